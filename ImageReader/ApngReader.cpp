@@ -0,0 +1,412 @@
+#include "ApngReader.h"
+
+//=============================================================================
+// Frame Index
+//=============================================================================
+static CKDWORD ReadBE32(const CKBYTE *p)
+{
+    return ((CKDWORD)p[0] << 24) | ((CKDWORD)p[1] << 16) | ((CKDWORD)p[2] << 8) | (CKDWORD)p[3];
+}
+
+static CKDWORD ReadBE16(const CKBYTE *p) { return ((CKDWORD)p[0] << 8) | (CKDWORD)p[1]; }
+
+static CKDWORD ChunkStart(const CKBYTE *data, const PngChunk &chunk)
+{
+    return (CKDWORD)(chunk.data - data) - 8;
+}
+
+static int ReadFrameControl(const PngChunk &chunk, const PngImageInfo &info, ApngFrame &frame)
+{
+    if (chunk.length < APNG_FCTL_SIZE)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    const CKBYTE *p = chunk.data + APNG_SEQUENCE_SIZE;
+    memset(&frame, 0, sizeof(frame));
+    frame.width = ReadBE32(p);
+    frame.height = ReadBE32(p + 4);
+    frame.x = ReadBE32(p + 8);
+    frame.y = ReadBE32(p + 12);
+    CKDWORD delayNum = ReadBE16(p + 16);
+    CKDWORD delayDen = ReadBE16(p + 18);
+    frame.disposeOp = p[20];
+    frame.blendOp = p[21];
+
+    // The region must lie inside the canvas
+    if (frame.width == 0 || frame.height == 0 || frame.width > info.width || frame.height > info.height ||
+        frame.x > info.width - frame.width || frame.y > info.height - frame.height)
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (frame.disposeOp > APNG_DISPOSE_PREVIOUS || frame.blendOp > APNG_BLEND_OVER)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // A zero denominator means 1/100 s units
+    if (delayDen == 0)
+        delayDen = 100;
+    frame.delay = delayNum * 1000 / delayDen;
+    return 0;
+}
+
+int APNG_Index(const CKBYTE *data, CKDWORD size, ApngAnimation &anim)
+{
+    memset(&anim, 0, sizeof(anim));
+    int result = PNG_ReadInfo(data, size, anim.info);
+    if (result != 0)
+        return result;
+    anim.data = data;
+    anim.size = size;
+
+    // First pass: acTL and the number of fcTL chunks, so the index is allocated once
+    CKBOOL animated = FALSE;
+    CKDWORD controlCount = 0;
+    CKDWORD offset = PNG_SIGNATURE_SIZE;
+    PngChunk chunk;
+    while (PNG_NextChunk(data, size, offset, chunk) && chunk.type != PNG_CHUNK_IEND)
+    {
+        if (chunk.type == PNG_CHUNK_ACTL && chunk.length >= APNG_ACTL_SIZE)
+        {
+            animated = TRUE;
+            anim.numPlays = ReadBE32(chunk.data + 4);
+        }
+        else if (chunk.type == PNG_CHUNK_FCTL)
+        {
+            controlCount++;
+        }
+    }
+    if (!animated || controlCount == 0)
+    {
+        anim.numPlays = 0;
+        controlCount = 0;
+    }
+
+    anim.frames = new ApngFrame[controlCount ? controlCount : 1];
+
+    // Second pass: frame regions and their data chunks. The static image (IDAT)
+    // is frame 0 only if an fcTL precedes it.
+    int current = -1;
+    CKBOOL seenIdat = FALSE;
+    CKDWORD idatOffset = 0;
+    CKDWORD idatSize = 0;
+    CKDWORD idatCount = 0;
+    offset = PNG_SIGNATURE_SIZE;
+    while (PNG_NextChunk(data, size, offset, chunk) && chunk.type != PNG_CHUNK_IEND)
+    {
+        if (chunk.type == PNG_CHUNK_IDAT)
+        {
+            if (chunk.length == 0)
+                continue;
+            if (chunk.length > 0x7FFFFFFF - idatSize)
+                break;
+            if (idatCount++ == 0)
+                idatOffset = ChunkStart(data, chunk);
+            idatSize += chunk.length;
+            seenIdat = TRUE;
+            continue;
+        }
+        if (controlCount == 0)
+            continue;
+
+        if (chunk.type == PNG_CHUNK_FCTL)
+        {
+            ApngFrame &frame = anim.frames[++current];
+            result = ReadFrameControl(chunk, anim.info, frame);
+            if (result == 0 && current == 0 && !seenIdat)
+            {
+                // Frame 0 is the static image and must cover the whole canvas
+                if (frame.x != 0 || frame.y != 0 || frame.width != anim.info.width ||
+                    frame.height != anim.info.height)
+                    result = CKBITMAPERROR_FILECORRUPTED;
+                frame.isIdat = TRUE;
+            }
+            if (result != 0)
+                break;
+        }
+        else if (chunk.type == PNG_CHUNK_FDAT)
+        {
+            if (current < 0 || anim.frames[current].isIdat)
+            {
+                result = CKBITMAPERROR_FILECORRUPTED;
+                break;
+            }
+            if (chunk.length <= APNG_SEQUENCE_SIZE)
+                continue;
+            ApngFrame &frame = anim.frames[current];
+            CKDWORD length = chunk.length - APNG_SEQUENCE_SIZE;
+            if (length > 0x7FFFFFFF - frame.dataSize)
+            {
+                result = CKBITMAPERROR_FILECORRUPTED;
+                break;
+            }
+            if (frame.chunkCount++ == 0)
+                frame.dataOffset = ChunkStart(data, chunk);
+            frame.dataSize += length;
+        }
+    }
+    if (result != 0 || idatSize == 0)
+    {
+        APNG_FreeIndex(anim);
+        return result ? result : CKBITMAPERROR_FILECORRUPTED;
+    }
+
+    if (controlCount == 0)
+    {
+        // Not animated: the static image as a single frame
+        ApngFrame &frame = anim.frames[0];
+        memset(&frame, 0, sizeof(frame));
+        frame.width = anim.info.width;
+        frame.height = anim.info.height;
+        frame.blendOp = APNG_BLEND_SOURCE;
+        frame.isIdat = TRUE;
+        anim.frameCount = 1;
+    }
+    else
+    {
+        anim.frameCount = (CKDWORD)(current + 1);
+    }
+
+    CKDWORD time = 0;
+    for (CKDWORD i = 0; i < anim.frameCount; i++)
+    {
+        ApngFrame &frame = anim.frames[i];
+        if (frame.isIdat)
+        {
+            frame.dataOffset = idatOffset;
+            frame.dataSize = idatSize;
+            frame.chunkCount = idatCount;
+        }
+        else if (frame.chunkCount == 0)
+        {
+            // A truncated animation keeps the frames that have data
+            anim.frameCount = i;
+            break;
+        }
+        frame.startTime = time;
+        time += frame.delay;
+    }
+    if (anim.frameCount == 0)
+    {
+        APNG_FreeIndex(anim);
+        return CKBITMAPERROR_FILECORRUPTED;
+    }
+    anim.length = time;
+
+    // Restoring the first frame means restoring the empty canvas
+    if (anim.frames[0].disposeOp == APNG_DISPOSE_PREVIOUS)
+        anim.frames[0].disposeOp = APNG_DISPOSE_BACKGROUND;
+    return 0;
+}
+
+void APNG_FreeIndex(ApngAnimation &anim)
+{
+    delete[] anim.frames;
+    anim.frames = NULL;
+    anim.frameCount = 0;
+}
+
+//=============================================================================
+// Frame Decoding and Blending
+//=============================================================================
+int APNG_DecodeFrame(const ApngAnimation &anim, CKDWORD index, CKBYTE *dst)
+{
+    if (index >= anim.frameCount || !dst)
+        return CKBITMAPERROR_GENERIC;
+
+    const ApngFrame &frame = anim.frames[index];
+    CKDWORD type = frame.isIdat ? PNG_CHUNK_IDAT : PNG_CHUNK_FDAT;
+    CKDWORD skip = frame.isIdat ? 0 : APNG_SEQUENCE_SIZE;
+
+    // A frame in a single chunk is decoded in place, several chunks are joined first
+    CKBYTE *joined = NULL;
+    const CKBYTE *zdata = NULL;
+    CKDWORD offset = frame.dataOffset;
+    PngChunk chunk;
+    if (frame.chunkCount == 1)
+    {
+        if (!PNG_NextChunk(anim.data, anim.size, offset, chunk))
+            return CKBITMAPERROR_FILECORRUPTED;
+        zdata = chunk.data + skip;
+    }
+    else
+    {
+        joined = new CKBYTE[frame.dataSize];
+        CKDWORD pos = 0;
+        CKDWORD found = 0;
+        while (found < frame.chunkCount && PNG_NextChunk(anim.data, anim.size, offset, chunk))
+        {
+            if (chunk.type != type || chunk.length <= skip)
+                continue;
+            memcpy(joined + pos, chunk.data + skip, chunk.length - skip);
+            pos += chunk.length - skip;
+            found++;
+        }
+        zdata = joined;
+    }
+
+    int result = PNG_DecodeImage(anim.info, frame.width, frame.height, zdata, frame.dataSize, PNG_OUTPUT_BGRA32,
+                                 dst, (int)(frame.width * 4));
+    delete[] joined;
+    return result;
+}
+
+// Straight-alpha "over": out = src + dst * (1 - srcA), with colors weighted by alpha
+static void BlendOverRow(const CKBYTE *src, CKBYTE *dst, CKDWORD count)
+{
+    for (CKDWORD i = 0; i < count; i++, src += 4, dst += 4)
+    {
+        CKDWORD sa = src[3];
+        if (sa == 255)
+        {
+            *(CKDWORD *)dst = *(const CKDWORD *)src;
+            continue;
+        }
+        if (sa == 0)
+            continue;
+
+        // Weights scaled by 255
+        CKDWORD ws = sa * 255;
+        CKDWORD wd = dst[3] * (255 - sa);
+        CKDWORD wa = ws + wd;
+        for (int c = 0; c < 3; c++)
+            dst[c] = (CKBYTE)((src[c] * ws + dst[c] * wd + wa / 2) / wa);
+        dst[3] = (CKBYTE)((wa + 127) / 255);
+    }
+}
+
+void APNG_BlendFrame(const ApngFrame &frame, const CKBYTE *src, CKBYTE *canvas, CKDWORD canvasStride)
+{
+    CKDWORD srcStride = frame.width * 4;
+    CKBYTE *dst = canvas + frame.y * canvasStride + frame.x * 4;
+    for (CKDWORD y = 0; y < frame.height; y++, src += srcStride, dst += canvasStride)
+    {
+        if (frame.blendOp == APNG_BLEND_SOURCE)
+            memcpy(dst, src, srcStride);
+        else
+            BlendOverRow(src, dst, frame.width);
+    }
+}
+
+//=============================================================================
+// Compositing
+//=============================================================================
+static void FrameRegion(void *context, CKDWORD f, ImageMovieRegion &region)
+{
+    const ApngFrame &frame = ((const ApngAnimation *)context)->frames[f];
+    region.x = frame.x;
+    region.y = frame.y;
+    region.width = frame.width;
+    region.height = frame.height;
+    if (frame.disposeOp == APNG_DISPOSE_BACKGROUND)
+        region.dispose = IMAGE_MOVIE_DISPOSE_BACKGROUND;
+    else if (frame.disposeOp == APNG_DISPOSE_PREVIOUS)
+        region.dispose = IMAGE_MOVIE_DISPOSE_PREVIOUS;
+    else
+        region.dispose = IMAGE_MOVIE_DISPOSE_NONE;
+}
+
+static CKBOOL IsOpaqueFrame(void *context, CKDWORD f)
+{
+    return ((const ApngAnimation *)context)->frames[f].blendOp == APNG_BLEND_SOURCE;
+}
+
+static int DecodeFrame(void *context, CKDWORD f, CKBYTE *pixels, CKDWORD &decoded)
+{
+    const ApngAnimation &anim = *(const ApngAnimation *)context;
+    decoded = anim.frames[f].width * anim.frames[f].height;
+    return APNG_DecodeFrame(anim, f, pixels);
+}
+
+static void DrawFrame(void *context, CKDWORD f, const CKBYTE *pixels, CKDWORD decoded, CKBYTE *canvas,
+                      CKDWORD canvasStride)
+{
+    APNG_BlendFrame(((const ApngAnimation *)context)->frames[f], pixels, canvas, canvasStride);
+}
+
+static const ImageMovieFormat ApngMovieFormat = {FrameRegion, IsOpaqueFrame, DecodeFrame, DrawFrame};
+
+//=============================================================================
+// ApngReader Class Implementation
+//=============================================================================
+ApngReader::ApngReader()
+{
+    memset(&m_Animation, 0, sizeof(m_Animation));
+    m_Properties.m_Ext = "png";
+    m_Properties.m_ReaderGuid = APNGREADER_GUID;
+    m_Properties.m_Data = NULL;
+}
+
+ApngReader::~ApngReader()
+{
+    Close();
+}
+
+CKPluginInfo *ApngReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_APNG];
+}
+
+void ApngReader::Close()
+{
+    // The prefetch task reads the file
+    m_Compositor.Close();
+
+    APNG_FreeIndex(m_Animation);
+    m_File.Close();
+    m_Properties.m_Data = NULL;
+    m_Properties.m_NumPlays = 0;
+    m_Properties.m_FrameDelay = 0;
+}
+
+int ApngReader::GetMovieFrameCount()
+{
+    return (int)m_Animation.frameCount;
+}
+
+int ApngReader::GetMovieLength()
+{
+    return (int)m_Animation.length;
+}
+
+CKERROR ApngReader::OpenFile(char *name)
+{
+    Close();
+    if (!name || !m_File.Open(name))
+        return CKMOVIEERROR_READERROR;
+
+    int result = APNG_Index(m_File.Data(), m_File.Size(), m_Animation);
+    if (result != 0)
+    {
+        m_File.Close();
+        return (result == CKBITMAPERROR_UNSUPPORTEDFILE || result == CKBITMAPERROR_READERROR)
+                   ? CKMOVIEERROR_UNSUPPORTEDFILE
+                   : CKMOVIEERROR_FILECORRUPTED;
+    }
+
+    const PngImageInfo &info = m_Animation.info;
+    uint64_t canvasSize = (uint64_t)info.width * info.height * 4;
+    if (!ImageWithinDecodeLimits(info.width, info.height, canvasSize))
+    {
+        Close();
+        return CKMOVIEERROR_FILECORRUPTED;
+    }
+
+    // Frame regions never exceed the canvas, so the decode buffers have its size
+    m_Compositor.Open(ApngMovieFormat, &m_Animation, info.width, info.height, m_Animation.frameCount,
+                      (CKDWORD)canvasSize);
+
+    ImageReader::FillFormatBGRA32(m_Properties.m_Format, (int)info.width, (int)info.height, (int)info.width * 4,
+                                  m_Compositor.Canvas());
+    m_Properties.m_NumPlays = m_Animation.numPlays;
+    return CK_OK;
+}
+
+CKERROR ApngReader::ReadFrame(int f, CKMovieProperties **mp)
+{
+    if (!mp || !m_Compositor.Canvas() || (CKDWORD)f >= m_Animation.frameCount)
+        return CKMOVIEERROR_GENERIC;
+
+    if (m_Compositor.Render((CKDWORD)f) != 0)
+        return CKMOVIEERROR_FILECORRUPTED;
+
+    m_Properties.m_Data = m_Compositor.Canvas();
+    m_Properties.m_FrameDelay = m_Animation.frames[f].delay;
+    *mp = (CKMovieProperties *)&m_Properties;
+    return CK_OK;
+}
@@ -0,0 +1,139 @@
+#ifndef APNGREADER_H
+#define APNGREADER_H
+
+#include "CKMovieReader.h"
+
+#include "PngReader.h"
+#include "ImageFileMap.h"
+#include "ImageMovieCompositor.h"
+
+// APNG Reader GUID
+#define APNGREADER_GUID CKGUID(0x5D2B8C43, 0x19E7A6F0)
+
+struct ApngMovieProperties : public CKMovieProperties
+{
+    ApngMovieProperties()
+    {
+        m_Size = sizeof(ApngMovieProperties);
+        m_NumPlays = 0;
+        m_FrameDelay = 0;
+    }
+
+    CKDWORD m_NumPlays;   // loop count from acTL (0 = forever)
+    CKDWORD m_FrameDelay; // display time of the last frame read, in ms
+};
+
+//=============================================================================
+// APNG file format
+//=============================================================================
+#define PNG_CHUNK_ACTL PNG_CHUNK_TYPE('a', 'c', 'T', 'L')
+#define PNG_CHUNK_FCTL PNG_CHUNK_TYPE('f', 'c', 'T', 'L')
+#define PNG_CHUNK_FDAT PNG_CHUNK_TYPE('f', 'd', 'A', 'T')
+
+#define APNG_ACTL_SIZE 8
+#define APNG_FCTL_SIZE 26
+#define APNG_SEQUENCE_SIZE 4 // leading sequence number of fcTL and fdAT
+
+// Disposal, applied to the frame's region before the next frame is drawn
+#define APNG_DISPOSE_NONE 0
+#define APNG_DISPOSE_BACKGROUND 1 // cleared to transparent black
+#define APNG_DISPOSE_PREVIOUS 2   // restored to what it was before the frame
+
+// Blending of the frame into the canvas
+#define APNG_BLEND_SOURCE 0
+#define APNG_BLEND_OVER 1
+
+struct ApngFrame
+{
+    CKDWORD width;
+    CKDWORD height;
+    CKDWORD x;
+    CKDWORD y;
+    CKDWORD delay;     // in ms
+    CKDWORD startTime; // sum of the delays of the previous frames
+    CKDWORD disposeOp;
+    CKDWORD blendOp;
+    CKDWORD dataOffset; // first IDAT/fdAT chunk of the frame (its length field)
+    CKDWORD dataSize;   // zlib bytes over all chunks, without fdAT sequence numbers
+    CKDWORD chunkCount;
+    CKBOOL isIdat;
+};
+
+// Frame index of an animated PNG. The file bytes are referenced, not copied,
+// and must stay valid while frames are decoded. A PNG without acTL is indexed
+// as a single frame.
+struct ApngAnimation
+{
+    const CKBYTE *data;
+    CKDWORD size;
+    PngImageInfo info;
+    CKDWORD numPlays;
+    CKDWORD length; // total duration in ms
+    CKDWORD frameCount;
+    ApngFrame *frames;
+};
+
+/**
+ * ApngReader - Animated PNG movie reader
+ *
+ *   - OpenFile maps the file and indexes the fcTL/IDAT/fdAT chunks; nothing
+ *     is decoded until a frame is read
+ *   - Frames are composited into a persistent BGRA32 canvas: each step decodes
+ *     only the frame's own region and applies disposal and blending to it
+ *   - Seeking restarts from the nearest frame that fully redraws the canvas;
+ *     reading forward continues from the current canvas
+ *   - After each ReadFrame the next frame is decoded on a background thread
+ *   - The static image of a file without acTL is read as a one-frame movie
+ */
+class ApngReader : public CKMovieReader
+{
+public:
+    ApngReader();
+    ~ApngReader();
+
+    void Release() { delete this; }
+
+    CKPluginInfo *GetReaderInfo();
+
+    int GetOptionsCount() { return 0; }
+    CKSTRING GetOptionDescription(int i) { return NULL; }
+
+    virtual CK_DATAREADER_FLAGS GetFlags() { return CK_DATAREADER_FILELOAD; }
+
+    // Frame count
+    virtual int GetMovieFrameCount();
+    // Length in ms
+    virtual int GetMovieLength();
+
+    virtual CKERROR OpenFile(char *name);
+    // Returns the composited canvas after frame f, in BGRA32
+    virtual CKERROR ReadFrame(int f, CKMovieProperties **mp);
+
+    virtual CKERROR OpenMemory(char *name) { return CKERR_NOTIMPLEMENTED; }
+    virtual CKERROR OpenAsynchronousFile(char *name) { return CKERR_NOTIMPLEMENTED; }
+
+    void Close();
+
+private:
+    ApngMovieProperties m_Properties;
+    ImageFileMap m_File;
+    ApngAnimation m_Animation;
+    ImageMovieCompositor m_Compositor;
+};
+
+//=============================================================================
+// Internal helper functions
+//=============================================================================
+
+// Builds the frame index; frames are allocated with new[] and released by
+// APNG_FreeIndex. Returns a CKBITMAPERROR_* code.
+int APNG_Index(const CKBYTE *data, CKDWORD size, ApngAnimation &anim);
+void APNG_FreeIndex(ApngAnimation &anim);
+
+// Decodes the region of a frame into dst as tightly packed BGRA32
+int APNG_DecodeFrame(const ApngAnimation &anim, CKDWORD frame, CKBYTE *dst);
+
+// Draws a decoded frame region into a canvas with the frame's blend operation
+void APNG_BlendFrame(const ApngFrame &frame, const CKBYTE *src, CKBYTE *canvas, CKDWORD canvasStride);
+
+#endif // APNGREADER_H
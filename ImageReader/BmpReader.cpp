@@ -170,14 +170,15 @@ struct RLEContext
     const XBYTE *palette;
     CKBOOL is3BytePalette;
     CKDWORD paletteEntries;
+    CKBOOL keepIndices; // write 8-bit indices instead of BGRA32
     CKDWORD x;
     CKDWORD y;
 
     RLEContext(const XBYTE *s, CKDWORD ss, XBYTE *d, CKDWORD ds, CKDWORD w, CKDWORD h,
-               CKBOOL td, const XBYTE *pal, CKBOOL is3, CKDWORD pe)
+               CKBOOL td, const XBYTE *pal, CKBOOL is3, CKDWORD pe, CKBOOL ki)
         : src(s), srcSize(ss), srcPos(0), dst(d), dstStride(ds),
           width(w), height(h), topDown(td), palette(pal),
-          is3BytePalette(is3), paletteEntries(pe),
+          is3BytePalette(is3), paletteEntries(pe), keepIndices(ki),
           x(0), y(td ? 0 : h - 1) {}
 
     XBYTE *Row() { return (y < height) ? (dst + y * dstStride) : NULL; }
@@ -201,10 +202,15 @@ struct RLEContext
     }
     CKBOOL HasMore() const { return srcPos < srcSize && y < height; }
     CKBYTE ReadByte() { return (srcPos < srcSize) ? src[srcPos++] : 0; }
+    CKBYTE PeekByte() const { return (srcPos < srcSize) ? src[srcPos] : 0; }
     void SetPixel(CKBYTE idx)
     {
         XBYTE *row = Row();
-        if (row && x < width)
+        if (!row || x >= width)
+            return;
+        if (keepIndices)
+            row[x++] = (idx < paletteEntries) ? idx : 0;
+        else
             SetBGRAFromPalette(row, x++, idx, palette, is3BytePalette, paletteEntries);
     }
 };
@@ -257,8 +263,8 @@ static void DecodeRLE4(RLEContext &ctx)
             {
                 for (CKDWORD i = 0; i < second; i++)
                 {
-                    CKBYTE idx = ((i & 1) == 0) ? (ctx.src[ctx.srcPos] >> 4)
-                                                : (ctx.src[ctx.srcPos++] & 0x0F);
+                    // Absolute runs may be cut short by the end of the data
+                    CKBYTE idx = ((i & 1) == 0) ? (ctx.PeekByte() >> 4) : (ctx.ReadByte() & 0x0F);
                     ctx.SetPixel(idx);
                 }
                 if (second & 1)
@@ -300,6 +306,37 @@ static void DecodeRow8bpp(const XBYTE *src, XBYTE *dst, CKDWORD width,
         SetBGRAFromPalette(dst, x, src[x], pal, is3, entries);
 }
 
+// Index row decoders (IMAGE_READ_KEEP_INDICES). Indices past the palette map
+// to 0, as SetBGRAFromPalette does.
+static void DecodeIndexRow1bpp(const XBYTE *src, XBYTE *dst, CKDWORD width, CKDWORD entries)
+{
+    for (CKDWORD x = 0; x < width; x++)
+    {
+        CKBYTE idx = (src[x / 8] >> (7 - (x & 7))) & 1;
+        dst[x] = (idx < entries) ? idx : 0;
+    }
+}
+
+static void DecodeIndexRow4bpp(const XBYTE *src, XBYTE *dst, CKDWORD width, CKDWORD entries)
+{
+    for (CKDWORD x = 0; x < width; x++)
+    {
+        CKBYTE idx = (x & 1) ? (src[x / 2] & 0x0F) : (src[x / 2] >> 4);
+        dst[x] = (idx < entries) ? idx : 0;
+    }
+}
+
+static void DecodeIndexRow8bpp(const XBYTE *src, XBYTE *dst, CKDWORD width, CKDWORD entries)
+{
+    if (entries >= 256)
+    {
+        memcpy(dst, src, width);
+        return;
+    }
+    for (CKDWORD x = 0; x < width; x++)
+        dst[x] = (src[x] < entries) ? src[x] : 0;
+}
+
 static void DecodeRow16bpp(const XBYTE *src, XBYTE *dst, CKDWORD width,
                            CKDWORD rMask, CKDWORD gMask, CKDWORD bMask, CKDWORD aMask, CKBOOL useMasks)
 {
@@ -368,21 +405,16 @@ struct BmpHeader
     CKBOOL topDown;
     CKDWORD redMask, greenMask, blueMask, alphaMask;
     CKDWORD pixelDataOffset;
+    CKBOOL icon; // ICO/CUR entry: no file header, AND mask below the color bitmap
 
     BmpHeader() : width(0), height(0), bitCount(0), planes(0), compression(0),
                   colorsUsed(0), headerSize(0), topDown(FALSE),
-                  redMask(0), greenMask(0), blueMask(0), alphaMask(0), pixelDataOffset(0) {}
+                  redMask(0), greenMask(0), blueMask(0), alphaMask(0), pixelDataOffset(0), icon(FALSE) {}
 };
 
-static int ParseBmpHeader(BmpDataSource &src, BmpHeader &hdr)
+// Parses the info header at the current position, which is base
+static int ParseInfoHeader(BmpDataSource &src, CKDWORD base, BmpHeader &hdr)
 {
-    BITMAPFILEHEADER fileHdr;
-    if (!src.Read(&fileHdr, sizeof(fileHdr)))
-        return CKBITMAPERROR_READERROR;
-    if (fileHdr.bfType != 0x4D42)
-        return CKBITMAPERROR_UNSUPPORTEDFILE;
-    hdr.pixelDataOffset = fileHdr.bfOffBits;
-
     if (!src.Read(&hdr.headerSize, 4))
         return CKBITMAPERROR_READERROR;
 
@@ -432,17 +464,26 @@ static int ParseBmpHeader(BmpDataSource &src, BmpHeader &hdr)
         // Read bitfield masks
         if ((hdr.compression == BI_BITFIELDS || hdr.compression == BI_ALPHABITFIELDS) && hdr.headerSize >= 52)
         {
-            CKDWORD base = sizeof(BITMAPFILEHEADER) + 40;
-            src.ReadAt(base, &hdr.redMask, 4);
-            src.ReadAt(base + 4, &hdr.greenMask, 4);
-            src.ReadAt(base + 8, &hdr.blueMask, 4);
+            CKDWORD masks = base + 40;
+            src.ReadAt(masks, &hdr.redMask, 4);
+            src.ReadAt(masks + 4, &hdr.greenMask, 4);
+            src.ReadAt(masks + 8, &hdr.blueMask, 4);
             if (hdr.headerSize >= 56)
-                src.ReadAt(base + 12, &hdr.alphaMask, 4);
+                src.ReadAt(masks + 12, &hdr.alphaMask, 4);
         }
     }
     else
         return CKBITMAPERROR_UNSUPPORTEDFILE;
 
+    // The height of an icon covers both bitmaps. Icons are stored without
+    // compression, so their size is known before anything is allocated.
+    if (hdr.icon)
+    {
+        hdr.height /= 2;
+        if (hdr.compression != BI_RGB && hdr.compression != BI_BITFIELDS)
+            return CKBITMAPERROR_UNSUPPORTEDFILE;
+    }
+
     // Validate
     if (hdr.width == 0 || hdr.height == 0)
         return CKBITMAPERROR_FILECORRUPTED;
@@ -459,6 +500,46 @@ static int ParseBmpHeader(BmpDataSource &src, BmpHeader &hdr)
     return 0;
 }
 
+static int ParseBmpHeader(BmpDataSource &src, BmpHeader &hdr)
+{
+    BITMAPFILEHEADER fileHdr;
+    if (!src.Read(&fileHdr, sizeof(fileHdr)))
+        return CKBITMAPERROR_READERROR;
+    if (fileHdr.bfType != 0x4D42)
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    hdr.pixelDataOffset = fileHdr.bfOffBits;
+    return ParseInfoHeader(src, sizeof(BITMAPFILEHEADER), hdr);
+}
+
+//=============================================================================
+// Icon AND Mask
+//=============================================================================
+
+// Applies the 1-bit AND mask of an icon: set bits are transparent. 32-bit
+// icons normally carry alpha themselves and use the mask only if every alpha
+// value is 0 (icons from before alpha support).
+static void ApplyIconMask(const BmpHeader &hdr, const XBYTE *mask, CKDWORD maskStride, XBYTE *dst, CKDWORD dstStride)
+{
+    if (hdr.bitCount == 32)
+    {
+        for (CKDWORD y = 0; y < hdr.height; y++)
+        {
+            const XBYTE *row = dst + y * dstStride;
+            for (CKDWORD x = 0; x < hdr.width; x++)
+                if (row[x * 4 + 3] != 0)
+                    return;
+        }
+    }
+
+    for (CKDWORD y = 0; y < hdr.height; y++)
+    {
+        const XBYTE *maskRow = mask ? mask + (hdr.topDown ? y : hdr.height - 1 - y) * maskStride : NULL;
+        XBYTE *row = dst + y * dstStride;
+        for (CKDWORD x = 0; x < hdr.width; x++)
+            row[x * 4 + 3] = (maskRow && ((maskRow[x / 8] >> (7 - (x & 7))) & 1)) ? 0 : 255;
+    }
+}
+
 //=============================================================================
 // RLE8 Encoding (for save)
 //=============================================================================
@@ -534,7 +615,7 @@ static CKBYTE ToGray(CKBYTE b, CKBYTE g, CKBYTE r)
 //=============================================================================
 // BmpReader Class Implementation
 //=============================================================================
-BmpReader::BmpReader() : ImageReader()
+BmpReader::BmpReader() : ImageReader(), m_ReadFlags(0)
 {
     m_Properties.Init(BMPREADER_GUID, "bmp");
 }
@@ -549,6 +630,10 @@ CKPluginInfo *BmpReader::GetReaderInfo()
     return &g_PluginInfo[READER_INDEX_BMP];
 }
 
+void BmpReader::SetReadFlags(CKDWORD flags) { m_ReadFlags = flags; }
+
+CKDWORD BmpReader::GetReadFlags() { return m_ReadFlags; }
+
 int BmpReader::GetOptionsCount() { return 1; }
 
 CKSTRING BmpReader::GetOptionDescription(int i)
@@ -567,7 +652,7 @@ int BmpReader::ReadFile(CKSTRING filename, CKBitmapProperties **bp)
 {
     if (!filename || !bp)
         return 1;
-    int result = BMP_Read((void *)filename, 0, (CKBitmapProperties *)&m_Properties);
+    int result = ReadSniffed(READER_INDEX_BMP, (void *)filename, 0, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
     *bp = (CKBitmapProperties *)&m_Properties;
     return result;
 }
@@ -576,11 +661,16 @@ int BmpReader::ReadMemory(void *memory, int size, CKBitmapProperties **bp)
 {
     if (!bp)
         return 1;
-    int result = BMP_Read(memory, size, (CKBitmapProperties *)&m_Properties);
+    int result = ReadSniffed(READER_INDEX_BMP, memory, size, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
     *bp = (CKBitmapProperties *)&m_Properties;
     return result;
 }
 
+int BmpReader::ReadOwnFormat(void *data, int size, CKBitmapProperties *props)
+{
+    return BMP_Read(data, size, props, m_ReadFlags);
+}
+
 int BmpReader::SaveFile(CKSTRING filename, CKBitmapProperties *bp)
 {
     if (!filename || !bp)
@@ -608,33 +698,10 @@ int BmpReader::SaveMemory(void **memory, CKBitmapProperties *bp)
 //=============================================================================
 // BMP_Read - Core Reading Function
 //=============================================================================
-int BMP_Read(void *data, int size, CKBitmapProperties *props)
-{
-    if (!data || !props)
-        return CKBITMAPERROR_GENERIC;
-    if (size < 0)
-        return CKBITMAPERROR_FILECORRUPTED;
-
-    // Create data source
-    BmpDataSource *src = (size == 0)
-                             ? (BmpDataSource *)new BmpFileSource((const char *)data)
-                             : (BmpDataSource *)new BmpMemorySource(data, size);
-
-    if (size == 0 && !((BmpFileSource *)src)->IsValid())
-    {
-        delete src;
-        return CKBITMAPERROR_READERROR;
-    }
-
-    // Parse header
-    BmpHeader hdr;
-    int result = ParseBmpHeader(*src, hdr);
-    if (result != 0)
-    {
-        delete src;
-        return result;
-    }
 
+// Decodes the palette and pixels that follow the parsed header
+static int DecodeBmp(BmpDataSource &src, BmpHeader &hdr, CKBitmapProperties *props, CKDWORD readFlags)
+{
     // Calculate palette
     CKDWORD paletteEntries = 0, paletteSize = 0;
     CKBOOL is3BytePalette = (hdr.headerSize == 12);
@@ -644,10 +711,7 @@ int BMP_Read(void *data, int size, CKBitmapProperties *props)
         CKDWORD maxColors = 1U << hdr.bitCount;
         paletteEntries = hdr.colorsUsed ? hdr.colorsUsed : maxColors;
         if (paletteEntries == 0 || paletteEntries > maxColors)
-        {
-            delete src;
             return CKBITMAPERROR_FILECORRUPTED;
-        }
         paletteSize = paletteEntries * (is3BytePalette ? 3 : 4);
     }
     else if ((hdr.compression == BI_BITFIELDS || hdr.compression == BI_ALPHABITFIELDS) && hdr.headerSize < 52)
@@ -660,11 +724,8 @@ int BMP_Read(void *data, int size, CKBitmapProperties *props)
     if (paletteSize > 0)
     {
         palette.Resize((int)paletteSize);
-        if (!src->Read(palette.Begin(), paletteSize))
-        {
-            delete src;
+        if (!src.Read(palette.Begin(), paletteSize))
             return CKBITMAPERROR_READERROR;
-        }
 
         // Extract masks if stored after header
         if ((hdr.compression == BI_BITFIELDS || hdr.compression == BI_ALPHABITFIELDS) &&
@@ -678,71 +739,110 @@ int BMP_Read(void *data, int size, CKBitmapProperties *props)
         }
     }
 
-    // Validate and seek to pixel data
-    if (hdr.pixelDataOffset < src->Tell())
-    {
-        delete src;
+    // Validate and seek to pixel data. Icon pixels follow the palette.
+    if (hdr.icon)
+        hdr.pixelDataOffset = src.Tell();
+    if (hdr.pixelDataOffset < src.Tell())
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (!src.Seek(hdr.pixelDataOffset))
         return CKBITMAPERROR_FILECORRUPTED;
-    }
-    src->Seek(hdr.pixelDataOffset);
 
     // Calculate strides and sizes
     unsigned long long bitsPerRow = (unsigned long long)hdr.width * hdr.bitCount;
     unsigned long long srcStride64 = ((bitsPerRow + 31ULL) / 32ULL) * 4ULL;
     if (srcStride64 > 0xFFFFFFFFULL)
-    {
-        delete src;
         return CKBITMAPERROR_FILECORRUPTED;
-    }
     CKDWORD srcStride = (CKDWORD)srcStride64;
 
+    // Index images carry their BGRA palette at the start of the destination block
+    CKBOOL keepIndices = (hdr.bitCount <= 8) && (readFlags & IMAGE_READ_KEEP_INDICES) && !hdr.icon;
+    CKDWORD colorMapSize = keepIndices ? paletteEntries * 4 : 0;
+    unsigned long long dstStride64 = keepIndices ? (((unsigned long long)hdr.width + 3) & ~3ULL)
+                                                 : (unsigned long long)hdr.width * 4;
+    unsigned long long dstTotal = dstStride64 * hdr.height;
+    if (!ImageWithinDecodeLimits(hdr.width, hdr.height, dstTotal + colorMapSize))
+        return CKBITMAPERROR_FILECORRUPTED;
+    CKDWORD dstStride = (CKDWORD)dstStride64;
+
+    // Uncompressed pixel data must be in the file; only the padding of the
+    // last row may be missing. RLE data needs at least one escape.
+    CKDWORD available = (src.Tell() < src.Size()) ? src.Size() - src.Tell() : 0;
     CKDWORD pixelDataSize = 0;
     if (hdr.compression == BI_RGB || hdr.compression == BI_BITFIELDS || hdr.compression == BI_ALPHABITFIELDS)
     {
         unsigned long long total = (unsigned long long)srcStride * hdr.height;
         if (total > 0xFFFFFFFFULL)
-        {
-            delete src;
             return CKBITMAPERROR_FILECORRUPTED;
-        }
+        if ((unsigned long long)srcStride * (hdr.height - 1) + (bitsPerRow + 7) / 8 > available)
+            return CKBITMAPERROR_FILECORRUPTED;
         pixelDataSize = (CKDWORD)total;
     }
     else
     {
-        pixelDataSize = src->Size() - src->Tell();
+        if (available < 2)
+            return CKBITMAPERROR_FILECORRUPTED;
+        pixelDataSize = available;
     }
 
-    // Read pixel data
-    XArray<XBYTE> srcPixels;
-    srcPixels.Resize((int)pixelDataSize);
-    src->Read(srcPixels.Begin(), pixelDataSize);
-    delete src;
-    src = NULL;
-
-    // Allocate destination
-    CKDWORD dstStride = hdr.width * 4;
-    unsigned long long dstTotal = (unsigned long long)dstStride * hdr.height;
-    if (dstTotal > 0xFFFFFFFFULL)
-        return CKBITMAPERROR_FILECORRUPTED;
+    // An icon's color bitmap must be complete; its AND mask may be missing
+    CKDWORD maskStride = (CKDWORD)((((unsigned long long)hdr.width + 31) / 32) * 4);
+    CKDWORD maskSize = 0;
+    if (hdr.icon)
+    {
+        if (pixelDataSize > available)
+            return CKBITMAPERROR_FILECORRUPTED;
+        if ((unsigned long long)maskStride * hdr.height <= available - pixelDataSize)
+            maskSize = maskStride * hdr.height;
+    }
 
-    XBYTE *dstPixels = new XBYTE[(CKDWORD)dstTotal];
-    memset(dstPixels, 0xFF, (CKDWORD)dstTotal);
+    // Read pixel data; missing row padding reads as 0
+    CKDWORD readSize = (pixelDataSize + maskSize < available) ? pixelDataSize + maskSize : available;
+    XArray<XBYTE> srcPixels;
+    srcPixels.Resize((int)(pixelDataSize + maskSize));
+    if (!src.Read(srcPixels.Begin(), readSize))
+        return CKBITMAPERROR_READERROR;
+    if (readSize < pixelDataSize + maskSize)
+        memset(srcPixels.Begin() + readSize, 0, pixelDataSize + maskSize - readSize);
+
+    // Allocate destination. Pixels RLE skips over are index 0 rather than white.
+    XBYTE *dstBlock = new XBYTE[(CKDWORD)dstTotal + colorMapSize];
+    XBYTE *dstPixels = dstBlock + colorMapSize;
+    memset(dstPixels, keepIndices ? 0 : 0xFF, (CKDWORD)dstTotal);
+    if (keepIndices)
+    {
+        CKDWORD stride = is3BytePalette ? 3 : 4;
+        for (CKDWORD i = 0; i < paletteEntries; i++)
+        {
+            dstBlock[i * 4 + 0] = palette[(int)(i * stride + 0)];
+            dstBlock[i * 4 + 1] = palette[(int)(i * stride + 1)];
+            dstBlock[i * 4 + 2] = palette[(int)(i * stride + 2)];
+            dstBlock[i * 4 + 3] = 255;
+        }
+    }
 
-    // Decode
+    // Decode. 32-bit icons without masks store alpha in the fourth byte.
     CKBOOL useMasks = (hdr.compression == BI_BITFIELDS || hdr.compression == BI_ALPHABITFIELDS);
+    if (hdr.icon && hdr.bitCount == 32 && !useMasks)
+    {
+        hdr.redMask = 0x00FF0000;
+        hdr.greenMask = 0x0000FF00;
+        hdr.blueMask = 0x000000FF;
+        hdr.alphaMask = 0xFF000000;
+        useMasks = TRUE;
+    }
 
     if (hdr.compression == BI_RLE8)
     {
         RLEContext ctx(srcPixels.Begin(), pixelDataSize, dstPixels, dstStride,
                        hdr.width, hdr.height, hdr.topDown, palette.Begin(),
-                       is3BytePalette, paletteEntries);
+                       is3BytePalette, paletteEntries, keepIndices);
         DecodeRLE8(ctx);
     }
     else if (hdr.compression == BI_RLE4)
     {
         RLEContext ctx(srcPixels.Begin(), pixelDataSize, dstPixels, dstStride,
                        hdr.width, hdr.height, hdr.topDown, palette.Begin(),
-                       is3BytePalette, paletteEntries);
+                       is3BytePalette, paletteEntries, keepIndices);
         DecodeRLE4(ctx);
     }
     else
@@ -753,6 +853,17 @@ int BMP_Read(void *data, int size, CKBitmapProperties *props)
             const XBYTE *srcRow = srcPixels.Begin() + srcY * srcStride;
             XBYTE *dstRow = dstPixels + y * dstStride;
 
+            if (keepIndices)
+            {
+                if (hdr.bitCount == 1)
+                    DecodeIndexRow1bpp(srcRow, dstRow, hdr.width, paletteEntries);
+                else if (hdr.bitCount == 4)
+                    DecodeIndexRow4bpp(srcRow, dstRow, hdr.width, paletteEntries);
+                else if (hdr.bitCount == 8)
+                    DecodeIndexRow8bpp(srcRow, dstRow, hdr.width, paletteEntries);
+                continue;
+            }
+
             switch (hdr.bitCount)
             {
             case 1:
@@ -777,12 +888,61 @@ int BMP_Read(void *data, int size, CKBitmapProperties *props)
         }
     }
 
+    if (hdr.icon)
+        ApplyIconMask(hdr, maskSize ? srcPixels.Begin() + pixelDataSize : NULL, maskStride, dstPixels, dstStride);
+
     // Fill properties
-    ImageReader::FillFormatBGRA32(props->m_Format, (int)hdr.width, (int)hdr.height, (int)dstStride, dstPixels);
-    props->m_Data = dstPixels;
+    if (keepIndices)
+        ImageReader::FillFormatIndexed8(props->m_Format, (int)hdr.width, (int)hdr.height, (int)dstStride,
+                                        dstPixels, dstBlock, (int)paletteEntries);
+    else
+        ImageReader::FillFormatBGRA32(props->m_Format, (int)hdr.width, (int)hdr.height, (int)dstStride, dstPixels);
+    props->m_Data = dstBlock;
     return 0;
 }
 
+int BMP_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags)
+{
+    if (!data || !props)
+        return CKBITMAPERROR_GENERIC;
+    if (size < 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // Create data source
+    BmpDataSource *src = (size == 0)
+                             ? (BmpDataSource *)new BmpFileSource((const char *)data)
+                             : (BmpDataSource *)new BmpMemorySource(data, size);
+
+    if (size == 0 && !((BmpFileSource *)src)->IsValid())
+    {
+        delete src;
+        return CKBITMAPERROR_READERROR;
+    }
+
+    BmpHeader hdr;
+    int result = ParseBmpHeader(*src, hdr);
+    if (result == 0)
+        result = DecodeBmp(*src, hdr, props, readFlags);
+    delete src;
+    return result;
+}
+
+int BMP_ReadIconDib(const void *data, CKDWORD size, CKBitmapProperties *props)
+{
+    if (!data || !props)
+        return CKBITMAPERROR_GENERIC;
+    if (size > 0x7FFFFFFF)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    BmpMemorySource src(data, (int)size);
+    BmpHeader hdr;
+    hdr.icon = TRUE;
+    int result = ParseInfoHeader(src, 0, hdr);
+    if (result == 0)
+        result = DecodeBmp(src, hdr, props, 0);
+    return result;
+}
+
 //=============================================================================
 // BMP_Save - Core Saving Function
 //=============================================================================
@@ -15,10 +15,14 @@
  *   - Writing: 8/24/32-bit BMP files with optional RLE8 compression
  *   - Proper color table handling for indexed formats
  *
+ * Extensions over the original:
+ *   - Reading 1/4/8-bit images as 8-bit indices plus palette (IMAGE_READ_KEEP_INDICES)
+ *
  * Original binary layout:
  *   - vtable: 4 bytes (offset 0)
  *   - m_Properties: 76 bytes (BmpBitmapProperties, offset 4)
  *   - Total: 80 bytes (0x50)
+ *   (m_ReadFlags is appended after m_Properties.)
  *
  * Based on reverse-engineering of the original ImageReader.dll
  */
@@ -39,10 +43,18 @@ public:
     virtual int SaveFile(CKSTRING filename, CKBitmapProperties *bp);
     virtual int SaveMemory(void **memory, CKBitmapProperties *bp);
 
+    // IMAGE_READ_* flags applied by ReadFile/ReadMemory (default 0)
+    void SetReadFlags(CKDWORD flags);
+    CKDWORD GetReadFlags();
+
+protected:
+    virtual int ReadOwnFormat(void *data, int size, CKBitmapProperties *props);
+
 private:
     // Extended properties (76 bytes) stored inline
     // m_Size = 76, m_BitDepth at offset 72
     BmpBitmapProperties m_Properties;
+    CKDWORD m_ReadFlags;
 };
 
 //=============================================================================
@@ -103,7 +115,16 @@ struct BITMAPCOREHEADER
 
 // Core BMP read function - reads from file path or memory buffer
 // If size == 0, treats data as filename; otherwise treats as memory buffer
-int BMP_Read(void *data, int size, CKBitmapProperties *props);
+// With IMAGE_READ_KEEP_INDICES, 1/4/8-bit images are returned as 8-bit indices with
+// the BGRA palette in m_Format.ColorMap; other formats are always BGRA32.
+int BMP_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags = 0);
+
+// Reads a DIB as stored in ICO and CUR entries: the info header directly
+// followed by the palette and pixels, with a height covering the color bitmap
+// and the 1-bit AND mask under it. Always decoded to BGRA32; the mask becomes
+// alpha unless a 32-bit image carries its own. The color bitmap must fit in
+// size before anything is allocated.
+int BMP_ReadIconDib(const void *data, CKDWORD size, CKBitmapProperties *props);
 
 // Core BMP save function - saves to file or returns memory buffer
 // If *outBuffer is non-NULL, treats as filename to save; otherwise allocates and returns buffer
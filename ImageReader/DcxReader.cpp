@@ -0,0 +1,179 @@
+#include "DcxReader.h"
+#include "PcxReader.h"
+#include "ImageFileMap.h"
+#include "ImageThreadPool.h"
+
+//=============================================================================
+// Page Index
+//=============================================================================
+static CKDWORD ReadLE32(const CKBYTE *p)
+{
+    return (CKDWORD)p[0] | ((CKDWORD)p[1] << 8) | ((CKDWORD)p[2] << 16) | ((CKDWORD)p[3] << 24);
+}
+
+int DCX_Index(const void *data, int size, DcxArchive &archive)
+{
+    archive.data = (const CKBYTE *)data;
+    archive.size = 0;
+    archive.pageCount = 0;
+    if (!data || size < 8)
+        return CKBITMAPERROR_READERROR;
+
+    const CKBYTE *bytes = (const CKBYTE *)data;
+    CKDWORD fileSize = (CKDWORD)size;
+    if (ReadLE32(bytes) != DCX_MAGIC)
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    archive.size = fileSize;
+
+    // The offset table ends at the first zero entry (or after 1023 pages)
+    CKDWORD count = 0;
+    CKDWORD tablePos = 4;
+    while (count < DCX_MAX_PAGES && tablePos + 4 <= fileSize)
+    {
+        CKDWORD offset = ReadLE32(bytes + tablePos);
+        if (offset == 0)
+            break;
+        archive.pages[count++].offset = offset;
+        tablePos += 4;
+    }
+
+    // Pages must lie past the table and inside the file
+    CKDWORD tableEnd = tablePos + 4;
+    for (CKDWORD i = 0; i < count; i++)
+    {
+        CKDWORD offset = archive.pages[i].offset;
+        if (offset < tableEnd || offset >= fileSize)
+            return CKBITMAPERROR_FILECORRUPTED;
+        CKDWORD next = (i + 1 < count) ? archive.pages[i + 1].offset : fileSize;
+        archive.pages[i].size = (next > offset) ? next - offset : fileSize - offset;
+    }
+    if (count == 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    archive.pageCount = count;
+    return 0;
+}
+
+//=============================================================================
+// Page Decoding
+//=============================================================================
+int DCX_ReadPage(const DcxArchive &archive, CKDWORD page, CKBitmapProperties *props)
+{
+    if (!props)
+        return CKBITMAPERROR_GENERIC;
+    if (page >= archive.pageCount)
+        return CKBITMAPERROR_READERROR;
+
+    const DcxPage &p = archive.pages[page];
+    return PCX_Read((void *)(archive.data + p.offset), (int)p.size, props);
+}
+
+struct DcxPagesJob
+{
+    const DcxArchive *archive;
+    CKDWORD first;
+    CKBitmapProperties *results;
+    int *errors;
+};
+
+static void DecodeDcxPages(void *context, CKDWORD begin, CKDWORD end)
+{
+    const DcxPagesJob &job = *(const DcxPagesJob *)context;
+    for (CKDWORD i = begin; i < end; i++)
+        job.errors[i] = DCX_ReadPage(*job.archive, job.first + i, &job.results[i]);
+}
+
+int DCX_ReadPages(const DcxArchive &archive, CKDWORD first, CKDWORD count, CKBitmapProperties *results)
+{
+    if (!results)
+        return CKBITMAPERROR_GENERIC;
+    if (first > archive.pageCount || count > archive.pageCount - first)
+        return CKBITMAPERROR_READERROR;
+    if (count == 0)
+        return 0;
+
+    int errors[DCX_MAX_PAGES];
+    DcxPagesJob job;
+    job.archive = &archive;
+    job.first = first;
+    job.results = results;
+    job.errors = errors;
+    ImageParallelFor(count, 1, DecodeDcxPages, &job);
+
+    for (CKDWORD i = 0; i < count; i++)
+        if (errors[i] != 0)
+            return errors[i];
+    return 0;
+}
+
+//=============================================================================
+// DcxReader Class Implementation
+//=============================================================================
+DcxReader::DcxReader() : ImageReader()
+{
+    m_Properties.Init(DCXREADER_GUID, "dcx");
+}
+
+DcxReader::~DcxReader()
+{
+    FreeBitmapData(&m_Properties);
+}
+
+CKPluginInfo *DcxReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_DCX];
+}
+
+int DcxReader::GetOptionsCount() { return 0; }
+
+CKSTRING DcxReader::GetOptionDescription(int i) { return ""; }
+
+int DcxReader::ReadFile(CKSTRING filename, CKBitmapProperties **bp)
+{
+    if (!filename || !bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_DCX, (void *)filename, 0, (CKBitmapProperties *)&m_Properties, 0);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int DcxReader::ReadMemory(void *memory, int size, CKBitmapProperties **bp)
+{
+    if (!bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_DCX, memory, size, (CKBitmapProperties *)&m_Properties, 0);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int DcxReader::ReadOwnFormat(void *data, int size, CKBitmapProperties *props)
+{
+    return DCX_Read(data, size, props);
+}
+
+//=============================================================================
+// DCX_Read - Core Reading Function
+//=============================================================================
+int DCX_Read(void *data, int size, CKBitmapProperties *props)
+{
+    if (!data || !props)
+        return CKBITMAPERROR_GENERIC;
+    if (size < 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // Files are mapped so the page is decoded straight from the mapping
+    ImageFileMap fileMap;
+    if (size == 0)
+    {
+        if (!fileMap.Open((const char *)data))
+            return CKBITMAPERROR_READERROR;
+        data = (void *)fileMap.Data();
+        size = (int)fileMap.Size();
+    }
+
+    DcxArchive archive;
+    int result = DCX_Index(data, size, archive);
+    if (result != 0)
+        return result;
+    return DCX_ReadPage(archive, 0, props);
+}
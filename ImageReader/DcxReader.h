@@ -0,0 +1,77 @@
+#ifndef DCXREADER_H
+#define DCXREADER_H
+
+#include "ImageReader.h"
+
+// DCX Reader GUID
+#define DCXREADER_GUID CKGUID(0x2F4A6C1B, 0x5E3D7A09)
+
+/**
+ * DcxReader - ZSoft multi-page PCX (DCX) reader
+ *
+ *   - A 4-byte magic followed by a zero-terminated table of up to 1023 page offsets
+ *   - Every page is a complete PCX file, decoded by PCX_Read in place
+ *   - ReadFile/ReadMemory return the first page; use DCX_Index and
+ *     DCX_ReadPage/DCX_ReadPages to access the others
+ *   - Read-only: SaveFile and SaveMemory return 0
+ */
+class DcxReader : public ImageReader
+{
+public:
+    DcxReader();
+    virtual ~DcxReader();
+
+    virtual CKPluginInfo *GetReaderInfo();
+    virtual int GetOptionsCount();
+    virtual CKSTRING GetOptionDescription(int i);
+
+    virtual int ReadFile(CKSTRING filename, CKBitmapProperties **bp);
+    virtual int ReadMemory(void *memory, int size, CKBitmapProperties **bp);
+
+protected:
+    virtual int ReadOwnFormat(void *data, int size, CKBitmapProperties *props);
+
+private:
+    PcxBitmapProperties m_Properties;
+};
+
+//=============================================================================
+// DCX file format
+//=============================================================================
+#define DCX_MAGIC 0x3ADE68B1
+#define DCX_MAX_PAGES 1023
+
+struct DcxPage
+{
+    CKDWORD offset; // start of the page's PCX data in the archive
+    CKDWORD size;   // up to the next page, or the end of the archive
+};
+
+// Page index of a DCX archive. The archive bytes are referenced, not copied,
+// and must stay valid while pages are decoded.
+struct DcxArchive
+{
+    const CKBYTE *data;
+    CKDWORD size;
+    CKDWORD pageCount;
+    DcxPage pages[DCX_MAX_PAGES];
+};
+
+//=============================================================================
+// Internal helper functions
+//=============================================================================
+
+// Validates the archive header and builds the page index
+int DCX_Index(const void *data, int size, DcxArchive &archive);
+
+// Decodes one page through PCX_Read on its sub-range of the archive
+int DCX_ReadPage(const DcxArchive &archive, CKDWORD page, CKBitmapProperties *props);
+
+// Decodes pages [first, first + count) on the worker pool; results[i] receives
+// page first + i. Returns the error of the lowest failing page, or 0.
+int DCX_ReadPages(const DcxArchive &archive, CKDWORD first, CKDWORD count, CKBitmapProperties *results);
+
+// Core DCX read function: decodes the first page (size == 0 means data is a filename)
+int DCX_Read(void *data, int size, CKBitmapProperties *props);
+
+#endif // DCXREADER_H
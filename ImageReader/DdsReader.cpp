@@ -0,0 +1,540 @@
+#include "DdsReader.h"
+#include "ImageBcn.h"
+#include "ImageSimd.h"
+#include "ImageThreadPool.h"
+#include "ImageFileMap.h"
+
+#define DDS_FOURCC(a, b, c, d) ((CKDWORD)(a) | ((CKDWORD)(b) << 8) | ((CKDWORD)(c) << 16) | ((CKDWORD)(d) << 24))
+
+static CKDWORD ReadLE32(const CKBYTE *p)
+{
+    return (CKDWORD)p[0] | ((CKDWORD)p[1] << 8) | ((CKDWORD)p[2] << 16) | ((CKDWORD)p[3] << 24);
+}
+
+static void SetMask(DdsMaskFormat &mask, CKDWORD bitCount, CKDWORD r, CKDWORD g, CKDWORD b, CKDWORD a)
+{
+    mask.bitCount = bitCount;
+    mask.redMask = r;
+    mask.greenMask = g;
+    mask.blueMask = b;
+    mask.alphaMask = a;
+    mask.luminance = FALSE;
+}
+
+//=============================================================================
+// Pixel Formats
+//=============================================================================
+static CKBOOL FourCCToFormat(CKDWORD fourCC, DdsImageInfo &info)
+{
+    switch (fourCC)
+    {
+    case DDS_FOURCC('D', 'X', 'T', '1'):
+        info.blockFormat = IMAGE_BLOCK_BC1;
+        return TRUE;
+    case DDS_FOURCC('D', 'X', 'T', '2'): // premultiplied alpha, decoded as is
+    case DDS_FOURCC('D', 'X', 'T', '3'):
+        info.blockFormat = IMAGE_BLOCK_BC2;
+        return TRUE;
+    case DDS_FOURCC('D', 'X', 'T', '4'):
+    case DDS_FOURCC('D', 'X', 'T', '5'):
+        info.blockFormat = IMAGE_BLOCK_BC3;
+        return TRUE;
+    case DDS_FOURCC('A', 'T', 'I', '1'):
+    case DDS_FOURCC('B', 'C', '4', 'U'):
+        info.blockFormat = IMAGE_BLOCK_BC4;
+        return TRUE;
+    case DDS_FOURCC('B', 'C', '4', 'S'):
+        info.blockFormat = IMAGE_BLOCK_BC4_SNORM;
+        return TRUE;
+    case DDS_FOURCC('A', 'T', 'I', '2'):
+    case DDS_FOURCC('B', 'C', '5', 'U'):
+        info.blockFormat = IMAGE_BLOCK_BC5;
+        return TRUE;
+    case DDS_FOURCC('B', 'C', '5', 'S'):
+        info.blockFormat = IMAGE_BLOCK_BC5_SNORM;
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+// DXGI_FORMAT values of the DX10 header (typeless formats read as UNORM)
+static CKBOOL DxgiToFormat(CKDWORD dxgi, DdsImageInfo &info)
+{
+    switch (dxgi)
+    {
+    case 70: // BC1
+    case 71:
+    case 72:
+        info.blockFormat = IMAGE_BLOCK_BC1;
+        break;
+    case 73: // BC2
+    case 74:
+    case 75:
+        info.blockFormat = IMAGE_BLOCK_BC2;
+        break;
+    case 76: // BC3
+    case 77:
+    case 78:
+        info.blockFormat = IMAGE_BLOCK_BC3;
+        break;
+    case 79: // BC4
+    case 80:
+        info.blockFormat = IMAGE_BLOCK_BC4;
+        break;
+    case 81:
+        info.blockFormat = IMAGE_BLOCK_BC4_SNORM;
+        break;
+    case 82: // BC5
+    case 83:
+        info.blockFormat = IMAGE_BLOCK_BC5;
+        break;
+    case 84:
+        info.blockFormat = IMAGE_BLOCK_BC5_SNORM;
+        break;
+    case 94: // BC6H
+    case 95:
+        info.blockFormat = IMAGE_BLOCK_BC6H;
+        break;
+    case 96:
+        info.blockFormat = IMAGE_BLOCK_BC6H_SF16;
+        break;
+    case 97: // BC7
+    case 98:
+    case 99:
+        info.blockFormat = IMAGE_BLOCK_BC7;
+        break;
+    case 27: // R8G8B8A8
+    case 28:
+    case 29:
+        SetMask(info.mask, 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000);
+        break;
+    case 87: // B8G8R8A8
+    case 90:
+    case 91:
+        SetMask(info.mask, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+        break;
+    case 88: // B8G8R8X8
+    case 92:
+    case 93:
+        SetMask(info.mask, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0);
+        break;
+    case 61: // R8, read as gray
+        SetMask(info.mask, 8, 0xFF, 0, 0, 0);
+        info.mask.luminance = TRUE;
+        break;
+    case 65: // A8
+        SetMask(info.mask, 8, 0, 0, 0, 0xFF);
+        break;
+    default:
+        return FALSE;
+    }
+    info.srgb = (dxgi == 29 || dxgi == 72 || dxgi == 75 || dxgi == 78 || dxgi == 91 || dxgi == 93 || dxgi == 99);
+    return TRUE;
+}
+
+static CKDWORD FullChainLevels(CKDWORD width, CKDWORD height)
+{
+    CKDWORD side = (width > height) ? width : height;
+    CKDWORD levels = 1;
+    while (side > 1)
+    {
+        side >>= 1;
+        levels++;
+    }
+    return levels;
+}
+
+//=============================================================================
+// DDS_ReadInfo - Header Parsing
+//=============================================================================
+int DDS_ReadInfo(const CKBYTE *data, CKDWORD size, DdsImageInfo &info)
+{
+    memset(&info, 0, sizeof(info));
+    if (size < DDS_HEADER_SIZE)
+        return CKBITMAPERROR_READERROR;
+    if (memcmp(data, DDS_MAGIC, 4) != 0)
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    if (ReadLE32(data + 4) != 124)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    info.height = ReadLE32(data + 12);
+    info.width = ReadLE32(data + 16);
+    CKDWORD depth = ReadLE32(data + 24);
+    info.mipCount = ReadLE32(data + 28);
+    // Writers do not reliably set DDSD_MIPMAPCOUNT, so the count alone is used
+    if (info.mipCount == 0)
+        info.mipCount = 1;
+    info.faces = 1;
+    info.layers = 1;
+    info.depth = 1;
+    info.dataOffset = DDS_HEADER_SIZE;
+
+    CKDWORD pfFlags = ReadLE32(data + 80);
+    CKDWORD fourCC = ReadLE32(data + 84);
+    CKDWORD caps2 = ReadLE32(data + 112);
+    if ((pfFlags & DDPF_FOURCC) && fourCC == DDS_FOURCC('D', 'X', '1', '0'))
+    {
+        if (size < DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE)
+            return CKBITMAPERROR_READERROR;
+        const CKBYTE *dx10 = data + DDS_HEADER_SIZE;
+        if (!DxgiToFormat(ReadLE32(dx10), info))
+            return CKBITMAPERROR_UNSUPPORTEDFILE;
+        if (ReadLE32(dx10 + 4) == DDS_DIMENSION_TEXTURE3D)
+            info.depth = depth ? depth : 1;
+        if (ReadLE32(dx10 + 8) & DDS_MISC_TEXTURECUBE)
+            info.faces = 6;
+        // Some writers leave the array size 0 for a single texture
+        info.layers = ReadLE32(dx10 + 12);
+        if (info.layers == 0)
+            info.layers = 1;
+        info.dataOffset = DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE;
+    }
+    else
+    {
+        if (pfFlags & DDPF_FOURCC)
+        {
+            if (!FourCCToFormat(fourCC, info))
+                return CKBITMAPERROR_UNSUPPORTEDFILE;
+        }
+        else if (pfFlags & (DDPF_RGB | DDPF_LUMINANCE | DDPF_ALPHA))
+        {
+            CKDWORD bitCount = ReadLE32(data + 88);
+            if (bitCount != 8 && bitCount != 16 && bitCount != 24 && bitCount != 32)
+                return CKBITMAPERROR_UNSUPPORTEDFILE;
+            CKDWORD colorMask = (pfFlags & (DDPF_RGB | DDPF_LUMINANCE)) ? 0xFFFFFFFF : 0;
+            CKDWORD alphaMask = (pfFlags & (DDPF_ALPHAPIXELS | DDPF_ALPHA)) ? ReadLE32(data + 104) : 0;
+            SetMask(info.mask, bitCount, ReadLE32(data + 92) & colorMask, ReadLE32(data + 96) & colorMask,
+                    ReadLE32(data + 100) & colorMask, alphaMask);
+            info.mask.luminance = (pfFlags & DDPF_LUMINANCE) != 0;
+        }
+        else
+        {
+            return CKBITMAPERROR_UNSUPPORTEDFILE;
+        }
+
+        if (caps2 & DDSCAPS2_CUBEMAP)
+        {
+            info.faces = ImagePopCount(caps2 & DDSCAPS2_CUBEMAP_ALLFACES);
+            if (info.faces == 0)
+                info.faces = 6;
+        }
+        if (caps2 & DDSCAPS2_VOLUME)
+            info.depth = depth ? depth : 1;
+    }
+
+    if (info.width == 0 || info.height == 0 || !ImageWithinDecodeLimits(info.width, info.height, 0))
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (info.mipCount > DDS_MAX_LEVELS || info.mipCount > FullChainLevels(info.width, info.height))
+        return CKBITMAPERROR_FILECORRUPTED;
+    return 0;
+}
+
+//=============================================================================
+// Uncompressed Conversion
+//=============================================================================
+enum MaskLayout
+{
+    MASK_GENERIC,
+    MASK_BGRA,
+    MASK_BGRX,
+    MASK_RGBA,
+    MASK_RGB,
+    MASK_GRAY
+};
+
+struct MaskChannel
+{
+    CKDWORD mask;
+    CKDWORD shift;
+    CKDWORD bits;
+    CKDWORD maxValue;
+};
+
+struct MaskConvertJob
+{
+    const CKBYTE *src;
+    int srcPitch;
+    CKDWORD bytesPerPixel;
+    MaskLayout layout;
+    MaskChannel channels[4]; // R, G, B, A
+    CKBOOL luminance;
+    CKDWORD width;
+    CKBYTE *dst;
+    int dstStride;
+};
+
+static MaskLayout FindLayout(const DdsMaskFormat &fmt)
+{
+    if (fmt.luminance)
+        return (fmt.bitCount == 8 && fmt.redMask == 0xFF && !fmt.alphaMask) ? MASK_GRAY : MASK_GENERIC;
+    if (fmt.bitCount == 32 && fmt.greenMask == 0x0000FF00)
+    {
+        if (fmt.redMask == 0x00FF0000 && fmt.blueMask == 0x000000FF)
+            return (fmt.alphaMask == 0xFF000000) ? MASK_BGRA : (fmt.alphaMask == 0) ? MASK_BGRX : MASK_GENERIC;
+        if (fmt.redMask == 0x000000FF && fmt.blueMask == 0x00FF0000 && fmt.alphaMask == 0xFF000000)
+            return MASK_RGBA;
+    }
+    if (fmt.bitCount == 24 && fmt.redMask == 0x000000FF && fmt.greenMask == 0x0000FF00 &&
+        fmt.blueMask == 0x00FF0000)
+        return MASK_RGB;
+    return MASK_GENERIC;
+}
+
+static void SetupChannel(MaskChannel &channel, CKDWORD mask)
+{
+    channel.mask = mask;
+    channel.shift = mask ? ImageLowestBit(mask) : 0;
+    channel.bits = ImagePopCount(mask);
+    channel.maxValue = (channel.bits >= 32) ? 0xFFFFFFFF : (1u << channel.bits) - 1;
+}
+
+static CKDWORD ScaleChannel(CKDWORD pixel, const MaskChannel &channel, CKDWORD missing)
+{
+    if (!channel.mask)
+        return missing;
+    CKDWORD value = (pixel & channel.mask) >> channel.shift;
+    if (channel.bits >= 8)
+        return (value >> (channel.bits - 8)) & 0xFF;
+    return (value * 255 + channel.maxValue / 2) / channel.maxValue;
+}
+
+static void ConvertGenericRow(const MaskConvertJob &job, const CKBYTE *src, CKBYTE *dst)
+{
+    for (CKDWORD x = 0; x < job.width; x++, src += job.bytesPerPixel, dst += 4)
+    {
+        CKDWORD pixel = 0;
+        for (CKDWORD i = 0; i < job.bytesPerPixel; i++)
+            pixel |= (CKDWORD)src[i] << (i * 8);
+        CKDWORD r = ScaleChannel(pixel, job.channels[0], 0);
+        CKDWORD g = ScaleChannel(pixel, job.channels[1], 0);
+        CKDWORD b = ScaleChannel(pixel, job.channels[2], 0);
+        if (job.luminance)
+            g = b = r;
+        dst[0] = (CKBYTE)b;
+        dst[1] = (CKBYTE)g;
+        dst[2] = (CKBYTE)r;
+        dst[3] = (CKBYTE)ScaleChannel(pixel, job.channels[3], 255);
+    }
+}
+
+static void ConvertMaskedRows(void *context, CKDWORD begin, CKDWORD end)
+{
+    const MaskConvertJob &job = *(const MaskConvertJob *)context;
+    for (CKDWORD y = begin; y < end; y++)
+    {
+        const CKBYTE *src = job.src + (size_t)y * job.srcPitch;
+        CKBYTE *dst = job.dst + (size_t)y * job.dstStride;
+        switch (job.layout)
+        {
+        case MASK_BGRA:
+            memcpy(dst, src, (size_t)job.width * 4);
+            break;
+        case MASK_BGRX:
+            memcpy(dst, src, (size_t)job.width * 4);
+            for (CKDWORD x = 0; x < job.width; x++)
+                dst[x * 4 + 3] = 0xFF;
+            break;
+        case MASK_RGBA:
+            ImageRGBAToBGRA32(src, dst, (int)job.width);
+            break;
+        case MASK_RGB:
+            ImageRGBToBGRA32(src, dst, (int)job.width);
+            break;
+        case MASK_GRAY:
+            ImageGrayToBGRA32(src, dst, (int)job.width);
+            break;
+        default:
+            ConvertGenericRow(job, src, dst);
+            break;
+        }
+    }
+}
+
+void DDS_ConvertMasked(const CKBYTE *src, int srcPitch, const DdsMaskFormat &fmt, CKDWORD width, CKDWORD height,
+                       CKBYTE *dst, int dstStride)
+{
+    MaskConvertJob job;
+    job.src = src;
+    job.srcPitch = srcPitch;
+    job.bytesPerPixel = fmt.bitCount / 8;
+    job.layout = FindLayout(fmt);
+    SetupChannel(job.channels[0], fmt.redMask);
+    SetupChannel(job.channels[1], fmt.luminance ? 0 : fmt.greenMask);
+    SetupChannel(job.channels[2], fmt.luminance ? 0 : fmt.blueMask);
+    SetupChannel(job.channels[3], fmt.alphaMask);
+    job.luminance = fmt.luminance;
+    job.width = width;
+    job.dst = dst;
+    job.dstStride = dstStride;
+    ImageParallelFor(height, 16, ConvertMaskedRows, &job);
+}
+
+//=============================================================================
+// DdsReader Class Implementation
+//=============================================================================
+DdsReader::DdsReader() : ImageReader(), m_ReadFlags(0)
+{
+    m_Properties.Init(DDSREADER_GUID, "dds");
+}
+
+DdsReader::~DdsReader()
+{
+    FreeBitmapData(&m_Properties);
+}
+
+CKPluginInfo *DdsReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_DDS];
+}
+
+void DdsReader::SetReadFlags(CKDWORD flags) { m_ReadFlags = flags; }
+
+CKDWORD DdsReader::GetReadFlags() { return m_ReadFlags; }
+
+int DdsReader::GetOptionsCount() { return 0; }
+
+CKSTRING DdsReader::GetOptionDescription(int i) { return ""; }
+
+int DdsReader::ReadFile(CKSTRING filename, CKBitmapProperties **bp)
+{
+    if (!filename || !bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_DDS, (void *)filename, 0, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int DdsReader::ReadMemory(void *memory, int size, CKBitmapProperties **bp)
+{
+    if (!bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_DDS, memory, size, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int DdsReader::ReadOwnFormat(void *data, int size, CKBitmapProperties *props)
+{
+    return DDS_Read(data, size, props, m_ReadFlags);
+}
+
+//=============================================================================
+// DDS_Read - Core Reading Function
+//=============================================================================
+
+// Bytes of one face, layer and slice of a level
+static uint64_t SliceSize(const DdsImageInfo &info, CKDWORD width, CKDWORD height)
+{
+    if (info.blockFormat != IMAGE_BLOCK_NONE)
+        return ImageBlockLevelSize(info.blockFormat, width, height);
+    return (uint64_t)width * (info.mask.bitCount / 8) * height;
+}
+
+int DDS_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags)
+{
+    if (!data || !props)
+        return CKBITMAPERROR_GENERIC;
+    if (size < 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // Files are mapped; blocks are copied or decoded straight from the mapping
+    ImageFileMap fileMap;
+    if (size == 0)
+    {
+        if (!fileMap.Open((const char *)data))
+            return CKBITMAPERROR_READERROR;
+        data = (void *)fileMap.Data();
+        size = (int)fileMap.Size();
+    }
+
+    const CKBYTE *bytes = (const CKBYTE *)data;
+    DdsImageInfo info;
+    int err = DDS_ReadInfo(bytes, (CKDWORD)size, info);
+    if (err != 0)
+        return err;
+
+    const CKBYTE *pixels = bytes + info.dataOffset;
+    uint64_t available = (CKDWORD)size - info.dataOffset;
+    CKDWORD blockBytes = ImageBlockBytes(info.blockFormat);
+    CKBYTE *dstPixels;
+    uint64_t dataSize;
+    if ((readFlags & IMAGE_READ_KEEP_BLOCKS) && blockBytes)
+    {
+        // The first face's levels follow each other; volume levels hold all
+        // their slices, of which the first is kept. Every level must be
+        // present before anything is allocated.
+        uint64_t offset = 0;
+        CKDWORD width = info.width, height = info.height, depth = info.depth;
+        for (CKDWORD level = 0; level < info.mipCount; level++)
+        {
+            uint64_t slice = SliceSize(info, width, height);
+            if (offset + slice > available)
+                return CKBITMAPERROR_READERROR;
+            offset += slice * depth;
+            width = (width > 1) ? width / 2 : 1;
+            height = (height > 1) ? height / 2 : 1;
+            depth = (depth > 1) ? depth / 2 : 1;
+        }
+
+        dataSize = ImageBlockChainSize(info.blockFormat, info.width, info.height, info.mipCount);
+        if (!ImageWithinDecodeLimits(info.width, info.height, dataSize))
+            return CKBITMAPERROR_FILECORRUPTED;
+        dstPixels = new CKBYTE[(size_t)dataSize];
+        offset = 0;
+        uint64_t written = 0;
+        width = info.width;
+        height = info.height;
+        depth = info.depth;
+        for (CKDWORD level = 0; level < info.mipCount; level++)
+        {
+            uint64_t slice = SliceSize(info, width, height);
+            memcpy(dstPixels + written, pixels + offset, (size_t)slice);
+            written += slice;
+            offset += slice * depth;
+            width = (width > 1) ? width / 2 : 1;
+            height = (height > 1) ? height / 2 : 1;
+            depth = (depth > 1) ? depth / 2 : 1;
+        }
+        ImageReader::FillFormatBlocks(props->m_Format, (int)info.width, (int)info.height, (int)blockBytes, dstPixels);
+    }
+    else
+    {
+        if (SliceSize(info, info.width, info.height) > available)
+            return CKBITMAPERROR_READERROR;
+
+        CKBOOL toFloat = (readFlags & IMAGE_READ_FLOAT) &&
+                         (info.blockFormat == IMAGE_BLOCK_BC6H || info.blockFormat == IMAGE_BLOCK_BC6H_SF16);
+        uint64_t dstStride64 = (uint64_t)info.width * (toFloat ? 16 : 4);
+        if (!ImageWithinDecodeLimits(info.width, info.height, dstStride64 * info.height))
+            return CKBITMAPERROR_FILECORRUPTED;
+
+        int dstStride = (int)dstStride64;
+        dataSize = dstStride64 * info.height;
+        dstPixels = new CKBYTE[(size_t)dataSize];
+        if (blockBytes)
+            ImageDecodeBlockLevel(info.blockFormat, pixels, info.width, info.height, dstPixels, dstStride, toFloat);
+        else
+            DDS_ConvertMasked(pixels, (int)(info.width * (info.mask.bitCount / 8)), info.mask, info.width, info.height,
+                              dstPixels, dstStride);
+
+        if (toFloat)
+            ImageReader::FillFormatRGBA128F(props->m_Format, (int)info.width, (int)info.height, dstStride, dstPixels);
+        else
+            ImageReader::FillFormatBGRA32(props->m_Format, (int)info.width, (int)info.height, dstStride, dstPixels);
+    }
+    props->m_Data = dstPixels;
+
+    if (props->m_Size == sizeof(DdsBitmapProperties))
+    {
+        DdsBitmapProperties *ddsProps = (DdsBitmapProperties *)props;
+        ddsProps->m_BlockFormat = info.blockFormat;
+        ddsProps->m_MipCount = info.mipCount;
+        ddsProps->m_DataSize = (CKDWORD)dataSize;
+        ddsProps->m_Faces = info.faces;
+        ddsProps->m_Layers = info.layers;
+        ddsProps->m_Depth = info.depth;
+        ddsProps->m_Srgb = info.srgb;
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+#ifndef DDSREADER_H
+#define DDSREADER_H
+
+#include "ImageReader.h"
+
+// DDS Reader GUID
+#define DDSREADER_GUID CKGUID(0x00FCFD15, 0x1C7A7A16)
+
+/**
+ * DdsReader - DirectDraw Surface (.dds) reader
+ *
+ *   - BC1 to BC7 (DXT1-5, ATI1/ATI2, BC4/BC5 signed and the DX10 header)
+ *     and uncompressed RGB, luminance and alpha pixel formats
+ *   - With IMAGE_READ_KEEP_BLOCKS the blocks of the whole mip chain are
+ *     copied once from the mapped file and never decoded
+ *   - Otherwise the top level is decoded to BGRA32, block rows in parallel
+ *     (ImageDecodeBlockLevel); BC6H gives RGBA float with IMAGE_READ_FLOAT
+ *   - Only the first face of cube maps, element of arrays and slice of
+ *     volume textures is read
+ *   - Read-only: SaveFile and SaveMemory return 0
+ */
+class DdsReader : public ImageReader
+{
+public:
+    DdsReader();
+    virtual ~DdsReader();
+
+    virtual CKPluginInfo *GetReaderInfo();
+    virtual int GetOptionsCount();
+    virtual CKSTRING GetOptionDescription(int i);
+
+    virtual int ReadFile(CKSTRING filename, CKBitmapProperties **bp);
+    virtual int ReadMemory(void *memory, int size, CKBitmapProperties **bp);
+
+    // IMAGE_READ_* flags applied by ReadFile/ReadMemory (default 0)
+    void SetReadFlags(CKDWORD flags);
+    CKDWORD GetReadFlags();
+
+protected:
+    virtual int ReadOwnFormat(void *data, int size, CKBitmapProperties *props);
+
+private:
+    DdsBitmapProperties m_Properties;
+    CKDWORD m_ReadFlags;
+};
+
+//=============================================================================
+// DDS file format
+//=============================================================================
+#define DDS_MAGIC "DDS "
+#define DDS_HEADER_SIZE 128 // magic and header
+#define DDS_DX10_HEADER_SIZE 20
+
+// Pixel format flags
+#define DDPF_ALPHAPIXELS 0x00000001
+#define DDPF_ALPHA 0x00000002
+#define DDPF_FOURCC 0x00000004
+#define DDPF_RGB 0x00000040
+#define DDPF_LUMINANCE 0x00020000
+
+// Caps2 flags
+#define DDSCAPS2_CUBEMAP 0x00000200
+#define DDSCAPS2_CUBEMAP_ALLFACES 0x0000FC00
+#define DDSCAPS2_VOLUME 0x00200000
+
+// DX10 header values
+#define DDS_DIMENSION_TEXTURE3D 4
+#define DDS_MISC_TEXTURECUBE 0x4
+
+// Mip chains cannot be longer than a 2^31 pixel side
+#define DDS_MAX_LEVELS 32
+
+// Uncompressed pixels: little-endian units of bitCount bits (8 to 32), with
+// channel masks as in the DDS pixel format. Luminance copies red to green
+// and blue; channels without a mask are 0, and 255 for alpha.
+struct DdsMaskFormat
+{
+    CKDWORD bitCount;
+    CKDWORD redMask;
+    CKDWORD greenMask;
+    CKDWORD blueMask;
+    CKDWORD alphaMask;
+    CKBOOL luminance;
+};
+
+struct DdsImageInfo
+{
+    CKDWORD width;
+    CKDWORD height;
+    CKDWORD depth;    // 1 unless a volume texture
+    CKDWORD mipCount; // at least 1
+    CKDWORD faces;    // 6 for cube maps
+    CKDWORD layers;   // DX10 array size, at least 1
+    CKDWORD blockFormat; // IMAGE_BLOCK_*, or IMAGE_BLOCK_NONE with mask set
+    DdsMaskFormat mask;
+    CKBOOL srgb;
+    CKDWORD dataOffset;
+};
+
+//=============================================================================
+// Internal helper functions
+//=============================================================================
+
+// Parses the header and pixel format (and the DX10 header if present)
+int DDS_ReadInfo(const CKBYTE *data, CKDWORD size, DdsImageInfo &info);
+
+// Converts width x height uncompressed pixels, rows srcPitch bytes apart, to
+// BGRA32 rows on the worker pool. Byte-aligned RGBA, BGRA, RGB and gray go
+// through the SIMD swizzles. Also used by the KTX reader.
+void DDS_ConvertMasked(const CKBYTE *src, int srcPitch, const DdsMaskFormat &fmt, CKDWORD width, CKDWORD height,
+                       CKBYTE *dst, int dstStride);
+
+// Core DDS read function (size == 0 means data is a filename)
+int DDS_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags = 0);
+
+#endif // DDSREADER_H
@@ -0,0 +1,536 @@
+#include "ExrCodec.h"
+#include "ImageInflate.h"
+
+//=============================================================================
+// RLE and ZIP
+//=============================================================================
+
+// Undoes the delta coding in place, then merges the two halves of raw
+// (even bytes first, odd bytes second) into dst
+static void UndoPredictor(CKBYTE *raw, CKDWORD size, CKBYTE *dst)
+{
+    for (CKDWORD i = 1; i < size; i++)
+        raw[i] = (CKBYTE)(raw[i - 1] + raw[i] - 128);
+
+    const CKBYTE *even = raw;
+    const CKBYTE *odd = raw + (size + 1) / 2;
+    CKDWORD i = 0;
+    for (; i + 1 < size; i += 2)
+    {
+        dst[i] = *even++;
+        dst[i + 1] = *odd++;
+    }
+    if (i < size)
+        dst[i] = *even;
+}
+
+CKBOOL EXR_RleDecompress(const CKBYTE *src, CKDWORD srcSize, CKBYTE *dst, CKDWORD dstSize, CKBYTE *scratch)
+{
+    // A negative count n is a literal of -n bytes, a positive one a run of
+    // n + 1 copies of the next byte
+    const CKBYTE *end = src + srcSize;
+    CKDWORD written = 0;
+    while (src < end)
+    {
+        int code = (signed char)*src++;
+        if (code < 0)
+        {
+            CKDWORD n = (CKDWORD)-code;
+            if (n > (CKDWORD)(end - src) || n > dstSize - written)
+                return FALSE;
+            memcpy(scratch + written, src, n);
+            src += n;
+            written += n;
+        }
+        else
+        {
+            CKDWORD n = (CKDWORD)code + 1;
+            if (src == end || n > dstSize - written)
+                return FALSE;
+            memset(scratch + written, *src++, n);
+            written += n;
+        }
+    }
+    if (written != dstSize)
+        return FALSE;
+    UndoPredictor(scratch, dstSize, dst);
+    return TRUE;
+}
+
+CKBOOL EXR_ZipDecompress(const CKBYTE *src, CKDWORD srcSize, CKBYTE *dst, CKDWORD dstSize, CKBYTE *scratch)
+{
+    CKDWORD written = 0;
+    if (!ImageZlibInflate(src, srcSize, scratch, dstSize, &written) || written != dstSize)
+        return FALSE;
+    UndoPredictor(scratch, dstSize, dst);
+    return TRUE;
+}
+
+//=============================================================================
+// Huffman Decoding
+//=============================================================================
+#define HUF_DECBITS 14 // codes up to this length are decoded by one table lookup
+#define HUF_DECSIZE (1 << HUF_DECBITS)
+#define HUF_DECMASK (HUF_DECSIZE - 1)
+
+// Code length table packing: lengths are 6 bits, 59..62 are runs of 2..5
+// zero lengths and 63 is followed by 8 bits giving a run of 6..261
+#define SHORT_ZEROCODE_RUN 59
+#define LONG_ZEROCODE_RUN 63
+#define SHORTEST_LONG_RUN (2 + LONG_ZEROCODE_RUN - SHORT_ZEROCODE_RUN)
+
+// Table entry for the next HUF_DECBITS bits: either a short code (len and
+// symbol) or the range of longCodes holding every longer code with this prefix
+struct HufDecEntry
+{
+    CKDWORD len;
+    CKDWORD symbol;
+    CKDWORD longStart;
+    CKDWORD longCount;
+};
+
+// MSB-first bit reader; bits holds the last count bits read
+struct HufBits
+{
+    const CKBYTE *p;
+    const CKBYTE *end;
+    uint64_t bits;
+    int count;
+
+    CKBOOL Fill(int n)
+    {
+        while (count < n)
+        {
+            if (p == end)
+                return FALSE;
+            bits = (bits << 8) | *p++;
+            count += 8;
+        }
+        return TRUE;
+    }
+    CKDWORD Peek(int n) const { return (CKDWORD)(bits >> (count - n)) & ((1u << n) - 1); }
+};
+
+// Reads the code lengths of symbols first..last and turns them into canonical
+// codes: hcode[i] = code << 6 | length
+static CKBOOL UnpackEncTable(HufBits &in, CKDWORD first, CKDWORD last, uint64_t *hcode)
+{
+    for (CKDWORD i = first; i <= last; i++)
+    {
+        if (!in.Fill(6))
+            return FALSE;
+        CKDWORD l = in.Peek(6);
+        in.count -= 6;
+        hcode[i] = l;
+        if (l >= SHORT_ZEROCODE_RUN)
+        {
+            CKDWORD run = l - SHORT_ZEROCODE_RUN + 2;
+            if (l == LONG_ZEROCODE_RUN)
+            {
+                if (!in.Fill(8))
+                    return FALSE;
+                run = in.Peek(8) + SHORTEST_LONG_RUN;
+                in.count -= 8;
+            }
+            if (run > last + 1 - i)
+                return FALSE;
+            for (CKDWORD k = 0; k < run; k++)
+                hcode[i + k] = 0;
+            i += run - 1;
+        }
+    }
+
+    // Canonical codes, assigned from the longest length down
+    uint64_t n[EXR_HUF_MAX_LENGTH + 1];
+    memset(n, 0, sizeof(n));
+    for (CKDWORD i = 0; i < EXR_HUF_ENCSIZE; i++)
+        n[hcode[i]]++;
+    uint64_t c = 0;
+    for (int l = EXR_HUF_MAX_LENGTH; l > 0; l--)
+    {
+        uint64_t next = (c + n[l]) >> 1;
+        n[l] = c;
+        c = next;
+    }
+    for (CKDWORD i = 0; i < EXR_HUF_ENCSIZE; i++)
+    {
+        uint64_t l = hcode[i];
+        if (l > 0)
+            hcode[i] = l | (n[l]++ << 6);
+    }
+    return TRUE;
+}
+
+static CKBOOL BuildDecTable(const uint64_t *hcode, CKDWORD first, CKDWORD last, HufDecEntry *table,
+                            CKDWORD *&longCodes)
+{
+    memset(table, 0, HUF_DECSIZE * sizeof(HufDecEntry));
+    CKDWORD longTotal = 0;
+    for (CKDWORD i = first; i <= last; i++)
+    {
+        uint64_t code = hcode[i] >> 6;
+        CKDWORD l = (CKDWORD)(hcode[i] & 63);
+        if (code >> l)
+            return FALSE;
+        if (l > HUF_DECBITS)
+        {
+            HufDecEntry &e = table[code >> (l - HUF_DECBITS)];
+            if (e.len)
+                return FALSE;
+            e.longCount++;
+            longTotal++;
+        }
+        else if (l)
+        {
+            HufDecEntry *e = table + (code << (HUF_DECBITS - l));
+            for (CKDWORD k = (CKDWORD)1 << (HUF_DECBITS - l); k > 0; k--, e++)
+            {
+                if (e->len || e->longCount)
+                    return FALSE;
+                e->len = l;
+                e->symbol = i;
+            }
+        }
+    }
+
+    // Long codes are grouped by prefix in one array
+    longCodes = new CKDWORD[longTotal + 1];
+    CKDWORD start = 0;
+    for (CKDWORD k = 0; k < HUF_DECSIZE; k++)
+    {
+        table[k].longStart = start;
+        start += table[k].longCount;
+        table[k].longCount = 0;
+    }
+    for (CKDWORD i = first; i <= last; i++)
+    {
+        CKDWORD l = (CKDWORD)(hcode[i] & 63);
+        if (l > HUF_DECBITS)
+        {
+            HufDecEntry &e = table[(hcode[i] >> 6) >> (l - HUF_DECBITS)];
+            longCodes[e.longStart + e.longCount++] = i;
+        }
+    }
+    return TRUE;
+}
+
+// Emits symbol; the run-length symbol repeats the previous word
+static CKBOOL EmitSymbol(CKDWORD symbol, CKDWORD rlc, HufBits &in, CKWORD *&out, CKWORD *outStart, CKWORD *outEnd)
+{
+    if (symbol == rlc)
+    {
+        if (!in.Fill(8))
+            return FALSE;
+        in.count -= 8;
+        CKDWORD run = (CKDWORD)(in.bits >> in.count) & 0xFF;
+        if (out == outStart || run > (CKDWORD)(outEnd - out))
+            return FALSE;
+        CKWORD value = out[-1];
+        for (CKDWORD k = 0; k < run; k++)
+            *out++ = value;
+        return TRUE;
+    }
+    if (out == outEnd)
+        return FALSE;
+    *out++ = (CKWORD)symbol;
+    return TRUE;
+}
+
+static CKBOOL HufDecodeBits(const uint64_t *hcode, const HufDecEntry *table, const CKDWORD *longCodes,
+                            const CKBYTE *src, CKDWORD bitCount, CKDWORD rlc, CKWORD *dst, CKDWORD count)
+{
+    HufBits in;
+    in.p = src;
+    in.end = src + (bitCount + 7) / 8;
+    in.bits = 0;
+    in.count = 0;
+    CKWORD *out = dst;
+    CKWORD *outEnd = dst + count;
+
+    while (in.p < in.end)
+    {
+        in.bits = (in.bits << 8) | *in.p++;
+        in.count += 8;
+        while (in.count >= HUF_DECBITS)
+        {
+            const HufDecEntry &e = table[in.Peek(HUF_DECBITS)];
+            if (e.len)
+            {
+                in.count -= e.len;
+                if (!EmitSymbol(e.symbol, rlc, in, out, dst, outEnd))
+                    return FALSE;
+                continue;
+            }
+            // Longer code: try each one sharing this prefix
+            CKDWORD k = 0;
+            for (; k < e.longCount; k++)
+            {
+                CKDWORD symbol = longCodes[e.longStart + k];
+                int l = (int)(hcode[symbol] & 63);
+                if (!in.Fill(l))
+                    continue;
+                if ((hcode[symbol] >> 6) == ((in.bits >> (in.count - l)) & ((1ULL << l) - 1)))
+                {
+                    in.count -= l;
+                    if (!EmitSymbol(symbol, rlc, in, out, dst, outEnd))
+                        return FALSE;
+                    break;
+                }
+            }
+            if (k == e.longCount)
+                return FALSE;
+        }
+    }
+
+    // The last codes are shorter than HUF_DECBITS; drop the padding bits
+    int padding = (int)((8 - bitCount) & 7);
+    in.bits >>= padding;
+    in.count -= padding;
+    while (in.count > 0)
+    {
+        const HufDecEntry &e = table[(CKDWORD)(in.bits << (HUF_DECBITS - in.count)) & HUF_DECMASK];
+        if (!e.len || (int)e.len > in.count)
+            return FALSE;
+        in.count -= e.len;
+        if (!EmitSymbol(e.symbol, rlc, in, out, dst, outEnd))
+            return FALSE;
+    }
+    return out == outEnd;
+}
+
+CKBOOL EXR_HufDecode(const CKBYTE *src, CKDWORD srcSize, CKWORD *dst, CKDWORD count)
+{
+    if (srcSize == 0)
+        return count == 0;
+    // Header: first and last symbol (the last is the run-length symbol),
+    // table size (unused), data bits and 4 reserved bytes
+    if (srcSize < 20)
+        return FALSE;
+    CKDWORD first = src[0] | (src[1] << 8) | (src[2] << 16) | ((CKDWORD)src[3] << 24);
+    CKDWORD last = src[4] | (src[5] << 8) | (src[6] << 16) | ((CKDWORD)src[7] << 24);
+    CKDWORD bitCount = src[12] | (src[13] << 8) | (src[14] << 16) | ((CKDWORD)src[15] << 24);
+    if (first >= EXR_HUF_ENCSIZE || last >= EXR_HUF_ENCSIZE || first > last)
+        return FALSE;
+
+    uint64_t *hcode = new uint64_t[EXR_HUF_ENCSIZE];
+    memset(hcode, 0, EXR_HUF_ENCSIZE * sizeof(uint64_t));
+    HufBits tableBits;
+    tableBits.p = src + 20;
+    tableBits.end = src + srcSize;
+    tableBits.bits = 0;
+    tableBits.count = 0;
+    CKBOOL ok = UnpackEncTable(tableBits, first, last, hcode);
+
+    // Lengths past 56 bits cannot come from a chunk of valid size and would
+    // overflow the bit reader
+    for (CKDWORD i = first; ok && i <= last; i++)
+        ok = (hcode[i] & 63) <= 56;
+
+    const CKBYTE *data = tableBits.p;
+    ok = ok && (uint64_t)bitCount <= 8 * (uint64_t)(src + srcSize - data);
+
+    HufDecEntry *table = NULL;
+    CKDWORD *longCodes = NULL;
+    if (ok)
+    {
+        table = new HufDecEntry[HUF_DECSIZE];
+        ok = BuildDecTable(hcode, first, last, table, longCodes);
+    }
+    if (ok)
+        ok = HufDecodeBits(hcode, table, longCodes, data, bitCount, last, dst, count);
+
+    delete[] longCodes;
+    delete[] table;
+    delete[] hcode;
+    return ok;
+}
+
+//=============================================================================
+// Wavelet
+//=============================================================================
+
+// 14-bit transform: plain averages and differences of signed values
+static inline void Wdec14(CKWORD l, CKWORD h, CKWORD &a, CKWORD &b)
+{
+    short ls = (short)l;
+    short hs = (short)h;
+    int hi = hs;
+    int ai = ls + (hi & 1) + (hi >> 1);
+    a = (CKWORD)(short)ai;
+    b = (CKWORD)(short)(ai - hi);
+}
+
+// 16-bit transform: modulo arithmetic, so no value overflows
+static inline void Wdec16(CKWORD l, CKWORD h, CKWORD &a, CKWORD &b)
+{
+    int m = l;
+    int d = h;
+    int bb = (m - (d >> 1)) & 0xFFFF;
+    int aa = (d + bb - 0x8000) & 0xFFFF;
+    b = (CKWORD)bb;
+    a = (CKWORD)aa;
+}
+
+template <void (*Wdec)(CKWORD, CKWORD, CKWORD &, CKWORD &)>
+static void Wav2DecodeT(CKWORD *data, int nx, int ox, int ny, int oy)
+{
+    int n = (nx > ny) ? ny : nx;
+    int p = 1;
+    while (p <= n)
+        p <<= 1;
+    p >>= 1;
+    int p2 = p;
+    p >>= 1;
+
+    // Levels from the coarsest to the finest
+    while (p >= 1)
+    {
+        CKWORD *py = data;
+        CKWORD *ey = data + oy * (ny - p2);
+        int oy1 = oy * p;
+        int oy2 = oy * p2;
+        int ox1 = ox * p;
+        int ox2 = ox * p2;
+        CKWORD i00, i01, i10, i11;
+
+        for (; py <= ey; py += oy2)
+        {
+            CKWORD *px = py;
+            CKWORD *ex = py + ox * (nx - p2);
+            for (; px <= ex; px += ox2)
+            {
+                CKWORD *p01 = px + ox1;
+                CKWORD *p10 = px + oy1;
+                CKWORD *p11 = p10 + ox1;
+                Wdec(*px, *p10, i00, i10);
+                Wdec(*p01, *p11, i01, i11);
+                Wdec(i00, i01, *px, *p01);
+                Wdec(i10, i11, *p10, *p11);
+            }
+            // Odd column
+            if (nx & p)
+            {
+                CKWORD *p10 = px + oy1;
+                Wdec(*px, *p10, i00, *p10);
+                *px = i00;
+            }
+        }
+        // Odd row
+        if (ny & p)
+        {
+            CKWORD *px = py;
+            CKWORD *ex = py + ox * (nx - p2);
+            for (; px <= ex; px += ox2)
+            {
+                CKWORD *p01 = px + ox1;
+                Wdec(*px, *p01, i00, *p01);
+                *px = i00;
+            }
+        }
+        p2 = p;
+        p >>= 1;
+    }
+}
+
+void EXR_Wav2Decode(CKWORD *data, int nx, int ox, int ny, int oy, CKWORD maxValue)
+{
+    if (maxValue < (1 << 14))
+        Wav2DecodeT<Wdec14>(data, nx, ox, ny, oy);
+    else
+        Wav2DecodeT<Wdec16>(data, nx, ox, ny, oy);
+}
+
+//=============================================================================
+// PIZ
+//=============================================================================
+
+// Maps the dense values 0..n back to the values present in the bitmap
+// (0 always is); returns n
+static CKWORD ReverseLutFromBitmap(const CKBYTE *bitmap, CKWORD *lut)
+{
+    CKDWORD k = 0;
+    for (CKDWORD i = 0; i < 65536; i++)
+    {
+        if (i == 0 || (bitmap[i >> 3] & (1 << (i & 7))))
+            lut[k++] = (CKWORD)i;
+    }
+    CKDWORD n = k - 1;
+    while (k < 65536)
+        lut[k++] = 0;
+    return (CKWORD)n;
+}
+
+CKBOOL EXR_PizDecompress(const CKBYTE *src, CKDWORD srcSize, CKBYTE *dst, int width, int lines,
+                         const int *channelWords, int channelCount)
+{
+    CKDWORD rowWords = 0;
+    for (int c = 0; c < channelCount; c++)
+        rowWords += (CKDWORD)width * channelWords[c];
+    CKDWORD count = rowWords * lines;
+
+    // Bitmap of the values used, stored from its first to its last non-zero byte
+    if (srcSize < 4)
+        return FALSE;
+    CKDWORD minNonZero = src[0] | (src[1] << 8);
+    CKDWORD maxNonZero = src[2] | (src[3] << 8);
+    if (maxNonZero >= EXR_PIZ_BITMAP_SIZE)
+        return FALSE;
+    CKBYTE bitmap[EXR_PIZ_BITMAP_SIZE];
+    memset(bitmap, 0, sizeof(bitmap));
+    CKDWORD pos = 4;
+    if (minNonZero <= maxNonZero)
+    {
+        CKDWORD n = maxNonZero - minNonZero + 1;
+        if (n > srcSize - pos)
+            return FALSE;
+        memcpy(bitmap + minNonZero, src + pos, n);
+        pos += n;
+    }
+    if (srcSize - pos < 4)
+        return FALSE;
+    CKDWORD length = src[pos] | (src[pos + 1] << 8) | (src[pos + 2] << 16) | ((CKDWORD)src[pos + 3] << 24);
+    pos += 4;
+    if (length > srcSize - pos)
+        return FALSE;
+
+    CKWORD *words = new CKWORD[count];
+    CKWORD *lut = new CKWORD[65536];
+    CKWORD maxValue = ReverseLutFromBitmap(bitmap, lut);
+    CKBOOL ok = EXR_HufDecode(src + pos, length, words, count);
+    if (ok)
+    {
+        // Each channel is one array of its own (row-major, words of a sample together)
+        CKWORD *channel = words;
+        for (int c = 0; c < channelCount; c++)
+        {
+            int w = channelWords[c];
+            for (int j = 0; j < w; j++)
+                EXR_Wav2Decode(channel + j, width, w, lines, width * w, maxValue);
+            channel += (size_t)width * lines * w;
+        }
+        for (CKDWORD i = 0; i < count; i++)
+            words[i] = lut[words[i]];
+
+        // Back to rows of channels, little-endian
+        CKBYTE *out = dst;
+        for (int y = 0; y < lines; y++)
+        {
+            channel = words;
+            for (int c = 0; c < channelCount; c++)
+            {
+                CKDWORD n = (CKDWORD)width * channelWords[c];
+                const CKWORD *in = channel + (size_t)y * n;
+                for (CKDWORD k = 0; k < n; k++)
+                {
+                    out[0] = (CKBYTE)in[k];
+                    out[1] = (CKBYTE)(in[k] >> 8);
+                    out += 2;
+                }
+                channel += (size_t)n * lines;
+            }
+        }
+    }
+    delete[] lut;
+    delete[] words;
+    return ok;
+}
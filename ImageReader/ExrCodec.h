@@ -0,0 +1,41 @@
+#ifndef EXRCODEC_H
+#define EXRCODEC_H
+
+#include "ImageReader.h"
+
+//=============================================================================
+// OpenEXR chunk decompression (RLE, ZIP/ZIPS and PIZ)
+//
+// RLE and ZIP store the chunk bytes split into two halves (even then odd
+// bytes) and delta-coded; the decompressors undo both. PIZ remaps the 16-bit
+// words of a chunk through a bitmap of the values in use, applies a 2D Haar
+// wavelet to each channel and Huffman-codes the result. The code follows the
+// OpenEXR reference implementation (ImfRle, ImfZip, ImfPizCompressor,
+// ImfWav, ImfHuf) so that any valid chunk decodes to the same bytes.
+//=============================================================================
+
+#define EXR_PIZ_BITMAP_SIZE 8192 // one bit per 16-bit value
+#define EXR_HUF_ENCSIZE 65537    // 65536 values plus the run-length symbol
+#define EXR_HUF_MAX_LENGTH 58
+
+// Decompresses an RLE chunk of dstSize bytes; scratch holds dstSize bytes.
+// Returns FALSE unless src decodes to exactly dstSize bytes.
+CKBOOL EXR_RleDecompress(const CKBYTE *src, CKDWORD srcSize, CKBYTE *dst, CKDWORD dstSize, CKBYTE *scratch);
+
+// Same for a ZIP or ZIPS chunk (zlib stream)
+CKBOOL EXR_ZipDecompress(const CKBYTE *src, CKDWORD srcSize, CKBYTE *dst, CKDWORD dstSize, CKBYTE *scratch);
+
+// Decompresses a PIZ chunk of lines rows of width pixels. channelWords holds
+// the size of each channel's samples in 16-bit words (1 for half, 2 for
+// float and uint); dst receives, row by row, each channel's samples in turn.
+CKBOOL EXR_PizDecompress(const CKBYTE *src, CKDWORD srcSize, CKBYTE *dst, int width, int lines,
+                         const int *channelWords, int channelCount);
+
+// Decodes the Huffman stream of a PIZ chunk into exactly count words
+CKBOOL EXR_HufDecode(const CKBYTE *src, CKDWORD srcSize, CKWORD *dst, CKDWORD count);
+
+// Inverse 2D wavelet of an nx x ny array of words spaced ox apart in a row
+// and oy apart between rows; maxValue selects the 14 or 16-bit transform
+void EXR_Wav2Decode(CKWORD *data, int nx, int ox, int ny, int oy, CKWORD maxValue);
+
+#endif // EXRCODEC_H
@@ -0,0 +1,539 @@
+#include "ExrReader.h"
+#include "ExrCodec.h"
+#include "ImageSimd.h"
+#include "ImageThreadPool.h"
+#include "ImageFileMap.h"
+
+//=============================================================================
+// Byte Helpers
+//=============================================================================
+static CKDWORD Read32(const CKBYTE *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((CKDWORD)p[3] << 24); }
+
+static int ReadInt(const CKBYTE *p) { return (int)Read32(p); }
+
+static uint64_t Read64(const CKBYTE *p) { return Read32(p) | ((uint64_t)Read32(p + 4) << 32); }
+
+// Reads a NUL-terminated string of at most maxLength characters at pos.
+// Returns 0, READERROR if the data ends first or FILECORRUPTED if too long.
+static int ReadString(const CKBYTE *data, CKDWORD size, CKDWORD &pos, CKDWORD maxLength, const char *&str)
+{
+    const CKBYTE *end = (const CKBYTE *)memchr(data + pos, 0, size - pos);
+    if (!end)
+        return CKBITMAPERROR_READERROR;
+    CKDWORD length = (CKDWORD)(end - (data + pos));
+    if (length == 0 || length > maxLength)
+        return CKBITMAPERROR_FILECORRUPTED;
+    str = (const char *)(data + pos);
+    pos += length + 1;
+    return 0;
+}
+
+//=============================================================================
+// Header
+//=============================================================================
+static int ReadBox(const CKBYTE *value, CKDWORD valueSize, int &minX, int &minY, CKDWORD &width, CKDWORD &height)
+{
+    if (valueSize != 16)
+        return CKBITMAPERROR_FILECORRUPTED;
+    minX = ReadInt(value);
+    minY = ReadInt(value + 4);
+    int64_t w = (int64_t)ReadInt(value + 8) - minX + 1;
+    int64_t h = (int64_t)ReadInt(value + 12) - minY + 1;
+    if (w <= 0 || h <= 0 || w > 0x7FFFFFFF || h > 0x7FFFFFFF)
+        return CKBITMAPERROR_FILECORRUPTED;
+    width = (CKDWORD)w;
+    height = (CKDWORD)h;
+    return 0;
+}
+
+static int ReadChannels(const CKBYTE *value, CKDWORD valueSize, ExrImageInfo &info)
+{
+    // Name, pixel type, linear flag, 3 reserved bytes and x/y sampling; the
+    // list ends with an empty name
+    CKDWORD pos = 0;
+    while (pos < valueSize && value[pos] != 0)
+    {
+        const char *name;
+        int result = ReadString(value, valueSize, pos, 255, name);
+        if (result != 0)
+            return CKBITMAPERROR_FILECORRUPTED;
+        if (valueSize - pos < 16)
+            return CKBITMAPERROR_FILECORRUPTED;
+        CKDWORD pixelType = Read32(value + pos);
+        int xSampling = ReadInt(value + pos + 8);
+        int ySampling = ReadInt(value + pos + 12);
+        pos += 16;
+        if (pixelType > EXR_PIXEL_FLOAT)
+            return CKBITMAPERROR_FILECORRUPTED;
+        if (xSampling != 1 || ySampling != 1)
+            return CKBITMAPERROR_UNSUPPORTEDFILE;
+        if (info.channelCount == EXR_MAX_CHANNELS)
+            return CKBITMAPERROR_UNSUPPORTEDFILE;
+
+        ExrChannel &channel = info.channels[info.channelCount++];
+        channel.pixelType = pixelType;
+        channel.size = (pixelType == EXR_PIXEL_HALF) ? 2 : 4;
+        channel.slot = EXR_SLOT_NONE;
+        // Layer channels ("diffuse.R") are skipped
+        if (name[1] == '\0')
+        {
+            switch (name[0])
+            {
+            case 'R': channel.slot = EXR_SLOT_R; break;
+            case 'G': channel.slot = EXR_SLOT_G; break;
+            case 'B': channel.slot = EXR_SLOT_B; break;
+            case 'A': channel.slot = EXR_SLOT_A; break;
+            case 'Y': channel.slot = EXR_SLOT_Y; break;
+            }
+        }
+        info.pixelSize += channel.size;
+    }
+    if (pos >= valueSize || info.channelCount == 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+    return 0;
+}
+
+int EXR_ReadInfo(const CKBYTE *data, CKDWORD size, ExrImageInfo &info)
+{
+    memset(&info, 0, sizeof(info));
+    if (!data || size < 8)
+        return CKBITMAPERROR_READERROR;
+    if (Read32(data) != EXR_MAGIC)
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    CKDWORD version = Read32(data + 4);
+    if ((version & 0xFF) != EXR_VERSION || (version & (EXR_FLAG_DEEP | EXR_FLAG_MULTIPART)))
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    info.tiled = (version & EXR_FLAG_TILED) != 0;
+    CKDWORD maxName = (version & EXR_FLAG_LONG_NAMES) ? 255 : 31;
+
+    // Attributes: name, type, size and value, up to an empty name
+    CKBOOL hasChannels = FALSE, hasCompression = FALSE, hasDataWindow = FALSE, hasDisplayWindow = FALSE;
+    CKBOOL hasTiles = FALSE;
+    CKDWORD pos = 8;
+    for (;;)
+    {
+        if (pos >= size)
+            return CKBITMAPERROR_READERROR;
+        if (data[pos] == 0)
+        {
+            pos++;
+            break;
+        }
+        const char *name;
+        const char *type;
+        int result = ReadString(data, size, pos, maxName, name);
+        if (result == 0)
+            result = ReadString(data, size, pos, maxName, type);
+        if (result != 0)
+            return result;
+        if (size - pos < 4)
+            return CKBITMAPERROR_READERROR;
+        CKDWORD valueSize = Read32(data + pos);
+        pos += 4;
+        if (valueSize > size - pos)
+            return CKBITMAPERROR_READERROR;
+        const CKBYTE *value = data + pos;
+        pos += valueSize;
+
+        if (strcmp(name, "channels") == 0 && strcmp(type, "chlist") == 0)
+        {
+            if (hasChannels)
+                return CKBITMAPERROR_FILECORRUPTED;
+            result = ReadChannels(value, valueSize, info);
+            hasChannels = TRUE;
+        }
+        else if (strcmp(name, "compression") == 0 && strcmp(type, "compression") == 0)
+        {
+            if (valueSize != 1)
+                return CKBITMAPERROR_FILECORRUPTED;
+            info.compression = value[0];
+            if (info.compression > EXR_COMPRESSION_PIZ)
+                return CKBITMAPERROR_UNSUPPORTEDFILE;
+            hasCompression = TRUE;
+        }
+        else if (strcmp(name, "dataWindow") == 0 && strcmp(type, "box2i") == 0)
+        {
+            result = ReadBox(value, valueSize, info.minX, info.minY, info.width, info.height);
+            hasDataWindow = TRUE;
+        }
+        else if (strcmp(name, "displayWindow") == 0 && strcmp(type, "box2i") == 0)
+        {
+            result = ReadBox(value, valueSize, info.displayMinX, info.displayMinY, info.displayWidth,
+                             info.displayHeight);
+            hasDisplayWindow = TRUE;
+        }
+        else if (strcmp(name, "tiles") == 0 && strcmp(type, "tiledesc") == 0)
+        {
+            // Tile size and level mode (one level, mipmaps or ripmaps); only
+            // the first level is read, and its tiles come first
+            if (valueSize != 9)
+                return CKBITMAPERROR_FILECORRUPTED;
+            info.chunkWidth = Read32(value);
+            info.chunkHeight = Read32(value + 4);
+            if (info.chunkWidth == 0 || info.chunkHeight == 0 || info.chunkWidth > 0x7FFFFFFF ||
+                info.chunkHeight > 0x7FFFFFFF || (value[8] & 0x0F) > 2)
+                return CKBITMAPERROR_FILECORRUPTED;
+            hasTiles = TRUE;
+        }
+        else if (strcmp(name, "type") == 0 && strcmp(type, "string") == 0)
+        {
+            if (valueSize >= 4 && memcmp(value, "deep", 4) == 0)
+                return CKBITMAPERROR_UNSUPPORTEDFILE;
+        }
+        if (result != 0)
+            return result;
+    }
+    if (!hasChannels || !hasCompression || !hasDataWindow || !hasDisplayWindow || (info.tiled && !hasTiles))
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (!ImageWithinDecodeLimits(info.width, info.height, 0))
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // Luminance is only used when there is no color channel
+    CKBOOL hasColor = FALSE, hasLuminance = FALSE;
+    for (CKDWORD c = 0; c < info.channelCount; c++)
+    {
+        int slot = info.channels[c].slot;
+        hasColor |= (slot == EXR_SLOT_R || slot == EXR_SLOT_G || slot == EXR_SLOT_B);
+        hasLuminance |= (slot == EXR_SLOT_Y);
+        info.hasAlpha |= (slot == EXR_SLOT_A);
+    }
+    if (!hasColor && !hasLuminance)
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    for (CKDWORD c = 0; hasColor && c < info.channelCount; c++)
+    {
+        if (info.channels[c].slot == EXR_SLOT_Y)
+            info.channels[c].slot = EXR_SLOT_NONE;
+    }
+
+    if (!info.tiled)
+    {
+        static const CKDWORD linesPerChunk[] = {1, 1, 1, 16, 32};
+        info.chunkWidth = info.width;
+        info.chunkHeight = linesPerChunk[info.compression];
+    }
+    info.chunksAcross = (CKDWORD)(((uint64_t)info.width + info.chunkWidth - 1) / info.chunkWidth);
+    info.chunksDown = (CKDWORD)(((uint64_t)info.height + info.chunkHeight - 1) / info.chunkHeight);
+
+    // The offset table must fit in the file before anything is allocated
+    info.offsetTable = pos;
+    if ((uint64_t)info.chunksAcross * info.chunksDown * 8 > size - pos)
+        return CKBITMAPERROR_FILECORRUPTED;
+    return 0;
+}
+
+//=============================================================================
+// Parallel Decoding
+//=============================================================================
+struct ExrDecodeJob
+{
+    const ExrImageInfo *info;
+    const CKBYTE *data;
+    CKDWORD size;
+    CKBOOL floatOutput;
+    CKBYTE *dst;
+    int dstStride;
+    int *errors;
+};
+
+// Buffers reused across the chunks of one range
+struct ExrScratch
+{
+    CKBYTE *raw;
+    CKBYTE *codec;
+    CKDWORD capacity;
+    float *row;     // RGBA pixels of one chunk row
+    float *samples; // one channel of one chunk row
+    CKWORD *halves;
+
+    void Reserve(CKDWORD bytes)
+    {
+        if (bytes <= capacity)
+            return;
+        delete[] raw;
+        delete[] codec;
+        raw = new CKBYTE[bytes];
+        codec = new CKBYTE[bytes];
+        capacity = bytes;
+    }
+};
+
+// Converts one row of a chunk (each channel's samples in turn) into the
+// output, RGBA float or BGRA32
+static void ConvertChunkRow(const ExrDecodeJob &job, const CKBYTE *src, CKDWORD width, CKBYTE *dst, ExrScratch &scratch)
+{
+    const ExrImageInfo &info = *job.info;
+    // Output position of each slot (R, G, B, A)
+    static const int rgbaOrder[4] = {0, 1, 2, 3};
+    static const int bgraOrder[4] = {2, 1, 0, 3};
+    const int *order = job.floatOutput ? rgbaOrder : bgraOrder;
+
+    float *row = scratch.row;
+    for (CKDWORD x = 0; x < width; x++)
+    {
+        row[x * 4] = 0.0f;
+        row[x * 4 + 1] = 0.0f;
+        row[x * 4 + 2] = 0.0f;
+        row[x * 4 + 3] = 1.0f;
+    }
+
+    for (CKDWORD c = 0; c < info.channelCount; c++)
+    {
+        const ExrChannel &channel = info.channels[c];
+        const CKBYTE *samples = src;
+        src += (size_t)width * channel.size;
+        if (channel.slot == EXR_SLOT_NONE)
+            continue;
+
+        // Chunk data has no alignment guarantee
+        float *values = scratch.samples;
+        if (channel.pixelType == EXR_PIXEL_HALF)
+        {
+            memcpy(scratch.halves, samples, (size_t)width * 2);
+            ImageHalfToFloat(scratch.halves, values, (int)width);
+        }
+        else if (channel.pixelType == EXR_PIXEL_FLOAT)
+        {
+            memcpy(values, samples, (size_t)width * 4);
+        }
+        else
+        {
+            for (CKDWORD x = 0; x < width; x++)
+                values[x] = (float)Read32(samples + x * 4);
+        }
+
+        if (channel.slot == EXR_SLOT_Y)
+        {
+            for (CKDWORD x = 0; x < width; x++)
+                row[x * 4] = row[x * 4 + 1] = row[x * 4 + 2] = values[x];
+        }
+        else
+        {
+            float *out = row + order[channel.slot];
+            for (CKDWORD x = 0; x < width; x++)
+                out[x * 4] = values[x];
+        }
+    }
+
+    if (job.floatOutput)
+        memcpy(dst, row, (size_t)width * 16);
+    else
+        ImageFloatTo8(row, dst, (int)width * 4);
+}
+
+static int DecodeChunk(const ExrDecodeJob &job, CKDWORD index, ExrScratch &scratch)
+{
+    const ExrImageInfo &info = *job.info;
+    CKDWORD across = index % info.chunksAcross;
+    CKDWORD down = index / info.chunksAcross;
+    CKDWORD x0 = across * info.chunkWidth;
+    CKDWORD y0 = down * info.chunkHeight;
+    CKDWORD width = (info.width - x0 < info.chunkWidth) ? info.width - x0 : info.chunkWidth;
+    CKDWORD lines = (info.height - y0 < info.chunkHeight) ? info.height - y0 : info.chunkHeight;
+
+    // Chunk header: y of the first line, or tile coordinates and level
+    uint64_t offset = Read64(job.data + info.offsetTable + (size_t)index * 8);
+    CKDWORD headerSize = info.tiled ? 20 : 8;
+    if (offset < info.offsetTable || offset > job.size || job.size - offset < headerSize)
+        return CKBITMAPERROR_FILECORRUPTED;
+    const CKBYTE *chunk = job.data + offset;
+    if (info.tiled)
+    {
+        if (Read32(chunk) != across || Read32(chunk + 4) != down || Read32(chunk + 8) != 0 || Read32(chunk + 12) != 0)
+            return CKBITMAPERROR_FILECORRUPTED;
+    }
+    else if ((int64_t)ReadInt(chunk) != (int64_t)info.minY + y0)
+    {
+        return CKBITMAPERROR_FILECORRUPTED;
+    }
+    CKDWORD dataSize = Read32(chunk + headerSize - 4);
+    if (dataSize > job.size - offset - headerSize)
+        return CKBITMAPERROR_FILECORRUPTED;
+    const CKBYTE *src = chunk + headerSize;
+
+    uint64_t rawSize64 = (uint64_t)width * lines * info.pixelSize;
+    if (rawSize64 > 0x7FFFFFFFULL)
+        return CKBITMAPERROR_FILECORRUPTED;
+    CKDWORD rawSize = (CKDWORD)rawSize64;
+
+    // Chunks that would not shrink are stored uncompressed
+    const CKBYTE *raw = src;
+    if (dataSize != rawSize)
+    {
+        if (info.compression == EXR_COMPRESSION_NONE)
+            return CKBITMAPERROR_FILECORRUPTED;
+        scratch.Reserve(rawSize);
+        CKBOOL ok = FALSE;
+        if (info.compression == EXR_COMPRESSION_RLE)
+        {
+            ok = EXR_RleDecompress(src, dataSize, scratch.raw, rawSize, scratch.codec);
+        }
+        else if (info.compression == EXR_COMPRESSION_PIZ)
+        {
+            int words[EXR_MAX_CHANNELS];
+            for (CKDWORD c = 0; c < info.channelCount; c++)
+                words[c] = (int)info.channels[c].size / 2;
+            ok = EXR_PizDecompress(src, dataSize, scratch.raw, (int)width, (int)lines, words, (int)info.channelCount);
+        }
+        else
+        {
+            ok = EXR_ZipDecompress(src, dataSize, scratch.raw, rawSize, scratch.codec);
+        }
+        if (!ok)
+            return CKBITMAPERROR_FILECORRUPTED;
+        raw = scratch.raw;
+    }
+
+    CKDWORD bytesPerPixel = job.floatOutput ? 16 : 4;
+    CKDWORD rowSize = width * info.pixelSize;
+    for (CKDWORD y = 0; y < lines; y++)
+    {
+        CKBYTE *dst = job.dst + (size_t)(y0 + y) * job.dstStride + (size_t)x0 * bytesPerPixel;
+        ConvertChunkRow(job, raw + (size_t)y * rowSize, width, dst, scratch);
+    }
+    return 0;
+}
+
+static void DecodeChunks(void *context, CKDWORD begin, CKDWORD end)
+{
+    const ExrDecodeJob &job = *(const ExrDecodeJob *)context;
+    const ExrImageInfo &info = *job.info;
+    CKDWORD rowWidth = info.chunkWidth < info.width ? info.chunkWidth : info.width;
+
+    ExrScratch scratch;
+    scratch.raw = NULL;
+    scratch.codec = NULL;
+    scratch.capacity = 0;
+    scratch.row = new float[(size_t)rowWidth * 4];
+    scratch.samples = new float[rowWidth];
+    scratch.halves = new CKWORD[rowWidth];
+    for (CKDWORD i = begin; i < end; i++)
+        job.errors[i] = DecodeChunk(job, i, scratch);
+    delete[] scratch.halves;
+    delete[] scratch.samples;
+    delete[] scratch.row;
+    delete[] scratch.codec;
+    delete[] scratch.raw;
+}
+
+//=============================================================================
+// ExrReader Class Implementation
+//=============================================================================
+ExrReader::ExrReader() : ImageReader(), m_ReadFlags(0)
+{
+    m_Properties.Init(EXRREADER_GUID, "exr");
+}
+
+ExrReader::~ExrReader()
+{
+    FreeBitmapData(&m_Properties);
+}
+
+CKPluginInfo *ExrReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_EXR];
+}
+
+void ExrReader::SetReadFlags(CKDWORD flags) { m_ReadFlags = flags; }
+
+CKDWORD ExrReader::GetReadFlags() { return m_ReadFlags; }
+
+int ExrReader::GetOptionsCount() { return 0; }
+
+CKSTRING ExrReader::GetOptionDescription(int i) { return ""; }
+
+int ExrReader::ReadFile(CKSTRING filename, CKBitmapProperties **bp)
+{
+    if (!filename || !bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_EXR, (void *)filename, 0, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int ExrReader::ReadMemory(void *memory, int size, CKBitmapProperties **bp)
+{
+    if (!bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_EXR, memory, size, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int ExrReader::ReadOwnFormat(void *data, int size, CKBitmapProperties *props)
+{
+    return EXR_Read(data, size, props, m_ReadFlags);
+}
+
+//=============================================================================
+// EXR_Read - Core Reading Function
+//=============================================================================
+int EXR_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags)
+{
+    if (!data || !props)
+        return CKBITMAPERROR_GENERIC;
+    if (size < 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // Files are mapped so chunks are decompressed straight from the mapping
+    ImageFileMap fileMap;
+    if (size == 0)
+    {
+        if (!fileMap.Open((const char *)data))
+            return CKBITMAPERROR_READERROR;
+        data = (void *)fileMap.Data();
+        size = (int)fileMap.Size();
+    }
+
+    const CKBYTE *bytes = (const CKBYTE *)data;
+    CKDWORD fileSize = (CKDWORD)size;
+    ExrImageInfo info;
+    int result = EXR_ReadInfo(bytes, fileSize, info);
+    if (result != 0)
+        return result;
+
+    CKBOOL floatOutput = (readFlags & IMAGE_READ_FLOAT) != 0;
+    uint64_t dstStride64 = (uint64_t)info.width * (floatOutput ? 16 : 4);
+    if (!ImageWithinDecodeLimits(info.width, info.height, dstStride64 * info.height))
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // Each chunk decompresses and converts its own rows or tile
+    CKDWORD chunkCount = info.chunksAcross * info.chunksDown;
+    int dstStride = (int)dstStride64;
+    CKBYTE *dstBlock = new CKBYTE[(size_t)dstStride64 * info.height];
+    int *errors = new int[chunkCount];
+    ExrDecodeJob job;
+    job.info = &info;
+    job.data = bytes;
+    job.size = fileSize;
+    job.floatOutput = floatOutput;
+    job.dst = dstBlock;
+    job.dstStride = dstStride;
+    job.errors = errors;
+    ImageParallelFor(chunkCount, 1, DecodeChunks, &job);
+
+    for (CKDWORD i = 0; i < chunkCount && result == 0; i++)
+        result = errors[i];
+    delete[] errors;
+    if (result != 0)
+    {
+        delete[] dstBlock;
+        return result;
+    }
+
+    // Fill properties
+    if (floatOutput)
+        ImageReader::FillFormatRGBA128F(props->m_Format, (int)info.width, (int)info.height, dstStride, dstBlock);
+    else
+        ImageReader::FillFormatBGRA32(props->m_Format, (int)info.width, (int)info.height, dstStride, dstBlock);
+    props->m_Data = dstBlock;
+
+    if (props->m_Size == sizeof(ExrBitmapProperties))
+    {
+        ExrBitmapProperties *exrProps = (ExrBitmapProperties *)props;
+        exrProps->m_DisplayWidth = info.displayWidth;
+        exrProps->m_DisplayHeight = info.displayHeight;
+        exrProps->m_DataX = (int)((int64_t)info.minX - info.displayMinX);
+        exrProps->m_DataY = (int)((int64_t)info.minY - info.displayMinY);
+    }
+    return 0;
+}
@@ -0,0 +1,126 @@
+#ifndef EXRREADER_H
+#define EXRREADER_H
+
+#include "ImageReader.h"
+
+// EXR Reader GUID
+#define EXRREADER_GUID CKGUID(0x5C19E7A3, 0x0B84D26F)
+
+/**
+ * ExrReader - OpenEXR reader
+ *
+ *   - Single-part scanline and tiled images (the first level of mipmapped or
+ *     ripmapped files), uncompressed or with RLE, ZIPS, ZIP or PIZ chunks
+ *   - Half, float and uint R/G/B/A channels, or luminance (Y) only; other
+ *     channels are skipped
+ *   - The file is mapped, the offset table gives every chunk, and chunks are
+ *     decompressed and converted on the worker pool (ImageParallelFor); half
+ *     floats are converted with F16C when available
+ *   - Only the data window is decoded; ExrBitmapProperties tells where it lies
+ *     in the display window
+ *   - Decoded to BGRA32 by clamping to 0..1 (values are linear); with
+ *     IMAGE_READ_FLOAT, to RGBA float
+ *   - Multi-part, deep and subsampled (chroma) images and the PXR24, B44 and
+ *     DWA compressions are not supported
+ *   - Read-only: SaveFile and SaveMemory return 0
+ */
+class ExrReader : public ImageReader
+{
+public:
+    ExrReader();
+    virtual ~ExrReader();
+
+    virtual CKPluginInfo *GetReaderInfo();
+    virtual int GetOptionsCount();
+    virtual CKSTRING GetOptionDescription(int i);
+
+    virtual int ReadFile(CKSTRING filename, CKBitmapProperties **bp);
+    virtual int ReadMemory(void *memory, int size, CKBitmapProperties **bp);
+
+    // IMAGE_READ_* flags applied by ReadFile/ReadMemory (default 0)
+    void SetReadFlags(CKDWORD flags);
+    CKDWORD GetReadFlags();
+
+protected:
+    virtual int ReadOwnFormat(void *data, int size, CKBitmapProperties *props);
+
+private:
+    ExrBitmapProperties m_Properties;
+    CKDWORD m_ReadFlags;
+};
+
+//=============================================================================
+// OpenEXR file format
+//=============================================================================
+#define EXR_MAGIC 20000630
+#define EXR_VERSION 2
+#define EXR_FLAG_TILED 0x00000200
+#define EXR_FLAG_LONG_NAMES 0x00000400
+#define EXR_FLAG_DEEP 0x00000800
+#define EXR_FLAG_MULTIPART 0x00001000
+
+// Compressions
+#define EXR_COMPRESSION_NONE 0
+#define EXR_COMPRESSION_RLE 1
+#define EXR_COMPRESSION_ZIPS 2 // one scanline per chunk
+#define EXR_COMPRESSION_ZIP 3  // 16 scanlines per chunk
+#define EXR_COMPRESSION_PIZ 4  // 32 scanlines per chunk
+
+// Channel pixel types
+#define EXR_PIXEL_UINT 0
+#define EXR_PIXEL_HALF 1
+#define EXR_PIXEL_FLOAT 2
+
+// Where a channel goes in an RGBA pixel
+#define EXR_SLOT_NONE -1
+#define EXR_SLOT_R 0
+#define EXR_SLOT_G 1
+#define EXR_SLOT_B 2
+#define EXR_SLOT_A 3
+#define EXR_SLOT_Y 4 // luminance, copied to R, G and B
+
+#define EXR_MAX_CHANNELS 64
+
+struct ExrChannel
+{
+    CKDWORD pixelType; // EXR_PIXEL_*
+    CKDWORD size;      // bytes per sample
+    int slot;          // EXR_SLOT_*
+};
+
+// Header of a single-part image. Chunks are scanline blocks of linesPerChunk
+// rows, or tiles of the first level, numbered in rows.
+struct ExrImageInfo
+{
+    int minX; // data window
+    int minY;
+    CKDWORD width;
+    CKDWORD height;
+    int displayMinX; // display window
+    int displayMinY;
+    CKDWORD displayWidth;
+    CKDWORD displayHeight;
+    CKDWORD compression;
+    CKBOOL tiled;
+    CKDWORD chunkWidth;    // data window width for scanline images
+    CKDWORD chunkHeight;   // lines per chunk, or tile height
+    CKDWORD chunksAcross;
+    CKDWORD chunksDown;
+    CKDWORD channelCount;
+    ExrChannel channels[EXR_MAX_CHANNELS]; // in file order (sorted by name)
+    CKDWORD pixelSize;     // bytes of one pixel, all channels
+    CKBOOL hasAlpha;
+    CKDWORD offsetTable;   // file position of the chunk offsets
+};
+
+//=============================================================================
+// Internal helper functions
+//=============================================================================
+
+// Parses the header; fails on anything the decoder does not support
+int EXR_ReadInfo(const CKBYTE *data, CKDWORD size, ExrImageInfo &info);
+
+// Core EXR read function (size == 0 means data is a filename)
+int EXR_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags = 0);
+
+#endif // EXRREADER_H
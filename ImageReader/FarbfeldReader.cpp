@@ -0,0 +1,168 @@
+#include "FarbfeldReader.h"
+#include "ImageSimd.h"
+#include "ImageThreadPool.h"
+#include "ImageFileMap.h"
+
+static CKDWORD ReadBE32(const CKBYTE *p)
+{
+    return ((CKDWORD)p[0] << 24) | ((CKDWORD)p[1] << 16) | ((CKDWORD)p[2] << 8) | (CKDWORD)p[3];
+}
+
+//=============================================================================
+// Row Conversion
+//=============================================================================
+struct FarbfeldConvertJob
+{
+    const CKBYTE *pixels;
+    CKDWORD width;
+    CKBOOL wide;
+    CKBYTE *dst;
+    int dstStride;
+    CKBYTE *translucent; // per row: some alpha below the maximum
+};
+
+static CKBOOL IsOpaqueRow64(const CKWORD *row, CKDWORD width)
+{
+    CKWORD alpha = 0xFFFF;
+    for (CKDWORD x = 0; x < width; x++)
+        alpha &= row[x * 4 + 3];
+    return alpha == 0xFFFF;
+}
+
+static void ConvertRows(void *context, CKDWORD begin, CKDWORD end)
+{
+    const FarbfeldConvertJob &job = *(const FarbfeldConvertJob *)context;
+    for (CKDWORD y = begin; y < end; y++)
+    {
+        const CKBYTE *src = job.pixels + (size_t)y * job.width * FARBFELD_PIXEL_SIZE;
+        CKBYTE *dst = job.dst + (size_t)y * job.dstStride;
+        if (job.wide)
+        {
+            ImageRGBA16ToBGRA64(src, (CKWORD *)dst, (int)job.width);
+            job.translucent[y] = !IsOpaqueRow64((const CKWORD *)dst, job.width);
+        }
+        else
+        {
+            ImageRGBA16ToBGRA32(src, dst, (int)job.width);
+            job.translucent[y] = !ImageIsOpaqueBGRA32(dst, (int)job.width, 1, job.dstStride);
+        }
+    }
+}
+
+//=============================================================================
+// FarbfeldReader Class Implementation
+//=============================================================================
+FarbfeldReader::FarbfeldReader() : ImageReader(), m_ReadFlags(0)
+{
+    m_Properties.Init(FARBFELDREADER_GUID, "ff");
+}
+
+FarbfeldReader::~FarbfeldReader()
+{
+    FreeBitmapData(&m_Properties);
+}
+
+CKPluginInfo *FarbfeldReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_FARBFELD];
+}
+
+void FarbfeldReader::SetReadFlags(CKDWORD flags) { m_ReadFlags = flags; }
+
+CKDWORD FarbfeldReader::GetReadFlags() { return m_ReadFlags; }
+
+int FarbfeldReader::GetOptionsCount() { return 0; }
+
+CKSTRING FarbfeldReader::GetOptionDescription(int i) { return ""; }
+
+int FarbfeldReader::ReadFile(CKSTRING filename, CKBitmapProperties **bp)
+{
+    if (!filename || !bp)
+        return 1;
+    int result =
+        ReadSniffed(READER_INDEX_FARBFELD, (void *)filename, 0, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int FarbfeldReader::ReadMemory(void *memory, int size, CKBitmapProperties **bp)
+{
+    if (!bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_FARBFELD, memory, size, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int FarbfeldReader::ReadOwnFormat(void *data, int size, CKBitmapProperties *props)
+{
+    return FARBFELD_Read(data, size, props, m_ReadFlags);
+}
+
+//=============================================================================
+// FARBFELD_Read - Core Reading Function
+//=============================================================================
+int FARBFELD_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags)
+{
+    if (!data || !props)
+        return CKBITMAPERROR_GENERIC;
+    if (size < 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // Files are mapped and converted straight from the mapping
+    ImageFileMap fileMap;
+    if (size == 0)
+    {
+        if (!fileMap.Open((const char *)data))
+            return CKBITMAPERROR_READERROR;
+        data = (void *)fileMap.Data();
+        size = (int)fileMap.Size();
+    }
+
+    const CKBYTE *bytes = (const CKBYTE *)data;
+    if (size < FARBFELD_HEADER_SIZE)
+        return CKBITMAPERROR_READERROR;
+    if (memcmp(bytes, FARBFELD_MAGIC, 8) != 0)
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+
+    CKDWORD width = ReadBE32(bytes + 8);
+    CKDWORD height = ReadBE32(bytes + 12);
+    if (width == 0 || height == 0 || !ImageWithinDecodeLimits(width, height, 0))
+        return CKBITMAPERROR_FILECORRUPTED;
+    // The payload size is fixed: a short file fails before any allocation
+    if ((uint64_t)width * height * FARBFELD_PIXEL_SIZE > (CKDWORD)size - FARBFELD_HEADER_SIZE)
+        return CKBITMAPERROR_READERROR;
+
+    CKBOOL wide = (readFlags & IMAGE_READ_KEEP_16BIT) != 0;
+    uint64_t dstStride64 = (uint64_t)width * (wide ? 8 : 4);
+    if (!ImageWithinDecodeLimits(width, height, dstStride64 * height))
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    int dstStride = (int)dstStride64;
+    CKBYTE *dstPixels = new CKBYTE[(size_t)dstStride64 * height];
+    CKBYTE *translucent = new CKBYTE[height];
+    FarbfeldConvertJob job;
+    job.pixels = bytes + FARBFELD_HEADER_SIZE;
+    job.width = width;
+    job.wide = wide;
+    job.dst = dstPixels;
+    job.dstStride = dstStride;
+    job.translucent = translucent;
+    ImageParallelFor(height, 16, ConvertRows, &job);
+
+    CKBOOL hasAlpha = FALSE;
+    for (CKDWORD y = 0; y < height && !hasAlpha; y++)
+        hasAlpha = translucent[y];
+    delete[] translucent;
+
+    // Fill properties
+    if (wide)
+        ImageReader::FillFormatBGRA64(props->m_Format, (int)width, (int)height, dstStride, dstPixels);
+    else
+        ImageReader::FillFormatBGRA32(props->m_Format, (int)width, (int)height, dstStride, dstPixels);
+    props->m_Data = dstPixels;
+
+    if (props->m_Size == sizeof(FarbfeldBitmapProperties))
+        ((FarbfeldBitmapProperties *)props)->m_HasAlpha = hasAlpha;
+    return 0;
+}
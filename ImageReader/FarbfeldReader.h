@@ -0,0 +1,58 @@
+#ifndef FARBFELDREADER_H
+#define FARBFELDREADER_H
+
+#include "ImageReader.h"
+
+// Farbfeld Reader GUID
+#define FARBFELDREADER_GUID CKGUID(0xCE4CA8D1, 0x0BCB8D12)
+
+/**
+ * FarbfeldReader - farbfeld reader
+ *
+ *   - A 16-byte header and 16-bit big-endian RGBA, converted row by row on
+ *     the worker pool (ImageParallelFor) with SSE2/AVX2 swap and pack kernels
+ *   - Decoded to BGRA32 by keeping the high bytes, or with
+ *     IMAGE_READ_KEEP_16BIT to BGRA64
+ *   - Files are mapped, so a read is a single pass over the payload
+ *   - Read-only: SaveFile and SaveMemory return 0
+ */
+class FarbfeldReader : public ImageReader
+{
+public:
+    FarbfeldReader();
+    virtual ~FarbfeldReader();
+
+    virtual CKPluginInfo *GetReaderInfo();
+    virtual int GetOptionsCount();
+    virtual CKSTRING GetOptionDescription(int i);
+
+    virtual int ReadFile(CKSTRING filename, CKBitmapProperties **bp);
+    virtual int ReadMemory(void *memory, int size, CKBitmapProperties **bp);
+
+    // IMAGE_READ_* flags applied by ReadFile/ReadMemory (default 0)
+    void SetReadFlags(CKDWORD flags);
+    CKDWORD GetReadFlags();
+
+protected:
+    virtual int ReadOwnFormat(void *data, int size, CKBitmapProperties *props);
+
+private:
+    FarbfeldBitmapProperties m_Properties;
+    CKDWORD m_ReadFlags;
+};
+
+//=============================================================================
+// Farbfeld file format
+//=============================================================================
+#define FARBFELD_MAGIC "farbfeld"
+#define FARBFELD_HEADER_SIZE 16
+#define FARBFELD_PIXEL_SIZE 8
+
+//=============================================================================
+// Internal helper functions
+//=============================================================================
+
+// Core farbfeld read function (size == 0 means data is a filename)
+int FARBFELD_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags = 0);
+
+#endif // FARBFELDREADER_H
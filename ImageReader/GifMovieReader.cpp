@@ -0,0 +1,122 @@
+#include "GifMovieReader.h"
+
+//=============================================================================
+// Compositing
+//
+// Disposal works on the part of a frame's region that lies inside the screen.
+//=============================================================================
+static void FrameRegion(void *context, CKDWORD f, ImageMovieRegion &region)
+{
+    const GifFrame &frame = ((const GifAnimation *)context)->frames[f];
+    region.x = frame.x;
+    region.y = frame.y;
+    region.width = frame.drawWidth;
+    region.height = frame.drawHeight;
+    if (frame.disposal == GIF_DISPOSE_BACKGROUND)
+        region.dispose = IMAGE_MOVIE_DISPOSE_BACKGROUND;
+    else if (frame.disposal == GIF_DISPOSE_PREVIOUS)
+        region.dispose = IMAGE_MOVIE_DISPOSE_PREVIOUS;
+    else
+        region.dispose = IMAGE_MOVIE_DISPOSE_NONE;
+}
+
+static CKBOOL IsOpaqueFrame(void *context, CKDWORD f)
+{
+    return ((const GifAnimation *)context)->frames[f].transparent < 0;
+}
+
+static int DecodeFrame(void *context, CKDWORD f, CKBYTE *indices, CKDWORD &decoded)
+{
+    return GIF_DecodeFrame(*(const GifAnimation *)context, f, indices, decoded);
+}
+
+static void DrawFrame(void *context, CKDWORD f, const CKBYTE *indices, CKDWORD decoded, CKBYTE *canvas,
+                      CKDWORD canvasStride)
+{
+    const GifAnimation &anim = *(const GifAnimation *)context;
+    GIF_DrawFrame(anim, anim.frames[f], indices, decoded, canvas, canvasStride);
+}
+
+static const ImageMovieFormat GifMovieFormat = {FrameRegion, IsOpaqueFrame, DecodeFrame, DrawFrame};
+
+//=============================================================================
+// GifMovieReader Class Implementation
+//=============================================================================
+GifMovieReader::GifMovieReader()
+{
+    memset(&m_Animation, 0, sizeof(m_Animation));
+    m_Properties.m_Ext = "gif";
+    m_Properties.m_ReaderGuid = GIFMOVIEREADER_GUID;
+    m_Properties.m_Data = NULL;
+}
+
+GifMovieReader::~GifMovieReader()
+{
+    Close();
+}
+
+CKPluginInfo *GifMovieReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_GIF_MOVIE];
+}
+
+void GifMovieReader::Close()
+{
+    // The prefetch task reads the file
+    m_Compositor.Close();
+
+    GIF_FreeIndex(m_Animation);
+    m_File.Close();
+    m_Properties.m_Data = NULL;
+    m_Properties.m_NumPlays = 0;
+    m_Properties.m_FrameDelay = 0;
+}
+
+int GifMovieReader::GetMovieFrameCount()
+{
+    return (int)m_Animation.frameCount;
+}
+
+int GifMovieReader::GetMovieLength()
+{
+    return (int)m_Animation.length;
+}
+
+CKERROR GifMovieReader::OpenFile(char *name)
+{
+    Close();
+    if (!name || !m_File.Open(name))
+        return CKMOVIEERROR_READERROR;
+
+    int result = GIF_Index(m_File.Data(), m_File.Size(), m_Animation);
+    if (result != 0)
+    {
+        m_File.Close();
+        return (result == CKBITMAPERROR_UNSUPPORTEDFILE || result == CKBITMAPERROR_READERROR)
+                   ? CKMOVIEERROR_UNSUPPORTEDFILE
+                   : CKMOVIEERROR_FILECORRUPTED;
+    }
+
+    // Both sizes are bounded by the decode limits
+    m_Compositor.Open(GifMovieFormat, &m_Animation, m_Animation.width, m_Animation.height, m_Animation.frameCount,
+                      m_Animation.maxFramePixels);
+
+    ImageReader::FillFormatBGRA32(m_Properties.m_Format, (int)m_Animation.width, (int)m_Animation.height,
+                                  (int)m_Animation.width * 4, m_Compositor.Canvas());
+    m_Properties.m_NumPlays = m_Animation.numPlays;
+    return CK_OK;
+}
+
+CKERROR GifMovieReader::ReadFrame(int f, CKMovieProperties **mp)
+{
+    if (!mp || !m_Compositor.Canvas() || (CKDWORD)f >= m_Animation.frameCount)
+        return CKMOVIEERROR_GENERIC;
+
+    if (m_Compositor.Render((CKDWORD)f) != 0)
+        return CKMOVIEERROR_FILECORRUPTED;
+
+    m_Properties.m_Data = m_Compositor.Canvas();
+    m_Properties.m_FrameDelay = m_Animation.frames[f].delay;
+    *mp = (CKMovieProperties *)&m_Properties;
+    return CK_OK;
+}
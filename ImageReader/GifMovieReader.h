@@ -0,0 +1,76 @@
+#ifndef GIFMOVIEREADER_H
+#define GIFMOVIEREADER_H
+
+#include "CKMovieReader.h"
+
+#include "GifReader.h"
+#include "ImageFileMap.h"
+#include "ImageMovieCompositor.h"
+
+// Animated GIF Reader GUID
+#define GIFMOVIEREADER_GUID CKGUID(0x7B42E6A1, 0x58C39D0F)
+
+struct GifMovieProperties : public CKMovieProperties
+{
+    GifMovieProperties()
+    {
+        m_Size = sizeof(GifMovieProperties);
+        m_NumPlays = 0;
+        m_FrameDelay = 0;
+    }
+
+    CKDWORD m_NumPlays;   // times the animation is played (0 = forever)
+    CKDWORD m_FrameDelay; // display time of the last frame read, in ms
+};
+
+/**
+ * GifMovieReader - Animated GIF movie reader
+ *
+ *   - OpenFile maps the file and indexes the frames (region, timing,
+ *     disposal and the offset of the LZW data); nothing is decoded until a
+ *     frame is read
+ *   - Frames are composited into a persistent BGRA32 canvas of the screen
+ *     size: each step decodes only the frame's own region and applies the
+ *     previous frame's disposal to its region
+ *   - Seeking restarts from the nearest frame that fully redraws the canvas;
+ *     reading forward continues from the current canvas
+ *   - After each ReadFrame the LZW data of the next frame is decoded on a
+ *     background thread
+ */
+class GifMovieReader : public CKMovieReader
+{
+public:
+    GifMovieReader();
+    ~GifMovieReader();
+
+    void Release() { delete this; }
+
+    CKPluginInfo *GetReaderInfo();
+
+    int GetOptionsCount() { return 0; }
+    CKSTRING GetOptionDescription(int i) { return NULL; }
+
+    virtual CK_DATAREADER_FLAGS GetFlags() { return CK_DATAREADER_FILELOAD; }
+
+    // Frame count
+    virtual int GetMovieFrameCount();
+    // Length in ms
+    virtual int GetMovieLength();
+
+    virtual CKERROR OpenFile(char *name);
+    // Returns the composited canvas after frame f, in BGRA32
+    virtual CKERROR ReadFrame(int f, CKMovieProperties **mp);
+
+    virtual CKERROR OpenMemory(char *name) { return CKERR_NOTIMPLEMENTED; }
+    virtual CKERROR OpenAsynchronousFile(char *name) { return CKERR_NOTIMPLEMENTED; }
+
+    void Close();
+
+private:
+    GifMovieProperties m_Properties;
+    ImageFileMap m_File;
+    GifAnimation m_Animation;
+    ImageMovieCompositor m_Compositor; // decode buffers hold color indices
+};
+
+#endif // GIFMOVIEREADER_H
@@ -0,0 +1,474 @@
+#include "GifReader.h"
+#include "ImageFileMap.h"
+#include "ImageLzw.h"
+
+static CKDWORD ReadLE16(const CKBYTE *p) { return (CKDWORD)p[0] | ((CKDWORD)p[1] << 8); }
+
+//=============================================================================
+// Frame Index
+//=============================================================================
+
+// Steps over a chain of data sub-blocks and its terminator. payload receives
+// the bytes held by the sub-blocks. Returns FALSE if the chain runs past the
+// end of the data; payload then counts the bytes up to the end.
+static CKBOOL SkipSubBlocks(const CKBYTE *data, CKDWORD size, CKDWORD &offset, CKDWORD &payload)
+{
+    payload = 0;
+    while (offset < size)
+    {
+        CKDWORD length = data[offset];
+        if (length == 0)
+        {
+            offset++;
+            return TRUE;
+        }
+        if (length > size - offset - 1)
+        {
+            payload += size - offset - 1;
+            offset = size;
+            return FALSE;
+        }
+        payload += length;
+        offset += 1 + length;
+    }
+    return FALSE;
+}
+
+static CKBOOL IsLoopExtension(const CKBYTE *id)
+{
+    return memcmp(id, "NETSCAPE2.0", 11) == 0 || memcmp(id, "ANIMEXTS1.0", 11) == 0;
+}
+
+// Walks the blocks that follow the global color table. With frames == NULL
+// the frames are only counted, so the index can be allocated once.
+static int ScanBlocks(GifAnimation &anim, CKDWORD offset, CKDWORD globalOffset, CKDWORD globalCount,
+                      GifFrame *frames, CKDWORD &count)
+{
+    const CKBYTE *data = anim.data;
+    CKDWORD size = anim.size;
+
+    // Graphic control extension of the next image
+    CKDWORD disposal = GIF_DISPOSE_NONE;
+    CKDWORD delay = 0;
+    int transparent = -1;
+
+    count = 0;
+    while (offset < size)
+    {
+        CKBYTE block = data[offset++];
+        if (block == GIF_BLOCK_EXTENSION)
+        {
+            if (offset >= size)
+                break;
+            CKBYTE label = data[offset++];
+            CKDWORD first = offset;
+            CKDWORD payload;
+            CKBOOL complete = SkipSubBlocks(data, size, offset, payload);
+            if (label == GIF_EXT_GRAPHIC_CONTROL && complete && data[first] >= GIF_GCE_SIZE)
+            {
+                const CKBYTE *p = data + first + 1;
+                disposal = (p[0] >> 2) & 7;
+                if (disposal != GIF_DISPOSE_BACKGROUND && disposal != GIF_DISPOSE_PREVIOUS)
+                    disposal = GIF_DISPOSE_NONE;
+                delay = ReadLE16(p + 1) * 10;
+                transparent = (p[0] & 1) ? (int)p[3] : -1;
+            }
+            else if (label == GIF_EXT_APPLICATION && complete && data[first] == 11 &&
+                     IsLoopExtension(data + first + 1))
+            {
+                // Loop sub-block: 1, then the repeat count (0 = forever)
+                CKDWORD sub = first + 12;
+                if (data[sub] >= 3 && data[sub + 1] == 1)
+                {
+                    CKDWORD repeats = ReadLE16(data + sub + 2);
+                    anim.numPlays = repeats ? repeats + 1 : 0;
+                }
+            }
+            if (!complete)
+                break;
+        }
+        else if (block == GIF_BLOCK_IMAGE)
+        {
+            if (size - offset < GIF_DESCRIPTOR_SIZE - 1)
+                break;
+            const CKBYTE *p = data + offset;
+            GifFrame frame;
+            memset(&frame, 0, sizeof(frame));
+            frame.x = ReadLE16(p);
+            frame.y = ReadLE16(p + 2);
+            frame.width = ReadLE16(p + 4);
+            frame.height = ReadLE16(p + 6);
+            frame.interlaced = (p[8] & GIF_FLAG_INTERLACED) ? TRUE : FALSE;
+            offset += GIF_DESCRIPTOR_SIZE - 1;
+            if (frame.width == 0 || frame.height == 0 || !ImageWithinDecodeLimits(frame.width, frame.height, 0))
+                return CKBITMAPERROR_FILECORRUPTED;
+
+            if (p[8] & GIF_FLAG_COLOR_TABLE)
+            {
+                CKDWORD entries = 2u << (p[8] & GIF_COLOR_TABLE_BITS);
+                if (entries * 3 > size - offset)
+                    break;
+                frame.paletteOffset = offset;
+                frame.paletteCount = entries;
+                offset += entries * 3;
+            }
+            else
+            {
+                frame.paletteOffset = globalOffset;
+                frame.paletteCount = globalCount;
+            }
+
+            if (offset >= size)
+                break;
+            frame.minCodeSize = data[offset++];
+            if (frame.minCodeSize < 1 || frame.minCodeSize > 8)
+                return CKBITMAPERROR_FILECORRUPTED;
+            frame.dataOffset = offset;
+            CKBOOL complete = SkipSubBlocks(data, size, offset, frame.dataSize);
+            if (frame.dataSize == 0)
+            {
+                if (!complete)
+                    break;
+                // An image without data draws nothing but still takes its time
+            }
+
+            frame.delay = delay;
+            frame.disposal = disposal;
+            frame.transparent = transparent;
+            if (frames)
+                frames[count] = frame;
+            count++;
+
+            disposal = GIF_DISPOSE_NONE;
+            delay = 0;
+            transparent = -1;
+            if (!complete)
+                break;
+        }
+        else
+        {
+            // Trailer, or anything unknown after the last frame
+            break;
+        }
+    }
+    return 0;
+}
+
+int GIF_Index(const CKBYTE *data, CKDWORD size, GifAnimation &anim)
+{
+    memset(&anim, 0, sizeof(anim));
+    if (!data || size < GIF_HEADER_SIZE)
+        return CKBITMAPERROR_READERROR;
+    if (memcmp(data, "GIF87a", GIF_SIGNATURE_SIZE) != 0 && memcmp(data, "GIF89a", GIF_SIGNATURE_SIZE) != 0)
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+
+    anim.data = data;
+    anim.size = size;
+    anim.width = ReadLE16(data + 6);
+    anim.height = ReadLE16(data + 8);
+    anim.numPlays = 1;
+
+    CKDWORD offset = GIF_HEADER_SIZE;
+    CKDWORD globalOffset = 0;
+    CKDWORD globalCount = 0;
+    if (data[10] & GIF_FLAG_COLOR_TABLE)
+    {
+        globalCount = 2u << (data[10] & GIF_COLOR_TABLE_BITS);
+        if (globalCount * 3 > size - offset)
+            return CKBITMAPERROR_FILECORRUPTED;
+        globalOffset = offset;
+        offset += globalCount * 3;
+    }
+
+    CKDWORD count = 0;
+    int result = ScanBlocks(anim, offset, globalOffset, globalCount, NULL, count);
+    if (result != 0)
+        return result;
+    if (count == 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+    anim.frames = new GifFrame[count];
+    ScanBlocks(anim, offset, globalOffset, globalCount, anim.frames, anim.frameCount);
+
+    // A screen without a size takes the extent of the first frame
+    if (anim.width == 0 || anim.height == 0)
+    {
+        anim.width = anim.frames[0].x + anim.frames[0].width;
+        anim.height = anim.frames[0].y + anim.frames[0].height;
+    }
+    // The largest block read is the BGRA32 screen
+    if (!ImageWithinDecodeLimits(anim.width, anim.height, (uint64_t)anim.width * anim.height * 4))
+    {
+        GIF_FreeIndex(anim);
+        return CKBITMAPERROR_FILECORRUPTED;
+    }
+
+    CKDWORD time = 0;
+    for (CKDWORD i = 0; i < anim.frameCount; i++)
+    {
+        GifFrame &frame = anim.frames[i];
+        frame.startTime = time;
+        time += frame.delay;
+
+        // Frames may reach past the screen; only the part inside it is drawn
+        frame.drawWidth = (frame.x < anim.width) ? anim.width - frame.x : 0;
+        frame.drawHeight = (frame.y < anim.height) ? anim.height - frame.y : 0;
+        if (frame.drawWidth > frame.width)
+            frame.drawWidth = frame.width;
+        if (frame.drawHeight > frame.height)
+            frame.drawHeight = frame.height;
+
+        if (frame.width * frame.height > anim.maxFramePixels)
+            anim.maxFramePixels = frame.width * frame.height;
+    }
+    anim.length = time;
+
+    // Restoring the first frame means restoring the empty canvas
+    if (anim.frames[0].disposal == GIF_DISPOSE_PREVIOUS)
+        anim.frames[0].disposal = GIF_DISPOSE_BACKGROUND;
+    return 0;
+}
+
+void GIF_FreeIndex(GifAnimation &anim)
+{
+    delete[] anim.frames;
+    anim.frames = NULL;
+    anim.frameCount = 0;
+}
+
+//=============================================================================
+// Frame Decoding and Drawing
+//=============================================================================
+void GIF_FramePalette(const GifAnimation &anim, const GifFrame &frame, CKDWORD palette[256])
+{
+    for (CKDWORD i = 0; i < 256; i++)
+        palette[i] = 0xFF000000;
+    const CKBYTE *rgb = anim.data + frame.paletteOffset;
+    for (CKDWORD i = 0; i < frame.paletteCount; i++, rgb += 3)
+        palette[i] = 0xFF000000 | ((CKDWORD)rgb[0] << 16) | ((CKDWORD)rgb[1] << 8) | rgb[2];
+    if (frame.transparent >= 0)
+        palette[frame.transparent] &= 0x00FFFFFF;
+}
+
+int GIF_DecodeFrame(const GifAnimation &anim, CKDWORD index, CKBYTE *dst, CKDWORD &decoded)
+{
+    decoded = 0;
+    if (index >= anim.frameCount || !dst)
+        return CKBITMAPERROR_GENERIC;
+
+    const GifFrame &frame = anim.frames[index];
+    if (frame.dataSize == 0)
+        return 0;
+
+    // Data in a single sub-block is decoded in place, several are joined first
+    const CKBYTE *data = anim.data;
+    CKBYTE *joined = NULL;
+    const CKBYTE *src = data + frame.dataOffset + 1;
+    if (data[frame.dataOffset] < frame.dataSize)
+    {
+        joined = new CKBYTE[frame.dataSize];
+        CKDWORD offset = frame.dataOffset;
+        for (CKDWORD pos = 0; pos < frame.dataSize;)
+        {
+            CKDWORD length = data[offset++];
+            if (length > frame.dataSize - pos)
+                length = frame.dataSize - pos;
+            memcpy(joined + pos, data + offset, length);
+            pos += length;
+            offset += length;
+        }
+        src = joined;
+    }
+
+    decoded = ImageLzwDecode(src, frame.dataSize, frame.minCodeSize, dst, frame.width * frame.height);
+    delete[] joined;
+    return decoded ? 0 : CKBITMAPERROR_FILECORRUPTED;
+}
+
+// Image row of the r-th row stored in an interlaced frame: every 8th row from
+// 0, every 8th from 4, every 4th from 2, then every 2nd from 1
+static CKDWORD InterlacedRow(CKDWORD r, CKDWORD height)
+{
+    CKDWORD pass = (height + 7) / 8;
+    if (r < pass)
+        return r * 8;
+    r -= pass;
+    pass = (height + 3) / 8;
+    if (r < pass)
+        return r * 8 + 4;
+    r -= pass;
+    pass = (height + 1) / 4;
+    if (r < pass)
+        return r * 4 + 2;
+    return (r - pass) * 2 + 1;
+}
+
+void GIF_DrawFrame(const GifAnimation &anim, const GifFrame &frame, const CKBYTE *indices, CKDWORD decoded,
+                   CKBYTE *canvas, CKDWORD canvasStride)
+{
+    if (frame.drawWidth == 0 || frame.drawHeight == 0)
+        return;
+
+    CKDWORD palette[256];
+    GIF_FramePalette(anim, frame, palette);
+
+    CKDWORD fullRows = decoded / frame.width;
+    for (CKDWORD r = 0; r <= fullRows && r < frame.height; r++)
+    {
+        CKDWORD count = (r < fullRows) ? frame.width : decoded % frame.width;
+        if (count > frame.drawWidth)
+            count = frame.drawWidth;
+        CKDWORD row = frame.interlaced ? InterlacedRow(r, frame.height) : r;
+        if (row >= frame.drawHeight)
+            continue;
+
+        const CKBYTE *src = indices + r * frame.width;
+        CKDWORD *dst = (CKDWORD *)(canvas + (frame.y + row) * canvasStride) + frame.x;
+        if (frame.transparent < 0)
+        {
+            for (CKDWORD i = 0; i < count; i++)
+                dst[i] = palette[src[i]];
+        }
+        else
+        {
+            for (CKDWORD i = 0; i < count; i++)
+            {
+                if (src[i] != frame.transparent)
+                    dst[i] = palette[src[i]];
+            }
+        }
+    }
+}
+
+//=============================================================================
+// GifReader Class Implementation
+//=============================================================================
+GifReader::GifReader() : ImageReader(), m_ReadFlags(0)
+{
+    m_Properties.Init(GIFREADER_GUID, "gif");
+}
+
+GifReader::~GifReader()
+{
+    FreeBitmapData(&m_Properties);
+}
+
+CKPluginInfo *GifReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_GIF];
+}
+
+void GifReader::SetReadFlags(CKDWORD flags) { m_ReadFlags = flags; }
+
+CKDWORD GifReader::GetReadFlags() { return m_ReadFlags; }
+
+int GifReader::GetOptionsCount() { return 0; }
+
+CKSTRING GifReader::GetOptionDescription(int i) { return ""; }
+
+int GifReader::ReadFile(CKSTRING filename, CKBitmapProperties **bp)
+{
+    if (!filename || !bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_GIF, (void *)filename, 0, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int GifReader::ReadMemory(void *memory, int size, CKBitmapProperties **bp)
+{
+    if (!bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_GIF, memory, size, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int GifReader::ReadOwnFormat(void *data, int size, CKBitmapProperties *props)
+{
+    return GIF_Read(data, size, props, m_ReadFlags);
+}
+
+//=============================================================================
+// GIF_Read - Core Reading Function
+//=============================================================================
+int GIF_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags)
+{
+    if (!data || !props)
+        return CKBITMAPERROR_GENERIC;
+    if (size < 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    ImageFileMap fileMap;
+    if (size == 0)
+    {
+        if (!fileMap.Open((const char *)data))
+            return CKBITMAPERROR_READERROR;
+        data = (void *)fileMap.Data();
+        size = (int)fileMap.Size();
+    }
+
+    GifAnimation anim;
+    int result = GIF_Index((const CKBYTE *)data, (CKDWORD)size, anim);
+    if (result != 0)
+        return result;
+
+    const GifFrame &frame = anim.frames[0];
+    CKBYTE *indices = new CKBYTE[frame.width * frame.height];
+    CKDWORD decoded = 0;
+    result = GIF_DecodeFrame(anim, 0, indices, decoded);
+    if (result != 0)
+    {
+        delete[] indices;
+        GIF_FreeIndex(anim);
+        return result;
+    }
+
+    // Indices are only kept when the frame is the whole image
+    CKBOOL keepIndices = (readFlags & IMAGE_READ_KEEP_INDICES) && frame.x == 0 && frame.y == 0 &&
+                         frame.width == anim.width && frame.height == anim.height;
+    CKBYTE *dstBlock;
+    if (keepIndices)
+    {
+        // Pixels the data does not reach take the transparent index, else 0
+        int dstStride = ImageReader::Indexed8Stride((int)anim.width);
+        dstBlock = new CKBYTE[256 * 4 + dstStride * anim.height];
+        CKBYTE *dstPixels = dstBlock + 256 * 4;
+        memset(dstPixels, (frame.transparent >= 0) ? frame.transparent : 0, dstStride * anim.height);
+        for (CKDWORD r = 0; r * frame.width < decoded; r++)
+        {
+            CKDWORD count = decoded - r * frame.width;
+            if (count > frame.width)
+                count = frame.width;
+            CKDWORD row = frame.interlaced ? InterlacedRow(r, frame.height) : r;
+            memcpy(dstPixels + row * dstStride, indices + r * frame.width, count);
+        }
+
+        // Codes below the clear code may index past a short color table
+        int colorCount = 1 << frame.minCodeSize;
+        if (colorCount < (int)frame.paletteCount)
+            colorCount = (int)frame.paletteCount;
+        if (colorCount > 256)
+            colorCount = 256;
+        GIF_FramePalette(anim, frame, (CKDWORD *)dstBlock);
+        ImageReader::FillFormatIndexed8(props->m_Format, (int)anim.width, (int)anim.height, dstStride, dstPixels,
+                                        dstBlock, colorCount);
+    }
+    else
+    {
+        CKDWORD dstStride = anim.width * 4;
+        dstBlock = new CKBYTE[dstStride * anim.height];
+        memset(dstBlock, 0, dstStride * anim.height);
+        GIF_DrawFrame(anim, frame, indices, decoded, dstBlock, dstStride);
+        ImageReader::FillFormatBGRA32(props->m_Format, (int)anim.width, (int)anim.height, (int)dstStride, dstBlock);
+    }
+    props->m_Data = dstBlock;
+
+    if (props->m_Size == sizeof(GifBitmapProperties))
+    {
+        ((GifBitmapProperties *)props)->m_FrameCount = anim.frameCount;
+        ((GifBitmapProperties *)props)->m_NumPlays = anim.numPlays;
+    }
+    delete[] indices;
+    GIF_FreeIndex(anim);
+    return 0;
+}
@@ -0,0 +1,137 @@
+#ifndef GIFREADER_H
+#define GIFREADER_H
+
+#include "ImageReader.h"
+
+// GIF Reader GUID
+#define GIFREADER_GUID CKGUID(0x6A1F3D92, 0x2E84C5B7)
+
+/**
+ * GifReader - Graphics Interchange Format reader
+ *
+ *   - GIF87a and GIF89a, global and local color tables, interlacing and
+ *     transparency; the first frame is returned on a canvas of the logical
+ *     screen size, transparent where the frame does not cover it
+ *   - Decoded to BGRA32; with IMAGE_READ_KEEP_INDICES, a first frame that
+ *     covers the whole screen is returned as 8-bit indices plus palette
+ *   - Table-driven LZW (ImageLzw) that copies whole code strings at once
+ *   - Frames cut short keep the pixels decoded so far; the rest of the frame
+ *     is left undrawn
+ *   - Animations are read frame by frame with GifMovieReader
+ *   - Read-only: SaveFile and SaveMemory return 0
+ */
+class GifReader : public ImageReader
+{
+public:
+    GifReader();
+    virtual ~GifReader();
+
+    virtual CKPluginInfo *GetReaderInfo();
+    virtual int GetOptionsCount();
+    virtual CKSTRING GetOptionDescription(int i);
+
+    virtual int ReadFile(CKSTRING filename, CKBitmapProperties **bp);
+    virtual int ReadMemory(void *memory, int size, CKBitmapProperties **bp);
+
+    // IMAGE_READ_* flags applied by ReadFile/ReadMemory (default 0)
+    void SetReadFlags(CKDWORD flags);
+    CKDWORD GetReadFlags();
+
+protected:
+    virtual int ReadOwnFormat(void *data, int size, CKBitmapProperties *props);
+
+private:
+    GifBitmapProperties m_Properties;
+    CKDWORD m_ReadFlags;
+};
+
+//=============================================================================
+// GIF file format
+//=============================================================================
+#define GIF_SIGNATURE_SIZE 6
+#define GIF_HEADER_SIZE 13 // signature and logical screen descriptor
+#define GIF_DESCRIPTOR_SIZE 10 // including the 0x2C introducer
+#define GIF_GCE_SIZE 4
+
+// Block introducers and extension labels
+#define GIF_BLOCK_EXTENSION 0x21
+#define GIF_BLOCK_IMAGE 0x2C
+#define GIF_BLOCK_TRAILER 0x3B
+#define GIF_EXT_GRAPHIC_CONTROL 0xF9
+#define GIF_EXT_APPLICATION 0xFF
+
+// Packed fields of the screen and image descriptors
+#define GIF_FLAG_COLOR_TABLE 0x80
+#define GIF_FLAG_INTERLACED 0x40
+#define GIF_COLOR_TABLE_BITS 0x07
+
+// Disposal, applied to the frame's region before the next frame is drawn.
+// Undefined values (0 and 4 to 7) are treated as GIF_DISPOSE_NONE.
+#define GIF_DISPOSE_NONE 1
+#define GIF_DISPOSE_BACKGROUND 2 // cleared to transparent black
+#define GIF_DISPOSE_PREVIOUS 3   // restored to what it was before the frame
+
+struct GifFrame
+{
+    CKDWORD x;
+    CKDWORD y;
+    CKDWORD width;
+    CKDWORD height;
+    CKDWORD drawWidth;  // part of the region inside the screen (0 if none)
+    CKDWORD drawHeight;
+    CKDWORD delay;     // in ms
+    CKDWORD startTime; // sum of the delays of the previous frames
+    CKDWORD disposal;
+    int transparent; // transparent color index, -1 if none
+    CKBOOL interlaced;
+    CKDWORD paletteOffset; // color table of the frame (local, else global), 0 if none
+    CKDWORD paletteCount;
+    int minCodeSize;
+    CKDWORD dataOffset; // first data sub-block (its length byte)
+    CKDWORD dataSize;   // LZW bytes over all sub-blocks
+};
+
+// Frame index of a GIF file. The file bytes are referenced, not copied, and
+// must stay valid while frames are decoded.
+struct GifAnimation
+{
+    const CKBYTE *data;
+    CKDWORD size;
+    CKDWORD width; // logical screen
+    CKDWORD height;
+    CKDWORD numPlays;       // 0 = forever
+    CKDWORD length;         // total duration in ms
+    CKDWORD maxFramePixels; // largest width * height over the frames
+    CKDWORD frameCount;
+    GifFrame *frames;
+};
+
+//=============================================================================
+// Internal helper functions
+//=============================================================================
+
+// Builds the frame index; frames are allocated with new[] and released by
+// GIF_FreeIndex. Frames cut off by the end of the file are kept as long as
+// they have some data. Returns a CKBITMAPERROR_* code.
+int GIF_Index(const CKBYTE *data, CKDWORD size, GifAnimation &anim);
+void GIF_FreeIndex(GifAnimation &anim);
+
+// BGRA palette of a frame: entries past its color table are opaque black and
+// the transparent index has alpha 0
+void GIF_FramePalette(const GifAnimation &anim, const GifFrame &frame, CKDWORD palette[256]);
+
+// Decompresses a frame's color indices into dst (width * height bytes) in
+// file order, i.e. interlaced frames are not reordered. Returns a
+// CKBITMAPERROR_* code; decoded receives the number of indices produced,
+// which is less than width * height for a frame cut short.
+int GIF_DecodeFrame(const GifAnimation &anim, CKDWORD frame, CKBYTE *dst, CKDWORD &decoded);
+
+// Draws the first decoded indices of a frame into a BGRA32 canvas of the
+// screen size, clipped to the screen and skipping transparent pixels
+void GIF_DrawFrame(const GifAnimation &anim, const GifFrame &frame, const CKBYTE *indices, CKDWORD decoded,
+                   CKBYTE *canvas, CKDWORD canvasStride);
+
+// Core GIF read function (size == 0 means data is a filename)
+int GIF_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags = 0);
+
+#endif // GIFREADER_H
@@ -0,0 +1,409 @@
+#include "HdrReader.h"
+#include "ImageSimd.h"
+#include "ImageThreadPool.h"
+#include "ImageFileMap.h"
+
+#include <cstdio>
+
+//=============================================================================
+// Header
+//=============================================================================
+
+// Copies the line starting at pos (without its newline) into line, cut to
+// HDR_MAX_LINE - 1 characters, and moves pos past it. Returns FALSE if the
+// data ends before the newline.
+static CKBOOL ReadLine(const CKBYTE *data, CKDWORD size, CKDWORD &pos, char *line)
+{
+    const CKBYTE *start = data + pos;
+    const CKBYTE *end = (const CKBYTE *)memchr(start, '\n', size - pos);
+    if (!end)
+        return FALSE;
+    CKDWORD length = (CKDWORD)(end - start);
+    CKDWORD copied = (length < HDR_MAX_LINE - 1) ? length : HDR_MAX_LINE - 1;
+    memcpy(line, start, copied);
+    line[copied] = '\0';
+    pos += length + 1;
+    return TRUE;
+}
+
+int HDR_ReadInfo(const CKBYTE *data, CKDWORD size, HdrImageInfo &info)
+{
+    memset(&info, 0, sizeof(info));
+    info.exposure = 1.0f;
+    info.gamma = 1.0f;
+    if (!data || size < 2)
+        return CKBITMAPERROR_READERROR;
+    if (memcmp(data, HDR_SIGNATURE, 2) != 0)
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+
+    // Variables up to an empty line; the first line is the program name
+    char line[HDR_MAX_LINE];
+    CKDWORD pos = 0;
+    if (!ReadLine(data, size, pos, line))
+        return CKBITMAPERROR_READERROR;
+    for (;;)
+    {
+        if (!ReadLine(data, size, pos, line))
+            return CKBITMAPERROR_READERROR;
+        if (line[0] == '\0')
+            break;
+        if (strncmp(line, "FORMAT=", 7) == 0)
+        {
+            if (strcmp(line + 7, "32-bit_rle_rgbe") != 0)
+                return CKBITMAPERROR_UNSUPPORTEDFILE;
+        }
+        else if (strncmp(line, "EXPOSURE=", 9) == 0)
+        {
+            info.exposure *= (float)atof(line + 9);
+        }
+        else if (strncmp(line, "GAMMA=", 6) == 0)
+        {
+            info.gamma = (float)atof(line + 6);
+        }
+    }
+
+    // Resolution: "-Y height +X width" is the usual top-down order
+    if (!ReadLine(data, size, pos, line))
+        return CKBITMAPERROR_READERROR;
+    char sign1, axis1, sign2, axis2;
+    unsigned int n1, n2;
+    if (sscanf(line, "%c%c %u %c%c %u", &sign1, &axis1, &n1, &sign2, &axis2, &n2) != 6)
+        return CKBITMAPERROR_FILECORRUPTED;
+    if ((sign1 != '+' && sign1 != '-') || (sign2 != '+' && sign2 != '-'))
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (axis1 == 'X' && axis2 == 'Y')
+        return CKBITMAPERROR_UNSUPPORTEDFILE; // column-major
+    if (axis1 != 'Y' || axis2 != 'X')
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    info.height = n1;
+    info.width = n2;
+    info.flipY = (sign1 == '+');
+    info.flipX = (sign2 == '-');
+    info.dataOffset = pos;
+    if (info.width == 0 || info.height == 0 || !ImageWithinDecodeLimits(info.width, info.height, 0))
+        return CKBITMAPERROR_FILECORRUPTED;
+    return 0;
+}
+
+//=============================================================================
+// Scanlines
+//=============================================================================
+static CKBOOL IsRleScanline(const CKBYTE *p, CKDWORD available, CKDWORD width)
+{
+    return width >= HDR_RLE_MIN_WIDTH && width <= HDR_RLE_MAX_WIDTH && available >= 4 && p[0] == 2 && p[1] == 2 &&
+           (p[2] & 0x80) == 0;
+}
+
+int HDR_IndexScanlines(const CKBYTE *data, CKDWORD size, const HdrImageInfo &info, CKDWORD *offsets)
+{
+    // Only the run headers are read. A scanline cut by the end of the data
+    // ends there, and the missing ones are empty.
+    CKDWORD pos = info.dataOffset;
+    CKDWORD width = info.width;
+    for (CKDWORD y = 0; y < info.height; y++)
+    {
+        offsets[y] = pos;
+        if (IsRleScanline(data + pos, size - pos, width))
+        {
+            if ((((CKDWORD)data[pos + 2] << 8) | data[pos + 3]) != width)
+                return CKBITMAPERROR_FILECORRUPTED;
+            pos += 4;
+            // Each channel is a sequence of runs (128 + n, value) and literals (n, n values)
+            for (int c = 0; c < 4; c++)
+            {
+                CKDWORD x = 0;
+                while (x < width && pos < size)
+                {
+                    CKDWORD code = data[pos++];
+                    CKDWORD n = (code > 128) ? code - 128 : code;
+                    if (n == 0 || n > width - x)
+                        return CKBITMAPERROR_FILECORRUPTED;
+                    pos += (code > 128) ? 1 : n;
+                    x += n;
+                }
+            }
+        }
+        else
+        {
+            // Flat pixels; (1, 1, 1, n) repeats the previous pixel, n shifted
+            // left 8 more bits for each consecutive repeat (old-style RLE)
+            CKDWORD x = 0;
+            CKDWORD shift = 0;
+            while (x < width && size - pos >= 4)
+            {
+                const CKBYTE *p = data + pos;
+                pos += 4;
+                if (p[0] == 1 && p[1] == 1 && p[2] == 1)
+                {
+                    if (x == 0 || shift > 16)
+                        return CKBITMAPERROR_FILECORRUPTED;
+                    CKDWORD n = (CKDWORD)p[3] << shift;
+                    if (n > width - x)
+                        return CKBITMAPERROR_FILECORRUPTED;
+                    x += n;
+                    shift += 8;
+                }
+                else
+                {
+                    x++;
+                    shift = 0;
+                }
+            }
+            if (x < width)
+                pos = size;
+        }
+        if (pos > size)
+            pos = size;
+    }
+    offsets[info.height] = pos;
+    return 0;
+}
+
+int HDR_DecodeScanline(const CKBYTE *src, CKDWORD srcSize, CKDWORD width, CKBYTE *dst)
+{
+    // Whatever the data does not cover stays black
+    memset(dst, 0, (size_t)width * 4);
+    const CKBYTE *end = src + srcSize;
+    if (IsRleScanline(src, srcSize, width))
+    {
+        src += 4;
+        for (int c = 0; c < 4; c++)
+        {
+            CKDWORD x = 0;
+            while (x < width && src < end)
+            {
+                CKDWORD code = *src++;
+                CKDWORD n = (code > 128) ? code - 128 : code;
+                if (n == 0 || n > width - x)
+                    return CKBITMAPERROR_FILECORRUPTED;
+                if (code > 128)
+                {
+                    if (src == end)
+                        break;
+                    CKBYTE value = *src++;
+                    for (CKDWORD k = 0; k < n; k++)
+                        dst[(x + k) * 4 + c] = value;
+                }
+                else
+                {
+                    if (n > (CKDWORD)(end - src))
+                        n = (CKDWORD)(end - src);
+                    for (CKDWORD k = 0; k < n; k++)
+                        dst[(x + k) * 4 + c] = src[k];
+                    src += n;
+                }
+                x += n;
+            }
+        }
+        return 0;
+    }
+
+    CKDWORD x = 0;
+    CKDWORD shift = 0;
+    while (x < width && end - src >= 4)
+    {
+        if (src[0] == 1 && src[1] == 1 && src[2] == 1)
+        {
+            if (x == 0 || shift > 16)
+                return CKBITMAPERROR_FILECORRUPTED;
+            CKDWORD n = (CKDWORD)src[3] << shift;
+            if (n > width - x)
+                return CKBITMAPERROR_FILECORRUPTED;
+            for (CKDWORD k = 0; k < n; k++, x++)
+                memcpy(dst + x * 4, dst + (x - 1) * 4, 4);
+            shift += 8;
+        }
+        else
+        {
+            memcpy(dst + x * 4, src, 4);
+            x++;
+            shift = 0;
+        }
+        src += 4;
+    }
+    return 0;
+}
+
+//=============================================================================
+// Parallel Decoding
+//=============================================================================
+struct HdrDecodeJob
+{
+    const HdrImageInfo *info;
+    const CKBYTE *data;
+    const CKDWORD *offsets;
+    CKBOOL floatOutput;
+    float exposure;
+    CKBYTE *dst;
+    int dstStride;
+    int *errors;
+};
+
+static void DecodeScanlines(void *context, CKDWORD begin, CKDWORD end)
+{
+    const HdrDecodeJob &job = *(const HdrDecodeJob *)context;
+    const HdrImageInfo &info = *job.info;
+    CKDWORD width = info.width;
+    CKBYTE *rgbe = new CKBYTE[(size_t)width * 4];
+    for (CKDWORD y = begin; y < end; y++)
+    {
+        job.errors[y] = HDR_DecodeScanline(job.data + job.offsets[y], job.offsets[y + 1] - job.offsets[y], width, rgbe);
+        if (job.errors[y] != 0)
+            continue;
+
+        if (info.flipX)
+        {
+            CKDWORD *px = (CKDWORD *)rgbe;
+            for (CKDWORD a = 0, b = width - 1; a < b; a++, b--)
+            {
+                CKDWORD t = px[a];
+                px[a] = px[b];
+                px[b] = t;
+            }
+        }
+        CKDWORD row = info.flipY ? info.height - 1 - y : y;
+        CKBYTE *dst = job.dst + (size_t)row * job.dstStride;
+        if (job.floatOutput)
+            ImageRGBEToFloat(rgbe, (float *)dst, (int)width);
+        else
+            ImageRGBEToBGRA32(rgbe, dst, (int)width, job.exposure);
+    }
+    delete[] rgbe;
+}
+
+//=============================================================================
+// HdrReader Class Implementation
+//=============================================================================
+HdrReader::HdrReader() : ImageReader(), m_ReadFlags(0), m_Exposure(1.0f)
+{
+    m_Properties.Init(HDRREADER_GUID, "hdr");
+}
+
+HdrReader::~HdrReader()
+{
+    FreeBitmapData(&m_Properties);
+}
+
+CKPluginInfo *HdrReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_HDR];
+}
+
+void HdrReader::SetReadFlags(CKDWORD flags) { m_ReadFlags = flags; }
+
+CKDWORD HdrReader::GetReadFlags() { return m_ReadFlags; }
+
+void HdrReader::SetExposure(float exposure) { m_Exposure = exposure; }
+
+float HdrReader::GetExposure() { return m_Exposure; }
+
+int HdrReader::GetOptionsCount() { return 0; }
+
+CKSTRING HdrReader::GetOptionDescription(int i) { return ""; }
+
+int HdrReader::ReadFile(CKSTRING filename, CKBitmapProperties **bp)
+{
+    if (!filename || !bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_HDR, (void *)filename, 0, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int HdrReader::ReadMemory(void *memory, int size, CKBitmapProperties **bp)
+{
+    if (!bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_HDR, memory, size, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int HdrReader::ReadOwnFormat(void *data, int size, CKBitmapProperties *props)
+{
+    return HDR_Read(data, size, props, m_ReadFlags, m_Exposure);
+}
+
+//=============================================================================
+// HDR_Read - Core Reading Function
+//=============================================================================
+int HDR_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags, float exposure)
+{
+    if (!data || !props)
+        return CKBITMAPERROR_GENERIC;
+    if (size < 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // Files are mapped so scanlines are decoded straight from the mapping
+    ImageFileMap fileMap;
+    if (size == 0)
+    {
+        if (!fileMap.Open((const char *)data))
+            return CKBITMAPERROR_READERROR;
+        data = (void *)fileMap.Data();
+        size = (int)fileMap.Size();
+    }
+
+    const CKBYTE *bytes = (const CKBYTE *)data;
+    CKDWORD fileSize = (CKDWORD)size;
+    HdrImageInfo info;
+    int result = HDR_ReadInfo(bytes, fileSize, info);
+    if (result != 0)
+        return result;
+
+    // Every scanline takes at least 4 bytes, which bounds the height by the
+    // file size before anything is allocated
+    if (info.height > (fileSize - info.dataOffset) / 4)
+        return CKBITMAPERROR_FILECORRUPTED;
+    CKBOOL floatOutput = (readFlags & IMAGE_READ_FLOAT) != 0;
+    uint64_t dstStride64 = (uint64_t)info.width * (floatOutput ? 16 : 4);
+    if (!ImageWithinDecodeLimits(info.width, info.height, dstStride64 * info.height))
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    CKDWORD *offsets = new CKDWORD[info.height + 1];
+    result = HDR_IndexScanlines(bytes, fileSize, info, offsets);
+    if (result != 0)
+    {
+        delete[] offsets;
+        return result;
+    }
+
+    int dstStride = (int)dstStride64;
+    CKBYTE *dstBlock = new CKBYTE[(size_t)dstStride64 * info.height];
+    int *errors = new int[info.height];
+    HdrDecodeJob job;
+    job.info = &info;
+    job.data = bytes;
+    job.offsets = offsets;
+    job.floatOutput = floatOutput;
+    job.exposure = exposure;
+    job.dst = dstBlock;
+    job.dstStride = dstStride;
+    job.errors = errors;
+    ImageParallelFor(info.height, 16, DecodeScanlines, &job);
+
+    for (CKDWORD y = 0; y < info.height && result == 0; y++)
+        result = errors[y];
+    delete[] errors;
+    delete[] offsets;
+    if (result != 0)
+    {
+        delete[] dstBlock;
+        return result;
+    }
+
+    // Fill properties
+    if (floatOutput)
+        ImageReader::FillFormatRGBA128F(props->m_Format, (int)info.width, (int)info.height, dstStride, dstBlock);
+    else
+        ImageReader::FillFormatBGRA32(props->m_Format, (int)info.width, (int)info.height, dstStride, dstBlock);
+    props->m_Data = dstBlock;
+
+    if (props->m_Size == sizeof(HdrBitmapProperties))
+    {
+        ((HdrBitmapProperties *)props)->m_Exposure = info.exposure;
+        ((HdrBitmapProperties *)props)->m_Gamma = info.gamma;
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#ifndef HDRREADER_H
+#define HDRREADER_H
+
+#include "ImageReader.h"
+
+// HDR Reader GUID
+#define HDRREADER_GUID CKGUID(0x7D3E9A15, 0x42C8F06B)
+
+/**
+ * HdrReader - Radiance RGBE (.hdr, .pic) reader
+ *
+ *   - Flat, old-style run-length and new-style (per channel) run-length
+ *     scanlines, in any of the four row/column orders
+ *   - A pre-scan finds where each scanline starts, then scanlines are decoded
+ *     in parallel (ImageParallelFor) and converted with SSE2
+ *   - Decoded to BGRA32 by scaling with the exposure setting and clamping to
+ *     0..1 (values are linear); with IMAGE_READ_FLOAT, to RGBA float
+ *   - XYZE files are not supported
+ *   - Read-only: SaveFile and SaveMemory return 0
+ */
+class HdrReader : public ImageReader
+{
+public:
+    HdrReader();
+    virtual ~HdrReader();
+
+    virtual CKPluginInfo *GetReaderInfo();
+    virtual int GetOptionsCount();
+    virtual CKSTRING GetOptionDescription(int i);
+
+    virtual int ReadFile(CKSTRING filename, CKBitmapProperties **bp);
+    virtual int ReadMemory(void *memory, int size, CKBitmapProperties **bp);
+
+    // IMAGE_READ_* flags applied by ReadFile/ReadMemory (default 0)
+    void SetReadFlags(CKDWORD flags);
+    CKDWORD GetReadFlags();
+
+    // Factor applied to the pixel values before they are clamped to BGRA32
+    // (default 1.0); float output is not scaled
+    void SetExposure(float exposure);
+    float GetExposure();
+
+protected:
+    virtual int ReadOwnFormat(void *data, int size, CKBitmapProperties *props);
+
+private:
+    HdrBitmapProperties m_Properties;
+    CKDWORD m_ReadFlags;
+    float m_Exposure;
+};
+
+//=============================================================================
+// Radiance file format
+//=============================================================================
+#define HDR_SIGNATURE "#?"
+#define HDR_MAX_LINE 256
+
+// New-style run-length scanlines start with 2, 2 and the width (big-endian);
+// only widths in this range can be encoded that way
+#define HDR_RLE_MIN_WIDTH 8
+#define HDR_RLE_MAX_WIDTH 0x7FFF
+
+// Header and scanline layout. Scanlines are stored in file order; xMajor is
+// not supported, flipX/flipY tell how file order maps to top-down, left-to-right.
+struct HdrImageInfo
+{
+    CKDWORD width;
+    CKDWORD height;
+    CKBOOL flipX; // "-X": scanlines run right to left
+    CKBOOL flipY; // "+Y": scanlines run bottom to top
+    float exposure;
+    float gamma;
+    CKDWORD dataOffset; // first scanline
+};
+
+//=============================================================================
+// Internal helper functions
+//=============================================================================
+
+// Parses the header and the resolution line
+int HDR_ReadInfo(const CKBYTE *data, CKDWORD size, HdrImageInfo &info);
+
+// Finds where each of the info.height scanlines starts; offsets receives
+// height + 1 entries, the last being the end of the pixel data.
+int HDR_IndexScanlines(const CKBYTE *data, CKDWORD size, const HdrImageInfo &info, CKDWORD *offsets);
+
+// Decodes one scanline of width RGBE pixels from src (srcSize bytes, as
+// delimited by HDR_IndexScanlines) into dst
+int HDR_DecodeScanline(const CKBYTE *src, CKDWORD srcSize, CKDWORD width, CKBYTE *dst);
+
+// Core HDR read function (size == 0 means data is a filename)
+int HDR_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags = 0, float exposure = 1.0f);
+
+#endif // HDRREADER_H
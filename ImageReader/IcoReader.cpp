@@ -0,0 +1,271 @@
+#include "IcoReader.h"
+#include "BmpReader.h"
+#include "PngReader.h"
+#include "ImageFileMap.h"
+
+//=============================================================================
+// Directory
+//=============================================================================
+static CKDWORD ReadLE16(const CKBYTE *p)
+{
+    return (CKDWORD)p[0] | ((CKDWORD)p[1] << 8);
+}
+
+static CKDWORD ReadLE32(const CKBYTE *p)
+{
+    return (CKDWORD)p[0] | ((CKDWORD)p[1] << 8) | ((CKDWORD)p[2] << 16) | ((CKDWORD)p[3] << 24);
+}
+
+static const CKBYTE s_PngSignature[PNG_SIGNATURE_SIZE] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+
+static CKDWORD PngBitsPerPixel(CKDWORD bitDepth, CKDWORD colorType)
+{
+    switch (colorType)
+    {
+    case PNG_COLOR_RGB:
+        return bitDepth * 3;
+    case PNG_COLOR_GRAY_ALPHA:
+        return bitDepth * 2;
+    case PNG_COLOR_RGBA:
+        return bitDepth * 4;
+    default:
+        return bitDepth;
+    }
+}
+
+int ICO_Index(const void *data, int size, IcoDirectory &dir)
+{
+    dir.data = (const CKBYTE *)data;
+    dir.size = 0;
+    dir.type = 0;
+    dir.entryCount = 0;
+    if (!data || size < ICO_HEADER_SIZE)
+        return CKBITMAPERROR_READERROR;
+
+    const CKBYTE *bytes = (const CKBYTE *)data;
+    CKDWORD type = ReadLE16(bytes + 2);
+    if (ReadLE16(bytes) != 0 || (type != ICO_TYPE_ICON && type != ICO_TYPE_CURSOR))
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+
+    CKDWORD count = ReadLE16(bytes + 4);
+    if (count == 0 || ICO_HEADER_SIZE + count * ICO_ENTRY_SIZE > (CKDWORD)size)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    dir.size = (CKDWORD)size;
+    dir.type = type;
+    dir.entryCount = count;
+    return 0;
+}
+
+int ICO_Entry(const IcoDirectory &dir, CKDWORD i, IcoEntry &entry)
+{
+    memset(&entry, 0, sizeof(entry));
+    if (i >= dir.entryCount)
+        return CKBITMAPERROR_READERROR;
+
+    const CKBYTE *e = dir.data + ICO_HEADER_SIZE + i * ICO_ENTRY_SIZE;
+    entry.width = e[0] ? e[0] : 256;
+    entry.height = e[1] ? e[1] : 256;
+    if (dir.type == ICO_TYPE_CURSOR)
+    {
+        entry.hotspotX = ReadLE16(e + 4);
+        entry.hotspotY = ReadLE16(e + 6);
+    }
+    entry.size = ReadLE32(e + 8);
+    entry.offset = ReadLE32(e + 12);
+
+    // The image must follow the table and end inside the file
+    CKDWORD tableEnd = ICO_HEADER_SIZE + dir.entryCount * ICO_ENTRY_SIZE;
+    if (entry.offset < tableEnd || entry.size < ICO_MIN_ENTRY_SIZE ||
+        (unsigned long long)entry.offset + entry.size > dir.size)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // The directory bit count is unreliable (and holds the hotspot in cursors),
+    // so the depth comes from the image header
+    const CKBYTE *image = dir.data + entry.offset;
+    entry.png = memcmp(image, s_PngSignature, PNG_SIGNATURE_SIZE) == 0;
+    if (entry.png)
+        entry.bitDepth = PngBitsPerPixel(image[24], image[25]);
+    else
+        entry.bitDepth = ReadLE16(image + ((ReadLE32(image) == 12) ? 10 : 14));
+    return 0;
+}
+
+CKDWORD ICO_BestEntry(const IcoDirectory &dir, CKDWORD size, CKDWORD bitDepth)
+{
+    CKDWORD best = dir.entryCount;
+    unsigned long long bestScore = 0;
+    for (CKDWORD i = 0; i < dir.entryCount; i++)
+    {
+        IcoEntry entry;
+        if (ICO_Entry(dir, i, entry) != 0)
+            continue;
+
+        // Lower is better: size distance (a larger entry wins a tie, as it
+        // scales down better), then depth distance (going over costs more)
+        CKDWORD extent = (entry.width > entry.height) ? entry.width : entry.height;
+        CKDWORD sizeScore;
+        if (size == 0)
+            sizeScore = 0xFFFF - extent;
+        else
+            sizeScore = (extent >= size) ? (extent - size) * 2 : (size - extent) * 2 + 1;
+        CKDWORD depthScore;
+        if (bitDepth == 0)
+            depthScore = 0xFFFF - entry.bitDepth;
+        else
+            depthScore = (entry.bitDepth <= bitDepth) ? bitDepth - entry.bitDepth : 0x10000 + entry.bitDepth - bitDepth;
+
+        unsigned long long score = ((unsigned long long)sizeScore << 32) | depthScore;
+        if (best == dir.entryCount || score < bestScore)
+        {
+            best = i;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+//=============================================================================
+// Entry Decoding
+//=============================================================================
+int ICO_ReadEntry(const IcoDirectory &dir, CKDWORD i, CKBitmapProperties *props)
+{
+    if (!props)
+        return CKBITMAPERROR_GENERIC;
+
+    IcoEntry entry;
+    int result = ICO_Entry(dir, i, entry);
+    if (result != 0)
+        return result;
+
+    const CKBYTE *image = dir.data + entry.offset;
+    if (!entry.png)
+        return BMP_ReadIconDib(image, entry.size, props);
+
+    // A PNG's dimensions say nothing about its compressed size, so they are
+    // checked against the directory (256 stands for 256 or more) and against
+    // what deflate can expand the entry to before PNG_Read allocates
+    PngImageInfo info;
+    result = PNG_ReadInfo(image, entry.size, info);
+    if (result != 0)
+        return result;
+    if ((entry.width < 256 ? info.width != entry.width : info.width < 256) ||
+        (entry.height < 256 ? info.height != entry.height : info.height < 256))
+        return CKBITMAPERROR_FILECORRUPTED;
+    unsigned long long rowSize = ((unsigned long long)info.width * PngBitsPerPixel(info.bitDepth, info.colorType) + 7) / 8 + 1;
+    if (rowSize * info.height > (unsigned long long)entry.size * 1032)
+        return CKBITMAPERROR_FILECORRUPTED;
+    return PNG_Read((void *)image, (int)entry.size, props);
+}
+
+//=============================================================================
+// IcoReader Class Implementation
+//=============================================================================
+IcoReader::IcoReader() : ImageReader(), m_PreferredSize(0), m_PreferredBitDepth(0)
+{
+    m_Properties.Init(ICOREADER_GUID, "ico");
+}
+
+IcoReader::IcoReader(const CKGUID &guid, const char *ext) : ImageReader(), m_PreferredSize(0), m_PreferredBitDepth(0)
+{
+    m_Properties.Init(guid, ext);
+}
+
+IcoReader::~IcoReader()
+{
+    FreeBitmapData(&m_Properties);
+}
+
+CKPluginInfo *IcoReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_ICO];
+}
+
+int IcoReader::GetOptionsCount() { return 0; }
+
+CKSTRING IcoReader::GetOptionDescription(int i) { return ""; }
+
+void IcoReader::SetPreferredEntry(CKDWORD size, CKDWORD bitDepth)
+{
+    m_PreferredSize = size;
+    m_PreferredBitDepth = bitDepth;
+}
+
+CKDWORD IcoReader::GetPreferredSize() { return m_PreferredSize; }
+
+CKDWORD IcoReader::GetPreferredBitDepth() { return m_PreferredBitDepth; }
+
+int IcoReader::ReadFile(CKSTRING filename, CKBitmapProperties **bp)
+{
+    if (!filename || !bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_ICO, (void *)filename, 0, (CKBitmapProperties *)&m_Properties, 0);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int IcoReader::ReadMemory(void *memory, int size, CKBitmapProperties **bp)
+{
+    if (!bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_ICO, memory, size, (CKBitmapProperties *)&m_Properties, 0);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int IcoReader::ReadOwnFormat(void *data, int size, CKBitmapProperties *props)
+{
+    return ICO_Read(data, size, props, m_PreferredSize, m_PreferredBitDepth);
+}
+
+//=============================================================================
+// CurReader Class Implementation
+//=============================================================================
+CurReader::CurReader() : IcoReader(CURREADER_GUID, "cur")
+{
+}
+
+CKPluginInfo *CurReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_CUR];
+}
+
+//=============================================================================
+// ICO_Read - Core Reading Function
+//=============================================================================
+int ICO_Read(void *data, int size, CKBitmapProperties *props, CKDWORD preferredSize, CKDWORD preferredBitDepth)
+{
+    if (!data || !props)
+        return CKBITMAPERROR_GENERIC;
+    if (size < 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // Files are mapped so the entry is decoded straight from the mapping
+    ImageFileMap fileMap;
+    if (size == 0)
+    {
+        if (!fileMap.Open((const char *)data))
+            return CKBITMAPERROR_READERROR;
+        data = (void *)fileMap.Data();
+        size = (int)fileMap.Size();
+    }
+
+    IcoDirectory dir;
+    int result = ICO_Index(data, size, dir);
+    if (result != 0)
+        return result;
+    CKDWORD best = ICO_BestEntry(dir, preferredSize, preferredBitDepth);
+    if (best == dir.entryCount)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    result = ICO_ReadEntry(dir, best, props);
+    if (result != 0)
+        return result;
+
+    if (props->m_Size == sizeof(IcoBitmapProperties))
+    {
+        ((IcoBitmapProperties *)props)->m_EntryCount = dir.entryCount;
+        ((IcoBitmapProperties *)props)->m_EntryIndex = best;
+    }
+    return 0;
+}
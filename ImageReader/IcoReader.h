@@ -0,0 +1,125 @@
+#ifndef ICOREADER_H
+#define ICOREADER_H
+
+#include "ImageReader.h"
+
+// ICO and CUR Reader GUIDs
+#define ICOREADER_GUID CKGUID(0x4E8B1C27, 0x1D6A93F5)
+#define CURREADER_GUID CKGUID(0x5C2D7E93, 0x3A91B06E)
+
+/**
+ * IcoReader - Windows icon (ICO) reader
+ *
+ *   - Picks the directory entry closest to a preferred size and bit depth
+ *     (by default the largest and deepest) and decodes only that entry
+ *   - DIB entries are decoded by BMP_ReadIconDib, with the AND mask as alpha;
+ *     PNG entries by PNG_Read, both in place on the entry's bytes
+ *   - The directory and the chosen entry are validated against the file size
+ *     before anything is allocated
+ *   - Always decoded to BGRA32
+ *   - Read-only: SaveFile and SaveMemory return 0
+ */
+class IcoReader : public ImageReader
+{
+public:
+    IcoReader();
+    virtual ~IcoReader();
+
+    virtual CKPluginInfo *GetReaderInfo();
+    virtual int GetOptionsCount();
+    virtual CKSTRING GetOptionDescription(int i);
+
+    virtual int ReadFile(CKSTRING filename, CKBitmapProperties **bp);
+    virtual int ReadMemory(void *memory, int size, CKBitmapProperties **bp);
+
+    // Entry picked by ReadFile/ReadMemory: size in pixels (0 = largest) and
+    // bits per pixel (0 = deepest); see ICO_BestEntry
+    void SetPreferredEntry(CKDWORD size, CKDWORD bitDepth);
+    CKDWORD GetPreferredSize();
+    CKDWORD GetPreferredBitDepth();
+
+protected:
+    IcoReader(const CKGUID &guid, const char *ext);
+
+    virtual int ReadOwnFormat(void *data, int size, CKBitmapProperties *props);
+
+private:
+    IcoBitmapProperties m_Properties;
+    CKDWORD m_PreferredSize;
+    CKDWORD m_PreferredBitDepth;
+};
+
+/**
+ * CurReader - Windows cursor (CUR) reader
+ *
+ * Same file layout as ICO; the directory holds hotspots instead of plane
+ * and bit counts.
+ */
+class CurReader : public IcoReader
+{
+public:
+    CurReader();
+
+    virtual CKPluginInfo *GetReaderInfo();
+};
+
+//=============================================================================
+// ICO file format
+//=============================================================================
+#define ICO_HEADER_SIZE 6
+#define ICO_ENTRY_SIZE 16
+
+// Resource types
+#define ICO_TYPE_ICON 1
+#define ICO_TYPE_CURSOR 2
+
+// Smallest entry whose image header gives the bit depth (PNG up to the IHDR
+// color type; a DIB header is shorter)
+#define ICO_MIN_ENTRY_SIZE 26
+
+// Directory of an ICO or CUR file. The file bytes are referenced, not copied,
+// and must stay valid while entries are read.
+struct IcoDirectory
+{
+    const CKBYTE *data;
+    CKDWORD size;
+    CKDWORD type;
+    CKDWORD entryCount;
+};
+
+struct IcoEntry
+{
+    CKDWORD width;    // from the directory, 0 stored as 256
+    CKDWORD height;   // from the directory, 0 stored as 256
+    CKDWORD bitDepth; // bits per pixel, from the image's own header
+    CKDWORD hotspotX; // cursors only
+    CKDWORD hotspotY; // cursors only
+    CKDWORD offset;
+    CKDWORD size;
+    CKBOOL png;
+};
+
+//=============================================================================
+// Internal helper functions
+//=============================================================================
+
+// Validates the header and that the entry table lies inside the file
+int ICO_Index(const void *data, int size, IcoDirectory &dir);
+
+// Reads directory entry i; fails if the image does not lie inside the file
+int ICO_Entry(const IcoDirectory &dir, CKDWORD i, IcoEntry &entry);
+
+// Index of the valid entry closest to size pixels (larger preferred on ties),
+// then closest to bitDepth without going over it. 0 asks for the largest size
+// or the deepest entry. The first of equal entries wins. Returns
+// dir.entryCount if no entry is valid.
+CKDWORD ICO_BestEntry(const IcoDirectory &dir, CKDWORD size, CKDWORD bitDepth);
+
+// Decodes entry i to BGRA32
+int ICO_ReadEntry(const IcoDirectory &dir, CKDWORD i, CKBitmapProperties *props);
+
+// Core ICO/CUR read function: decodes the best entry (size == 0 means data is a filename)
+int ICO_Read(void *data, int size, CKBitmapProperties *props, CKDWORD preferredSize = 0,
+             CKDWORD preferredBitDepth = 0);
+
+#endif // ICOREADER_H
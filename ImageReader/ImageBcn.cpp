@@ -0,0 +1,880 @@
+#include "ImageBcn.h"
+#include "ImageSimd.h"
+#include "ImageThreadPool.h"
+
+#include <string.h>
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+//=============================================================================
+// Block Sizes
+//=============================================================================
+CKDWORD ImageBlockBytes(CKDWORD format)
+{
+    switch (format)
+    {
+    case IMAGE_BLOCK_BC1:
+    case IMAGE_BLOCK_BC4:
+    case IMAGE_BLOCK_BC4_SNORM:
+        return 8;
+    case IMAGE_BLOCK_BC2:
+    case IMAGE_BLOCK_BC3:
+    case IMAGE_BLOCK_BC5:
+    case IMAGE_BLOCK_BC6H:
+    case IMAGE_BLOCK_BC7:
+    case IMAGE_BLOCK_BC5_SNORM:
+    case IMAGE_BLOCK_BC6H_SF16:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+uint64_t ImageBlockLevelSize(CKDWORD format, CKDWORD width, CKDWORD height)
+{
+    uint64_t blocksWide = ((uint64_t)width + 3) / 4;
+    uint64_t blocksHigh = ((uint64_t)height + 3) / 4;
+    return blocksWide * blocksHigh * ImageBlockBytes(format);
+}
+
+uint64_t ImageBlockChainSize(CKDWORD format, CKDWORD width, CKDWORD height, CKDWORD levels)
+{
+    uint64_t total = 0;
+    for (CKDWORD i = 0; i < levels; i++)
+    {
+        total += ImageBlockLevelSize(format, width, height);
+        width = (width > 1) ? width / 2 : 1;
+        height = (height > 1) ? height / 2 : 1;
+    }
+    return total;
+}
+
+//=============================================================================
+// Bit Reading (BC6H and BC7 pack their fields LSB first over 128 bits)
+//=============================================================================
+struct BlockBits
+{
+    unsigned long long lo;
+    unsigned long long hi;
+    CKDWORD pos;
+
+    explicit BlockBits(const CKBYTE *block) : pos(0)
+    {
+        lo = 0;
+        hi = 0;
+        for (int i = 7; i >= 0; i--)
+        {
+            lo = (lo << 8) | block[i];
+            hi = (hi << 8) | block[8 + i];
+        }
+    }
+
+    // count <= 16; reads past the end return 0
+    CKDWORD Get(CKDWORD count)
+    {
+        unsigned long long value;
+        if (pos >= 128)
+            value = 0;
+        else if (pos >= 64)
+            value = hi >> (pos - 64);
+        else if (pos + count <= 64)
+            value = lo >> pos;
+        else
+            value = (lo >> pos) | (hi << (64 - pos));
+        pos += count;
+        return (CKDWORD)value & ((1u << count) - 1);
+    }
+};
+
+static CKDWORD PackBGRA(int r, int g, int b, int a)
+{
+    return (CKDWORD)b | ((CKDWORD)g << 8) | ((CKDWORD)r << 16) | ((CKDWORD)a << 24);
+}
+
+//=============================================================================
+// BC1 to BC5
+//=============================================================================
+typedef void (*ColorLookupFn)(const CKDWORD palette[4], const CKBYTE *indices, CKDWORD *out);
+
+static void ColorLookupScalar(const CKDWORD palette[4], const CKBYTE *indices, CKDWORD *out)
+{
+    for (int row = 0; row < 4; row++)
+    {
+        CKDWORD bits = indices[row];
+        for (int x = 0; x < 4; x++)
+            out[row * 4 + x] = palette[(bits >> (x * 2)) & 3];
+    }
+}
+
+// pshufb control for one index byte: pixel x takes palette entry (bits >> 2x) & 3
+#define BCN_SHUFFLE_PIXEL(e) (CKBYTE)((e) * 4), (CKBYTE)((e) * 4 + 1), (CKBYTE)((e) * 4 + 2), (CKBYTE)((e) * 4 + 3)
+#define BCN_SHUFFLE(v)                                                                                        \
+    BCN_SHUFFLE_PIXEL((v) & 3), BCN_SHUFFLE_PIXEL(((v) >> 2) & 3), BCN_SHUFFLE_PIXEL(((v) >> 4) & 3),         \
+        BCN_SHUFFLE_PIXEL(((v) >> 6) & 3)
+#define BCN_SHUFFLE4(v) BCN_SHUFFLE(v), BCN_SHUFFLE((v) + 1), BCN_SHUFFLE((v) + 2), BCN_SHUFFLE((v) + 3)
+#define BCN_SHUFFLE16(v) BCN_SHUFFLE4(v), BCN_SHUFFLE4((v) + 4), BCN_SHUFFLE4((v) + 8), BCN_SHUFFLE4((v) + 12)
+#define BCN_SHUFFLE64(v) BCN_SHUFFLE16(v), BCN_SHUFFLE16((v) + 16), BCN_SHUFFLE16((v) + 32), BCN_SHUFFLE16((v) + 48)
+
+static const CKBYTE s_ColorShuffle[256 * 16] = {BCN_SHUFFLE64(0), BCN_SHUFFLE64(64), BCN_SHUFFLE64(128),
+                                                BCN_SHUFFLE64(192)};
+
+IMAGE_TARGET_SSSE3 static void ColorLookupSSSE3(const CKDWORD palette[4], const CKBYTE *indices, CKDWORD *out)
+{
+    // The four palette colors fill one register; each row is one shuffle
+    __m128i colors = _mm_loadu_si128((const __m128i *)palette);
+    for (int row = 0; row < 4; row++)
+    {
+        __m128i control = _mm_loadu_si128((const __m128i *)(s_ColorShuffle + indices[row] * 16));
+        _mm_storeu_si128((__m128i *)(out + row * 4), _mm_shuffle_epi8(colors, control));
+    }
+}
+
+static ColorLookupFn SelectColorLookup()
+{
+    if (ImageCpuHas(IMAGE_CPU_SSSE3))
+        return ColorLookupSSSE3;
+    return ColorLookupScalar;
+}
+
+static void Expand565(CKDWORD c, int &r, int &g, int &b)
+{
+    r = (c >> 11) & 0x1F;
+    g = (c >> 5) & 0x3F;
+    b = c & 0x1F;
+    r = (r << 3) | (r >> 2);
+    g = (g << 2) | (g >> 4);
+    b = (b << 3) | (b >> 2);
+}
+
+// BC2 and BC3 always use four colors; BC1 switches to three colors and
+// transparent black when the first endpoint is not greater
+static void DecodeColorBlock(const CKBYTE *block, CKBOOL fourColors, ColorLookupFn lookup, CKDWORD *out)
+{
+    CKDWORD c0 = block[0] | (block[1] << 8);
+    CKDWORD c1 = block[2] | (block[3] << 8);
+    int r0, g0, b0, r1, g1, b1;
+    Expand565(c0, r0, g0, b0);
+    Expand565(c1, r1, g1, b1);
+
+    CKDWORD palette[4];
+    palette[0] = PackBGRA(r0, g0, b0, 255);
+    palette[1] = PackBGRA(r1, g1, b1, 255);
+    if (fourColors || c0 > c1)
+    {
+        palette[2] = PackBGRA((2 * r0 + r1) / 3, (2 * g0 + g1) / 3, (2 * b0 + b1) / 3, 255);
+        palette[3] = PackBGRA((r0 + 2 * r1) / 3, (g0 + 2 * g1) / 3, (b0 + 2 * b1) / 3, 255);
+    }
+    else
+    {
+        palette[2] = PackBGRA((r0 + r1) / 2, (g0 + g1) / 2, (b0 + b1) / 2, 255);
+        palette[3] = 0;
+    }
+    lookup(palette, block + 4, out);
+}
+
+// The 8 values of a BC3/BC4/BC5 channel: 6 interpolated values when the
+// first endpoint is greater, otherwise 4 and the two extremes
+static void BuildAlphaPalette(int a0, int a1, int lowest, int highest, int palette[8])
+{
+    palette[0] = a0;
+    palette[1] = a1;
+    if (a0 > a1)
+    {
+        for (int i = 1; i < 7; i++)
+            palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+    }
+    else
+    {
+        for (int i = 1; i < 5; i++)
+            palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+        palette[6] = lowest;
+        palette[7] = highest;
+    }
+}
+
+// Decodes the 16 3-bit indices of an 8-byte channel block to 0..255
+static void DecodeAlphaBlock(const CKBYTE *block, CKBOOL snorm, CKBYTE *out)
+{
+    int palette[8];
+    if (snorm)
+    {
+        // -128 is an alias of -127; the range maps to 0..255
+        int a0 = (signed char)block[0];
+        int a1 = (signed char)block[1];
+        if (a0 < -127)
+            a0 = -127;
+        if (a1 < -127)
+            a1 = -127;
+        BuildAlphaPalette(a0, a1, -127, 127, palette);
+        for (int i = 0; i < 8; i++)
+            palette[i] = ((palette[i] + 127) * 255 + 127) / 254;
+    }
+    else
+    {
+        BuildAlphaPalette(block[0], block[1], 0, 255, palette);
+    }
+
+    // Two groups of eight 3-bit indices, 24 bits each
+    for (int half = 0; half < 2; half++)
+    {
+        const CKBYTE *bits = block + 2 + half * 3;
+        CKDWORD indices = bits[0] | (bits[1] << 8) | (bits[2] << 16);
+        for (int i = 0; i < 8; i++)
+            out[half * 8 + i] = (CKBYTE)palette[(indices >> (i * 3)) & 7];
+    }
+}
+
+static void DecodeBC1(const CKBYTE *block, ColorLookupFn lookup, CKDWORD *out)
+{
+    DecodeColorBlock(block, FALSE, lookup, out);
+}
+
+static void DecodeBC2(const CKBYTE *block, ColorLookupFn lookup, CKDWORD *out)
+{
+    DecodeColorBlock(block + 8, TRUE, lookup, out);
+    for (int i = 0; i < 16; i++)
+    {
+        CKDWORD alpha = (block[i / 2] >> ((i & 1) * 4)) & 0xF;
+        out[i] = (out[i] & 0x00FFFFFF) | ((alpha * 17) << 24);
+    }
+}
+
+static void DecodeBC3(const CKBYTE *block, ColorLookupFn lookup, CKDWORD *out)
+{
+    CKBYTE alpha[16];
+    DecodeAlphaBlock(block, FALSE, alpha);
+    DecodeColorBlock(block + 8, TRUE, lookup, out);
+    for (int i = 0; i < 16; i++)
+        out[i] = (out[i] & 0x00FFFFFF) | ((CKDWORD)alpha[i] << 24);
+}
+
+static void DecodeBC4(const CKBYTE *block, CKBOOL snorm, CKDWORD *out)
+{
+    CKBYTE gray[16];
+    DecodeAlphaBlock(block, snorm, gray);
+    for (int i = 0; i < 16; i++)
+        out[i] = gray[i] * 0x00010101u | 0xFF000000u;
+}
+
+static void DecodeBC5(const CKBYTE *block, CKBOOL snorm, CKDWORD *out)
+{
+    CKBYTE red[16], green[16];
+    DecodeAlphaBlock(block, snorm, red);
+    DecodeAlphaBlock(block + 8, snorm, green);
+    for (int i = 0; i < 16; i++)
+        out[i] = PackBGRA(red[i], green[i], 0, 255);
+}
+
+//=============================================================================
+// Partition Tables (shared by BC6H and BC7)
+//=============================================================================
+
+// 2-subset partitions: bit i set when pixel i is in subset 1
+static const CKWORD s_Partitions2[64] = {
+    0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8,
+    0xFF00, 0xFFF0, 0xF000, 0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110,
+    0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C, 0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696,
+    0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660, 0x0272, 0x04E4, 0x4E40, 0x2720,
+    0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+};
+
+// 3-subset partitions: the subset of each pixel
+static const CKBYTE s_Partitions3[64][16] = {
+    {0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2}, {0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1}, {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2}, {0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2},
+    {0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1}, {0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2}, {0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2},
+    {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2},
+    {0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2}, {0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2},
+    {0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2}, {0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0},
+    {0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2}, {0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0},
+    {0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2}, {0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1},
+    {0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2}, {0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2}, {0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0},
+    {0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0}, {0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2},
+    {0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0}, {0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1},
+    {0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2}, {0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2},
+    {0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1}, {0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2}, {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1},
+    {0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2}, {0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0},
+    {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0}, {0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0},
+    {0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0}, {0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1},
+    {0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1}, {0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1}, {0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2},
+    {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1}, {0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1},
+    {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1}, {0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1},
+    {0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2}, {0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1},
+    {0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2}, {0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2},
+    {0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2}, {0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2},
+    {0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2}, {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2},
+    {0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2},
+    {0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2}, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2},
+    {0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1}, {0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2},
+    {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0},
+};
+
+// Anchor pixels (whose index drops its top bit) of subset 1 in 2-subset
+// partitions, and of subsets 1 and 2 in 3-subset partitions; pixel 0 is
+// always the anchor of subset 0
+static const CKBYTE s_Anchors2[64] = {
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 2,  8,  2,  2,  8,
+    8,  15, 2,  8,  2,  2,  8,  8,  2,  2,  15, 15, 6,  8,  2,  8,  15, 15, 2,  8,  2,  2,
+    2,  15, 15, 6,  6,  2,  6,  8,  15, 15, 2,  2,  15, 15, 15, 15, 15, 2,  2,  15,
+};
+
+static const CKBYTE s_Anchors3a[64] = {
+    3,  3,  15, 15, 8,  3,  15, 15, 8,  8,  6,  6,  6,  5,  3,  3, 3, 3,  8,  15, 3,  3,
+    6,  10, 5,  8,  8,  6,  8,  5,  15, 15, 8,  15, 3,  5,  6,  10, 8, 15, 15, 3,  15, 5,
+    15, 15, 15, 15, 3,  15, 5,  5,  5,  8,  5,  10, 5,  10, 8,  13, 15, 12, 3,  3,
+};
+
+static const CKBYTE s_Anchors3b[64] = {
+    15, 8,  8,  3,  15, 15, 3,  8,  15, 15, 15, 15, 15, 15, 15, 8,  15, 8,  15, 3,  15, 8,
+    15, 8,  3,  15, 6,  10, 15, 15, 10, 8,  15, 3,  15, 10, 10, 8,  9,  10, 6,  15, 8,  15,
+    3,  6,  6,  8,  15, 3,  15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3,  15, 15, 8,
+};
+
+// Interpolation weights for 2, 3 and 4-bit indices (out of 64)
+static const CKBYTE s_Weights2[4] = {0, 21, 43, 64};
+static const CKBYTE s_Weights3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+static const CKBYTE s_Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+static const CKBYTE *WeightTable(CKDWORD indexBits)
+{
+    return (indexBits == 2) ? s_Weights2 : (indexBits == 3) ? s_Weights3 : s_Weights4;
+}
+
+static int Interpolate(int e0, int e1, int weight)
+{
+    return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+}
+
+//=============================================================================
+// BC7
+//=============================================================================
+struct Bc7Mode
+{
+    CKBYTE subsets;
+    CKBYTE partitionBits;
+    CKBYTE rotationBits;
+    CKBYTE selectorBits;
+    CKBYTE colorBits;
+    CKBYTE alphaBits;
+    CKBYTE endpointPBits; // one P-bit per endpoint
+    CKBYTE sharedPBits;   // one P-bit per subset
+    CKBYTE indexBits;
+    CKBYTE index2Bits;
+};
+
+static const Bc7Mode s_Bc7Modes[8] = {
+    {3, 4, 0, 0, 4, 0, 1, 0, 3, 0}, {2, 6, 0, 0, 6, 0, 0, 1, 3, 0}, {3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+    {2, 6, 0, 0, 7, 0, 1, 0, 2, 0}, {1, 0, 2, 1, 5, 6, 0, 0, 2, 3}, {1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+    {1, 0, 0, 0, 7, 7, 1, 0, 4, 0}, {2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+};
+
+static CKDWORD Subset(CKDWORD subsets, CKDWORD partition, int pixel)
+{
+    if (subsets == 2)
+        return (s_Partitions2[partition] >> pixel) & 1;
+    if (subsets == 3)
+        return s_Partitions3[partition][pixel];
+    return 0;
+}
+
+static CKBOOL IsAnchor(CKDWORD subsets, CKDWORD partition, int pixel)
+{
+    if (pixel == 0)
+        return TRUE;
+    if (subsets == 2)
+        return pixel == s_Anchors2[partition];
+    if (subsets == 3)
+        return pixel == s_Anchors3a[partition] || pixel == s_Anchors3b[partition];
+    return FALSE;
+}
+
+static void DecodeBC7(const CKBYTE *block, CKDWORD *out)
+{
+    // The mode is the position of the lowest set bit; a zero first byte
+    // is reserved and decodes to transparent black
+    if (block[0] == 0)
+    {
+        memset(out, 0, 16 * sizeof(CKDWORD));
+        return;
+    }
+    CKDWORD modeIndex = ImageLowestBit(block[0]);
+    const Bc7Mode &mode = s_Bc7Modes[modeIndex];
+    BlockBits bits(block);
+    bits.pos = modeIndex + 1;
+
+    CKDWORD partition = bits.Get(mode.partitionBits);
+    CKDWORD rotation = bits.Get(mode.rotationBits);
+    CKDWORD selector = bits.Get(mode.selectorBits);
+
+    int endpoints[6][4];
+    int endpointCount = mode.subsets * 2;
+    for (int c = 0; c < 3; c++)
+        for (int e = 0; e < endpointCount; e++)
+            endpoints[e][c] = (int)bits.Get(mode.colorBits);
+    for (int e = 0; e < endpointCount; e++)
+        endpoints[e][3] = mode.alphaBits ? (int)bits.Get(mode.alphaBits) : 255;
+
+    int colorBits = mode.colorBits;
+    int alphaBits = mode.alphaBits;
+    if (mode.endpointPBits || mode.sharedPBits)
+    {
+        // The P-bit is the low bit of every channel of its endpoint
+        int pbits[6];
+        for (int e = 0; e < endpointCount; e++)
+        {
+            if (mode.endpointPBits || e % 2 == 0)
+                pbits[e] = (int)bits.Get(1);
+            else
+                pbits[e] = pbits[e - 1]; // shared by the two endpoints of a subset
+        }
+        int channels = alphaBits ? 4 : 3;
+        for (int e = 0; e < endpointCount; e++)
+            for (int c = 0; c < channels; c++)
+                endpoints[e][c] = (endpoints[e][c] << 1) | pbits[e];
+        colorBits++;
+        if (alphaBits)
+            alphaBits++;
+    }
+
+    // Widen to 8 bits by replicating the top bits
+    for (int e = 0; e < endpointCount; e++)
+    {
+        for (int c = 0; c < 3; c++)
+            endpoints[e][c] = (endpoints[e][c] << (8 - colorBits)) | (endpoints[e][c] >> (2 * colorBits - 8));
+        if (alphaBits)
+            endpoints[e][3] = (endpoints[e][3] << (8 - alphaBits)) | (endpoints[e][3] >> (2 * alphaBits - 8));
+    }
+
+    CKBYTE indices[16], indices2[16];
+    for (int i = 0; i < 16; i++)
+        indices[i] = (CKBYTE)bits.Get(mode.indexBits - (IsAnchor(mode.subsets, partition, i) ? 1 : 0));
+    if (mode.index2Bits)
+    {
+        for (int i = 0; i < 16; i++)
+            indices2[i] = (CKBYTE)bits.Get(mode.index2Bits - (i == 0 ? 1 : 0));
+    }
+
+    for (int i = 0; i < 16; i++)
+    {
+        CKDWORD s = Subset(mode.subsets, partition, i);
+        const int *e0 = endpoints[s * 2];
+        const int *e1 = endpoints[s * 2 + 1];
+
+        int colorWeight, alphaWeight;
+        if (!mode.index2Bits)
+        {
+            colorWeight = WeightTable(mode.indexBits)[indices[i]];
+            alphaWeight = colorWeight;
+        }
+        else if (selector)
+        {
+            colorWeight = WeightTable(mode.index2Bits)[indices2[i]];
+            alphaWeight = WeightTable(mode.indexBits)[indices[i]];
+        }
+        else
+        {
+            colorWeight = WeightTable(mode.indexBits)[indices[i]];
+            alphaWeight = WeightTable(mode.index2Bits)[indices2[i]];
+        }
+
+        int rgba[4];
+        for (int c = 0; c < 3; c++)
+            rgba[c] = Interpolate(e0[c], e1[c], colorWeight);
+        rgba[3] = Interpolate(e0[3], e1[3], alphaWeight);
+
+        // Rotation swaps alpha with red, green or blue
+        if (rotation)
+        {
+            int t = rgba[3];
+            rgba[3] = rgba[rotation - 1];
+            rgba[rotation - 1] = t;
+        }
+        out[i] = PackBGRA(rgba[0], rgba[1], rgba[2], rgba[3]);
+    }
+}
+
+//=============================================================================
+// BC6H
+//=============================================================================
+
+// Endpoint fields: w and x are the endpoints of subset 0, y and z of subset 1
+#define BC6_RW 0
+#define BC6_GW 1
+#define BC6_BW 2
+#define BC6_RX 3
+#define BC6_GX 4
+#define BC6_BX 5
+#define BC6_RY 6
+#define BC6_GY 7
+#define BC6_BY 8
+#define BC6_RZ 9
+#define BC6_GZ 10
+#define BC6_BZ 11
+#define BC6_D 12 // partition
+
+// count bits read into a field, starting at bit shift
+struct Bc6Segment
+{
+    CKBYTE field;
+    CKBYTE shift;
+    CKBYTE count;
+};
+
+struct Bc6Mode
+{
+    CKBYTE regions;
+    CKBYTE transformed; // x, y and z are deltas from w
+    CKBYTE precision;   // endpoint bits
+    CKBYTE deltaBits[3];
+    Bc6Segment segments[25]; // ends with count 0
+};
+
+#define BC6_DESCENDING6(field) {field, 15, 1}, {field, 14, 1}, {field, 13, 1}, {field, 12, 1}, {field, 11, 1}, {field, 10, 1}
+
+static const Bc6Mode s_Bc6Modes[14] = {
+    {2, 1, 10, {5, 5, 5}, {{BC6_GY, 4, 1}, {BC6_BY, 4, 1}, {BC6_BZ, 4, 1}, {BC6_RW, 0, 10}, {BC6_GW, 0, 10},
+                           {BC6_BW, 0, 10}, {BC6_RX, 0, 5}, {BC6_GZ, 4, 1}, {BC6_GY, 0, 4}, {BC6_GX, 0, 5},
+                           {BC6_BZ, 0, 1}, {BC6_GZ, 0, 4}, {BC6_BX, 0, 5}, {BC6_BZ, 1, 1}, {BC6_BY, 0, 4},
+                           {BC6_RY, 0, 5}, {BC6_BZ, 2, 1}, {BC6_RZ, 0, 5}, {BC6_BZ, 3, 1}, {BC6_D, 0, 5}}},
+    {2, 1, 7, {6, 6, 6}, {{BC6_GY, 5, 1}, {BC6_GZ, 4, 1}, {BC6_GZ, 5, 1}, {BC6_RW, 0, 7}, {BC6_BZ, 0, 1},
+                          {BC6_BZ, 1, 1}, {BC6_BY, 4, 1}, {BC6_GW, 0, 7}, {BC6_BY, 5, 1}, {BC6_BZ, 2, 1},
+                          {BC6_GY, 4, 1}, {BC6_BW, 0, 7}, {BC6_BZ, 3, 1}, {BC6_BZ, 5, 1}, {BC6_BZ, 4, 1},
+                          {BC6_RX, 0, 6}, {BC6_GY, 0, 4}, {BC6_GX, 0, 6}, {BC6_GZ, 0, 4}, {BC6_BX, 0, 6},
+                          {BC6_BY, 0, 4}, {BC6_RY, 0, 6}, {BC6_RZ, 0, 6}, {BC6_D, 0, 5}}},
+    {2, 1, 11, {5, 4, 4}, {{BC6_RW, 0, 10}, {BC6_GW, 0, 10}, {BC6_BW, 0, 10}, {BC6_RX, 0, 5}, {BC6_RW, 10, 1},
+                           {BC6_GY, 0, 4}, {BC6_GX, 0, 4}, {BC6_GW, 10, 1}, {BC6_BZ, 0, 1}, {BC6_GZ, 0, 4},
+                           {BC6_BX, 0, 4}, {BC6_BW, 10, 1}, {BC6_BZ, 1, 1}, {BC6_BY, 0, 4}, {BC6_RY, 0, 5},
+                           {BC6_BZ, 2, 1}, {BC6_RZ, 0, 5}, {BC6_BZ, 3, 1}, {BC6_D, 0, 5}}},
+    {2, 1, 11, {4, 5, 4}, {{BC6_RW, 0, 10}, {BC6_GW, 0, 10}, {BC6_BW, 0, 10}, {BC6_RX, 0, 4}, {BC6_RW, 10, 1},
+                           {BC6_GZ, 4, 1}, {BC6_GY, 0, 4}, {BC6_GX, 0, 5}, {BC6_GW, 10, 1}, {BC6_GZ, 0, 4},
+                           {BC6_BX, 0, 4}, {BC6_BW, 10, 1}, {BC6_BZ, 1, 1}, {BC6_BY, 0, 4}, {BC6_RY, 0, 4},
+                           {BC6_BZ, 0, 1}, {BC6_BZ, 2, 1}, {BC6_RZ, 0, 4}, {BC6_GY, 4, 1}, {BC6_BZ, 3, 1},
+                           {BC6_D, 0, 5}}},
+    {2, 1, 11, {4, 4, 5}, {{BC6_RW, 0, 10}, {BC6_GW, 0, 10}, {BC6_BW, 0, 10}, {BC6_RX, 0, 4}, {BC6_RW, 10, 1},
+                           {BC6_BY, 4, 1}, {BC6_GY, 0, 4}, {BC6_GX, 0, 4}, {BC6_GW, 10, 1}, {BC6_BZ, 0, 1},
+                           {BC6_GZ, 0, 4}, {BC6_BX, 0, 5}, {BC6_BW, 10, 1}, {BC6_BY, 0, 4}, {BC6_RY, 0, 4},
+                           {BC6_BZ, 1, 1}, {BC6_BZ, 2, 1}, {BC6_RZ, 0, 4}, {BC6_BZ, 4, 1}, {BC6_BZ, 3, 1},
+                           {BC6_D, 0, 5}}},
+    {2, 1, 9, {5, 5, 5}, {{BC6_RW, 0, 9}, {BC6_BY, 4, 1}, {BC6_GW, 0, 9}, {BC6_GY, 4, 1}, {BC6_BW, 0, 9},
+                          {BC6_BZ, 4, 1}, {BC6_RX, 0, 5}, {BC6_GZ, 4, 1}, {BC6_GY, 0, 4}, {BC6_GX, 0, 5},
+                          {BC6_BZ, 0, 1}, {BC6_GZ, 0, 4}, {BC6_BX, 0, 5}, {BC6_BZ, 1, 1}, {BC6_BY, 0, 4},
+                          {BC6_RY, 0, 5}, {BC6_BZ, 2, 1}, {BC6_RZ, 0, 5}, {BC6_BZ, 3, 1}, {BC6_D, 0, 5}}},
+    {2, 1, 8, {6, 5, 5}, {{BC6_RW, 0, 8}, {BC6_GZ, 4, 1}, {BC6_BY, 4, 1}, {BC6_GW, 0, 8}, {BC6_BZ, 2, 1},
+                          {BC6_GY, 4, 1}, {BC6_BW, 0, 8}, {BC6_BZ, 3, 1}, {BC6_BZ, 4, 1}, {BC6_RX, 0, 6},
+                          {BC6_GY, 0, 4}, {BC6_GX, 0, 5}, {BC6_BZ, 0, 1}, {BC6_GZ, 0, 4}, {BC6_BX, 0, 5},
+                          {BC6_BZ, 1, 1}, {BC6_BY, 0, 4}, {BC6_RY, 0, 6}, {BC6_RZ, 0, 6}, {BC6_D, 0, 5}}},
+    {2, 1, 8, {5, 6, 5}, {{BC6_RW, 0, 8}, {BC6_BZ, 0, 1}, {BC6_BY, 4, 1}, {BC6_GW, 0, 8}, {BC6_GY, 5, 1},
+                          {BC6_GY, 4, 1}, {BC6_BW, 0, 8}, {BC6_GZ, 5, 1}, {BC6_BZ, 4, 1}, {BC6_RX, 0, 5},
+                          {BC6_GZ, 4, 1}, {BC6_GY, 0, 4}, {BC6_GX, 0, 6}, {BC6_GZ, 0, 4}, {BC6_BX, 0, 5},
+                          {BC6_BZ, 1, 1}, {BC6_BY, 0, 4}, {BC6_RY, 0, 5}, {BC6_BZ, 2, 1}, {BC6_RZ, 0, 5},
+                          {BC6_BZ, 3, 1}, {BC6_D, 0, 5}}},
+    {2, 1, 8, {5, 5, 6}, {{BC6_RW, 0, 8}, {BC6_BZ, 1, 1}, {BC6_BY, 4, 1}, {BC6_GW, 0, 8}, {BC6_BY, 5, 1},
+                          {BC6_GY, 4, 1}, {BC6_BW, 0, 8}, {BC6_BZ, 5, 1}, {BC6_BZ, 4, 1}, {BC6_RX, 0, 5},
+                          {BC6_GZ, 4, 1}, {BC6_GY, 0, 4}, {BC6_GX, 0, 5}, {BC6_BZ, 0, 1}, {BC6_GZ, 0, 4},
+                          {BC6_BX, 0, 6}, {BC6_BY, 0, 4}, {BC6_RY, 0, 5}, {BC6_BZ, 2, 1}, {BC6_RZ, 0, 5},
+                          {BC6_BZ, 3, 1}, {BC6_D, 0, 5}}},
+    {2, 0, 6, {6, 6, 6}, {{BC6_RW, 0, 6}, {BC6_GZ, 4, 1}, {BC6_BZ, 0, 1}, {BC6_BZ, 1, 1}, {BC6_BY, 4, 1},
+                          {BC6_GW, 0, 6}, {BC6_GY, 5, 1}, {BC6_BY, 5, 1}, {BC6_BZ, 2, 1}, {BC6_GY, 4, 1},
+                          {BC6_BW, 0, 6}, {BC6_GZ, 5, 1}, {BC6_BZ, 3, 1}, {BC6_BZ, 5, 1}, {BC6_BZ, 4, 1},
+                          {BC6_RX, 0, 6}, {BC6_GY, 0, 4}, {BC6_GX, 0, 6}, {BC6_GZ, 0, 4}, {BC6_BX, 0, 6},
+                          {BC6_BY, 0, 4}, {BC6_RY, 0, 6}, {BC6_RZ, 0, 6}, {BC6_D, 0, 5}}},
+    {1, 0, 10, {10, 10, 10}, {{BC6_RW, 0, 10}, {BC6_GW, 0, 10}, {BC6_BW, 0, 10}, {BC6_RX, 0, 10}, {BC6_GX, 0, 10},
+                              {BC6_BX, 0, 10}}},
+    {1, 1, 11, {9, 9, 9}, {{BC6_RW, 0, 10}, {BC6_GW, 0, 10}, {BC6_BW, 0, 10}, {BC6_RX, 0, 9}, {BC6_RW, 10, 1},
+                           {BC6_GX, 0, 9}, {BC6_GW, 10, 1}, {BC6_BX, 0, 9}, {BC6_BW, 10, 1}}},
+    // The high bits of the last two modes are stored in reverse order
+    {1, 1, 12, {8, 8, 8}, {{BC6_RW, 0, 10}, {BC6_GW, 0, 10}, {BC6_BW, 0, 10}, {BC6_RX, 0, 8}, {BC6_RW, 11, 1},
+                           {BC6_RW, 10, 1}, {BC6_GX, 0, 8}, {BC6_GW, 11, 1}, {BC6_GW, 10, 1}, {BC6_BX, 0, 8},
+                           {BC6_BW, 11, 1}, {BC6_BW, 10, 1}}},
+    {1, 1, 16, {4, 4, 4}, {{BC6_RW, 0, 10}, {BC6_GW, 0, 10}, {BC6_BW, 0, 10}, {BC6_RX, 0, 4}, BC6_DESCENDING6(BC6_RW),
+                           {BC6_GX, 0, 4}, BC6_DESCENDING6(BC6_GW), {BC6_BX, 0, 4}, BC6_DESCENDING6(BC6_BW)}},
+};
+
+// Mode index for each 5-bit mode field (modes 0 and 1 use 2 bits); -1 is reserved
+static const signed char s_Bc6ModeCodes[32] = {
+    0, 1, 2, 10, 0, 1, 3, 11, 0, 1, 4, 12, 0, 1, 5, 13, 0, 1, 6, -1, 0, 1, 7, -1, 0, 1, 8, -1, 0, 1, 9, -1,
+};
+
+static int SignExtend(int value, int bits)
+{
+    int shift = 32 - bits;
+    return (int)((unsigned int)value << shift) >> shift;
+}
+
+static int Unquantize(int value, int bits, CKBOOL isSigned)
+{
+    if (!isSigned)
+    {
+        if (bits >= 15 || value == 0)
+            return value;
+        if (value == (1 << bits) - 1)
+            return 0xFFFF;
+        return ((value << 16) + 0x8000) >> bits;
+    }
+
+    if (bits >= 16)
+        return value;
+    CKBOOL negative = value < 0;
+    if (negative)
+        value = -value;
+    int result;
+    if (value == 0)
+        result = 0;
+    else if (value >= (1 << (bits - 1)) - 1)
+        result = 0x7FFF;
+    else
+        result = ((value << 15) + 0x4000) >> (bits - 1);
+    return negative ? -result : result;
+}
+
+// Scales an interpolated value to the half float range (31/64 of the
+// unsigned range, 31/32 of the signed one)
+static CKWORD FinishUnquantize(int value, CKBOOL isSigned)
+{
+    if (!isSigned)
+        return (CKWORD)((value * 31) >> 6);
+    if (value < 0)
+        return (CKWORD)(0x8000 | (((-value) * 31) >> 5));
+    return (CKWORD)((value * 31) >> 5);
+}
+
+static void DecodeBC6H(const CKBYTE *block, CKBOOL isSigned, CKWORD *out)
+{
+    BlockBits bits(block);
+    CKDWORD code = bits.Get(2);
+    if (code >= 2)
+        code |= bits.Get(3) << 2;
+    int modeIndex = s_Bc6ModeCodes[code];
+    if (modeIndex < 0)
+    {
+        // Reserved modes decode to black
+        for (int i = 0; i < 16; i++)
+        {
+            out[i * 4 + 0] = 0;
+            out[i * 4 + 1] = 0;
+            out[i * 4 + 2] = 0;
+            out[i * 4 + 3] = 0x3C00;
+        }
+        return;
+    }
+    const Bc6Mode &mode = s_Bc6Modes[modeIndex];
+
+    int fields[13];
+    memset(fields, 0, sizeof(fields));
+    for (const Bc6Segment *seg = mode.segments; seg->count; seg++)
+        fields[seg->field] |= (int)bits.Get(seg->count) << seg->shift;
+    CKDWORD partition = (CKDWORD)fields[BC6_D];
+
+    // endpoints[e][c]: e = w, x, y, z
+    int endpoints[4][3];
+    int endpointCount = mode.regions * 2;
+    int precision = mode.precision;
+    for (int c = 0; c < 3; c++)
+    {
+        int base = fields[BC6_RW + c];
+        if (isSigned)
+            base = SignExtend(base, precision);
+        endpoints[0][c] = base;
+        for (int e = 1; e < endpointCount; e++)
+        {
+            int value = fields[BC6_RW + e * 3 + c];
+            if (mode.transformed)
+            {
+                value = SignExtend(value, mode.deltaBits[c]);
+                value = (fields[BC6_RW + c] + value) & ((1 << precision) - 1);
+            }
+            if (isSigned)
+                value = SignExtend(value, precision);
+            endpoints[e][c] = value;
+        }
+    }
+    for (int e = 0; e < endpointCount; e++)
+        for (int c = 0; c < 3; c++)
+            endpoints[e][c] = Unquantize(endpoints[e][c], precision, isSigned);
+
+    CKDWORD indexBits = (mode.regions == 2) ? 3 : 4;
+    const CKBYTE *weights = WeightTable(indexBits);
+    for (int i = 0; i < 16; i++)
+    {
+        CKBOOL anchor = (i == 0) || (mode.regions == 2 && i == s_Anchors2[partition]);
+        CKDWORD index = bits.Get(indexBits - (anchor ? 1 : 0));
+        CKDWORD s = (mode.regions == 2) ? ((s_Partitions2[partition] >> i) & 1) : 0;
+        for (int c = 0; c < 3; c++)
+        {
+            int value = Interpolate(endpoints[s * 2][c], endpoints[s * 2 + 1][c], weights[index]);
+            out[i * 4 + c] = FinishUnquantize(value, isSigned);
+        }
+        out[i * 4 + 3] = 0x3C00;
+    }
+}
+
+//=============================================================================
+// Block Decoding
+//=============================================================================
+static void DecodeBlockBGRA(CKDWORD format, const CKBYTE *block, ColorLookupFn lookup, CKDWORD *out)
+{
+    switch (format)
+    {
+    case IMAGE_BLOCK_BC1:
+        DecodeBC1(block, lookup, out);
+        break;
+    case IMAGE_BLOCK_BC2:
+        DecodeBC2(block, lookup, out);
+        break;
+    case IMAGE_BLOCK_BC3:
+        DecodeBC3(block, lookup, out);
+        break;
+    case IMAGE_BLOCK_BC4:
+    case IMAGE_BLOCK_BC4_SNORM:
+        DecodeBC4(block, format == IMAGE_BLOCK_BC4_SNORM, out);
+        break;
+    case IMAGE_BLOCK_BC5:
+    case IMAGE_BLOCK_BC5_SNORM:
+        DecodeBC5(block, format == IMAGE_BLOCK_BC5_SNORM, out);
+        break;
+    case IMAGE_BLOCK_BC7:
+        DecodeBC7(block, out);
+        break;
+    default:
+        memset(out, 0, 16 * sizeof(CKDWORD));
+        break;
+    }
+}
+
+static CKBOOL IsHalfFormat(CKDWORD format)
+{
+    return format == IMAGE_BLOCK_BC6H || format == IMAGE_BLOCK_BC6H_SF16;
+}
+
+// RGBA halves to BGRA32, through float so that rounding matches ImageFloatTo8
+static void HalfToBGRA32(const CKWORD *src, float *floats, CKBYTE *dst, int count)
+{
+    ImageHalfToFloat(src, floats, count * 4);
+    ImageFloatTo8(floats, dst, count * 4);
+    for (int i = 0; i < count; i++)
+    {
+        CKBYTE t = dst[i * 4];
+        dst[i * 4] = dst[i * 4 + 2];
+        dst[i * 4 + 2] = t;
+    }
+}
+
+void ImageDecodeBlock(CKDWORD format, const CKBYTE *block, CKDWORD pixels[16])
+{
+    if (IsHalfFormat(format))
+    {
+        CKWORD halves[64];
+        float floats[64];
+        ImageDecodeBlockHalf(format, block, halves);
+        HalfToBGRA32(halves, floats, (CKBYTE *)pixels, 16);
+        return;
+    }
+    DecodeBlockBGRA(format, block, SelectColorLookup(), pixels);
+}
+
+void ImageDecodeBlockHalf(CKDWORD format, const CKBYTE *block, CKWORD pixels[64])
+{
+    DecodeBC6H(block, format == IMAGE_BLOCK_BC6H_SF16, pixels);
+}
+
+//=============================================================================
+// Level Decoding
+//=============================================================================
+struct BlockLevelJob
+{
+    CKDWORD format;
+    const CKBYTE *src;
+    CKDWORD width;
+    CKDWORD height;
+    CKDWORD blocksWide;
+    CKDWORD blockBytes;
+    CKBYTE *dst;
+    int dstStride;
+    CKBOOL toFloat;
+    ColorLookupFn lookup;
+};
+
+static void DecodeBlockRows(void *context, CKDWORD begin, CKDWORD end)
+{
+    const BlockLevelJob &job = *(const BlockLevelJob *)context;
+    CKDWORD pixelBytes = job.toFloat ? 16 : 4;
+
+    // A row of blocks is decoded to four full-width rows, then clipped
+    CKDWORD rowPixels = job.blocksWide * 4;
+    CKBYTE *rows = new CKBYTE[(size_t)rowPixels * 4 * pixelBytes];
+    CKWORD *halves = NULL;
+    float *floats = NULL;
+    if (IsHalfFormat(job.format))
+    {
+        halves = new CKWORD[(size_t)rowPixels * 4 * 4];
+        if (!job.toFloat)
+            floats = new float[(size_t)rowPixels * 4];
+    }
+
+    for (CKDWORD by = begin; by < end; by++)
+    {
+        const CKBYTE *block = job.src + (size_t)by * job.blocksWide * job.blockBytes;
+        for (CKDWORD bx = 0; bx < job.blocksWide; bx++, block += job.blockBytes)
+        {
+            if (halves)
+            {
+                CKWORD decoded[64];
+                DecodeBC6H(block, job.format == IMAGE_BLOCK_BC6H_SF16, decoded);
+                for (int y = 0; y < 4; y++)
+                    memcpy(halves + ((size_t)y * rowPixels + bx * 4) * 4, decoded + y * 16, 16 * sizeof(CKWORD));
+            }
+            else
+            {
+                CKDWORD decoded[16];
+                DecodeBlockBGRA(job.format, block, job.lookup, decoded);
+                for (int y = 0; y < 4; y++)
+                    memcpy(rows + ((size_t)y * rowPixels + bx * 4) * 4, decoded + y * 4, 16);
+            }
+        }
+
+        CKDWORD rowCount = job.height - by * 4;
+        if (rowCount > 4)
+            rowCount = 4;
+        for (CKDWORD y = 0; y < rowCount; y++)
+        {
+            CKBYTE *dstRow = job.dst + (size_t)(by * 4 + y) * job.dstStride;
+            if (!halves)
+                memcpy(dstRow, rows + (size_t)y * rowPixels * 4, (size_t)job.width * 4);
+            else if (job.toFloat)
+                ImageHalfToFloat(halves + (size_t)y * rowPixels * 4, (float *)dstRow, (int)job.width * 4);
+            else
+                HalfToBGRA32(halves + (size_t)y * rowPixels * 4, floats, dstRow, (int)job.width);
+        }
+    }
+
+    delete[] floats;
+    delete[] halves;
+    delete[] rows;
+}
+
+void ImageDecodeBlockLevel(CKDWORD format, const CKBYTE *src, CKDWORD width, CKDWORD height, CKBYTE *dst,
+                           int dstStride, CKBOOL toFloat)
+{
+    CKDWORD blockBytes = ImageBlockBytes(format);
+    if (!src || !dst || !blockBytes || width == 0 || height == 0)
+        return;
+
+    BlockLevelJob job;
+    job.format = format;
+    job.src = src;
+    job.width = width;
+    job.height = height;
+    job.blocksWide = (width + 3) / 4;
+    job.blockBytes = blockBytes;
+    job.dst = dst;
+    job.dstStride = dstStride;
+    job.toFloat = toFloat && IsHalfFormat(format);
+    job.lookup = SelectColorLookup();
+    ImageParallelFor((height + 3) / 4, 8, DecodeBlockRows, &job);
+}
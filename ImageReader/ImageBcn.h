@@ -0,0 +1,51 @@
+#ifndef IMAGEBCN_H
+#define IMAGEBCN_H
+
+#include "ImageReader.h"
+
+//=============================================================================
+// Block-compressed textures (BC1 to BC7)
+//
+// GPU formats store 4x4 pixel blocks of 8 or 16 bytes; levels are padded to
+// whole blocks. Readers normally pass the blocks through untouched
+// (IMAGE_READ_KEEP_BLOCKS); decoding is the fallback for consumers that only
+// take BGRA32. Block rows are decoded on the worker pool, and BC1 to BC5
+// expand their index bits with SSSE3 table shuffles.
+//=============================================================================
+
+// Block formats. BC4 and BC5 are decoded as gray and as red/green;
+// BC6H holds half floats (unsigned, or signed for SF16).
+#define IMAGE_BLOCK_NONE 0
+#define IMAGE_BLOCK_BC1 1
+#define IMAGE_BLOCK_BC2 2
+#define IMAGE_BLOCK_BC3 3
+#define IMAGE_BLOCK_BC4 4
+#define IMAGE_BLOCK_BC5 5
+#define IMAGE_BLOCK_BC6H 6
+#define IMAGE_BLOCK_BC7 7
+#define IMAGE_BLOCK_BC4_SNORM 8
+#define IMAGE_BLOCK_BC5_SNORM 9
+#define IMAGE_BLOCK_BC6H_SF16 10
+#define IMAGE_BLOCK_FORMAT_COUNT 11
+
+// Bytes per 4x4 block (8 or 16), 0 for IMAGE_BLOCK_NONE or unknown formats
+CKDWORD ImageBlockBytes(CKDWORD format);
+
+// Bytes of a width x height level, and of a chain of levels each half the
+// size of the previous one (rounded down, at least 1)
+uint64_t ImageBlockLevelSize(CKDWORD format, CKDWORD width, CKDWORD height);
+uint64_t ImageBlockChainSize(CKDWORD format, CKDWORD width, CKDWORD height, CKDWORD levels);
+
+// Decodes one block to 16 BGRA32 pixels, row by row. BC6H is clamped to 0..1
+// and rounded as ImageFloatTo8 does.
+void ImageDecodeBlock(CKDWORD format, const CKBYTE *block, CKDWORD pixels[16]);
+
+// Decodes one BC6H block to 16 RGBA pixels of half floats (alpha 1.0)
+void ImageDecodeBlockHalf(CKDWORD format, const CKBYTE *block, CKWORD pixels[64]);
+
+// Decodes a level to BGRA32 rows of dstStride bytes, or for BC6H with
+// toFloat to RGBA float (16 bytes per pixel)
+void ImageDecodeBlockLevel(CKDWORD format, const CKBYTE *src, CKDWORD width, CKDWORD height, CKBYTE *dst,
+                           int dstStride, CKBOOL toFloat);
+
+#endif // IMAGEBCN_H
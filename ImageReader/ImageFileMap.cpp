@@ -0,0 +1,56 @@
+#include "ImageFileMap.h"
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+ImageFileMap::ImageFileMap() : m_File(INVALID_HANDLE_VALUE), m_Mapping(NULL), m_Data(NULL), m_Size(0) {}
+
+ImageFileMap::~ImageFileMap()
+{
+    Close();
+}
+
+CKBOOL ImageFileMap::Open(const char *filename)
+{
+    Close();
+    if (!filename)
+        return FALSE;
+
+    m_File = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m_File == INVALID_HANDLE_VALUE)
+        return FALSE;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(m_File, &fileSize) || fileSize.QuadPart > 0x7FFFFFFF)
+    {
+        Close();
+        return FALSE;
+    }
+    m_Size = (CKDWORD)fileSize.QuadPart;
+    if (m_Size == 0)
+        return TRUE;
+
+    m_Mapping = CreateFileMappingA(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_Mapping)
+        m_Data = (const CKBYTE *)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!m_Data)
+    {
+        Close();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void ImageFileMap::Close()
+{
+    if (m_Data)
+        UnmapViewOfFile(m_Data);
+    if (m_Mapping)
+        CloseHandle(m_Mapping);
+    if (m_File != INVALID_HANDLE_VALUE)
+        CloseHandle(m_File);
+    m_File = INVALID_HANDLE_VALUE;
+    m_Mapping = NULL;
+    m_Data = NULL;
+    m_Size = 0;
+}
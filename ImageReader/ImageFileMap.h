@@ -0,0 +1,35 @@
+#ifndef IMAGEFILEMAP_H
+#define IMAGEFILEMAP_H
+
+#include "ImageReader.h"
+
+//=============================================================================
+// Read-only file mapping
+//
+// Maps a whole file into memory so readers can decode straight from it and
+// hand out sub-ranges (e.g. DCX pages) without copying.
+//=============================================================================
+class ImageFileMap
+{
+public:
+    ImageFileMap();
+    ~ImageFileMap();
+
+    // Maps the file; empty files open successfully with Data() == NULL
+    CKBOOL Open(const char *filename);
+    void Close();
+
+    const CKBYTE *Data() const { return m_Data; }
+    CKDWORD Size() const { return m_Size; }
+
+private:
+    void *m_File;
+    void *m_Mapping;
+    const CKBYTE *m_Data;
+    CKDWORD m_Size;
+
+    ImageFileMap(const ImageFileMap &);
+    ImageFileMap &operator=(const ImageFileMap &);
+};
+
+#endif // IMAGEFILEMAP_H
@@ -0,0 +1,563 @@
+#include "ImageInflate.h"
+#include "ImageThreadPool.h"
+
+//=============================================================================
+// Decode Tables
+//
+// Entry layout: [31..16] value, [15..8] op, [7..0] code bits to consume.
+// Codes up to the root width resolve in one lookup; longer codes point to a
+// subtable indexed by the bits that follow the root bits.
+//=============================================================================
+#define INFLATE_LITLEN_ROOT 10
+#define INFLATE_DIST_ROOT 8
+#define INFLATE_CODELEN_ROOT 7
+#define INFLATE_LITLEN_TABLE_SIZE 2048
+#define INFLATE_DIST_TABLE_SIZE 1024
+#define INFLATE_MAX_BITS 15
+
+#define OP_LITERAL 0x00  // value = byte (or code length symbol)
+#define OP_BASE 0x10     // | extra bits; value = length or distance base
+#define OP_INVALID 0x20  // unused code, or symbols 286/287 and 30/31
+#define OP_END 0x40      // end of block
+#define OP_SUBTABLE 0x80 // | subtable bits; value = subtable offset
+
+#define ENTRY(value, op, bits) (((CKDWORD)(value) << 16) | ((CKDWORD)(op) << 8) | (CKDWORD)(bits))
+
+enum InflateCodeKind
+{
+    INFLATE_CODE_LITLEN,
+    INFLATE_CODE_DIST,
+    INFLATE_CODE_CODELEN
+};
+
+static const CKWORD LengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                      35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const CKBYTE LengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                       3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const CKWORD DistBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                                    193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const CKBYTE DistExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                     6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// Table entry for a symbol, without the code bits
+static CKDWORD SymbolEntry(InflateCodeKind kind, CKDWORD symbol)
+{
+    if (kind == INFLATE_CODE_CODELEN)
+        return ENTRY(symbol, OP_LITERAL, 0);
+    if (kind == INFLATE_CODE_DIST)
+        return (symbol < 30) ? ENTRY(DistBase[symbol], OP_BASE | DistExtra[symbol], 0) : ENTRY(0, OP_INVALID, 0);
+    if (symbol < 256)
+        return ENTRY(symbol, OP_LITERAL, 0);
+    if (symbol == 256)
+        return ENTRY(0, OP_END, 0);
+    if (symbol < 286)
+        return ENTRY(LengthBase[symbol - 257], OP_BASE | LengthExtra[symbol - 257], 0);
+    return ENTRY(0, OP_INVALID, 0);
+}
+
+static CKDWORD ReverseBits(CKDWORD code, CKDWORD length)
+{
+    CKDWORD reversed = 0;
+    for (CKDWORD i = 0; i < length; i++)
+    {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+    return reversed;
+}
+
+// Builds the decode table of a canonical Huffman code from its code lengths.
+// Over-subscribed codes are rejected; incomplete codes only when they have a
+// single 1-bit code (allowed for distance codes).
+static CKBOOL BuildDecodeTable(const CKBYTE *lengths, CKDWORD count, InflateCodeKind kind, CKDWORD rootBits,
+                               CKDWORD *table, CKDWORD capacity)
+{
+    CKDWORD counts[INFLATE_MAX_BITS + 1];
+    memset(counts, 0, sizeof(counts));
+    for (CKDWORD s = 0; s < count; s++)
+        counts[lengths[s]]++;
+    counts[0] = 0;
+
+    CKDWORD maxLen = INFLATE_MAX_BITS;
+    while (maxLen > 0 && counts[maxLen] == 0)
+        maxLen--;
+
+    CKDWORD rootSize = 1u << rootBits;
+    if (maxLen == 0)
+    {
+        // No codes at all (e.g. a block without matches): every lookup fails
+        for (CKDWORD i = 0; i < rootSize; i++)
+            table[i] = ENTRY(0, OP_INVALID, 1);
+        return TRUE;
+    }
+
+    int left = 1;
+    for (CKDWORD len = 1; len <= INFLATE_MAX_BITS; len++)
+    {
+        left = (left << 1) - (int)counts[len];
+        if (left < 0)
+            return FALSE;
+    }
+    if (left > 0)
+    {
+        if (maxLen != 1)
+            return FALSE;
+        for (CKDWORD i = 0; i < rootSize; i++)
+            table[i] = ENTRY(0, OP_INVALID, 1);
+    }
+
+    // Symbols sorted by code length, then by value (canonical order)
+    CKWORD offsets[INFLATE_MAX_BITS + 2];
+    offsets[1] = 0;
+    for (CKDWORD len = 1; len <= INFLATE_MAX_BITS; len++)
+        offsets[len + 1] = (CKWORD)(offsets[len] + counts[len]);
+    CKWORD sorted[288];
+    for (CKDWORD s = 0; s < count; s++)
+        if (lengths[s])
+            sorted[offsets[lengths[s]]++] = (CKWORD)s;
+
+    CKDWORD remaining[INFLATE_MAX_BITS + 1];
+    memcpy(remaining, counts, sizeof(counts));
+
+    CKDWORD rootMask = rootSize - 1;
+    CKDWORD used = rootSize;
+    CKDWORD subPrefix = 0xFFFFFFFF;
+    CKDWORD subOffset = 0;
+    CKDWORD code = 0;
+    CKDWORD index = 0;
+    for (CKDWORD len = 1; len <= maxLen; len++, code <<= 1)
+    {
+        for (CKDWORD k = 0; k < counts[len]; k++, code++)
+        {
+            CKDWORD entry = SymbolEntry(kind, sorted[index++]);
+            CKDWORD reversed = ReverseBits(code, len);
+
+            if (len <= rootBits)
+            {
+                for (CKDWORD i = reversed; i < rootSize; i += 1u << len)
+                    table[i] = entry | len;
+            }
+            else
+            {
+                CKDWORD prefix = reversed & rootMask;
+                if (prefix != subPrefix)
+                {
+                    // Size the subtable for the codes that remain under this prefix
+                    CKDWORD subBits = len - rootBits;
+                    int subLeft = 1 << subBits;
+                    while (subBits + rootBits < maxLen)
+                    {
+                        subLeft -= (int)remaining[subBits + rootBits];
+                        if (subLeft <= 0)
+                            break;
+                        subBits++;
+                        subLeft <<= 1;
+                    }
+                    if (used + (1u << subBits) > capacity)
+                        return FALSE;
+                    subPrefix = prefix;
+                    subOffset = used;
+                    used += 1u << subBits;
+                    table[prefix] = ENTRY(subOffset, OP_SUBTABLE | subBits, rootBits);
+                }
+
+                CKDWORD subBits = (table[prefix] >> 8) & 0x7F;
+                for (CKDWORD i = reversed >> rootBits; i < (1u << subBits); i += 1u << (len - rootBits))
+                    table[subOffset + i] = entry | (len - rootBits);
+            }
+            remaining[len]--;
+        }
+    }
+    return TRUE;
+}
+
+struct InflateFixedTables
+{
+    CKDWORD litlen[1 << INFLATE_LITLEN_ROOT];
+    CKDWORD dist[1 << INFLATE_DIST_ROOT];
+};
+
+static InflateFixedTables s_FixedTables;
+static ImageOnce s_FixedTablesOnce = 0;
+
+static void BuildFixedTables()
+{
+    CKBYTE lengths[288];
+    memset(lengths, 8, 144);
+    memset(lengths + 144, 9, 112);
+    memset(lengths + 256, 7, 24);
+    memset(lengths + 280, 8, 8);
+    BuildDecodeTable(lengths, 288, INFLATE_CODE_LITLEN, INFLATE_LITLEN_ROOT, s_FixedTables.litlen,
+                     1 << INFLATE_LITLEN_ROOT);
+    memset(lengths, 5, 32);
+    BuildDecodeTable(lengths, 32, INFLATE_CODE_DIST, INFLATE_DIST_ROOT, s_FixedTables.dist, 1 << INFLATE_DIST_ROOT);
+}
+
+static const InflateFixedTables &GetFixedTables()
+{
+    ImageCallOnce(s_FixedTablesOnce, BuildFixedTables);
+    return s_FixedTables;
+}
+
+//=============================================================================
+// Bit Input
+//
+// bitbuf holds bitCount valid bits, LSB first. The fast refill loads 8 bytes
+// at once; the bits it places above bitCount are exactly the next input bytes,
+// so both refills can be mixed freely.
+//=============================================================================
+struct InflateState
+{
+    const CKBYTE *in;
+    const CKBYTE *inEnd;
+    CKBYTE *outStart;
+    CKBYTE *out;
+    CKBYTE *outEnd;
+    uint64_t bitbuf;
+    CKDWORD bitCount;
+    CKDWORD overrun; // zero bytes supplied past the end of the input
+    CKDWORD litlen[INFLATE_LITLEN_TABLE_SIZE];
+    CKDWORD dist[INFLATE_DIST_TABLE_SIZE];
+};
+
+static uint64_t Load64(const CKBYTE *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Requires at least 8 readable input bytes; leaves 56..63 bits
+static void RefillFast(InflateState &s)
+{
+    s.bitbuf |= Load64(s.in) << s.bitCount;
+    s.in += (63 - s.bitCount) >> 3;
+    s.bitCount |= 56;
+}
+
+// Byte-wise refill to at least 57 bits; reads past the end yield zero bytes
+static void RefillSlow(InflateState &s)
+{
+    while (s.bitCount <= 56)
+    {
+        CKDWORD byte = 0;
+        if (s.in < s.inEnd)
+            byte = *s.in++;
+        else
+            s.overrun++;
+        s.bitbuf |= (uint64_t)byte << s.bitCount;
+        s.bitCount += 8;
+    }
+}
+
+static void Refill(InflateState &s)
+{
+    if (s.inEnd - s.in >= 8)
+        RefillFast(s);
+    else
+        RefillSlow(s);
+}
+
+static CKDWORD PeekBits(const InflateState &s, CKDWORD n) { return (CKDWORD)s.bitbuf & ((1u << n) - 1); }
+
+static void DropBits(InflateState &s, CKDWORD n)
+{
+    s.bitbuf >>= n;
+    s.bitCount -= n;
+}
+
+static CKDWORD ReadBits(InflateState &s, CKDWORD n)
+{
+    CKDWORD v = PeekBits(s, n);
+    DropBits(s, n);
+    return v;
+}
+
+// Resolves one code (at least 15 bits must be buffered) and consumes its bits
+static CKDWORD DecodeSymbol(InflateState &s, const CKDWORD *table, CKDWORD rootBits)
+{
+    CKDWORD entry = table[PeekBits(s, rootBits)];
+    if (entry & (OP_SUBTABLE << 8))
+    {
+        DropBits(s, rootBits);
+        entry = table[(entry >> 16) + PeekBits(s, (entry >> 8) & 0x7F)];
+    }
+    DropBits(s, entry & 0xFF);
+    return entry;
+}
+
+// More zero bytes than a final partial code could need means the input ran out
+static CKBOOL IsTruncated(const InflateState &s) { return s.overrun > 8; }
+
+//=============================================================================
+// Block Decoding
+//=============================================================================
+static CKBOOL CopyStored(InflateState &s)
+{
+    // Return whole buffered bytes to the input, then copy LEN bytes
+    DropBits(s, s.bitCount & 7);
+    CKDWORD buffered = s.bitCount >> 3;
+    if (s.overrun > buffered)
+        return FALSE;
+    s.in -= buffered - s.overrun;
+    s.overrun = 0;
+    s.bitbuf = 0;
+    s.bitCount = 0;
+
+    if (s.inEnd - s.in < 4)
+        return FALSE;
+    CKDWORD len = s.in[0] | ((CKDWORD)s.in[1] << 8);
+    CKDWORD nlen = s.in[2] | ((CKDWORD)s.in[3] << 8);
+    s.in += 4;
+    if (len != (~nlen & 0xFFFF))
+        return FALSE;
+    if (len > (CKDWORD)(s.inEnd - s.in) || len > (CKDWORD)(s.outEnd - s.out))
+        return FALSE;
+    memcpy(s.out, s.in, len);
+    s.in += len;
+    s.out += len;
+    return TRUE;
+}
+
+static CKBOOL ReadDynamicTables(InflateState &s)
+{
+    static const CKBYTE CodeLengthOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+    Refill(s);
+    CKDWORD hlit = ReadBits(s, 5) + 257;
+    CKDWORD hdist = ReadBits(s, 5) + 1;
+    CKDWORD hclen = ReadBits(s, 4) + 4;
+    if (hlit > 286 || hdist > 30)
+        return FALSE;
+
+    CKBYTE codeLengths[19];
+    memset(codeLengths, 0, sizeof(codeLengths));
+    for (CKDWORD i = 0; i < hclen; i++)
+    {
+        if (s.bitCount < 3)
+            Refill(s);
+        codeLengths[CodeLengthOrder[i]] = (CKBYTE)ReadBits(s, 3);
+    }
+
+    CKDWORD codeTable[1 << INFLATE_CODELEN_ROOT];
+    if (!BuildDecodeTable(codeLengths, 19, INFLATE_CODE_CODELEN, INFLATE_CODELEN_ROOT, codeTable,
+                          1 << INFLATE_CODELEN_ROOT))
+        return FALSE;
+
+    CKBYTE lengths[286 + 30];
+    CKDWORD total = hlit + hdist;
+    CKDWORD n = 0;
+    while (n < total)
+    {
+        // 7 bits for the code plus up to 7 extra bits
+        if (s.bitCount < 14)
+            Refill(s);
+        CKDWORD entry = DecodeSymbol(s, codeTable, INFLATE_CODELEN_ROOT);
+        if ((entry >> 8) & 0xFF)
+            return FALSE;
+        CKDWORD symbol = entry >> 16;
+        if (symbol < 16)
+        {
+            lengths[n++] = (CKBYTE)symbol;
+            continue;
+        }
+
+        CKBYTE value = 0;
+        CKDWORD repeat;
+        if (symbol == 16)
+        {
+            if (n == 0)
+                return FALSE;
+            value = lengths[n - 1];
+            repeat = 3 + ReadBits(s, 2);
+        }
+        else if (symbol == 17)
+        {
+            repeat = 3 + ReadBits(s, 3);
+        }
+        else
+        {
+            repeat = 11 + ReadBits(s, 7);
+        }
+        if (repeat > total - n)
+            return FALSE;
+        memset(lengths + n, value, repeat);
+        n += repeat;
+    }
+    if (IsTruncated(s) || lengths[256] == 0)
+        return FALSE;
+
+    return BuildDecodeTable(lengths, hlit, INFLATE_CODE_LITLEN, INFLATE_LITLEN_ROOT, s.litlen,
+                            INFLATE_LITLEN_TABLE_SIZE) &&
+           BuildDecodeTable(lengths + hlit, hdist, INFLATE_CODE_DIST, INFLATE_DIST_ROOT, s.dist,
+                            INFLATE_DIST_TABLE_SIZE);
+}
+
+static void CopyMatch(CKBYTE *out, CKDWORD dist, CKDWORD len)
+{
+    const CKBYTE *from = out - dist;
+    for (CKDWORD i = 0; i < len; i++)
+        out[i] = from[i];
+}
+
+// Longest match plus the overshoot of 8-byte match copies
+#define INFLATE_FAST_OUT_MARGIN (258 + 8)
+
+static CKBOOL DecodeHuffmanBlock(InflateState &s, const CKDWORD *litlen, const CKDWORD *dist)
+{
+    for (;;)
+    {
+        // Fast path: 56+ bits cover literal/length code, extra bits, distance
+        // code and extra bits (15 + 5 + 15 + 13); no output bounds checks
+        while (s.inEnd - s.in >= 8 && s.outEnd - s.out >= INFLATE_FAST_OUT_MARGIN)
+        {
+            RefillFast(s);
+            CKDWORD entry = DecodeSymbol(s, litlen, INFLATE_LITLEN_ROOT);
+            CKDWORD op = (entry >> 8) & 0xFF;
+            if (op == OP_LITERAL)
+            {
+                *s.out++ = (CKBYTE)(entry >> 16);
+                // A second literal still fits in the buffered bits
+                entry = DecodeSymbol(s, litlen, INFLATE_LITLEN_ROOT);
+                op = (entry >> 8) & 0xFF;
+                if (op == OP_LITERAL)
+                {
+                    *s.out++ = (CKBYTE)(entry >> 16);
+                    continue;
+                }
+                if (s.bitCount < 48)
+                    Refill(s);
+            }
+            if (!(op & OP_BASE))
+                return op == OP_END;
+
+            CKDWORD len = (entry >> 16) + ReadBits(s, op & 0x0F);
+            entry = DecodeSymbol(s, dist, INFLATE_DIST_ROOT);
+            op = (entry >> 8) & 0xFF;
+            if (!(op & OP_BASE))
+                return FALSE;
+            CKDWORD distance = (entry >> 16) + ReadBits(s, op & 0x0F);
+            if (distance > (CKDWORD)(s.out - s.outStart))
+                return FALSE;
+
+            const CKBYTE *from = s.out - distance;
+            CKBYTE *end = s.out + len;
+            if (distance >= 8)
+            {
+                CKBYTE *to = s.out;
+                do
+                {
+                    memcpy(to, from, 8);
+                    to += 8;
+                    from += 8;
+                } while (to < end);
+            }
+            else if (distance == 1)
+            {
+                memset(s.out, s.out[-1], len);
+            }
+            else
+            {
+                CopyMatch(s.out, distance, len);
+            }
+            s.out = end;
+        }
+
+        // Slow path near the ends of the buffers
+        RefillSlow(s);
+        if (IsTruncated(s))
+            return FALSE;
+        CKDWORD entry = DecodeSymbol(s, litlen, INFLATE_LITLEN_ROOT);
+        CKDWORD op = (entry >> 8) & 0xFF;
+        if (op == OP_LITERAL)
+        {
+            if (s.out == s.outEnd)
+                return FALSE;
+            *s.out++ = (CKBYTE)(entry >> 16);
+            continue;
+        }
+        if (!(op & OP_BASE))
+            return op == OP_END;
+
+        CKDWORD len = (entry >> 16) + ReadBits(s, op & 0x0F);
+        entry = DecodeSymbol(s, dist, INFLATE_DIST_ROOT);
+        op = (entry >> 8) & 0xFF;
+        if (!(op & OP_BASE))
+            return FALSE;
+        CKDWORD distance = (entry >> 16) + ReadBits(s, op & 0x0F);
+        if (distance > (CKDWORD)(s.out - s.outStart) || len > (CKDWORD)(s.outEnd - s.out))
+            return FALSE;
+        CopyMatch(s.out, distance, len);
+        s.out += len;
+    }
+}
+
+//=============================================================================
+// Public Interface
+//=============================================================================
+CKBOOL ImageInflate(const CKBYTE *src, CKDWORD srcSize, CKBYTE *dst, CKDWORD dstSize, CKDWORD *written)
+{
+    if (written)
+        *written = 0;
+    if (!src || (!dst && dstSize > 0))
+        return FALSE;
+
+    InflateState *s = new InflateState;
+    s->in = src;
+    s->inEnd = src + srcSize;
+    s->outStart = dst;
+    s->out = dst;
+    s->outEnd = dst + dstSize;
+    s->bitbuf = 0;
+    s->bitCount = 0;
+    s->overrun = 0;
+
+    CKBOOL ok = TRUE;
+    CKBOOL final = FALSE;
+    while (ok && !final)
+    {
+        Refill(*s);
+        final = ReadBits(*s, 1);
+        CKDWORD type = ReadBits(*s, 2);
+        if (type == 0)
+        {
+            ok = CopyStored(*s);
+        }
+        else if (type == 1)
+        {
+            const InflateFixedTables &fixed = GetFixedTables();
+            ok = DecodeHuffmanBlock(*s, fixed.litlen, fixed.dist);
+        }
+        else if (type == 2)
+        {
+            ok = ReadDynamicTables(*s) && DecodeHuffmanBlock(*s, s->litlen, s->dist);
+        }
+        else
+        {
+            ok = FALSE;
+        }
+        // Every zero byte handed out past the end must still be unconsumed
+        if (ok && s->overrun * 8 > s->bitCount)
+            ok = FALSE;
+    }
+
+    if (written)
+        *written = (CKDWORD)(s->out - dst);
+    delete s;
+    return ok;
+}
+
+CKBOOL ImageZlibInflate(const CKBYTE *src, CKDWORD srcSize, CKBYTE *dst, CKDWORD dstSize, CKDWORD *written)
+{
+    if (written)
+        *written = 0;
+    if (!src || srcSize < 2)
+        return FALSE;
+
+    // CM = 8 (deflate), window <= 32K, no preset dictionary, valid check bits
+    CKDWORD cmf = src[0];
+    CKDWORD flg = src[1];
+    if ((cmf & 0x0F) != 8 || (cmf >> 4) > 7 || (flg & 0x20) || ((cmf << 8) | flg) % 31 != 0)
+        return FALSE;
+    return ImageInflate(src + 2, srcSize - 2, dst, dstSize, written);
+}
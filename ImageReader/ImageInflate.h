@@ -0,0 +1,24 @@
+#ifndef IMAGEINFLATE_H
+#define IMAGEINFLATE_H
+
+#include "ImageReader.h"
+
+//=============================================================================
+// Deflate decompression (RFC 1950/1951)
+//
+// One-shot decoder for streams whose decompressed size is known up front, as
+// in PNG images and TIFF/EXR blocks. Codes are resolved through two-level
+// lookup tables, and away from the buffer ends the inner loop refills a 64-bit
+// bit buffer once per symbol and copies matches 8 bytes at a time.
+//=============================================================================
+
+// Decompresses a raw deflate stream into dst, stopping at the end of the final
+// block. *written (optional) receives the number of bytes produced.
+// Returns FALSE on malformed or truncated input, or if dst is too small.
+CKBOOL ImageInflate(const CKBYTE *src, CKDWORD srcSize, CKBYTE *dst, CKDWORD dstSize, CKDWORD *written);
+
+// Same for a zlib stream (2-byte header, deflate data, Adler-32 trailer).
+// The checksum is not verified.
+CKBOOL ImageZlibInflate(const CKBYTE *src, CKDWORD srcSize, CKBYTE *dst, CKDWORD dstSize, CKDWORD *written);
+
+#endif // IMAGEINFLATE_H
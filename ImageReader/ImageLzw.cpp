@@ -0,0 +1,215 @@
+#include "ImageLzw.h"
+
+//=============================================================================
+// Bit Readers
+//
+// Codes are read from a 64-bit buffer. Away from the end of the input the
+// buffer is refilled with one unaligned 8-byte load: the bytes beyond the ones
+// consumed land where the next refill puts them again.
+//=============================================================================
+
+// GIF: codes LSB first, buffered from bit 0 up
+struct LzwBitReaderLsb
+{
+    const CKBYTE *ptr;
+    const CKBYTE *end;
+    uint64_t bits;
+    int count;
+
+    void Refill()
+    {
+        if (end - ptr >= 8)
+        {
+            uint64_t v;
+            memcpy(&v, ptr, 8);
+            bits |= v << count;
+            int bytes = (63 - count) >> 3;
+            ptr += bytes;
+            count += bytes * 8;
+            return;
+        }
+        while (count <= 56 && ptr < end)
+        {
+            bits |= (uint64_t)*ptr++ << count;
+            count += 8;
+        }
+    }
+
+    int Take(int width)
+    {
+        int code = (int)(bits & ((1u << width) - 1));
+        bits >>= width;
+        count -= width;
+        return code;
+    }
+};
+
+// TIFF: codes MSB first, buffered from bit 63 down
+struct LzwBitReaderMsb
+{
+    const CKBYTE *ptr;
+    const CKBYTE *end;
+    uint64_t bits;
+    int count;
+
+    void Refill()
+    {
+        if (end - ptr >= 8)
+        {
+            uint64_t v = 0;
+            for (int i = 0; i < 8; i++)
+                v = (v << 8) | ptr[i];
+            bits |= v >> count;
+            int bytes = (63 - count) >> 3;
+            ptr += bytes;
+            count += bytes * 8;
+            return;
+        }
+        while (count <= 56 && ptr < end)
+        {
+            bits |= (uint64_t)*ptr++ << (56 - count);
+            count += 8;
+        }
+    }
+
+    int Take(int width)
+    {
+        int code = (int)(bits >> (64 - width));
+        bits <<= width;
+        count -= width;
+        return code;
+    }
+};
+
+//=============================================================================
+// String Copies
+//=============================================================================
+
+// Copies a dictionary string to the end of the output. The string lies wholly
+// before dst, so it can be copied in 8-byte steps when there is room to spill
+// past its end: the extra bytes are overwritten by the strings that follow.
+static inline void CopyString(CKBYTE *dst, const CKBYTE *src, CKDWORD len, CKDWORD room)
+{
+    if (len + 7 <= room)
+    {
+        for (CKDWORD i = 0; i < len; i += 8)
+        {
+            uint64_t v;
+            memcpy(&v, src + i, 8);
+            memcpy(dst + i, &v, 8);
+        }
+        return;
+    }
+    memcpy(dst, src, len < room ? len : room);
+}
+
+//=============================================================================
+// Decoder
+//=============================================================================
+
+// earlyChange is 1 for TIFF, whose encoders widen the codes one code before
+// the table needs it
+template <class BitReader>
+static CKDWORD DecodeLzw(const CKBYTE *src, CKDWORD srcSize, int minCodeSize, int earlyChange, CKBYTE *dst,
+                         CKDWORD dstSize)
+{
+    // Strings of the codes above clear + 1: output position and length
+    CKDWORD offsets[IMAGE_LZW_MAX_CODES];
+    CKWORD lengths[IMAGE_LZW_MAX_CODES];
+
+    const int clearCode = 1 << minCodeSize;
+    const int endCode = clearCode + 1;
+    int width = minCodeSize + 1;
+    int next = clearCode + 2;
+
+    BitReader br;
+    br.ptr = src;
+    br.end = src + srcSize;
+    br.bits = 0;
+    br.count = 0;
+
+    // String of the previous code; 0 length right after a clear code
+    CKDWORD prevPos = 0;
+    CKDWORD prevLen = 0;
+    CKDWORD pos = 0;
+    while (pos < dstSize)
+    {
+        if (br.count < width)
+        {
+            br.Refill();
+            if (br.count < width)
+                break;
+        }
+        int code = br.Take(width);
+
+        CKDWORD room = dstSize - pos;
+        CKDWORD len;
+        if (code < clearCode)
+        {
+            dst[pos] = (CKBYTE)code;
+            len = 1;
+        }
+        else if (code == clearCode)
+        {
+            width = minCodeSize + 1;
+            next = clearCode + 2;
+            prevLen = 0;
+            continue;
+        }
+        else if (code == endCode)
+        {
+            break;
+        }
+        else if (code < next)
+        {
+            len = lengths[code];
+            CopyString(dst + pos, dst + offsets[code], len, room);
+        }
+        else if (code == next && prevLen != 0)
+        {
+            // Not in the table yet: the previous string plus its own first byte
+            len = prevLen + 1;
+            CKBYTE first = dst[prevPos];
+            CopyString(dst + pos, dst + prevPos, prevLen, room);
+            if (prevLen < room)
+                dst[pos + prevLen] = first;
+        }
+        else
+        {
+            break;
+        }
+
+        // The new entry is the previous string plus the first byte of this
+        // one, which was just written right after it
+        if (prevLen != 0 && next < IMAGE_LZW_MAX_CODES)
+        {
+            offsets[next] = prevPos;
+            lengths[next] = (CKWORD)(prevLen + 1);
+            next++;
+        }
+        // Widen as soon as the next code can be the one being added (checked
+        // after the first code too, which matters for minCodeSize 1)
+        if (next + earlyChange == (1 << width) && width < IMAGE_LZW_MAX_BITS)
+            width++;
+        if (len > room)
+            len = room;
+        prevPos = pos;
+        prevLen = len;
+        pos += len;
+    }
+    return pos;
+}
+
+CKDWORD ImageLzwDecode(const CKBYTE *src, CKDWORD srcSize, int minCodeSize, CKBYTE *dst, CKDWORD dstSize)
+{
+    if (!src || !dst || minCodeSize < 1 || minCodeSize > 8)
+        return 0;
+    return DecodeLzw<LzwBitReaderLsb>(src, srcSize, minCodeSize, 0, dst, dstSize);
+}
+
+CKDWORD ImageLzwDecodeTiff(const CKBYTE *src, CKDWORD srcSize, CKBYTE *dst, CKDWORD dstSize)
+{
+    if (!src || !dst)
+        return 0;
+    return DecodeLzw<LzwBitReaderMsb>(src, srcSize, 8, 1, dst, dstSize);
+}
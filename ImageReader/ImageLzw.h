@@ -0,0 +1,28 @@
+#ifndef IMAGELZW_H
+#define IMAGELZW_H
+
+#include "ImageReader.h"
+
+//=============================================================================
+// LZW decompression (GIF and TIFF flavors)
+//
+// Variable-width codes starting at minCodeSize + 1 bits and growing up to 12,
+// with clear and end-of-information codes. GIF packs codes LSB first; TIFF
+// packs them MSB first and widens one code early. Every dictionary
+// string is already present in the output, so the table stores where it was
+// last written and its length, and a code is emitted as one copy of the whole
+// string instead of by walking a prefix chain one symbol at a time.
+//=============================================================================
+
+#define IMAGE_LZW_MAX_BITS 12
+#define IMAGE_LZW_MAX_CODES (1 << IMAGE_LZW_MAX_BITS)
+
+// Decompresses the concatenated code bytes of an image into dst, stopping at
+// the end-of-information code, when dst is full, at the end of src, or at an
+// invalid code. minCodeSize is 1 to 8. Returns the number of bytes written.
+CKDWORD ImageLzwDecode(const CKBYTE *src, CKDWORD srcSize, int minCodeSize, CKBYTE *dst, CKDWORD dstSize);
+
+// Same for a TIFF strip or tile (8-bit literals, MSB first, early change)
+CKDWORD ImageLzwDecodeTiff(const CKBYTE *src, CKDWORD srcSize, CKBYTE *dst, CKDWORD dstSize);
+
+#endif // IMAGELZW_H
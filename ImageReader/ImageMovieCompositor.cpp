@@ -0,0 +1,195 @@
+#include "ImageMovieCompositor.h"
+
+//=============================================================================
+// Canvas Regions
+//=============================================================================
+
+// Copies a frame's region between the canvas and a tightly packed buffer
+static void CopyRegion(const ImageMovieRegion &region, CKBYTE *canvas, CKDWORD canvasStride, CKBYTE *buffer,
+                       CKBOOL toCanvas)
+{
+    CKDWORD rowSize = region.width * 4;
+    CKBYTE *row = canvas + region.y * canvasStride + region.x * 4;
+    for (CKDWORD y = 0; y < region.height; y++, row += canvasStride, buffer += rowSize)
+    {
+        if (toCanvas)
+            memcpy(row, buffer, rowSize);
+        else
+            memcpy(buffer, row, rowSize);
+    }
+}
+
+static void ClearRegion(const ImageMovieRegion &region, CKBYTE *canvas, CKDWORD canvasStride)
+{
+    CKBYTE *row = canvas + region.y * canvasStride + region.x * 4;
+    for (CKDWORD y = 0; y < region.height; y++, row += canvasStride)
+        memset(row, 0, region.width * 4);
+}
+
+//=============================================================================
+// ImageMovieCompositor Class Implementation
+//=============================================================================
+ImageMovieCompositor::ImageMovieCompositor()
+    : m_Context(NULL), m_Width(0), m_Height(0), m_FrameCount(0), m_Canvas(NULL), m_Saved(NULL),
+      m_FrameBuffer(NULL), m_PrefetchBuffer(NULL), m_CanvasFrame(-1), m_PrefetchFrame(-1), m_PrefetchResult(0),
+      m_PrefetchDecoded(0)
+{
+    memset(&m_Format, 0, sizeof(m_Format));
+}
+
+ImageMovieCompositor::~ImageMovieCompositor()
+{
+    Close();
+}
+
+void ImageMovieCompositor::Open(const ImageMovieFormat &format, void *context, CKDWORD width, CKDWORD height,
+                                CKDWORD frameCount, CKDWORD bufferSize)
+{
+    Close();
+    m_Format = format;
+    m_Context = context;
+    m_Width = width;
+    m_Height = height;
+    m_FrameCount = frameCount;
+
+    // Frame regions never exceed the canvas, so the saved region fits its size
+    CKDWORD canvasSize = width * height * 4;
+    m_Canvas = new CKBYTE[canvasSize];
+    m_Saved = new CKBYTE[canvasSize];
+    m_FrameBuffer = new CKBYTE[bufferSize];
+    m_PrefetchBuffer = new CKBYTE[bufferSize];
+    memset(m_Canvas, 0, canvasSize);
+}
+
+void ImageMovieCompositor::Close()
+{
+    // The prefetch task reads the format's data and writes its buffer
+    m_Worker.Wait();
+    m_PrefetchFrame = -1;
+
+    delete[] m_Canvas;
+    delete[] m_Saved;
+    delete[] m_FrameBuffer;
+    delete[] m_PrefetchBuffer;
+    m_Canvas = NULL;
+    m_Saved = NULL;
+    m_FrameBuffer = NULL;
+    m_PrefetchBuffer = NULL;
+    m_CanvasFrame = -1;
+    m_FrameCount = 0;
+}
+
+CKDWORD ImageMovieCompositor::RenderStart(CKDWORD f)
+{
+    // A frame can be drawn onto an empty canvas if the previous frame cleared
+    // the whole canvas, or if it replaces the whole canvas itself and does not
+    // need the covered pixels back later
+    CKDWORD start = f;
+    for (; start > 0; start--)
+    {
+        ImageMovieRegion prev, frame;
+        m_Format.region(m_Context, start - 1, prev);
+        m_Format.region(m_Context, start, frame);
+        if (prev.width == m_Width && prev.height == m_Height && prev.dispose == IMAGE_MOVIE_DISPOSE_BACKGROUND)
+            break;
+        if (frame.width == m_Width && frame.height == m_Height && frame.dispose != IMAGE_MOVIE_DISPOSE_PREVIOUS &&
+            m_Format.isOpaque(m_Context, start))
+            break;
+    }
+
+    // Carry on from the current canvas when that is shorter
+    if (m_CanvasFrame >= 0 && (CKDWORD)m_CanvasFrame < f && (CKDWORD)m_CanvasFrame + 1 > start)
+        return (CKDWORD)m_CanvasFrame + 1;
+    return start;
+}
+
+int ImageMovieCompositor::RenderFrame(CKDWORD f)
+{
+    CKDWORD stride = m_Width * 4;
+
+    // Dispose of the previous frame's region only when continuing the canvas
+    if (m_CanvasFrame >= 0 && (CKDWORD)m_CanvasFrame + 1 == f)
+    {
+        ImageMovieRegion prev;
+        m_Format.region(m_Context, f - 1, prev);
+        if (prev.dispose == IMAGE_MOVIE_DISPOSE_BACKGROUND)
+            ClearRegion(prev, m_Canvas, stride);
+        else if (prev.dispose == IMAGE_MOVIE_DISPOSE_PREVIOUS)
+            CopyRegion(prev, m_Canvas, stride, m_Saved, TRUE);
+    }
+    else
+    {
+        memset(m_Canvas, 0, stride * m_Height);
+    }
+    m_CanvasFrame = -1;
+
+    ImageMovieRegion frame;
+    m_Format.region(m_Context, f, frame);
+    if (frame.dispose == IMAGE_MOVIE_DISPOSE_PREVIOUS)
+        CopyRegion(frame, m_Canvas, stride, m_Saved, FALSE);
+
+    const CKBYTE *buffer = m_FrameBuffer;
+    CKDWORD decoded = 0;
+    if (m_PrefetchFrame == (int)f && m_PrefetchResult == 0)
+    {
+        buffer = m_PrefetchBuffer;
+        decoded = m_PrefetchDecoded;
+    }
+    else
+    {
+        int result = m_Format.decode(m_Context, f, m_FrameBuffer, decoded);
+        if (result != 0)
+            return result;
+    }
+    if (m_PrefetchFrame == (int)f)
+        m_PrefetchFrame = -1;
+
+    m_Format.draw(m_Context, f, buffer, decoded, m_Canvas, stride);
+    m_CanvasFrame = (int)f;
+    return 0;
+}
+
+void ImageMovieCompositor::PrefetchTask(void *context)
+{
+    ImageMovieCompositor *compositor = (ImageMovieCompositor *)context;
+    compositor->m_PrefetchResult =
+        compositor->m_Format.decode(compositor->m_Context, (CKDWORD)compositor->m_PrefetchFrame,
+                                    compositor->m_PrefetchBuffer, compositor->m_PrefetchDecoded);
+}
+
+void ImageMovieCompositor::StartPrefetch(CKDWORD f)
+{
+    if (m_PrefetchFrame == (int)f)
+        return;
+    m_PrefetchFrame = (int)f;
+    if (!m_Worker.Start(PrefetchTask, this))
+        m_PrefetchFrame = -1;
+}
+
+int ImageMovieCompositor::Render(CKDWORD f)
+{
+    if (!m_Canvas || f >= m_FrameCount)
+        return CKBITMAPERROR_GENERIC;
+
+    // The prefetched frame is either the one needed now or stale
+    m_Worker.Wait();
+
+    if (m_CanvasFrame != (int)f)
+    {
+        for (CKDWORD i = RenderStart(f); i <= f; i++)
+        {
+            int result = RenderFrame(i);
+            if (result != 0)
+            {
+                m_PrefetchFrame = -1;
+                return result;
+            }
+        }
+    }
+
+    // Playback wraps around to the first frame
+    CKDWORD next = (f + 1) % m_FrameCount;
+    if (next != f)
+        StartPrefetch(next);
+    return 0;
+}
@@ -0,0 +1,96 @@
+#ifndef IMAGEMOVIECOMPOSITOR_H
+#define IMAGEMOVIECOMPOSITOR_H
+
+#include "ImageThreadPool.h"
+
+//=============================================================================
+// Movie frame compositing
+//
+// Frames of an animation are drawn one after the other into a persistent
+// BGRA32 canvas. Each frame covers a region of the canvas that is disposed
+// of before the next frame is drawn. The format supplies the frame regions
+// and how a frame is decoded and drawn; the compositor keeps the canvas,
+// restores disposed regions and decodes the next frame in the background.
+//=============================================================================
+
+// Disposal, applied to a frame's region before the next frame is drawn
+#define IMAGE_MOVIE_DISPOSE_NONE 0
+#define IMAGE_MOVIE_DISPOSE_BACKGROUND 1 // cleared to transparent black
+#define IMAGE_MOVIE_DISPOSE_PREVIOUS 2   // restored to what it was before the frame
+
+// Region of a frame, inside the canvas
+struct ImageMovieRegion
+{
+    CKDWORD x;
+    CKDWORD y;
+    CKDWORD width;
+    CKDWORD height;
+    CKDWORD dispose; // IMAGE_MOVIE_DISPOSE_*
+};
+
+// Format-specific parts of a movie reader; context is passed to every call
+struct ImageMovieFormat
+{
+    void (*region)(void *context, CKDWORD frame, ImageMovieRegion &region);
+
+    // TRUE if drawing the frame replaces every pixel of its region, whatever
+    // was there before (the frame has no transparent or blended pixels)
+    CKBOOL (*isOpaque)(void *context, CKDWORD frame);
+
+    // Decodes a frame into buffer; decoded is passed on to draw. Also called
+    // on a background thread. Returns a CKBITMAPERROR_* code.
+    int (*decode)(void *context, CKDWORD frame, CKBYTE *buffer, CKDWORD &decoded);
+
+    void (*draw)(void *context, CKDWORD frame, const CKBYTE *buffer, CKDWORD decoded, CKBYTE *canvas,
+                 CKDWORD canvasStride);
+};
+
+class ImageMovieCompositor
+{
+public:
+    ImageMovieCompositor();
+    ~ImageMovieCompositor();
+
+    // Allocates a cleared canvas and two decode buffers of bufferSize bytes.
+    // The format's data must stay valid until Close.
+    void Open(const ImageMovieFormat &format, void *context, CKDWORD width, CKDWORD height, CKDWORD frameCount,
+              CKDWORD bufferSize);
+    // Waits for the background decode and frees the buffers
+    void Close();
+
+    // Composites frame f into the canvas, restarting from the nearest frame
+    // that fully redraws the canvas or carrying on from the current one, then
+    // starts decoding the next frame. Returns a CKBITMAPERROR_* code.
+    int Render(CKDWORD f);
+
+    CKBYTE *Canvas() const { return m_Canvas; }
+
+private:
+    // Start of the shortest run of frames that renders frame f
+    CKDWORD RenderStart(CKDWORD f);
+    int RenderFrame(CKDWORD f);
+    void StartPrefetch(CKDWORD f);
+
+    static void PrefetchTask(void *context);
+
+    ImageMovieFormat m_Format;
+    void *m_Context;
+    CKDWORD m_Width;
+    CKDWORD m_Height;
+    CKDWORD m_FrameCount;
+
+    CKBYTE *m_Canvas;
+    CKBYTE *m_Saved;          // region under a frame disposed with IMAGE_MOVIE_DISPOSE_PREVIOUS
+    CKBYTE *m_FrameBuffer;    // decoded frame being drawn
+    CKBYTE *m_PrefetchBuffer; // decoded m_PrefetchFrame
+    int m_CanvasFrame;        // last frame drawn into the canvas, -1 if none
+    int m_PrefetchFrame;      // frame held or being decoded in m_PrefetchBuffer, -1 if none
+    int m_PrefetchResult;
+    CKDWORD m_PrefetchDecoded;
+    ImageBackgroundWorker m_Worker;
+
+    ImageMovieCompositor(const ImageMovieCompositor &);
+    ImageMovieCompositor &operator=(const ImageMovieCompositor &);
+};
+
+#endif // IMAGEMOVIECOMPOSITOR_H
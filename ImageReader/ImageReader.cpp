@@ -3,6 +3,23 @@
 #include "BmpReader.h"
 #include "TgaReader.h"
 #include "PcxReader.h"
+#include "DcxReader.h"
+#include "QoiReader.h"
+#include "PngReader.h"
+#include "ApngReader.h"
+#include "JpegReader.h"
+#include "GifReader.h"
+#include "GifMovieReader.h"
+#include "IcoReader.h"
+#include "TiffReader.h"
+#include "HdrReader.h"
+#include "ExrReader.h"
+#include "WebpReader.h"
+#include "PnmReader.h"
+#include "FarbfeldReader.h"
+#include "DdsReader.h"
+#include "KtxReader.h"
+#include "ImageThreadPool.h"
 
 #ifdef CK_LIB
 #define RegisterBehaviorDeclarations Register_ImageReader_BehaviorDeclarations
@@ -25,11 +42,40 @@
 #define READER_INDEX_BMP 0
 #define READER_INDEX_TGA 1
 #define READER_INDEX_PCX 2
-#define READER_COUNT 3
+#define READER_INDEX_DCX 3
+#define READER_INDEX_QOI 4
+#define READER_INDEX_PNG 5
+#define READER_INDEX_APNG 6
+#define READER_INDEX_JPEG 7
+#define READER_INDEX_GIF 8
+#define READER_INDEX_GIF_MOVIE 9
+#define READER_INDEX_ICO 10
+#define READER_INDEX_CUR 11
+#define READER_INDEX_TIFF 12
+#define READER_INDEX_HDR 13
+#define READER_INDEX_EXR 14
+#define READER_INDEX_WEBP 15
+#define READER_INDEX_PNM 16
+#define READER_INDEX_PBM 17
+#define READER_INDEX_PGM 18
+#define READER_INDEX_PPM 19
+#define READER_INDEX_PAM 20
+#define READER_INDEX_FARBFELD 21
+#define READER_INDEX_DDS 22
+#define READER_INDEX_KTX 23
+#define READER_COUNT 24
 CKPluginInfo g_PluginInfo[READER_COUNT];
 
 #define READER_VERSION 0x00000001
 
+// Stops the worker pool shared by all readers before the plugin is unloaded;
+// its threads would otherwise outlive the code they run
+CKERROR ExitInstance(CKContext *context)
+{
+    ImageShutdownPool();
+    return CK_OK;
+}
+
 PLUGIN_EXPORT CKDataReader *CKGetReader(int pos)
 {
     // Return the appropriate reader based on index
@@ -42,6 +88,48 @@ PLUGIN_EXPORT CKDataReader *CKGetReader(int pos)
         return new TgaReader;
     case READER_INDEX_PCX:
         return new PcxReader;
+    case READER_INDEX_DCX:
+        return new DcxReader;
+    case READER_INDEX_QOI:
+        return new QoiReader;
+    case READER_INDEX_PNG:
+        return new PngReader;
+    case READER_INDEX_APNG:
+        return new ApngReader;
+    case READER_INDEX_JPEG:
+        return new JpegReader;
+    case READER_INDEX_GIF:
+        return new GifReader;
+    case READER_INDEX_GIF_MOVIE:
+        return new GifMovieReader;
+    case READER_INDEX_ICO:
+        return new IcoReader;
+    case READER_INDEX_CUR:
+        return new CurReader;
+    case READER_INDEX_TIFF:
+        return new TiffReader;
+    case READER_INDEX_HDR:
+        return new HdrReader;
+    case READER_INDEX_EXR:
+        return new ExrReader;
+    case READER_INDEX_WEBP:
+        return new WebpReader;
+    case READER_INDEX_PNM:
+        return new PnmReader;
+    case READER_INDEX_PBM:
+        return new PbmReader;
+    case READER_INDEX_PGM:
+        return new PgmReader;
+    case READER_INDEX_PPM:
+        return new PpmReader;
+    case READER_INDEX_PAM:
+        return new PamReader;
+    case READER_INDEX_FARBFELD:
+        return new FarbfeldReader;
+    case READER_INDEX_DDS:
+        return new DdsReader;
+    case READER_INDEX_KTX:
+        return new KtxReader;
     default:
         return NULL;
     }
@@ -61,7 +149,7 @@ PLUGIN_EXPORT CKPluginInfo *CKGetPluginInfo(int index)
     g_PluginInfo[0].m_Extension = "Bmp";
     g_PluginInfo[0].m_Author = "Virtools";
     g_PluginInfo[0].m_InitInstanceFct = NULL;
-    g_PluginInfo[0].m_ExitInstanceFct = NULL;
+    g_PluginInfo[0].m_ExitInstanceFct = ExitInstance;
     g_PluginInfo[0].m_Type = CKPLUGIN_BITMAP_READER;
 
     g_PluginInfo[1].m_GUID = TGAREADER_GUID;
@@ -84,5 +172,239 @@ PLUGIN_EXPORT CKPluginInfo *CKGetPluginInfo(int index)
     g_PluginInfo[2].m_ExitInstanceFct = NULL;
     g_PluginInfo[2].m_Type = CKPLUGIN_BITMAP_READER;
 
+    g_PluginInfo[3].m_GUID = DCXREADER_GUID;
+    g_PluginInfo[3].m_Version = READER_VERSION;
+    g_PluginInfo[3].m_Description = "ZSoft Multi-Page PCX";
+    g_PluginInfo[3].m_Summary = "DCX";
+    g_PluginInfo[3].m_Extension = "Dcx";
+    g_PluginInfo[3].m_Author = "Virtools";
+    g_PluginInfo[3].m_InitInstanceFct = NULL;
+    g_PluginInfo[3].m_ExitInstanceFct = NULL;
+    g_PluginInfo[3].m_Type = CKPLUGIN_BITMAP_READER;
+
+    g_PluginInfo[4].m_GUID = QOIREADER_GUID;
+    g_PluginInfo[4].m_Version = READER_VERSION;
+    g_PluginInfo[4].m_Description = "Quite OK Image";
+    g_PluginInfo[4].m_Summary = "QOI";
+    g_PluginInfo[4].m_Extension = "Qoi";
+    g_PluginInfo[4].m_Author = "Virtools";
+    g_PluginInfo[4].m_InitInstanceFct = NULL;
+    g_PluginInfo[4].m_ExitInstanceFct = NULL;
+    g_PluginInfo[4].m_Type = CKPLUGIN_BITMAP_READER;
+
+    g_PluginInfo[5].m_GUID = PNGREADER_GUID;
+    g_PluginInfo[5].m_Version = READER_VERSION;
+    g_PluginInfo[5].m_Description = "Portable Network Graphics";
+    g_PluginInfo[5].m_Summary = "PNG";
+    g_PluginInfo[5].m_Extension = "Png";
+    g_PluginInfo[5].m_Author = "Virtools";
+    g_PluginInfo[5].m_InitInstanceFct = NULL;
+    g_PluginInfo[5].m_ExitInstanceFct = NULL;
+    g_PluginInfo[5].m_Type = CKPLUGIN_BITMAP_READER;
+
+    g_PluginInfo[6].m_GUID = APNGREADER_GUID;
+    g_PluginInfo[6].m_Version = READER_VERSION;
+    g_PluginInfo[6].m_Description = "Animated PNG";
+    g_PluginInfo[6].m_Summary = "APNG";
+    g_PluginInfo[6].m_Extension = "Png";
+    g_PluginInfo[6].m_Author = "Virtools";
+    g_PluginInfo[6].m_InitInstanceFct = NULL;
+    g_PluginInfo[6].m_ExitInstanceFct = NULL;
+    g_PluginInfo[6].m_Type = CKPLUGIN_MOVIE_READER;
+
+    g_PluginInfo[7].m_GUID = JPEGREADER_GUID;
+    g_PluginInfo[7].m_Version = READER_VERSION;
+    g_PluginInfo[7].m_Description = "Joint Photographic Experts Group";
+    g_PluginInfo[7].m_Summary = "JPEG";
+    g_PluginInfo[7].m_Extension = "Jpg";
+    g_PluginInfo[7].m_Author = "Virtools";
+    g_PluginInfo[7].m_InitInstanceFct = NULL;
+    g_PluginInfo[7].m_ExitInstanceFct = NULL;
+    g_PluginInfo[7].m_Type = CKPLUGIN_BITMAP_READER;
+
+    g_PluginInfo[8].m_GUID = GIFREADER_GUID;
+    g_PluginInfo[8].m_Version = READER_VERSION;
+    g_PluginInfo[8].m_Description = "Graphics Interchange Format";
+    g_PluginInfo[8].m_Summary = "GIF";
+    g_PluginInfo[8].m_Extension = "Gif";
+    g_PluginInfo[8].m_Author = "Virtools";
+    g_PluginInfo[8].m_InitInstanceFct = NULL;
+    g_PluginInfo[8].m_ExitInstanceFct = NULL;
+    g_PluginInfo[8].m_Type = CKPLUGIN_BITMAP_READER;
+
+    g_PluginInfo[9].m_GUID = GIFMOVIEREADER_GUID;
+    g_PluginInfo[9].m_Version = READER_VERSION;
+    g_PluginInfo[9].m_Description = "Animated GIF";
+    g_PluginInfo[9].m_Summary = "Animated GIF";
+    g_PluginInfo[9].m_Extension = "Gif";
+    g_PluginInfo[9].m_Author = "Virtools";
+    g_PluginInfo[9].m_InitInstanceFct = NULL;
+    g_PluginInfo[9].m_ExitInstanceFct = NULL;
+    g_PluginInfo[9].m_Type = CKPLUGIN_MOVIE_READER;
+
+    g_PluginInfo[10].m_GUID = ICOREADER_GUID;
+    g_PluginInfo[10].m_Version = READER_VERSION;
+    g_PluginInfo[10].m_Description = "Windows Icon";
+    g_PluginInfo[10].m_Summary = "ICO";
+    g_PluginInfo[10].m_Extension = "Ico";
+    g_PluginInfo[10].m_Author = "Virtools";
+    g_PluginInfo[10].m_InitInstanceFct = NULL;
+    g_PluginInfo[10].m_ExitInstanceFct = NULL;
+    g_PluginInfo[10].m_Type = CKPLUGIN_BITMAP_READER;
+
+    g_PluginInfo[11].m_GUID = CURREADER_GUID;
+    g_PluginInfo[11].m_Version = READER_VERSION;
+    g_PluginInfo[11].m_Description = "Windows Cursor";
+    g_PluginInfo[11].m_Summary = "CUR";
+    g_PluginInfo[11].m_Extension = "Cur";
+    g_PluginInfo[11].m_Author = "Virtools";
+    g_PluginInfo[11].m_InitInstanceFct = NULL;
+    g_PluginInfo[11].m_ExitInstanceFct = NULL;
+    g_PluginInfo[11].m_Type = CKPLUGIN_BITMAP_READER;
+
+    g_PluginInfo[12].m_GUID = TIFFREADER_GUID;
+    g_PluginInfo[12].m_Version = READER_VERSION;
+    g_PluginInfo[12].m_Description = "Tagged Image File Format";
+    g_PluginInfo[12].m_Summary = "TIFF";
+    g_PluginInfo[12].m_Extension = "Tif";
+    g_PluginInfo[12].m_Author = "Virtools";
+    g_PluginInfo[12].m_InitInstanceFct = NULL;
+    g_PluginInfo[12].m_ExitInstanceFct = NULL;
+    g_PluginInfo[12].m_Type = CKPLUGIN_BITMAP_READER;
+
+    g_PluginInfo[13].m_GUID = HDRREADER_GUID;
+    g_PluginInfo[13].m_Version = READER_VERSION;
+    g_PluginInfo[13].m_Description = "Radiance HDR";
+    g_PluginInfo[13].m_Summary = "HDR";
+    g_PluginInfo[13].m_Extension = "Hdr";
+    g_PluginInfo[13].m_Author = "Virtools";
+    g_PluginInfo[13].m_InitInstanceFct = NULL;
+    g_PluginInfo[13].m_ExitInstanceFct = NULL;
+    g_PluginInfo[13].m_Type = CKPLUGIN_BITMAP_READER;
+
+    g_PluginInfo[14].m_GUID = EXRREADER_GUID;
+    g_PluginInfo[14].m_Version = READER_VERSION;
+    g_PluginInfo[14].m_Description = "OpenEXR";
+    g_PluginInfo[14].m_Summary = "EXR";
+    g_PluginInfo[14].m_Extension = "Exr";
+    g_PluginInfo[14].m_Author = "Virtools";
+    g_PluginInfo[14].m_InitInstanceFct = NULL;
+    g_PluginInfo[14].m_ExitInstanceFct = NULL;
+    g_PluginInfo[14].m_Type = CKPLUGIN_BITMAP_READER;
+
+    g_PluginInfo[15].m_GUID = WEBPREADER_GUID;
+    g_PluginInfo[15].m_Version = READER_VERSION;
+    g_PluginInfo[15].m_Description = "WebP";
+    g_PluginInfo[15].m_Summary = "WebP";
+    // CKFileExtension holds three characters, so "webp" cannot be registered
+    // whole; renamed or unmatched files are still read through sniffing
+    g_PluginInfo[15].m_Extension = "Web";
+    g_PluginInfo[15].m_Author = "Virtools";
+    g_PluginInfo[15].m_InitInstanceFct = NULL;
+    g_PluginInfo[15].m_ExitInstanceFct = NULL;
+    g_PluginInfo[15].m_Type = CKPLUGIN_BITMAP_READER;
+
+    g_PluginInfo[16].m_GUID = PNMREADER_GUID;
+    g_PluginInfo[16].m_Version = READER_VERSION;
+    g_PluginInfo[16].m_Description = "Portable Any Map";
+    g_PluginInfo[16].m_Summary = "PNM";
+    g_PluginInfo[16].m_Extension = "Pnm";
+    g_PluginInfo[16].m_Author = "Virtools";
+    g_PluginInfo[16].m_InitInstanceFct = NULL;
+    g_PluginInfo[16].m_ExitInstanceFct = NULL;
+    g_PluginInfo[16].m_Type = CKPLUGIN_BITMAP_READER;
+
+    g_PluginInfo[17].m_GUID = PBMREADER_GUID;
+    g_PluginInfo[17].m_Version = READER_VERSION;
+    g_PluginInfo[17].m_Description = "Portable Bitmap";
+    g_PluginInfo[17].m_Summary = "PBM";
+    g_PluginInfo[17].m_Extension = "Pbm";
+    g_PluginInfo[17].m_Author = "Virtools";
+    g_PluginInfo[17].m_InitInstanceFct = NULL;
+    g_PluginInfo[17].m_ExitInstanceFct = NULL;
+    g_PluginInfo[17].m_Type = CKPLUGIN_BITMAP_READER;
+
+    g_PluginInfo[18].m_GUID = PGMREADER_GUID;
+    g_PluginInfo[18].m_Version = READER_VERSION;
+    g_PluginInfo[18].m_Description = "Portable Graymap";
+    g_PluginInfo[18].m_Summary = "PGM";
+    g_PluginInfo[18].m_Extension = "Pgm";
+    g_PluginInfo[18].m_Author = "Virtools";
+    g_PluginInfo[18].m_InitInstanceFct = NULL;
+    g_PluginInfo[18].m_ExitInstanceFct = NULL;
+    g_PluginInfo[18].m_Type = CKPLUGIN_BITMAP_READER;
+
+    g_PluginInfo[19].m_GUID = PPMREADER_GUID;
+    g_PluginInfo[19].m_Version = READER_VERSION;
+    g_PluginInfo[19].m_Description = "Portable Pixmap";
+    g_PluginInfo[19].m_Summary = "PPM";
+    g_PluginInfo[19].m_Extension = "Ppm";
+    g_PluginInfo[19].m_Author = "Virtools";
+    g_PluginInfo[19].m_InitInstanceFct = NULL;
+    g_PluginInfo[19].m_ExitInstanceFct = NULL;
+    g_PluginInfo[19].m_Type = CKPLUGIN_BITMAP_READER;
+
+    g_PluginInfo[20].m_GUID = PAMREADER_GUID;
+    g_PluginInfo[20].m_Version = READER_VERSION;
+    g_PluginInfo[20].m_Description = "Portable Arbitrary Map";
+    g_PluginInfo[20].m_Summary = "PAM";
+    g_PluginInfo[20].m_Extension = "Pam";
+    g_PluginInfo[20].m_Author = "Virtools";
+    g_PluginInfo[20].m_InitInstanceFct = NULL;
+    g_PluginInfo[20].m_ExitInstanceFct = NULL;
+    g_PluginInfo[20].m_Type = CKPLUGIN_BITMAP_READER;
+
+    g_PluginInfo[21].m_GUID = FARBFELDREADER_GUID;
+    g_PluginInfo[21].m_Version = READER_VERSION;
+    g_PluginInfo[21].m_Description = "Farbfeld";
+    g_PluginInfo[21].m_Summary = "Farbfeld";
+    g_PluginInfo[21].m_Extension = "Ff";
+    g_PluginInfo[21].m_Author = "Virtools";
+    g_PluginInfo[21].m_InitInstanceFct = NULL;
+    g_PluginInfo[21].m_ExitInstanceFct = NULL;
+    g_PluginInfo[21].m_Type = CKPLUGIN_BITMAP_READER;
+
+    g_PluginInfo[22].m_GUID = DDSREADER_GUID;
+    g_PluginInfo[22].m_Version = READER_VERSION;
+    g_PluginInfo[22].m_Description = "DirectDraw Surface";
+    g_PluginInfo[22].m_Summary = "DDS";
+    g_PluginInfo[22].m_Extension = "Dds";
+    g_PluginInfo[22].m_Author = "Virtools";
+    g_PluginInfo[22].m_InitInstanceFct = NULL;
+    g_PluginInfo[22].m_ExitInstanceFct = NULL;
+    g_PluginInfo[22].m_Type = CKPLUGIN_BITMAP_READER;
+
+    g_PluginInfo[23].m_GUID = KTXREADER_GUID;
+    g_PluginInfo[23].m_Version = READER_VERSION;
+    g_PluginInfo[23].m_Description = "Khronos Texture";
+    g_PluginInfo[23].m_Summary = "KTX";
+    // Reads KTX 2 as well; "ktx2" does not fit in a CKFileExtension
+    g_PluginInfo[23].m_Extension = "Ktx";
+    g_PluginInfo[23].m_Author = "Virtools";
+    g_PluginInfo[23].m_InitInstanceFct = NULL;
+    g_PluginInfo[23].m_ExitInstanceFct = NULL;
+    g_PluginInfo[23].m_Type = CKPLUGIN_BITMAP_READER;
+
     return &g_PluginInfo[index];
 }
+
+//=============================================================================
+// Decode limits
+//=============================================================================
+static CKDWORD s_MaxPixels = IMAGE_DEFAULT_MAX_PIXELS;
+static CKDWORD s_MaxBytes = IMAGE_DEFAULT_MAX_BYTES;
+
+void ImageSetDecodeLimits(CKDWORD maxPixels, CKDWORD maxBytes)
+{
+    s_MaxPixels = maxPixels ? maxPixels : IMAGE_DEFAULT_MAX_PIXELS;
+    s_MaxBytes = (maxBytes && maxBytes < IMAGE_DEFAULT_MAX_BYTES) ? maxBytes : IMAGE_DEFAULT_MAX_BYTES;
+}
+
+CKDWORD ImageGetMaxPixels() { return s_MaxPixels; }
+
+CKDWORD ImageGetMaxBytes() { return s_MaxBytes; }
+
+CKBOOL ImageWithinDecodeLimits(CKDWORD width, CKDWORD height, uint64_t bytes)
+{
+    return (uint64_t)width * height <= s_MaxPixels && bytes <= s_MaxBytes;
+}
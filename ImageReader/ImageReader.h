@@ -13,9 +13,74 @@
 #define READER_INDEX_BMP 0
 #define READER_INDEX_TGA 1
 #define READER_INDEX_PCX 2
-#define READER_COUNT 3
+#define READER_INDEX_DCX 3
+#define READER_INDEX_QOI 4
+#define READER_INDEX_PNG 5
+#define READER_INDEX_APNG 6
+#define READER_INDEX_JPEG 7
+#define READER_INDEX_GIF 8
+#define READER_INDEX_GIF_MOVIE 9
+#define READER_INDEX_ICO 10
+#define READER_INDEX_CUR 11
+#define READER_INDEX_TIFF 12
+#define READER_INDEX_HDR 13
+#define READER_INDEX_EXR 14
+#define READER_INDEX_WEBP 15
+#define READER_INDEX_PNM 16
+#define READER_INDEX_PBM 17
+#define READER_INDEX_PGM 18
+#define READER_INDEX_PPM 19
+#define READER_INDEX_PAM 20
+#define READER_INDEX_FARBFELD 21
+#define READER_INDEX_DDS 22
+#define READER_INDEX_KTX 23
+#define READER_COUNT 24
 extern CKPluginInfo g_PluginInfo[READER_COUNT];
 
+// Read flags accepted by the core read functions and ImageReader::SetReadFlags
+// Keep color index images (up to 8 bits per pixel) as 8-bit indices plus a
+// BGRA palette in VxImageDescEx::ColorMap instead of expanding them to BGRA32
+#define IMAGE_READ_KEEP_INDICES 0x00000001
+// Keep 16 bits per channel images as BGRA64 (four little-endian 16-bit
+// channels per pixel) instead of reducing them to BGRA32
+#define IMAGE_READ_KEEP_16BIT 0x00000002
+// Keep high dynamic range images as RGBA float (four 32-bit floats per pixel)
+// instead of clamping them to BGRA32
+#define IMAGE_READ_FLOAT 0x00000004
+// Keep block-compressed textures (DDS, KTX) as their BC1 to BC7 blocks and
+// whole mip chain instead of decoding the top level to BGRA32; see
+// DdsBitmapProperties for the layout
+#define IMAGE_READ_KEEP_BLOCKS 0x00000008
+// Decode at a reduced size (rounded up) where the format can do so cheaply;
+// readers without such support ignore these flags. JPEG scales in the DCT
+// domain, so only the low-frequency coefficients are transformed.
+#define IMAGE_READ_SCALE_1_2 0x00000010
+#define IMAGE_READ_SCALE_1_4 0x00000020
+#define IMAGE_READ_SCALE_1_8 0x00000030
+#define IMAGE_READ_SCALE_MASK 0x00000030
+
+//=============================================================================
+// Decode limits
+//
+// Images larger than these limits are rejected with CKBITMAPERROR_FILECORRUPTED
+// before their decoded block is allocated. Readers check the pixel count from
+// the header and the block size once the output format is known.
+// The limits are shared by every image and movie reader and apply to reads
+// started after they are set.
+//=============================================================================
+
+#define IMAGE_DEFAULT_MAX_PIXELS 400000000u
+#define IMAGE_DEFAULT_MAX_BYTES 0x7FFFFFFFu // int sizes cannot describe larger blocks
+
+// Sets the largest image (width times height) and the largest decoded block
+// in bytes. 0 restores a default; byte limits above the default are clamped.
+void ImageSetDecodeLimits(CKDWORD maxPixels, CKDWORD maxBytes);
+CKDWORD ImageGetMaxPixels();
+CKDWORD ImageGetMaxBytes();
+
+// TRUE if a width x height image decoded into a block of bytes fits the limits
+CKBOOL ImageWithinDecodeLimits(CKDWORD width, CKDWORD height, uint64_t bytes);
+
 //=============================================================================
 // Extended bitmap properties structures
 //
@@ -74,8 +139,8 @@ struct TgaBitmapProperties : public CKBitmapProperties
 };
 
 // PCX extended properties: 80 bytes total
-// Offset 72: m_BitDepth (default 24, unused)
-// Offset 76: m_UseRLE (default 0, unused)
+// Offset 72: m_BitDepth (default 24)
+// Offset 76: m_UseRLE (default 1)
 struct PcxBitmapProperties : public CKBitmapProperties
 {
     PcxBitmapProperties() { Init(CKGUID(), nullptr); }
@@ -90,12 +155,352 @@ struct PcxBitmapProperties : public CKBitmapProperties
             m_Ext = CKFileExtension((char *)ext);
         m_Format.Size = sizeof(VxImageDescEx);
         m_BitDepth = 24;
-        m_UseRLE = 0;
+        m_UseRLE = 1;
+    }
+
+    // Extended fields
+    CKDWORD m_BitDepth; // 0x48 (offset 72): Bit depth for saving, 8 or 24 (default 24)
+    CKDWORD m_UseRLE;   // 0x4C (offset 76): Use RLE compression (default 1)
+};
+
+// QOI extended properties: 76 bytes total
+// Offset 72: m_Channels (0 = auto, 3 or 4)
+struct QoiBitmapProperties : public CKBitmapProperties
+{
+    QoiBitmapProperties() { Init(CKGUID(), nullptr); }
+    QoiBitmapProperties(const CKGUID &readerGuid, const char *ext) { Init(readerGuid, ext); }
+
+    void Init(const CKGUID &readerGuid, const char *ext)
+    {
+        memset(this, 0, sizeof(*this));
+        m_Size = sizeof(QoiBitmapProperties);
+        m_ReaderGuid = readerGuid;
+        if (ext)
+            m_Ext = CKFileExtension((char *)ext);
+        m_Format.Size = sizeof(VxImageDescEx);
+        m_Channels = 0;
+    }
+
+    // Extended fields
+    CKDWORD m_Channels; // 0x48 (offset 72): Channels for saving, 0 = auto (default 0)
+};
+
+// PNG extended properties: 80 bytes total (read-only, describes the source image)
+// Offset 72: m_BitDepth (1, 2, 4, 8 or 16 bits per sample)
+// Offset 76: m_ColorType (0 gray, 2 RGB, 3 palette, 4 gray + alpha, 6 RGBA)
+struct PngBitmapProperties : public CKBitmapProperties
+{
+    PngBitmapProperties() { Init(CKGUID(), nullptr); }
+    PngBitmapProperties(const CKGUID &readerGuid, const char *ext) { Init(readerGuid, ext); }
+
+    void Init(const CKGUID &readerGuid, const char *ext)
+    {
+        memset(this, 0, sizeof(*this));
+        m_Size = sizeof(PngBitmapProperties);
+        m_ReaderGuid = readerGuid;
+        if (ext)
+            m_Ext = CKFileExtension((char *)ext);
+        m_Format.Size = sizeof(VxImageDescEx);
+        m_BitDepth = 8;
+        m_ColorType = 6;
+    }
+
+    // Extended fields
+    CKDWORD m_BitDepth;  // 0x48 (offset 72): Bits per sample of the last image read (default 8)
+    CKDWORD m_ColorType; // 0x4C (offset 76): PNG color type of the last image read (default 6)
+};
+
+// JPEG extended properties: 80 bytes total (read-only, describes the source image)
+// Offset 72: m_Components (1 gray, 3 YCbCr or RGB, 4 CMYK or YCCK)
+// Offset 76: m_Progressive (1 for progressive JPEG, 0 for sequential)
+struct JpegBitmapProperties : public CKBitmapProperties
+{
+    JpegBitmapProperties() { Init(CKGUID(), nullptr); }
+    JpegBitmapProperties(const CKGUID &readerGuid, const char *ext) { Init(readerGuid, ext); }
+
+    void Init(const CKGUID &readerGuid, const char *ext)
+    {
+        memset(this, 0, sizeof(*this));
+        m_Size = sizeof(JpegBitmapProperties);
+        m_ReaderGuid = readerGuid;
+        if (ext)
+            m_Ext = CKFileExtension((char *)ext);
+        m_Format.Size = sizeof(VxImageDescEx);
+        m_Components = 3;
+        m_Progressive = 0;
+    }
+
+    // Extended fields
+    CKDWORD m_Components;  // 0x48 (offset 72): Component count of the last image read (default 3)
+    CKDWORD m_Progressive; // 0x4C (offset 76): 1 if the last image read was progressive (default 0)
+};
+
+// GIF extended properties: 80 bytes total (read-only, describes the source image)
+// Offset 72: m_FrameCount (number of frames in the file; only the first is read)
+// Offset 76: m_NumPlays (times the animation is played, 0 = forever)
+struct GifBitmapProperties : public CKBitmapProperties
+{
+    GifBitmapProperties() { Init(CKGUID(), nullptr); }
+    GifBitmapProperties(const CKGUID &readerGuid, const char *ext) { Init(readerGuid, ext); }
+
+    void Init(const CKGUID &readerGuid, const char *ext)
+    {
+        memset(this, 0, sizeof(*this));
+        m_Size = sizeof(GifBitmapProperties);
+        m_ReaderGuid = readerGuid;
+        if (ext)
+            m_Ext = CKFileExtension((char *)ext);
+        m_Format.Size = sizeof(VxImageDescEx);
+        m_FrameCount = 1;
+        m_NumPlays = 1;
+    }
+
+    // Extended fields
+    CKDWORD m_FrameCount; // 0x48 (offset 72): Frame count of the last file read (default 1)
+    CKDWORD m_NumPlays;   // 0x4C (offset 76): Loop count of the last file read, 0 = forever (default 1)
+};
+
+// ICO/CUR extended properties: 80 bytes total (read-only, describes the source file)
+// Offset 72: m_EntryCount (number of images in the directory)
+// Offset 76: m_EntryIndex (directory index of the image read)
+struct IcoBitmapProperties : public CKBitmapProperties
+{
+    IcoBitmapProperties() { Init(CKGUID(), nullptr); }
+    IcoBitmapProperties(const CKGUID &readerGuid, const char *ext) { Init(readerGuid, ext); }
+
+    void Init(const CKGUID &readerGuid, const char *ext)
+    {
+        memset(this, 0, sizeof(*this));
+        m_Size = sizeof(IcoBitmapProperties);
+        m_ReaderGuid = readerGuid;
+        if (ext)
+            m_Ext = CKFileExtension((char *)ext);
+        m_Format.Size = sizeof(VxImageDescEx);
+        m_EntryCount = 1;
+        m_EntryIndex = 0;
+    }
+
+    // Extended fields
+    CKDWORD m_EntryCount; // 0x48 (offset 72): Directory entries of the last file read (default 1)
+    CKDWORD m_EntryIndex; // 0x4C (offset 76): Entry decoded from the last file read (default 0)
+};
+
+// TIFF extended properties: 80 bytes total (read-only, describes the source image)
+// Offset 72: m_BitsPerSample (1, 2, 4, 8, 16 or 32 for floating point samples)
+// Offset 76: m_SamplesPerPixel (color samples plus extra samples such as alpha)
+struct TiffBitmapProperties : public CKBitmapProperties
+{
+    TiffBitmapProperties() { Init(CKGUID(), nullptr); }
+    TiffBitmapProperties(const CKGUID &readerGuid, const char *ext) { Init(readerGuid, ext); }
+
+    void Init(const CKGUID &readerGuid, const char *ext)
+    {
+        memset(this, 0, sizeof(*this));
+        m_Size = sizeof(TiffBitmapProperties);
+        m_ReaderGuid = readerGuid;
+        if (ext)
+            m_Ext = CKFileExtension((char *)ext);
+        m_Format.Size = sizeof(VxImageDescEx);
+        m_BitsPerSample = 8;
+        m_SamplesPerPixel = 4;
+    }
+
+    // Extended fields
+    CKDWORD m_BitsPerSample;   // 0x48 (offset 72): Bits per sample of the last image read (default 8)
+    CKDWORD m_SamplesPerPixel; // 0x4C (offset 76): Samples per pixel of the last image read (default 4)
+};
+
+// Radiance HDR extended properties: 80 bytes total (read-only, describes the source image)
+// Offset 72: m_Exposure (product of the EXPOSURE header lines; pixels were multiplied by it)
+// Offset 76: m_Gamma (GAMMA header value, 1.0 if absent)
+struct HdrBitmapProperties : public CKBitmapProperties
+{
+    HdrBitmapProperties() { Init(CKGUID(), nullptr); }
+    HdrBitmapProperties(const CKGUID &readerGuid, const char *ext) { Init(readerGuid, ext); }
+
+    void Init(const CKGUID &readerGuid, const char *ext)
+    {
+        memset(this, 0, sizeof(*this));
+        m_Size = sizeof(HdrBitmapProperties);
+        m_ReaderGuid = readerGuid;
+        if (ext)
+            m_Ext = CKFileExtension((char *)ext);
+        m_Format.Size = sizeof(VxImageDescEx);
+        m_Exposure = 1.0f;
+        m_Gamma = 1.0f;
+    }
+
+    // Extended fields
+    float m_Exposure; // 0x48 (offset 72): Exposure of the last image read (default 1.0)
+    float m_Gamma;    // 0x4C (offset 76): Gamma of the last image read (default 1.0)
+};
+
+// OpenEXR extended properties: 88 bytes total (read-only, describes the source image)
+// The decoded image is the data window; these place it in the display window.
+// Offset 72: m_DisplayWidth
+// Offset 76: m_DisplayHeight
+// Offset 80: m_DataX (left of the data window, relative to the display window)
+// Offset 84: m_DataY (top of the data window, relative to the display window)
+struct ExrBitmapProperties : public CKBitmapProperties
+{
+    ExrBitmapProperties() { Init(CKGUID(), nullptr); }
+    ExrBitmapProperties(const CKGUID &readerGuid, const char *ext) { Init(readerGuid, ext); }
+
+    void Init(const CKGUID &readerGuid, const char *ext)
+    {
+        memset(this, 0, sizeof(*this));
+        m_Size = sizeof(ExrBitmapProperties);
+        m_ReaderGuid = readerGuid;
+        if (ext)
+            m_Ext = CKFileExtension((char *)ext);
+        m_Format.Size = sizeof(VxImageDescEx);
+    }
+
+    // Extended fields
+    CKDWORD m_DisplayWidth;  // 0x48 (offset 72): Display window width of the last image read
+    CKDWORD m_DisplayHeight; // 0x4C (offset 76): Display window height of the last image read
+    int m_DataX;             // 0x50 (offset 80): Data window left, relative to the display window
+    int m_DataY;             // 0x54 (offset 84): Data window top, relative to the display window
+};
+
+// WebP extended properties: 80 bytes total (read-only, describes the source file)
+// Offset 72: m_FrameCount (number of frames in the file; only the first is read)
+// Offset 76: m_Lossless (1 if the frame read was VP8L, 0 if VP8)
+struct WebpBitmapProperties : public CKBitmapProperties
+{
+    WebpBitmapProperties() { Init(CKGUID(), nullptr); }
+    WebpBitmapProperties(const CKGUID &readerGuid, const char *ext) { Init(readerGuid, ext); }
+
+    void Init(const CKGUID &readerGuid, const char *ext)
+    {
+        memset(this, 0, sizeof(*this));
+        m_Size = sizeof(WebpBitmapProperties);
+        m_ReaderGuid = readerGuid;
+        if (ext)
+            m_Ext = CKFileExtension((char *)ext);
+        m_Format.Size = sizeof(VxImageDescEx);
+        m_FrameCount = 1;
+    }
+
+    // Extended fields
+    CKDWORD m_FrameCount; // 0x48 (offset 72): Frame count of the last file read (default 1)
+    CKDWORD m_Lossless;   // 0x4C (offset 76): 1 if the last image read was lossless (default 0)
+};
+
+// Netpbm extended properties: 80 bytes total (read-only, describes the source file)
+// Offset 72: m_PnmFormat (the digit of the magic number: 1-3 plain, 4-6 raw, 7 PAM)
+// Offset 76: m_MaxValue (largest sample value; 1 for bitmaps)
+struct PnmBitmapProperties : public CKBitmapProperties
+{
+    PnmBitmapProperties() { Init(CKGUID(), nullptr); }
+    PnmBitmapProperties(const CKGUID &readerGuid, const char *ext) { Init(readerGuid, ext); }
+
+    void Init(const CKGUID &readerGuid, const char *ext)
+    {
+        memset(this, 0, sizeof(*this));
+        m_Size = sizeof(PnmBitmapProperties);
+        m_ReaderGuid = readerGuid;
+        if (ext)
+            m_Ext = CKFileExtension((char *)ext);
+        m_Format.Size = sizeof(VxImageDescEx);
+    }
+
+    // Extended fields
+    CKDWORD m_PnmFormat; // 0x48 (offset 72): Format of the last file read (PNM_*, default 0)
+    CKDWORD m_MaxValue;  // 0x4C (offset 76): Maxval of the last file read (default 0)
+};
+
+// Farbfeld extended properties: 76 bytes total (read-only, describes the source image)
+// Offset 72: m_HasAlpha (1 if a decoded pixel has alpha below the maximum)
+struct FarbfeldBitmapProperties : public CKBitmapProperties
+{
+    FarbfeldBitmapProperties() { Init(CKGUID(), nullptr); }
+    FarbfeldBitmapProperties(const CKGUID &readerGuid, const char *ext) { Init(readerGuid, ext); }
+
+    void Init(const CKGUID &readerGuid, const char *ext)
+    {
+        memset(this, 0, sizeof(*this));
+        m_Size = sizeof(FarbfeldBitmapProperties);
+        m_ReaderGuid = readerGuid;
+        if (ext)
+            m_Ext = CKFileExtension((char *)ext);
+        m_Format.Size = sizeof(VxImageDescEx);
+    }
+
+    // Extended fields
+    CKDWORD m_HasAlpha; // 0x48 (offset 72): 1 if the last image read is not opaque (default 0)
+};
+
+// DDS extended properties: 100 bytes total (read-only, describes the source file)
+// With IMAGE_READ_KEEP_BLOCKS, m_Data holds the m_MipCount levels of the first
+// face, layer and slice back to back, and m_Format describes level 0 (see
+// ImageReader::FillFormatBlocks).
+// Offset 72: m_BlockFormat (IMAGE_BLOCK_* from ImageBcn.h; 0 for uncompressed pixels)
+// Offset 76: m_MipCount (mip levels in the file)
+// Offset 80: m_DataSize (bytes at m_Data)
+// Offset 84: m_Faces (6 for cube maps, otherwise 1)
+// Offset 88: m_Layers (array elements)
+// Offset 92: m_Depth (slices of volume textures, otherwise 1)
+// Offset 96: m_Srgb (1 if the colors are sRGB encoded)
+struct DdsBitmapProperties : public CKBitmapProperties
+{
+    DdsBitmapProperties() { Init(CKGUID(), nullptr); }
+    DdsBitmapProperties(const CKGUID &readerGuid, const char *ext) { Init(readerGuid, ext); }
+
+    void Init(const CKGUID &readerGuid, const char *ext)
+    {
+        memset(this, 0, sizeof(*this));
+        m_Size = sizeof(DdsBitmapProperties);
+        m_ReaderGuid = readerGuid;
+        if (ext)
+            m_Ext = CKFileExtension((char *)ext);
+        m_Format.Size = sizeof(VxImageDescEx);
     }
 
-    // Extended fields (unused for PCX, but present for consistency)
-    CKDWORD m_BitDepth; // 0x48 (offset 72): Reserved (default 24)
-    CKDWORD m_UseRLE;   // 0x4C (offset 76): Reserved (default 0)
+    // Extended fields
+    CKDWORD m_BlockFormat; // 0x48 (offset 72): Block format of the last file read (default 0)
+    CKDWORD m_MipCount;    // 0x4C (offset 76): Mip levels of the last file read (default 0)
+    CKDWORD m_DataSize;    // 0x50 (offset 80): Bytes of image data returned (default 0)
+    CKDWORD m_Faces;       // 0x54 (offset 84): Faces of the last file read (default 0)
+    CKDWORD m_Layers;      // 0x58 (offset 88): Array layers of the last file read (default 0)
+    CKDWORD m_Depth;       // 0x5C (offset 92): Depth of the last file read (default 0)
+    CKDWORD m_Srgb;        // 0x60 (offset 96): 1 if the last file read is sRGB (default 0)
+};
+
+// KTX extended properties: 104 bytes total (read-only, describes the source file)
+// Same fields and block layout as DdsBitmapProperties, plus the version.
+// Offset 72: m_BlockFormat
+// Offset 76: m_MipCount
+// Offset 80: m_DataSize
+// Offset 84: m_Faces
+// Offset 88: m_Layers
+// Offset 92: m_Depth
+// Offset 96: m_Srgb
+// Offset 100: m_KtxVersion (1 or 2)
+struct KtxBitmapProperties : public CKBitmapProperties
+{
+    KtxBitmapProperties() { Init(CKGUID(), nullptr); }
+    KtxBitmapProperties(const CKGUID &readerGuid, const char *ext) { Init(readerGuid, ext); }
+
+    void Init(const CKGUID &readerGuid, const char *ext)
+    {
+        memset(this, 0, sizeof(*this));
+        m_Size = sizeof(KtxBitmapProperties);
+        m_ReaderGuid = readerGuid;
+        if (ext)
+            m_Ext = CKFileExtension((char *)ext);
+        m_Format.Size = sizeof(VxImageDescEx);
+    }
+
+    // Extended fields
+    CKDWORD m_BlockFormat; // 0x48 (offset 72): Block format of the last file read (default 0)
+    CKDWORD m_MipCount;    // 0x4C (offset 76): Mip levels of the last file read (default 0)
+    CKDWORD m_DataSize;    // 0x50 (offset 80): Bytes of image data returned (default 0)
+    CKDWORD m_Faces;       // 0x54 (offset 84): Faces of the last file read (default 0)
+    CKDWORD m_Layers;      // 0x58 (offset 88): Array layers of the last file read (default 0)
+    CKDWORD m_Depth;       // 0x5C (offset 92): Depth of the last file read (default 0)
+    CKDWORD m_Srgb;        // 0x60 (offset 96): 1 if the last file read is sRGB (default 0)
+    CKDWORD m_KtxVersion;  // 0x64 (offset 100): KTX version of the last file read (default 0)
 };
 
 // Shared base class for BMP/TGA/PCX readers.
@@ -177,6 +582,67 @@ public:
         fmt.Image = image;
     }
 
+    // Shared helper to fill a VxImageDescEx for 16 bits per channel BGRA images
+    // (IMAGE_READ_KEEP_16BIT). The channel masks do not fit in a DWORD and are left 0.
+    static void FillFormatBGRA64(VxImageDescEx &fmt, int width, int height, int bytesPerLine, CKBYTE *image)
+    {
+        memset(&fmt, 0, sizeof(VxImageDescEx));
+        fmt.Size = sizeof(VxImageDescEx);
+        fmt.Width = width;
+        fmt.Height = height;
+        fmt.BytesPerLine = bytesPerLine;
+        fmt.BitsPerPixel = 64;
+        fmt.Image = image;
+    }
+
+    // Shared helper to fill a VxImageDescEx for float RGBA images (IMAGE_READ_FLOAT),
+    // four 32-bit floats per pixel in R, G, B, A order. The masks are left 0.
+    static void FillFormatRGBA128F(VxImageDescEx &fmt, int width, int height, int bytesPerLine, CKBYTE *image)
+    {
+        memset(&fmt, 0, sizeof(VxImageDescEx));
+        fmt.Size = sizeof(VxImageDescEx);
+        fmt.Width = width;
+        fmt.Height = height;
+        fmt.BytesPerLine = bytesPerLine;
+        fmt.BitsPerPixel = 128;
+        fmt.Image = image;
+    }
+
+    // Shared helper to fill a VxImageDescEx for BC1 to BC7 blocks
+    // (IMAGE_READ_KEEP_BLOCKS) of 8 or 16 bytes per 4x4 pixels. BytesPerLine is
+    // the pitch of a row of blocks; the masks are left 0.
+    static void FillFormatBlocks(VxImageDescEx &fmt, int width, int height, int blockBytes, CKBYTE *image)
+    {
+        memset(&fmt, 0, sizeof(VxImageDescEx));
+        fmt.Size = sizeof(VxImageDescEx);
+        fmt.Width = width;
+        fmt.Height = height;
+        fmt.BytesPerLine = ((width + 3) / 4) * blockBytes;
+        fmt.BitsPerPixel = blockBytes / 2;
+        fmt.Image = image;
+    }
+
+    // Shared helper to fill a VxImageDescEx for 8-bit color index images.
+    // colorMap holds colorCount BGRA entries (4 bytes each).
+    static void FillFormatIndexed8(VxImageDescEx &fmt, int width, int height, int bytesPerLine, CKBYTE *image,
+                                   CKBYTE *colorMap, int colorCount)
+    {
+        memset(&fmt, 0, sizeof(VxImageDescEx));
+        fmt.Size = sizeof(VxImageDescEx);
+        fmt.Flags = 0;
+        fmt.Width = width;
+        fmt.Height = height;
+        fmt.BytesPerLine = bytesPerLine;
+        fmt.BitsPerPixel = 8;
+        fmt.BytesPerColorEntry = 4;
+        fmt.ColorMapEntries = colorCount;
+        fmt.ColorMap = colorMap;
+        fmt.Image = image;
+    }
+
+    // Row pitch of 8-bit index images (DWORD aligned)
+    static int Indexed8Stride(int width) { return (width + 3) & ~3; }
+
     // Free image data associated with properties.
     // Ownership rules (mirroring original behavior):
     // - If m_Data is non-null, it owns the allocation backing the image (and potentially other sub-pointers).
@@ -195,6 +661,24 @@ public:
 protected:
     ImageReader() {}
 
+    // Reads a file (size == 0, data is its name) or memory block, whatever its
+    // extension: the file is mapped once and its first bytes are matched
+    // against every known format (ImageSniffFormat). Data in this reader's
+    // format (formatIndex, as ImageSniffFormat reports it) or in no known
+    // format goes to ReadOwnFormat; data in another format is decoded by that
+    // reader's core function with default options and readFlags, and only
+    // m_Format and m_Data of props are set. If that fails, ReadOwnFormat is
+    // tried before the other reader's error is returned; this is the only
+    // path that parses the data twice. Implemented in ImageSniff.cpp.
+    int ReadSniffed(int formatIndex, void *data, int size, CKBitmapProperties *props, CKDWORD readFlags);
+
+    // Decodes data (size > 0, or the reader's own error for invalid
+    // arguments) with this reader's core function and options
+    virtual int ReadOwnFormat(void *data, int size, CKBitmapProperties *props)
+    {
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    }
+
 private:
     ImageReader(const ImageReader &);
     ImageReader &operator=(const ImageReader &);
@@ -0,0 +1,922 @@
+#include "ImageSimd.h"
+#include "ImageThreadPool.h"
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+//=============================================================================
+// CPU Feature Detection
+//=============================================================================
+static void CpuId(int leaf, int subLeaf, int regs[4])
+{
+#if defined(_MSC_VER)
+    __cpuidex(regs, leaf, subLeaf);
+#else
+    unsigned int a = 0, b = 0, c = 0, d = 0;
+    __cpuid_count(leaf, subLeaf, a, b, c, d);
+    regs[0] = (int)a;
+    regs[1] = (int)b;
+    regs[2] = (int)c;
+    regs[3] = (int)d;
+#endif
+}
+
+static unsigned long long ReadXcr0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int lo = 0, hi = 0;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((unsigned long long)hi << 32) | lo;
+#endif
+}
+
+static CKDWORD DetectCpuFeatures()
+{
+    int regs[4];
+    CpuId(0, 0, regs);
+    int maxLeaf = regs[0];
+    if (maxLeaf < 1)
+        return 0;
+
+    CKDWORD features = 0;
+    CpuId(1, 0, regs);
+    if (regs[3] & (1 << 26))
+        features |= IMAGE_CPU_SSE2;
+    if (regs[2] & (1 << 9))
+        features |= IMAGE_CPU_SSSE3;
+    if (regs[2] & (1 << 19))
+        features |= IMAGE_CPU_SSE41;
+
+    // AVX state must be enabled by the OS (OSXSAVE + XCR0 bits 1/2)
+    CKBOOL osAvx = FALSE;
+    if ((regs[2] & (1 << 27)) && (regs[2] & (1 << 28)))
+        osAvx = (ReadXcr0() & 6) == 6;
+
+    if (osAvx && (regs[2] & (1 << 29)))
+        features |= IMAGE_CPU_F16C;
+
+    if (osAvx && maxLeaf >= 7)
+    {
+        CpuId(7, 0, regs);
+        if (regs[1] & (1 << 5))
+            features |= IMAGE_CPU_AVX2;
+    }
+    return features;
+}
+
+static CKDWORD s_CpuFeatures = 0;
+static ImageOnce s_CpuFeaturesOnce = 0;
+
+static void InitCpuFeatures()
+{
+    s_CpuFeatures = DetectCpuFeatures();
+}
+
+CKDWORD ImageCpuFeatures()
+{
+    ImageCallOnce(s_CpuFeaturesOnce, InitCpuFeatures);
+    return s_CpuFeatures;
+}
+
+//=============================================================================
+// Alpha Scan
+//=============================================================================
+static CKBOOL IsOpaqueRowScalar(const CKBYTE *row, int width)
+{
+    for (int x = 0; x < width; x++)
+        if (row[x * 4 + 3] != 0xFF)
+            return FALSE;
+    return TRUE;
+}
+
+static CKBOOL IsOpaqueRowSSE2(const CKBYTE *row, int width)
+{
+    // OR-ing the color bits in turns every opaque pixel into 0xFFFFFFFF
+    const __m128i colorBits = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i ones = _mm_set1_epi32(-1);
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)(row + x * 4));
+        __m128i b = _mm_loadu_si128((const __m128i *)(row + x * 4 + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *)(row + x * 4 + 32));
+        __m128i d = _mm_loadu_si128((const __m128i *)(row + x * 4 + 48));
+        __m128i all = _mm_and_si128(_mm_and_si128(a, b), _mm_and_si128(c, d));
+        all = _mm_or_si128(all, colorBits);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(all, ones)) != 0xFFFF)
+            return FALSE;
+    }
+    for (; x + 4 <= width; x += 4)
+    {
+        __m128i a = _mm_or_si128(_mm_loadu_si128((const __m128i *)(row + x * 4)), colorBits);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, ones)) != 0xFFFF)
+            return FALSE;
+    }
+    return IsOpaqueRowScalar(row + x * 4, width - x);
+}
+
+IMAGE_TARGET_AVX2 static CKBOOL IsOpaqueRowAVX2(const CKBYTE *row, int width)
+{
+    const __m256i colorBits = _mm256_set1_epi32(0x00FFFFFF);
+    const __m256i ones = _mm256_set1_epi32(-1);
+    int x = 0;
+    for (; x + 32 <= width; x += 32)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(row + x * 4));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(row + x * 4 + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i *)(row + x * 4 + 64));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(row + x * 4 + 96));
+        __m256i all = _mm256_and_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, d));
+        all = _mm256_or_si256(all, colorBits);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(all, ones)) != -1)
+            return FALSE;
+    }
+    return IsOpaqueRowSSE2(row + x * 4, width - x);
+}
+
+CKBOOL ImageIsOpaqueBGRA32(const CKBYTE *pixels, int width, int height, int bytesPerLine)
+{
+    if (!pixels || width <= 0 || height <= 0)
+        return TRUE;
+
+    CKBOOL (*scanRow)(const CKBYTE *, int) = IsOpaqueRowScalar;
+    if (ImageCpuHas(IMAGE_CPU_AVX2))
+        scanRow = IsOpaqueRowAVX2;
+    else if (ImageCpuHas(IMAGE_CPU_SSE2))
+        scanRow = IsOpaqueRowSSE2;
+
+    // Contiguous images are scanned as a single long row
+    if (bytesPerLine == width * 4)
+        return scanRow(pixels, width * height);
+
+    for (int y = 0; y < height; y++)
+        if (!scanRow(pixels + (size_t)y * bytesPerLine, width))
+            return FALSE;
+    return TRUE;
+}
+
+//=============================================================================
+// Planar to Interleaved
+//=============================================================================
+typedef void (*PlanarToBGRAFn)(const CKBYTE *, const CKBYTE *, const CKBYTE *, const CKBYTE *, CKBYTE *, int);
+
+static void PlanarToBGRAScalar(const CKBYTE *r, const CKBYTE *g, const CKBYTE *b, const CKBYTE *a,
+                               CKBYTE *dst, int count)
+{
+    for (int x = 0; x < count; x++)
+    {
+        dst[x * 4 + 0] = b[x];
+        dst[x * 4 + 1] = g[x];
+        dst[x * 4 + 2] = r[x];
+        dst[x * 4 + 3] = a ? a[x] : 0xFF;
+    }
+}
+
+static void PlanarToBGRASSE2(const CKBYTE *r, const CKBYTE *g, const CKBYTE *b, const CKBYTE *a,
+                             CKBYTE *dst, int count)
+{
+    // B,G and R,A byte pairs become 16-bit lanes, which then pair into 32-bit pixels
+    const __m128i opaque = _mm_set1_epi8((char)0xFF);
+    int x = 0;
+    for (; x + 16 <= count; x += 16)
+    {
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + x));
+        __m128i vg = _mm_loadu_si128((const __m128i *)(g + x));
+        __m128i vr = _mm_loadu_si128((const __m128i *)(r + x));
+        __m128i va = a ? _mm_loadu_si128((const __m128i *)(a + x)) : opaque;
+
+        __m128i bgLo = _mm_unpacklo_epi8(vb, vg);
+        __m128i bgHi = _mm_unpackhi_epi8(vb, vg);
+        __m128i raLo = _mm_unpacklo_epi8(vr, va);
+        __m128i raHi = _mm_unpackhi_epi8(vr, va);
+
+        __m128i *out = (__m128i *)(dst + x * 4);
+        _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(bgLo, raLo));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(bgLo, raLo));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(bgHi, raHi));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(bgHi, raHi));
+    }
+    PlanarToBGRAScalar(r + x, g + x, b + x, a ? a + x : NULL, dst + x * 4, count - x);
+}
+
+IMAGE_TARGET_AVX2 static void PlanarToBGRAAVX2(const CKBYTE *r, const CKBYTE *g, const CKBYTE *b, const CKBYTE *a,
+                                               CKBYTE *dst, int count)
+{
+    // Unpacks work per 128-bit lane, so the results are re-paired across lanes on store
+    const __m256i opaque = _mm256_set1_epi8((char)0xFF);
+    int x = 0;
+    for (; x + 32 <= count; x += 32)
+    {
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + x));
+        __m256i vg = _mm256_loadu_si256((const __m256i *)(g + x));
+        __m256i vr = _mm256_loadu_si256((const __m256i *)(r + x));
+        __m256i va = a ? _mm256_loadu_si256((const __m256i *)(a + x)) : opaque;
+
+        __m256i bgLo = _mm256_unpacklo_epi8(vb, vg);
+        __m256i bgHi = _mm256_unpackhi_epi8(vb, vg);
+        __m256i raLo = _mm256_unpacklo_epi8(vr, va);
+        __m256i raHi = _mm256_unpackhi_epi8(vr, va);
+
+        __m256i p0 = _mm256_unpacklo_epi16(bgLo, raLo); // pixels 0-3 | 16-19
+        __m256i p1 = _mm256_unpackhi_epi16(bgLo, raLo); // pixels 4-7 | 20-23
+        __m256i p2 = _mm256_unpacklo_epi16(bgHi, raHi); // pixels 8-11 | 24-27
+        __m256i p3 = _mm256_unpackhi_epi16(bgHi, raHi); // pixels 12-15 | 28-31
+
+        __m256i *out = (__m256i *)(dst + x * 4);
+        _mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(p0, p1, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(p2, p3, 0x20));
+        _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(p0, p1, 0x31));
+        _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(p2, p3, 0x31));
+    }
+    PlanarToBGRASSE2(r + x, g + x, b + x, a ? a + x : NULL, dst + x * 4, count - x);
+}
+
+void ImagePlanarToBGRA32(const CKBYTE *r, const CKBYTE *g, const CKBYTE *b, const CKBYTE *a,
+                         CKBYTE *dst, int count)
+{
+    if (count <= 0)
+        return;
+
+    PlanarToBGRAFn convert = PlanarToBGRAScalar;
+    if (ImageCpuHas(IMAGE_CPU_AVX2))
+        convert = PlanarToBGRAAVX2;
+    else if (ImageCpuHas(IMAGE_CPU_SSE2))
+        convert = PlanarToBGRASSE2;
+    convert(r, g, b, a, dst, count);
+}
+
+//=============================================================================
+// Interleaved RGB/RGBA to BGRA32
+//=============================================================================
+typedef void (*InterleavedToBGRAFn)(const CKBYTE *, CKBYTE *, int);
+
+static void RGBToBGRAScalar(const CKBYTE *src, CKBYTE *dst, int count)
+{
+    for (int x = 0; x < count; x++)
+    {
+        dst[x * 4 + 0] = src[x * 3 + 2];
+        dst[x * 4 + 1] = src[x * 3 + 1];
+        dst[x * 4 + 2] = src[x * 3 + 0];
+        dst[x * 4 + 3] = 0xFF;
+    }
+}
+
+IMAGE_TARGET_SSSE3 static void RGBToBGRASSSE3(const CKBYTE *src, CKBYTE *dst, int count)
+{
+    // 48 source bytes are split into four 12-byte groups, each shuffled into
+    // four pixels with a zero alpha byte that is then set
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+    int x = 0;
+    for (; x + 16 <= count; x += 16)
+    {
+        const __m128i *in = (const __m128i *)(src + x * 3);
+        __m128i v0 = _mm_loadu_si128(in + 0);
+        __m128i v1 = _mm_loadu_si128(in + 1);
+        __m128i v2 = _mm_loadu_si128(in + 2);
+
+        __m128i *out = (__m128i *)(dst + x * 4);
+        _mm_storeu_si128(out + 0, _mm_or_si128(_mm_shuffle_epi8(v0, shuffle), alpha));
+        _mm_storeu_si128(out + 1, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(v1, v0, 12), shuffle), alpha));
+        _mm_storeu_si128(out + 2, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(v2, v1, 8), shuffle), alpha));
+        _mm_storeu_si128(out + 3, _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(v2, 4), shuffle), alpha));
+    }
+    RGBToBGRAScalar(src + x * 3, dst + x * 4, count - x);
+}
+
+void ImageRGBToBGRA32(const CKBYTE *src, CKBYTE *dst, int count)
+{
+    if (count <= 0)
+        return;
+
+    InterleavedToBGRAFn convert = RGBToBGRAScalar;
+    if (ImageCpuHas(IMAGE_CPU_SSSE3))
+        convert = RGBToBGRASSSE3;
+    convert(src, dst, count);
+}
+
+static void RGBAToBGRAScalar(const CKBYTE *src, CKBYTE *dst, int count)
+{
+    for (int x = 0; x < count; x++)
+    {
+        dst[x * 4 + 0] = src[x * 4 + 2];
+        dst[x * 4 + 1] = src[x * 4 + 1];
+        dst[x * 4 + 2] = src[x * 4 + 0];
+        dst[x * 4 + 3] = src[x * 4 + 3];
+    }
+}
+
+static void RGBAToBGRASSE2(const CKBYTE *src, CKBYTE *dst, int count)
+{
+    // G and A stay in place; R and B trade places through 16-bit shifts
+    const __m128i gaMask = _mm_set1_epi32((int)0xFF00FF00);
+    const __m128i rbMask = _mm_set1_epi32(0x00FF00FF);
+    int x = 0;
+    for (; x + 4 <= count; x += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + x * 4));
+        __m128i rb = _mm_and_si128(v, rbMask);
+        __m128i br = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+        _mm_storeu_si128((__m128i *)(dst + x * 4), _mm_or_si128(_mm_and_si128(v, gaMask), br));
+    }
+    RGBAToBGRAScalar(src + x * 4, dst + x * 4, count - x);
+}
+
+void ImageRGBAToBGRA32(const CKBYTE *src, CKBYTE *dst, int count)
+{
+    if (count <= 0)
+        return;
+
+    InterleavedToBGRAFn convert = RGBAToBGRAScalar;
+    if (ImageCpuHas(IMAGE_CPU_SSE2))
+        convert = RGBAToBGRASSE2;
+    convert(src, dst, count);
+}
+
+//=============================================================================
+// Gray and Bilevel to BGRA32
+//=============================================================================
+static void GrayToBGRAScalar(const CKBYTE *src, CKBYTE *dst, int count)
+{
+    for (int x = 0; x < count; x++)
+    {
+        dst[x * 4 + 0] = src[x];
+        dst[x * 4 + 1] = src[x];
+        dst[x * 4 + 2] = src[x];
+        dst[x * 4 + 3] = 0xFF;
+    }
+}
+
+static void GrayToBGRASSE2(const CKBYTE *src, CKBYTE *dst, int count)
+{
+    // Gray,gray and gray,alpha byte pairs pair up into pixels, as in PlanarToBGRASSE2
+    const __m128i opaque = _mm_set1_epi8((char)0xFF);
+    int x = 0;
+    for (; x + 16 <= count; x += 16)
+    {
+        __m128i g = _mm_loadu_si128((const __m128i *)(src + x));
+        __m128i ggLo = _mm_unpacklo_epi8(g, g);
+        __m128i ggHi = _mm_unpackhi_epi8(g, g);
+        __m128i gaLo = _mm_unpacklo_epi8(g, opaque);
+        __m128i gaHi = _mm_unpackhi_epi8(g, opaque);
+
+        __m128i *out = (__m128i *)(dst + x * 4);
+        _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(ggLo, gaLo));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(ggLo, gaLo));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(ggHi, gaHi));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(ggHi, gaHi));
+    }
+    GrayToBGRAScalar(src + x, dst + x * 4, count - x);
+}
+
+void ImageGrayToBGRA32(const CKBYTE *src, CKBYTE *dst, int count)
+{
+    if (count <= 0)
+        return;
+
+    InterleavedToBGRAFn convert = GrayToBGRAScalar;
+    if (ImageCpuHas(IMAGE_CPU_SSE2))
+        convert = GrayToBGRASSE2;
+    convert(src, dst, count);
+}
+
+static void GrayAlphaToBGRAScalar(const CKBYTE *src, CKBYTE *dst, int count)
+{
+    for (int x = 0; x < count; x++)
+    {
+        dst[x * 4 + 0] = src[x * 2];
+        dst[x * 4 + 1] = src[x * 2];
+        dst[x * 4 + 2] = src[x * 2];
+        dst[x * 4 + 3] = src[x * 2 + 1];
+    }
+}
+
+static void GrayAlphaToBGRASSE2(const CKBYTE *src, CKBYTE *dst, int count)
+{
+    // Each gray,alpha pair doubles into gray,alpha,gray,alpha; the second
+    // byte then takes the gray value
+    const __m128i keep = _mm_set1_epi32((int)0xFFFF00FF);
+    const __m128i low = _mm_set1_epi32(0xFF);
+    int x = 0;
+    for (; x + 8 <= count; x += 8)
+    {
+        __m128i ga = _mm_loadu_si128((const __m128i *)(src + x * 2));
+        __m128i lo = _mm_unpacklo_epi16(ga, ga);
+        __m128i hi = _mm_unpackhi_epi16(ga, ga);
+        lo = _mm_or_si128(_mm_and_si128(lo, keep), _mm_slli_epi32(_mm_and_si128(lo, low), 8));
+        hi = _mm_or_si128(_mm_and_si128(hi, keep), _mm_slli_epi32(_mm_and_si128(hi, low), 8));
+
+        __m128i *out = (__m128i *)(dst + x * 4);
+        _mm_storeu_si128(out + 0, lo);
+        _mm_storeu_si128(out + 1, hi);
+    }
+    GrayAlphaToBGRAScalar(src + x * 2, dst + x * 4, count - x);
+}
+
+void ImageGrayAlphaToBGRA32(const CKBYTE *src, CKBYTE *dst, int count)
+{
+    if (count <= 0)
+        return;
+
+    InterleavedToBGRAFn convert = GrayAlphaToBGRAScalar;
+    if (ImageCpuHas(IMAGE_CPU_SSE2))
+        convert = GrayAlphaToBGRASSE2;
+    convert(src, dst, count);
+}
+
+typedef void (*BitsToBGRAFn)(const CKBYTE *, CKBYTE *, int, CKDWORD, CKDWORD);
+
+static void BitsToBGRAScalar(const CKBYTE *src, CKBYTE *dst, int count, CKDWORD zero, CKDWORD one)
+{
+    CKDWORD *out = (CKDWORD *)dst;
+    for (int x = 0; x < count; x++)
+        out[x] = ((src[x >> 3] >> (7 - (x & 7))) & 1) ? one : zero;
+}
+
+static void BitsToBGRASSE2(const CKBYTE *src, CKBYTE *dst, int count, CKDWORD zero, CKDWORD one)
+{
+    // The byte is broadcast and each lane tests its own bit, giving a
+    // per-pixel mask that selects between the two colors
+    const __m128i bitsHi = _mm_setr_epi32(0x80, 0x40, 0x20, 0x10);
+    const __m128i bitsLo = _mm_setr_epi32(0x08, 0x04, 0x02, 0x01);
+    const __m128i vZero = _mm_set1_epi32((int)zero);
+    const __m128i vOne = _mm_set1_epi32((int)one);
+    int x = 0;
+    for (; x + 8 <= count; x += 8)
+    {
+        __m128i v = _mm_set1_epi32(src[x >> 3]);
+        __m128i maskHi = _mm_cmpeq_epi32(_mm_and_si128(v, bitsHi), bitsHi);
+        __m128i maskLo = _mm_cmpeq_epi32(_mm_and_si128(v, bitsLo), bitsLo);
+
+        __m128i *out = (__m128i *)(dst + x * 4);
+        _mm_storeu_si128(out + 0, _mm_or_si128(_mm_and_si128(maskHi, vOne), _mm_andnot_si128(maskHi, vZero)));
+        _mm_storeu_si128(out + 1, _mm_or_si128(_mm_and_si128(maskLo, vOne), _mm_andnot_si128(maskLo, vZero)));
+    }
+    if (x < count)
+        BitsToBGRAScalar(src + (x >> 3), dst + x * 4, count - x, zero, one);
+}
+
+void ImageBitsToBGRA32(const CKBYTE *src, CKBYTE *dst, int count, CKDWORD zero, CKDWORD one)
+{
+    if (count <= 0)
+        return;
+
+    BitsToBGRAFn convert = BitsToBGRAScalar;
+    if (ImageCpuHas(IMAGE_CPU_SSE2))
+        convert = BitsToBGRASSE2;
+    convert(src, dst, count, zero, one);
+}
+
+//=============================================================================
+// Byte Swapping
+//=============================================================================
+typedef void (*Swap16Fn)(const CKBYTE *, CKWORD *, int);
+
+static void Swap16Scalar(const CKBYTE *src, CKWORD *dst, int count)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = (CKWORD)((src[i * 2] << 8) | src[i * 2 + 1]);
+}
+
+static void Swap16SSE2(const CKBYTE *src, CKWORD *dst, int count)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 2));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+    }
+    Swap16Scalar(src + i * 2, dst + i, count - i);
+}
+
+void ImageSwap16(const CKBYTE *src, CKWORD *dst, int count)
+{
+    if (count <= 0)
+        return;
+
+    Swap16Fn convert = Swap16Scalar;
+    if (ImageCpuHas(IMAGE_CPU_SSE2))
+        convert = Swap16SSE2;
+    convert(src, dst, count);
+}
+
+//=============================================================================
+// 16-bit RGBA to BGRA
+//=============================================================================
+typedef void (*RGBA16ToBGRA32Fn)(const CKBYTE *, CKBYTE *, int);
+typedef void (*RGBA16ToBGRA64Fn)(const CKBYTE *, CKWORD *, int);
+
+static void RGBA16ToBGRA32Scalar(const CKBYTE *src, CKBYTE *dst, int count)
+{
+    for (int i = 0; i < count; i++, src += 8, dst += 4)
+    {
+        dst[0] = src[4];
+        dst[1] = src[2];
+        dst[2] = src[0];
+        dst[3] = src[6];
+    }
+}
+
+// The high bytes come first, so masking the 16-bit lanes to their low byte
+// and packing keeps them; R and B then trade places within each pixel
+static __m128i SwapRB32SSE2(__m128i rgba)
+{
+    __m128i ga = _mm_and_si128(rgba, _mm_set1_epi32((int)0xFF00FF00));
+    __m128i rb = _mm_and_si128(rgba, _mm_set1_epi32(0x00FF00FF));
+    return _mm_or_si128(ga, _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16)));
+}
+
+static void RGBA16ToBGRA32SSE2(const CKBYTE *src, CKBYTE *dst, int count)
+{
+    const __m128i low = _mm_set1_epi16(0x00FF);
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + i * 8)), low);
+        __m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + i * 8 + 16)), low);
+        _mm_storeu_si128((__m128i *)(dst + i * 4), SwapRB32SSE2(_mm_packus_epi16(a, b)));
+    }
+    RGBA16ToBGRA32Scalar(src + i * 8, dst + i * 4, count - i);
+}
+
+IMAGE_TARGET_AVX2 static void RGBA16ToBGRA32AVX2(const CKBYTE *src, CKBYTE *dst, int count)
+{
+    const __m256i low = _mm256_set1_epi16(0x00FF);
+    const __m256i ga = _mm256_set1_epi32((int)0xFF00FF00);
+    const __m256i rb = _mm256_set1_epi32(0x00FF00FF);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i a = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(src + i * 8)), low);
+        __m256i b = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(src + i * 8 + 32)), low);
+        __m256i rgba = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+        __m256i swapped = _mm256_and_si256(rgba, rb);
+        swapped = _mm256_or_si256(_mm256_slli_epi32(swapped, 16), _mm256_srli_epi32(swapped, 16));
+        _mm256_storeu_si256((__m256i *)(dst + i * 4), _mm256_or_si256(_mm256_and_si256(rgba, ga), swapped));
+    }
+    RGBA16ToBGRA32SSE2(src + i * 8, dst + i * 4, count - i);
+}
+
+void ImageRGBA16ToBGRA32(const CKBYTE *src, CKBYTE *dst, int count)
+{
+    if (count <= 0)
+        return;
+
+    RGBA16ToBGRA32Fn convert = RGBA16ToBGRA32Scalar;
+    if (ImageCpuHas(IMAGE_CPU_AVX2))
+        convert = RGBA16ToBGRA32AVX2;
+    else if (ImageCpuHas(IMAGE_CPU_SSE2))
+        convert = RGBA16ToBGRA32SSE2;
+    convert(src, dst, count);
+}
+
+static void RGBA16ToBGRA64Scalar(const CKBYTE *src, CKWORD *dst, int count)
+{
+    for (int i = 0; i < count; i++, src += 8, dst += 4)
+    {
+        dst[0] = (CKWORD)((src[4] << 8) | src[5]);
+        dst[1] = (CKWORD)((src[2] << 8) | src[3]);
+        dst[2] = (CKWORD)((src[0] << 8) | src[1]);
+        dst[3] = (CKWORD)((src[6] << 8) | src[7]);
+    }
+}
+
+static void RGBA16ToBGRA64SSE2(const CKBYTE *src, CKWORD *dst, int count)
+{
+    int i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 8));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 0, 1, 2)), _MM_SHUFFLE(3, 0, 1, 2));
+        _mm_storeu_si128((__m128i *)(dst + i * 4), v);
+    }
+    RGBA16ToBGRA64Scalar(src + i * 8, dst + i * 4, count - i);
+}
+
+void ImageRGBA16ToBGRA64(const CKBYTE *src, CKWORD *dst, int count)
+{
+    if (count <= 0)
+        return;
+
+    RGBA16ToBGRA64Fn convert = RGBA16ToBGRA64Scalar;
+    if (ImageCpuHas(IMAGE_CPU_SSE2))
+        convert = RGBA16ToBGRA64SSE2;
+    convert(src, dst, count);
+}
+
+//=============================================================================
+// Sample Narrowing
+//=============================================================================
+typedef void (*Narrow16Fn)(const CKWORD *, CKBYTE *, int);
+typedef void (*FloatTo8Fn)(const float *, CKBYTE *, int);
+
+static void Narrow16Scalar(const CKWORD *src, CKBYTE *dst, int count)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = (CKBYTE)(src[i] >> 8);
+}
+
+static void Narrow16SSE2(const CKWORD *src, CKBYTE *dst, int count)
+{
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i lo = _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src + i)), 8);
+        __m128i hi = _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src + i + 8)), 8);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    Narrow16Scalar(src + i, dst + i, count - i);
+}
+
+IMAGE_TARGET_AVX2 static void Narrow16AVX2(const CKWORD *src, CKBYTE *dst, int count)
+{
+    // packus works per 128-bit lane; the permute puts the 64-bit halves back in order
+    int i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        __m256i lo = _mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)(src + i)), 8);
+        __m256i hi = _mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)(src + i + 16)), 8);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+        _mm256_storeu_si256((__m256i *)(dst + i), packed);
+    }
+    Narrow16SSE2(src + i, dst + i, count - i);
+}
+
+void ImageNarrow16To8(const CKWORD *src, CKBYTE *dst, int count)
+{
+    if (count <= 0)
+        return;
+
+    Narrow16Fn convert = Narrow16Scalar;
+    if (ImageCpuHas(IMAGE_CPU_AVX2))
+        convert = Narrow16AVX2;
+    else if (ImageCpuHas(IMAGE_CPU_SSE2))
+        convert = Narrow16SSE2;
+    convert(src, dst, count);
+}
+
+static void FloatTo8Scalar(const float *src, CKBYTE *dst, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        // Written so that NaN fails the first comparison
+        float v = (src[i] > 0.0f) ? src[i] : 0.0f;
+        v = (v < 1.0f) ? v : 1.0f;
+        dst[i] = (CKBYTE)(int)(v * 255.0f + 0.5f);
+    }
+}
+
+static void FloatTo8SSE2(const float *src, CKBYTE *dst, int count)
+{
+    // maxps returns its second operand when the first is NaN
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(255.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i v[4];
+        for (int k = 0; k < 4; k++)
+        {
+            __m128 f = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + k * 4), zero), one);
+            v[k] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(f, scale), half));
+        }
+        __m128i w0 = _mm_packs_epi32(v[0], v[1]);
+        __m128i w1 = _mm_packs_epi32(v[2], v[3]);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(w0, w1));
+    }
+    FloatTo8Scalar(src + i, dst + i, count - i);
+}
+
+void ImageFloatTo8(const float *src, CKBYTE *dst, int count)
+{
+    if (count <= 0)
+        return;
+
+    FloatTo8Fn convert = FloatTo8Scalar;
+    if (ImageCpuHas(IMAGE_CPU_SSE2))
+        convert = FloatTo8SSE2;
+    convert(src, dst, count);
+}
+
+//=============================================================================
+// RGBE Conversion
+//=============================================================================
+typedef void (*RGBEToFloatFn)(const CKBYTE *, float *, int);
+typedef void (*RGBEToBGRAFn)(const CKBYTE *, CKBYTE *, int, float);
+
+// Mantissa m and exponent e give m * 2^(e - 136), computed as (m / 256) *
+// 2^(e - 128) with the power of two built directly from its bits (2^-127,
+// for e == 1, is the one denormal)
+static float RGBEChannel(CKBYTE m, CKBYTE e)
+{
+    CKDWORD bits = (e > 1) ? (CKDWORD)(e - 1) << 23 : (e == 1) ? 0x00400000 : 0;
+    float scale;
+    memcpy(&scale, &bits, 4);
+    return ((float)m * (1.0f / 256.0f)) * scale;
+}
+
+static void RGBEToFloatScalar(const CKBYTE *src, float *dst, int count)
+{
+    for (int i = 0; i < count; i++, src += 4, dst += 4)
+    {
+        dst[0] = RGBEChannel(src[0], src[3]);
+        dst[1] = RGBEChannel(src[1], src[3]);
+        dst[2] = RGBEChannel(src[2], src[3]);
+        dst[3] = 1.0f;
+    }
+}
+
+static CKBYTE ClampTo8(float v, float scale)
+{
+    v *= scale;
+    v = (v > 0.0f) ? v : 0.0f;
+    v = (v < 1.0f) ? v : 1.0f;
+    return (CKBYTE)(int)(v * 255.0f + 0.5f);
+}
+
+static void RGBEToBGRAScalar(const CKBYTE *src, CKBYTE *dst, int count, float scale)
+{
+    for (int i = 0; i < count; i++, src += 4, dst += 4)
+    {
+        dst[0] = ClampTo8(RGBEChannel(src[2], src[3]), scale);
+        dst[1] = ClampTo8(RGBEChannel(src[1], src[3]), scale);
+        dst[2] = ClampTo8(RGBEChannel(src[0], src[3]), scale);
+        dst[3] = 255;
+    }
+}
+
+// Four pixels as RGBE float vectors [R, G, B, E]; the exponent lane is
+// broadcast, turned into the power of two and multiplied in
+static void LoadRGBE4(const CKBYTE *src, __m128 out[4])
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i two = _mm_set1_epi32(2);
+    const __m128i denormal = _mm_set1_epi32(0x00400000);
+    const __m128 inv256 = _mm_set1_ps(1.0f / 256.0f);
+    __m128i px = _mm_loadu_si128((const __m128i *)src);
+    __m128i lo = _mm_unpacklo_epi8(px, zero);
+    __m128i hi = _mm_unpackhi_epi8(px, zero);
+    __m128i p[4] = {_mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero), _mm_unpacklo_epi16(hi, zero),
+                    _mm_unpackhi_epi16(hi, zero)};
+    for (int k = 0; k < 4; k++)
+    {
+        __m128i e = _mm_shuffle_epi32(p[k], _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i bits = _mm_andnot_si128(_mm_cmpgt_epi32(two, e), _mm_slli_epi32(_mm_sub_epi32(e, one), 23));
+        bits = _mm_or_si128(bits, _mm_and_si128(_mm_cmpeq_epi32(e, one), denormal));
+        out[k] = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(p[k]), inv256), _mm_castsi128_ps(bits));
+    }
+}
+
+static void RGBEToFloatSSE2(const CKBYTE *src, float *dst, int count)
+{
+    const __m128 rgbMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    const __m128 alpha = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 v[4];
+        LoadRGBE4(src + i * 4, v);
+        for (int k = 0; k < 4; k++)
+            _mm_storeu_ps(dst + (i + k) * 4, _mm_or_ps(_mm_and_ps(v[k], rgbMask), alpha));
+    }
+    RGBEToFloatScalar(src + i * 4, dst + i * 4, count - i);
+}
+
+static void RGBEToBGRASSE2(const CKBYTE *src, CKBYTE *dst, int count, float scale)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 c255 = _mm_set1_ps(255.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128i rgbMask = _mm_set_epi32(0, -1, -1, -1);
+    const __m128i alpha = _mm_set_epi32(255, 0, 0, 0);
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 v[4];
+        LoadRGBE4(src + i * 4, v);
+        __m128i q[4];
+        for (int k = 0; k < 4; k++)
+        {
+            __m128 f = _mm_min_ps(_mm_max_ps(_mm_mul_ps(v[k], s), zero), one);
+            q[k] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(f, c255), half));
+            q[k] = _mm_or_si128(_mm_and_si128(q[k], rgbMask), alpha);
+        }
+        // RGBA words to BGRA, then to bytes
+        __m128i w0 = _mm_packs_epi32(q[0], q[1]);
+        __m128i w1 = _mm_packs_epi32(q[2], q[3]);
+        w0 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(w0, _MM_SHUFFLE(3, 0, 1, 2)), _MM_SHUFFLE(3, 0, 1, 2));
+        w1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(w1, _MM_SHUFFLE(3, 0, 1, 2)), _MM_SHUFFLE(3, 0, 1, 2));
+        _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_packus_epi16(w0, w1));
+    }
+    RGBEToBGRAScalar(src + i * 4, dst + i * 4, count - i, scale);
+}
+
+void ImageRGBEToFloat(const CKBYTE *src, float *dst, int count)
+{
+    if (count <= 0)
+        return;
+
+    RGBEToFloatFn convert = RGBEToFloatScalar;
+    if (ImageCpuHas(IMAGE_CPU_SSE2))
+        convert = RGBEToFloatSSE2;
+    convert(src, dst, count);
+}
+
+void ImageRGBEToBGRA32(const CKBYTE *src, CKBYTE *dst, int count, float scale)
+{
+    if (count <= 0)
+        return;
+
+    RGBEToBGRAFn convert = RGBEToBGRAScalar;
+    if (ImageCpuHas(IMAGE_CPU_SSE2))
+        convert = RGBEToBGRASSE2;
+    convert(src, dst, count, scale);
+}
+
+//=============================================================================
+// Half Float Conversion
+//=============================================================================
+typedef void (*HalfToFloatFn)(const CKWORD *, float *, int);
+
+static CKDWORD HalfToFloatBits(CKWORD h)
+{
+    CKDWORD sign = (CKDWORD)(h & 0x8000) << 16;
+    CKDWORD exponent = (h >> 10) & 0x1F;
+    CKDWORD mantissa = h & 0x3FF;
+    if (exponent == 0)
+    {
+        if (mantissa == 0)
+            return sign;
+        // Denormal: normalize the mantissa
+        exponent = 127 - 15 + 1;
+        while (!(mantissa & 0x400))
+        {
+            mantissa <<= 1;
+            exponent--;
+        }
+        return sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+    }
+    if (exponent == 31)
+        return sign | 0x7F800000 | (mantissa << 13); // infinity or NaN
+    return sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+}
+
+// One float for each of the 65536 halves (256 KB), built on first use
+static CKDWORD s_HalfTable[65536];
+static ImageOnce s_HalfTableOnce = 0;
+
+static void BuildHalfTable()
+{
+    for (CKDWORD h = 0; h < 65536; h++)
+        s_HalfTable[h] = HalfToFloatBits((CKWORD)h);
+}
+
+static const CKDWORD *HalfTable()
+{
+    ImageCallOnce(s_HalfTableOnce, BuildHalfTable);
+    return s_HalfTable;
+}
+
+static void HalfToFloatTable(const CKWORD *src, float *dst, int count)
+{
+    const CKDWORD *table = HalfTable();
+    for (int i = 0; i < count; i++)
+        memcpy(dst + i, table + src[i], 4);
+}
+
+IMAGE_TARGET_F16C static void HalfToFloatF16C(const CKWORD *src, float *dst, int count)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(src + i))));
+    for (; i < count; i++)
+    {
+        CKDWORD bits = HalfToFloatBits(src[i]);
+        memcpy(dst + i, &bits, 4);
+    }
+}
+
+void ImageHalfToFloat(const CKWORD *src, float *dst, int count)
+{
+    if (count <= 0)
+        return;
+
+    HalfToFloatFn convert = HalfToFloatTable;
+    if (ImageCpuHas(IMAGE_CPU_F16C))
+        convert = HalfToFloatF16C;
+    convert(src, dst, count);
+}
@@ -0,0 +1,121 @@
+#ifndef IMAGESIMD_H
+#define IMAGESIMD_H
+
+#include "ImageReader.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//=============================================================================
+// CPU feature detection
+//
+// Kernels are compiled for every instruction set we support and selected at
+// runtime, so the plugin still loads on machines without SSE2/AVX2.
+//=============================================================================
+
+#define IMAGE_CPU_SSE2 0x0001
+#define IMAGE_CPU_SSSE3 0x0002
+#define IMAGE_CPU_SSE41 0x0004
+#define IMAGE_CPU_AVX2 0x0008
+#define IMAGE_CPU_F16C 0x0010
+
+// MSVC emits any intrinsic regardless of /arch; GCC/Clang (MinGW) need the
+// target attribute on functions that use instructions above the baseline.
+#if defined(__GNUC__) || defined(__clang__)
+#define IMAGE_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define IMAGE_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define IMAGE_TARGET_AVX2 __attribute__((target("avx2")))
+#define IMAGE_TARGET_F16C __attribute__((target("avx,f16c")))
+#else
+#define IMAGE_TARGET_SSSE3
+#define IMAGE_TARGET_SSE41
+#define IMAGE_TARGET_AVX2
+#define IMAGE_TARGET_F16C
+#endif
+
+// Returns a mask of IMAGE_CPU_* flags (detected once, then cached)
+CKDWORD ImageCpuFeatures();
+
+inline CKBOOL ImageCpuHas(CKDWORD feature) { return (ImageCpuFeatures() & feature) == feature; }
+
+// Index of the lowest set bit; mask must be non-zero (e.g. a movemask result)
+inline CKDWORD ImageLowestBit(CKDWORD mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (CKDWORD)index;
+#else
+    return (CKDWORD)__builtin_ctz(mask);
+#endif
+}
+
+// Number of set bits
+inline CKDWORD ImagePopCount(CKDWORD mask)
+{
+#if defined(_MSC_VER)
+    mask = mask - ((mask >> 1) & 0x55555555);
+    mask = (mask & 0x33333333) + ((mask >> 2) & 0x33333333);
+    return (((mask + (mask >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+#else
+    return (CKDWORD)__builtin_popcount(mask);
+#endif
+}
+
+//=============================================================================
+// Shared pixel kernels
+//=============================================================================
+
+// Returns TRUE if every pixel of a BGRA32 image has alpha == 255
+CKBOOL ImageIsOpaqueBGRA32(const CKBYTE *pixels, int width, int height, int bytesPerLine);
+
+// Interleaves count bytes of separate R, G, B and A planes into BGRA32.
+// a may be NULL, in which case alpha is set to 255.
+void ImagePlanarToBGRA32(const CKBYTE *r, const CKBYTE *g, const CKBYTE *b, const CKBYTE *a,
+                         CKBYTE *dst, int count);
+
+// Converts count RGB (3 bytes) or RGBA (4 bytes) pixels to BGRA32; RGB pixels
+// become opaque. src and dst must not overlap.
+void ImageRGBToBGRA32(const CKBYTE *src, CKBYTE *dst, int count);
+void ImageRGBAToBGRA32(const CKBYTE *src, CKBYTE *dst, int count);
+
+// Converts count gray (1 byte) or gray and alpha (2 bytes) pixels to BGRA32;
+// gray pixels become opaque. src and dst must not overlap.
+void ImageGrayToBGRA32(const CKBYTE *src, CKBYTE *dst, int count);
+void ImageGrayAlphaToBGRA32(const CKBYTE *src, CKBYTE *dst, int count);
+
+// Expands count 1-bit pixels, packed MSB first, to the BGRA32 colors zero and
+// one (e.g. 0xFFFFFFFF and 0xFF000000)
+void ImageBitsToBGRA32(const CKBYTE *src, CKBYTE *dst, int count, CKDWORD zero, CKDWORD one);
+
+// Swaps the bytes of count 16-bit samples (big-endian to little-endian);
+// src and dst may be the same
+void ImageSwap16(const CKBYTE *src, CKWORD *dst, int count);
+
+// Converts count RGBA pixels of big-endian 16-bit samples (farbfeld, 16-bit
+// PNG) to BGRA32, keeping the high bytes, or to BGRA64 with little-endian
+// samples. src and dst must not overlap.
+void ImageRGBA16ToBGRA32(const CKBYTE *src, CKBYTE *dst, int count);
+void ImageRGBA16ToBGRA64(const CKBYTE *src, CKWORD *dst, int count);
+
+// Narrows count 16-bit samples to 8 bits by keeping the high byte
+void ImageNarrow16To8(const CKWORD *src, CKBYTE *dst, int count);
+
+// Converts count float samples to 8 bits: 0..1 maps to 0..255 with rounding,
+// values outside are clamped and NaN becomes 0
+void ImageFloatTo8(const float *src, CKBYTE *dst, int count);
+
+// Converts count Radiance RGBE pixels (8-bit mantissas and a shared exponent)
+// to RGBA float with alpha 1.0, exactly (m * 2^(e - 136)); exponent 0 is black.
+void ImageRGBEToFloat(const CKBYTE *src, float *dst, int count);
+
+// Same, then scaled, clamped to 0..1 and rounded to BGRA32 with alpha 255
+// (as ImageFloatTo8 does)
+void ImageRGBEToBGRA32(const CKBYTE *src, CKBYTE *dst, int count, float scale);
+
+// Converts count IEEE half floats to float: F16C when available, otherwise
+// a 65536-entry table built on first use
+void ImageHalfToFloat(const CKWORD *src, float *dst, int count);
+
+#endif // IMAGESIMD_H
@@ -0,0 +1,271 @@
+#include "ImageSniff.h"
+#include "ImageFileMap.h"
+
+#include "BmpReader.h"
+#include "TgaReader.h"
+#include "PcxReader.h"
+#include "DcxReader.h"
+#include "QoiReader.h"
+#include "PngReader.h"
+#include "JpegReader.h"
+#include "GifReader.h"
+#include "IcoReader.h"
+#include "TiffReader.h"
+#include "HdrReader.h"
+#include "ExrReader.h"
+#include "WebpReader.h"
+#include "PnmReader.h"
+#include "FarbfeldReader.h"
+#include "DdsReader.h"
+#include "KtxReader.h"
+
+static CKDWORD ReadLE16(const CKBYTE *p)
+{
+    return (CKDWORD)p[0] | ((CKDWORD)p[1] << 8);
+}
+
+static CKDWORD ReadLE32(const CKBYTE *p)
+{
+    return (CKDWORD)p[0] | ((CKDWORD)p[1] << 8) | ((CKDWORD)p[2] << 16) | ((CKDWORD)p[3] << 24);
+}
+
+static CKBOOL HasPrefix(const CKBYTE *data, CKDWORD size, const char *prefix, CKDWORD length)
+{
+    return size >= length && memcmp(data, prefix, length) == 0;
+}
+
+//=============================================================================
+// Signatures
+//=============================================================================
+
+// "BM" and a core (12 bytes) or info (40 bytes or more) header
+static CKBOOL IsBmp(const CKBYTE *data, CKDWORD size)
+{
+    if (size < 18 || data[0] != 'B' || data[1] != 'M')
+        return FALSE;
+    CKDWORD headerSize = ReadLE32(data + 14);
+    return headerSize == 12 || headerSize >= 40;
+}
+
+// Reserved 0, type 1 (icon) or 2 (cursor), at least one entry, and a first
+// entry whose image follows the directory and ends inside the file. Six bytes
+// alone are matched by chance, e.g. by a TGA with a color map length but no
+// color map.
+static CKBOOL IsIco(const CKBYTE *data, CKDWORD size, CKDWORD fileSize)
+{
+    if (size < ICO_HEADER_SIZE + ICO_ENTRY_SIZE || ReadLE16(data) != 0)
+        return FALSE;
+    CKDWORD type = ReadLE16(data + 2), count = ReadLE16(data + 4);
+    if ((type != ICO_TYPE_ICON && type != ICO_TYPE_CURSOR) || count == 0)
+        return FALSE;
+    const CKBYTE *entry = data + ICO_HEADER_SIZE;
+    CKDWORD imageSize = ReadLE32(entry + 8), offset = ReadLE32(entry + 12);
+    return offset >= ICO_HEADER_SIZE + count * ICO_ENTRY_SIZE && imageSize >= ICO_MIN_ENTRY_SIZE &&
+           (unsigned long long)offset + imageSize <= fileSize;
+}
+
+// Manufacturer 0x0A, a known version, RLE or no encoding and 1 to 8 bits
+static CKBOOL IsPcx(const CKBYTE *data, CKDWORD size)
+{
+    if (size < 4 || data[0] != 0x0A)
+        return FALSE;
+    CKDWORD version = data[1], bits = data[3];
+    return (version == 0 || (version >= 2 && version <= 5)) && data[2] <= 1 &&
+           (bits == 1 || bits == 2 || bits == 4 || bits == 8);
+}
+
+// "P1" to "P7" and whitespace
+static CKBOOL IsPnm(const CKBYTE *data, CKDWORD size)
+{
+    if (size < 3 || data[0] != 'P' || data[1] < '1' || data[1] > '7')
+        return FALSE;
+    return data[2] == ' ' || data[2] == '\t' || data[2] == '\n' || data[2] == '\r';
+}
+
+static CKBOOL IsTiff(const CKBYTE *data, CKDWORD size)
+{
+    return HasPrefix(data, size, "II*\0", 4) || HasPrefix(data, size, "MM\0*", 4);
+}
+
+static CKBOOL IsWebp(const CKBYTE *data, CKDWORD size)
+{
+    return size >= 12 && memcmp(data, "RIFF", 4) == 0 && memcmp(data + 8, "WEBP", 4) == 0;
+}
+
+static CKBOOL IsKtx(const CKBYTE *data, CKDWORD size)
+{
+    static const CKBYTE s_KtxPrefix[5] = {0xAB, 'K', 'T', 'X', ' '};
+    return size >= KTX_IDENTIFIER_SIZE && memcmp(data, s_KtxPrefix, 5) == 0;
+}
+
+// TGA has no signature: a supported image type with a matching color map,
+// non-empty dimensions and a valid pixel depth
+static CKBOOL IsTga(const CKBYTE *data, CKDWORD size)
+{
+    if (size < sizeof(TGAHEADER))
+        return FALSE;
+    CKDWORD colorMapType = data[1], imageType = data[2], pixelDepth = data[16];
+    switch (imageType)
+    {
+    case TGA_TYPE_COLORMAP:
+    case TGA_TYPE_RLE_COLORMAP:
+        if (colorMapType != 1 || pixelDepth != 8)
+            return FALSE;
+        break;
+    case TGA_TYPE_TRUECOLOR:
+    case TGA_TYPE_RLE_TRUECOLOR:
+        if (colorMapType > 1 || (pixelDepth != 15 && pixelDepth != 16 && pixelDepth != 24 && pixelDepth != 32))
+            return FALSE;
+        break;
+    case TGA_TYPE_GRAYSCALE:
+    case TGA_TYPE_RLE_GRAYSCALE:
+        if (colorMapType > 1 || (pixelDepth != 8 && pixelDepth != 16))
+            return FALSE;
+        break;
+    default:
+        return FALSE;
+    }
+    if (colorMapType == 1)
+    {
+        CKDWORD entryBits = data[7];
+        if (entryBits != 15 && entryBits != 16 && entryBits != 24 && entryBits != 32)
+            return FALSE;
+    }
+    // Width, height, and no interleaving
+    return ReadLE16(data + 12) != 0 && ReadLE16(data + 14) != 0 && (data[17] & 0xC0) == 0;
+}
+
+int ImageSniffFormat(const CKBYTE *data, CKDWORD size)
+{
+    if (!data)
+        return IMAGE_SNIFF_UNKNOWN;
+    CKDWORD fileSize = size;
+    if (size > IMAGE_SNIFF_BYTES)
+        size = IMAGE_SNIFF_BYTES;
+
+    static const CKBYTE s_PngSignature[PNG_SIGNATURE_SIZE] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+    if (size >= PNG_SIGNATURE_SIZE && memcmp(data, s_PngSignature, PNG_SIGNATURE_SIZE) == 0)
+        return READER_INDEX_PNG;
+    if (size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF)
+        return READER_INDEX_JPEG;
+    if (HasPrefix(data, size, "GIF87a", 6) || HasPrefix(data, size, "GIF89a", 6))
+        return READER_INDEX_GIF;
+    if (IsBmp(data, size))
+        return READER_INDEX_BMP;
+    if (IsWebp(data, size))
+        return READER_INDEX_WEBP;
+    if (IsTiff(data, size))
+        return READER_INDEX_TIFF;
+    if (HasPrefix(data, size, DDS_MAGIC, 4))
+        return READER_INDEX_DDS;
+    if (IsKtx(data, size))
+        return READER_INDEX_KTX;
+    if (size >= 4 && ReadLE32(data) == EXR_MAGIC)
+        return READER_INDEX_EXR;
+    if (HasPrefix(data, size, "qoif", 4))
+        return READER_INDEX_QOI;
+    if (HasPrefix(data, size, FARBFELD_MAGIC, 8))
+        return READER_INDEX_FARBFELD;
+    if (size >= 4 && ReadLE32(data) == DCX_MAGIC)
+        return READER_INDEX_DCX;
+    if (HasPrefix(data, size, HDR_SIGNATURE, 2))
+        return READER_INDEX_HDR;
+    if (IsIco(data, size, fileSize))
+        return READER_INDEX_ICO;
+    if (IsPnm(data, size))
+        return READER_INDEX_PNM;
+    if (IsPcx(data, size))
+        return READER_INDEX_PCX;
+    if (IsTga(data, size))
+        return READER_INDEX_TGA;
+    return IMAGE_SNIFF_UNKNOWN;
+}
+
+//=============================================================================
+// Dispatch
+//=============================================================================
+int ImageReadFormat(int formatIndex, void *data, int size, CKBitmapProperties *props, CKDWORD readFlags)
+{
+    switch (formatIndex)
+    {
+    case READER_INDEX_BMP:
+        return BMP_Read(data, size, props, readFlags);
+    case READER_INDEX_TGA:
+        return TGA_Read(data, size, props);
+    case READER_INDEX_PCX:
+        return PCX_Read(data, size, props, readFlags);
+    case READER_INDEX_DCX:
+        return DCX_Read(data, size, props);
+    case READER_INDEX_QOI:
+        return QOI_Read(data, size, props);
+    case READER_INDEX_PNG:
+        return PNG_Read(data, size, props, readFlags);
+    case READER_INDEX_JPEG:
+        return JPEG_Read(data, size, props, readFlags);
+    case READER_INDEX_GIF:
+        return GIF_Read(data, size, props, readFlags);
+    case READER_INDEX_ICO:
+        return ICO_Read(data, size, props);
+    case READER_INDEX_TIFF:
+        return TIFF_Read(data, size, props, readFlags);
+    case READER_INDEX_HDR:
+        return HDR_Read(data, size, props, readFlags);
+    case READER_INDEX_EXR:
+        return EXR_Read(data, size, props, readFlags);
+    case READER_INDEX_WEBP:
+        return WEBP_Read(data, size, props);
+    case READER_INDEX_PNM:
+        return PNM_Read(data, size, props, readFlags);
+    case READER_INDEX_FARBFELD:
+        return FARBFELD_Read(data, size, props, readFlags);
+    case READER_INDEX_DDS:
+        return DDS_Read(data, size, props, readFlags);
+    case READER_INDEX_KTX:
+        return KTX_Read(data, size, props, readFlags);
+    default:
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    }
+}
+
+//=============================================================================
+// ImageReader::ReadSniffed
+//=============================================================================
+int ImageReader::ReadSniffed(int formatIndex, void *data, int size, CKBitmapProperties *props, CKDWORD readFlags)
+{
+    // The reader's own checks report invalid arguments
+    if (!data || !props || size < 0)
+        return ReadOwnFormat(data, size, props);
+
+    // Files are mapped once; whichever reader decodes them reads the mapping
+    ImageFileMap fileMap;
+    if (size == 0)
+    {
+        if (!fileMap.Open((const char *)data) || fileMap.Size() == 0)
+            return CKBITMAPERROR_READERROR;
+        data = (void *)fileMap.Data();
+        size = (int)fileMap.Size();
+    }
+
+    int sniffed = ImageSniffFormat((const CKBYTE *)data, (CKDWORD)size);
+    if (sniffed == IMAGE_SNIFF_UNKNOWN || sniffed == formatIndex)
+        return ReadOwnFormat(data, size, props);
+
+    // Another reader's format. Its extended properties differ from this
+    // reader's, so it fills plain properties and only the image is kept.
+    CKBitmapProperties plain;
+    memset(&plain, 0, sizeof(plain));
+    plain.m_Size = sizeof(CKBitmapProperties);
+    plain.m_Format.Size = sizeof(VxImageDescEx);
+    int result = ImageReadFormat(sniffed, data, size, &plain, readFlags);
+    if (result != 0)
+    {
+        // The one case where data is parsed twice: a signature matched by a
+        // file of this reader's format. The checks above make it take a
+        // contrived or corrupt file, and the data is already in memory.
+        FreeBitmapData(&plain);
+        return ReadOwnFormat(data, size, props) == 0 ? 0 : result;
+    }
+    props->m_Format = plain.m_Format;
+    props->m_Data = plain.m_Data;
+    return 0;
+}
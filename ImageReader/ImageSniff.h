@@ -0,0 +1,33 @@
+#ifndef IMAGESNIFF_H
+#define IMAGESNIFF_H
+
+#include "ImageReader.h"
+
+//=============================================================================
+// Format sniffing
+//
+// Identifies the format of a file from its first bytes, whatever its
+// extension, so ImageReader::ReadSniffed can hand a misnamed file to the
+// reader of its actual format. Formats are identified by their signatures;
+// TGA has none and is recognized by a plausible header, after every other
+// format.
+//=============================================================================
+
+// Bytes looked at, at most
+#define IMAGE_SNIFF_BYTES 32
+
+// No signature matched
+#define IMAGE_SNIFF_UNKNOWN (-1)
+
+// Returns the READER_INDEX_* of the reader for the format that data starts
+// with, or IMAGE_SNIFF_UNKNOWN. Formats read by several readers give the
+// first one: READER_INDEX_ICO for cursors and READER_INDEX_PNM for every
+// Netpbm format.
+int ImageSniffFormat(const CKBYTE *data, CKDWORD size);
+
+// Reads size bytes of data (never a filename) with the core read function of
+// the reader at formatIndex, as returned by ImageSniffFormat, and its default
+// options
+int ImageReadFormat(int formatIndex, void *data, int size, CKBitmapProperties *props, CKDWORD readFlags);
+
+#endif // IMAGESNIFF_H
@@ -0,0 +1,307 @@
+#include "ImageThreadPool.h"
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#define IMAGE_MAX_THREADS 16
+#define IMAGE_CHUNKS_PER_THREAD 4
+
+//=============================================================================
+// Pool State
+//=============================================================================
+struct ImageJob
+{
+    ImageRangeFunc func;
+    void *context;
+    CKDWORD count;
+    CKDWORD chunkSize;
+    CKDWORD chunkCount;
+    volatile LONG nextChunk;
+    volatile LONG pendingWorkers;
+};
+
+static CRITICAL_SECTION s_JobLock;
+static HANDLE s_WakeSemaphore = NULL;
+static HANDLE s_DoneEvent = NULL;
+static ImageJob *volatile s_CurrentJob = NULL;
+static DWORD s_WorkerTls = TLS_OUT_OF_INDEXES;
+static HANDLE s_Threads[IMAGE_MAX_THREADS];
+static CKDWORD s_BackgroundThreads = 0;
+static volatile LONG s_Quit = 0;
+static volatile LONG s_PoolState = 0; // 0 = not started, 1 = starting or stopping, 2 = ready
+
+static void RunChunks(ImageJob *job)
+{
+    for (;;)
+    {
+        CKDWORD chunk = (CKDWORD)(InterlockedIncrement(&job->nextChunk) - 1);
+        if (chunk >= job->chunkCount)
+            break;
+        CKDWORD begin = chunk * job->chunkSize;
+        CKDWORD end = begin + job->chunkSize;
+        if (end > job->count)
+            end = job->count;
+        job->func(job->context, begin, end);
+    }
+}
+
+static DWORD WINAPI WorkerMain(LPVOID)
+{
+    TlsSetValue(s_WorkerTls, (LPVOID)1);
+    for (;;)
+    {
+        WaitForSingleObject(s_WakeSemaphore, INFINITE);
+        if (s_Quit)
+            break;
+        ImageJob *job = s_CurrentJob;
+        RunChunks(job);
+        if (InterlockedDecrement(&job->pendingWorkers) == 0)
+            SetEvent(s_DoneEvent);
+    }
+    return 0;
+}
+
+static void StartPool()
+{
+    InitializeCriticalSection(&s_JobLock);
+    s_WorkerTls = TlsAlloc();
+    s_WakeSemaphore = CreateSemaphore(NULL, 0, IMAGE_MAX_THREADS, NULL);
+    s_DoneEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (s_WorkerTls == TLS_OUT_OF_INDEXES || !s_WakeSemaphore || !s_DoneEvent)
+        return;
+
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    CKDWORD threads = info.dwNumberOfProcessors;
+    if (threads > IMAGE_MAX_THREADS)
+        threads = IMAGE_MAX_THREADS;
+
+    for (CKDWORD i = 1; i < threads; i++)
+    {
+        HANDLE thread = CreateThread(NULL, 0, WorkerMain, NULL, 0, NULL);
+        if (!thread)
+            break;
+        s_Threads[s_BackgroundThreads++] = thread;
+    }
+}
+
+static void StopPool()
+{
+    // Waits for a running job, then wakes every worker to quit
+    EnterCriticalSection(&s_JobLock);
+    InterlockedExchange(&s_Quit, 1);
+    if (s_BackgroundThreads)
+        ReleaseSemaphore(s_WakeSemaphore, (LONG)s_BackgroundThreads, NULL);
+    for (CKDWORD i = 0; i < s_BackgroundThreads; i++)
+    {
+        WaitForSingleObject(s_Threads[i], INFINITE);
+        CloseHandle(s_Threads[i]);
+        s_Threads[i] = NULL;
+    }
+    s_BackgroundThreads = 0;
+    InterlockedExchange(&s_Quit, 0);
+
+    if (s_WakeSemaphore)
+        CloseHandle(s_WakeSemaphore);
+    if (s_DoneEvent)
+        CloseHandle(s_DoneEvent);
+    if (s_WorkerTls != TLS_OUT_OF_INDEXES)
+        TlsFree(s_WorkerTls);
+    s_WakeSemaphore = NULL;
+    s_DoneEvent = NULL;
+    s_WorkerTls = TLS_OUT_OF_INDEXES;
+    LeaveCriticalSection(&s_JobLock);
+    DeleteCriticalSection(&s_JobLock);
+}
+
+static void EnsurePool()
+{
+    for (;;)
+    {
+        if (s_PoolState == 2)
+            return;
+        if (InterlockedCompareExchange(&s_PoolState, 1, 0) == 0)
+        {
+            StartPool();
+            InterlockedExchange(&s_PoolState, 2);
+            return;
+        }
+        Sleep(0);
+    }
+}
+
+//=============================================================================
+// Public Interface
+//=============================================================================
+CKDWORD ImageWorkerCount()
+{
+    EnsurePool();
+    return s_BackgroundThreads + 1;
+}
+
+void ImageParallelFor(CKDWORD count, CKDWORD minChunk, ImageRangeFunc func, void *context)
+{
+    if (count == 0)
+        return;
+    if (minChunk == 0)
+        minChunk = 1;
+
+    EnsurePool();
+    CKDWORD maxChunks = (s_BackgroundThreads + 1) * IMAGE_CHUNKS_PER_THREAD;
+    CKDWORD chunkCount = (count + minChunk - 1) / minChunk;
+    if (chunkCount > maxChunks)
+        chunkCount = maxChunks;
+
+    if (chunkCount <= 1 || s_BackgroundThreads == 0 || TlsGetValue(s_WorkerTls))
+    {
+        func(context, 0, count);
+        return;
+    }
+    if (!TryEnterCriticalSection(&s_JobLock))
+    {
+        func(context, 0, count);
+        return;
+    }
+
+    ImageJob job;
+    job.func = func;
+    job.context = context;
+    job.count = count;
+    job.chunkSize = (count + chunkCount - 1) / chunkCount;
+    job.chunkCount = (count + job.chunkSize - 1) / job.chunkSize;
+    job.nextChunk = 0;
+
+    CKDWORD wake = job.chunkCount - 1;
+    if (wake > s_BackgroundThreads)
+        wake = s_BackgroundThreads;
+    job.pendingWorkers = (LONG)wake;
+
+    // The caller counts as a worker while it runs chunks, so nested calls stay serial
+    s_CurrentJob = &job;
+    ReleaseSemaphore(s_WakeSemaphore, (LONG)wake, NULL);
+    TlsSetValue(s_WorkerTls, (LPVOID)1);
+    RunChunks(&job);
+    TlsSetValue(s_WorkerTls, NULL);
+    WaitForSingleObject(s_DoneEvent, INFINITE);
+    s_CurrentJob = NULL;
+
+    LeaveCriticalSection(&s_JobLock);
+}
+
+void ImageShutdownPool()
+{
+    if (InterlockedCompareExchange(&s_PoolState, 1, 2) != 2)
+        return;
+    StopPool();
+    InterlockedExchange(&s_PoolState, 0);
+}
+
+//=============================================================================
+// One-time Initialization
+//=============================================================================
+void ImageCallOnce(ImageOnce &once, ImageInitFunc init)
+{
+    // 0 = not run, 1 = running, 2 = done. The interlocked calls order init's
+    // writes before the state becomes 2, and the barrier orders the caller's
+    // reads after it saw 2.
+    if (once == 2)
+    {
+        MemoryBarrier();
+        return;
+    }
+    if (InterlockedCompareExchange(&once, 1, 0) == 0)
+    {
+        init();
+        InterlockedExchange(&once, 2);
+        return;
+    }
+    while (InterlockedCompareExchange(&once, 2, 2) != 2)
+        Sleep(0);
+}
+
+//=============================================================================
+// Background Worker
+//=============================================================================
+struct ImageWorkerState
+{
+    HANDLE thread;
+    HANDLE wakeEvent;
+    HANDLE doneEvent;
+    ImageTaskFunc func;
+    void *context;
+    volatile LONG quit;
+};
+
+static DWORD WINAPI BackgroundMain(LPVOID param)
+{
+    ImageWorkerState *state = (ImageWorkerState *)param;
+    for (;;)
+    {
+        WaitForSingleObject(state->wakeEvent, INFINITE);
+        if (state->quit)
+            break;
+        state->func(state->context);
+        SetEvent(state->doneEvent);
+    }
+    return 0;
+}
+
+static void CloseWorkerState(ImageWorkerState *state)
+{
+    if (state->thread)
+        CloseHandle(state->thread);
+    if (state->wakeEvent)
+        CloseHandle(state->wakeEvent);
+    if (state->doneEvent)
+        CloseHandle(state->doneEvent);
+    delete state;
+}
+
+ImageBackgroundWorker::ImageBackgroundWorker() : m_State(NULL), m_Busy(FALSE) {}
+
+ImageBackgroundWorker::~ImageBackgroundWorker()
+{
+    Wait();
+    if (!m_State)
+        return;
+    InterlockedExchange(&m_State->quit, 1);
+    SetEvent(m_State->wakeEvent);
+    WaitForSingleObject(m_State->thread, INFINITE);
+    CloseWorkerState(m_State);
+}
+
+CKBOOL ImageBackgroundWorker::Start(ImageTaskFunc func, void *context)
+{
+    if (!func || m_Busy)
+        return FALSE;
+
+    if (!m_State)
+    {
+        ImageWorkerState *state = new ImageWorkerState;
+        memset(state, 0, sizeof(*state));
+        state->wakeEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+        state->doneEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+        if (state->wakeEvent && state->doneEvent)
+            state->thread = CreateThread(NULL, 0, BackgroundMain, state, 0, NULL);
+        if (!state->thread)
+        {
+            CloseWorkerState(state);
+            return FALSE;
+        }
+        m_State = state;
+    }
+
+    m_State->func = func;
+    m_State->context = context;
+    m_Busy = TRUE;
+    SetEvent(m_State->wakeEvent);
+    return TRUE;
+}
+
+void ImageBackgroundWorker::Wait()
+{
+    if (!m_Busy)
+        return;
+    WaitForSingleObject(m_State->doneEvent, INFINITE);
+    m_Busy = FALSE;
+}
@@ -0,0 +1,80 @@
+#ifndef IMAGETHREADPOOL_H
+#define IMAGETHREADPOOL_H
+
+#include "ImageReader.h"
+
+//=============================================================================
+// Worker pool
+//
+// A small set of threads shared by all readers, created on first use. A job
+// is an index range split into chunks; the calling thread works on chunks
+// too and the call returns once the whole range is done.
+//=============================================================================
+
+// Processes items [begin, end) of a job
+typedef void (*ImageRangeFunc)(void *context, CKDWORD begin, CKDWORD end);
+
+// Number of threads that take part in a job, including the caller
+CKDWORD ImageWorkerCount();
+
+// Runs func over [0, count) in chunks of at least minChunk items.
+// Calls made from a worker thread, or while another job is running, are
+// executed serially on the calling thread.
+void ImageParallelFor(CKDWORD count, CKDWORD minChunk, ImageRangeFunc func, void *context);
+
+// Waits for a running job, stops the worker threads and frees the pool. Must
+// not be called from DllMain or from a job. A later call to ImageParallelFor
+// or ImageWorkerCount starts a new pool.
+void ImageShutdownPool();
+
+//=============================================================================
+// One-time initialization
+//
+// Lookup tables and kernel choices built on first use, which may be from
+// several threads at once. The first caller runs init while later ones wait,
+// and every caller sees all of init's writes once ImageCallOnce returns.
+//=============================================================================
+
+typedef void (*ImageInitFunc)();
+
+// State of a one-time initialization; a zero-initialized static
+typedef volatile long ImageOnce;
+
+void ImageCallOnce(ImageOnce &once, ImageInitFunc init);
+
+//=============================================================================
+// Background worker
+//
+// One thread that runs a single task at a time while its owner carries on,
+// e.g. decoding the next movie frame ahead of playback. The thread is created
+// by the first Start call and stopped when the worker is destroyed.
+//=============================================================================
+
+typedef void (*ImageTaskFunc)(void *context);
+
+struct ImageWorkerState;
+
+class ImageBackgroundWorker
+{
+public:
+    ImageBackgroundWorker();
+    ~ImageBackgroundWorker();
+
+    // Runs func(context) on the worker thread; the previous task must have
+    // been waited for. Returns FALSE (and runs nothing) if no thread is available.
+    CKBOOL Start(ImageTaskFunc func, void *context);
+
+    // Blocks until the current task, if any, has finished
+    void Wait();
+
+    CKBOOL IsBusy() const { return m_Busy; }
+
+private:
+    ImageWorkerState *m_State;
+    CKBOOL m_Busy;
+
+    ImageBackgroundWorker(const ImageBackgroundWorker &);
+    ImageBackgroundWorker &operator=(const ImageBackgroundWorker &);
+};
+
+#endif // IMAGETHREADPOOL_H
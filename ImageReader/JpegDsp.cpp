@@ -0,0 +1,813 @@
+#include "JpegDsp.h"
+#include "ImageSimd.h"
+#include "ImageThreadPool.h"
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+//=============================================================================
+// Helpers
+//=============================================================================
+static inline int Descale(int x, int n) { return (x + (1 << (n - 1))) >> n; }
+
+static inline int Clamp16(int v) { return v < -32768 ? -32768 : (v > 32767 ? 32767 : v); }
+
+static inline CKBYTE ClampByte(int v) { return (CKBYTE)(v < 0 ? 0 : (v > 255 ? 255 : v)); }
+
+//=============================================================================
+// Full 8x8 Inverse DCT
+//
+// libjpeg's accurate integer IDCT (Loeffler, Ligtenberg and Moschytz) with 13
+// fractional bits in the constants and 2 extra bits kept between the passes.
+// Dequantization wraps to 16 bits and the first pass saturates to 16 bits,
+// which is what the SIMD versions do; real JPEG data never reaches either limit.
+//=============================================================================
+#define IDCT_CONST_BITS 13
+#define IDCT_PASS1_BITS 2
+
+#define FIX_0_298631336 2446
+#define FIX_0_390180644 3196
+#define FIX_0_541196100 4433
+#define FIX_0_765366865 6270
+#define FIX_0_899976223 7373
+#define FIX_1_175875602 9633
+#define FIX_1_501321110 12299
+#define FIX_1_847759065 15137
+#define FIX_1_961570560 16069
+#define FIX_2_053119869 16819
+#define FIX_2_562915447 20995
+#define FIX_3_072711026 25172
+
+// One 1-D pass over 8 values; out receives the undescaled results
+static inline void Idct1D(const int *in, int *out)
+{
+    // Even part
+    int z2 = in[2];
+    int z3 = in[6];
+    int z1 = (z2 + z3) * FIX_0_541196100;
+    int tmp2 = z1 - z3 * FIX_1_847759065;
+    int tmp3 = z1 + z2 * FIX_0_765366865;
+    int tmp0 = (in[0] + in[4]) * (1 << IDCT_CONST_BITS);
+    int tmp1 = (in[0] - in[4]) * (1 << IDCT_CONST_BITS);
+    int tmp10 = tmp0 + tmp3;
+    int tmp13 = tmp0 - tmp3;
+    int tmp11 = tmp1 + tmp2;
+    int tmp12 = tmp1 - tmp2;
+
+    // Odd part
+    tmp0 = in[7];
+    tmp1 = in[5];
+    tmp2 = in[3];
+    tmp3 = in[1];
+    z1 = tmp0 + tmp3;
+    z2 = tmp1 + tmp2;
+    z3 = tmp0 + tmp2;
+    int z4 = tmp1 + tmp3;
+    int z5 = (z3 + z4) * FIX_1_175875602;
+    tmp0 *= FIX_0_298631336;
+    tmp1 *= FIX_2_053119869;
+    tmp2 *= FIX_3_072711026;
+    tmp3 *= FIX_1_501321110;
+    z1 *= -FIX_0_899976223;
+    z2 *= -FIX_2_562915447;
+    z3 = z3 * -FIX_1_961570560 + z5;
+    z4 = z4 * -FIX_0_390180644 + z5;
+    tmp0 += z1 + z3;
+    tmp1 += z2 + z4;
+    tmp2 += z2 + z3;
+    tmp3 += z1 + z4;
+
+    out[0] = tmp10 + tmp3;
+    out[7] = tmp10 - tmp3;
+    out[1] = tmp11 + tmp2;
+    out[6] = tmp11 - tmp2;
+    out[2] = tmp12 + tmp1;
+    out[5] = tmp12 - tmp1;
+    out[3] = tmp13 + tmp0;
+    out[4] = tmp13 - tmp0;
+}
+
+// Value of every pixel of a block whose AC coefficients are all zero
+static inline CKBYTE IdctDcValue(const short *coefs, const CKWORD *quant)
+{
+    int dc = Clamp16((short)(coefs[0] * quant[0]) * (1 << IDCT_PASS1_BITS));
+    return ClampByte(Descale(dc, IDCT_PASS1_BITS + 3) + 128);
+}
+
+static CKBOOL IsDcOnly(const short *coefs)
+{
+    for (int i = 1; i < 64; i++)
+        if (coefs[i])
+            return FALSE;
+    return TRUE;
+}
+
+static void FillBlock(CKBYTE *dst, int stride, int size, CKBYTE value)
+{
+    for (int y = 0; y < size; y++, dst += stride)
+        memset(dst, value, size);
+}
+
+static void Idct8x8Scalar(const short *coefs, int count, const CKWORD *quant, CKBYTE *dst, int stride)
+{
+    for (int b = 0; b < count; b++, coefs += 64, dst += 8)
+    {
+        if (IsDcOnly(coefs))
+        {
+            FillBlock(dst, stride, 8, IdctDcValue(coefs, quant));
+            continue;
+        }
+
+        int ws[64];
+        int in[8];
+        int out[8];
+        for (int c = 0; c < 8; c++)
+        {
+            for (int r = 0; r < 8; r++)
+                in[r] = (short)(coefs[r * 8 + c] * quant[r * 8 + c]);
+            Idct1D(in, out);
+            for (int r = 0; r < 8; r++)
+                ws[r * 8 + c] = Clamp16(Descale(out[r], IDCT_CONST_BITS - IDCT_PASS1_BITS));
+        }
+        CKBYTE *row = dst;
+        for (int r = 0; r < 8; r++, row += stride)
+        {
+            Idct1D(ws + r * 8, out);
+            for (int c = 0; c < 8; c++)
+                row[c] = ClampByte(Descale(out[c], IDCT_CONST_BITS + IDCT_PASS1_BITS + 3) + 128);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// SSE2: one block, columns in 16-bit lanes. Every product goes through
+// pmaddwd, with the odd-part rotations folded into per-input constants so no
+// 16-bit sum of inputs is ever formed.
+//-----------------------------------------------------------------------------
+#define IDCT_PAIR(a, b) (int)(((CKDWORD)(CKWORD)(short)(a)) | ((CKDWORD)(CKWORD)(short)(b) << 16))
+
+// Constants for the (row 2, row 6), (row 0, row 4), (row 7, row 1) and (row 5, row 3) pairs
+#define IDCT_K_EVEN2 IDCT_PAIR(FIX_0_541196100, FIX_0_541196100 - FIX_1_847759065)
+#define IDCT_K_EVEN3 IDCT_PAIR(FIX_0_541196100 + FIX_0_765366865, FIX_0_541196100)
+#define IDCT_K_EVEN0 IDCT_PAIR(1 << IDCT_CONST_BITS, 1 << IDCT_CONST_BITS)
+#define IDCT_K_EVEN1 IDCT_PAIR(1 << IDCT_CONST_BITS, -(1 << IDCT_CONST_BITS))
+#define IDCT_K_ODD0_71 IDCT_PAIR(FIX_0_298631336 - FIX_0_899976223 + FIX_1_175875602 - FIX_1_961570560, FIX_1_175875602 - FIX_0_899976223)
+#define IDCT_K_ODD0_53 IDCT_PAIR(FIX_1_175875602, FIX_1_175875602 - FIX_1_961570560)
+#define IDCT_K_ODD1_71 IDCT_PAIR(FIX_1_175875602, FIX_1_175875602 - FIX_0_390180644)
+#define IDCT_K_ODD1_53 IDCT_PAIR(FIX_2_053119869 - FIX_2_562915447 + FIX_1_175875602 - FIX_0_390180644, FIX_1_175875602 - FIX_2_562915447)
+#define IDCT_K_ODD2_71 IDCT_PAIR(FIX_1_175875602 - FIX_1_961570560, FIX_1_175875602)
+#define IDCT_K_ODD2_53 IDCT_PAIR(FIX_1_175875602 - FIX_2_562915447, FIX_3_072711026 - FIX_2_562915447 + FIX_1_175875602 - FIX_1_961570560)
+#define IDCT_K_ODD3_71 IDCT_PAIR(FIX_1_175875602 - FIX_0_899976223, FIX_1_501321110 - FIX_0_899976223 + FIX_1_175875602 - FIX_0_390180644)
+#define IDCT_K_ODD3_53 IDCT_PAIR(FIX_1_175875602 - FIX_0_390180644, FIX_1_175875602)
+
+static inline void Transpose8x8SSE2(__m128i r[8])
+{
+    __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+    __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+    __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+    __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+    __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+    __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+    __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+    __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+    __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+    __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+    __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+    __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+    __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+    __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+    __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+    __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+    r[0] = _mm_unpacklo_epi64(b0, b4);
+    r[1] = _mm_unpackhi_epi64(b0, b4);
+    r[2] = _mm_unpacklo_epi64(b1, b5);
+    r[3] = _mm_unpackhi_epi64(b1, b5);
+    r[4] = _mm_unpacklo_epi64(b2, b6);
+    r[5] = _mm_unpackhi_epi64(b2, b6);
+    r[6] = _mm_unpacklo_epi64(b3, b7);
+    r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+// 1-D pass on half a register set (four lanes, 32-bit results)
+static inline void IdctHalfSSE2(__m128i p26, __m128i p04, __m128i p71, __m128i p53, __m128i out[8])
+{
+    __m128i tmp2 = _mm_madd_epi16(p26, _mm_set1_epi32(IDCT_K_EVEN2));
+    __m128i tmp3 = _mm_madd_epi16(p26, _mm_set1_epi32(IDCT_K_EVEN3));
+    __m128i tmp0 = _mm_madd_epi16(p04, _mm_set1_epi32(IDCT_K_EVEN0));
+    __m128i tmp1 = _mm_madd_epi16(p04, _mm_set1_epi32(IDCT_K_EVEN1));
+    __m128i tmp10 = _mm_add_epi32(tmp0, tmp3);
+    __m128i tmp13 = _mm_sub_epi32(tmp0, tmp3);
+    __m128i tmp11 = _mm_add_epi32(tmp1, tmp2);
+    __m128i tmp12 = _mm_sub_epi32(tmp1, tmp2);
+
+    __m128i o0 = _mm_add_epi32(_mm_madd_epi16(p71, _mm_set1_epi32(IDCT_K_ODD0_71)),
+                               _mm_madd_epi16(p53, _mm_set1_epi32(IDCT_K_ODD0_53)));
+    __m128i o1 = _mm_add_epi32(_mm_madd_epi16(p71, _mm_set1_epi32(IDCT_K_ODD1_71)),
+                               _mm_madd_epi16(p53, _mm_set1_epi32(IDCT_K_ODD1_53)));
+    __m128i o2 = _mm_add_epi32(_mm_madd_epi16(p71, _mm_set1_epi32(IDCT_K_ODD2_71)),
+                               _mm_madd_epi16(p53, _mm_set1_epi32(IDCT_K_ODD2_53)));
+    __m128i o3 = _mm_add_epi32(_mm_madd_epi16(p71, _mm_set1_epi32(IDCT_K_ODD3_71)),
+                               _mm_madd_epi16(p53, _mm_set1_epi32(IDCT_K_ODD3_53)));
+
+    out[0] = _mm_add_epi32(tmp10, o3);
+    out[7] = _mm_sub_epi32(tmp10, o3);
+    out[1] = _mm_add_epi32(tmp11, o2);
+    out[6] = _mm_sub_epi32(tmp11, o2);
+    out[2] = _mm_add_epi32(tmp12, o1);
+    out[5] = _mm_sub_epi32(tmp12, o1);
+    out[3] = _mm_add_epi32(tmp13, o0);
+    out[4] = _mm_sub_epi32(tmp13, o0);
+}
+
+// 1-D pass over eight registers (lane = position along the other axis)
+static inline void IdctPassSSE2(__m128i r[8], int shift)
+{
+    __m128i lo[8];
+    __m128i hi[8];
+    IdctHalfSSE2(_mm_unpacklo_epi16(r[2], r[6]), _mm_unpacklo_epi16(r[0], r[4]), _mm_unpacklo_epi16(r[7], r[1]),
+                 _mm_unpacklo_epi16(r[5], r[3]), lo);
+    IdctHalfSSE2(_mm_unpackhi_epi16(r[2], r[6]), _mm_unpackhi_epi16(r[0], r[4]), _mm_unpackhi_epi16(r[7], r[1]),
+                 _mm_unpackhi_epi16(r[5], r[3]), hi);
+
+    const __m128i round = _mm_set1_epi32(1 << (shift - 1));
+    for (int i = 0; i < 8; i++)
+    {
+        __m128i l = _mm_srai_epi32(_mm_add_epi32(lo[i], round), shift);
+        __m128i h = _mm_srai_epi32(_mm_add_epi32(hi[i], round), shift);
+        r[i] = _mm_packs_epi32(l, h);
+    }
+}
+
+static void Idct8x8SSE2(const short *coefs, int count, const CKWORD *quant, CKBYTE *dst, int stride)
+{
+    for (int b = 0; b < count; b++, coefs += 64, dst += 8)
+    {
+        __m128i r[8];
+        // Coefficient 0 is masked out of the zero test
+        __m128i ac = _mm_setr_epi16(0, -1, -1, -1, -1, -1, -1, -1);
+        for (int i = 0; i < 8; i++)
+        {
+            __m128i c = _mm_loadu_si128((const __m128i *)(coefs + i * 8));
+            ac = i ? _mm_or_si128(ac, c) : _mm_and_si128(ac, c);
+            r[i] = _mm_mullo_epi16(c, _mm_loadu_si128((const __m128i *)(quant + i * 8)));
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(ac, _mm_setzero_si128())) == 0xFFFF)
+        {
+            FillBlock(dst, stride, 8, IdctDcValue(coefs, quant));
+            continue;
+        }
+
+        IdctPassSSE2(r, IDCT_CONST_BITS - IDCT_PASS1_BITS);
+        Transpose8x8SSE2(r);
+        IdctPassSSE2(r, IDCT_CONST_BITS + IDCT_PASS1_BITS + 3);
+        Transpose8x8SSE2(r);
+
+        const __m128i center = _mm_set1_epi16(128);
+        CKBYTE *row = dst;
+        for (int i = 0; i < 8; i += 2)
+        {
+            __m128i px = _mm_packus_epi16(_mm_adds_epi16(r[i], center), _mm_adds_epi16(r[i + 1], center));
+            _mm_storel_epi64((__m128i *)row, px);
+            _mm_storel_epi64((__m128i *)(row + stride), _mm_srli_si128(px, 8));
+            row += stride * 2;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// AVX2: the SSE2 algorithm on two blocks at once, one per 128-bit lane
+//-----------------------------------------------------------------------------
+IMAGE_TARGET_AVX2 static inline void Transpose8x8AVX2(__m256i r[8])
+{
+    __m256i a0 = _mm256_unpacklo_epi16(r[0], r[1]);
+    __m256i a1 = _mm256_unpackhi_epi16(r[0], r[1]);
+    __m256i a2 = _mm256_unpacklo_epi16(r[2], r[3]);
+    __m256i a3 = _mm256_unpackhi_epi16(r[2], r[3]);
+    __m256i a4 = _mm256_unpacklo_epi16(r[4], r[5]);
+    __m256i a5 = _mm256_unpackhi_epi16(r[4], r[5]);
+    __m256i a6 = _mm256_unpacklo_epi16(r[6], r[7]);
+    __m256i a7 = _mm256_unpackhi_epi16(r[6], r[7]);
+    __m256i b0 = _mm256_unpacklo_epi32(a0, a2);
+    __m256i b1 = _mm256_unpackhi_epi32(a0, a2);
+    __m256i b2 = _mm256_unpacklo_epi32(a1, a3);
+    __m256i b3 = _mm256_unpackhi_epi32(a1, a3);
+    __m256i b4 = _mm256_unpacklo_epi32(a4, a6);
+    __m256i b5 = _mm256_unpackhi_epi32(a4, a6);
+    __m256i b6 = _mm256_unpacklo_epi32(a5, a7);
+    __m256i b7 = _mm256_unpackhi_epi32(a5, a7);
+    r[0] = _mm256_unpacklo_epi64(b0, b4);
+    r[1] = _mm256_unpackhi_epi64(b0, b4);
+    r[2] = _mm256_unpacklo_epi64(b1, b5);
+    r[3] = _mm256_unpackhi_epi64(b1, b5);
+    r[4] = _mm256_unpacklo_epi64(b2, b6);
+    r[5] = _mm256_unpackhi_epi64(b2, b6);
+    r[6] = _mm256_unpacklo_epi64(b3, b7);
+    r[7] = _mm256_unpackhi_epi64(b3, b7);
+}
+
+IMAGE_TARGET_AVX2 static inline void IdctHalfAVX2(__m256i p26, __m256i p04, __m256i p71, __m256i p53, __m256i out[8])
+{
+    __m256i tmp2 = _mm256_madd_epi16(p26, _mm256_set1_epi32(IDCT_K_EVEN2));
+    __m256i tmp3 = _mm256_madd_epi16(p26, _mm256_set1_epi32(IDCT_K_EVEN3));
+    __m256i tmp0 = _mm256_madd_epi16(p04, _mm256_set1_epi32(IDCT_K_EVEN0));
+    __m256i tmp1 = _mm256_madd_epi16(p04, _mm256_set1_epi32(IDCT_K_EVEN1));
+    __m256i tmp10 = _mm256_add_epi32(tmp0, tmp3);
+    __m256i tmp13 = _mm256_sub_epi32(tmp0, tmp3);
+    __m256i tmp11 = _mm256_add_epi32(tmp1, tmp2);
+    __m256i tmp12 = _mm256_sub_epi32(tmp1, tmp2);
+
+    __m256i o0 = _mm256_add_epi32(_mm256_madd_epi16(p71, _mm256_set1_epi32(IDCT_K_ODD0_71)),
+                                  _mm256_madd_epi16(p53, _mm256_set1_epi32(IDCT_K_ODD0_53)));
+    __m256i o1 = _mm256_add_epi32(_mm256_madd_epi16(p71, _mm256_set1_epi32(IDCT_K_ODD1_71)),
+                                  _mm256_madd_epi16(p53, _mm256_set1_epi32(IDCT_K_ODD1_53)));
+    __m256i o2 = _mm256_add_epi32(_mm256_madd_epi16(p71, _mm256_set1_epi32(IDCT_K_ODD2_71)),
+                                  _mm256_madd_epi16(p53, _mm256_set1_epi32(IDCT_K_ODD2_53)));
+    __m256i o3 = _mm256_add_epi32(_mm256_madd_epi16(p71, _mm256_set1_epi32(IDCT_K_ODD3_71)),
+                                  _mm256_madd_epi16(p53, _mm256_set1_epi32(IDCT_K_ODD3_53)));
+
+    out[0] = _mm256_add_epi32(tmp10, o3);
+    out[7] = _mm256_sub_epi32(tmp10, o3);
+    out[1] = _mm256_add_epi32(tmp11, o2);
+    out[6] = _mm256_sub_epi32(tmp11, o2);
+    out[2] = _mm256_add_epi32(tmp12, o1);
+    out[5] = _mm256_sub_epi32(tmp12, o1);
+    out[3] = _mm256_add_epi32(tmp13, o0);
+    out[4] = _mm256_sub_epi32(tmp13, o0);
+}
+
+IMAGE_TARGET_AVX2 static inline void IdctPassAVX2(__m256i r[8], int shift)
+{
+    __m256i lo[8];
+    __m256i hi[8];
+    IdctHalfAVX2(_mm256_unpacklo_epi16(r[2], r[6]), _mm256_unpacklo_epi16(r[0], r[4]),
+                 _mm256_unpacklo_epi16(r[7], r[1]), _mm256_unpacklo_epi16(r[5], r[3]), lo);
+    IdctHalfAVX2(_mm256_unpackhi_epi16(r[2], r[6]), _mm256_unpackhi_epi16(r[0], r[4]),
+                 _mm256_unpackhi_epi16(r[7], r[1]), _mm256_unpackhi_epi16(r[5], r[3]), hi);
+
+    const __m256i round = _mm256_set1_epi32(1 << (shift - 1));
+    for (int i = 0; i < 8; i++)
+    {
+        __m256i l = _mm256_srai_epi32(_mm256_add_epi32(lo[i], round), shift);
+        __m256i h = _mm256_srai_epi32(_mm256_add_epi32(hi[i], round), shift);
+        r[i] = _mm256_packs_epi32(l, h);
+    }
+}
+
+IMAGE_TARGET_AVX2 static void Idct8x8AVX2(const short *coefs, int count, const CKWORD *quant, CKBYTE *dst, int stride)
+{
+    int b = 0;
+    for (; b + 2 <= count; b += 2, coefs += 128, dst += 16)
+    {
+        // Two DC-only blocks are cheaper to fill than to transform
+        if (IsDcOnly(coefs) && IsDcOnly(coefs + 64))
+        {
+            FillBlock(dst, stride, 8, IdctDcValue(coefs, quant));
+            FillBlock(dst + 8, stride, 8, IdctDcValue(coefs + 64, quant));
+            continue;
+        }
+
+        __m256i r[8];
+        for (int i = 0; i < 8; i++)
+        {
+            __m256i c = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(coefs + i * 8))),
+                                                _mm_loadu_si128((const __m128i *)(coefs + 64 + i * 8)), 1);
+            __m256i q = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(quant + i * 8)));
+            r[i] = _mm256_mullo_epi16(c, q);
+        }
+
+        IdctPassAVX2(r, IDCT_CONST_BITS - IDCT_PASS1_BITS);
+        Transpose8x8AVX2(r);
+        IdctPassAVX2(r, IDCT_CONST_BITS + IDCT_PASS1_BITS + 3);
+        Transpose8x8AVX2(r);
+
+        const __m256i center = _mm256_set1_epi16(128);
+        CKBYTE *row = dst;
+        for (int i = 0; i < 8; i += 2)
+        {
+            __m256i px = _mm256_packus_epi16(_mm256_adds_epi16(r[i], center), _mm256_adds_epi16(r[i + 1], center));
+            __m128i a = _mm256_castsi256_si128(px);
+            __m128i c = _mm256_extracti128_si256(px, 1);
+            _mm_storel_epi64((__m128i *)row, a);
+            _mm_storel_epi64((__m128i *)(row + 8), c);
+            _mm_storel_epi64((__m128i *)(row + stride), _mm_srli_si128(a, 8));
+            _mm_storel_epi64((__m128i *)(row + stride + 8), _mm_srli_si128(c, 8));
+            row += stride * 2;
+        }
+    }
+    if (b < count)
+        Idct8x8SSE2(coefs, count - b, quant, dst, stride);
+}
+
+//=============================================================================
+// Reduced Inverse DCTs
+//
+// Scaled decoding produces 4x4, 2x2 or 1x1 pixels per block straight from
+// the low-frequency coefficients (libjpeg's reduced-size transforms), so the
+// remaining coefficients are never touched.
+//=============================================================================
+#define FIX_0_211164243 1730
+#define FIX_0_509795579 4176
+#define FIX_0_601344887 4926
+#define FIX_0_720959822 5906
+#define FIX_0_850430095 6967
+#define FIX_1_061594337 8697
+#define FIX_1_272758580 10426
+#define FIX_1_451774981 11893
+#define FIX_2_172734803 17799
+#define FIX_3_624509785 29692
+
+// These transforms stay scalar, so they can afford 64-bit sums: unlike the
+// 16-bit lanes of the full IDCT, 32 bits would overflow on corrupt data
+static inline int64_t DescaleWide(int64_t x, int n) { return (x + ((int64_t)1 << (n - 1))) >> n; }
+
+static inline CKBYTE ClampWide(int64_t v) { return (CKBYTE)(v < 0 ? 0 : (v > 255 ? 255 : v)); }
+
+static void Idct4x4Scalar(const short *coefs, int count, const CKWORD *quant, CKBYTE *dst, int stride)
+{
+    for (int b = 0; b < count; b++, coefs += 64, dst += 4)
+    {
+        int64_t ws[8 * 4];
+
+        // Pass 1: columns into 4 rows; column 4 is not needed by pass 2
+        for (int c = 0; c < 8; c++)
+        {
+            if (c == 4)
+                continue;
+            const short *in = coefs + c;
+            const CKWORD *q = quant + c;
+            if (!in[8] && !in[16] && !in[24] && !in[40] && !in[48] && !in[56])
+            {
+                int64_t dc = (int64_t)(in[0] * q[0]) * (1 << IDCT_PASS1_BITS);
+                for (int r = 0; r < 4; r++)
+                    ws[r * 8 + c] = dc;
+                continue;
+            }
+
+            int64_t tmp0 = (int64_t)(in[0] * q[0]) * (1 << (IDCT_CONST_BITS + 1));
+            int64_t tmp2 = (int64_t)(in[16] * q[16]) * FIX_1_847759065 - (int64_t)(in[48] * q[48]) * FIX_0_765366865;
+            int64_t tmp10 = tmp0 + tmp2;
+            int64_t tmp12 = tmp0 - tmp2;
+
+            int64_t z1 = in[56] * q[56];
+            int64_t z2 = in[40] * q[40];
+            int64_t z3 = in[24] * q[24];
+            int64_t z4 = in[8] * q[8];
+            tmp0 = -z1 * FIX_0_211164243 + z2 * FIX_1_451774981 - z3 * FIX_2_172734803 + z4 * FIX_1_061594337;
+            tmp2 = -z1 * FIX_0_509795579 - z2 * FIX_0_601344887 + z3 * FIX_0_899976223 + z4 * FIX_2_562915447;
+
+            const int shift = IDCT_CONST_BITS - IDCT_PASS1_BITS + 1;
+            ws[0 * 8 + c] = DescaleWide(tmp10 + tmp2, shift);
+            ws[3 * 8 + c] = DescaleWide(tmp10 - tmp2, shift);
+            ws[1 * 8 + c] = DescaleWide(tmp12 + tmp0, shift);
+            ws[2 * 8 + c] = DescaleWide(tmp12 - tmp0, shift);
+        }
+
+        // Pass 2: rows
+        CKBYTE *row = dst;
+        for (int r = 0; r < 4; r++, row += stride)
+        {
+            const int64_t *w = ws + r * 8;
+            if (!w[1] && !w[2] && !w[3] && !w[5] && !w[6] && !w[7])
+            {
+                memset(row, ClampWide(DescaleWide(w[0], IDCT_PASS1_BITS + 3) + 128), 4);
+                continue;
+            }
+
+            int64_t tmp0 = w[0] * (1 << (IDCT_CONST_BITS + 1));
+            int64_t tmp2 = w[2] * FIX_1_847759065 - w[6] * FIX_0_765366865;
+            int64_t tmp10 = tmp0 + tmp2;
+            int64_t tmp12 = tmp0 - tmp2;
+            tmp0 = -w[7] * FIX_0_211164243 + w[5] * FIX_1_451774981 - w[3] * FIX_2_172734803 + w[1] * FIX_1_061594337;
+            tmp2 = -w[7] * FIX_0_509795579 - w[5] * FIX_0_601344887 + w[3] * FIX_0_899976223 + w[1] * FIX_2_562915447;
+
+            const int shift = IDCT_CONST_BITS + IDCT_PASS1_BITS + 3 + 1;
+            row[0] = ClampWide(DescaleWide(tmp10 + tmp2, shift) + 128);
+            row[3] = ClampWide(DescaleWide(tmp10 - tmp2, shift) + 128);
+            row[1] = ClampWide(DescaleWide(tmp12 + tmp0, shift) + 128);
+            row[2] = ClampWide(DescaleWide(tmp12 - tmp0, shift) + 128);
+        }
+    }
+}
+
+static void Idct2x2Scalar(const short *coefs, int count, const CKWORD *quant, CKBYTE *dst, int stride)
+{
+    for (int b = 0; b < count; b++, coefs += 64, dst += 2)
+    {
+        int64_t ws[8 * 2];
+
+        // Pass 1: columns 0, 1, 3, 5 and 7 into 2 rows
+        for (int c = 0; c < 8; c++)
+        {
+            if (c == 2 || c == 4 || c == 6)
+                continue;
+            const short *in = coefs + c;
+            const CKWORD *q = quant + c;
+            if (!in[8] && !in[24] && !in[40] && !in[56])
+            {
+                int64_t dc = (int64_t)(in[0] * q[0]) * (1 << IDCT_PASS1_BITS);
+                ws[c] = dc;
+                ws[8 + c] = dc;
+                continue;
+            }
+
+            int64_t tmp10 = (int64_t)(in[0] * q[0]) * (1 << (IDCT_CONST_BITS + 2));
+            int64_t tmp0 = -(int64_t)(in[56] * q[56]) * FIX_0_720959822 + (int64_t)(in[40] * q[40]) * FIX_0_850430095 -
+                       (int64_t)(in[24] * q[24]) * FIX_1_272758580 + (int64_t)(in[8] * q[8]) * FIX_3_624509785;
+
+            const int shift = IDCT_CONST_BITS - IDCT_PASS1_BITS + 2;
+            ws[c] = DescaleWide(tmp10 + tmp0, shift);
+            ws[8 + c] = DescaleWide(tmp10 - tmp0, shift);
+        }
+
+        // Pass 2: rows
+        CKBYTE *row = dst;
+        for (int r = 0; r < 2; r++, row += stride)
+        {
+            const int64_t *w = ws + r * 8;
+            int64_t tmp10 = w[0] * (1 << (IDCT_CONST_BITS + 2));
+            int64_t tmp0 = -w[7] * FIX_0_720959822 + w[5] * FIX_0_850430095 - w[3] * FIX_1_272758580 +
+                       w[1] * FIX_3_624509785;
+
+            const int shift = IDCT_CONST_BITS + IDCT_PASS1_BITS + 3 + 2;
+            row[0] = ClampWide(DescaleWide(tmp10 + tmp0, shift) + 128);
+            row[1] = ClampWide(DescaleWide(tmp10 - tmp0, shift) + 128);
+        }
+    }
+}
+
+static void Idct1x1Scalar(const short *coefs, int count, const CKWORD *quant, CKBYTE *dst, int)
+{
+    for (int b = 0; b < count; b++, coefs += 64)
+        dst[b] = ClampByte(Descale(coefs[0] * quant[0], 3) + 128);
+}
+
+//=============================================================================
+// Fancy Upsampling
+//
+// Each output sample is a 3:1 weighted mix of the nearest and the next
+// nearest input sample (in both directions for 2x2), with libjpeg's
+// alternating rounding biases.
+//=============================================================================
+static void UpsampleH2V1Scalar(const CKBYTE *src, int width, CKBYTE *dst)
+{
+    dst[0] = src[0];
+    dst[1] = (CKBYTE)((src[0] * 3 + src[1] + 2) >> 2);
+    for (int x = 1; x < width - 1; x++)
+    {
+        int v = src[x] * 3;
+        dst[x * 2] = (CKBYTE)((v + src[x - 1] + 1) >> 2);
+        dst[x * 2 + 1] = (CKBYTE)((v + src[x + 1] + 2) >> 2);
+    }
+    int last = width - 1;
+    dst[last * 2] = (CKBYTE)((src[last] * 3 + src[last - 1] + 1) >> 2);
+    dst[last * 2 + 1] = src[last];
+}
+
+static void UpsampleH2V1SSE2(const CKBYTE *src, int width, CKBYTE *dst)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i two = _mm_set1_epi16(2);
+
+    // Interior samples in groups of 8, reading one sample on each side
+    int x = 1;
+    for (; x + 9 <= width; x += 8)
+    {
+        __m128i prev = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src + x - 1)), zero);
+        __m128i cur = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src + x)), zero);
+        __m128i next = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src + x + 1)), zero);
+        __m128i cur3 = _mm_add_epi16(cur, _mm_add_epi16(cur, cur));
+        __m128i even = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(cur3, prev), one), 2);
+        __m128i odd = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(cur3, next), two), 2);
+        __m128i packed = _mm_packus_epi16(even, odd);
+        _mm_storeu_si128((__m128i *)(dst + x * 2), _mm_unpacklo_epi8(packed, _mm_srli_si128(packed, 8)));
+    }
+
+    dst[0] = src[0];
+    dst[1] = (CKBYTE)((src[0] * 3 + src[1] + 2) >> 2);
+    for (; x < width - 1; x++)
+    {
+        int v = src[x] * 3;
+        dst[x * 2] = (CKBYTE)((v + src[x - 1] + 1) >> 2);
+        dst[x * 2 + 1] = (CKBYTE)((v + src[x + 1] + 2) >> 2);
+    }
+    int last = width - 1;
+    dst[last * 2] = (CKBYTE)((src[last] * 3 + src[last - 1] + 1) >> 2);
+    dst[last * 2 + 1] = src[last];
+}
+
+static void UpsampleH2V2Scalar(const CKBYTE *nearRow, const CKBYTE *farRow, int width, CKBYTE *dst)
+{
+    int thisSum = nearRow[0] * 3 + farRow[0];
+    int nextSum = nearRow[1] * 3 + farRow[1];
+    dst[0] = (CKBYTE)((thisSum * 4 + 8) >> 4);
+    dst[1] = (CKBYTE)((thisSum * 3 + nextSum + 7) >> 4);
+    int lastSum = thisSum;
+    thisSum = nextSum;
+    for (int x = 1; x < width - 1; x++)
+    {
+        nextSum = nearRow[x + 1] * 3 + farRow[x + 1];
+        dst[x * 2] = (CKBYTE)((thisSum * 3 + lastSum + 8) >> 4);
+        dst[x * 2 + 1] = (CKBYTE)((thisSum * 3 + nextSum + 7) >> 4);
+        lastSum = thisSum;
+        thisSum = nextSum;
+    }
+    int last = width - 1;
+    dst[last * 2] = (CKBYTE)((thisSum * 3 + lastSum + 8) >> 4);
+    dst[last * 2 + 1] = (CKBYTE)((thisSum * 4 + 7) >> 4);
+}
+
+static inline __m128i ColumnSumSSE2(const CKBYTE *nearRow, const CKBYTE *farRow)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i n = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)nearRow), zero);
+    __m128i f = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)farRow), zero);
+    return _mm_add_epi16(_mm_add_epi16(n, _mm_add_epi16(n, n)), f);
+}
+
+static void UpsampleH2V2SSE2(const CKBYTE *nearRow, const CKBYTE *farRow, int width, CKBYTE *dst)
+{
+    const __m128i eight = _mm_set1_epi16(8);
+    const __m128i seven = _mm_set1_epi16(7);
+
+    int x = 1;
+    for (; x + 9 <= width; x += 8)
+    {
+        __m128i prev = ColumnSumSSE2(nearRow + x - 1, farRow + x - 1);
+        __m128i cur = ColumnSumSSE2(nearRow + x, farRow + x);
+        __m128i next = ColumnSumSSE2(nearRow + x + 1, farRow + x + 1);
+        __m128i cur3 = _mm_add_epi16(cur, _mm_add_epi16(cur, cur));
+        __m128i even = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(cur3, prev), eight), 4);
+        __m128i odd = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(cur3, next), seven), 4);
+        __m128i packed = _mm_packus_epi16(even, odd);
+        _mm_storeu_si128((__m128i *)(dst + x * 2), _mm_unpacklo_epi8(packed, _mm_srli_si128(packed, 8)));
+    }
+
+    int thisSum = nearRow[0] * 3 + farRow[0];
+    dst[0] = (CKBYTE)((thisSum * 4 + 8) >> 4);
+    dst[1] = (CKBYTE)((thisSum * 3 + nearRow[1] * 3 + farRow[1] + 7) >> 4);
+    for (; x < width - 1; x++)
+    {
+        int lastSum = nearRow[x - 1] * 3 + farRow[x - 1];
+        thisSum = nearRow[x] * 3 + farRow[x];
+        int nextSum = nearRow[x + 1] * 3 + farRow[x + 1];
+        dst[x * 2] = (CKBYTE)((thisSum * 3 + lastSum + 8) >> 4);
+        dst[x * 2 + 1] = (CKBYTE)((thisSum * 3 + nextSum + 7) >> 4);
+    }
+    int last = width - 1;
+    thisSum = nearRow[last] * 3 + farRow[last];
+    dst[last * 2] = (CKBYTE)((thisSum * 3 + nearRow[last - 1] * 3 + farRow[last - 1] + 8) >> 4);
+    dst[last * 2 + 1] = (CKBYTE)((thisSum * 4 + 7) >> 4);
+}
+
+//=============================================================================
+// YCbCr to BGRA32
+//
+// R = Y + 1.402 Cr, G = Y - 0.34414 Cb - 0.71414 Cr, B = Y + 1.772 Cb in
+// 16.16 fixed point, rounded like libjpeg's tables. The SIMD versions split
+// every constant into a 16-bit part for pmaddwd and a whole-number part:
+// 1.402 = 1 + 26345/65536, -0.71414 = -1 + 18734/65536, 1.772 = 2 - 14942/65536.
+//=============================================================================
+#define YCC_SCALEBITS 16
+#define YCC_HALF (1 << (YCC_SCALEBITS - 1))
+#define YCC_FIX(x) ((int)((x) * (1 << YCC_SCALEBITS) + 0.5))
+
+static void YCbCrToBGRAScalar(const CKBYTE *y, const CKBYTE *cb, const CKBYTE *cr, CKBYTE *dst, int count)
+{
+    for (int i = 0; i < count; i++, dst += 4)
+    {
+        int yy = y[i];
+        int b = cb[i] - 128;
+        int r = cr[i] - 128;
+        dst[0] = ClampByte(yy + ((YCC_FIX(1.77200) * b + YCC_HALF) >> YCC_SCALEBITS));
+        dst[1] = ClampByte(yy + ((-YCC_FIX(0.34414) * b - YCC_FIX(0.71414) * r + YCC_HALF) >> YCC_SCALEBITS));
+        dst[2] = ClampByte(yy + ((YCC_FIX(1.40200) * r + YCC_HALF) >> YCC_SCALEBITS));
+        dst[3] = 0xFF;
+    }
+}
+
+#define YCC_K_R IDCT_PAIR(YCC_FIX(1.40200) - 65536, 0)
+#define YCC_K_G IDCT_PAIR(65536 - YCC_FIX(0.71414), -YCC_FIX(0.34414))
+#define YCC_K_B IDCT_PAIR(0, YCC_FIX(1.77200) - 2 * 65536)
+
+// Fixed-point part of one channel for four (Cr, Cb) pairs
+static inline __m128i YccTermSSE2(__m128i pairs, int k)
+{
+    __m128i v = _mm_add_epi32(_mm_madd_epi16(pairs, _mm_set1_epi32(k)), _mm_set1_epi32(YCC_HALF));
+    return _mm_srai_epi32(v, YCC_SCALEBITS);
+}
+
+static void YCbCrToBGRASSE2(const CKBYTE *y, const CKBYTE *cb, const CKBYTE *cr, CKBYTE *dst, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(128);
+    const __m128i alpha = _mm_set1_epi8((char)0xFF);
+    int x = 0;
+    for (; x + 8 <= count; x += 8)
+    {
+        __m128i yy = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(y + x)), zero);
+        __m128i b = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(cb + x)), zero), bias);
+        __m128i r = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(cr + x)), zero), bias);
+        __m128i lo = _mm_unpacklo_epi16(r, b);
+        __m128i hi = _mm_unpackhi_epi16(r, b);
+
+        __m128i rTerm = _mm_packs_epi32(YccTermSSE2(lo, YCC_K_R), YccTermSSE2(hi, YCC_K_R));
+        __m128i gTerm = _mm_packs_epi32(YccTermSSE2(lo, YCC_K_G), YccTermSSE2(hi, YCC_K_G));
+        __m128i bTerm = _mm_packs_epi32(YccTermSSE2(lo, YCC_K_B), YccTermSSE2(hi, YCC_K_B));
+
+        __m128i rr = _mm_add_epi16(yy, _mm_add_epi16(rTerm, r));
+        __m128i gg = _mm_add_epi16(yy, _mm_sub_epi16(gTerm, r));
+        __m128i bb = _mm_add_epi16(yy, _mm_add_epi16(bTerm, _mm_add_epi16(b, b)));
+
+        __m128i bg = _mm_unpacklo_epi8(_mm_packus_epi16(bb, bb), _mm_packus_epi16(gg, gg));
+        __m128i ra = _mm_unpacklo_epi8(_mm_packus_epi16(rr, rr), alpha);
+        _mm_storeu_si128((__m128i *)(dst + x * 4), _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128((__m128i *)(dst + x * 4 + 16), _mm_unpackhi_epi16(bg, ra));
+    }
+    YCbCrToBGRAScalar(y + x, cb + x, cr + x, dst + x * 4, count - x);
+}
+
+IMAGE_TARGET_AVX2 static inline __m256i YccTermAVX2(__m256i pairs, int k)
+{
+    __m256i v = _mm256_add_epi32(_mm256_madd_epi16(pairs, _mm256_set1_epi32(k)), _mm256_set1_epi32(YCC_HALF));
+    return _mm256_srai_epi32(v, YCC_SCALEBITS);
+}
+
+IMAGE_TARGET_AVX2 static void YCbCrToBGRAAVX2(const CKBYTE *y, const CKBYTE *cb, const CKBYTE *cr, CKBYTE *dst,
+                                              int count)
+{
+    const __m256i bias = _mm256_set1_epi16(128);
+    const __m256i alpha = _mm256_set1_epi8((char)0xFF);
+    int x = 0;
+    for (; x + 16 <= count; x += 16)
+    {
+        __m256i yy = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(y + x)));
+        __m256i b = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(cb + x))), bias);
+        __m256i r = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(cr + x))), bias);
+        __m256i lo = _mm256_unpacklo_epi16(r, b);
+        __m256i hi = _mm256_unpackhi_epi16(r, b);
+
+        // Unpacking and packing both work per 128-bit lane, so pixel order is kept
+        __m256i rTerm = _mm256_packs_epi32(YccTermAVX2(lo, YCC_K_R), YccTermAVX2(hi, YCC_K_R));
+        __m256i gTerm = _mm256_packs_epi32(YccTermAVX2(lo, YCC_K_G), YccTermAVX2(hi, YCC_K_G));
+        __m256i bTerm = _mm256_packs_epi32(YccTermAVX2(lo, YCC_K_B), YccTermAVX2(hi, YCC_K_B));
+
+        __m256i rr = _mm256_add_epi16(yy, _mm256_add_epi16(rTerm, r));
+        __m256i gg = _mm256_add_epi16(yy, _mm256_sub_epi16(gTerm, r));
+        __m256i bb = _mm256_add_epi16(yy, _mm256_add_epi16(bTerm, _mm256_add_epi16(b, b)));
+
+        __m256i bg = _mm256_unpacklo_epi8(_mm256_packus_epi16(bb, bb), _mm256_packus_epi16(gg, gg));
+        __m256i ra = _mm256_unpacklo_epi8(_mm256_packus_epi16(rr, rr), alpha);
+        __m256i p0 = _mm256_unpacklo_epi16(bg, ra); // pixels 0-3 | 8-11
+        __m256i p1 = _mm256_unpackhi_epi16(bg, ra); // pixels 4-7 | 12-15
+        _mm256_storeu_si256((__m256i *)(dst + x * 4), _mm256_permute2x128_si256(p0, p1, 0x20));
+        _mm256_storeu_si256((__m256i *)(dst + x * 4 + 32), _mm256_permute2x128_si256(p0, p1, 0x31));
+    }
+    YCbCrToBGRASSE2(y + x, cb + x, cr + x, dst + x * 4, count - x);
+}
+
+//=============================================================================
+// Kernel Selection
+//=============================================================================
+static JpegDsp s_ScalarDsp;
+static JpegDsp s_Dsp;
+static ImageOnce s_DspOnce = 0;
+
+static void InitDsp()
+{
+    JpegDsp dsp;
+    dsp.idct[0] = Idct1x1Scalar;
+    dsp.idct[1] = Idct2x2Scalar;
+    dsp.idct[2] = Idct4x4Scalar;
+    dsp.idct[3] = Idct8x8Scalar;
+    dsp.upsampleH2V1 = UpsampleH2V1Scalar;
+    dsp.upsampleH2V2 = UpsampleH2V2Scalar;
+    dsp.yccToBGRA = YCbCrToBGRAScalar;
+    s_ScalarDsp = dsp;
+
+    if (ImageCpuHas(IMAGE_CPU_SSE2))
+    {
+        dsp.idct[3] = Idct8x8SSE2;
+        dsp.upsampleH2V1 = UpsampleH2V1SSE2;
+        dsp.upsampleH2V2 = UpsampleH2V2SSE2;
+        dsp.yccToBGRA = YCbCrToBGRASSE2;
+    }
+    if (ImageCpuHas(IMAGE_CPU_SSE2 | IMAGE_CPU_AVX2))
+    {
+        dsp.idct[3] = Idct8x8AVX2;
+        dsp.yccToBGRA = YCbCrToBGRAAVX2;
+    }
+    s_Dsp = dsp;
+}
+
+const JpegDsp &JPEG_GetDsp()
+{
+    ImageCallOnce(s_DspOnce, InitDsp);
+    return s_Dsp;
+}
+
+const JpegDsp &JPEG_GetScalarDsp()
+{
+    ImageCallOnce(s_DspOnce, InitDsp);
+    return s_ScalarDsp;
+}
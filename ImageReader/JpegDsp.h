@@ -0,0 +1,46 @@
+#ifndef JPEGDSP_H
+#define JPEGDSP_H
+
+#include "ImageReader.h"
+
+//=============================================================================
+// JPEG signal processing kernels
+//
+// Inverse DCT, chroma upsampling and color conversion. The integer math
+// follows the libjpeg "islow" IDCT, fancy (triangle) upsampling and YCbCr
+// tables, and the SSE2/AVX2 variants produce exactly the scalar results.
+//=============================================================================
+
+// Inverse DCT of count horizontally adjacent blocks. coefs holds 64
+// coefficients per block in natural (row-major) order and quant the matching
+// quantization table. Each block becomes size x size pixels: 8 is the full
+// transform, 4, 2 and 1 the reduced transforms used for scaled decoding.
+typedef void (*JpegIdctFunc)(const short *coefs, int count, const CKWORD *quant, CKBYTE *dst, int stride);
+
+// Fancy 2:1 horizontal upsampling of width (>= 2) samples into 2 * width
+typedef void (*JpegUpsampleH2Func)(const CKBYTE *src, int width, CKBYTE *dst);
+
+// Fancy 2:1 horizontal and vertical upsampling: near is the sample row the
+// output row lies in, far the adjacent row above or below it
+typedef void (*JpegUpsampleH2V2Func)(const CKBYTE *nearRow, const CKBYTE *farRow, int width, CKBYTE *dst);
+
+// Converts count YCbCr samples to opaque BGRA32
+typedef void (*JpegColorFunc)(const CKBYTE *y, const CKBYTE *cb, const CKBYTE *cr, CKBYTE *dst, int count);
+
+struct JpegDsp
+{
+    JpegIdctFunc idct[4]; // indexed by JPEG_IDCT_INDEX(size)
+    JpegUpsampleH2Func upsampleH2V1;
+    JpegUpsampleH2V2Func upsampleH2V2;
+    JpegColorFunc yccToBGRA;
+};
+
+#define JPEG_IDCT_INDEX(size) ((size) == 8 ? 3 : (size) == 4 ? 2 : (size) == 2 ? 1 : 0)
+
+// Kernels for the running CPU
+const JpegDsp &JPEG_GetDsp();
+
+// Scalar kernels, used as the reference for the SIMD ones
+const JpegDsp &JPEG_GetScalarDsp();
+
+#endif // JPEGDSP_H
@@ -0,0 +1,1414 @@
+#include "JpegReader.h"
+#include "JpegDsp.h"
+#include "ImageSimd.h"
+#include "ImageThreadPool.h"
+#include "ImageFileMap.h"
+
+#include "XArray.h"
+
+//=============================================================================
+// Byte Helpers
+//=============================================================================
+static CKDWORD ReadBE16(const CKBYTE *p) { return ((CKDWORD)p[0] << 8) | (CKDWORD)p[1]; }
+
+// Natural (row-major) position of the k-th coefficient in zigzag order. The
+// 16 extra entries absorb run lengths that overshoot the end of a corrupt
+// block, as in libjpeg.
+static const int ZigzagToNatural[64 + 16] = {
+    0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,  12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,
+    6,  7,  14, 21, 28, 35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51, 58, 59, 52, 45, 38, 31,
+    39, 46, 53, 60, 61, 54, 47, 55, 62, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63};
+
+//=============================================================================
+// Huffman Tables
+//=============================================================================
+#define HUFF_FAST_BITS 9
+
+struct JpegHuffTable
+{
+    CKBOOL defined;
+    // (length << 8) | symbol for codes up to HUFF_FAST_BITS long, 0 otherwise
+    CKWORD fast[1 << HUFF_FAST_BITS];
+    // AC codes whose extra bits also fit: (value << 8) | (run << 4) | total length, 0 otherwise
+    int acFast[1 << HUFF_FAST_BITS];
+    int maxCode[17]; // largest code of each length, -1 if there is none
+    int valOffset[17];
+    CKBYTE values[256];
+};
+
+static inline int Extend(int v, int s) { return v < (1 << (s - 1)) ? v - (1 << s) + 1 : v; }
+
+static CKBOOL BuildHuffTable(const CKBYTE *counts, const CKBYTE *symbols, CKBOOL isDc, JpegHuffTable &t)
+{
+    memset(&t, 0, sizeof(t));
+    int code = 0;
+    int k = 0;
+    for (int len = 1; len <= 16; len++)
+    {
+        int n = counts[len - 1];
+        t.valOffset[len] = k - code;
+        for (int i = 0; i < n; i++, k++, code++)
+        {
+            // Codes of all 1 bits are reserved
+            if (code >= (1 << len) - 1)
+                return FALSE;
+            if (len <= HUFF_FAST_BITS)
+            {
+                int shift = HUFF_FAST_BITS - len;
+                for (int j = 0; j < (1 << shift); j++)
+                    t.fast[(code << shift) | j] = (CKWORD)((len << 8) | symbols[k]);
+            }
+        }
+        t.maxCode[len] = n ? code - 1 : -1;
+        code <<= 1;
+    }
+    memcpy(t.values, symbols, k);
+
+    // DC symbols are bit counts of the difference that follows
+    if (isDc)
+    {
+        for (int i = 0; i < k; i++)
+            if (symbols[i] > 15)
+                return FALSE;
+    }
+
+    for (int i = 0; i < (1 << HUFF_FAST_BITS); i++)
+    {
+        CKDWORD e = t.fast[i];
+        if (!e)
+            continue;
+        int len = (int)(e >> 8);
+        int run = (int)(e >> 4) & 15;
+        int size = (int)e & 15;
+        if (size == 0 || len + size > HUFF_FAST_BITS)
+            continue;
+        int bits = (i >> (HUFF_FAST_BITS - len - size)) & ((1 << size) - 1);
+        t.acFast[i] = Extend(bits, size) * 256 + run * 16 + len + size;
+    }
+    t.defined = TRUE;
+    return TRUE;
+}
+
+//=============================================================================
+// Bit Reader
+//
+// Entropy-coded data is read MSB first through a 64-bit buffer. Stuffed
+// 0xFF 0x00 pairs become 0xFF; at a marker or at the end of the data the
+// reader stops and feeds zero bits, as libjpeg does for truncated scans.
+//=============================================================================
+struct JpegBitReader
+{
+    const CKBYTE *ptr;
+    const CKBYTE *end;
+    uint64_t bits; // MSB-aligned
+    int count;
+    CKBOOL marker;
+};
+
+static void InitBitReader(JpegBitReader &br, const CKBYTE *ptr, const CKBYTE *end)
+{
+    br.ptr = ptr;
+    br.end = end;
+    br.bits = 0;
+    br.count = 0;
+    br.marker = FALSE;
+}
+
+static void FillBits(JpegBitReader &br)
+{
+    while (br.count <= 56)
+    {
+        CKDWORD byte = 0;
+        if (!br.marker && br.ptr < br.end)
+        {
+            byte = *br.ptr;
+            if (byte != 0xFF)
+            {
+                br.ptr++;
+            }
+            else if (br.ptr + 1 < br.end && br.ptr[1] == 0)
+            {
+                br.ptr += 2;
+            }
+            else
+            {
+                br.marker = TRUE;
+                byte = 0;
+            }
+        }
+        br.bits |= (uint64_t)byte << (56 - br.count);
+        br.count += 8;
+    }
+}
+
+static inline void SkipBits(JpegBitReader &br, int n)
+{
+    br.bits <<= n;
+    br.count -= n;
+}
+
+// 1 <= n <= 16
+static inline int GetBits(JpegBitReader &br, int n)
+{
+    if (br.count < n)
+        FillBits(br);
+    int v = (int)(br.bits >> (64 - n));
+    SkipBits(br, n);
+    return v;
+}
+
+static inline int GetBit(JpegBitReader &br)
+{
+    if (br.count < 1)
+        FillBits(br);
+    int v = (int)(br.bits >> 63);
+    SkipBits(br, 1);
+    return v;
+}
+
+static inline int ReceiveExtend(JpegBitReader &br, int s) { return Extend(GetBits(br, s), s); }
+
+static inline int DecodeHuff(JpegBitReader &br, const JpegHuffTable &t)
+{
+    if (br.count < 16)
+        FillBits(br);
+    CKDWORD e = t.fast[br.bits >> (64 - HUFF_FAST_BITS)];
+    if (e)
+    {
+        SkipBits(br, (int)(e >> 8));
+        return (int)(e & 0xFF);
+    }
+    int code = (int)(br.bits >> 48);
+    for (int len = HUFF_FAST_BITS + 1; len <= 16; len++)
+    {
+        int c = code >> (16 - len);
+        if (c <= t.maxCode[len])
+        {
+            SkipBits(br, len);
+            return t.values[t.valOffset[len] + c];
+        }
+    }
+    // Not a valid code: like libjpeg, use 0 as the safest result
+    SkipBits(br, 16);
+    return 0;
+}
+
+//=============================================================================
+// Decoder State
+//=============================================================================
+enum JpegColorSpace
+{
+    JPEG_CS_GRAY,
+    JPEG_CS_YCBCR,
+    JPEG_CS_RGB,
+    JPEG_CS_CMYK,
+    JPEG_CS_YCCK
+};
+
+struct JpegComponent
+{
+    int id;
+    int h;
+    int v;
+    int tq;
+    int dcTable; // of the current scan
+    int acTable;
+    int dcPred;
+    CKBOOL quantLatched;
+    CKWORD quant[64]; // natural order, latched at the component's first scan
+
+    int blocksWide; // padded to whole MCUs
+    int blocksHigh;
+    int blocksPerLine; // blocks holding image data, the grid of non-interleaved scans
+    int blockRows;
+    short *coefs; // whole-image coefficients (buffered decoding only)
+
+    // Output stage
+    int idctSize; // 8, 4, 2 or 1 pixels per block side
+    CKBYTE *plane;
+    int planeStride;
+    int dsWidth; // component size at the output scale
+    int dsHeight;
+    int hExpand; // upsampling factors to the output size
+    int vExpand;
+    CKBOOL fancy;
+};
+
+struct JpegDecoder
+{
+    const CKBYTE *data;
+    CKDWORD size;
+    CKDWORD pos;
+    CKDWORD readFlags;
+    const JpegDsp *dsp;
+
+    CKWORD quant[4][64]; // natural order
+    CKBOOL quantDefined[4];
+    JpegHuffTable dcTables[4];
+    JpegHuffTable acTables[4];
+    int restartInterval;
+    CKBOOL sawJfif;
+    CKBOOL sawAdobe;
+    int adobeTransform;
+
+    // Frame
+    CKBOOL hasFrame;
+    CKBOOL progressive;
+    int width;
+    int height;
+    int compCount;
+    JpegComponent comps[4];
+    int hMax;
+    int vMax;
+    int mcusX;
+    int mcusY;
+
+    // Output
+    CKBOOL outputReady;
+    CKBOOL buffered; // coefficients kept for the whole image (progressive or multi-scan)
+    CKBOOL complete; // single-scan image already transformed
+    int outWidth;
+    int outHeight;
+    short *rowCoefs; // one MCU row of coefficients for direct decoding
+    int scanCount;
+
+    // Current scan
+    int scanComps[4];
+    int scanCompCount;
+    int ss;
+    int se;
+    int ah;
+    int al;
+    int eobrun;
+};
+
+static void FreeDecoder(JpegDecoder *dec)
+{
+    for (int c = 0; c < 4; c++)
+    {
+        delete[] dec->comps[c].coefs;
+        delete[] dec->comps[c].plane;
+    }
+    delete[] dec->rowCoefs;
+    delete dec;
+}
+
+static int ScaleDenominator(CKDWORD readFlags)
+{
+    switch (readFlags & IMAGE_READ_SCALE_MASK)
+    {
+    case IMAGE_READ_SCALE_1_2:
+        return 2;
+    case IMAGE_READ_SCALE_1_4:
+        return 4;
+    case IMAGE_READ_SCALE_1_8:
+        return 8;
+    default:
+        return 1;
+    }
+}
+
+static inline int CeilDiv(int a, int b) { return (a + b - 1) / b; }
+
+//=============================================================================
+// Markers
+//=============================================================================
+
+// Returns the next marker code at or after dec.pos, skipping anything that is
+// not a marker, or 0 at the end of the data
+static int NextMarker(JpegDecoder &dec)
+{
+    while (dec.pos + 1 < dec.size)
+    {
+        CKBYTE m = dec.data[dec.pos + 1];
+        if (dec.data[dec.pos] == 0xFF && m != 0 && m != 0xFF)
+        {
+            dec.pos += 2;
+            return m;
+        }
+        dec.pos++;
+    }
+    dec.pos = dec.size;
+    return 0;
+}
+
+static int ParseFrame(JpegDecoder &dec, int marker, const CKBYTE *seg, CKDWORD len)
+{
+    if (dec.hasFrame)
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (len < 6)
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (seg[0] != 8)
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+
+    dec.height = (int)ReadBE16(seg + 1);
+    dec.width = (int)ReadBE16(seg + 3);
+    dec.compCount = seg[5];
+    if (len != 6 + 3 * (CKDWORD)dec.compCount)
+        return CKBITMAPERROR_FILECORRUPTED;
+    // A zero height would be defined later by a DNL marker, which is not supported
+    if (dec.width == 0 || dec.height == 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (!ImageWithinDecodeLimits((CKDWORD)dec.width, (CKDWORD)dec.height, 0))
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (dec.compCount != 1 && dec.compCount != 3 && dec.compCount != 4)
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+
+    dec.hMax = 1;
+    dec.vMax = 1;
+    for (int c = 0; c < dec.compCount; c++)
+    {
+        JpegComponent &comp = dec.comps[c];
+        const CKBYTE *p = seg + 6 + c * 3;
+        comp.id = p[0];
+        comp.h = p[1] >> 4;
+        comp.v = p[1] & 15;
+        comp.tq = p[2];
+        if (comp.h < 1 || comp.h > 4 || comp.v < 1 || comp.v > 4 || comp.tq > 3)
+            return CKBITMAPERROR_FILECORRUPTED;
+        for (int i = 0; i < c; i++)
+            if (dec.comps[i].id == comp.id)
+                return CKBITMAPERROR_FILECORRUPTED;
+        if (comp.h > dec.hMax)
+            dec.hMax = comp.h;
+        if (comp.v > dec.vMax)
+            dec.vMax = comp.v;
+    }
+
+    dec.mcusX = CeilDiv(dec.width, 8 * dec.hMax);
+    dec.mcusY = CeilDiv(dec.height, 8 * dec.vMax);
+    for (int c = 0; c < dec.compCount; c++)
+    {
+        JpegComponent &comp = dec.comps[c];
+        comp.blocksWide = dec.mcusX * comp.h;
+        comp.blocksHigh = dec.mcusY * comp.v;
+        comp.blocksPerLine = CeilDiv(CeilDiv(dec.width * comp.h, dec.hMax), 8);
+        comp.blockRows = CeilDiv(CeilDiv(dec.height * comp.v, dec.vMax), 8);
+    }
+
+    dec.progressive = (marker == JPEG_MARKER_SOF2);
+    dec.hasFrame = TRUE;
+    return 0;
+}
+
+static int ParseHuffmanTables(JpegDecoder &dec, const CKBYTE *seg, CKDWORD len)
+{
+    while (len > 0)
+    {
+        if (len < 17)
+            return CKBITMAPERROR_FILECORRUPTED;
+        int tc = seg[0] >> 4;
+        int th = seg[0] & 15;
+        if (tc > 1 || th > 3)
+            return CKBITMAPERROR_FILECORRUPTED;
+        CKDWORD total = 0;
+        for (int i = 0; i < 16; i++)
+            total += seg[1 + i];
+        if (total > 256 || len < 17 + total)
+            return CKBITMAPERROR_FILECORRUPTED;
+        JpegHuffTable &t = tc ? dec.acTables[th] : dec.dcTables[th];
+        if (!BuildHuffTable(seg + 1, seg + 17, tc == 0, t))
+            return CKBITMAPERROR_FILECORRUPTED;
+        seg += 17 + total;
+        len -= 17 + total;
+    }
+    return 0;
+}
+
+static int ParseQuantTables(JpegDecoder &dec, const CKBYTE *seg, CKDWORD len)
+{
+    while (len > 0)
+    {
+        int pq = seg[0] >> 4;
+        int tq = seg[0] & 15;
+        CKDWORD tableSize = 1 + 64 * (pq ? 2 : 1);
+        if (pq > 1 || tq > 3 || len < tableSize)
+            return CKBITMAPERROR_FILECORRUPTED;
+        for (int k = 0; k < 64; k++)
+        {
+            CKDWORD q = pq ? ReadBE16(seg + 1 + k * 2) : seg[1 + k];
+            dec.quant[tq][ZigzagToNatural[k]] = (CKWORD)q;
+        }
+        dec.quantDefined[tq] = TRUE;
+        seg += tableSize;
+        len -= tableSize;
+    }
+    return 0;
+}
+
+static void ParseApp(JpegDecoder &dec, int marker, const CKBYTE *seg, CKDWORD len)
+{
+    if (marker == JPEG_MARKER_APP0 && len >= 5 && memcmp(seg, "JFIF\0", 5) == 0)
+        dec.sawJfif = TRUE;
+    if (marker == JPEG_MARKER_APP14 && len >= 12 && memcmp(seg, "Adobe", 5) == 0)
+    {
+        dec.sawAdobe = TRUE;
+        dec.adobeTransform = seg[11];
+    }
+}
+
+// Color space from the markers and component IDs, by libjpeg's rules
+static JpegColorSpace ColorSpaceOf(const JpegDecoder &dec)
+{
+    if (dec.compCount == 1)
+        return JPEG_CS_GRAY;
+    if (dec.compCount == 3)
+    {
+        if (dec.sawJfif)
+            return JPEG_CS_YCBCR;
+        if (dec.sawAdobe)
+            return dec.adobeTransform == 0 ? JPEG_CS_RGB : JPEG_CS_YCBCR;
+        if (dec.comps[0].id == 'R' && dec.comps[1].id == 'G' && dec.comps[2].id == 'B')
+            return JPEG_CS_RGB;
+        return JPEG_CS_YCBCR;
+    }
+    if (dec.sawAdobe && dec.adobeTransform == 2)
+        return JPEG_CS_YCCK;
+    return JPEG_CS_CMYK;
+}
+
+//=============================================================================
+// Output Geometry
+//
+// Each component is transformed to idctSize pixels per block, then
+// upsampled by integer factors to the output size. Components with less
+// resolution get larger IDCT sizes where that saves upsampling, as libjpeg
+// chooses them, so chroma usually needs no upsampling at reduced scales.
+//=============================================================================
+static int SetupOutput(JpegDecoder &dec)
+{
+    int minSize = 8 / ScaleDenominator(dec.readFlags);
+    dec.outWidth = CeilDiv(dec.width * minSize, 8);
+    dec.outHeight = CeilDiv(dec.height * minSize, 8);
+    uint64_t outSize = (uint64_t)dec.outWidth * dec.outHeight * 4;
+    if (!ImageWithinDecodeLimits((CKDWORD)dec.outWidth, (CKDWORD)dec.outHeight, outSize))
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    uint64_t total = 0;
+    for (int c = 0; c < dec.compCount; c++)
+    {
+        JpegComponent &comp = dec.comps[c];
+        int s = minSize;
+        while (s < 8 && (dec.hMax * minSize) % (comp.h * s * 2) == 0 && (dec.vMax * minSize) % (comp.v * s * 2) == 0)
+            s *= 2;
+        comp.idctSize = s;
+        if ((dec.hMax * minSize) % (comp.h * s) != 0 || (dec.vMax * minSize) % (comp.v * s) != 0)
+            return CKBITMAPERROR_UNSUPPORTEDFILE;
+        comp.hExpand = dec.hMax * minSize / (comp.h * s);
+        comp.vExpand = dec.vMax * minSize / (comp.v * s);
+        comp.dsWidth = CeilDiv(dec.width * comp.h * s, dec.hMax * 8);
+        comp.dsHeight = CeilDiv(dec.height * comp.v * s, dec.vMax * 8);
+
+        // libjpeg only interpolates 2:1 ratios, and not when decoding at 1/8
+        CKBOOL fancy = minSize > 1;
+        if (comp.hExpand == 2 && comp.vExpand <= 2)
+            comp.fancy = fancy && comp.dsWidth > 2;
+        else if (comp.hExpand == 1 && comp.vExpand == 2)
+            comp.fancy = fancy;
+        else
+            comp.fancy = FALSE;
+
+        comp.planeStride = comp.blocksWide * s;
+        total += (uint64_t)comp.planeStride * comp.blocksHigh * s;
+        if (dec.buffered)
+            total += (uint64_t)comp.blocksWide * comp.blocksHigh * 64 * sizeof(short);
+    }
+    if (total > 0x7FFFFFFFULL)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    for (int c = 0; c < dec.compCount; c++)
+    {
+        JpegComponent &comp = dec.comps[c];
+        CKDWORD planeSize = (CKDWORD)comp.planeStride * comp.blocksHigh * comp.idctSize;
+        comp.plane = new CKBYTE[planeSize];
+        if (dec.buffered)
+        {
+            CKDWORD count = (CKDWORD)comp.blocksWide * comp.blocksHigh * 64;
+            comp.coefs = new short[count];
+            memset(comp.coefs, 0, count * sizeof(short));
+        }
+    }
+    if (!dec.buffered)
+    {
+        CKDWORD rowSize = 0;
+        for (int c = 0; c < dec.compCount; c++)
+            rowSize += (CKDWORD)dec.comps[c].blocksWide * dec.comps[c].v * 64;
+        dec.rowCoefs = new short[rowSize];
+    }
+    dec.outputReady = TRUE;
+    return 0;
+}
+
+//=============================================================================
+// Block Decoding
+//=============================================================================
+
+// Sequential: a whole block in one go
+static void DecodeBlock(JpegBitReader &br, const JpegHuffTable &dc, const JpegHuffTable &ac, int &pred, short *block)
+{
+    memset(block, 0, 64 * sizeof(short));
+
+    int s = DecodeHuff(br, dc);
+    int diff = s ? ReceiveExtend(br, s) : 0;
+    pred = (short)(pred + diff);
+    block[0] = (short)pred;
+
+    for (int k = 1; k < 64;)
+    {
+        if (br.count < 16)
+            FillBits(br);
+        int fast = ac.acFast[br.bits >> (64 - HUFF_FAST_BITS)];
+        if (fast)
+        {
+            SkipBits(br, fast & 15);
+            k += (fast >> 4) & 15;
+            block[ZigzagToNatural[k++]] = (short)(fast >> 8);
+            continue;
+        }
+        int rs = DecodeHuff(br, ac);
+        int r = rs >> 4;
+        s = rs & 15;
+        if (s)
+        {
+            k += r;
+            block[ZigzagToNatural[k++]] = (short)ReceiveExtend(br, s);
+        }
+        else
+        {
+            if (r != 15)
+                break;
+            k += 16;
+        }
+    }
+}
+
+// Progressive: first DC scan of a block
+static void DecodeDcFirst(JpegBitReader &br, const JpegHuffTable &dc, int &pred, int al, short *block)
+{
+    int s = DecodeHuff(br, dc);
+    int diff = s ? ReceiveExtend(br, s) : 0;
+    pred = (short)(pred + diff);
+    block[0] = (short)((CKDWORD)pred << al);
+}
+
+// Progressive: one more bit of the DC coefficient
+static void DecodeDcRefine(JpegBitReader &br, int al, short *block)
+{
+    if (GetBit(br))
+        block[0] = (short)(block[0] | (1 << al));
+}
+
+// Progressive: first AC scan of a band of coefficients
+static void DecodeAcFirst(JpegBitReader &br, const JpegHuffTable &ac, int ss, int se, int al, int &eobrun,
+                          short *block)
+{
+    if (eobrun > 0)
+    {
+        eobrun--;
+        return;
+    }
+    for (int k = ss; k <= se; k++)
+    {
+        int rs = DecodeHuff(br, ac);
+        int r = rs >> 4;
+        int s = rs & 15;
+        if (s)
+        {
+            k += r;
+            block[ZigzagToNatural[k]] = (short)((CKDWORD)ReceiveExtend(br, s) << al);
+        }
+        else if (r == 15)
+        {
+            k += 15;
+        }
+        else
+        {
+            // End of band for this block and the (2^r - 1 + extra) following ones
+            eobrun = 1 << r;
+            if (r)
+                eobrun += GetBits(br, r);
+            eobrun--;
+            break;
+        }
+    }
+}
+
+// Progressive: one more bit of the coefficients of a band (libjpeg's decode_mcu_AC_refine)
+static void DecodeAcRefine(JpegBitReader &br, const JpegHuffTable &ac, int ss, int se, int al, int &eobrun,
+                           short *block)
+{
+    const int p1 = 1 << al;
+    const int m1 = -p1;
+    int k = ss;
+
+    if (eobrun == 0)
+    {
+        for (; k <= se; k++)
+        {
+            int rs = DecodeHuff(br, ac);
+            int r = rs >> 4;
+            int s = rs & 15;
+            if (s)
+            {
+                // The new coefficient is always +-1 at this bit position
+                s = GetBit(br) ? p1 : m1;
+            }
+            else if (r != 15)
+            {
+                eobrun = 1 << r;
+                if (r)
+                    eobrun += GetBits(br, r);
+                break;
+            }
+
+            // Skip r zero coefficients, refining the nonzero ones passed on the way
+            do
+            {
+                short *coef = block + ZigzagToNatural[k];
+                if (*coef != 0)
+                {
+                    if (GetBit(br) && (*coef & p1) == 0)
+                        *coef = (short)(*coef + (*coef >= 0 ? p1 : m1));
+                }
+                else
+                {
+                    if (--r < 0)
+                        break;
+                }
+                k++;
+            } while (k <= se);
+
+            if (s)
+                block[ZigzagToNatural[k]] = (short)s;
+        }
+    }
+
+    if (eobrun > 0)
+    {
+        // Only corrections for the band's remaining nonzero coefficients
+        for (; k <= se; k++)
+        {
+            short *coef = block + ZigzagToNatural[k];
+            if (*coef != 0 && GetBit(br) && (*coef & p1) == 0)
+                *coef = (short)(*coef + (*coef >= 0 ? p1 : m1));
+        }
+        eobrun--;
+    }
+}
+
+//=============================================================================
+// Scans
+//=============================================================================
+static void ResetPredictors(JpegDecoder &dec)
+{
+    for (int c = 0; c < dec.compCount; c++)
+        dec.comps[c].dcPred = 0;
+    dec.eobrun = 0;
+}
+
+// Moves the reader past the next RSTn marker. If another marker comes first
+// the reader is left on it and decoding continues with zero bits.
+static void ProcessRestart(JpegDecoder &dec, JpegBitReader &br)
+{
+    ResetPredictors(dec);
+    const CKBYTE *p = br.ptr;
+    for (; p + 1 < br.end; p++)
+    {
+        if (p[0] != 0xFF || p[1] == 0 || p[1] == 0xFF)
+            continue;
+        if (p[1] >= JPEG_MARKER_RST0 && p[1] <= JPEG_MARKER_RST7)
+        {
+            InitBitReader(br, p + 2, br.end);
+            return;
+        }
+        break;
+    }
+    InitBitReader(br, p, br.end);
+    br.marker = TRUE;
+}
+
+// Transforms count blocks of a block row, starting at column blockCol
+static void TransformBlocks(const JpegDecoder &dec, const JpegComponent &comp, const short *coefs, int count,
+                            int blockRow, int blockCol)
+{
+    int s = comp.idctSize;
+    CKBYTE *dst = comp.plane + (size_t)blockRow * s * comp.planeStride + (size_t)blockCol * s;
+    dec.dsp->idct[JPEG_IDCT_INDEX(s)](coefs, count, comp.quant, dst, comp.planeStride);
+}
+
+static void DecodeScanBlock(JpegDecoder &dec, JpegBitReader &br, JpegComponent &comp, short *block)
+{
+    if (!dec.progressive)
+        DecodeBlock(br, dec.dcTables[comp.dcTable], dec.acTables[comp.acTable], comp.dcPred, block);
+    else if (dec.ss == 0 && dec.ah == 0)
+        DecodeDcFirst(br, dec.dcTables[comp.dcTable], comp.dcPred, dec.al, block);
+    else if (dec.ss == 0)
+        DecodeDcRefine(br, dec.al, block);
+    else if (dec.ah == 0)
+        DecodeAcFirst(br, dec.acTables[comp.acTable], dec.ss, dec.se, dec.al, dec.eobrun, block);
+    else
+        DecodeAcRefine(br, dec.acTables[comp.acTable], dec.ss, dec.se, dec.al, dec.eobrun, block);
+}
+
+// Decodes MCUs [first, last) of a sequential single-scan image without
+// keeping its coefficients: each run of MCUs within an MCU row is decoded
+// into rowCoefs, one component's rows of blocks after the other, and
+// transformed straight into the planes. The DC predictors start at zero.
+static void DecodeDirectMcus(const JpegDecoder &dec, JpegBitReader &br, int first, int last, short *rowCoefs)
+{
+    CKBOOL single = (dec.scanCompCount == 1);
+    int mcusX = single ? dec.comps[dec.scanComps[0]].blocksPerLine : dec.mcusX;
+
+    short *rowStart[4];
+    short *p = rowCoefs;
+    for (int i = 0; i < dec.scanCompCount; i++)
+    {
+        rowStart[i] = p;
+        const JpegComponent &comp = dec.comps[dec.scanComps[i]];
+        p += (size_t)comp.blocksWide * (single ? 1 : comp.v) * 64;
+    }
+    int preds[4] = {0, 0, 0, 0};
+
+    while (first < last)
+    {
+        int my = first / mcusX;
+        int mxBegin = first % mcusX;
+        int mxEnd = mxBegin + (last - first);
+        if (mxEnd > mcusX)
+            mxEnd = mcusX;
+
+        for (int mx = mxBegin; mx < mxEnd; mx++)
+        {
+            for (int i = 0; i < dec.scanCompCount; i++)
+            {
+                const JpegComponent &comp = dec.comps[dec.scanComps[i]];
+                const JpegHuffTable &dc = dec.dcTables[comp.dcTable];
+                const JpegHuffTable &ac = dec.acTables[comp.acTable];
+                int bh = single ? 1 : comp.h;
+                int bv = single ? 1 : comp.v;
+                for (int by = 0; by < bv; by++)
+                {
+                    short *block = rowStart[i] + ((size_t)by * comp.blocksWide + mx * bh) * 64;
+                    for (int bx = 0; bx < bh; bx++, block += 64)
+                        DecodeBlock(br, dc, ac, preds[i], block);
+                }
+            }
+        }
+
+        for (int i = 0; i < dec.scanCompCount; i++)
+        {
+            const JpegComponent &comp = dec.comps[dec.scanComps[i]];
+            int bh = single ? 1 : comp.h;
+            int bv = single ? 1 : comp.v;
+            for (int by = 0; by < bv; by++)
+                TransformBlocks(dec, comp, rowStart[i] + ((size_t)by * comp.blocksWide + mxBegin * bh) * 64,
+                                (mxEnd - mxBegin) * bh, my * bv + by, mxBegin * bh);
+        }
+        first += mxEnd - mxBegin;
+    }
+}
+
+//=============================================================================
+// Parallel Restart Intervals
+//
+// Restart markers split a scan into segments that each start on a byte
+// boundary with the DC predictors reset, so they can be decoded independently.
+// Large sequential images have their segments located up front and decoded
+// and transformed on the worker pool.
+//=============================================================================
+
+// Images smaller than this are decoded serially; the pre-scan would not pay off
+#define JPEG_PARALLEL_MIN_PIXELS (256 * 256)
+// MCUs per job chunk, so that short restart intervals are batched
+#define JPEG_PARALLEL_CHUNK_MCUS 256
+// Output rows per job chunk of the color conversion
+#define JPEG_PARALLEL_CHUNK_ROWS 16
+
+// Records where each of the segmentCount segments of the scan at dec.pos
+// begins. Fails if a marker other than RSTn, or the end of the data, comes
+// before the last segment: such a scan is left to the serial decoder, which
+// handles missing restart markers the way libjpeg does.
+static CKBOOL FindRestartSegments(const JpegDecoder &dec, int segmentCount, XArray<CKDWORD> &starts)
+{
+    starts.Resize(segmentCount);
+    starts[0] = dec.pos;
+    const CKBYTE *p = dec.data + dec.pos;
+    const CKBYTE *end = dec.data + dec.size;
+    for (int found = 1; found < segmentCount;)
+    {
+        p = (const CKBYTE *)memchr(p, 0xFF, end - p);
+        if (!p || p + 1 >= end)
+            return FALSE;
+        CKBYTE m = p[1];
+        if (m == 0 || m == 0xFF)
+        {
+            // Stuffed byte or fill byte
+            p++;
+            continue;
+        }
+        if (m < JPEG_MARKER_RST0 || m > JPEG_MARKER_RST7)
+            return FALSE;
+        p += 2;
+        starts[found++] = (CKDWORD)(p - dec.data);
+    }
+    return TRUE;
+}
+
+struct JpegSegmentJob
+{
+    const JpegDecoder *dec;
+    const CKDWORD *starts;
+    int interval; // MCUs per segment
+    int mcuCount;
+    CKDWORD rowSize; // coefficients of one MCU row
+};
+
+static void DecodeSegments(void *context, CKDWORD begin, CKDWORD end)
+{
+    const JpegSegmentJob &job = *(const JpegSegmentJob *)context;
+    const JpegDecoder &dec = *job.dec;
+    short *rowCoefs = new short[job.rowSize];
+    for (CKDWORD seg = begin; seg < end; seg++)
+    {
+        JpegBitReader br;
+        InitBitReader(br, dec.data + job.starts[seg], dec.data + dec.size);
+        int first = (int)seg * job.interval;
+        int last = first + job.interval < job.mcuCount ? first + job.interval : job.mcuCount;
+        DecodeDirectMcus(dec, br, first, last, rowCoefs);
+    }
+    delete[] rowCoefs;
+}
+
+// Decodes and transforms the single sequential scan of an image
+static void DecodeDirectScan(JpegDecoder &dec)
+{
+    CKBOOL single = (dec.scanCompCount == 1);
+    const JpegComponent &first = dec.comps[dec.scanComps[0]];
+    int mcuCount = single ? first.blocksPerLine * first.blockRows : dec.mcusX * dec.mcusY;
+    int interval = dec.restartInterval ? dec.restartInterval : mcuCount;
+    int segmentCount = CeilDiv(mcuCount, interval);
+
+    XArray<CKDWORD> starts;
+    if (segmentCount > 1 && (uint64_t)dec.width * dec.height >= JPEG_PARALLEL_MIN_PIXELS && ImageWorkerCount() > 1 &&
+        FindRestartSegments(dec, segmentCount, starts))
+    {
+        JpegSegmentJob job;
+        job.dec = &dec;
+        job.starts = starts.Begin();
+        job.interval = interval;
+        job.mcuCount = mcuCount;
+        job.rowSize = 0;
+        for (int c = 0; c < dec.compCount; c++)
+            job.rowSize += (CKDWORD)dec.comps[c].blocksWide * dec.comps[c].v * 64;
+        ImageParallelFor((CKDWORD)segmentCount, (CKDWORD)CeilDiv(JPEG_PARALLEL_CHUNK_MCUS, interval), DecodeSegments,
+                         &job);
+        // Anything after the last segment's data is skipped by the marker search
+        dec.pos = starts[segmentCount - 1];
+    }
+    else
+    {
+        JpegBitReader br;
+        InitBitReader(br, dec.data + dec.pos, dec.data + dec.size);
+        for (int seg = 0; seg < segmentCount; seg++)
+        {
+            if (seg > 0)
+                ProcessRestart(dec, br);
+            int last = (seg + 1) * interval < mcuCount ? (seg + 1) * interval : mcuCount;
+            DecodeDirectMcus(dec, br, seg * interval, last, dec.rowCoefs);
+        }
+        dec.pos = (CKDWORD)(br.ptr - dec.data);
+    }
+    dec.complete = TRUE;
+}
+
+// Decodes the entropy-coded data of the current scan starting at dec.pos
+static void DecodeScan(JpegDecoder &dec)
+{
+    if (!dec.buffered)
+    {
+        DecodeDirectScan(dec);
+        return;
+    }
+
+    JpegBitReader br;
+    InitBitReader(br, dec.data + dec.pos, dec.data + dec.size);
+    ResetPredictors(dec);
+
+    // Non-interleaved scans cover the component's own block grid, one block per MCU
+    CKBOOL single = (dec.scanCompCount == 1);
+    JpegComponent &first = dec.comps[dec.scanComps[0]];
+    int mcusX = single ? first.blocksPerLine : dec.mcusX;
+    int mcusY = single ? first.blockRows : dec.mcusY;
+
+    int mcu = 0;
+    for (int my = 0; my < mcusY; my++)
+    {
+        for (int mx = 0; mx < mcusX; mx++, mcu++)
+        {
+            if (dec.restartInterval && mcu > 0 && mcu % dec.restartInterval == 0)
+                ProcessRestart(dec, br);
+
+            for (int i = 0; i < dec.scanCompCount; i++)
+            {
+                JpegComponent &comp = dec.comps[dec.scanComps[i]];
+                int bh = single ? 1 : comp.h;
+                int bv = single ? 1 : comp.v;
+                for (int by = 0; by < bv; by++)
+                {
+                    for (int bx = 0; bx < bh; bx++)
+                    {
+                        int col = mx * bh + bx;
+                        short *block = comp.coefs + ((size_t)(my * bv + by) * comp.blocksWide + col) * 64;
+                        DecodeScanBlock(dec, br, comp, block);
+                    }
+                }
+            }
+        }
+    }
+    dec.pos = (CKDWORD)(br.ptr - dec.data);
+}
+
+static int ParseScan(JpegDecoder &dec, const CKBYTE *seg, CKDWORD len)
+{
+    if (!dec.hasFrame || len < 1)
+        return CKBITMAPERROR_FILECORRUPTED;
+    int count = seg[0];
+    if (count < 1 || count > dec.compCount || len != 4 + 2 * (CKDWORD)count)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    for (int i = 0; i < count; i++)
+    {
+        int id = seg[1 + i * 2];
+        int c = 0;
+        while (c < dec.compCount && dec.comps[c].id != id)
+            c++;
+        if (c == dec.compCount)
+            return CKBITMAPERROR_FILECORRUPTED;
+        for (int j = 0; j < i; j++)
+            if (dec.scanComps[j] == c)
+                return CKBITMAPERROR_FILECORRUPTED;
+        dec.scanComps[i] = c;
+        dec.comps[c].dcTable = seg[2 + i * 2] >> 4;
+        dec.comps[c].acTable = seg[2 + i * 2] & 15;
+        if (dec.comps[c].dcTable > 3 || dec.comps[c].acTable > 3)
+            return CKBITMAPERROR_FILECORRUPTED;
+    }
+    dec.scanCompCount = count;
+
+    const CKBYTE *p = seg + 1 + count * 2;
+    dec.ss = p[0];
+    dec.se = p[1];
+    dec.ah = p[2] >> 4;
+    dec.al = p[2] & 15;
+
+    CKBOOL needDc;
+    CKBOOL needAc;
+    if (dec.progressive)
+    {
+        if (dec.ss == 0 ? dec.se != 0 : (dec.se < dec.ss || dec.se > 63 || count != 1))
+            return CKBITMAPERROR_FILECORRUPTED;
+        if (dec.ah > 13 || dec.al > 13)
+            return CKBITMAPERROR_FILECORRUPTED;
+        needDc = (dec.ss == 0 && dec.ah == 0);
+        needAc = (dec.ss != 0);
+    }
+    else
+    {
+        // Spectral selection and approximation do not apply to sequential scans
+        needDc = TRUE;
+        needAc = TRUE;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        JpegComponent &comp = dec.comps[dec.scanComps[i]];
+        if ((needDc && !dec.dcTables[comp.dcTable].defined) || (needAc && !dec.acTables[comp.acTable].defined))
+            return CKBITMAPERROR_FILECORRUPTED;
+        // Quantization tables may be redefined later; each component keeps the one in effect now
+        if (!comp.quantLatched)
+        {
+            if (!dec.quantDefined[comp.tq])
+                return CKBITMAPERROR_FILECORRUPTED;
+            memcpy(comp.quant, dec.quant[comp.tq], sizeof(comp.quant));
+            comp.quantLatched = TRUE;
+        }
+    }
+    return 0;
+}
+
+// Transforms the coefficients of a buffered image into the component planes
+static void TransformBuffered(JpegDecoder &dec)
+{
+    for (int c = 0; c < dec.compCount; c++)
+    {
+        const JpegComponent &comp = dec.comps[c];
+        for (int row = 0; row < comp.blocksHigh; row++)
+            TransformBlocks(dec, comp, comp.coefs + (size_t)row * comp.blocksWide * 64, comp.blocksWide, row, 0);
+    }
+}
+
+// Walks the marker segments up to EOI, decoding every scan. With headerOnly
+// it stops after the frame header.
+static int DecodeStream(JpegDecoder &dec, CKBOOL headerOnly)
+{
+    if (dec.size < 2 || dec.data[0] != 0xFF || dec.data[1] != JPEG_MARKER_SOI)
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    dec.pos = 2;
+
+    for (;;)
+    {
+        int marker = NextMarker(dec);
+        if (marker == 0 || marker == JPEG_MARKER_EOI)
+            break;
+        // Markers without a segment
+        if ((marker >= JPEG_MARKER_RST0 && marker <= JPEG_MARKER_RST7) || marker == JPEG_MARKER_SOI || marker == 0x01)
+            continue;
+
+        // A truncated segment ends the stream
+        if (dec.size - dec.pos < 2)
+            break;
+        CKDWORD length = ReadBE16(dec.data + dec.pos);
+        if (length < 2 || length > dec.size - dec.pos)
+            break;
+        const CKBYTE *seg = dec.data + dec.pos + 2;
+        CKDWORD len = length - 2;
+        dec.pos += length;
+
+        int result = 0;
+        switch (marker)
+        {
+        case JPEG_MARKER_SOF0:
+        case JPEG_MARKER_SOF1:
+        case JPEG_MARKER_SOF2:
+            result = ParseFrame(dec, marker, seg, len);
+            if (result == 0 && headerOnly)
+                return 0;
+            break;
+        case 0xC3: // lossless
+        case 0xC5: // hierarchical
+        case 0xC6:
+        case 0xC7:
+        case 0xC9: // arithmetic coding
+        case 0xCA:
+        case 0xCB:
+        case 0xCD:
+        case 0xCE:
+        case 0xCF:
+            return CKBITMAPERROR_UNSUPPORTEDFILE;
+        case JPEG_MARKER_DHT:
+            result = ParseHuffmanTables(dec, seg, len);
+            break;
+        case JPEG_MARKER_DQT:
+            result = ParseQuantTables(dec, seg, len);
+            break;
+        case JPEG_MARKER_DRI:
+            if (len < 2)
+                return CKBITMAPERROR_FILECORRUPTED;
+            dec.restartInterval = (int)ReadBE16(seg);
+            break;
+        case JPEG_MARKER_SOS:
+            result = ParseScan(dec, seg, len);
+            if (result != 0)
+                break;
+            if (!dec.outputReady)
+            {
+                // Only an image sent in one sequential scan is decoded without keeping its coefficients
+                dec.buffered = dec.progressive || dec.scanCompCount != dec.compCount;
+                result = SetupOutput(dec);
+                if (result != 0)
+                    break;
+            }
+            if (!dec.complete)
+            {
+                DecodeScan(dec);
+                dec.scanCount++;
+            }
+            break;
+        default:
+            if (marker >= JPEG_MARKER_APP0 && marker <= 0xEF)
+                ParseApp(dec, marker, seg, len);
+            break;
+        }
+        if (result != 0)
+            return result;
+    }
+
+    if (!dec.hasFrame || dec.scanCount == 0)
+        return headerOnly && dec.hasFrame ? 0 : CKBITMAPERROR_FILECORRUPTED;
+    if (dec.buffered)
+        TransformBuffered(dec);
+    return 0;
+}
+
+//=============================================================================
+// Upsampling and Color Conversion
+//=============================================================================
+
+// Row y of a component at the output size; tmp receives upsampled rows
+static const CKBYTE *ComponentRow(const JpegDecoder &dec, const JpegComponent &comp, int y, CKBYTE *tmp)
+{
+    if (comp.hExpand == 1 && comp.vExpand == 1)
+        return comp.plane + (size_t)y * comp.planeStride;
+
+    if (comp.fancy && comp.vExpand == 1)
+    {
+        dec.dsp->upsampleH2V1(comp.plane + (size_t)y * comp.planeStride, comp.dsWidth, tmp);
+        return tmp;
+    }
+    if (comp.fancy)
+    {
+        // The nearest input row and the one above (even output rows) or below
+        // (odd output rows), repeating the edge rows
+        int row = y >> 1;
+        int other = (y & 1) ? row + 1 : row - 1;
+        if (other < 0)
+            other = 0;
+        if (other > comp.dsHeight - 1)
+            other = comp.dsHeight - 1;
+        const CKBYTE *nearRow = comp.plane + (size_t)row * comp.planeStride;
+        const CKBYTE *farRow = comp.plane + (size_t)other * comp.planeStride;
+        if (comp.hExpand == 2)
+        {
+            dec.dsp->upsampleH2V2(nearRow, farRow, comp.dsWidth, tmp);
+        }
+        else
+        {
+            int bias = (y & 1) ? 2 : 1;
+            for (int x = 0; x < comp.dsWidth; x++)
+                tmp[x] = (CKBYTE)((nearRow[x] * 3 + farRow[x] + bias) >> 2);
+        }
+        return tmp;
+    }
+
+    // Plain replication
+    const CKBYTE *src = comp.plane + (size_t)(y / comp.vExpand) * comp.planeStride;
+    if (comp.hExpand == 1)
+        return src;
+    CKBYTE *dst = tmp;
+    for (int x = 0; x < comp.dsWidth; x++, dst += comp.hExpand)
+        memset(dst, src[x], comp.hExpand);
+    return tmp;
+}
+
+// x * y / 255, rounded
+static inline CKBYTE Mul255(int x, int y)
+{
+    int t = x * y + 128;
+    return (CKBYTE)((t + (t >> 8)) >> 8);
+}
+
+static void ConvertRows(const JpegDecoder &dec, JpegColorSpace cs, CKBYTE *dst, int dstStride, int rowBegin,
+                        int rowEnd, CKBYTE *scratch, int scratchStride)
+{
+    const CKBYTE *rows[4];
+    for (int y = rowBegin; y < rowEnd; y++)
+    {
+        for (int c = 0; c < dec.compCount; c++)
+            rows[c] = ComponentRow(dec, dec.comps[c], y, scratch + c * scratchStride);
+
+        CKBYTE *out = dst + (size_t)y * dstStride;
+        int width = dec.outWidth;
+        switch (cs)
+        {
+        case JPEG_CS_GRAY:
+            ImagePlanarToBGRA32(rows[0], rows[0], rows[0], NULL, out, width);
+            break;
+        case JPEG_CS_RGB:
+            ImagePlanarToBGRA32(rows[0], rows[1], rows[2], NULL, out, width);
+            break;
+        case JPEG_CS_YCBCR:
+            dec.dsp->yccToBGRA(rows[0], rows[1], rows[2], out, width);
+            break;
+        case JPEG_CS_CMYK:
+            // Adobe CMYK is stored inverted, so the samples are already 255 - ink
+            for (int x = 0; x < width; x++, out += 4)
+            {
+                int k = rows[3][x];
+                out[0] = Mul255(rows[2][x], k);
+                out[1] = Mul255(rows[1][x], k);
+                out[2] = Mul255(rows[0][x], k);
+                out[3] = 0xFF;
+            }
+            break;
+        case JPEG_CS_YCCK:
+            // YCbCr holds the inverted CMY inks
+            dec.dsp->yccToBGRA(rows[0], rows[1], rows[2], out, width);
+            for (int x = 0; x < width; x++, out += 4)
+            {
+                int k = rows[3][x];
+                out[0] = Mul255(255 - out[0], k);
+                out[1] = Mul255(255 - out[1], k);
+                out[2] = Mul255(255 - out[2], k);
+            }
+            break;
+        }
+    }
+}
+
+struct JpegConvertJob
+{
+    const JpegDecoder *dec;
+    JpegColorSpace cs;
+    CKBYTE *dst;
+    int dstStride;
+    int scratchStride;
+};
+
+static void ConvertRowRange(void *context, CKDWORD begin, CKDWORD end)
+{
+    const JpegConvertJob &job = *(const JpegConvertJob *)context;
+    CKBYTE *scratch = new CKBYTE[(size_t)job.scratchStride * job.dec->compCount];
+    ConvertRows(*job.dec, job.cs, job.dst, job.dstStride, (int)begin, (int)end, scratch, job.scratchStride);
+    delete[] scratch;
+}
+
+//=============================================================================
+// Header Information
+//=============================================================================
+int JPEG_ReadInfo(const CKBYTE *data, CKDWORD size, JpegImageInfo &info)
+{
+    memset(&info, 0, sizeof(info));
+    if (!data || size < 2)
+        return CKBITMAPERROR_READERROR;
+
+    JpegDecoder *dec = new JpegDecoder;
+    memset(dec, 0, sizeof(JpegDecoder));
+    dec->data = data;
+    dec->size = size;
+    int result = DecodeStream(*dec, TRUE);
+    if (result == 0)
+    {
+        info.width = (CKDWORD)dec->width;
+        info.height = (CKDWORD)dec->height;
+        info.components = (CKDWORD)dec->compCount;
+        info.progressive = dec->progressive;
+    }
+    FreeDecoder(dec);
+    return result;
+}
+
+void JPEG_ScaledSize(const JpegImageInfo &info, CKDWORD readFlags, CKDWORD &width, CKDWORD &height)
+{
+    CKDWORD denom = (CKDWORD)ScaleDenominator(readFlags);
+    width = (info.width + denom - 1) / denom;
+    height = (info.height + denom - 1) / denom;
+}
+
+//=============================================================================
+// Constructor/Destructor
+//=============================================================================
+JpegReader::JpegReader() : ImageReader(), m_ReadFlags(0)
+{
+    m_Properties.Init(JPEGREADER_GUID, "jpg");
+}
+
+JpegReader::~JpegReader()
+{
+    FreeBitmapData(&m_Properties);
+}
+
+CKPluginInfo *JpegReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_JPEG];
+}
+
+void JpegReader::SetReadFlags(CKDWORD flags) { m_ReadFlags = flags; }
+
+CKDWORD JpegReader::GetReadFlags() { return m_ReadFlags; }
+
+int JpegReader::GetOptionsCount() { return 0; }
+
+CKSTRING JpegReader::GetOptionDescription(int i) { return ""; }
+
+int JpegReader::ReadFile(CKSTRING filename, CKBitmapProperties **bp)
+{
+    if (!filename || !bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_JPEG, (void *)filename, 0, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int JpegReader::ReadMemory(void *memory, int size, CKBitmapProperties **bp)
+{
+    if (!bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_JPEG, memory, size, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int JpegReader::ReadOwnFormat(void *data, int size, CKBitmapProperties *props)
+{
+    return JPEG_Read(data, size, props, m_ReadFlags);
+}
+
+//=============================================================================
+// JPEG_Read - Core Reading Function
+//=============================================================================
+int JPEG_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags)
+{
+    if (!data || !props)
+        return CKBITMAPERROR_GENERIC;
+    if (size < 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    ImageFileMap fileMap;
+    if (size == 0)
+    {
+        if (!fileMap.Open((const char *)data))
+            return CKBITMAPERROR_READERROR;
+        data = (void *)fileMap.Data();
+        size = (int)fileMap.Size();
+    }
+    if (size < 2)
+        return CKBITMAPERROR_READERROR;
+
+    JpegDecoder *dec = new JpegDecoder;
+    memset(dec, 0, sizeof(JpegDecoder));
+    dec->data = (const CKBYTE *)data;
+    dec->size = (CKDWORD)size;
+    dec->readFlags = readFlags;
+    dec->dsp = &JPEG_GetDsp();
+
+    int result = DecodeStream(*dec, FALSE);
+    if (result != 0)
+    {
+        FreeDecoder(dec);
+        return result;
+    }
+
+    // Upsampled rows can run a few samples past the output width
+    int scratchStride = 0;
+    for (int c = 0; c < dec->compCount; c++)
+    {
+        int w = dec->comps[c].planeStride * dec->comps[c].hExpand;
+        if (w > scratchStride)
+            scratchStride = w;
+    }
+    scratchStride = (scratchStride + 31) & ~31;
+
+    int dstStride = dec->outWidth * 4;
+    CKBYTE *dst = new CKBYTE[(size_t)dstStride * dec->outHeight];
+    JpegConvertJob job;
+    job.dec = dec;
+    job.cs = ColorSpaceOf(*dec);
+    job.dst = dst;
+    job.dstStride = dstStride;
+    job.scratchStride = scratchStride;
+    if ((uint64_t)dec->outWidth * dec->outHeight >= JPEG_PARALLEL_MIN_PIXELS && ImageWorkerCount() > 1)
+        ImageParallelFor((CKDWORD)dec->outHeight, JPEG_PARALLEL_CHUNK_ROWS, ConvertRowRange, &job);
+    else
+        ConvertRowRange(&job, 0, (CKDWORD)dec->outHeight);
+
+    ImageReader::FillFormatBGRA32(props->m_Format, dec->outWidth, dec->outHeight, dstStride, dst);
+    props->m_Data = dst;
+
+    if (props->m_Size == sizeof(JpegBitmapProperties))
+    {
+        ((JpegBitmapProperties *)props)->m_Components = (CKDWORD)dec->compCount;
+        ((JpegBitmapProperties *)props)->m_Progressive = dec->progressive ? 1 : 0;
+    }
+    FreeDecoder(dec);
+    return 0;
+}
@@ -0,0 +1,90 @@
+#ifndef JPEGREADER_H
+#define JPEGREADER_H
+
+#include "ImageReader.h"
+
+// JPEG Reader GUID
+#define JPEGREADER_GUID CKGUID(0xB14E6FB0, 0xB4162D0A)
+
+/**
+ * JpegReader - JPEG (JFIF/EXIF) reader
+ *
+ *   - Baseline, extended sequential and progressive Huffman-coded JPEG with
+ *     8-bit samples; gray, YCbCr, RGB, CMYK and YCCK images
+ *   - Decoded to BGRA32. With IMAGE_READ_SCALE_1_2/1_4/1_8 the image is
+ *     decoded at a reduced size in the DCT domain: each 8x8 block is
+ *     transformed straight to 4x4, 2x2 or 1x1 pixels
+ *   - Accurate integer IDCT, fancy chroma upsampling and YCbCr conversion
+ *     with SSE2/AVX2 kernels (JpegDsp); output matches libjpeg's defaults
+ *   - Large sequential images with restart markers are split at the markers
+ *     and the segments decoded on the worker pool; color conversion of large
+ *     images is split by rows
+ *   - Arithmetic coding, lossless and 12-bit JPEG are not supported.
+ *     Metadata (EXIF orientation, ICC profiles) is ignored
+ *   - Read-only: SaveFile and SaveMemory return 0
+ */
+class JpegReader : public ImageReader
+{
+public:
+    JpegReader();
+    virtual ~JpegReader();
+
+    virtual CKPluginInfo *GetReaderInfo();
+    virtual int GetOptionsCount();
+    virtual CKSTRING GetOptionDescription(int i);
+
+    virtual int ReadFile(CKSTRING filename, CKBitmapProperties **bp);
+    virtual int ReadMemory(void *memory, int size, CKBitmapProperties **bp);
+
+    // IMAGE_READ_* flags applied by ReadFile/ReadMemory (default 0)
+    void SetReadFlags(CKDWORD flags);
+    CKDWORD GetReadFlags();
+
+protected:
+    virtual int ReadOwnFormat(void *data, int size, CKBitmapProperties *props);
+
+private:
+    JpegBitmapProperties m_Properties;
+    CKDWORD m_ReadFlags;
+};
+
+//=============================================================================
+// JPEG file format
+//=============================================================================
+#define JPEG_MARKER_SOF0 0xC0 // baseline
+#define JPEG_MARKER_SOF1 0xC1 // extended sequential
+#define JPEG_MARKER_SOF2 0xC2 // progressive
+#define JPEG_MARKER_DHT 0xC4
+#define JPEG_MARKER_RST0 0xD0
+#define JPEG_MARKER_RST7 0xD7
+#define JPEG_MARKER_SOI 0xD8
+#define JPEG_MARKER_EOI 0xD9
+#define JPEG_MARKER_SOS 0xDA
+#define JPEG_MARKER_DQT 0xDB
+#define JPEG_MARKER_DRI 0xDD
+#define JPEG_MARKER_APP0 0xE0
+#define JPEG_MARKER_APP14 0xEE
+
+// Frame header of a JPEG stream
+struct JpegImageInfo
+{
+    CKDWORD width;
+    CKDWORD height;
+    CKDWORD components;
+    CKBOOL progressive;
+};
+
+//=============================================================================
+// Internal helper functions
+//=============================================================================
+
+// Reads the frame header without decoding the image
+int JPEG_ReadInfo(const CKBYTE *data, CKDWORD size, JpegImageInfo &info);
+
+// Size of the image decoded with the IMAGE_READ_SCALE_* part of readFlags
+void JPEG_ScaledSize(const JpegImageInfo &info, CKDWORD readFlags, CKDWORD &width, CKDWORD &height);
+
+// Core JPEG read function (size == 0 means data is a filename)
+int JPEG_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags = 0);
+
+#endif // JPEGREADER_H
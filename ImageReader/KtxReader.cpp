@@ -0,0 +1,513 @@
+#include "KtxReader.h"
+#include "ImageBcn.h"
+#include "ImageSimd.h"
+#include "ImageFileMap.h"
+
+static const CKBYTE s_Ktx1Identifier[KTX_IDENTIFIER_SIZE] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+static const CKBYTE s_Ktx2Identifier[KTX_IDENTIFIER_SIZE] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+static CKDWORD ReadLE32(const CKBYTE *p)
+{
+    return (CKDWORD)p[0] | ((CKDWORD)p[1] << 8) | ((CKDWORD)p[2] << 16) | ((CKDWORD)p[3] << 24);
+}
+
+static CKDWORD ReadBE32(const CKBYTE *p)
+{
+    return ((CKDWORD)p[0] << 24) | ((CKDWORD)p[1] << 16) | ((CKDWORD)p[2] << 8) | (CKDWORD)p[3];
+}
+
+static uint64_t ReadLE64(const CKBYTE *p)
+{
+    return (uint64_t)ReadLE32(p) | ((uint64_t)ReadLE32(p + 4) << 32);
+}
+
+static void SetMask(DdsMaskFormat &mask, CKDWORD bitCount, CKDWORD r, CKDWORD g, CKDWORD b, CKDWORD a,
+                    CKBOOL luminance)
+{
+    mask.bitCount = bitCount;
+    mask.redMask = r;
+    mask.greenMask = g;
+    mask.blueMask = b;
+    mask.alphaMask = a;
+    mask.luminance = luminance;
+}
+
+//=============================================================================
+// Pixel Formats
+//=============================================================================
+
+// glInternalFormat of KTX 1 compressed textures
+static CKBOOL GlToBlockFormat(CKDWORD internalFormat, KtxImageInfo &info)
+{
+    switch (internalFormat)
+    {
+    case 0x83F0: // COMPRESSED_RGB_S3TC_DXT1
+    case 0x8C4C: // COMPRESSED_SRGB_S3TC_DXT1
+        info.blockFormat = IMAGE_BLOCK_BC1;
+        info.opaque = TRUE;
+        break;
+    case 0x83F1: // COMPRESSED_RGBA_S3TC_DXT1
+    case 0x8C4D:
+        info.blockFormat = IMAGE_BLOCK_BC1;
+        break;
+    case 0x83F2: // COMPRESSED_RGBA_S3TC_DXT3
+    case 0x8C4E:
+        info.blockFormat = IMAGE_BLOCK_BC2;
+        break;
+    case 0x83F3: // COMPRESSED_RGBA_S3TC_DXT5
+    case 0x8C4F:
+        info.blockFormat = IMAGE_BLOCK_BC3;
+        break;
+    case 0x8DBB: // COMPRESSED_RED_RGTC1
+        info.blockFormat = IMAGE_BLOCK_BC4;
+        break;
+    case 0x8DBC:
+        info.blockFormat = IMAGE_BLOCK_BC4_SNORM;
+        break;
+    case 0x8DBD: // COMPRESSED_RG_RGTC2
+        info.blockFormat = IMAGE_BLOCK_BC5;
+        break;
+    case 0x8DBE:
+        info.blockFormat = IMAGE_BLOCK_BC5_SNORM;
+        break;
+    case 0x8E8C: // COMPRESSED_RGBA_BPTC_UNORM
+    case 0x8E8D:
+        info.blockFormat = IMAGE_BLOCK_BC7;
+        break;
+    case 0x8E8E: // COMPRESSED_RGB_BPTC_SIGNED_FLOAT
+        info.blockFormat = IMAGE_BLOCK_BC6H_SF16;
+        break;
+    case 0x8E8F: // COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT
+        info.blockFormat = IMAGE_BLOCK_BC6H;
+        break;
+    default:
+        return FALSE;
+    }
+    info.srgb = (internalFormat >= 0x8C4C && internalFormat <= 0x8C4F) || internalFormat == 0x8E8D;
+    return TRUE;
+}
+
+// glFormat of KTX 1 textures of unsigned bytes
+static CKBOOL GlToMaskFormat(CKDWORD format, CKDWORD internalFormat, KtxImageInfo &info)
+{
+    switch (format)
+    {
+    case KTX_GL_RGBA:
+        SetMask(info.mask, 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000, FALSE);
+        break;
+    case KTX_GL_BGRA:
+        SetMask(info.mask, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000, FALSE);
+        break;
+    case KTX_GL_RGB:
+        SetMask(info.mask, 24, 0x000000FF, 0x0000FF00, 0x00FF0000, 0, FALSE);
+        break;
+    case KTX_GL_BGR:
+        SetMask(info.mask, 24, 0x00FF0000, 0x0000FF00, 0x000000FF, 0, FALSE);
+        break;
+    case KTX_GL_RED:
+    case KTX_GL_LUMINANCE:
+        SetMask(info.mask, 8, 0xFF, 0, 0, 0, TRUE);
+        break;
+    case KTX_GL_LUMINANCE_ALPHA:
+        SetMask(info.mask, 16, 0x00FF, 0, 0, 0xFF00, TRUE);
+        break;
+    default:
+        return FALSE;
+    }
+    info.srgb = (internalFormat == KTX_GL_SRGB8 || internalFormat == KTX_GL_SRGB8_ALPHA8);
+    return TRUE;
+}
+
+// VkFormat of KTX 2 textures
+static CKBOOL VkToFormat(CKDWORD vkFormat, KtxImageInfo &info)
+{
+    switch (vkFormat)
+    {
+    case 131: // BC1_RGB
+    case 132:
+        info.blockFormat = IMAGE_BLOCK_BC1;
+        info.opaque = TRUE;
+        break;
+    case 133: // BC1_RGBA
+    case 134:
+        info.blockFormat = IMAGE_BLOCK_BC1;
+        break;
+    case 135: // BC2
+    case 136:
+        info.blockFormat = IMAGE_BLOCK_BC2;
+        break;
+    case 137: // BC3
+    case 138:
+        info.blockFormat = IMAGE_BLOCK_BC3;
+        break;
+    case 139: // BC4
+        info.blockFormat = IMAGE_BLOCK_BC4;
+        break;
+    case 140:
+        info.blockFormat = IMAGE_BLOCK_BC4_SNORM;
+        break;
+    case 141: // BC5
+        info.blockFormat = IMAGE_BLOCK_BC5;
+        break;
+    case 142:
+        info.blockFormat = IMAGE_BLOCK_BC5_SNORM;
+        break;
+    case 143: // BC6H
+        info.blockFormat = IMAGE_BLOCK_BC6H;
+        break;
+    case 144:
+        info.blockFormat = IMAGE_BLOCK_BC6H_SF16;
+        break;
+    case 145: // BC7
+    case 146:
+        info.blockFormat = IMAGE_BLOCK_BC7;
+        break;
+    case 9: // R8
+    case 15:
+        SetMask(info.mask, 8, 0xFF, 0, 0, 0, TRUE);
+        break;
+    case 23: // R8G8B8
+    case 29:
+        SetMask(info.mask, 24, 0x000000FF, 0x0000FF00, 0x00FF0000, 0, FALSE);
+        break;
+    case 30: // B8G8R8
+    case 36:
+        SetMask(info.mask, 24, 0x00FF0000, 0x0000FF00, 0x000000FF, 0, FALSE);
+        break;
+    case 37: // R8G8B8A8
+    case 43:
+        SetMask(info.mask, 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000, FALSE);
+        break;
+    case 44: // B8G8R8A8
+    case 50:
+        SetMask(info.mask, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000, FALSE);
+        break;
+    default:
+        return FALSE;
+    }
+    info.srgb = (vkFormat == 15 || vkFormat == 29 || vkFormat == 36 || vkFormat == 43 || vkFormat == 50 ||
+                 vkFormat == 132 || vkFormat == 134 || vkFormat == 136 || vkFormat == 138 || vkFormat == 146);
+    return TRUE;
+}
+
+// Bytes of one face, layer and slice of a level
+static uint64_t SliceSize(const KtxImageInfo &info, CKDWORD width, CKDWORD height)
+{
+    if (info.blockFormat != IMAGE_BLOCK_NONE)
+        return ImageBlockLevelSize(info.blockFormat, width, height);
+    return (((uint64_t)width * (info.mask.bitCount / 8) + info.rowAlignment - 1) & ~(uint64_t)(info.rowAlignment - 1)) *
+           height;
+}
+
+//=============================================================================
+// KTX_ReadInfo - Header Parsing
+//=============================================================================
+static int ReadKtx1Info(const CKBYTE *data, CKDWORD size, KtxImageInfo &info)
+{
+    if (size < KTX1_HEADER_SIZE)
+        return CKBITMAPERROR_READERROR;
+
+    // The writer's byte order applies to every 32-bit field
+    CKDWORD (*read32)(const CKBYTE *) = ReadLE32;
+    if (ReadLE32(data + 12) == KTX_ENDIAN_REF_REV)
+        read32 = ReadBE32;
+    else if (ReadLE32(data + 12) != KTX_ENDIAN_REF)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    CKDWORD glType = read32(data + 16);
+    CKDWORD glFormat = read32(data + 24);
+    CKDWORD glInternalFormat = read32(data + 28);
+    info.width = read32(data + 36);
+    info.height = read32(data + 40);
+    info.depth = read32(data + 44);
+    info.layers = read32(data + 48);
+    info.faces = read32(data + 52);
+    info.mipCount = read32(data + 56);
+    CKDWORD keyValueBytes = read32(data + 60);
+    info.rowAlignment = 4;
+
+    if (glType == 0 && glFormat == 0)
+    {
+        if (!GlToBlockFormat(glInternalFormat, info))
+            return CKBITMAPERROR_UNSUPPORTEDFILE;
+    }
+    else if (glType != KTX_GL_UNSIGNED_BYTE || !GlToMaskFormat(glFormat, glInternalFormat, info))
+    {
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    }
+
+    CKBOOL cubeFaces = (info.faces == 6 && info.layers == 0);
+    if (info.height == 0)
+        info.height = 1;
+    if (info.depth == 0)
+        info.depth = 1;
+    if (info.layers == 0)
+        info.layers = 1;
+    if (info.mipCount == 0)
+        info.mipCount = 1;
+    if (info.mipCount > KTX_MAX_LEVELS)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // Each level is its byte count and data; the count of a non-array cube
+    // map is that of one face, each face padded to 4 bytes. Levels past the
+    // end of the file are marked missing.
+    uint64_t offset = (uint64_t)KTX1_HEADER_SIZE + keyValueBytes;
+    for (CKDWORD level = 0; level < info.mipCount; level++)
+    {
+        if (offset + 4 > size)
+        {
+            info.levelOffsets[level] = KTX_LEVEL_MISSING;
+            continue;
+        }
+        uint64_t imageSize = read32(data + offset);
+        info.levelOffsets[level] = offset + 4;
+        uint64_t levelBytes = cubeFaces ? ((imageSize + 3) & ~3ULL) * 6 : imageSize;
+        offset += 4 + ((levelBytes + 3) & ~3ULL);
+    }
+    return 0;
+}
+
+static int ReadKtx2Info(const CKBYTE *data, CKDWORD size, KtxImageInfo &info)
+{
+    if (size < KTX2_HEADER_SIZE)
+        return CKBITMAPERROR_READERROR;
+
+    CKDWORD vkFormat = ReadLE32(data + 12);
+    info.width = ReadLE32(data + 20);
+    info.height = ReadLE32(data + 24);
+    info.depth = ReadLE32(data + 28);
+    info.layers = ReadLE32(data + 32);
+    info.faces = ReadLE32(data + 36);
+    info.mipCount = ReadLE32(data + 40);
+    info.rowAlignment = 1;
+
+    // Supercompressed (Basis, zstd, zlib) and undefined formats need a transcoder
+    if (ReadLE32(data + 44) != 0 || !VkToFormat(vkFormat, info))
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+
+    if (info.height == 0)
+        info.height = 1;
+    if (info.depth == 0)
+        info.depth = 1;
+    if (info.layers == 0)
+        info.layers = 1;
+    if (info.mipCount == 0)
+        info.mipCount = 1;
+    if (info.mipCount > KTX_MAX_LEVELS)
+        return CKBITMAPERROR_FILECORRUPTED;
+    if ((uint64_t)KTX2_HEADER_SIZE + (uint64_t)info.mipCount * KTX2_LEVEL_INDEX_ENTRY > size)
+        return CKBITMAPERROR_READERROR;
+
+    // The level index gives each level's offset; the first face, layer and
+    // slice start it
+    for (CKDWORD level = 0; level < info.mipCount; level++)
+        info.levelOffsets[level] = ReadLE64(data + KTX2_HEADER_SIZE + level * KTX2_LEVEL_INDEX_ENTRY);
+    return 0;
+}
+
+static CKDWORD FullChainLevels(CKDWORD width, CKDWORD height)
+{
+    CKDWORD side = (width > height) ? width : height;
+    CKDWORD levels = 1;
+    while (side > 1)
+    {
+        side >>= 1;
+        levels++;
+    }
+    return levels;
+}
+
+int KTX_ReadInfo(const CKBYTE *data, CKDWORD size, KtxImageInfo &info)
+{
+    memset(&info, 0, sizeof(info));
+    if (size < KTX_IDENTIFIER_SIZE)
+        return CKBITMAPERROR_READERROR;
+
+    int err;
+    if (memcmp(data, s_Ktx1Identifier, KTX_IDENTIFIER_SIZE) == 0)
+    {
+        info.version = 1;
+        err = ReadKtx1Info(data, size, info);
+    }
+    else if (memcmp(data, s_Ktx2Identifier, KTX_IDENTIFIER_SIZE) == 0)
+    {
+        info.version = 2;
+        err = ReadKtx2Info(data, size, info);
+    }
+    else
+    {
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    }
+    if (err != 0)
+        return err;
+
+    if (info.faces != 1 && info.faces != 6)
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (info.width == 0 || !ImageWithinDecodeLimits(info.width, info.height, 0))
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (info.mipCount > FullChainLevels(info.width, info.height))
+        return CKBITMAPERROR_FILECORRUPTED;
+    return 0;
+}
+
+//=============================================================================
+// KtxReader Class Implementation
+//=============================================================================
+KtxReader::KtxReader() : ImageReader(), m_ReadFlags(0)
+{
+    m_Properties.Init(KTXREADER_GUID, "ktx");
+}
+
+KtxReader::~KtxReader()
+{
+    FreeBitmapData(&m_Properties);
+}
+
+CKPluginInfo *KtxReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_KTX];
+}
+
+void KtxReader::SetReadFlags(CKDWORD flags) { m_ReadFlags = flags; }
+
+CKDWORD KtxReader::GetReadFlags() { return m_ReadFlags; }
+
+int KtxReader::GetOptionsCount() { return 0; }
+
+CKSTRING KtxReader::GetOptionDescription(int i) { return ""; }
+
+int KtxReader::ReadFile(CKSTRING filename, CKBitmapProperties **bp)
+{
+    if (!filename || !bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_KTX, (void *)filename, 0, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int KtxReader::ReadMemory(void *memory, int size, CKBitmapProperties **bp)
+{
+    if (!bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_KTX, memory, size, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int KtxReader::ReadOwnFormat(void *data, int size, CKBitmapProperties *props)
+{
+    return KTX_Read(data, size, props, m_ReadFlags);
+}
+
+//=============================================================================
+// KTX_Read - Core Reading Function
+//=============================================================================
+int KTX_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags)
+{
+    if (!data || !props)
+        return CKBITMAPERROR_GENERIC;
+    if (size < 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // Files are mapped; blocks are copied or decoded straight from the mapping
+    ImageFileMap fileMap;
+    if (size == 0)
+    {
+        if (!fileMap.Open((const char *)data))
+            return CKBITMAPERROR_READERROR;
+        data = (void *)fileMap.Data();
+        size = (int)fileMap.Size();
+    }
+
+    const CKBYTE *bytes = (const CKBYTE *)data;
+    KtxImageInfo info;
+    int err = KTX_ReadInfo(bytes, (CKDWORD)size, info);
+    if (err != 0)
+        return err;
+
+    CKDWORD blockBytes = ImageBlockBytes(info.blockFormat);
+    CKBOOL keepBlocks = (readFlags & IMAGE_READ_KEEP_BLOCKS) && blockBytes;
+    CKDWORD levelCount = keepBlocks ? info.mipCount : 1;
+
+    // Every level returned must be in the file before anything is allocated
+    CKDWORD width = info.width, height = info.height;
+    for (CKDWORD level = 0; level < levelCount; level++)
+    {
+        uint64_t offset = info.levelOffsets[level];
+        if (offset == KTX_LEVEL_MISSING || offset > (CKDWORD)size ||
+            SliceSize(info, width, height) > (CKDWORD)size - offset)
+            return CKBITMAPERROR_READERROR;
+        width = (width > 1) ? width / 2 : 1;
+        height = (height > 1) ? height / 2 : 1;
+    }
+
+    CKBYTE *dstPixels;
+    uint64_t dataSize;
+    if (keepBlocks)
+    {
+        dataSize = ImageBlockChainSize(info.blockFormat, info.width, info.height, info.mipCount);
+        if (!ImageWithinDecodeLimits(info.width, info.height, dataSize))
+            return CKBITMAPERROR_FILECORRUPTED;
+        dstPixels = new CKBYTE[(size_t)dataSize];
+        uint64_t written = 0;
+        width = info.width;
+        height = info.height;
+        for (CKDWORD level = 0; level < info.mipCount; level++)
+        {
+            uint64_t slice = SliceSize(info, width, height);
+            memcpy(dstPixels + written, bytes + info.levelOffsets[level], (size_t)slice);
+            written += slice;
+            width = (width > 1) ? width / 2 : 1;
+            height = (height > 1) ? height / 2 : 1;
+        }
+        ImageReader::FillFormatBlocks(props->m_Format, (int)info.width, (int)info.height, (int)blockBytes, dstPixels);
+    }
+    else
+    {
+        CKBOOL toFloat = (readFlags & IMAGE_READ_FLOAT) &&
+                         (info.blockFormat == IMAGE_BLOCK_BC6H || info.blockFormat == IMAGE_BLOCK_BC6H_SF16);
+        uint64_t dstStride64 = (uint64_t)info.width * (toFloat ? 16 : 4);
+        if (!ImageWithinDecodeLimits(info.width, info.height, dstStride64 * info.height))
+            return CKBITMAPERROR_FILECORRUPTED;
+
+        int dstStride = (int)dstStride64;
+        dataSize = dstStride64 * info.height;
+        dstPixels = new CKBYTE[(size_t)dataSize];
+        const CKBYTE *pixels = bytes + info.levelOffsets[0];
+        if (blockBytes)
+        {
+            ImageDecodeBlockLevel(info.blockFormat, pixels, info.width, info.height, dstPixels, dstStride, toFloat);
+            // Formats without alpha leave BC1 punch-through pixels opaque
+            if (info.opaque)
+            {
+                for (CKDWORD i = 0; i < info.width * info.height; i++)
+                    dstPixels[i * 4 + 3] = 0xFF;
+            }
+        }
+        else
+        {
+            int srcPitch = (int)(SliceSize(info, info.width, 1));
+            DDS_ConvertMasked(pixels, srcPitch, info.mask, info.width, info.height, dstPixels, dstStride);
+        }
+
+        if (toFloat)
+            ImageReader::FillFormatRGBA128F(props->m_Format, (int)info.width, (int)info.height, dstStride, dstPixels);
+        else
+            ImageReader::FillFormatBGRA32(props->m_Format, (int)info.width, (int)info.height, dstStride, dstPixels);
+    }
+    props->m_Data = dstPixels;
+
+    if (props->m_Size == sizeof(KtxBitmapProperties))
+    {
+        KtxBitmapProperties *ktxProps = (KtxBitmapProperties *)props;
+        ktxProps->m_BlockFormat = info.blockFormat;
+        ktxProps->m_MipCount = info.mipCount;
+        ktxProps->m_DataSize = (CKDWORD)dataSize;
+        ktxProps->m_Faces = info.faces;
+        ktxProps->m_Layers = info.layers;
+        ktxProps->m_Depth = info.depth;
+        ktxProps->m_Srgb = info.srgb;
+        ktxProps->m_KtxVersion = info.version;
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+#ifndef KTXREADER_H
+#define KTXREADER_H
+
+#include "ImageReader.h"
+#include "DdsReader.h"
+
+// KTX Reader GUID
+#define KTXREADER_GUID CKGUID(0x2C1ED85F, 0x73B99652)
+
+/**
+ * KtxReader - Khronos texture (.ktx, .ktx2) reader
+ *
+ *   - KTX 1 (either byte order) and KTX 2 without supercompression, told
+ *     apart by their identifier; one reader is registered for both, as
+ *     "ktx2" does not fit in a CKFileExtension
+ *   - BC1 to BC7 (S3TC, RGTC and BPTC) and 8-bit RGBA, RGB, BGRA, BGR and
+ *     single channel formats
+ *   - With IMAGE_READ_KEEP_BLOCKS the blocks of the whole mip chain are
+ *     copied once from the mapped file and never decoded
+ *   - Otherwise the top level is decoded to BGRA32 as the DDS reader does;
+ *     BC6H gives RGBA float with IMAGE_READ_FLOAT
+ *   - Only the first face of cube maps, layer of arrays and slice of 3D
+ *     textures is read
+ *   - Read-only: SaveFile and SaveMemory return 0
+ */
+class KtxReader : public ImageReader
+{
+public:
+    KtxReader();
+    virtual ~KtxReader();
+
+    virtual CKPluginInfo *GetReaderInfo();
+    virtual int GetOptionsCount();
+    virtual CKSTRING GetOptionDescription(int i);
+
+    virtual int ReadFile(CKSTRING filename, CKBitmapProperties **bp);
+    virtual int ReadMemory(void *memory, int size, CKBitmapProperties **bp);
+
+    // IMAGE_READ_* flags applied by ReadFile/ReadMemory (default 0)
+    void SetReadFlags(CKDWORD flags);
+    CKDWORD GetReadFlags();
+
+protected:
+    virtual int ReadOwnFormat(void *data, int size, CKBitmapProperties *props);
+
+private:
+    KtxBitmapProperties m_Properties;
+    CKDWORD m_ReadFlags;
+};
+
+//=============================================================================
+// KTX file format
+//=============================================================================
+#define KTX_IDENTIFIER_SIZE 12
+#define KTX1_HEADER_SIZE 64
+#define KTX2_HEADER_SIZE 80 // up to the level index
+#define KTX2_LEVEL_INDEX_ENTRY 24
+
+#define KTX_ENDIAN_REF 0x04030201
+#define KTX_ENDIAN_REF_REV 0x01020304
+
+// OpenGL enums of KTX 1 uncompressed formats
+#define KTX_GL_UNSIGNED_BYTE 0x1401
+#define KTX_GL_RED 0x1903
+#define KTX_GL_RGB 0x1907
+#define KTX_GL_RGBA 0x1908
+#define KTX_GL_LUMINANCE 0x1909
+#define KTX_GL_LUMINANCE_ALPHA 0x190A
+#define KTX_GL_BGR 0x80E0
+#define KTX_GL_BGRA 0x80E1
+#define KTX_GL_SRGB8 0x8C41
+#define KTX_GL_SRGB8_ALPHA8 0x8C43
+
+#define KTX_MAX_LEVELS 32
+
+// Offset of a level the file ends before
+#define KTX_LEVEL_MISSING 0xFFFFFFFFFFFFFFFFULL
+
+struct KtxImageInfo
+{
+    CKDWORD version; // 1 or 2
+    CKDWORD width;
+    CKDWORD height; // 1 for 1D textures
+    CKDWORD depth;  // 1 unless a 3D texture
+    CKDWORD faces;  // 6 for cube maps
+    CKDWORD layers; // at least 1
+    CKDWORD mipCount;
+    CKDWORD blockFormat; // IMAGE_BLOCK_*, or IMAGE_BLOCK_NONE with mask set
+    DdsMaskFormat mask;
+    CKBOOL srgb;
+    CKBOOL opaque;       // BC1 without alpha: punch-through pixels are black
+    CKDWORD rowAlignment; // uncompressed rows: 4 bytes in KTX 1, packed in KTX 2
+    uint64_t levelOffsets[KTX_MAX_LEVELS]; // first face, layer and slice of each level
+};
+
+//=============================================================================
+// Internal helper functions
+//=============================================================================
+
+// Parses the header and locates the levels (KTX 1 or KTX 2)
+int KTX_ReadInfo(const CKBYTE *data, CKDWORD size, KtxImageInfo &info);
+
+// Core KTX read function (size == 0 means data is a filename)
+int KTX_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags = 0);
+
+#endif // KTXREADER_H
@@ -1,7 +1,11 @@
 #include "PcxReader.h"
+#include "ImageSimd.h"
+#include "ImageThreadPool.h"
 
 #include "XArray.h"
 
+#include <emmintrin.h>
+
 //=============================================================================
 // Data Source Abstraction
 //=============================================================================
@@ -10,7 +14,9 @@ class PcxDataSource
 public:
     virtual ~PcxDataSource() {}
     virtual CKBOOL ReadHeader(PCXHEADER &hdr) = 0;
-    virtual CKBOOL ReadRemaining(XArray<CKBYTE> &out) = 0;
+    // Exposes the bytes after the header. Sources that are not already in memory
+    // load them into storage; memory sources point into the caller's buffer.
+    virtual CKBOOL ReadRemaining(XArray<CKBYTE> &storage, const CKBYTE *&data, CKDWORD &size) = 0;
 };
 
 class PcxFileSource : public PcxDataSource
@@ -31,8 +37,10 @@ public:
         return m_fp && fread(&hdr, 1, sizeof(hdr), m_fp) == sizeof(hdr);
     }
 
-    CKBOOL ReadRemaining(XArray<CKBYTE> &out) override
+    CKBOOL ReadRemaining(XArray<CKBYTE> &storage, const CKBYTE *&data, CKDWORD &size) override
     {
+        data = NULL;
+        size = 0;
         if (!m_fp)
             return FALSE;
         long cur = ftell(m_fp);
@@ -46,8 +54,12 @@ public:
         CKDWORD remaining = (CKDWORD)(end - cur);
         if (remaining == 0)
             return TRUE;
-        out.Resize((int)remaining);
-        return fread(out.Begin(), 1, remaining, m_fp) == remaining;
+        storage.Resize((int)remaining);
+        if (fread(storage.Begin(), 1, remaining, m_fp) != remaining)
+            return FALSE;
+        data = storage.Begin();
+        size = remaining;
+        return TRUE;
     }
 };
 
@@ -70,13 +82,14 @@ public:
         return TRUE;
     }
 
-    CKBOOL ReadRemaining(XArray<CKBYTE> &out) override
+    CKBOOL ReadRemaining(XArray<CKBYTE> &storage, const CKBYTE *&data, CKDWORD &size) override
     {
+        data = NULL;
+        size = 0;
         if (m_offset >= (CKDWORD)m_size)
             return TRUE;
-        CKDWORD remaining = (CKDWORD)m_size - m_offset;
-        out.Resize((int)remaining);
-        memcpy(out.Begin(), m_data + m_offset, remaining);
+        data = m_data + m_offset;
+        size = (CKDWORD)m_size - m_offset;
         return TRUE;
     }
 };
@@ -124,6 +137,64 @@ static void GetPal16(const PCXHEADER &hdr, CKBOOL useDefault, CKDWORD idx, CKBYT
 //=============================================================================
 // PCX Context & Scanline Decoding
 //=============================================================================
+
+// Counts leading bytes of src that are plain literals, i.e. without the 0xC0 run marker.
+// Literal stretches are then copied in bulk instead of byte by byte.
+static CKDWORD CountRleLiterals(const CKBYTE *src, CKDWORD count, CKBOOL useSse2)
+{
+    if (count == 0 || (src[0] & 0xC0) == 0xC0)
+        return 0;
+
+    CKDWORD n = 0;
+    if (useSse2)
+    {
+        // A byte is a marker when max(byte, 0xC0) == byte, i.e. byte >= 0xC0
+        const __m128i marker = _mm_set1_epi8((char)0xC0);
+        for (; n + 16 <= count; n += 16)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + n));
+            int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v, marker), v));
+            if (mask)
+                return n + ImageLowestBit((CKDWORD)mask);
+        }
+    }
+    for (; n < count; n++)
+        if ((src[n] & 0xC0) == 0xC0)
+            break;
+    return n;
+}
+
+// Decodes one RLE scanline of outSize bytes. Runs are clipped at the end of the line.
+// Bytes left over when the input runs out are zeroed.
+static void DecodeRleLine(const CKBYTE *src, CKDWORD srcSize, CKDWORD &srcPos,
+                          CKBYTE *out, CKDWORD outSize, CKBOOL useSse2)
+{
+    CKDWORD linePos = 0;
+    while (linePos < outSize && srcPos < srcSize)
+    {
+        CKDWORD literals = CountRleLiterals(src + srcPos, MinDword(outSize - linePos, srcSize - srcPos), useSse2);
+        if (literals)
+        {
+            memcpy(out + linePos, src + srcPos, literals);
+            srcPos += literals;
+            linePos += literals;
+            continue;
+        }
+
+        CKDWORD count = src[srcPos++] & 0x3F;
+        if (count == 0)
+            count = 1;
+        if (srcPos >= srcSize)
+            break;
+        CKBYTE value = src[srcPos++];
+        CKDWORD toWrite = MinDword(count, outSize - linePos);
+        memset(out + linePos, value, toWrite);
+        linePos += toWrite;
+    }
+    if (linePos < outSize)
+        memset(out + linePos, 0, outSize - linePos);
+}
+
 struct PcxContext
 {
     PCXHEADER header;
@@ -131,55 +202,72 @@ struct PcxContext
     CKBOOL isPlanar1bpp, isPacked2bpp, isPacked4bpp;
     CKBOOL isIndexed8bpp, isTrueColor24, isTrueColor32;
     CKBOOL forceDefaultEga;
-    XArray<CKBYTE> fileData;
-    CKDWORD srcPos;
+    const CKBYTE *data;      // image data following the header (not owned)
+    CKDWORD dataSize;
+    XArray<CKBYTE> fileData; // backing storage when reading from a file
+    CKBOOL useSse2;
 
     PcxContext() : width(0), height(0), bytesPerScanLine(0),
                    isPlanar1bpp(FALSE), isPacked2bpp(FALSE), isPacked4bpp(FALSE),
                    isIndexed8bpp(FALSE), isTrueColor24(FALSE), isTrueColor32(FALSE),
-                   forceDefaultEga(FALSE), srcPos(0)
+                   forceDefaultEga(FALSE), data(NULL), dataSize(0), useSse2(ImageCpuHas(IMAGE_CPU_SSE2))
     {
         memset(&header, 0, sizeof(header));
     }
 
-    void DecodeScanLine(CKBYTE *out)
+    // Decodes the scanline starting at srcPos and advances srcPos past it
+    void DecodeScanLine(CKDWORD &srcPos, CKBYTE *out) const
     {
-        memset(out, 0, bytesPerScanLine);
-        if (!fileData.Begin())
+        if (!data)
+        {
+            memset(out, 0, bytesPerScanLine);
             return;
-        CKDWORD dataSize = (CKDWORD)fileData.Size();
+        }
 
         if (header.encoding == 0)
         {
             CKDWORD remaining = (srcPos < dataSize) ? (dataSize - srcPos) : 0;
             CKDWORD toCopy = MinDword(remaining, bytesPerScanLine);
             if (toCopy)
-                memcpy(out, fileData.Begin() + srcPos, toCopy);
+                memcpy(out, data + srcPos, toCopy);
+            if (toCopy < bytesPerScanLine)
+                memset(out + toCopy, 0, bytesPerScanLine - toCopy);
             srcPos += toCopy;
             return;
         }
 
-        // RLE decoding
+        DecodeRleLine(data, dataSize, srcPos, out, bytesPerScanLine, useSse2);
+    }
+
+    // Advances srcPos past one scanline exactly as DecodeScanLine would, without writing output
+    void SkipScanLine(CKDWORD &srcPos) const
+    {
+        if (header.encoding == 0)
+        {
+            CKDWORD remaining = (srcPos < dataSize) ? (dataSize - srcPos) : 0;
+            srcPos += MinDword(remaining, bytesPerScanLine);
+            return;
+        }
+
+        const CKBYTE *src = data;
         CKDWORD linePos = 0;
         while (linePos < bytesPerScanLine && srcPos < dataSize)
         {
-            CKBYTE byte = fileData.Begin()[srcPos++];
-            if ((byte & 0xC0) == 0xC0)
+            CKDWORD literals = CountRleLiterals(src + srcPos, MinDword(bytesPerScanLine - linePos, dataSize - srcPos), useSse2);
+            if (literals)
             {
-                CKDWORD count = byte & 0x3F;
-                if (count == 0)
-                    count = 1;
-                if (srcPos >= dataSize)
-                    break;
-                CKBYTE value = fileData.Begin()[srcPos++];
-                CKDWORD toWrite = MinDword(count, bytesPerScanLine - linePos);
-                memset(out + linePos, value, toWrite);
-                linePos += toWrite;
-            }
-            else
-            {
-                out[linePos++] = byte;
+                srcPos += literals;
+                linePos += literals;
+                continue;
             }
+
+            CKDWORD count = src[srcPos++] & 0x3F;
+            if (count == 0)
+                count = 1;
+            if (srcPos >= dataSize)
+                break;
+            srcPos++;
+            linePos += MinDword(count, bytesPerScanLine - linePos);
         }
     }
 };
@@ -199,7 +287,7 @@ static int ParsePcxHeader(PcxDataSource &src, PcxContext &ctx)
 
     if (ctx.width == 0 || ctx.height == 0)
         return CKBITMAPERROR_FILECORRUPTED;
-    if (ctx.width > 32768 || ctx.height > 32768)
+    if (ctx.width > PCX_MAX_DIMENSION || ctx.height > PCX_MAX_DIMENSION)
         return CKBITMAPERROR_FILECORRUPTED;
     if (ctx.header.bitsPerPixel == 0 || ctx.header.nPlanes == 0 || ctx.header.bytesPerLine == 0)
         return CKBITMAPERROR_FILECORRUPTED;
@@ -232,90 +320,106 @@ static int ParsePcxHeader(PcxDataSource &src, PcxContext &ctx)
 //=============================================================================
 // Row Decoders
 //=============================================================================
-static void DecodeRowPlanar1bpp(const PcxContext &ctx, CKDWORD width, const CKBYTE *scanLine, CKBYTE *dstRow)
+// Spreads the 8 bits of a plane byte into the low bit of 8 nibbles, leftmost pixel
+// in the lowest nibble. OR-ing the tables of every plane (shifted by plane number)
+// yields the 4-bit indices of 8 pixels in one word.
+#define PCX_SPREAD(v)                                                                                          \
+    ((((v) >> 7) & 1) | ((((v) >> 6) & 1) << 4) | ((((v) >> 5) & 1) << 8) | ((((v) >> 4) & 1) << 12) |       \
+     ((((v) >> 3) & 1) << 16) | ((((v) >> 2) & 1) << 20) | ((((v) >> 1) & 1) << 24) | (((v) & 1) << 28))
+#define PCX_SPREAD4(v) PCX_SPREAD(v), PCX_SPREAD((v) + 1), PCX_SPREAD((v) + 2), PCX_SPREAD((v) + 3)
+#define PCX_SPREAD16(v) PCX_SPREAD4(v), PCX_SPREAD4((v) + 4), PCX_SPREAD4((v) + 8), PCX_SPREAD4((v) + 12)
+#define PCX_SPREAD64(v) PCX_SPREAD16(v), PCX_SPREAD16((v) + 16), PCX_SPREAD16((v) + 32), PCX_SPREAD16((v) + 48)
+
+static const CKDWORD s_BitSpread[256] = {PCX_SPREAD64(0u), PCX_SPREAD64(64u), PCX_SPREAD64(128u),
+                                         PCX_SPREAD64(192u)};
+
+// Resolves the 16-color header (or default EGA) palette to BGRA32 once per image
+static void BuildPal16Lut(const PcxContext &ctx, CKDWORD lut[16])
+{
+    CKBOOL mono = ctx.isPlanar1bpp && ctx.header.paletteInfo == 2 && ctx.header.nPlanes == 1;
+    for (CKDWORD i = 0; i < 16; i++)
+    {
+        CKBYTE r, g, b;
+        if (mono)
+            r = g = b = (i & 1) ? 255 : 0;
+        else
+            GetPal16(ctx.header, ctx.forceDefaultEga, i, r, g, b);
+        lut[i] = 0xFF000000 | ((CKDWORD)r << 16) | ((CKDWORD)g << 8) | (CKDWORD)b;
+    }
+}
+
+static void DecodeRowPlanar1bpp(const PcxContext &ctx, const CKDWORD pal16[16], CKDWORD width,
+                                const CKBYTE *scanLine, CKBYTE *dstRow)
 {
+    const CKDWORD *spread = s_BitSpread;
     CKDWORD nPlanes = ctx.header.nPlanes;
-    CKDWORD maxX = MinDword(width, ctx.header.bytesPerLine * 8);
+    CKDWORD bytesPerLine = ctx.header.bytesPerLine;
+    CKDWORD maxX = MinDword(width, bytesPerLine * 8);
+    CKDWORD *dst = (CKDWORD *)dstRow;
 
-    for (CKDWORD x = 0; x < maxX; x++)
+    for (CKDWORD x = 0, byteOff = 0; x < maxX; x += 8, byteOff++)
     {
-        CKDWORD byteOff = x / 8;
-        CKDWORD bitOff = 7 - (x & 7);
-        CKDWORD idx = 0;
-        for (CKDWORD p = 0; p < nPlanes; p++)
-            idx |= ((scanLine[p * ctx.header.bytesPerLine + byteOff] >> bitOff) & 1) << p;
+        const CKBYTE *src = scanLine + byteOff;
+        CKDWORD nibbles = spread[src[0]];
+        for (CKDWORD p = 1; p < nPlanes; p++)
+            nibbles |= spread[src[p * bytesPerLine]] << p;
 
-        CKBYTE r, g, b;
-        if (ctx.header.paletteInfo == 2 && nPlanes == 1)
+        if (x + 8 <= maxX)
         {
-            r = g = b = (idx & 1) ? 255 : 0;
+            dst[x + 0] = pal16[nibbles & 15];
+            dst[x + 1] = pal16[(nibbles >> 4) & 15];
+            dst[x + 2] = pal16[(nibbles >> 8) & 15];
+            dst[x + 3] = pal16[(nibbles >> 12) & 15];
+            dst[x + 4] = pal16[(nibbles >> 16) & 15];
+            dst[x + 5] = pal16[(nibbles >> 20) & 15];
+            dst[x + 6] = pal16[(nibbles >> 24) & 15];
+            dst[x + 7] = pal16[nibbles >> 28];
         }
         else
         {
-            GetPal16(ctx.header, ctx.forceDefaultEga, idx, r, g, b);
+            for (CKDWORD i = 0; x + i < maxX; i++, nibbles >>= 4)
+                dst[x + i] = pal16[nibbles & 15];
         }
-        dstRow[x * 4 + 0] = b;
-        dstRow[x * 4 + 1] = g;
-        dstRow[x * 4 + 2] = r;
-        dstRow[x * 4 + 3] = 255;
     }
 }
 
-static void DecodeRowPacked2bpp(const PcxContext &ctx, CKDWORD width, const CKBYTE *scanLine, CKBYTE *dstRow)
+static void DecodeRowPacked2bpp(const PcxContext &ctx, const CKDWORD pal16[16], CKDWORD width,
+                                const CKBYTE *scanLine, CKBYTE *dstRow)
 {
     CKDWORD maxX = MinDword(width, ctx.header.bytesPerLine * 4);
+    CKDWORD *dst = (CKDWORD *)dstRow;
     for (CKDWORD x = 0; x < maxX; x++)
     {
-        CKBYTE byteVal = scanLine[x / 4];
         CKDWORD shift = 6 - 2 * (x & 3);
-        CKDWORD idx = (byteVal >> shift) & 3;
-        CKBYTE r, g, b;
-        GetPal16(ctx.header, ctx.forceDefaultEga, idx, r, g, b);
-        dstRow[x * 4 + 0] = b;
-        dstRow[x * 4 + 1] = g;
-        dstRow[x * 4 + 2] = r;
-        dstRow[x * 4 + 3] = 255;
+        dst[x] = pal16[(scanLine[x / 4] >> shift) & 3];
     }
 }
 
-static void DecodeRowPacked4bpp(const PcxContext &ctx, CKDWORD width, const CKBYTE *scanLine, CKBYTE *dstRow)
+static void DecodeRowPacked4bpp(const PcxContext &ctx, const CKDWORD pal16[16], CKDWORD width,
+                                const CKBYTE *scanLine, CKBYTE *dstRow)
 {
     CKDWORD maxX = MinDword(width, ctx.header.bytesPerLine * 2);
+    CKDWORD *dst = (CKDWORD *)dstRow;
     for (CKDWORD x = 0; x < maxX; x++)
     {
         CKBYTE byteVal = scanLine[x / 2];
-        CKDWORD idx = (x & 1) ? (byteVal & 0x0F) : (byteVal >> 4);
-        CKBYTE r, g, b;
-        GetPal16(ctx.header, ctx.forceDefaultEga, idx, r, g, b);
-        dstRow[x * 4 + 0] = b;
-        dstRow[x * 4 + 1] = g;
-        dstRow[x * 4 + 2] = r;
-        dstRow[x * 4 + 3] = 255;
+        dst[x] = pal16[(x & 1) ? (byteVal & 0x0F) : (byteVal >> 4)];
     }
 }
 
 static void DecodeRowTrueColor24(const PcxContext &ctx, CKDWORD width, const CKBYTE *scanLine, CKBYTE *dstRow)
 {
-    CKDWORD maxX = MinDword(width, ctx.header.bytesPerLine);
-    for (CKDWORD x = 0; x < maxX; x++)
-    {
-        dstRow[x * 4 + 2] = scanLine[x];                               // R
-        dstRow[x * 4 + 1] = scanLine[ctx.header.bytesPerLine + x];     // G
-        dstRow[x * 4 + 0] = scanLine[ctx.header.bytesPerLine * 2 + x]; // B
-        dstRow[x * 4 + 3] = 255;
-    }
+    CKDWORD bytesPerLine = ctx.header.bytesPerLine;
+    CKDWORD maxX = MinDword(width, bytesPerLine);
+    ImagePlanarToBGRA32(scanLine, scanLine + bytesPerLine, scanLine + bytesPerLine * 2, NULL, dstRow, (int)maxX);
 }
 
 static void DecodeRowTrueColor32(const PcxContext &ctx, CKDWORD width, const CKBYTE *scanLine, CKBYTE *dstRow)
 {
-    CKDWORD maxX = MinDword(width, ctx.header.bytesPerLine);
-    for (CKDWORD x = 0; x < maxX; x++)
-    {
-        dstRow[x * 4 + 2] = scanLine[x];                               // R
-        dstRow[x * 4 + 1] = scanLine[ctx.header.bytesPerLine + x];     // G
-        dstRow[x * 4 + 0] = scanLine[ctx.header.bytesPerLine * 2 + x]; // B
-        dstRow[x * 4 + 3] = scanLine[ctx.header.bytesPerLine * 3 + x]; // A
-    }
+    CKDWORD bytesPerLine = ctx.header.bytesPerLine;
+    CKDWORD maxX = MinDword(width, bytesPerLine);
+    ImagePlanarToBGRA32(scanLine, scanLine + bytesPerLine, scanLine + bytesPerLine * 2, scanLine + bytesPerLine * 3,
+                        dstRow, (int)maxX);
 }
 
 //=============================================================================
@@ -334,36 +438,175 @@ static const CKBYTE *FindVgaPalette(const CKBYTE *data, CKDWORD dataSize, CKDWOR
     return NULL;
 }
 
-static void ApplyIndexedPalette(CKDWORD width, CKDWORD height, CKDWORD stride,
-                                const CKBYTE *indexPixels, CKBYTE *dstPixels,
-                                const CKBYTE *vgaPal, CKBOOL grayscale)
+// Locates the 8bpp palette before any pixel is decoded. Conforming files keep it in
+// the last 769 bytes; only files with trailing data need a skip-only pass over the
+// RLE stream to find where the image data ends.
+static const CKBYTE *LocateVgaPalette(const PcxContext &ctx)
 {
-    for (CKDWORD y = 0; y < height; y++)
+    const CKBYTE *data = ctx.data;
+    CKDWORD dataSize = ctx.dataSize;
+    if (!data || dataSize < 769)
+        return NULL;
+    if (data[dataSize - 769] == 0x0C)
+        return data + dataSize - 768;
+
+    CKDWORD imageEndPos = 0;
+    for (CKDWORD y = 0; y < ctx.height; y++)
+        ctx.SkipScanLine(imageEndPos);
+    return FindVgaPalette(data, dataSize, imageEndPos);
+}
+
+// Expands the 256-entry palette into BGRA32 texels so rows convert with one load per pixel
+static void BuildPaletteLut(const CKBYTE *vgaPal, CKBOOL grayscale, CKDWORD lut[256])
+{
+    for (CKDWORD i = 0; i < 256; i++)
+    {
+        if (!grayscale && vgaPal)
+            lut[i] = 0xFF000000 | ((CKDWORD)vgaPal[i * 3 + 0] << 16) |
+                     ((CKDWORD)vgaPal[i * 3 + 1] << 8) | (CKDWORD)vgaPal[i * 3 + 2];
+        else
+            lut[i] = 0xFF000000 | (i << 16) | (i << 8) | i;
+    }
+}
+
+// Walks right to left so scanLine may alias the start of dstRow: pixel x only
+// overwrites index bytes >= x, which have already been consumed.
+static void DecodeRowIndexed8bpp(const PcxContext &ctx, const CKDWORD lut[256], CKDWORD width,
+                                 const CKBYTE *scanLine, CKBYTE *dstRow)
+{
+    CKDWORD *dst = (CKDWORD *)dstRow;
+    CKDWORD maxX = MinDword(width, ctx.header.bytesPerLine);
+    // Columns beyond the encoded scanline read as index 0
+    for (CKDWORD x = width; x > maxX; x--)
+        dst[x - 1] = lut[0];
+
+    CKDWORD x = maxX;
+    for (; x >= 4; x -= 4)
     {
-        CKBYTE *dstRow = dstPixels + y * stride;
-        const CKBYTE *idxRow = indexPixels + y * width;
-        for (CKDWORD x = 0; x < width; x++)
+        CKBYTE i0 = scanLine[x - 4], i1 = scanLine[x - 3], i2 = scanLine[x - 2], i3 = scanLine[x - 1];
+        dst[x - 1] = lut[i3];
+        dst[x - 2] = lut[i2];
+        dst[x - 3] = lut[i1];
+        dst[x - 4] = lut[i0];
+    }
+    for (; x > 0; x--)
+        dst[x - 1] = lut[scanLine[x - 1]];
+}
+
+//=============================================================================
+// Row Job
+//=============================================================================
+
+// Images smaller than this are decoded serially; the pre-scan would not pay off
+#define PCX_PARALLEL_MIN_PIXELS (256 * 256)
+#define PCX_PARALLEL_MIN_ROWS 16
+
+struct PcxRowJob
+{
+    const PcxContext *ctx;
+    const CKDWORD *paletteLut;
+    const CKDWORD *pal16;
+    const CKDWORD *rowOffsets; // compressed start of each scanline, NULL when decoding serially
+    CKBYTE *dstPixels;
+    CKDWORD dstStride;
+    CKBOOL keepIndices; // 8bpp only: store the indices instead of expanding them
+};
+
+// Copies the decoded 8bpp indices of one row; columns beyond the encoded
+// scanline read as index 0, as in DecodeRowIndexed8bpp.
+static void StoreRowIndices8bpp(const PcxContext &ctx, CKDWORD width, const CKBYTE *scanLine,
+                                CKBYTE *dstRow, CKDWORD dstStride)
+{
+    CKDWORD valid = MinDword(width, ctx.header.bytesPerLine);
+    if (scanLine != dstRow)
+        memcpy(dstRow, scanLine, valid);
+    memset(dstRow + valid, 0, dstStride - valid);
+}
+
+// Decodes scanlines [yBegin, yEnd) into BGRA32 (or 8-bit indices with keepIndices). Ranges are independent as long as
+// rowOffsets is set, so this doubles as the worker entry point.
+static void DecodePcxRows(void *context, CKDWORD yBegin, CKDWORD yEnd)
+{
+    const PcxRowJob &job = *(const PcxRowJob *)context;
+    const PcxContext &ctx = *job.ctx;
+    CKDWORD srcPos = job.rowOffsets ? job.rowOffsets[yBegin] : 0;
+
+    // 8bpp indices are decoded straight into the destination row and expanded in place
+    CKBOOL decodeInPlace = ctx.isIndexed8bpp && ctx.bytesPerScanLine <= job.dstStride;
+    XArray<CKBYTE> scanLine;
+    if (!decodeInPlace)
+        scanLine.Resize((int)ctx.bytesPerScanLine);
+
+    for (CKDWORD y = yBegin; y < yEnd; y++)
+    {
+        CKBYTE *dstRow = job.dstPixels + y * job.dstStride;
+        if (decodeInPlace)
         {
-            CKBYTE idx = idxRow[x];
-            if (!grayscale && vgaPal)
+            ctx.DecodeScanLine(srcPos, dstRow);
+            if (job.keepIndices)
             {
-                dstRow[x * 4 + 0] = vgaPal[idx * 3 + 2]; // B
-                dstRow[x * 4 + 1] = vgaPal[idx * 3 + 1]; // G
-                dstRow[x * 4 + 2] = vgaPal[idx * 3 + 0]; // R
+                StoreRowIndices8bpp(ctx, ctx.width, dstRow, dstRow, job.dstStride);
+                continue;
             }
+            DecodeRowIndexed8bpp(ctx, job.paletteLut, ctx.width, dstRow, dstRow);
+            continue;
+        }
+
+        ctx.DecodeScanLine(srcPos, scanLine.Begin());
+        if (ctx.isIndexed8bpp)
+        {
+            if (job.keepIndices)
+                StoreRowIndices8bpp(ctx, ctx.width, scanLine.Begin(), dstRow, job.dstStride);
             else
-            {
-                dstRow[x * 4 + 0] = dstRow[x * 4 + 1] = dstRow[x * 4 + 2] = idx;
-            }
-            dstRow[x * 4 + 3] = 255;
+                DecodeRowIndexed8bpp(ctx, job.paletteLut, ctx.width, scanLine.Begin(), dstRow);
+            continue;
         }
+
+        // Other row decoders leave columns past the encoded scanline untouched
+        CKDWORD *dst = (CKDWORD *)dstRow;
+        for (CKDWORD x = 0; x < ctx.width; x++)
+            dst[x] = 0xFF000000;
+
+        if (ctx.isTrueColor24)
+        {
+            DecodeRowTrueColor24(ctx, ctx.width, scanLine.Begin(), dstRow);
+        }
+        else if (ctx.isTrueColor32)
+        {
+            DecodeRowTrueColor32(ctx, ctx.width, scanLine.Begin(), dstRow);
+        }
+        else if (ctx.isPlanar1bpp)
+        {
+            DecodeRowPlanar1bpp(ctx, job.pal16, ctx.width, scanLine.Begin(), dstRow);
+        }
+        else if (ctx.isPacked2bpp)
+        {
+            DecodeRowPacked2bpp(ctx, job.pal16, ctx.width, scanLine.Begin(), dstRow);
+        }
+        else if (ctx.isPacked4bpp)
+        {
+            DecodeRowPacked4bpp(ctx, job.pal16, ctx.width, scanLine.Begin(), dstRow);
+        }
+    }
+}
+
+// Records where each scanline starts in the compressed data. Runs are clipped at the
+// end of a scanline (as the serial decoder does), so these offsets are exact.
+static void BuildRowOffsets(const PcxContext &ctx, XArray<CKDWORD> &rowOffsets)
+{
+    rowOffsets.Resize((int)ctx.height);
+    CKDWORD srcPos = 0;
+    for (CKDWORD y = 0; y < ctx.height; y++)
+    {
+        rowOffsets[(int)y] = srcPos;
+        ctx.SkipScanLine(srcPos);
     }
 }
 
 //=============================================================================
 // PcxReader Class Implementation
 //=============================================================================
-PcxReader::PcxReader() : ImageReader()
+PcxReader::PcxReader() : ImageReader(), m_ReadFlags(0)
 {
     m_Properties.Init(PCXREADER_GUID, "pcx");
 }
@@ -378,12 +621,16 @@ CKPluginInfo *PcxReader::GetReaderInfo()
     return &g_PluginInfo[READER_INDEX_PCX];
 }
 
-int PcxReader::GetOptionsCount() { return 0; }
+void PcxReader::SetReadFlags(CKDWORD flags) { m_ReadFlags = flags; }
+
+CKDWORD PcxReader::GetReadFlags() { return m_ReadFlags; }
+
+int PcxReader::GetOptionsCount() { return 2; }
 
 CKSTRING PcxReader::GetOptionDescription(int i)
 {
     if (i == 0)
-        return "Enum:Bit Depth:1 bit=1,4 bit=4,8 bit=8,24 bit=24";
+        return "Enum:Bit Depth:8 bit=8,24 bit=24";
     if (i == 1)
         return "Boolean:Run Length Encoding";
     return "";
@@ -395,7 +642,7 @@ int PcxReader::ReadFile(CKSTRING filename, CKBitmapProperties **bp)
 {
     if (!filename || !bp)
         return 1;
-    int result = PCX_Read((void *)filename, 0, (CKBitmapProperties *)&m_Properties);
+    int result = ReadSniffed(READER_INDEX_PCX, (void *)filename, 0, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
     *bp = (CKBitmapProperties *)&m_Properties;
     return result;
 }
@@ -404,24 +651,54 @@ int PcxReader::ReadMemory(void *memory, int size, CKBitmapProperties **bp)
 {
     if (!bp)
         return 1;
-    int result = PCX_Read(memory, size, (CKBitmapProperties *)&m_Properties);
+    int result = ReadSniffed(READER_INDEX_PCX, memory, size, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
     *bp = (CKBitmapProperties *)&m_Properties;
     return result;
 }
 
-int PcxReader::SaveFile(CKSTRING filename, CKBitmapProperties *bp) { return 0; }
+int PcxReader::ReadOwnFormat(void *data, int size, CKBitmapProperties *props)
+{
+    return PCX_Read(data, size, props, m_ReadFlags);
+}
+
+int PcxReader::SaveFile(CKSTRING filename, CKBitmapProperties *bp)
+{
+    if (!filename || !bp)
+        return 0;
+    PcxBitmapProperties local;
+    memset(&local, 0, sizeof(local));
+    memcpy(&local, bp, (bp->m_Size < sizeof(local)) ? bp->m_Size : sizeof(local));
+    local.m_Size = sizeof(PcxBitmapProperties);
+    if (bp->m_Size != sizeof(PcxBitmapProperties))
+    {
+        local.m_BitDepth = 24;
+        local.m_UseRLE = 1;
+    }
+    void *ptr = (void *)filename;
+    return PCX_Save(&ptr, (CKBitmapProperties *)&local, (int)local.m_BitDepth, (int)local.m_UseRLE);
+}
 
 int PcxReader::SaveMemory(void **memory, CKBitmapProperties *bp)
 {
-    if (memory && bp)
-        *memory = NULL;
-    return 0;
+    if (!memory || !bp)
+        return 0;
+    PcxBitmapProperties local;
+    memset(&local, 0, sizeof(local));
+    memcpy(&local, bp, (bp->m_Size < sizeof(local)) ? bp->m_Size : sizeof(local));
+    local.m_Size = sizeof(PcxBitmapProperties);
+    if (bp->m_Size != sizeof(PcxBitmapProperties))
+    {
+        local.m_BitDepth = 24;
+        local.m_UseRLE = 1;
+    }
+    *memory = NULL;
+    return PCX_Save(memory, (CKBitmapProperties *)&local, (int)local.m_BitDepth, (int)local.m_UseRLE);
 }
 
 //=============================================================================
 // PCX_Read - Core Reading Function
 //=============================================================================
-int PCX_Read(void *data, int size, CKBitmapProperties *props)
+int PCX_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags)
 {
     if (!data || !props)
         return CKBITMAPERROR_GENERIC;
@@ -447,8 +724,20 @@ int PCX_Read(void *data, int size, CKBitmapProperties *props)
         return result;
     }
 
-    // Read remaining file data
-    if (!src->ReadRemaining(ctx.fileData))
+    // Reject images over the decode limits before reading the file. Index
+    // images carry their palette at the start of the block.
+    CKBOOL keepIndices = ctx.isIndexed8bpp && (readFlags & IMAGE_READ_KEEP_INDICES);
+    CKDWORD paletteSize = keepIndices ? 256 * 4 : 0;
+    CKDWORD dstStride = keepIndices ? (CKDWORD)ImageReader::Indexed8Stride((int)ctx.width) : ctx.width * 4;
+    uint64_t dstSize64 = (uint64_t)dstStride * ctx.height;
+    if (!ImageWithinDecodeLimits(ctx.width, ctx.height, dstSize64 + paletteSize))
+    {
+        delete src;
+        return CKBITMAPERROR_FILECORRUPTED;
+    }
+
+    // Read remaining file data (memory sources are decoded in place)
+    if (!src->ReadRemaining(ctx.fileData, ctx.data, ctx.dataSize))
     {
         delete src;
         return CKBITMAPERROR_READERROR;
@@ -456,82 +745,382 @@ int PCX_Read(void *data, int size, CKBitmapProperties *props)
     delete src;
     src = NULL;
 
-    // Allocate destination
-    CKDWORD dstStride = ctx.width * 4;
-    uint64_t dstSize64 = (uint64_t)dstStride * ctx.height;
-    if (dstSize64 > 0x7FFFFFFFULL)
+    // Data that cannot hold every scanline is rejected before allocating:
+    // uncompressed scanlines are stored whole and an RLE run covers 63 bytes
+    // at most. RLE scanlines cut short are zero-filled.
+    uint64_t minLineSize = (ctx.header.encoding == 0) ? ctx.bytesPerScanLine : (ctx.bytesPerScanLine + 62) / 63;
+    if (ctx.dataSize < minLineSize * ctx.height)
         return CKBITMAPERROR_FILECORRUPTED;
 
-    CKBYTE *dstPixels = new CKBYTE[(CKDWORD)dstSize64];
-    memset(dstPixels, 0, (CKDWORD)dstSize64);
-    for (CKDWORD i = 0; i < (CKDWORD)dstSize64; i += 4)
-        dstPixels[i + 3] = 255;
-
-    // Allocate scanline buffer
-    XArray<CKBYTE> scanLine((int)ctx.bytesPerScanLine);
-    scanLine.Resize((int)ctx.bytesPerScanLine);
+    // Allocate destination
+    CKBYTE *dstBlock = new CKBYTE[(CKDWORD)dstSize64 + paletteSize];
+    CKBYTE *dstPixels = dstBlock + paletteSize;
 
-    // Allocate index buffer for 8bpp
-    CKBYTE *indexPixels = NULL;
+    // Resolve the palettes up front so rows convert straight to BGRA32
+    CKDWORD paletteLut[256];
     if (ctx.isIndexed8bpp)
     {
-        uint64_t idxSize = (uint64_t)ctx.width * ctx.height;
-        if (idxSize > 0x7FFFFFFFULL)
-        {
-            delete[] dstPixels;
-            return CKBITMAPERROR_FILECORRUPTED;
-        }
-        indexPixels = new CKBYTE[(CKDWORD)idxSize];
-        memset(indexPixels, 0, (CKDWORD)idxSize);
+        const CKBYTE *vgaPal = LocateVgaPalette(ctx);
+        BuildPaletteLut(vgaPal, ctx.header.paletteInfo == 2, paletteLut);
     }
+    CKDWORD pal16[16];
+    BuildPal16Lut(ctx, pal16);
 
-    // Decode scanlines
-    ctx.srcPos = 0;
-    for (CKDWORD y = 0; y < ctx.height; y++)
+    PcxRowJob job;
+    job.ctx = &ctx;
+    job.paletteLut = paletteLut;
+    job.pal16 = pal16;
+    job.rowOffsets = NULL;
+    job.dstPixels = dstPixels;
+    job.dstStride = dstStride;
+    job.keepIndices = keepIndices;
+
+    // Large images are pre-scanned for scanline offsets and decoded on the worker pool
+    XArray<CKDWORD> rowOffsets;
+    if ((uint64_t)ctx.width * ctx.height >= PCX_PARALLEL_MIN_PIXELS &&
+        ctx.height >= PCX_PARALLEL_MIN_ROWS && ImageWorkerCount() > 1)
+    {
+        BuildRowOffsets(ctx, rowOffsets);
+        job.rowOffsets = rowOffsets.Begin();
+        ImageParallelFor(ctx.height, PCX_PARALLEL_MIN_ROWS / 2, DecodePcxRows, &job);
+    }
+    else
     {
-        ctx.DecodeScanLine(scanLine.Begin());
-        CKBYTE *dstRow = dstPixels + y * dstStride;
+        DecodePcxRows(&job, 0, ctx.height);
+    }
 
-        if (ctx.isIndexed8bpp)
-        {
-            CKDWORD maxX = MinDword(ctx.width, ctx.header.bytesPerLine);
-            CKBYTE *idxRow = indexPixels + y * ctx.width;
-            for (CKDWORD x = 0; x < maxX; x++)
-                idxRow[x] = scanLine.Begin()[x];
-        }
-        else if (ctx.isTrueColor24)
+    // Fill properties
+    if (keepIndices)
+    {
+        // paletteLut entries are BGRA in memory order
+        memcpy(dstBlock, paletteLut, paletteSize);
+        ImageReader::FillFormatIndexed8(props->m_Format, (int)ctx.width, (int)ctx.height, (int)dstStride,
+                                        dstPixels, dstBlock, 256);
+    }
+    else
+    {
+        ImageReader::FillFormatBGRA32(props->m_Format, (int)ctx.width, (int)ctx.height, (int)dstStride, dstPixels);
+    }
+    props->m_Data = dstBlock;
+    return 0;
+}
+
+//=============================================================================
+// Palette Building (8-bit save)
+//=============================================================================
+
+// Exact palettes are looked up through a small open-addressing table keyed by
+// BGR color. Keys carry bit 24 so that black is distinguishable from an empty slot.
+#define PCX_COLOR_HASH_SIZE 1024
+#define PCX_COLOR_USED 0x01000000
+
+struct PcxSavePalette
+{
+    CKBYTE rgb[768];
+    CKBOOL exact;                            // FALSE: fixed 6x7x6 color cube
+    CKDWORD hashKeys[PCX_COLOR_HASH_SIZE];
+    CKBYTE hashIndex[PCX_COLOR_HASH_SIZE];
+    CKBYTE cubeR[256], cubeG[256], cubeB[256];
+};
+
+static CKDWORD HashColor(CKDWORD color) { return (color * 2654435761u) >> 22; }
+
+// Collects the distinct colors of the image. Returns FALSE once a 257th color shows up.
+static CKBOOL BuildExactPalette(const VxImageDescEx &format, PcxSavePalette &pal)
+{
+    memset(pal.hashKeys, 0, sizeof(pal.hashKeys));
+    memset(pal.rgb, 0, sizeof(pal.rgb));
+    CKDWORD colorCount = 0;
+    CKDWORD lastKey = 0;
+
+    for (int y = 0; y < format.Height; y++)
+    {
+        const CKDWORD *row = (const CKDWORD *)(format.Image + y * format.BytesPerLine);
+        for (int x = 0; x < format.Width; x++)
         {
-            DecodeRowTrueColor24(ctx, ctx.width, scanLine.Begin(), dstRow);
+            CKDWORD key = (row[x] & 0x00FFFFFF) | PCX_COLOR_USED;
+            if (key == lastKey)
+                continue;
+            lastKey = key;
+
+            CKDWORD slot = HashColor(key);
+            while (pal.hashKeys[slot] && pal.hashKeys[slot] != key)
+                slot = (slot + 1) & (PCX_COLOR_HASH_SIZE - 1);
+            if (pal.hashKeys[slot])
+                continue;
+            if (colorCount == 256)
+                return FALSE;
+
+            pal.hashKeys[slot] = key;
+            pal.hashIndex[slot] = (CKBYTE)colorCount;
+            pal.rgb[colorCount * 3 + 0] = (CKBYTE)(key >> 16);
+            pal.rgb[colorCount * 3 + 1] = (CKBYTE)(key >> 8);
+            pal.rgb[colorCount * 3 + 2] = (CKBYTE)key;
+            colorCount++;
         }
-        else if (ctx.isTrueColor32)
+    }
+    return TRUE;
+}
+
+// Fallback for images with more than 256 colors: 6 red x 7 green x 6 blue levels
+static void BuildCubePalette(PcxSavePalette &pal)
+{
+    memset(pal.rgb, 0, sizeof(pal.rgb));
+    for (CKDWORD r = 0; r < 6; r++)
+        for (CKDWORD g = 0; g < 7; g++)
+            for (CKDWORD b = 0; b < 6; b++)
+            {
+                CKDWORD i = r * 42 + g * 6 + b;
+                pal.rgb[i * 3 + 0] = (CKBYTE)(r * 255 / 5);
+                pal.rgb[i * 3 + 1] = (CKBYTE)(g * 255 / 6);
+                pal.rgb[i * 3 + 2] = (CKBYTE)(b * 255 / 5);
+            }
+    for (CKDWORD v = 0; v < 256; v++)
+    {
+        pal.cubeR[v] = (CKBYTE)(((v * 5 + 127) / 255) * 42);
+        pal.cubeG[v] = (CKBYTE)(((v * 6 + 127) / 255) * 6);
+        pal.cubeB[v] = (CKBYTE)((v * 5 + 127) / 255);
+    }
+}
+
+static CKBYTE PaletteIndex(const PcxSavePalette &pal, CKDWORD bgra)
+{
+    if (!pal.exact)
+        return (CKBYTE)(pal.cubeR[(bgra >> 16) & 0xFF] + pal.cubeG[(bgra >> 8) & 0xFF] + pal.cubeB[bgra & 0xFF]);
+
+    CKDWORD key = (bgra & 0x00FFFFFF) | PCX_COLOR_USED;
+    CKDWORD slot = HashColor(key);
+    while (pal.hashKeys[slot] != key)
+        slot = (slot + 1) & (PCX_COLOR_HASH_SIZE - 1);
+    return pal.hashIndex[slot];
+}
+
+//=============================================================================
+// Row Encoding
+//=============================================================================
+
+// Length of the run of bytes equal to src[0], at most maxCount
+static CKDWORD CountRleRun(const CKBYTE *src, CKDWORD maxCount, CKBOOL useSse2)
+{
+    if (maxCount < 2 || src[1] != src[0])
+        return 1;
+
+    CKDWORD n = 2;
+    if (useSse2)
+    {
+        const __m128i value = _mm_set1_epi8((char)src[0]);
+        for (; n + 16 <= maxCount; n += 16)
         {
-            DecodeRowTrueColor32(ctx, ctx.width, scanLine.Begin(), dstRow);
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + n));
+            CKDWORD differs = ~(CKDWORD)_mm_movemask_epi8(_mm_cmpeq_epi8(v, value)) & 0xFFFF;
+            if (differs)
+                return n + ImageLowestBit(differs);
         }
-        else if (ctx.isPlanar1bpp)
+    }
+    while (n < maxCount && src[n] == src[0])
+        n++;
+    return n;
+}
+
+// RLE-encodes count bytes from src to out and returns the encoded size. Output never
+// exceeds twice the consumed input, so out may trail src by count bytes in one buffer.
+static CKDWORD EncodeRleLine(const CKBYTE *src, CKDWORD count, CKBYTE *out, CKBOOL useSse2)
+{
+    CKDWORD outPos = 0;
+    CKDWORD i = 0;
+    while (i < count)
+    {
+        CKBYTE value = src[i];
+        CKDWORD run = CountRleRun(src + i, MinDword(count - i, 63), useSse2);
+        if (run > 1 || (value & 0xC0) == 0xC0)
+            out[outPos++] = (CKBYTE)(0xC0 | run);
+        out[outPos++] = value;
+        i += run;
+    }
+    return outPos;
+}
+
+// Each row is encoded into its own slot of the output buffer so rows can be produced
+// in any order; the slots are packed together afterwards. A slot holds the encoded
+// size followed by room for the worst case of 2 bytes per input byte. The raw plane
+// bytes are staged at the end of the slot and encoded towards its start.
+struct PcxEncodeJob
+{
+    const VxImageDescEx *format;
+    const PcxSavePalette *palette; // NULL for 24-bit
+    CKDWORD bytesPerLine;
+    CKDWORD planes;
+    CKDWORD slotSize;
+    CKBOOL useRLE;
+    CKBOOL useSse2;
+    CKBYTE *slots;
+};
+
+static void EncodePcxRows(void *context, CKDWORD yBegin, CKDWORD yEnd)
+{
+    const PcxEncodeJob &job = *(const PcxEncodeJob *)context;
+    CKDWORD width = (CKDWORD)job.format->Width;
+    CKDWORD lineBytes = job.bytesPerLine * job.planes;
+
+    for (CKDWORD y = yBegin; y < yEnd; y++)
+    {
+        const CKDWORD *src = (const CKDWORD *)(job.format->Image + y * job.format->BytesPerLine);
+        CKBYTE *slot = job.slots + y * job.slotSize;
+        CKBYTE *encoded = slot + sizeof(CKDWORD);
+        CKBYTE *raw = job.useRLE ? slot + job.slotSize - lineBytes : encoded;
+
+        if (job.palette)
         {
-            DecodeRowPlanar1bpp(ctx, ctx.width, scanLine.Begin(), dstRow);
+            CKDWORD lastColor = ~src[0];
+            CKBYTE lastIndex = 0;
+            for (CKDWORD x = 0; x < width; x++)
+            {
+                if (src[x] != lastColor)
+                {
+                    lastColor = src[x];
+                    lastIndex = PaletteIndex(*job.palette, lastColor);
+                }
+                raw[x] = lastIndex;
+            }
         }
-        else if (ctx.isPacked2bpp)
+        else
         {
-            DecodeRowPacked2bpp(ctx, ctx.width, scanLine.Begin(), dstRow);
+            CKBYTE *r = raw;
+            CKBYTE *g = raw + job.bytesPerLine;
+            CKBYTE *b = raw + job.bytesPerLine * 2;
+            for (CKDWORD x = 0; x < width; x++)
+            {
+                CKDWORD c = src[x];
+                r[x] = (CKBYTE)(c >> 16);
+                g[x] = (CKBYTE)(c >> 8);
+                b[x] = (CKBYTE)c;
+            }
         }
-        else if (ctx.isPacked4bpp)
+        // Pad each plane to the even bytesPerLine
+        for (CKDWORD p = 0; p < job.planes; p++)
+            for (CKDWORD x = width; x < job.bytesPerLine; x++)
+                raw[p * job.bytesPerLine + x] = 0;
+
+        CKDWORD size = lineBytes;
+        if (job.useRLE)
         {
-            DecodeRowPacked4bpp(ctx, ctx.width, scanLine.Begin(), dstRow);
+            // Runs never cross planes
+            size = 0;
+            for (CKDWORD p = 0; p < job.planes; p++)
+                size += EncodeRleLine(raw + p * job.bytesPerLine, job.bytesPerLine, encoded + size, job.useSse2);
         }
+        memcpy(slot, &size, sizeof(CKDWORD));
     }
+}
 
-    // Apply VGA palette for 8bpp
-    if (ctx.isIndexed8bpp)
+//=============================================================================
+// PCX_Save - Core Saving Function
+//=============================================================================
+int PCX_Save(void **outBuffer, CKBitmapProperties *props, int bitDepth, int useRLE)
+{
+    if (!outBuffer || !props || !props->m_Format.Image)
+        return 0;
+
+    const VxImageDescEx &format = props->m_Format;
+    if (format.Width <= 0 || format.Height <= 0 || format.Width > PCX_MAX_DIMENSION || format.Height > PCX_MAX_DIMENSION)
+        return 0;
+    if (bitDepth != 8 && bitDepth != 24)
+        bitDepth = 24;
+
+    CKDWORD width = (CKDWORD)format.Width;
+    CKDWORD height = (CKDWORD)format.Height;
+    CKDWORD planes = (bitDepth == 8) ? 1 : 3;
+    CKDWORD bytesPerLine = (width + 1) & ~1u;
+    CKDWORD slotSize = sizeof(CKDWORD) + bytesPerLine * planes * (useRLE ? 2 : 1);
+
+    uint64_t maxFileSize64 = sizeof(PCXHEADER) + (uint64_t)slotSize * height + ((bitDepth == 8) ? 769 : 0);
+    if (maxFileSize64 > 0x7FFFFFFFULL)
+        return 0;
+    CKDWORD maxFileSize = (CKDWORD)maxFileSize64;
+
+    PcxSavePalette palette;
+    if (bitDepth == 8)
     {
-        const CKBYTE *vgaPal = FindVgaPalette(ctx.fileData.Begin(), (CKDWORD)ctx.fileData.Size(), ctx.srcPos);
-        CKBOOL grayscale = (ctx.header.paletteInfo == 2);
-        ApplyIndexedPalette(ctx.width, ctx.height, dstStride, indexPixels, dstPixels, vgaPal, grayscale);
-        delete[] indexPixels;
+        palette.exact = BuildExactPalette(format, palette);
+        if (!palette.exact)
+            BuildCubePalette(palette);
     }
 
-    // Fill properties
-    ImageReader::FillFormatBGRA32(props->m_Format, (int)ctx.width, (int)ctx.height, (int)dstStride, dstPixels);
-    props->m_Data = dstPixels;
-    return 0;
+    PCXHEADER header;
+    memset(&header, 0, sizeof(header));
+    header.manufacturer = 0x0A;
+    header.version = 5;
+    header.encoding = useRLE ? 1 : 0;
+    header.bitsPerPixel = 8;
+    header.xMax = (CKWORD)(width - 1);
+    header.yMax = (CKWORD)(height - 1);
+    header.hDPI = 72;
+    header.vDPI = 72;
+    header.nPlanes = (CKBYTE)planes;
+    header.bytesPerLine = (CKWORD)bytesPerLine;
+    header.paletteInfo = 1;
+
+    CKBYTE *buffer = new CKBYTE[maxFileSize];
+    memcpy(buffer, &header, sizeof(header));
+
+    PcxEncodeJob job;
+    job.format = &format;
+    job.palette = (bitDepth == 8) ? &palette : NULL;
+    job.bytesPerLine = bytesPerLine;
+    job.planes = planes;
+    job.slotSize = slotSize;
+    job.useRLE = useRLE ? TRUE : FALSE;
+    job.useSse2 = ImageCpuHas(IMAGE_CPU_SSE2);
+    job.slots = buffer + sizeof(PCXHEADER);
+
+    if ((uint64_t)width * height >= PCX_PARALLEL_MIN_PIXELS && height >= PCX_PARALLEL_MIN_ROWS)
+        ImageParallelFor(height, PCX_PARALLEL_MIN_ROWS / 2, EncodePcxRows, &job);
+    else
+        EncodePcxRows(&job, 0, height);
+
+    // Pack the row slots; each one moves towards the start, never past unread slots
+    CKDWORD writePos = sizeof(PCXHEADER);
+    for (CKDWORD y = 0; y < height; y++)
+    {
+        const CKBYTE *slot = job.slots + y * slotSize;
+        CKDWORD size;
+        memcpy(&size, slot, sizeof(CKDWORD));
+        memmove(buffer + writePos, slot + sizeof(CKDWORD), size);
+        writePos += size;
+    }
+
+    if (bitDepth == 8)
+    {
+        buffer[writePos++] = 0x0C;
+        memcpy(buffer + writePos, palette.rgb, 768);
+        writePos += 768;
+    }
+
+    CKDWORD fileSize = writePos;
+
+    // Output
+    if (*outBuffer)
+    {
+        FILE *fp = fopen((const char *)*outBuffer, "wb");
+        if (!fp)
+        {
+            delete[] buffer;
+            return 0;
+        }
+        fwrite(buffer, 1, fileSize, fp);
+        fclose(fp);
+        delete[] buffer;
+    }
+    else
+    {
+        if (fileSize < maxFileSize)
+        {
+            CKBYTE *final = new CKBYTE[fileSize];
+            memcpy(final, buffer, fileSize);
+            delete[] buffer;
+            buffer = final;
+        }
+        *outBuffer = buffer;
+    }
+    return (int)fileSize;
 }
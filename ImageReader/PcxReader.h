@@ -7,19 +7,22 @@
 #define PCXREADER_GUID CKGUID(0x585C7216, 0x33302657)
 
 /**
- * PcxReader - ZSoft PCX format reader (read-only)
+ * PcxReader - ZSoft PCX format reader/writer
  *
  * Faithfully implements the original Virtools PcxReader including:
  *   - Reading: 1/4/8/24-bit PCX files
  *   - RLE decompression
  *   - Color plane handling
  *
- * NOTE: SaveFile and SaveMemory return 0 (not implemented in original)
+ * Extensions over the original (where SaveFile/SaveMemory returned 0):
+ *   - Writing: 8-bit paletted and 24-bit planar PCX, RLE or uncompressed
+ *   - Reading 8-bit images as indices plus palette (IMAGE_READ_KEEP_INDICES)
  *
  * Original binary layout:
  *   - vtable: 4 bytes (offset 0)
  *   - m_Properties: 80 bytes (PcxBitmapProperties, offset 4)
  *   - Total: 84 bytes (0x54)
+ *   (m_ReadFlags is appended after m_Properties.)
  *
  * Based on reverse-engineering of the original ImageReader.dll
  */
@@ -40,10 +43,18 @@ public:
     virtual int SaveFile(CKSTRING filename, CKBitmapProperties *bp);
     virtual int SaveMemory(void **memory, CKBitmapProperties *bp);
 
+    // IMAGE_READ_* flags applied by ReadFile/ReadMemory (default 0)
+    void SetReadFlags(CKDWORD flags);
+    CKDWORD GetReadFlags();
+
+protected:
+    virtual int ReadOwnFormat(void *data, int size, CKBitmapProperties *props);
+
 private:
     // Extended properties (80 bytes) stored inline
-    // m_Size = 80, m_BitDepth at offset 72, m_UseRLE at offset 76
+    // m_Size = 80, m_BitDepth at offset 72 (8 or 24), m_UseRLE at offset 76
     PcxBitmapProperties m_Properties;
+    CKDWORD m_ReadFlags;
 };
 
 //=============================================================================
@@ -75,11 +86,21 @@ struct PCXHEADER
 
 #pragma pack(pop)
 
+// Largest width and height read, and so written
+#define PCX_MAX_DIMENSION 32768
+
 //=============================================================================
 // Internal helper functions
 //=============================================================================
 
 // Core PCX read function
-int PCX_Read(void *data, int size, CKBitmapProperties *props);
+// With IMAGE_READ_KEEP_INDICES, 8-bit images are returned as 8-bit indices with
+// a 256-entry BGRA palette in m_Format.ColorMap; other formats are always BGRA32.
+int PCX_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags = 0);
+
+// Core PCX save function
+// bitDepth 8 writes a 256-color VGA palette (exact if the image has at most 256
+// colors, otherwise a fixed color cube); any other value writes 24-bit planes
+int PCX_Save(void **outBuffer, CKBitmapProperties *props, int bitDepth, int useRLE);
 
 #endif // PCXREADER_H
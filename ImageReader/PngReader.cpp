@@ -0,0 +1,855 @@
+#include "PngReader.h"
+#include "ImageInflate.h"
+#include "ImageSimd.h"
+#include "ImageFileMap.h"
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+//=============================================================================
+// Byte Helpers
+//=============================================================================
+static CKDWORD ReadBE32(const CKBYTE *p)
+{
+    return ((CKDWORD)p[0] << 24) | ((CKDWORD)p[1] << 16) | ((CKDWORD)p[2] << 8) | (CKDWORD)p[3];
+}
+
+static CKDWORD ReadBE16(const CKBYTE *p) { return ((CKDWORD)p[0] << 8) | (CKDWORD)p[1]; }
+
+static void WriteLE16(CKBYTE *p, CKDWORD v)
+{
+    p[0] = (CKBYTE)v;
+    p[1] = (CKBYTE)(v >> 8);
+}
+
+static const CKBYTE PngSignature[PNG_SIGNATURE_SIZE] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+static CKDWORD ChannelCount(CKDWORD colorType)
+{
+    switch (colorType)
+    {
+    case PNG_COLOR_RGB:
+        return 3;
+    case PNG_COLOR_GRAY_ALPHA:
+        return 2;
+    case PNG_COLOR_RGBA:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+//=============================================================================
+// Chunks and Header
+//=============================================================================
+CKBOOL PNG_NextChunk(const CKBYTE *data, CKDWORD size, CKDWORD &offset, PngChunk &chunk)
+{
+    if (offset > size || size - offset < PNG_CHUNK_OVERHEAD)
+        return FALSE;
+    CKDWORD length = ReadBE32(data + offset);
+    if (length > 0x7FFFFFFF || length > size - offset - PNG_CHUNK_OVERHEAD)
+        return FALSE;
+    chunk.length = length;
+    chunk.type = ReadBE32(data + offset + 4);
+    chunk.data = data + offset + 8;
+    offset += PNG_CHUNK_OVERHEAD + length;
+    return TRUE;
+}
+
+static CKBOOL IsValidDepth(CKDWORD colorType, CKDWORD bitDepth)
+{
+    switch (colorType)
+    {
+    case PNG_COLOR_GRAY:
+        return bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8 || bitDepth == 16;
+    case PNG_COLOR_PALETTE:
+        return bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8;
+    case PNG_COLOR_RGB:
+    case PNG_COLOR_GRAY_ALPHA:
+    case PNG_COLOR_RGBA:
+        return bitDepth == 8 || bitDepth == 16;
+    default:
+        return FALSE;
+    }
+}
+
+int PNG_ReadInfo(const CKBYTE *data, CKDWORD size, PngImageInfo &info)
+{
+    memset(&info, 0, sizeof(info));
+    if (!data || size < PNG_SIGNATURE_SIZE)
+        return CKBITMAPERROR_READERROR;
+    if (memcmp(data, PngSignature, PNG_SIGNATURE_SIZE) != 0)
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+
+    CKDWORD offset = PNG_SIGNATURE_SIZE;
+    PngChunk chunk;
+    if (!PNG_NextChunk(data, size, offset, chunk))
+        return CKBITMAPERROR_READERROR;
+    if (chunk.type != PNG_CHUNK_IHDR || chunk.length != 13)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    info.width = ReadBE32(chunk.data);
+    info.height = ReadBE32(chunk.data + 4);
+    info.bitDepth = chunk.data[8];
+    info.colorType = chunk.data[9];
+    info.interlace = chunk.data[12];
+    if (info.width == 0 || info.height == 0 || info.width > 0x7FFFFFFF || info.height > 0x7FFFFFFF)
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (!ImageWithinDecodeLimits(info.width, info.height, 0))
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (!IsValidDepth(info.colorType, info.bitDepth))
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (chunk.data[10] != 0 || chunk.data[11] != 0 || info.interlace > 1)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // Out-of-range palette indices decode as opaque black
+    for (CKDWORD i = 0; i < 256; i++)
+        info.palette[i] = 0xFF000000;
+
+    // PLTE and tRNS precede the image data
+    while (PNG_NextChunk(data, size, offset, chunk))
+    {
+        if (chunk.type == PNG_CHUNK_IDAT || chunk.type == PNG_CHUNK_IEND)
+            break;
+
+        if (chunk.type == PNG_CHUNK_PLTE)
+        {
+            CKDWORD count = chunk.length / 3;
+            if (chunk.length % 3 != 0 || count == 0 || count > 256)
+                return CKBITMAPERROR_FILECORRUPTED;
+            // A palette is only a suggestion for RGB images; it is ignored there
+            if (info.colorType != PNG_COLOR_PALETTE)
+                continue;
+            if (count > (1u << info.bitDepth))
+                count = 1u << info.bitDepth;
+            for (CKDWORD i = 0; i < count; i++)
+            {
+                const CKBYTE *rgb = chunk.data + i * 3;
+                info.palette[i] = 0xFF000000 | ((CKDWORD)rgb[0] << 16) | ((CKDWORD)rgb[1] << 8) | rgb[2];
+            }
+            info.paletteCount = count;
+        }
+        else if (chunk.type == PNG_CHUNK_TRNS)
+        {
+            if (info.colorType == PNG_COLOR_PALETTE)
+            {
+                CKDWORD count = (chunk.length < 256) ? chunk.length : 256;
+                for (CKDWORD i = 0; i < count; i++)
+                    info.palette[i] = (info.palette[i] & 0x00FFFFFF) | ((CKDWORD)chunk.data[i] << 24);
+            }
+            else if (info.colorType == PNG_COLOR_GRAY && chunk.length >= 2)
+            {
+                info.colorKey[0] = (CKWORD)ReadBE16(chunk.data);
+                info.hasColorKey = TRUE;
+            }
+            else if (info.colorType == PNG_COLOR_RGB && chunk.length >= 6)
+            {
+                for (int c = 0; c < 3; c++)
+                    info.colorKey[c] = (CKWORD)ReadBE16(chunk.data + c * 2);
+                info.hasColorKey = TRUE;
+            }
+        }
+    }
+
+    if (info.colorType == PNG_COLOR_PALETTE && info.paletteCount == 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+    return 0;
+}
+
+PngOutput PNG_OutputFor(const PngImageInfo &info, CKDWORD readFlags)
+{
+    if ((readFlags & IMAGE_READ_KEEP_INDICES) && info.colorType == PNG_COLOR_PALETTE)
+        return PNG_OUTPUT_INDEX8;
+    if ((readFlags & IMAGE_READ_KEEP_16BIT) && info.bitDepth == 16)
+        return PNG_OUTPUT_BGRA64;
+    return PNG_OUTPUT_BGRA32;
+}
+
+//=============================================================================
+// Unfiltering
+//
+// Rows are unfiltered in place; prev is the previous unfiltered row of the
+// same pass (all zero for the first row). bpp is the filter distance: bytes
+// per complete pixel, at least 1.
+//=============================================================================
+typedef void (*PngUnfilterFn)(CKBYTE *row, const CKBYTE *prev, CKDWORD length, CKDWORD bpp);
+
+struct PngUnfilters
+{
+    PngUnfilterFn sub;
+    PngUnfilterFn up;
+    PngUnfilterFn avg;
+    PngUnfilterFn paeth;
+};
+
+static CKBYTE PaethPredictor(int a, int b, int c)
+{
+    int pa = abs(b - c);
+    int pb = abs(a - c);
+    int pc = abs(a + b - 2 * c);
+    if (pa <= pb && pa <= pc)
+        return (CKBYTE)a;
+    return (CKBYTE)((pb <= pc) ? b : c);
+}
+
+static void UnfilterSubScalar(CKBYTE *row, const CKBYTE *, CKDWORD length, CKDWORD bpp)
+{
+    for (CKDWORD i = bpp; i < length; i++)
+        row[i] = (CKBYTE)(row[i] + row[i - bpp]);
+}
+
+static void UnfilterUpScalar(CKBYTE *row, const CKBYTE *prev, CKDWORD length, CKDWORD)
+{
+    for (CKDWORD i = 0; i < length; i++)
+        row[i] = (CKBYTE)(row[i] + prev[i]);
+}
+
+static void UnfilterAvgScalar(CKBYTE *row, const CKBYTE *prev, CKDWORD length, CKDWORD bpp)
+{
+    CKDWORD i = 0;
+    for (; i < bpp && i < length; i++)
+        row[i] = (CKBYTE)(row[i] + (prev[i] >> 1));
+    for (; i < length; i++)
+        row[i] = (CKBYTE)(row[i] + ((row[i - bpp] + prev[i]) >> 1));
+}
+
+static void UnfilterPaethScalar(CKBYTE *row, const CKBYTE *prev, CKDWORD length, CKDWORD bpp)
+{
+    CKDWORD i = 0;
+    for (; i < bpp && i < length; i++)
+        row[i] = (CKBYTE)(row[i] + prev[i]);
+    for (; i < length; i++)
+        row[i] = (CKBYTE)(row[i] + PaethPredictor(row[i - bpp], prev[i], prev[i - bpp]));
+}
+
+// Pixel loads and stores for the 3 and 4 byte SIMD paths (no bytes outside the pixel are touched)
+static __m128i LoadPixel(const CKBYTE *p, CKDWORD bpp)
+{
+    int v = 0;
+    memcpy(&v, p, bpp);
+    return _mm_cvtsi32_si128(v);
+}
+
+static void StorePixel(CKBYTE *p, __m128i v, CKDWORD bpp)
+{
+    int bits = _mm_cvtsi128_si32(v);
+    memcpy(p, &bits, bpp);
+}
+
+static void UnfilterSubSSE2(CKBYTE *row, const CKBYTE *prev, CKDWORD length, CKDWORD bpp)
+{
+    if (bpp == 4)
+    {
+        // Prefix sum over four pixels at a time, carrying the last pixel over
+        __m128i last = _mm_setzero_si128();
+        CKDWORD i = 0;
+        for (; i + 16 <= length; i += 16)
+        {
+            __m128i x = _mm_loadu_si128((const __m128i *)(row + i));
+            x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+            x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+            x = _mm_add_epi8(x, last);
+            _mm_storeu_si128((__m128i *)(row + i), x);
+            last = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+        }
+        for (; i < length; i += 4)
+        {
+            last = _mm_add_epi8(LoadPixel(row + i, 4), last);
+            StorePixel(row + i, last, 4);
+        }
+        return;
+    }
+    if (bpp == 3)
+    {
+        __m128i last = _mm_setzero_si128();
+        for (CKDWORD i = 0; i < length; i += 3)
+        {
+            last = _mm_add_epi8(LoadPixel(row + i, 3), last);
+            StorePixel(row + i, last, 3);
+        }
+        return;
+    }
+    UnfilterSubScalar(row, prev, length, bpp);
+}
+
+static void UnfilterUpSSE2(CKBYTE *row, const CKBYTE *prev, CKDWORD length, CKDWORD bpp)
+{
+    CKDWORD i = 0;
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(row + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(prev + i));
+        _mm_storeu_si128((__m128i *)(row + i), _mm_add_epi8(x, b));
+    }
+    UnfilterUpScalar(row + i, prev + i, length - i, bpp);
+}
+
+static void UnfilterAvgSSE2(CKBYTE *row, const CKBYTE *prev, CKDWORD length, CKDWORD bpp)
+{
+    if (bpp != 3 && bpp != 4)
+    {
+        UnfilterAvgScalar(row, prev, length, bpp);
+        return;
+    }
+
+    // avg_epu8 rounds up; subtracting the low bit of a ^ b turns it into floor((a + b) / 2)
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i a = _mm_setzero_si128();
+    for (CKDWORD i = 0; i < length; i += bpp)
+    {
+        __m128i b = LoadPixel(prev + i, bpp);
+        __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+        a = _mm_add_epi8(LoadPixel(row + i, bpp), avg);
+        StorePixel(row + i, a, bpp);
+    }
+}
+
+// Picks a, b or c per 16-bit lane from the distances, preferring a, then b
+static __m128i PaethSelect(__m128i a, __m128i b, __m128i c, __m128i pa, __m128i pb, __m128i pc)
+{
+    __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+    __m128i useA = _mm_cmpeq_epi16(smallest, pa);
+    __m128i useB = _mm_cmpeq_epi16(smallest, pb);
+    __m128i bc = _mm_or_si128(_mm_and_si128(useB, b), _mm_andnot_si128(useB, c));
+    return _mm_or_si128(_mm_and_si128(useA, a), _mm_andnot_si128(useA, bc));
+}
+
+static void UnfilterPaethSSE2(CKBYTE *row, const CKBYTE *prev, CKDWORD length, CKDWORD bpp)
+{
+    if (bpp != 3 && bpp != 4)
+    {
+        UnfilterPaethScalar(row, prev, length, bpp);
+        return;
+    }
+
+    // Predictor arithmetic in 16-bit lanes; SSE2 has no abs, so use max(x, -x)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a = zero;
+    __m128i c = zero;
+    for (CKDWORD i = 0; i < length; i += bpp)
+    {
+        __m128i b = _mm_unpacklo_epi8(LoadPixel(prev + i, bpp), zero);
+        __m128i pa = _mm_sub_epi16(b, c);
+        __m128i pb = _mm_sub_epi16(a, c);
+        __m128i pc = _mm_add_epi16(pa, pb);
+        pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+        pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+        pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+
+        __m128i pred = PaethSelect(a, b, c, pa, pb, pc);
+        __m128i x = _mm_add_epi8(LoadPixel(row + i, bpp), _mm_packus_epi16(pred, pred));
+        StorePixel(row + i, x, bpp);
+        a = _mm_unpacklo_epi8(x, zero);
+        c = b;
+    }
+}
+
+IMAGE_TARGET_SSSE3 static void UnfilterPaethSSSE3(CKBYTE *row, const CKBYTE *prev, CKDWORD length, CKDWORD bpp)
+{
+    if (bpp != 3 && bpp != 4)
+    {
+        UnfilterPaethScalar(row, prev, length, bpp);
+        return;
+    }
+
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a = zero;
+    __m128i c = zero;
+    for (CKDWORD i = 0; i < length; i += bpp)
+    {
+        __m128i b = _mm_unpacklo_epi8(LoadPixel(prev + i, bpp), zero);
+        __m128i pa = _mm_sub_epi16(b, c);
+        __m128i pb = _mm_sub_epi16(a, c);
+        __m128i pc = _mm_add_epi16(pa, pb);
+
+        __m128i pred = PaethSelect(a, b, c, _mm_abs_epi16(pa), _mm_abs_epi16(pb), _mm_abs_epi16(pc));
+        __m128i x = _mm_add_epi8(LoadPixel(row + i, bpp), _mm_packus_epi16(pred, pred));
+        StorePixel(row + i, x, bpp);
+        a = _mm_unpacklo_epi8(x, zero);
+        c = b;
+    }
+}
+
+static PngUnfilters SelectUnfilters()
+{
+    PngUnfilters f;
+    f.sub = UnfilterSubScalar;
+    f.up = UnfilterUpScalar;
+    f.avg = UnfilterAvgScalar;
+    f.paeth = UnfilterPaethScalar;
+    if (ImageCpuHas(IMAGE_CPU_SSE2))
+    {
+        f.sub = UnfilterSubSSE2;
+        f.up = UnfilterUpSSE2;
+        f.avg = UnfilterAvgSSE2;
+        f.paeth = UnfilterPaethSSE2;
+    }
+    if (ImageCpuHas(IMAGE_CPU_SSE2 | IMAGE_CPU_SSSE3))
+        f.paeth = UnfilterPaethSSSE3;
+    return f;
+}
+
+//=============================================================================
+// Row Conversion
+//=============================================================================
+struct PngConverter
+{
+    const PngImageInfo *info;
+    PngOutput output;
+    CKDWORD lut[256]; // BGRA32 per sample value of palette and <= 8-bit gray images
+};
+
+static void InitConverter(PngConverter &cv, const PngImageInfo &info, PngOutput output)
+{
+    cv.info = &info;
+    cv.output = output;
+    if (info.colorType == PNG_COLOR_PALETTE)
+    {
+        memcpy(cv.lut, info.palette, sizeof(cv.lut));
+    }
+    else if (info.colorType == PNG_COLOR_GRAY && info.bitDepth <= 8)
+    {
+        CKDWORD maxValue = (1u << info.bitDepth) - 1;
+        for (CKDWORD v = 0; v < 256; v++)
+        {
+            CKDWORD gray = ((v & maxValue) * 255 / maxValue) * 0x010101;
+            CKBOOL keyed = info.hasColorKey && v == info.colorKey[0];
+            cv.lut[v] = gray | (keyed ? 0 : 0xFF000000);
+        }
+    }
+}
+
+// 16-bit samples: big-endian in the file, little-endian in BGRA64
+static void Store16(CKBYTE *dst, const CKBYTE *sample) { WriteLE16(dst, ReadBE16(sample)); }
+
+static void ConvertRow(const PngConverter &cv, const CKBYTE *src, CKDWORD count, CKBYTE *dst)
+{
+    const PngImageInfo &info = *cv.info;
+    CKDWORD *dst32 = (CKDWORD *)dst;
+    CKBOOL wide = (cv.output == PNG_OUTPUT_BGRA64);
+
+    switch (info.colorType)
+    {
+    case PNG_COLOR_GRAY:
+    case PNG_COLOR_PALETTE:
+        if (info.bitDepth < 8)
+        {
+            CKDWORD depth = info.bitDepth;
+            CKDWORD mask = (1u << depth) - 1;
+            CKDWORD perByte = 8 / depth;
+            for (CKDWORD x = 0; x < count; x += perByte)
+            {
+                CKDWORD bits = src[x / perByte];
+                CKDWORD n = (count - x < perByte) ? count - x : perByte;
+                for (CKDWORD k = 0; k < n; k++)
+                {
+                    CKDWORD v = (bits >> (8 - depth * (k + 1))) & mask;
+                    if (cv.output == PNG_OUTPUT_INDEX8)
+                        dst[x + k] = (CKBYTE)v;
+                    else
+                        dst32[x + k] = cv.lut[v];
+                }
+            }
+        }
+        else if (info.bitDepth == 8)
+        {
+            if (cv.output == PNG_OUTPUT_INDEX8)
+                memcpy(dst, src, count);
+            else
+                for (CKDWORD x = 0; x < count; x++)
+                    dst32[x] = cv.lut[src[x]];
+        }
+        else
+        {
+            for (CKDWORD x = 0; x < count; x++)
+            {
+                const CKBYTE *s = src + x * 2;
+                CKBOOL keyed = info.hasColorKey && ReadBE16(s) == info.colorKey[0];
+                if (wide)
+                {
+                    Store16(dst + x * 8, s);
+                    Store16(dst + x * 8 + 2, s);
+                    Store16(dst + x * 8 + 4, s);
+                    WriteLE16(dst + x * 8 + 6, keyed ? 0 : 0xFFFF);
+                }
+                else
+                {
+                    dst32[x] = ((CKDWORD)s[0] * 0x010101) | (keyed ? 0 : 0xFF000000);
+                }
+            }
+        }
+        break;
+
+    case PNG_COLOR_GRAY_ALPHA:
+        if (info.bitDepth == 8)
+        {
+            for (CKDWORD x = 0; x < count; x++)
+                dst32[x] = ((CKDWORD)src[x * 2] * 0x010101) | ((CKDWORD)src[x * 2 + 1] << 24);
+        }
+        else
+        {
+            for (CKDWORD x = 0; x < count; x++)
+            {
+                const CKBYTE *s = src + x * 4;
+                if (wide)
+                {
+                    Store16(dst + x * 8, s);
+                    Store16(dst + x * 8 + 2, s);
+                    Store16(dst + x * 8 + 4, s);
+                    Store16(dst + x * 8 + 6, s + 2);
+                }
+                else
+                {
+                    dst32[x] = ((CKDWORD)s[0] * 0x010101) | ((CKDWORD)s[2] << 24);
+                }
+            }
+        }
+        break;
+
+    case PNG_COLOR_RGB:
+        if (info.bitDepth == 8 && !info.hasColorKey)
+        {
+            ImageRGBToBGRA32(src, dst, (int)count);
+        }
+        else if (info.bitDepth == 8)
+        {
+            CKDWORD key = ((CKDWORD)info.colorKey[0] << 16) | ((CKDWORD)info.colorKey[1] << 8) | info.colorKey[2];
+            for (CKDWORD x = 0; x < count; x++)
+            {
+                const CKBYTE *s = src + x * 3;
+                CKDWORD rgb = ((CKDWORD)s[0] << 16) | ((CKDWORD)s[1] << 8) | s[2];
+                dst32[x] = rgb | ((rgb == key) ? 0 : 0xFF000000);
+            }
+        }
+        else
+        {
+            for (CKDWORD x = 0; x < count; x++)
+            {
+                const CKBYTE *s = src + x * 6;
+                CKBOOL keyed = info.hasColorKey && ReadBE16(s) == info.colorKey[0] &&
+                               ReadBE16(s + 2) == info.colorKey[1] && ReadBE16(s + 4) == info.colorKey[2];
+                if (wide)
+                {
+                    Store16(dst + x * 8, s + 4);
+                    Store16(dst + x * 8 + 2, s + 2);
+                    Store16(dst + x * 8 + 4, s);
+                    WriteLE16(dst + x * 8 + 6, keyed ? 0 : 0xFFFF);
+                }
+                else
+                {
+                    dst32[x] = ((CKDWORD)s[0] << 16) | ((CKDWORD)s[2] << 8) | s[4] | (keyed ? 0 : 0xFF000000);
+                }
+            }
+        }
+        break;
+
+    case PNG_COLOR_RGBA:
+        if (info.bitDepth == 8)
+        {
+            ImageRGBAToBGRA32(src, dst, (int)count);
+        }
+        else
+        {
+            for (CKDWORD x = 0; x < count; x++)
+            {
+                const CKBYTE *s = src + x * 8;
+                if (wide)
+                {
+                    Store16(dst + x * 8, s + 4);
+                    Store16(dst + x * 8 + 2, s + 2);
+                    Store16(dst + x * 8 + 4, s);
+                    Store16(dst + x * 8 + 6, s + 6);
+                }
+                else
+                {
+                    dst32[x] = ((CKDWORD)s[6] << 24) | ((CKDWORD)s[0] << 16) | ((CKDWORD)s[2] << 8) | s[4];
+                }
+            }
+        }
+        break;
+    }
+}
+
+//=============================================================================
+// Image Decoding
+//=============================================================================
+struct PngPass
+{
+    CKDWORD x0, y0, dx, dy;
+};
+
+static const PngPass Adam7Passes[7] = {
+    {0, 0, 8, 8}, {4, 0, 8, 8}, {0, 4, 4, 8}, {2, 0, 4, 4}, {0, 2, 2, 4}, {1, 0, 2, 2}, {0, 1, 1, 2},
+};
+static const PngPass SinglePass = {0, 0, 1, 1};
+
+static CKDWORD PassExtent(CKDWORD size, CKDWORD start, CKDWORD step)
+{
+    return (size > start) ? (size - start + step - 1) / step : 0;
+}
+
+int PNG_DecodeImage(const PngImageInfo &info, CKDWORD width, CKDWORD height, const CKBYTE *zdata, CKDWORD zsize,
+                    PngOutput output, CKBYTE *dst, int dstStride)
+{
+    if (!zdata || !dst || width == 0 || height == 0)
+        return CKBITMAPERROR_GENERIC;
+
+    CKDWORD bitsPerPixel = ChannelCount(info.colorType) * info.bitDepth;
+    CKDWORD bpp = (bitsPerPixel >= 8) ? bitsPerPixel / 8 : 1;
+    CKDWORD outPixelSize = (output == PNG_OUTPUT_BGRA64) ? 8 : (output == PNG_OUTPUT_INDEX8) ? 1 : 4;
+
+    const PngPass *passes = info.interlace ? Adam7Passes : &SinglePass;
+    CKDWORD passCount = info.interlace ? 7 : 1;
+
+    // Filtered data of all passes: a filter byte plus the packed samples per row
+    uint64_t rawSize = 0;
+    for (CKDWORD p = 0; p < passCount; p++)
+    {
+        uint64_t passWidth = PassExtent(width, passes[p].x0, passes[p].dx);
+        uint64_t passHeight = PassExtent(height, passes[p].y0, passes[p].dy);
+        if (passWidth && passHeight)
+            rawSize += passHeight * (1 + (passWidth * bitsPerPixel + 7) / 8);
+    }
+    if (rawSize > 0x7FFFFFFFULL)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // Decoding stops once every row is there; trailing data in the stream is ignored
+    CKBYTE *raw = new CKBYTE[(CKDWORD)rawSize];
+    CKDWORD written = 0;
+    ImageZlibInflate(zdata, zsize, raw, (CKDWORD)rawSize, &written);
+    if (written != (CKDWORD)rawSize)
+    {
+        delete[] raw;
+        return CKBITMAPERROR_FILECORRUPTED;
+    }
+
+    CKDWORD maxRowBytes = (CKDWORD)(((uint64_t)width * bitsPerPixel + 7) / 8);
+    CKBYTE *zeroRow = new CKBYTE[maxRowBytes];
+    memset(zeroRow, 0, maxRowBytes);
+    CKBYTE *passRow = info.interlace ? new CKBYTE[(size_t)width * outPixelSize] : NULL;
+
+    PngUnfilters unfilters = SelectUnfilters();
+    PngConverter converter;
+    InitConverter(converter, info, output);
+
+    int result = 0;
+    CKBYTE *row = raw;
+    for (CKDWORD p = 0; p < passCount && result == 0; p++)
+    {
+        const PngPass &pass = passes[p];
+        CKDWORD passWidth = PassExtent(width, pass.x0, pass.dx);
+        CKDWORD passHeight = PassExtent(height, pass.y0, pass.dy);
+        if (passWidth == 0 || passHeight == 0)
+            continue;
+
+        CKDWORD rowBytes = (CKDWORD)(((uint64_t)passWidth * bitsPerPixel + 7) / 8);
+        const CKBYTE *prev = zeroRow;
+        for (CKDWORD y = 0; y < passHeight; y++, row += rowBytes + 1)
+        {
+            CKBYTE *samples = row + 1;
+            switch (row[0])
+            {
+            case 0:
+                break;
+            case 1:
+                unfilters.sub(samples, prev, rowBytes, bpp);
+                break;
+            case 2:
+                unfilters.up(samples, prev, rowBytes, bpp);
+                break;
+            case 3:
+                unfilters.avg(samples, prev, rowBytes, bpp);
+                break;
+            case 4:
+                unfilters.paeth(samples, prev, rowBytes, bpp);
+                break;
+            default:
+                result = CKBITMAPERROR_FILECORRUPTED;
+                break;
+            }
+            if (result != 0)
+                break;
+            prev = samples;
+
+            CKBYTE *dstRow = dst + (size_t)(pass.y0 + y * pass.dy) * dstStride;
+            if (pass.dx == 1)
+            {
+                ConvertRow(converter, samples, passWidth, dstRow);
+                continue;
+            }
+
+            // Interlaced passes convert once, then scatter pixels to every dx-th column
+            ConvertRow(converter, samples, passWidth, passRow);
+            CKBYTE *to = dstRow + (size_t)pass.x0 * outPixelSize;
+            CKDWORD step = pass.dx * outPixelSize;
+            for (CKDWORD x = 0; x < passWidth; x++, to += step)
+                memcpy(to, passRow + x * outPixelSize, outPixelSize);
+        }
+    }
+
+    delete[] passRow;
+    delete[] zeroRow;
+    delete[] raw;
+    return result;
+}
+
+//=============================================================================
+// PngReader Class Implementation
+//=============================================================================
+PngReader::PngReader() : ImageReader(), m_ReadFlags(0)
+{
+    m_Properties.Init(PNGREADER_GUID, "png");
+}
+
+PngReader::~PngReader()
+{
+    FreeBitmapData(&m_Properties);
+}
+
+CKPluginInfo *PngReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_PNG];
+}
+
+void PngReader::SetReadFlags(CKDWORD flags) { m_ReadFlags = flags; }
+
+CKDWORD PngReader::GetReadFlags() { return m_ReadFlags; }
+
+int PngReader::GetOptionsCount() { return 0; }
+
+CKSTRING PngReader::GetOptionDescription(int i) { return ""; }
+
+int PngReader::ReadFile(CKSTRING filename, CKBitmapProperties **bp)
+{
+    if (!filename || !bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_PNG, (void *)filename, 0, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int PngReader::ReadMemory(void *memory, int size, CKBitmapProperties **bp)
+{
+    if (!bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_PNG, memory, size, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int PngReader::ReadOwnFormat(void *data, int size, CKBitmapProperties *props)
+{
+    return PNG_Read(data, size, props, m_ReadFlags);
+}
+
+//=============================================================================
+// PNG_Read - Core Reading Function
+//=============================================================================
+int PNG_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags)
+{
+    if (!data || !props)
+        return CKBITMAPERROR_GENERIC;
+    if (size < 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    ImageFileMap fileMap;
+    if (size == 0)
+    {
+        if (!fileMap.Open((const char *)data))
+            return CKBITMAPERROR_READERROR;
+        data = (void *)fileMap.Data();
+        size = (int)fileMap.Size();
+    }
+
+    const CKBYTE *bytes = (const CKBYTE *)data;
+    CKDWORD fileSize = (CKDWORD)size;
+    PngImageInfo info;
+    int result = PNG_ReadInfo(bytes, fileSize, info);
+    if (result != 0)
+        return result;
+
+    // The zlib stream may be split over several IDAT chunks; a single chunk is
+    // decoded in place, several are joined first
+    CKDWORD idatCount = 0;
+    CKDWORD idatSize = 0;
+    const CKBYTE *firstIdat = NULL;
+    CKDWORD offset = PNG_SIGNATURE_SIZE;
+    PngChunk chunk;
+    while (PNG_NextChunk(bytes, fileSize, offset, chunk) && chunk.type != PNG_CHUNK_IEND)
+    {
+        if (chunk.type != PNG_CHUNK_IDAT || chunk.length == 0)
+            continue;
+        if (chunk.length > 0x7FFFFFFF - idatSize)
+            return CKBITMAPERROR_FILECORRUPTED;
+        if (idatCount++ == 0)
+            firstIdat = chunk.data;
+        idatSize += chunk.length;
+    }
+    if (idatSize == 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    CKBYTE *joined = NULL;
+    const CKBYTE *zdata = firstIdat;
+    if (idatCount > 1)
+    {
+        joined = new CKBYTE[idatSize];
+        CKDWORD pos = 0;
+        offset = PNG_SIGNATURE_SIZE;
+        while (PNG_NextChunk(bytes, fileSize, offset, chunk) && chunk.type != PNG_CHUNK_IEND)
+        {
+            if (chunk.type != PNG_CHUNK_IDAT)
+                continue;
+            memcpy(joined + pos, chunk.data, chunk.length);
+            pos += chunk.length;
+        }
+        zdata = joined;
+    }
+
+    // Allocate destination. Index images carry their palette at the start of the block.
+    PngOutput output = PNG_OutputFor(info, readFlags);
+    CKDWORD paletteSize = (output == PNG_OUTPUT_INDEX8) ? 256 * 4 : 0;
+    uint64_t dstStride64 = (output == PNG_OUTPUT_INDEX8) ? (uint64_t)ImageReader::Indexed8Stride((int)info.width)
+                                                         : (uint64_t)info.width * ((output == PNG_OUTPUT_BGRA64) ? 8 : 4);
+    uint64_t dstSize64 = dstStride64 * info.height;
+    if (!ImageWithinDecodeLimits(info.width, info.height, dstSize64 + paletteSize))
+    {
+        delete[] joined;
+        return CKBITMAPERROR_FILECORRUPTED;
+    }
+
+    CKBYTE *dstBlock = new CKBYTE[(CKDWORD)dstSize64 + paletteSize];
+    CKBYTE *dstPixels = dstBlock + paletteSize;
+    int dstStride = (int)dstStride64;
+    result = PNG_DecodeImage(info, info.width, info.height, zdata, idatSize, output, dstPixels, dstStride);
+    delete[] joined;
+    if (result != 0)
+    {
+        delete[] dstBlock;
+        return result;
+    }
+
+    // Fill properties
+    if (output == PNG_OUTPUT_INDEX8)
+    {
+        // Palette entries are BGRA in memory order
+        memcpy(dstBlock, info.palette, paletteSize);
+        ImageReader::FillFormatIndexed8(props->m_Format, (int)info.width, (int)info.height, dstStride, dstPixels,
+                                        dstBlock, (int)info.paletteCount);
+    }
+    else if (output == PNG_OUTPUT_BGRA64)
+    {
+        ImageReader::FillFormatBGRA64(props->m_Format, (int)info.width, (int)info.height, dstStride, dstPixels);
+    }
+    else
+    {
+        ImageReader::FillFormatBGRA32(props->m_Format, (int)info.width, (int)info.height, dstStride, dstPixels);
+    }
+    props->m_Data = dstBlock;
+
+    if (props->m_Size == sizeof(PngBitmapProperties))
+    {
+        ((PngBitmapProperties *)props)->m_BitDepth = info.bitDepth;
+        ((PngBitmapProperties *)props)->m_ColorType = info.colorType;
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+#ifndef PNGREADER_H
+#define PNGREADER_H
+
+#include "ImageReader.h"
+
+// PNG Reader GUID
+#define PNGREADER_GUID CKGUID(0x3C5A9E17, 0x4B2D8F61)
+
+/**
+ * PngReader - Portable Network Graphics reader
+ *
+ *   - All color types and bit depths, Adam7 interlacing, PLTE/tRNS transparency
+ *   - Decoded straight to BGRA32; with IMAGE_READ_KEEP_16BIT, 16-bit images are
+ *     returned as BGRA64 and with IMAGE_READ_KEEP_INDICES, palette images as
+ *     8-bit indices plus palette
+ *   - Table-driven inflate (ImageInflate) and SSE2/SSSE3 row unfiltering
+ *   - Chunk CRCs and the zlib checksum are not verified; gamma and color
+ *     profiles are ignored
+ *   - Read-only: SaveFile and SaveMemory return 0
+ */
+class PngReader : public ImageReader
+{
+public:
+    PngReader();
+    virtual ~PngReader();
+
+    virtual CKPluginInfo *GetReaderInfo();
+    virtual int GetOptionsCount();
+    virtual CKSTRING GetOptionDescription(int i);
+
+    virtual int ReadFile(CKSTRING filename, CKBitmapProperties **bp);
+    virtual int ReadMemory(void *memory, int size, CKBitmapProperties **bp);
+
+    // IMAGE_READ_* flags applied by ReadFile/ReadMemory (default 0)
+    void SetReadFlags(CKDWORD flags);
+    CKDWORD GetReadFlags();
+
+protected:
+    virtual int ReadOwnFormat(void *data, int size, CKBitmapProperties *props);
+
+private:
+    PngBitmapProperties m_Properties;
+    CKDWORD m_ReadFlags;
+};
+
+//=============================================================================
+// PNG file format
+//=============================================================================
+#define PNG_SIGNATURE_SIZE 8
+#define PNG_CHUNK_OVERHEAD 12 // length, type and CRC
+
+#define PNG_CHUNK_TYPE(a, b, c, d) (((CKDWORD)(a) << 24) | ((CKDWORD)(b) << 16) | ((CKDWORD)(c) << 8) | (CKDWORD)(d))
+#define PNG_CHUNK_IHDR PNG_CHUNK_TYPE('I', 'H', 'D', 'R')
+#define PNG_CHUNK_PLTE PNG_CHUNK_TYPE('P', 'L', 'T', 'E')
+#define PNG_CHUNK_TRNS PNG_CHUNK_TYPE('t', 'R', 'N', 'S')
+#define PNG_CHUNK_IDAT PNG_CHUNK_TYPE('I', 'D', 'A', 'T')
+#define PNG_CHUNK_IEND PNG_CHUNK_TYPE('I', 'E', 'N', 'D')
+
+// Color types
+#define PNG_COLOR_GRAY 0
+#define PNG_COLOR_RGB 2
+#define PNG_COLOR_PALETTE 3
+#define PNG_COLOR_GRAY_ALPHA 4
+#define PNG_COLOR_RGBA 6
+
+struct PngChunk
+{
+    CKDWORD type;
+    CKDWORD length;
+    const CKBYTE *data;
+};
+
+// Image header plus the transparency information that applies to every frame.
+// palette holds BGRA entries (alpha from tRNS); colorKey holds the tRNS gray
+// or R, G, B sample values of gray and RGB images.
+struct PngImageInfo
+{
+    CKDWORD width;
+    CKDWORD height;
+    CKDWORD bitDepth;
+    CKDWORD colorType;
+    CKDWORD interlace;
+    CKDWORD paletteCount;
+    CKDWORD palette[256];
+    CKBOOL hasColorKey;
+    CKWORD colorKey[3];
+};
+
+// Pixel layouts produced by PNG_DecodeImage
+enum PngOutput
+{
+    PNG_OUTPUT_BGRA32, // 4 bytes per pixel
+    PNG_OUTPUT_BGRA64, // 8 bytes per pixel, 16-bit images only
+    PNG_OUTPUT_INDEX8  // 1 byte per pixel, palette images only
+};
+
+//=============================================================================
+// Internal helper functions
+//=============================================================================
+
+// Steps through the chunks that follow the signature; offset starts at
+// PNG_SIGNATURE_SIZE. Returns FALSE at the end of the data or on a chunk that
+// runs past it.
+CKBOOL PNG_NextChunk(const CKBYTE *data, CKDWORD size, CKDWORD &offset, PngChunk &chunk);
+
+// Validates the signature and reads IHDR, PLTE and tRNS
+int PNG_ReadInfo(const CKBYTE *data, CKDWORD size, PngImageInfo &info);
+
+// Output layout for an image and a set of IMAGE_READ_* flags
+PngOutput PNG_OutputFor(const PngImageInfo &info, CKDWORD readFlags);
+
+// Decodes a width x height image from its zlib stream (the concatenated IDAT
+// data) into dst. The sample format and interlacing are taken from info, so
+// the same function decodes APNG frames of any size.
+int PNG_DecodeImage(const PngImageInfo &info, CKDWORD width, CKDWORD height, const CKBYTE *zdata, CKDWORD zsize,
+                    PngOutput output, CKBYTE *dst, int dstStride);
+
+// Core PNG read function (size == 0 means data is a filename)
+int PNG_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags = 0);
+
+#endif // PNGREADER_H
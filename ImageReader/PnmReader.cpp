@@ -0,0 +1,690 @@
+#include "PnmReader.h"
+#include "ImageSimd.h"
+#include "ImageThreadPool.h"
+#include "ImageFileMap.h"
+
+#include <emmintrin.h>
+
+//=============================================================================
+// Header
+//=============================================================================
+static CKBOOL IsSpace(CKBYTE c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f'; }
+
+static CKBOOL IsDigit(CKBYTE c) { return (CKBYTE)(c - '0') < 10; }
+
+// Reads a decimal number, skipping whitespace and comments before it.
+// Values saturate at 0x7FFFFFFF.
+static int ReadHeaderNumber(const CKBYTE *data, CKDWORD size, CKDWORD &pos, CKDWORD &value)
+{
+    for (;;)
+    {
+        if (pos >= size)
+            return CKBITMAPERROR_READERROR;
+        if (IsSpace(data[pos]))
+        {
+            pos++;
+        }
+        else if (data[pos] == '#')
+        {
+            while (pos < size && data[pos] != '\n' && data[pos] != '\r')
+                pos++;
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (!IsDigit(data[pos]))
+        return CKBITMAPERROR_FILECORRUPTED;
+    value = 0;
+    while (pos < size && IsDigit(data[pos]))
+    {
+        value = (value < 100000000) ? value * 10 + (data[pos] - '0') : 0x7FFFFFFF;
+        pos++;
+    }
+    return 0;
+}
+
+// PAM header: "KEYWORD value" lines up to ENDHDR
+static int ReadPamHeader(const CKBYTE *data, CKDWORD size, CKDWORD pos, PnmImageInfo &info)
+{
+    CKBOOL hasWidth = FALSE, hasHeight = FALSE, hasDepth = FALSE, hasMaxValue = FALSE;
+    for (;;)
+    {
+        const CKBYTE *eol = (const CKBYTE *)memchr(data + pos, '\n', size - pos);
+        if (!eol)
+            return CKBITMAPERROR_READERROR;
+        CKDWORD end = (CKDWORD)(eol - data);
+        while (pos < end && IsSpace(data[pos]))
+            pos++;
+        const CKBYTE *keyword = data + pos;
+        CKDWORD length = 0;
+        while (pos + length < end && !IsSpace(data[pos + length]))
+            length++;
+
+        if (length == 6 && memcmp(keyword, "ENDHDR", 6) == 0)
+        {
+            info.dataOffset = end + 1;
+            break;
+        }
+        CKDWORD *field = NULL;
+        if (length == 5 && memcmp(keyword, "WIDTH", 5) == 0)
+            field = &info.width, hasWidth = TRUE;
+        else if (length == 6 && memcmp(keyword, "HEIGHT", 6) == 0)
+            field = &info.height, hasHeight = TRUE;
+        else if (length == 5 && memcmp(keyword, "DEPTH", 5) == 0)
+            field = &info.depth, hasDepth = TRUE;
+        else if (length == 6 && memcmp(keyword, "MAXVAL", 6) == 0)
+            field = &info.maxValue, hasMaxValue = TRUE;
+        // TUPLTYPE only names the channels, which the depth already tells;
+        // comments and unknown lines are skipped
+        if (field)
+        {
+            CKDWORD numberPos = pos + length;
+            int result = ReadHeaderNumber(data, end, numberPos, *field);
+            if (result != 0)
+                return CKBITMAPERROR_FILECORRUPTED;
+        }
+        pos = end + 1;
+    }
+    if (!hasWidth || !hasHeight || !hasDepth || !hasMaxValue)
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (info.depth == 0 || info.depth > PNM_MAX_DEPTH)
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    return 0;
+}
+
+int PNM_ReadInfo(const CKBYTE *data, CKDWORD size, PnmImageInfo &info)
+{
+    memset(&info, 0, sizeof(info));
+    if (!data || size < 3)
+        return CKBITMAPERROR_READERROR;
+    if (data[0] != 'P' || data[1] < '1' || data[1] > '7')
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    info.format = data[1] - '0';
+    info.plain = (info.format <= PNM_PLAIN_PIXMAP);
+    info.bitmap = (info.format == PNM_PLAIN_BITMAP || info.format == PNM_RAW_BITMAP);
+
+    int result;
+    if (info.format == PNM_ARBITRARY_MAP)
+    {
+        // "P7 332" is an XV thumbnail, not PAM
+        if (data[2] != '\n')
+            return CKBITMAPERROR_UNSUPPORTEDFILE;
+        result = ReadPamHeader(data, size, 3, info);
+        if (result != 0)
+            return result;
+    }
+    else
+    {
+        CKDWORD pos = 2;
+        if (!IsSpace(data[pos]) && data[pos] != '#')
+            return CKBITMAPERROR_UNSUPPORTEDFILE;
+        result = ReadHeaderNumber(data, size, pos, info.width);
+        if (result == 0)
+            result = ReadHeaderNumber(data, size, pos, info.height);
+        if (result == 0 && !info.bitmap)
+            result = ReadHeaderNumber(data, size, pos, info.maxValue);
+        if (result != 0)
+            return result;
+        if (info.bitmap)
+            info.maxValue = 1;
+        info.depth = (info.format == PNM_PLAIN_PIXMAP || info.format == PNM_RAW_PIXMAP) ? 3 : 1;
+
+        // A single whitespace character separates a raw raster from the header
+        if (!info.plain)
+        {
+            if (pos >= size)
+                return CKBITMAPERROR_READERROR;
+            if (!IsSpace(data[pos]))
+                return CKBITMAPERROR_FILECORRUPTED;
+            pos++;
+        }
+        info.dataOffset = pos;
+    }
+
+    if (info.width == 0 || info.height == 0 || !ImageWithinDecodeLimits(info.width, info.height, 0))
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (info.maxValue == 0 || info.maxValue > PNM_MAX_VALUE)
+        return CKBITMAPERROR_FILECORRUPTED;
+    return 0;
+}
+
+//=============================================================================
+// Plain Rasters
+//=============================================================================
+
+// Bit i is set if character i of the 16 at p is a digit
+static CKDWORD DigitMask(const CKBYTE *p)
+{
+    // Unsigned c - '0' < 10, as a signed compare with the sign bits flipped
+    __m128i v = _mm_sub_epi8(_mm_loadu_si128((const __m128i *)p), _mm_set1_epi8('0'));
+    v = _mm_xor_si128(v, _mm_set1_epi8((char)0x80));
+    return (CKDWORD)_mm_movemask_epi8(_mm_cmplt_epi8(v, _mm_set1_epi8((char)(0x80 + 10))));
+}
+
+// Value of the length (1 to 8) digits at p, 8 bytes of which are readable.
+// The digits are shifted to the top of a 64-bit word, then adjacent digits,
+// pairs and quads are combined with one multiply-add each.
+static CKDWORD ParseDigits8(const CKBYTE *p, CKDWORD length)
+{
+    unsigned long long chunk;
+    memcpy(&chunk, p, 8);
+    // Bytes after the number may borrow, but only from bytes that are shifted out
+    chunk -= 0x3030303030303030ULL;
+    chunk <<= 8 * (8 - length);
+    chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FFULL;
+    chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFFULL;
+    chunk = (chunk * 10000 + (chunk >> 32)) & 0xFFFFFFFFULL;
+    return (CKDWORD)chunk;
+}
+
+static CKWORD Saturate(CKDWORD value) { return (CKWORD)((value > PNM_MAX_VALUE) ? PNM_MAX_VALUE : value); }
+
+// Counts the samples in [pos, end): digits of a bitmap, numbers otherwise.
+// pos must not be inside a number.
+static CKDWORD CountSamples(const CKBYTE *data, CKDWORD pos, CKDWORD end, CKBOOL bitmap)
+{
+    CKDWORD count = 0;
+    CKDWORD previous = 0; // whether the character before the block is a digit
+    for (; end - pos >= 16; pos += 16)
+    {
+        CKDWORD digits = DigitMask(data + pos);
+        count += ImagePopCount(bitmap ? digits : digits & ~((digits << 1) | previous));
+        previous = digits >> 15;
+    }
+    for (; pos < end; pos++)
+    {
+        CKDWORD digit = IsDigit(data[pos]);
+        if (digit && (bitmap || !previous))
+            count++;
+        previous = digit;
+    }
+    return count;
+}
+
+// Parses the samples starting in [pos, end) into samples[index] onwards, up
+// to total; the data is readable up to limit. Returns the next index.
+static CKDWORD ParseSamples(const CKBYTE *data, CKDWORD pos, CKDWORD end, CKDWORD limit, CKBOOL bitmap,
+                            CKWORD *samples, CKDWORD index, CKDWORD total)
+{
+    if (bitmap)
+    {
+        for (; end - pos >= 16 && index < total; pos += 16)
+        {
+            for (CKDWORD digits = DigitMask(data + pos); digits && index < total; digits &= digits - 1)
+                samples[index++] = data[pos + ImageLowestBit(digits)] != '0';
+        }
+        for (; pos < end && index < total; pos++)
+        {
+            if (IsDigit(data[pos]))
+                samples[index++] = data[pos] != '0';
+        }
+        return index;
+    }
+
+    while (pos < end && index < total)
+    {
+        if (limit - pos >= 16)
+        {
+            // Separators are skipped a block at a time; numbers of up to 8
+            // digits are converted at once
+            CKDWORD digits = DigitMask(data + pos);
+            if (!(digits & 1))
+            {
+                pos += digits ? ImageLowestBit(digits) : 16;
+                continue;
+            }
+            CKDWORD length = ImageLowestBit(~digits);
+            if (length <= 8)
+            {
+                samples[index++] = Saturate(ParseDigits8(data + pos, length));
+                pos += length;
+                continue;
+            }
+        }
+        else if (!IsDigit(data[pos]))
+        {
+            pos++;
+            continue;
+        }
+
+        CKDWORD value = 0;
+        for (; pos < limit && IsDigit(data[pos]); pos++)
+            value = Saturate(value * 10 + (data[pos] - '0'));
+        samples[index++] = (CKWORD)value;
+    }
+    return index;
+}
+
+// Plain rasters may contain comments too (netpbm skips them); those are
+// parsed one character at a time
+static CKDWORD ParseCommented(const CKBYTE *data, CKDWORD pos, CKDWORD size, CKBOOL bitmap, CKWORD *samples,
+                              CKDWORD total)
+{
+    CKDWORD index = 0;
+    while (pos < size && index < total)
+    {
+        CKBYTE c = data[pos];
+        if (c == '#')
+        {
+            while (pos < size && data[pos] != '\n' && data[pos] != '\r')
+                pos++;
+        }
+        else if (!IsDigit(c))
+        {
+            pos++;
+        }
+        else if (bitmap)
+        {
+            samples[index++] = (c != '0');
+            pos++;
+        }
+        else
+        {
+            CKDWORD value = 0;
+            for (; pos < size && IsDigit(data[pos]); pos++)
+                value = Saturate(value * 10 + (data[pos] - '0'));
+            samples[index++] = (CKWORD)value;
+        }
+    }
+    return index;
+}
+
+struct PnmPlainJob
+{
+    const CKBYTE *data;
+    CKDWORD size;
+    CKBOOL bitmap;
+    const CKDWORD *bounds; // chunk i is [bounds[i], bounds[i + 1])
+    CKDWORD *starts;       // sample counts, then the index of each chunk's first sample
+    CKWORD *samples;
+    CKDWORD total;
+};
+
+static void CountChunks(void *context, CKDWORD begin, CKDWORD end)
+{
+    const PnmPlainJob &job = *(const PnmPlainJob *)context;
+    for (CKDWORD i = begin; i < end; i++)
+        job.starts[i] = CountSamples(job.data, job.bounds[i], job.bounds[i + 1], job.bitmap);
+}
+
+static void ParseChunks(void *context, CKDWORD begin, CKDWORD end)
+{
+    const PnmPlainJob &job = *(const PnmPlainJob *)context;
+    for (CKDWORD i = begin; i < end; i++)
+    {
+        if (job.starts[i] < job.total)
+            ParseSamples(job.data, job.bounds[i], job.bounds[i + 1], job.size, job.bitmap, job.samples,
+                         job.starts[i], job.total);
+    }
+}
+
+int PNM_ParsePlain(const CKBYTE *data, CKDWORD size, const PnmImageInfo &info, CKWORD *samples)
+{
+    CKDWORD total = info.width * info.height * info.depth;
+    CKDWORD pos = info.dataOffset;
+    if (pos > size)
+        return CKBITMAPERROR_READERROR;
+    if (memchr(data + pos, '#', size - pos))
+        return (ParseCommented(data, pos, size, info.bitmap, samples, total) < total) ? CKBITMAPERROR_READERROR : 0;
+
+    // One chunk needs no count: its samples simply start at 0
+    CKDWORD chunkCount = (size - pos) / PNM_PLAIN_CHUNK_SIZE + 1;
+    if (chunkCount == 1)
+        return (ParseSamples(data, pos, size, size, info.bitmap, samples, 0, total) < total) ? CKBITMAPERROR_READERROR
+                                                                                           : 0;
+
+    // Chunks end at a separator, so no number is split, and are counted in
+    // parallel to find where each one's samples go
+    CKDWORD *bounds = new CKDWORD[chunkCount + 1];
+    CKDWORD *starts = new CKDWORD[chunkCount];
+    bounds[0] = pos;
+    for (CKDWORD i = 1; i < chunkCount; i++)
+    {
+        CKDWORD bound = pos + i * PNM_PLAIN_CHUNK_SIZE;
+        if (bound < bounds[i - 1])
+            bound = bounds[i - 1];
+        while (bound < size && IsDigit(data[bound]))
+            bound++;
+        bounds[i] = bound;
+    }
+    bounds[chunkCount] = size;
+
+    PnmPlainJob job;
+    job.data = data;
+    job.size = size;
+    job.bitmap = info.bitmap;
+    job.bounds = bounds;
+    job.starts = starts;
+    job.samples = samples;
+    job.total = total;
+    ImageParallelFor(chunkCount, 1, CountChunks, &job);
+
+    CKDWORD found = 0;
+    for (CKDWORD i = 0; i < chunkCount; i++)
+    {
+        CKDWORD count = starts[i];
+        starts[i] = found;
+        found = (count < total - found) ? found + count : total;
+    }
+    if (found == total)
+        ImageParallelFor(chunkCount, 1, ParseChunks, &job);
+
+    delete[] starts;
+    delete[] bounds;
+    return (found < total) ? CKBITMAPERROR_READERROR : 0;
+}
+
+//=============================================================================
+// Conversion
+//=============================================================================
+struct PnmConvertJob
+{
+    const PnmImageInfo *info;
+    const CKBYTE *raster; // raw rows, or NULL
+    CKDWORD rowBytes;
+    const CKWORD *samples; // plain samples, or NULL
+    const CKBYTE *lut8;    // 8-bit value of each sample value, NULL if not needed
+    const CKWORD *lut16;   // 16-bit value of each sample value, for BGRA64
+    CKBOOL wide;
+    CKBYTE *dst;
+    int dstStride;
+};
+
+static void ExpandRow64(const CKWORD *src, CKDWORD depth, CKDWORD width, CKWORD *dst)
+{
+    for (CKDWORD x = 0; x < width; x++, src += depth, dst += 4)
+    {
+        CKWORD gray = src[0];
+        dst[0] = (depth >= 3) ? src[2] : gray;
+        dst[1] = (depth >= 3) ? src[1] : gray;
+        dst[2] = gray;
+        dst[3] = (depth == 2 || depth == 4) ? src[depth - 1] : (CKWORD)0xFFFF;
+    }
+}
+
+static void ConvertRows(void *context, CKDWORD begin, CKDWORD end)
+{
+    const PnmConvertJob &job = *(const PnmConvertJob *)context;
+    const PnmImageInfo &info = *job.info;
+    CKDWORD count = info.width * info.depth;
+    CKBYTE *row8 = new CKBYTE[count];
+    CKWORD *row16 = new CKWORD[count];
+    for (CKDWORD y = begin; y < end; y++)
+    {
+        CKBYTE *dst = job.dst + (size_t)y * job.dstStride;
+        const CKBYTE *raw = job.raster ? job.raster + (size_t)y * job.rowBytes : NULL;
+        const CKWORD *plain = job.samples ? job.samples + (size_t)y * count : NULL;
+        if (raw && info.bitmap)
+        {
+            ImageBitsToBGRA32(raw, dst, (int)info.width, 0xFFFFFFFF, 0xFF000000);
+            continue;
+        }
+
+        if (job.wide)
+        {
+            if (raw)
+            {
+                ImageSwap16(raw, row16, (int)count);
+                if (info.maxValue != PNM_MAX_VALUE)
+                    for (CKDWORD i = 0; i < count; i++)
+                        row16[i] = job.lut16[row16[i]];
+            }
+            else
+            {
+                for (CKDWORD i = 0; i < count; i++)
+                    row16[i] = job.lut16[plain[i]];
+            }
+            ExpandRow64(row16, info.depth, info.width, (CKWORD *)dst);
+            continue;
+        }
+
+        const CKBYTE *row = row8;
+        if (raw && info.maxValue == 255)
+        {
+            row = raw;
+        }
+        else if (raw && info.maxValue == PNM_MAX_VALUE)
+        {
+            ImageSwap16(raw, row16, (int)count);
+            ImageNarrow16To8(row16, row8, (int)count);
+        }
+        else if (raw && info.maxValue < 256)
+        {
+            for (CKDWORD i = 0; i < count; i++)
+                row8[i] = job.lut8[raw[i]];
+        }
+        else if (raw)
+        {
+            for (CKDWORD i = 0; i < count; i++)
+                row8[i] = job.lut8[(raw[i * 2] << 8) | raw[i * 2 + 1]];
+        }
+        else
+        {
+            for (CKDWORD i = 0; i < count; i++)
+                row8[i] = job.lut8[plain[i]];
+        }
+
+        switch (info.depth)
+        {
+        case 1:
+            ImageGrayToBGRA32(row, dst, (int)info.width);
+            break;
+        case 2:
+            ImageGrayAlphaToBGRA32(row, dst, (int)info.width);
+            break;
+        case 3:
+            ImageRGBToBGRA32(row, dst, (int)info.width);
+            break;
+        default:
+            ImageRGBAToBGRA32(row, dst, (int)info.width);
+            break;
+        }
+    }
+    delete[] row16;
+    delete[] row8;
+}
+
+//=============================================================================
+// PnmReader Class Implementation
+//=============================================================================
+PnmReader::PnmReader() : ImageReader(), m_ReadFlags(0)
+{
+    m_Properties.Init(PNMREADER_GUID, "pnm");
+}
+
+PnmReader::PnmReader(const CKGUID &guid, const char *ext) : ImageReader(), m_ReadFlags(0)
+{
+    m_Properties.Init(guid, ext);
+}
+
+PnmReader::~PnmReader()
+{
+    FreeBitmapData(&m_Properties);
+}
+
+CKPluginInfo *PnmReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_PNM];
+}
+
+void PnmReader::SetReadFlags(CKDWORD flags) { m_ReadFlags = flags; }
+
+CKDWORD PnmReader::GetReadFlags() { return m_ReadFlags; }
+
+int PnmReader::GetOptionsCount() { return 0; }
+
+CKSTRING PnmReader::GetOptionDescription(int i) { return ""; }
+
+int PnmReader::ReadFile(CKSTRING filename, CKBitmapProperties **bp)
+{
+    if (!filename || !bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_PNM, (void *)filename, 0, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int PnmReader::ReadMemory(void *memory, int size, CKBitmapProperties **bp)
+{
+    if (!bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_PNM, memory, size, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int PnmReader::ReadOwnFormat(void *data, int size, CKBitmapProperties *props)
+{
+    return PNM_Read(data, size, props, m_ReadFlags);
+}
+
+PbmReader::PbmReader() : PnmReader(PBMREADER_GUID, "pbm")
+{
+}
+
+CKPluginInfo *PbmReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_PBM];
+}
+
+PgmReader::PgmReader() : PnmReader(PGMREADER_GUID, "pgm")
+{
+}
+
+CKPluginInfo *PgmReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_PGM];
+}
+
+PpmReader::PpmReader() : PnmReader(PPMREADER_GUID, "ppm")
+{
+}
+
+CKPluginInfo *PpmReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_PPM];
+}
+
+PamReader::PamReader() : PnmReader(PAMREADER_GUID, "pam")
+{
+}
+
+CKPluginInfo *PamReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_PAM];
+}
+
+//=============================================================================
+// PNM_Read - Core Reading Function
+//=============================================================================
+int PNM_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags)
+{
+    if (!data || !props)
+        return CKBITMAPERROR_GENERIC;
+    if (size < 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // Files are mapped so raw rows are converted straight from the mapping
+    ImageFileMap fileMap;
+    if (size == 0)
+    {
+        if (!fileMap.Open((const char *)data))
+            return CKBITMAPERROR_READERROR;
+        data = (void *)fileMap.Data();
+        size = (int)fileMap.Size();
+    }
+
+    const CKBYTE *bytes = (const CKBYTE *)data;
+    CKDWORD fileSize = (CKDWORD)size;
+    PnmImageInfo info;
+    int result = PNM_ReadInfo(bytes, fileSize, info);
+    if (result != 0)
+        return result;
+
+    // The raster must fit in the file before anything is allocated: raw rows
+    // are a fixed size, plain samples take a character and a separator
+    CKBOOL wide = (readFlags & IMAGE_READ_KEEP_16BIT) && info.maxValue > 255;
+    uint64_t sampleCount = (uint64_t)info.width * info.height * info.depth;
+    uint64_t available = fileSize - info.dataOffset;
+    uint64_t rowBytes = info.bitmap ? (info.width + 7) / 8 : info.width * info.depth * (info.maxValue > 255 ? 2 : 1);
+    if (info.plain ? sampleCount > (info.bitmap ? available : (available + 1) / 2) : rowBytes * info.height > available)
+        return CKBITMAPERROR_READERROR;
+    uint64_t dstStride64 = (uint64_t)info.width * (wide ? 8 : 4);
+    if (!ImageWithinDecodeLimits(info.width, info.height, dstStride64 * info.height))
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    CKWORD *samples = NULL;
+    if (info.plain)
+    {
+        samples = new CKWORD[(size_t)sampleCount];
+        result = PNM_ParsePlain(bytes, fileSize, info, samples);
+        if (result != 0)
+        {
+            delete[] samples;
+            return result;
+        }
+    }
+
+    // Scaling tables, indexed by any 8 or 16-bit sample value; values above
+    // the maxval are clamped. Bitmaps store 1 for black.
+    CKBYTE *lut8 = NULL;
+    CKWORD *lut16 = NULL;
+    CKBOOL direct = !info.plain && (info.bitmap || info.maxValue == 255 || info.maxValue == PNM_MAX_VALUE);
+    if (!direct)
+    {
+        CKDWORD lutSize = (info.plain || info.maxValue > 255) ? PNM_MAX_VALUE + 1 : 256;
+        CKDWORD maxValue = info.maxValue;
+        if (wide)
+        {
+            lut16 = new CKWORD[lutSize];
+            for (CKDWORD v = 0; v < lutSize; v++)
+                lut16[v] = (CKWORD)(((v < maxValue ? v : maxValue) * 65535u + maxValue / 2) / maxValue);
+        }
+        else
+        {
+            lut8 = new CKBYTE[lutSize];
+            for (CKDWORD v = 0; v < lutSize; v++)
+                lut8[v] = (CKBYTE)(((v < maxValue ? v : maxValue) * 255u + maxValue / 2) / maxValue);
+            // Plain 16-bit samples keep their high byte, as raw ones do
+            if (maxValue == PNM_MAX_VALUE)
+                for (CKDWORD v = 0; v < lutSize; v++)
+                    lut8[v] = (CKBYTE)(v >> 8);
+            if (info.bitmap)
+                for (CKDWORD v = 0; v < lutSize; v++)
+                    lut8[v] = v ? 0 : 255;
+        }
+    }
+
+    int dstStride = (int)dstStride64;
+    CKBYTE *dstBlock = new CKBYTE[(size_t)dstStride64 * info.height];
+    PnmConvertJob job;
+    job.info = &info;
+    job.raster = info.plain ? NULL : bytes + info.dataOffset;
+    job.rowBytes = (CKDWORD)rowBytes;
+    job.samples = samples;
+    job.lut8 = lut8;
+    job.lut16 = lut16;
+    job.wide = wide;
+    job.dst = dstBlock;
+    job.dstStride = dstStride;
+    ImageParallelFor(info.height, 16, ConvertRows, &job);
+    delete[] lut16;
+    delete[] lut8;
+    delete[] samples;
+
+    // Fill properties
+    if (wide)
+        ImageReader::FillFormatBGRA64(props->m_Format, (int)info.width, (int)info.height, dstStride, dstBlock);
+    else
+        ImageReader::FillFormatBGRA32(props->m_Format, (int)info.width, (int)info.height, dstStride, dstBlock);
+    props->m_Data = dstBlock;
+
+    if (props->m_Size == sizeof(PnmBitmapProperties))
+    {
+        ((PnmBitmapProperties *)props)->m_PnmFormat = info.format;
+        ((PnmBitmapProperties *)props)->m_MaxValue = info.maxValue;
+    }
+    return 0;
+}
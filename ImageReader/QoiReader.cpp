@@ -0,0 +1,424 @@
+#include "QoiReader.h"
+#include "ImageSimd.h"
+#include "ImageFileMap.h"
+#include "ImageThreadPool.h"
+
+//=============================================================================
+// Pixel Helpers
+//
+// Pixels are kept as BGRA32 words (B in the low byte) throughout, so decoded
+// values are stored to the destination as they are.
+//=============================================================================
+static CKDWORD ReadBE32(const CKBYTE *p)
+{
+    return ((CKDWORD)p[0] << 24) | ((CKDWORD)p[1] << 16) | ((CKDWORD)p[2] << 8) | (CKDWORD)p[3];
+}
+
+static void WriteBE32(CKBYTE *p, CKDWORD v)
+{
+    p[0] = (CKBYTE)(v >> 24);
+    p[1] = (CKBYTE)(v >> 16);
+    p[2] = (CKBYTE)(v >> 8);
+    p[3] = (CKBYTE)v;
+}
+
+static CKDWORD QoiHash(CKDWORD px)
+{
+    return (((px >> 16) & 0xFF) * 3 + ((px >> 8) & 0xFF) * 5 + (px & 0xFF) * 7 + (px >> 24) * 11) & 63;
+}
+
+// Adds per-byte deltas without carries between channels
+static CKDWORD AddBytes(CKDWORD px, CKDWORD delta)
+{
+    return (((px & 0x00FF00FF) + (delta & 0x00FF00FF)) & 0x00FF00FF) |
+           (((px & 0xFF00FF00) + (delta & 0xFF00FF00)) & 0xFF00FF00);
+}
+
+static CKDWORD PackDelta(int dr, int dg, int db)
+{
+    return ((CKDWORD)(dr & 0xFF) << 16) | ((CKDWORD)(dg & 0xFF) << 8) | (CKDWORD)(db & 0xFF);
+}
+
+//=============================================================================
+// Delta Tables
+//
+// QOI_OP_DIFF and QOI_OP_LUMA become one or two table lookups plus AddBytes,
+// so the decoder has no per-channel arithmetic.
+//=============================================================================
+struct QoiDeltaTables
+{
+    CKDWORD diff[64];  // 01|dr|dg|db, indexed by the low 6 bits
+    CKDWORD lumaG[64]; // 10|dg: dg added to all three channels
+    CKDWORD lumaRB[256]; // dr-dg|db-dg
+};
+
+static QoiDeltaTables s_DeltaTables;
+static ImageOnce s_DeltaTablesOnce = 0;
+
+static void BuildDeltaTables()
+{
+    for (int v = 0; v < 64; v++)
+    {
+        s_DeltaTables.diff[v] = PackDelta(((v >> 4) & 3) - 2, ((v >> 2) & 3) - 2, (v & 3) - 2);
+        int dg = v - 32;
+        s_DeltaTables.lumaG[v] = PackDelta(dg, dg, dg);
+    }
+    for (int v = 0; v < 256; v++)
+        s_DeltaTables.lumaRB[v] = PackDelta((v >> 4) - 8, 0, (v & 15) - 8);
+}
+
+static const QoiDeltaTables &GetDeltaTables()
+{
+    ImageCallOnce(s_DeltaTablesOnce, BuildDeltaTables);
+    return s_DeltaTables;
+}
+
+//=============================================================================
+// Decoding
+//=============================================================================
+
+// Decodes pixelCount pixels from the chunk stream. Ops are only started before
+// chunksEnd; the 8 padding bytes behind it cover the longest op, so operand
+// reads need no bounds checks.
+static CKBOOL DecodeQoiChunks(const CKBYTE *src, CKDWORD chunksEnd, CKDWORD *dst, CKDWORD pixelCount)
+{
+    const QoiDeltaTables &tables = GetDeltaTables();
+    CKDWORD index[64];
+    memset(index, 0, sizeof(index));
+
+    CKDWORD px = 0xFF000000;
+    CKDWORD pos = 0;
+    CKDWORD *out = dst;
+    CKDWORD *outEnd = dst + pixelCount;
+
+    while (out < outEnd)
+    {
+        if (pos >= chunksEnd)
+            return FALSE;
+
+        CKDWORD b1 = src[pos++];
+        switch (b1 >> 6)
+        {
+        case 0: // QOI_OP_INDEX (the slot already holds px, no update needed)
+            px = index[b1];
+            *out++ = px;
+            continue;
+        case 1: // QOI_OP_DIFF
+            px = AddBytes(px, tables.diff[b1 & 0x3F]);
+            break;
+        case 2: // QOI_OP_LUMA
+            px = AddBytes(AddBytes(px, tables.lumaG[b1 & 0x3F]), tables.lumaRB[src[pos++]]);
+            break;
+        default:
+            if (b1 < QOI_OP_RGB)
+            {
+                // QOI_OP_RUN: px is already in the index
+                CKDWORD run = (b1 & 0x3F) + 1;
+                CKDWORD left = (CKDWORD)(outEnd - out);
+                if (run > left)
+                    run = left;
+                for (CKDWORD i = 0; i < run; i++)
+                    out[i] = px;
+                out += run;
+                continue;
+            }
+            // QOI_OP_RGB keeps alpha, QOI_OP_RGBA (bit 0 set) replaces it
+            {
+                CKDWORD alpha = (b1 & 1) ? ((CKDWORD)src[pos + 3] << 24) : (px & 0xFF000000);
+                px = alpha | ((CKDWORD)src[pos] << 16) | ((CKDWORD)src[pos + 1] << 8) | (CKDWORD)src[pos + 2];
+                pos += 3 + (b1 & 1);
+            }
+            break;
+        }
+
+        index[QoiHash(px)] = px;
+        *out++ = px;
+    }
+    return TRUE;
+}
+
+//=============================================================================
+// QoiReader Class Implementation
+//=============================================================================
+QoiReader::QoiReader() : ImageReader()
+{
+    m_Properties.Init(QOIREADER_GUID, "qoi");
+}
+
+QoiReader::~QoiReader()
+{
+    FreeBitmapData(&m_Properties);
+}
+
+CKPluginInfo *QoiReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_QOI];
+}
+
+int QoiReader::GetOptionsCount() { return 1; }
+
+CKSTRING QoiReader::GetOptionDescription(int i)
+{
+    return (i == 0) ? "Enum:Channels:Auto=0,RGB=3,RGBA=4" : "";
+}
+
+CKBOOL QoiReader::IsAlphaSaved(CKBitmapProperties *bp)
+{
+    if (!bp || bp->m_Size != sizeof(QoiBitmapProperties))
+        return TRUE;
+    // In auto mode alpha is kept whenever the image actually uses it
+    CKDWORD channels = ((QoiBitmapProperties *)bp)->m_Channels;
+    return channels != 3;
+}
+
+int QoiReader::ReadFile(CKSTRING filename, CKBitmapProperties **bp)
+{
+    if (!filename || !bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_QOI, (void *)filename, 0, (CKBitmapProperties *)&m_Properties, 0);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int QoiReader::ReadMemory(void *memory, int size, CKBitmapProperties **bp)
+{
+    if (!bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_QOI, memory, size, (CKBitmapProperties *)&m_Properties, 0);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int QoiReader::ReadOwnFormat(void *data, int size, CKBitmapProperties *props)
+{
+    return QOI_Read(data, size, props);
+}
+
+int QoiReader::SaveFile(CKSTRING filename, CKBitmapProperties *bp)
+{
+    if (!filename || !bp)
+        return 0;
+    CKDWORD channels = (bp->m_Size == sizeof(QoiBitmapProperties)) ? ((QoiBitmapProperties *)bp)->m_Channels
+                                                                    : QOI_CHANNELS_AUTO;
+    void *ptr = (void *)filename;
+    return QOI_Save(&ptr, bp, (int)channels);
+}
+
+int QoiReader::SaveMemory(void **memory, CKBitmapProperties *bp)
+{
+    if (!memory || !bp)
+        return 0;
+    CKDWORD channels = (bp->m_Size == sizeof(QoiBitmapProperties)) ? ((QoiBitmapProperties *)bp)->m_Channels
+                                                                    : QOI_CHANNELS_AUTO;
+    *memory = NULL;
+    return QOI_Save(memory, bp, (int)channels);
+}
+
+//=============================================================================
+// QOI_Read - Core Reading Function
+//=============================================================================
+int QOI_Read(void *data, int size, CKBitmapProperties *props)
+{
+    if (!data || !props)
+        return CKBITMAPERROR_GENERIC;
+    if (size < 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // Files are mapped and decoded straight from the mapping
+    ImageFileMap fileMap;
+    if (size == 0)
+    {
+        if (!fileMap.Open((const char *)data))
+            return CKBITMAPERROR_READERROR;
+        data = (void *)fileMap.Data();
+        size = (int)fileMap.Size();
+    }
+
+    const CKBYTE *bytes = (const CKBYTE *)data;
+    if (size < QOI_HEADER_SIZE)
+        return CKBITMAPERROR_READERROR;
+    if (ReadBE32(bytes) != QOI_MAGIC)
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+
+    CKDWORD width = ReadBE32(bytes + 4);
+    CKDWORD height = ReadBE32(bytes + 8);
+    CKBYTE channels = bytes[12];
+    CKBYTE colorSpace = bytes[13];
+    if (width == 0 || height == 0 || (channels != 3 && channels != 4) || colorSpace > 1)
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (!ImageWithinDecodeLimits(width, height, (uint64_t)width * height * 4))
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (size < QOI_HEADER_SIZE + QOI_PADDING_SIZE)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    CKDWORD pixelCount = width * height;
+    CKDWORD chunksEnd = (CKDWORD)size - QOI_HEADER_SIZE - QOI_PADDING_SIZE;
+    // Every chunk yields at most 62 pixels
+    if ((uint64_t)chunksEnd * 62 < pixelCount)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    CKBYTE *dstPixels = new CKBYTE[pixelCount * 4];
+    if (!DecodeQoiChunks(bytes + QOI_HEADER_SIZE, chunksEnd, (CKDWORD *)dstPixels, pixelCount))
+    {
+        delete[] dstPixels;
+        return CKBITMAPERROR_FILECORRUPTED;
+    }
+
+    // Fill properties
+    ImageReader::FillFormatBGRA32(props->m_Format, (int)width, (int)height, (int)(width * 4), dstPixels);
+    props->m_Data = dstPixels;
+
+    if (props->m_Size == sizeof(QoiBitmapProperties))
+        ((QoiBitmapProperties *)props)->m_Channels = channels;
+
+    return 0;
+}
+
+//=============================================================================
+// QOI_Save - Core Saving Function
+//=============================================================================
+int QOI_Save(void **outBuffer, CKBitmapProperties *props, int channels)
+{
+    if (!outBuffer || !props || !props->m_Format.Image)
+        return 0;
+
+    const VxImageDescEx &format = props->m_Format;
+    if (format.Width <= 0 || format.Height <= 0 || format.BitsPerPixel != 32)
+        return 0;
+
+    CKDWORD width = (CKDWORD)format.Width;
+    CKDWORD height = (CKDWORD)format.Height;
+    if (height > IMAGE_DEFAULT_MAX_PIXELS / width)
+        return 0;
+
+    const CKBYTE *srcPixels = format.Image;
+    int srcStride = format.BytesPerLine;
+    if (channels == QOI_CHANNELS_AUTO)
+        channels = ImageIsOpaqueBGRA32(srcPixels, (int)width, (int)height, srcStride) ? 3 : 4;
+    if (channels != 3 && channels != 4)
+        channels = 4;
+
+    // Worst case: every pixel is a QOI_OP_RGBA chunk
+    uint64_t maxFileSize64 = QOI_HEADER_SIZE + (uint64_t)width * height * 5 + QOI_PADDING_SIZE;
+    if (maxFileSize64 > 0x7FFFFFFFULL)
+        return 0;
+    CKDWORD maxFileSize = (CKDWORD)maxFileSize64;
+
+    CKBYTE *buffer = new CKBYTE[maxFileSize];
+    WriteBE32(buffer, QOI_MAGIC);
+    WriteBE32(buffer + 4, width);
+    WriteBE32(buffer + 8, height);
+    buffer[12] = (CKBYTE)channels;
+    buffer[13] = 0; // sRGB with linear alpha
+
+    // RGB images are encoded as fully opaque so alpha never costs a chunk
+    CKDWORD alphaForce = (channels == 3) ? 0xFF000000 : 0;
+
+    CKDWORD index[64];
+    memset(index, 0, sizeof(index));
+    CKDWORD prev = 0xFF000000;
+    CKDWORD run = 0;
+    CKBYTE *out = buffer + QOI_HEADER_SIZE;
+
+    for (CKDWORD y = 0; y < height; y++)
+    {
+        const CKDWORD *row = (const CKDWORD *)(srcPixels + (size_t)y * srcStride);
+        for (CKDWORD x = 0; x < width; x++)
+        {
+            CKDWORD px = row[x] | alphaForce;
+            if (px == prev)
+            {
+                if (++run == 62)
+                {
+                    *out++ = (CKBYTE)(QOI_OP_RUN | (run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0)
+            {
+                *out++ = (CKBYTE)(QOI_OP_RUN | (run - 1));
+                run = 0;
+            }
+
+            CKDWORD hash = QoiHash(px);
+            if (index[hash] == px)
+            {
+                *out++ = (CKBYTE)(QOI_OP_INDEX | hash);
+                prev = px;
+                continue;
+            }
+            index[hash] = px;
+
+            if ((px ^ prev) >> 24)
+            {
+                *out++ = QOI_OP_RGBA;
+                *out++ = (CKBYTE)(px >> 16);
+                *out++ = (CKBYTE)(px >> 8);
+                *out++ = (CKBYTE)px;
+                *out++ = (CKBYTE)(px >> 24);
+                prev = px;
+                continue;
+            }
+
+            // Channel differences wrap around, as the decoder's additions do
+            int dr = (signed char)(CKBYTE)((px >> 16) - (prev >> 16));
+            int dg = (signed char)(CKBYTE)((px >> 8) - (prev >> 8));
+            int db = (signed char)(CKBYTE)(px - prev);
+            int drdg = dr - dg;
+            int dbdg = db - dg;
+
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+            {
+                *out++ = (CKBYTE)(QOI_OP_DIFF | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+            }
+            else if (dg >= -32 && dg <= 31 && drdg >= -8 && drdg <= 7 && dbdg >= -8 && dbdg <= 7)
+            {
+                *out++ = (CKBYTE)(QOI_OP_LUMA | (dg + 32));
+                *out++ = (CKBYTE)(((drdg + 8) << 4) | (dbdg + 8));
+            }
+            else
+            {
+                *out++ = QOI_OP_RGB;
+                *out++ = (CKBYTE)(px >> 16);
+                *out++ = (CKBYTE)(px >> 8);
+                *out++ = (CKBYTE)px;
+            }
+            prev = px;
+        }
+    }
+    if (run > 0)
+        *out++ = (CKBYTE)(QOI_OP_RUN | (run - 1));
+
+    memset(out, 0, QOI_PADDING_SIZE - 1);
+    out[QOI_PADDING_SIZE - 1] = 1;
+    out += QOI_PADDING_SIZE;
+
+    CKDWORD fileSize = (CKDWORD)(out - buffer);
+
+    // Output
+    if (*outBuffer)
+    {
+        FILE *fp = fopen((const char *)*outBuffer, "wb");
+        if (!fp)
+        {
+            delete[] buffer;
+            return 0;
+        }
+        fwrite(buffer, 1, fileSize, fp);
+        fclose(fp);
+        delete[] buffer;
+    }
+    else
+    {
+        if (fileSize < maxFileSize)
+        {
+            CKBYTE *final = new CKBYTE[fileSize];
+            memcpy(final, buffer, fileSize);
+            delete[] buffer;
+            buffer = final;
+        }
+        *outBuffer = buffer;
+    }
+    return (int)fileSize;
+}
@@ -0,0 +1,69 @@
+#ifndef QOIREADER_H
+#define QOIREADER_H
+
+#include "ImageReader.h"
+
+// QOI Reader GUID
+#define QOIREADER_GUID CKGUID(0x6B1E43D2, 0x1C7F0A95)
+
+/**
+ * QoiReader - Quite OK Image format reader/writer
+ *
+ *   - Reading: 3 and 4 channel images, decoded straight to BGRA32
+ *   - Writing: RGB or RGBA, or picked from the source alpha (QOI_CHANNELS_AUTO)
+ *   - Lossless; typically much smaller than uncompressed TGA and several
+ *     times faster to decode than PNG
+ */
+class QoiReader : public ImageReader
+{
+public:
+    QoiReader();
+    virtual ~QoiReader();
+
+    virtual CKPluginInfo *GetReaderInfo();
+    virtual int GetOptionsCount();
+    virtual CKSTRING GetOptionDescription(int i);
+    virtual CKBOOL IsAlphaSaved(CKBitmapProperties *bp);
+
+    virtual int ReadFile(CKSTRING filename, CKBitmapProperties **bp);
+    virtual int ReadMemory(void *memory, int size, CKBitmapProperties **bp);
+    virtual int SaveFile(CKSTRING filename, CKBitmapProperties *bp);
+    virtual int SaveMemory(void **memory, CKBitmapProperties *bp);
+
+protected:
+    virtual int ReadOwnFormat(void *data, int size, CKBitmapProperties *props);
+
+private:
+    QoiBitmapProperties m_Properties;
+};
+
+//=============================================================================
+// QOI file format
+//=============================================================================
+#define QOI_MAGIC 0x716F6966 // "qoif", stored big-endian
+#define QOI_HEADER_SIZE 14
+#define QOI_PADDING_SIZE 8 // 7 zero bytes followed by 0x01
+
+// Chunk tags
+#define QOI_OP_INDEX 0x00 // 00xxxxxx
+#define QOI_OP_DIFF 0x40  // 01xxxxxx
+#define QOI_OP_LUMA 0x80  // 10xxxxxx
+#define QOI_OP_RUN 0xC0   // 11xxxxxx
+#define QOI_OP_RGB 0xFE
+#define QOI_OP_RGBA 0xFF
+
+// Save channel count selected from the source alpha (3 if fully opaque, else 4)
+#define QOI_CHANNELS_AUTO 0
+
+//=============================================================================
+// Internal helper functions
+//=============================================================================
+
+// Core QOI read function (size == 0 means data is a filename)
+int QOI_Read(void *data, int size, CKBitmapProperties *props);
+
+// Core QOI save function
+// channels may be QOI_CHANNELS_AUTO to pick 3 or 4 from the source alpha
+int QOI_Save(void **outBuffer, CKBitmapProperties *props, int channels);
+
+#endif // QOIREADER_H
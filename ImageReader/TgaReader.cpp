@@ -1,4 +1,5 @@
 #include "TgaReader.h"
+#include "ImageSimd.h"
 
 #include "XArray.h"
 
@@ -394,7 +395,7 @@ int TgaReader::GetOptionsCount() { return 2; }
 CKSTRING TgaReader::GetOptionDescription(int i)
 {
     if (i == 0)
-        return "Enum:Bit Depth:16 bit=16,24 bit=24,32 bit=32,Greyscale=64";
+        return "Enum:Bit Depth:16 bit=16,24 bit=24,32 bit=32,Greyscale=64,Auto=1";
     if (i == 1)
         return "Boolean:Run Length Encoding";
     return "";
@@ -404,14 +405,23 @@ CKBOOL TgaReader::IsAlphaSaved(CKBitmapProperties *bp)
 {
     if (!bp || bp->m_Size != 80)
         return FALSE;
-    return ((CKDWORD *)bp)[18] == 32;
+    CKDWORD bitDepth = ((CKDWORD *)bp)[18];
+    if (bitDepth != TGA_BITDEPTH_AUTO)
+        return bitDepth == 32;
+
+    // Auto mode keeps alpha only when the image uses it; without an image
+    // to look at, alpha is not promised
+    const VxImageDescEx &fmt = bp->m_Format;
+    if (!fmt.Image || fmt.Width <= 0 || fmt.Height <= 0)
+        return FALSE;
+    return !ImageIsOpaqueBGRA32(fmt.Image, fmt.Width, fmt.Height, fmt.BytesPerLine);
 }
 
 int TgaReader::ReadFile(CKSTRING filename, CKBitmapProperties **bp)
 {
     if (!filename || !bp)
         return 1;
-    int result = TGA_Read((void *)filename, 0, (CKBitmapProperties *)&m_Properties);
+    int result = ReadSniffed(READER_INDEX_TGA, (void *)filename, 0, (CKBitmapProperties *)&m_Properties, 0);
     *bp = (CKBitmapProperties *)&m_Properties;
     return result;
 }
@@ -420,11 +430,16 @@ int TgaReader::ReadMemory(void *memory, int size, CKBitmapProperties **bp)
 {
     if (!bp)
         return 1;
-    int result = TGA_Read(memory, size, (CKBitmapProperties *)&m_Properties);
+    int result = ReadSniffed(READER_INDEX_TGA, memory, size, (CKBitmapProperties *)&m_Properties, 0);
     *bp = (CKBitmapProperties *)&m_Properties;
     return result;
 }
 
+int TgaReader::ReadOwnFormat(void *data, int size, CKBitmapProperties *props)
+{
+    return TGA_Read(data, size, props);
+}
+
 int TgaReader::SaveFile(CKSTRING filename, CKBitmapProperties *bp)
 {
     if (!filename || !bp)
@@ -488,6 +503,17 @@ int TGA_Read(void *data, int size, CKBitmapProperties *props)
         return result;
     }
 
+    // Reject images over the decode limits, and pixel data the file cannot
+    // hold, before reading or allocating. An RLE packet covers 128 pixels at most.
+    unsigned long long totalPixels64 = (unsigned long long)ctx.width * ctx.height;
+    unsigned long long minDataSize = ctx.isRLE ? ((totalPixels64 + 127) / 128) * (1 + ctx.srcBytesPerPixel)
+                                               : totalPixels64 * ctx.srcBytesPerPixel;
+    if (!ImageWithinDecodeLimits(ctx.width, ctx.height, totalPixels64 * 4) || src->Remaining() < minDataSize)
+    {
+        delete src;
+        return CKBITMAPERROR_FILECORRUPTED;
+    }
+
     // Read pixel data
     XArray<CKBYTE> srcPixels;
     if (!src->ReadRemaining(srcPixels))
@@ -632,6 +658,8 @@ int TGA_Save(void **outBuffer, CKBitmapProperties *props, int bitDepth, int useR
 
     if (width == 0 || height == 0)
         return 0;
+    if (bitDepth == TGA_BITDEPTH_AUTO)
+        bitDepth = ImageIsOpaqueBGRA32(srcPixels, (int)width, (int)height, (int)srcStride) ? 24 : 32;
     if (bitDepth != 24 && bitDepth != 32)
         bitDepth = 24;
 
@@ -14,6 +14,7 @@
  *   - Image types 1, 2, 3 (uncompressed) and 9, 10, 11 (RLE compressed)
  *   - Color-mapped (paletted), grayscale, and true-color images
  *   - Writing: 24/32-bit TGA with optional RLE compression
+ *   - Auto bit depth: writes 32-bit only when the source has non-opaque alpha
  *
  * Original binary layout:
  *   - vtable: 4 bytes (offset 0)
@@ -39,6 +40,9 @@ public:
     virtual int SaveFile(CKSTRING filename, CKBitmapProperties *bp);
     virtual int SaveMemory(void **memory, CKBitmapProperties *bp);
 
+protected:
+    virtual int ReadOwnFormat(void *data, int size, CKBitmapProperties *props);
+
 private:
     // Extended properties (80 bytes) stored inline
     // m_Size = 80, m_BitDepth at offset 72, m_UseRLE at offset 76
@@ -79,6 +83,10 @@ struct TGAHEADER
 #define TGA_TYPE_RLE_TRUECOLOR 10 // RLE, true-color
 #define TGA_TYPE_RLE_GRAYSCALE 11 // RLE, grayscale
 
+// Save bit depth selected from the source alpha (24 if fully opaque, else 32).
+// Any other value than 24, 32 or this one, 0 included, saves 24-bit.
+#define TGA_BITDEPTH_AUTO 1
+
 //=============================================================================
 // Internal helper functions
 //=============================================================================
@@ -87,6 +95,7 @@ struct TGAHEADER
 int TGA_Read(void *data, int size, CKBitmapProperties *props);
 
 // Core TGA save function
+// bitDepth may be TGA_BITDEPTH_AUTO to pick 24 or 32 from the source alpha
 int TGA_Save(void **outBuffer, CKBitmapProperties *props, int bitDepth, int useRLE);
 
 #endif // TGAREADER_H
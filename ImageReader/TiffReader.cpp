@@ -0,0 +1,819 @@
+#include "TiffReader.h"
+#include "ImageInflate.h"
+#include "ImageLzw.h"
+#include "ImageSimd.h"
+#include "ImageThreadPool.h"
+#include "ImageFileMap.h"
+
+//=============================================================================
+// Byte Helpers
+//=============================================================================
+static CKDWORD Read16(const CKBYTE *p, CKBOOL bigEndian)
+{
+    if (bigEndian)
+        return ((CKDWORD)p[0] << 8) | (CKDWORD)p[1];
+    return (CKDWORD)p[0] | ((CKDWORD)p[1] << 8);
+}
+
+static CKDWORD Read32(const CKBYTE *p, CKBOOL bigEndian)
+{
+    if (bigEndian)
+        return ((CKDWORD)p[0] << 24) | ((CKDWORD)p[1] << 16) | ((CKDWORD)p[2] << 8) | (CKDWORD)p[3];
+    return (CKDWORD)p[0] | ((CKDWORD)p[1] << 8) | ((CKDWORD)p[2] << 16) | ((CKDWORD)p[3] << 24);
+}
+
+static CKDWORD TypeSize(CKDWORD type)
+{
+    switch (type)
+    {
+    case TIFF_TYPE_BYTE:
+        return 1;
+    case TIFF_TYPE_SHORT:
+        return 2;
+    case TIFF_TYPE_LONG:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+CKDWORD TIFF_ArrayValue(const TiffImageInfo &info, const TiffArray &array, CKDWORD i)
+{
+    if (i >= array.count)
+        return 0;
+    switch (array.type)
+    {
+    case TIFF_TYPE_BYTE:
+        return array.data[i];
+    case TIFF_TYPE_SHORT:
+        return Read16(array.data + i * 2, info.bigEndian);
+    case TIFF_TYPE_LONG:
+        return Read32(array.data + i * 4, info.bigEndian);
+    default:
+        return 0;
+    }
+}
+
+//=============================================================================
+// Header and IFD
+//=============================================================================
+
+// Values of up to 4 bytes are stored in the entry itself, longer arrays at an offset
+static CKBOOL ReadEntry(const CKBYTE *data, CKDWORD size, CKBOOL bigEndian, const CKBYTE *entry, TiffArray &array)
+{
+    array.type = Read16(entry + 2, bigEndian);
+    array.count = Read32(entry + 4, bigEndian);
+    CKDWORD typeSize = TypeSize(array.type);
+    if (typeSize == 0 || array.count == 0)
+        return FALSE;
+
+    unsigned long long bytes = (unsigned long long)array.count * typeSize;
+    if (bytes <= 4)
+    {
+        array.data = entry + 8;
+        return TRUE;
+    }
+    CKDWORD offset = Read32(entry + 8, bigEndian);
+    if (offset > size || bytes > size - offset)
+        return FALSE;
+    array.data = data + offset;
+    return TRUE;
+}
+
+static CKBOOL IsSupportedCompression(CKDWORD compression)
+{
+    return compression == TIFF_COMPRESSION_NONE || compression == TIFF_COMPRESSION_PACKBITS ||
+           compression == TIFF_COMPRESSION_LZW || compression == TIFF_COMPRESSION_DEFLATE ||
+           compression == TIFF_COMPRESSION_ADOBE_DEFLATE;
+}
+
+int TIFF_ReadInfo(const CKBYTE *data, CKDWORD size, TiffImageInfo &info)
+{
+    memset(&info, 0, sizeof(info));
+    if (!data || size < TIFF_HEADER_SIZE)
+        return CKBITMAPERROR_READERROR;
+    if (data[0] == 'M' && data[1] == 'M')
+        info.bigEndian = TRUE;
+    else if (data[0] != 'I' || data[1] != 'I')
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    // BigTIFF (43) has 64-bit offsets and is not supported
+    if (Read16(data + 2, info.bigEndian) != TIFF_MAGIC)
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+
+    CKDWORD ifd = Read32(data + 4, info.bigEndian);
+    if (ifd < TIFF_HEADER_SIZE || ifd > size - 2)
+        return CKBITMAPERROR_FILECORRUPTED;
+    CKDWORD entryCount = Read16(data + ifd, info.bigEndian);
+    if ((unsigned long long)entryCount * TIFF_ENTRY_SIZE > size - ifd - 2)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // Tags the decoder uses; missing arrays keep count 0
+    TiffArray width, height, bitsPerSample, compression, photometric, fillOrder, samplesPerPixel, rowsPerStrip;
+    TiffArray planarConfig, predictor, colorMap, tileWidth, tileLength, extraSamples, sampleFormat;
+    TiffArray stripOffsets, stripByteCounts, tileOffsets, tileByteCounts;
+    TiffArray *arrays[] = {&width, &height, &bitsPerSample, &compression, &photometric, &fillOrder,
+                           &samplesPerPixel, &rowsPerStrip, &planarConfig, &predictor, &colorMap, &tileWidth,
+                           &tileLength, &extraSamples, &sampleFormat, &stripOffsets, &stripByteCounts,
+                           &tileOffsets, &tileByteCounts};
+    for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++)
+        memset(arrays[i], 0, sizeof(TiffArray));
+
+    for (CKDWORD i = 0; i < entryCount; i++)
+    {
+        const CKBYTE *entry = data + ifd + 2 + i * TIFF_ENTRY_SIZE;
+        TiffArray *array;
+        switch (Read16(entry, info.bigEndian))
+        {
+        case TIFF_TAG_IMAGE_WIDTH: array = &width; break;
+        case TIFF_TAG_IMAGE_LENGTH: array = &height; break;
+        case TIFF_TAG_BITS_PER_SAMPLE: array = &bitsPerSample; break;
+        case TIFF_TAG_COMPRESSION: array = &compression; break;
+        case TIFF_TAG_PHOTOMETRIC: array = &photometric; break;
+        case TIFF_TAG_FILL_ORDER: array = &fillOrder; break;
+        case TIFF_TAG_STRIP_OFFSETS: array = &stripOffsets; break;
+        case TIFF_TAG_SAMPLES_PER_PIXEL: array = &samplesPerPixel; break;
+        case TIFF_TAG_ROWS_PER_STRIP: array = &rowsPerStrip; break;
+        case TIFF_TAG_STRIP_BYTE_COUNTS: array = &stripByteCounts; break;
+        case TIFF_TAG_PLANAR_CONFIG: array = &planarConfig; break;
+        case TIFF_TAG_PREDICTOR: array = &predictor; break;
+        case TIFF_TAG_COLOR_MAP: array = &colorMap; break;
+        case TIFF_TAG_TILE_WIDTH: array = &tileWidth; break;
+        case TIFF_TAG_TILE_LENGTH: array = &tileLength; break;
+        case TIFF_TAG_TILE_OFFSETS: array = &tileOffsets; break;
+        case TIFF_TAG_TILE_BYTE_COUNTS: array = &tileByteCounts; break;
+        case TIFF_TAG_EXTRA_SAMPLES: array = &extraSamples; break;
+        case TIFF_TAG_SAMPLE_FORMAT: array = &sampleFormat; break;
+        default: continue;
+        }
+        if (!ReadEntry(data, size, info.bigEndian, entry, *array))
+            return CKBITMAPERROR_FILECORRUPTED;
+    }
+
+    // Single values, with the defaults of the specification
+    info.width = TIFF_ArrayValue(info, width, 0);
+    info.height = TIFF_ArrayValue(info, height, 0);
+    info.samplesPerPixel = samplesPerPixel.count ? TIFF_ArrayValue(info, samplesPerPixel, 0) : 1;
+    info.bitsPerSample = bitsPerSample.count ? TIFF_ArrayValue(info, bitsPerSample, 0) : 1;
+    info.sampleFormat = sampleFormat.count ? TIFF_ArrayValue(info, sampleFormat, 0) : TIFF_SAMPLE_FORMAT_UINT;
+    info.compression = compression.count ? TIFF_ArrayValue(info, compression, 0) : TIFF_COMPRESSION_NONE;
+    info.predictor = predictor.count ? TIFF_ArrayValue(info, predictor, 0) : TIFF_PREDICTOR_NONE;
+    CKDWORD planar = planarConfig.count ? TIFF_ArrayValue(info, planarConfig, 0) : 1;
+    if (info.width == 0 || info.height == 0 || info.width > 0x7FFFFFFF || info.height > 0x7FFFFFFF)
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (!ImageWithinDecodeLimits(info.width, info.height, 0))
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (photometric.count == 0 || info.samplesPerPixel == 0 || (planar != 1 && planar != 2))
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (info.samplesPerPixel > TIFF_MAX_SAMPLES)
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    if (!IsSupportedCompression(info.compression) || (fillOrder.count && TIFF_ArrayValue(info, fillOrder, 0) != 1))
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+
+    // Every sample must have the same depth and format
+    for (CKDWORD i = 1; i < info.samplesPerPixel; i++)
+    {
+        if ((i < bitsPerSample.count && TIFF_ArrayValue(info, bitsPerSample, i) != info.bitsPerSample) ||
+            (i < sampleFormat.count && TIFF_ArrayValue(info, sampleFormat, i) != info.sampleFormat))
+            return CKBITMAPERROR_UNSUPPORTEDFILE;
+    }
+    CKDWORD bps = info.bitsPerSample;
+    if (info.sampleFormat == TIFF_SAMPLE_FORMAT_FLOAT)
+    {
+        if (bps != 32)
+            return CKBITMAPERROR_UNSUPPORTEDFILE;
+    }
+    else if (info.sampleFormat != TIFF_SAMPLE_FORMAT_UINT || (bps != 1 && bps != 2 && bps != 4 && bps != 8 && bps != 16))
+    {
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    }
+
+    info.photometric = TIFF_ArrayValue(info, photometric, 0);
+    switch (info.photometric)
+    {
+    case TIFF_PHOTOMETRIC_MIN_IS_WHITE:
+    case TIFF_PHOTOMETRIC_MIN_IS_BLACK:
+        info.colorSamples = 1;
+        break;
+    case TIFF_PHOTOMETRIC_PALETTE:
+        info.colorSamples = 1;
+        if (bps > 8 || info.sampleFormat != TIFF_SAMPLE_FORMAT_UINT)
+            return CKBITMAPERROR_UNSUPPORTEDFILE;
+        if (colorMap.type != TIFF_TYPE_SHORT || colorMap.count != (3u << bps))
+            return CKBITMAPERROR_FILECORRUPTED;
+        break;
+    case TIFF_PHOTOMETRIC_RGB:
+        info.colorSamples = 3;
+        break;
+    case TIFF_PHOTOMETRIC_SEPARATED:
+        info.colorSamples = 4;
+        break;
+    default:
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    }
+    if (info.samplesPerPixel < info.colorSamples)
+        return CKBITMAPERROR_FILECORRUPTED;
+    // Packed samples only make sense for single-sample gray and palette images
+    if (bps < 8 && info.colorSamples != 1)
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+
+    switch (info.predictor)
+    {
+    case TIFF_PREDICTOR_NONE:
+        break;
+    case TIFF_PREDICTOR_HORIZONTAL:
+        if (bps != 8 && bps != 16)
+            return CKBITMAPERROR_UNSUPPORTEDFILE;
+        break;
+    case TIFF_PREDICTOR_FLOAT:
+        if (info.sampleFormat != TIFF_SAMPLE_FORMAT_FLOAT)
+            return CKBITMAPERROR_UNSUPPORTEDFILE;
+        break;
+    default:
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    }
+
+    // Only an extra sample marked as alpha is used; any others are skipped
+    if (info.samplesPerPixel > info.colorSamples && extraSamples.count)
+    {
+        CKDWORD extra = TIFF_ArrayValue(info, extraSamples, 0);
+        if (extra == TIFF_EXTRA_ASSOCIATED_ALPHA || extra == TIFF_EXTRA_UNASSOCIATED_ALPHA)
+            info.alphaType = extra;
+    }
+    info.planes = (planar == 2) ? info.samplesPerPixel : 1;
+
+    // Strips are chunks as wide as the image
+    if (tileWidth.count || tileLength.count)
+    {
+        info.tiled = TRUE;
+        info.chunkWidth = TIFF_ArrayValue(info, tileWidth, 0);
+        info.chunkHeight = TIFF_ArrayValue(info, tileLength, 0);
+        info.offsets = tileOffsets;
+        info.byteCounts = tileByteCounts;
+        if (info.chunkWidth == 0 || info.chunkHeight == 0 ||
+            !ImageWithinDecodeLimits(info.chunkWidth, info.chunkHeight, 0))
+            return CKBITMAPERROR_FILECORRUPTED;
+    }
+    else
+    {
+        CKDWORD rows = rowsPerStrip.count ? TIFF_ArrayValue(info, rowsPerStrip, 0) : info.height;
+        if (rows == 0)
+            return CKBITMAPERROR_FILECORRUPTED;
+        info.chunkWidth = info.width;
+        info.chunkHeight = (rows < info.height) ? rows : info.height;
+        info.offsets = stripOffsets;
+        info.byteCounts = stripByteCounts;
+    }
+    info.chunksAcross = (CKDWORD)(((unsigned long long)info.width + info.chunkWidth - 1) / info.chunkWidth);
+    info.chunksDown = (CKDWORD)(((unsigned long long)info.height + info.chunkHeight - 1) / info.chunkHeight);
+    unsigned long long chunkCount = (unsigned long long)info.chunksAcross * info.chunksDown * info.planes;
+    if (info.offsets.count < chunkCount || info.byteCounts.count < chunkCount)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // The color map holds all reds, then all greens, then all blues
+    for (CKDWORD i = 0; i < 256; i++)
+        info.palette[i] = 0xFF000000;
+    if (info.photometric == TIFF_PHOTOMETRIC_PALETTE)
+    {
+        CKDWORD n = 1u << bps;
+        for (CKDWORD i = 0; i < n; i++)
+        {
+            CKDWORD r = TIFF_ArrayValue(info, colorMap, i) >> 8;
+            CKDWORD g = TIFF_ArrayValue(info, colorMap, n + i) >> 8;
+            CKDWORD b = TIFF_ArrayValue(info, colorMap, 2 * n + i) >> 8;
+            info.palette[i] = 0xFF000000 | (r << 16) | (g << 8) | b;
+        }
+    }
+    return 0;
+}
+
+//=============================================================================
+// Decompression
+//=============================================================================
+CKDWORD TIFF_UnpackBits(const CKBYTE *src, CKDWORD srcSize, CKBYTE *dst, CKDWORD dstSize)
+{
+    CKDWORD in = 0;
+    CKDWORD out = 0;
+    while (in < srcSize && out < dstSize)
+    {
+        int n = (signed char)src[in++];
+        if (n >= 0)
+        {
+            // n + 1 literal bytes
+            CKDWORD count = (CKDWORD)n + 1;
+            if (count > srcSize - in)
+                count = srcSize - in;
+            if (count > dstSize - out)
+                count = dstSize - out;
+            memcpy(dst + out, src + in, count);
+            in += (CKDWORD)n + 1;
+            out += count;
+        }
+        else if (n != -128)
+        {
+            // The next byte repeated 1 - n times; -128 is a no-op
+            if (in >= srcSize)
+                break;
+            CKDWORD count = (CKDWORD)(1 - n);
+            if (count > dstSize - out)
+                count = dstSize - out;
+            memset(dst + out, src[in++], count);
+            out += count;
+        }
+    }
+    return out;
+}
+
+//=============================================================================
+// Chunk Decoding
+//=============================================================================
+struct TiffDecodeJob
+{
+    const TiffImageInfo *info;
+    const CKBYTE *data;
+    CKDWORD size;
+    CKDWORD chunkSamples; // samples per pixel within a chunk
+    CKDWORD rowBytes;     // bytes per chunk row
+    CKDWORD chunkBytes;   // bytes per decoded chunk (full rows of the full chunk height)
+    CKBOOL wide;          // samples are kept as 16 bits
+    CKBYTE *samples;      // interleaved samples of the whole image, 1 or 2 bytes each
+    int *errors;
+};
+
+// Per-range scratch buffers
+struct TiffScratch
+{
+    CKBYTE *chunk;  // chunkBytes
+    CKBYTE *row;    // rowBytes, for the float predictor
+    CKBYTE *narrow; // chunkWidth bytes, for narrowing planar samples
+};
+
+static void SwapBytes(CKBYTE *p, CKDWORD size, CKDWORD width)
+{
+    if (width == 2)
+    {
+        for (CKDWORD i = 0; i + 1 < size; i += 2)
+        {
+            CKBYTE t = p[i];
+            p[i] = p[i + 1];
+            p[i + 1] = t;
+        }
+    }
+    else
+    {
+        for (CKDWORD i = 0; i + 3 < size; i += 4)
+        {
+            CKBYTE t0 = p[i], t1 = p[i + 1];
+            p[i] = p[i + 3];
+            p[i + 1] = p[i + 2];
+            p[i + 2] = t1;
+            p[i + 3] = t0;
+        }
+    }
+}
+
+// Undoes the predictor on one row of count samples (host byte order)
+static void UndoPredictor(const TiffDecodeJob &job, CKBYTE *row, CKBYTE *tmp)
+{
+    const TiffImageInfo &info = *job.info;
+    CKDWORD stride = job.chunkSamples;
+    CKDWORD count = info.chunkWidth * stride;
+    if (info.predictor == TIFF_PREDICTOR_HORIZONTAL)
+    {
+        if (info.bitsPerSample == 8)
+        {
+            for (CKDWORD i = stride; i < count; i++)
+                row[i] = (CKBYTE)(row[i] + row[i - stride]);
+        }
+        else
+        {
+            CKWORD *row16 = (CKWORD *)row;
+            for (CKDWORD i = stride; i < count; i++)
+                row16[i] = (CKWORD)(row16[i] + row16[i - stride]);
+        }
+    }
+    else
+    {
+        // Bytes are differenced across the row, which holds the most
+        // significant bytes of all samples first, then the next bytes, ...
+        CKDWORD bytes = count * 4;
+        for (CKDWORD i = stride; i < bytes; i++)
+            row[i] = (CKBYTE)(row[i] + row[i - stride]);
+        for (CKDWORD i = 0; i < count; i++)
+        {
+            tmp[i * 4 + 0] = row[3 * count + i];
+            tmp[i * 4 + 1] = row[2 * count + i];
+            tmp[i * 4 + 2] = row[count + i];
+            tmp[i * 4 + 3] = row[i];
+        }
+        memcpy(row, tmp, bytes);
+    }
+}
+
+// Writes count samples of a chunk row to the sample image, step samples apart
+static void StoreSamples(const TiffDecodeJob &job, const CKBYTE *src, CKDWORD count, CKBYTE *dst, CKDWORD step,
+                         CKBYTE *narrow)
+{
+    const TiffImageInfo &info = *job.info;
+    CKDWORD bps = info.bitsPerSample;
+    if (bps < 8)
+    {
+        // Packed MSB first; gray levels are scaled to 0..255, palette indices kept
+        CKDWORD mask = (1u << bps) - 1;
+        CKBOOL scale = (info.photometric != TIFF_PHOTOMETRIC_PALETTE);
+        for (CKDWORD i = 0; i < count; i++)
+        {
+            CKDWORD bit = i * bps;
+            CKDWORD v = (src[bit >> 3] >> (8 - bps - (bit & 7))) & mask;
+            dst[i * step] = (CKBYTE)(scale ? v * 255 / mask : v);
+        }
+        return;
+    }
+
+    if (bps == 8 || job.wide)
+    {
+        CKDWORD sampleBytes = bps / 8;
+        if (step == 1)
+        {
+            memcpy(dst, src, count * sampleBytes);
+        }
+        else if (sampleBytes == 1)
+        {
+            for (CKDWORD i = 0; i < count; i++)
+                dst[i * step] = src[i];
+        }
+        else
+        {
+            const CKWORD *src16 = (const CKWORD *)src;
+            CKWORD *dst16 = (CKWORD *)dst;
+            for (CKDWORD i = 0; i < count; i++)
+                dst16[i * step] = src16[i];
+        }
+        return;
+    }
+
+    // 16-bit and float samples are narrowed straight into place when they
+    // are contiguous, through the scratch row otherwise
+    CKBYTE *out = (step == 1) ? dst : narrow;
+    if (bps == 16)
+        ImageNarrow16To8((const CKWORD *)src, out, (int)count);
+    else
+        ImageFloatTo8((const float *)src, out, (int)count);
+    if (step != 1)
+    {
+        for (CKDWORD i = 0; i < count; i++)
+            dst[i * step] = narrow[i];
+    }
+}
+
+static int DecodeChunk(const TiffDecodeJob &job, CKDWORD index, TiffScratch &scratch)
+{
+    const TiffImageInfo &info = *job.info;
+    CKDWORD perPlane = info.chunksAcross * info.chunksDown;
+    CKDWORD plane = index / perPlane;
+    CKDWORD cy = (index % perPlane) / info.chunksAcross;
+    CKDWORD cx = (index % perPlane) % info.chunksAcross;
+    CKDWORD x0 = cx * info.chunkWidth;
+    CKDWORD y0 = cy * info.chunkHeight;
+    CKDWORD w = (info.width - x0 < info.chunkWidth) ? info.width - x0 : info.chunkWidth;
+    CKDWORD h = (info.height - y0 < info.chunkHeight) ? info.height - y0 : info.chunkHeight;
+
+    CKDWORD offset = TIFF_ArrayValue(info, info.offsets, index);
+    CKDWORD count = TIFF_ArrayValue(info, info.byteCounts, index);
+    if (offset > job.size || count > job.size - offset)
+        return CKBITMAPERROR_FILECORRUPTED;
+    const CKBYTE *src = job.data + offset;
+
+    // Short chunks decode as zeros past their end
+    CKDWORD needed = job.rowBytes * h;
+    CKBOOL swap = info.bigEndian && info.bitsPerSample > 8 && info.predictor != TIFF_PREDICTOR_FLOAT;
+    const CKBYTE *pixels = scratch.chunk;
+    CKDWORD written = 0;
+    switch (info.compression)
+    {
+    case TIFF_COMPRESSION_NONE:
+        if (!swap && info.predictor == TIFF_PREDICTOR_NONE && count >= needed && ((size_t)src & 3) == 0)
+        {
+            pixels = src;
+            written = needed;
+        }
+        else
+        {
+            written = (count < job.chunkBytes) ? count : job.chunkBytes;
+            memcpy(scratch.chunk, src, written);
+        }
+        break;
+    case TIFF_COMPRESSION_PACKBITS:
+        written = TIFF_UnpackBits(src, count, scratch.chunk, job.chunkBytes);
+        break;
+    case TIFF_COMPRESSION_LZW:
+        // Old-style LZW (LSB first, from before TIFF 6.0) starts with a clear code in the low bits
+        if (count >= 2 && src[0] == 0 && (src[1] & 1))
+            return CKBITMAPERROR_UNSUPPORTEDFILE;
+        written = ImageLzwDecodeTiff(src, count, scratch.chunk, job.chunkBytes);
+        break;
+    default:
+        if (!ImageZlibInflate(src, count, scratch.chunk, job.chunkBytes, &written))
+            return CKBITMAPERROR_FILECORRUPTED;
+        break;
+    }
+    if (pixels == scratch.chunk && written < needed)
+        memset(scratch.chunk + written, 0, needed - written);
+
+    CKDWORD sampleBytes = job.wide ? 2 : 1;
+    CKDWORD spp = info.samplesPerPixel;
+    CKDWORD step = (info.planes == 1) ? 1 : spp;
+    CKDWORD rowCount = w * job.chunkSamples;
+    for (CKDWORD y = 0; y < h; y++)
+    {
+        CKBYTE *row = (CKBYTE *)pixels + y * job.rowBytes;
+        if (pixels == scratch.chunk)
+        {
+            if (swap)
+                SwapBytes(row, job.rowBytes, info.bitsPerSample / 8);
+            if (info.predictor != TIFF_PREDICTOR_NONE)
+                UndoPredictor(job, row, scratch.row);
+        }
+        size_t dstIndex = ((size_t)(y0 + y) * info.width + x0) * spp + plane;
+        StoreSamples(job, row, rowCount, job.samples + dstIndex * sampleBytes, step, scratch.narrow);
+    }
+    return 0;
+}
+
+static void DecodeChunks(void *context, CKDWORD begin, CKDWORD end)
+{
+    const TiffDecodeJob &job = *(const TiffDecodeJob *)context;
+    TiffScratch scratch;
+    scratch.chunk = new CKBYTE[job.chunkBytes];
+    scratch.row = new CKBYTE[job.rowBytes];
+    scratch.narrow = new CKBYTE[job.info->chunkWidth];
+    for (CKDWORD i = begin; i < end; i++)
+        job.errors[i] = DecodeChunk(job, i, scratch);
+    delete[] scratch.narrow;
+    delete[] scratch.row;
+    delete[] scratch.chunk;
+}
+
+//=============================================================================
+// Color Conversion
+//=============================================================================
+struct TiffConvertJob
+{
+    const TiffImageInfo *info;
+    const CKBYTE *samples;
+    CKBYTE *dst;
+    int dstStride;
+    CKBOOL wide;
+    CKBOOL indexed;
+};
+
+// Converts one row of samples to BGRA, with T the sample and channel type
+// (CKBYTE for BGRA32, CKWORD for BGRA64)
+template <class T>
+static void ConvertRow(const TiffImageInfo &info, const T *src, CKDWORD width, T *dst)
+{
+    const CKDWORD maxValue = (T)~0;
+    CKDWORD spp = info.samplesPerPixel;
+    for (CKDWORD x = 0; x < width; x++, src += spp, dst += 4)
+    {
+        CKDWORD r, g, b;
+        switch (info.photometric)
+        {
+        case TIFF_PHOTOMETRIC_MIN_IS_WHITE:
+            r = g = b = maxValue - src[0];
+            break;
+        case TIFF_PHOTOMETRIC_RGB:
+            r = src[0];
+            g = src[1];
+            b = src[2];
+            break;
+        case TIFF_PHOTOMETRIC_SEPARATED:
+        {
+            CKDWORD k = maxValue - src[3];
+            r = (maxValue - src[0]) * k / maxValue;
+            g = (maxValue - src[1]) * k / maxValue;
+            b = (maxValue - src[2]) * k / maxValue;
+            break;
+        }
+        default:
+            r = g = b = src[0];
+            break;
+        }
+
+        CKDWORD a = info.alphaType ? (CKDWORD)src[info.colorSamples] : maxValue;
+        if (info.alphaType == TIFF_EXTRA_ASSOCIATED_ALPHA && a != maxValue)
+        {
+            if (a == 0)
+            {
+                r = g = b = 0;
+            }
+            else
+            {
+                r = (r * maxValue + a / 2) / a;
+                g = (g * maxValue + a / 2) / a;
+                b = (b * maxValue + a / 2) / a;
+                r = (r > maxValue) ? maxValue : r;
+                g = (g > maxValue) ? maxValue : g;
+                b = (b > maxValue) ? maxValue : b;
+            }
+        }
+        dst[0] = (T)b;
+        dst[1] = (T)g;
+        dst[2] = (T)r;
+        dst[3] = (T)a;
+    }
+}
+
+static void ConvertRows(void *context, CKDWORD begin, CKDWORD end)
+{
+    const TiffConvertJob &job = *(const TiffConvertJob *)context;
+    const TiffImageInfo &info = *job.info;
+    CKDWORD spp = info.samplesPerPixel;
+    size_t srcStride = (size_t)info.width * spp * (job.wide ? 2 : 1);
+    for (CKDWORD y = begin; y < end; y++)
+    {
+        const CKBYTE *src = job.samples + y * srcStride;
+        CKBYTE *dst = job.dst + (size_t)y * job.dstStride;
+        if (job.wide)
+        {
+            ConvertRow<CKWORD>(info, (const CKWORD *)src, info.width, (CKWORD *)dst);
+        }
+        else if (info.photometric == TIFF_PHOTOMETRIC_PALETTE)
+        {
+            CKDWORD *dst32 = (CKDWORD *)dst;
+            for (CKDWORD x = 0; x < info.width; x++)
+            {
+                if (job.indexed)
+                    dst[x] = src[x * spp];
+                else
+                    dst32[x] = info.palette[src[x * spp]];
+            }
+        }
+        else if (info.photometric == TIFF_PHOTOMETRIC_RGB && spp == 3)
+        {
+            ImageRGBToBGRA32(src, dst, (int)info.width);
+        }
+        else if (info.photometric == TIFF_PHOTOMETRIC_RGB && spp == 4 && info.alphaType == TIFF_EXTRA_UNASSOCIATED_ALPHA)
+        {
+            ImageRGBAToBGRA32(src, dst, (int)info.width);
+        }
+        else
+        {
+            ConvertRow<CKBYTE>(info, src, info.width, dst);
+        }
+    }
+}
+
+//=============================================================================
+// TiffReader Class Implementation
+//=============================================================================
+TiffReader::TiffReader() : ImageReader(), m_ReadFlags(0)
+{
+    m_Properties.Init(TIFFREADER_GUID, "tif");
+}
+
+TiffReader::~TiffReader()
+{
+    FreeBitmapData(&m_Properties);
+}
+
+CKPluginInfo *TiffReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_TIFF];
+}
+
+void TiffReader::SetReadFlags(CKDWORD flags) { m_ReadFlags = flags; }
+
+CKDWORD TiffReader::GetReadFlags() { return m_ReadFlags; }
+
+int TiffReader::GetOptionsCount() { return 0; }
+
+CKSTRING TiffReader::GetOptionDescription(int i) { return ""; }
+
+int TiffReader::ReadFile(CKSTRING filename, CKBitmapProperties **bp)
+{
+    if (!filename || !bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_TIFF, (void *)filename, 0, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int TiffReader::ReadMemory(void *memory, int size, CKBitmapProperties **bp)
+{
+    if (!bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_TIFF, memory, size, (CKBitmapProperties *)&m_Properties, m_ReadFlags);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int TiffReader::ReadOwnFormat(void *data, int size, CKBitmapProperties *props)
+{
+    return TIFF_Read(data, size, props, m_ReadFlags);
+}
+
+//=============================================================================
+// TIFF_Read - Core Reading Function
+//=============================================================================
+int TIFF_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags)
+{
+    if (!data || !props)
+        return CKBITMAPERROR_GENERIC;
+    if (size < 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // Files are mapped so strips and tiles are decompressed straight from the mapping
+    ImageFileMap fileMap;
+    if (size == 0)
+    {
+        if (!fileMap.Open((const char *)data))
+            return CKBITMAPERROR_READERROR;
+        data = (void *)fileMap.Data();
+        size = (int)fileMap.Size();
+    }
+
+    const CKBYTE *bytes = (const CKBYTE *)data;
+    CKDWORD fileSize = (CKDWORD)size;
+    TiffImageInfo info;
+    int result = TIFF_ReadInfo(bytes, fileSize, info);
+    if (result != 0)
+        return result;
+
+    CKBOOL indexed = (readFlags & IMAGE_READ_KEEP_INDICES) && info.photometric == TIFF_PHOTOMETRIC_PALETTE;
+    CKBOOL wide = (readFlags & IMAGE_READ_KEEP_16BIT) && info.bitsPerSample == 16;
+
+    // Chunks are decoded whole rows at a time, at their full height
+    CKDWORD chunkSamples = (info.planes == 1) ? info.samplesPerPixel : 1;
+    uint64_t rowBytes64 = ((uint64_t)info.chunkWidth * chunkSamples * info.bitsPerSample + 7) / 8;
+    uint64_t chunkBytes64 = rowBytes64 * info.chunkHeight;
+    uint64_t samplesSize64 = (uint64_t)info.width * info.height * info.samplesPerPixel * (wide ? 2 : 1);
+    uint64_t dstStride64 = indexed ? (uint64_t)ImageReader::Indexed8Stride((int)info.width)
+                                   : (uint64_t)info.width * (wide ? 8 : 4);
+    CKDWORD paletteSize = indexed ? 256 * 4 : 0;
+    if (chunkBytes64 > 0x7FFFFFFFULL || samplesSize64 > 0x7FFFFFFFULL ||
+        !ImageWithinDecodeLimits(info.width, info.height, dstStride64 * info.height + paletteSize))
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    CKDWORD chunkCount = info.chunksAcross * info.chunksDown * info.planes;
+    int *errors = new int[chunkCount];
+    CKBYTE *samples = new CKBYTE[(size_t)samplesSize64];
+    TiffDecodeJob decodeJob;
+    decodeJob.info = &info;
+    decodeJob.data = bytes;
+    decodeJob.size = fileSize;
+    decodeJob.chunkSamples = chunkSamples;
+    decodeJob.rowBytes = (CKDWORD)rowBytes64;
+    decodeJob.chunkBytes = (CKDWORD)chunkBytes64;
+    decodeJob.wide = wide;
+    decodeJob.samples = samples;
+    decodeJob.errors = errors;
+    ImageParallelFor(chunkCount, 1, DecodeChunks, &decodeJob);
+
+    for (CKDWORD i = 0; i < chunkCount && result == 0; i++)
+        result = errors[i];
+    delete[] errors;
+    if (result != 0)
+    {
+        delete[] samples;
+        return result;
+    }
+
+    // Allocate destination. Index images carry their palette at the start of the block.
+    int dstStride = (int)dstStride64;
+    CKBYTE *dstBlock = new CKBYTE[(size_t)dstStride64 * info.height + paletteSize];
+    CKBYTE *dstPixels = dstBlock + paletteSize;
+    TiffConvertJob convertJob;
+    convertJob.info = &info;
+    convertJob.samples = samples;
+    convertJob.dst = dstPixels;
+    convertJob.dstStride = dstStride;
+    convertJob.wide = wide;
+    convertJob.indexed = indexed;
+    ImageParallelFor(info.height, 64, ConvertRows, &convertJob);
+    delete[] samples;
+
+    // Fill properties
+    if (indexed)
+    {
+        // Palette entries are BGRA in memory order
+        memcpy(dstBlock, info.palette, paletteSize);
+        ImageReader::FillFormatIndexed8(props->m_Format, (int)info.width, (int)info.height, dstStride, dstPixels,
+                                        dstBlock, 1 << info.bitsPerSample);
+    }
+    else if (wide)
+    {
+        ImageReader::FillFormatBGRA64(props->m_Format, (int)info.width, (int)info.height, dstStride, dstPixels);
+    }
+    else
+    {
+        ImageReader::FillFormatBGRA32(props->m_Format, (int)info.width, (int)info.height, dstStride, dstPixels);
+    }
+    props->m_Data = dstBlock;
+
+    if (props->m_Size == sizeof(TiffBitmapProperties))
+    {
+        ((TiffBitmapProperties *)props)->m_BitsPerSample = info.bitsPerSample;
+        ((TiffBitmapProperties *)props)->m_SamplesPerPixel = info.samplesPerPixel;
+    }
+    return 0;
+}
@@ -0,0 +1,162 @@
+#ifndef TIFFREADER_H
+#define TIFFREADER_H
+
+#include "ImageReader.h"
+
+// TIFF Reader GUID
+#define TIFFREADER_GUID CKGUID(0x2A7D5F31, 0x6E04B9C8)
+
+/**
+ * TiffReader - Tagged Image File Format reader
+ *
+ *   - Baseline TIFF plus LZW and Deflate: uncompressed, PackBits, LZW and
+ *     Deflate strips or tiles, with the horizontal and floating point predictors
+ *   - Gray, palette, RGB and CMYK images, chunky or planar, with 1/2/4/8/16-bit
+ *     integer or 32-bit floating point samples and an optional alpha sample
+ *   - The file is mapped and strips/tiles are decompressed on the worker pool
+ *     (ImageParallelFor); 16-bit and float samples are narrowed with SIMD
+ *   - Decoded to BGRA32; with IMAGE_READ_KEEP_16BIT, 16-bit images are
+ *     returned as BGRA64 and with IMAGE_READ_KEEP_INDICES, palette images as
+ *     8-bit indices plus palette
+ *   - Only the first image of the file is read; JPEG, CCITT fax, YCbCr and
+ *     BigTIFF files are not supported
+ *   - Read-only: SaveFile and SaveMemory return 0
+ */
+class TiffReader : public ImageReader
+{
+public:
+    TiffReader();
+    virtual ~TiffReader();
+
+    virtual CKPluginInfo *GetReaderInfo();
+    virtual int GetOptionsCount();
+    virtual CKSTRING GetOptionDescription(int i);
+
+    virtual int ReadFile(CKSTRING filename, CKBitmapProperties **bp);
+    virtual int ReadMemory(void *memory, int size, CKBitmapProperties **bp);
+
+    // IMAGE_READ_* flags applied by ReadFile/ReadMemory (default 0)
+    void SetReadFlags(CKDWORD flags);
+    CKDWORD GetReadFlags();
+
+protected:
+    virtual int ReadOwnFormat(void *data, int size, CKBitmapProperties *props);
+
+private:
+    TiffBitmapProperties m_Properties;
+    CKDWORD m_ReadFlags;
+};
+
+//=============================================================================
+// TIFF file format
+//=============================================================================
+#define TIFF_HEADER_SIZE 8
+#define TIFF_MAGIC 42
+#define TIFF_ENTRY_SIZE 12
+
+// Tags
+#define TIFF_TAG_IMAGE_WIDTH 256
+#define TIFF_TAG_IMAGE_LENGTH 257
+#define TIFF_TAG_BITS_PER_SAMPLE 258
+#define TIFF_TAG_COMPRESSION 259
+#define TIFF_TAG_PHOTOMETRIC 262
+#define TIFF_TAG_FILL_ORDER 266
+#define TIFF_TAG_STRIP_OFFSETS 273
+#define TIFF_TAG_SAMPLES_PER_PIXEL 277
+#define TIFF_TAG_ROWS_PER_STRIP 278
+#define TIFF_TAG_STRIP_BYTE_COUNTS 279
+#define TIFF_TAG_PLANAR_CONFIG 284
+#define TIFF_TAG_PREDICTOR 317
+#define TIFF_TAG_COLOR_MAP 320
+#define TIFF_TAG_TILE_WIDTH 322
+#define TIFF_TAG_TILE_LENGTH 323
+#define TIFF_TAG_TILE_OFFSETS 324
+#define TIFF_TAG_TILE_BYTE_COUNTS 325
+#define TIFF_TAG_EXTRA_SAMPLES 338
+#define TIFF_TAG_SAMPLE_FORMAT 339
+
+// Field types
+#define TIFF_TYPE_BYTE 1
+#define TIFF_TYPE_SHORT 3
+#define TIFF_TYPE_LONG 4
+
+// Compression schemes
+#define TIFF_COMPRESSION_NONE 1
+#define TIFF_COMPRESSION_LZW 5
+#define TIFF_COMPRESSION_DEFLATE 8
+#define TIFF_COMPRESSION_ADOBE_DEFLATE 32946
+#define TIFF_COMPRESSION_PACKBITS 32773
+
+// Photometric interpretations
+#define TIFF_PHOTOMETRIC_MIN_IS_WHITE 0
+#define TIFF_PHOTOMETRIC_MIN_IS_BLACK 1
+#define TIFF_PHOTOMETRIC_RGB 2
+#define TIFF_PHOTOMETRIC_PALETTE 3
+#define TIFF_PHOTOMETRIC_SEPARATED 5 // CMYK
+
+// Predictors
+#define TIFF_PREDICTOR_NONE 1
+#define TIFF_PREDICTOR_HORIZONTAL 2
+#define TIFF_PREDICTOR_FLOAT 3
+
+// Extra sample meanings
+#define TIFF_EXTRA_ASSOCIATED_ALPHA 1
+#define TIFF_EXTRA_UNASSOCIATED_ALPHA 2
+
+#define TIFF_SAMPLE_FORMAT_UINT 1
+#define TIFF_SAMPLE_FORMAT_FLOAT 3
+
+#define TIFF_MAX_SAMPLES 16
+
+// Array of tag values, read on demand from the file bytes
+struct TiffArray
+{
+    const CKBYTE *data;
+    CKDWORD type;
+    CKDWORD count;
+};
+
+// First image of a TIFF file. Chunks are the strips or tiles, one set per
+// sample plane with planar configuration 2, numbered plane by plane in rows.
+struct TiffImageInfo
+{
+    CKBOOL bigEndian;
+    CKDWORD width;
+    CKDWORD height;
+    CKDWORD bitsPerSample;
+    CKDWORD samplesPerPixel;
+    CKDWORD sampleFormat;
+    CKDWORD compression;
+    CKDWORD photometric;
+    CKDWORD predictor;
+    CKDWORD planes;        // 1 (chunky) or samplesPerPixel (planar)
+    CKDWORD colorSamples;  // 1 gray or palette, 3 RGB, 4 CMYK
+    CKDWORD alphaType;     // 0 or TIFF_EXTRA_*_ALPHA; alpha follows the color samples
+    CKBOOL tiled;
+    CKDWORD chunkWidth;    // image width for strips
+    CKDWORD chunkHeight;   // rows per strip, clamped to the image height
+    CKDWORD chunksAcross;
+    CKDWORD chunksDown;
+    TiffArray offsets;
+    TiffArray byteCounts;
+    CKDWORD palette[256];  // BGRA, palette images only
+};
+
+//=============================================================================
+// Internal helper functions
+//=============================================================================
+
+// Parses the header and the first IFD; fails on anything the decoder does not
+// support. The tag arrays point into data, which must outlive info.
+int TIFF_ReadInfo(const CKBYTE *data, CKDWORD size, TiffImageInfo &info);
+
+// Value i of a tag array (BYTE, SHORT or LONG)
+CKDWORD TIFF_ArrayValue(const TiffImageInfo &info, const TiffArray &array, CKDWORD i);
+
+// Expands PackBits data into dst; returns the number of bytes written
+CKDWORD TIFF_UnpackBits(const CKBYTE *src, CKDWORD srcSize, CKBYTE *dst, CKDWORD dstSize);
+
+// Core TIFF read function (size == 0 means data is a filename)
+int TIFF_Read(void *data, int size, CKBitmapProperties *props, CKDWORD readFlags = 0);
+
+#endif // TIFFREADER_H
@@ -0,0 +1,37 @@
+#ifndef WEBPCODEC_H
+#define WEBPCODEC_H
+
+#include "ImageReader.h"
+
+//=============================================================================
+// WebP bitstream decoders
+//
+// VP8L (lossless): LZ77 with a color cache over ARGB pixels, coded with
+// canonical prefix codes that may change across the image, then up to four
+// inverse transforms (predictor, color, subtract green, color indexing).
+// VP8 (lossy): the key frame of a VP8 video stream, 4:2:0 YUV.
+// Both follow libwebp, the reference decoder, and give its output exactly.
+//=============================================================================
+
+#define WEBP_VP8L_SIGNATURE 0x2F
+#define WEBP_VP8L_HEADER_SIZE 5
+#define WEBP_VP8_HEADER_SIZE 10
+
+// Reads the 5-byte header of a VP8L bitstream
+int WEBP_ReadLosslessHeader(const CKBYTE *data, CKDWORD size, CKDWORD &width, CKDWORD &height, CKBOOL &hasAlpha);
+
+// Decodes a VP8L bitstream (header included) into width x height pixels as
+// 0xAARRGGBB words, which is BGRA32 in memory on little-endian machines
+int WEBP_DecodeLossless(const CKBYTE *data, CKDWORD size, CKDWORD *argb);
+
+// Decodes the headerless VP8L stream of an ALPH chunk; the green channel of
+// each pixel is the alpha value written to alpha (one byte per pixel)
+int WEBP_DecodeLosslessAlpha(const CKBYTE *data, CKDWORD size, CKDWORD width, CKDWORD height, CKBYTE *alpha);
+
+// Reads the 10-byte header of a VP8 key frame
+int WEBP_ReadLossyHeader(const CKBYTE *data, CKDWORD size, CKDWORD &width, CKDWORD &height);
+
+// Decodes a VP8 key frame into BGRA32 rows stride bytes apart (alpha 255)
+int WEBP_DecodeLossy(const CKBYTE *data, CKDWORD size, CKBYTE *bgra, int stride);
+
+#endif // WEBPCODEC_H
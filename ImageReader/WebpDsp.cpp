@@ -0,0 +1,1019 @@
+#include "WebpDsp.h"
+#include "ImageSimd.h"
+#include "ImageThreadPool.h"
+
+#include <emmintrin.h>
+
+//=============================================================================
+// Helpers
+//=============================================================================
+static inline CKBYTE ClampByte(int v) { return (CKBYTE)(v < 0 ? 0 : (v > 255 ? 255 : v)); }
+
+static inline int Clamp(int v, int lo, int hi) { return v < lo ? lo : (v > hi ? hi : v); }
+
+static inline int Abs(int v) { return v < 0 ? -v : v; }
+
+//=============================================================================
+// VP8 Inverse Transform
+//
+// The 4x4 integer DCT of RFC 6386: 20091/65536 + 1 and 35468/65536 are
+// sqrt(2) * cos(pi/8) and sqrt(2) * sin(pi/8). Columns first, then rows with
+// the final rounding; the values fit in 16 bits for any coefficient a VP8
+// encoder can produce, which the SSE2 version relies on.
+//=============================================================================
+static inline int Mul1(int a) { return ((a * 20091) >> 16) + a; }
+
+static inline int Mul2(int a) { return (a * 35468) >> 16; }
+
+static void TransformScalar(const short *coefs, CKBYTE *dst, int stride)
+{
+    int tmp[16];
+    for (int i = 0; i < 4; i++)
+    {
+        const short *in = coefs + i;
+        int a = in[0] + in[8];
+        int b = in[0] - in[8];
+        int c = Mul2(in[4]) - Mul1(in[12]);
+        int d = Mul1(in[4]) + Mul2(in[12]);
+        tmp[i * 4 + 0] = a + d;
+        tmp[i * 4 + 1] = b + c;
+        tmp[i * 4 + 2] = b - c;
+        tmp[i * 4 + 3] = a - d;
+    }
+    for (int i = 0; i < 4; i++, dst += stride)
+    {
+        const int *t = tmp + i;
+        int dc = t[0] + 4;
+        int a = dc + t[8];
+        int b = dc - t[8];
+        int c = Mul2(t[4]) - Mul1(t[12]);
+        int d = Mul1(t[4]) + Mul2(t[12]);
+        dst[0] = ClampByte(dst[0] + ((a + d) >> 3));
+        dst[1] = ClampByte(dst[1] + ((b + c) >> 3));
+        dst[2] = ClampByte(dst[2] + ((b - c) >> 3));
+        dst[3] = ClampByte(dst[3] + ((a - d) >> 3));
+    }
+}
+
+// Transposes the low 64 bits (four 16-bit values) of four rows
+static inline void Transpose4x4SSE2(__m128i &r0, __m128i &r1, __m128i &r2, __m128i &r3)
+{
+    __m128i t0 = _mm_unpacklo_epi16(r0, r1);
+    __m128i t1 = _mm_unpacklo_epi16(r2, r3);
+    r0 = _mm_unpacklo_epi32(t0, t1);
+    r2 = _mm_unpackhi_epi32(t0, t1);
+    r1 = _mm_unpackhi_epi64(r0, r0);
+    r3 = _mm_unpackhi_epi64(r2, r2);
+}
+
+// One pass of the transform over four 16-bit lanes. Mul1 is exact with
+// mulhi; 35468 does not fit a signed 16-bit constant, so Mul2 multiplies by
+// 35468 - 65536 and adds the input back.
+static inline void TransformPassSSE2(__m128i in0, __m128i in1, __m128i in2, __m128i in3, __m128i &out0,
+                                     __m128i &out1, __m128i &out2, __m128i &out3)
+{
+    const __m128i k1 = _mm_set1_epi16(20091);
+    const __m128i k2 = _mm_set1_epi16(-30068);
+    __m128i a = _mm_add_epi16(in0, in2);
+    __m128i b = _mm_sub_epi16(in0, in2);
+    __m128i mul1In1 = _mm_add_epi16(_mm_mulhi_epi16(in1, k1), in1);
+    __m128i mul2In1 = _mm_add_epi16(_mm_mulhi_epi16(in1, k2), in1);
+    __m128i mul1In3 = _mm_add_epi16(_mm_mulhi_epi16(in3, k1), in3);
+    __m128i mul2In3 = _mm_add_epi16(_mm_mulhi_epi16(in3, k2), in3);
+    __m128i c = _mm_sub_epi16(mul2In1, mul1In3);
+    __m128i d = _mm_add_epi16(mul1In1, mul2In3);
+    out0 = _mm_add_epi16(a, d);
+    out1 = _mm_add_epi16(b, c);
+    out2 = _mm_sub_epi16(b, c);
+    out3 = _mm_sub_epi16(a, d);
+}
+
+static void TransformSSE2(const short *coefs, CKBYTE *dst, int stride)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i r0 = _mm_loadl_epi64((const __m128i *)(coefs + 0));
+    __m128i r1 = _mm_loadl_epi64((const __m128i *)(coefs + 4));
+    __m128i r2 = _mm_loadl_epi64((const __m128i *)(coefs + 8));
+    __m128i r3 = _mm_loadl_epi64((const __m128i *)(coefs + 12));
+
+    // Columns (one per lane), then rows (one per lane after the transpose)
+    __m128i t0, t1, t2, t3;
+    TransformPassSSE2(r0, r1, r2, r3, t0, t1, t2, t3);
+    Transpose4x4SSE2(t0, t1, t2, t3);
+    t0 = _mm_add_epi16(t0, _mm_set1_epi16(4));
+    TransformPassSSE2(t0, t1, t2, t3, r0, r1, r2, r3);
+    r0 = _mm_srai_epi16(r0, 3);
+    r1 = _mm_srai_epi16(r1, 3);
+    r2 = _mm_srai_epi16(r2, 3);
+    r3 = _mm_srai_epi16(r3, 3);
+    Transpose4x4SSE2(r0, r1, r2, r3);
+
+    __m128i *rows[4] = {&r0, &r1, &r2, &r3};
+    for (int y = 0; y < 4; y++, dst += stride)
+    {
+        int pixels;
+        memcpy(&pixels, dst, 4);
+        __m128i p = _mm_unpacklo_epi8(_mm_cvtsi32_si128(pixels), zero);
+        p = _mm_packus_epi16(_mm_add_epi16(p, *rows[y]), zero);
+        pixels = _mm_cvtsi128_si32(p);
+        memcpy(dst, &pixels, 4);
+    }
+}
+
+//=============================================================================
+// VP8 Loop Filters
+//
+// thresh bounds 4 * |p0 - q0| + |p1 - q1| (as 2 * thresh + 1), interiorLimit
+// every other step across the edge, and hevThresh selects between the strong
+// filter and the one that only moves p0 and q0 ("high edge variance").
+// Macroblock edges use the 6-tap filter, inner edges the 4-tap one.
+//=============================================================================
+static inline CKBOOL NeedsFilter(const CKBYTE *p, int step, int thresh2)
+{
+    int p1 = p[-2 * step], p0 = p[-step], q0 = p[0], q1 = p[step];
+    return 4 * Abs(p0 - q0) + Abs(p1 - q1) <= thresh2;
+}
+
+static inline CKBOOL NeedsFilter2(const CKBYTE *p, int step, int thresh2, int it)
+{
+    int p3 = p[-4 * step], p2 = p[-3 * step], p1 = p[-2 * step], p0 = p[-step];
+    int q0 = p[0], q1 = p[step], q2 = p[2 * step], q3 = p[3 * step];
+    if (4 * Abs(p0 - q0) + Abs(p1 - q1) > thresh2)
+        return FALSE;
+    return Abs(p3 - p2) <= it && Abs(p2 - p1) <= it && Abs(p1 - p0) <= it && Abs(q3 - q2) <= it &&
+           Abs(q2 - q1) <= it && Abs(q1 - q0) <= it;
+}
+
+static inline CKBOOL HighEdgeVariance(const CKBYTE *p, int step, int thresh)
+{
+    int p1 = p[-2 * step], p0 = p[-step], q0 = p[0], q1 = p[step];
+    return Abs(p1 - p0) > thresh || Abs(q1 - q0) > thresh;
+}
+
+// Moves p0 and q0 (4 pixels in, 2 out)
+static inline void DoFilter2(CKBYTE *p, int step)
+{
+    int p1 = p[-2 * step], p0 = p[-step], q0 = p[0], q1 = p[step];
+    int a = 3 * (q0 - p0) + Clamp(p1 - q1, -128, 127);
+    int a1 = Clamp((a + 4) >> 3, -16, 15);
+    int a2 = Clamp((a + 3) >> 3, -16, 15);
+    p[-step] = ClampByte(p0 + a2);
+    p[0] = ClampByte(q0 - a1);
+}
+
+// Inner edge filter (4 pixels in, 4 out)
+static inline void DoFilter4(CKBYTE *p, int step)
+{
+    int p1 = p[-2 * step], p0 = p[-step], q0 = p[0], q1 = p[step];
+    int a = 3 * (q0 - p0);
+    int a1 = Clamp((a + 4) >> 3, -16, 15);
+    int a2 = Clamp((a + 3) >> 3, -16, 15);
+    int a3 = (a1 + 1) >> 1;
+    p[-2 * step] = ClampByte(p1 + a3);
+    p[-step] = ClampByte(p0 + a2);
+    p[0] = ClampByte(q0 - a1);
+    p[step] = ClampByte(q1 - a3);
+}
+
+// Macroblock edge filter (6 pixels in, 6 out)
+static inline void DoFilter6(CKBYTE *p, int step)
+{
+    int p2 = p[-3 * step], p1 = p[-2 * step], p0 = p[-step];
+    int q0 = p[0], q1 = p[step], q2 = p[2 * step];
+    int a = Clamp(3 * (q0 - p0) + Clamp(p1 - q1, -128, 127), -128, 127);
+    int a1 = (27 * a + 63) >> 7;
+    int a2 = (18 * a + 63) >> 7;
+    int a3 = (9 * a + 63) >> 7;
+    p[-3 * step] = ClampByte(p2 + a3);
+    p[-2 * step] = ClampByte(p1 + a2);
+    p[-step] = ClampByte(p0 + a1);
+    p[0] = ClampByte(q0 - a1);
+    p[step] = ClampByte(q1 - a2);
+    p[2 * step] = ClampByte(q2 - a3);
+}
+
+// hstride crosses the edge, vstride moves along it
+static inline void FilterLoop26(CKBYTE *p, int hstride, int vstride, int size, int thresh, int it, int hevThresh)
+{
+    int thresh2 = 2 * thresh + 1;
+    for (int i = 0; i < size; i++, p += vstride)
+    {
+        if (!NeedsFilter2(p, hstride, thresh2, it))
+            continue;
+        if (HighEdgeVariance(p, hstride, hevThresh))
+            DoFilter2(p, hstride);
+        else
+            DoFilter6(p, hstride);
+    }
+}
+
+static inline void FilterLoop24(CKBYTE *p, int hstride, int vstride, int size, int thresh, int it, int hevThresh)
+{
+    int thresh2 = 2 * thresh + 1;
+    for (int i = 0; i < size; i++, p += vstride)
+    {
+        if (!NeedsFilter2(p, hstride, thresh2, it))
+            continue;
+        if (HighEdgeVariance(p, hstride, hevThresh))
+            DoFilter2(p, hstride);
+        else
+            DoFilter4(p, hstride);
+    }
+}
+
+static void SimpleV16Scalar(CKBYTE *p, int stride, int thresh)
+{
+    int thresh2 = 2 * thresh + 1;
+    for (int i = 0; i < 16; i++)
+        if (NeedsFilter(p + i, stride, thresh2))
+            DoFilter2(p + i, stride);
+}
+
+static void SimpleH16Scalar(CKBYTE *p, int stride, int thresh)
+{
+    int thresh2 = 2 * thresh + 1;
+    for (int i = 0; i < 16; i++)
+        if (NeedsFilter(p + i * stride, 1, thresh2))
+            DoFilter2(p + i * stride, 1);
+}
+
+static void SimpleV16iScalar(CKBYTE *p, int stride, int thresh)
+{
+    for (int k = 1; k < 4; k++)
+        SimpleV16Scalar(p + 4 * k * stride, stride, thresh);
+}
+
+static void SimpleH16iScalar(CKBYTE *p, int stride, int thresh)
+{
+    for (int k = 1; k < 4; k++)
+        SimpleH16Scalar(p + 4 * k, stride, thresh);
+}
+
+static void V16Scalar(CKBYTE *p, int stride, int thresh, int it, int hevThresh)
+{
+    FilterLoop26(p, stride, 1, 16, thresh, it, hevThresh);
+}
+
+static void H16Scalar(CKBYTE *p, int stride, int thresh, int it, int hevThresh)
+{
+    FilterLoop26(p, 1, stride, 16, thresh, it, hevThresh);
+}
+
+static void V16iScalar(CKBYTE *p, int stride, int thresh, int it, int hevThresh)
+{
+    for (int k = 1; k < 4; k++)
+        FilterLoop24(p + 4 * k * stride, stride, 1, 16, thresh, it, hevThresh);
+}
+
+static void H16iScalar(CKBYTE *p, int stride, int thresh, int it, int hevThresh)
+{
+    for (int k = 1; k < 4; k++)
+        FilterLoop24(p + 4 * k, 1, stride, 16, thresh, it, hevThresh);
+}
+
+static void V8Scalar(CKBYTE *u, CKBYTE *v, int stride, int thresh, int it, int hevThresh)
+{
+    FilterLoop26(u, stride, 1, 8, thresh, it, hevThresh);
+    FilterLoop26(v, stride, 1, 8, thresh, it, hevThresh);
+}
+
+static void H8Scalar(CKBYTE *u, CKBYTE *v, int stride, int thresh, int it, int hevThresh)
+{
+    FilterLoop26(u, 1, stride, 8, thresh, it, hevThresh);
+    FilterLoop26(v, 1, stride, 8, thresh, it, hevThresh);
+}
+
+static void V8iScalar(CKBYTE *u, CKBYTE *v, int stride, int thresh, int it, int hevThresh)
+{
+    FilterLoop24(u + 4 * stride, stride, 1, 8, thresh, it, hevThresh);
+    FilterLoop24(v + 4 * stride, stride, 1, 8, thresh, it, hevThresh);
+}
+
+static void H8iScalar(CKBYTE *u, CKBYTE *v, int stride, int thresh, int it, int hevThresh)
+{
+    FilterLoop24(u + 4, 1, stride, 8, thresh, it, hevThresh);
+    FilterLoop24(v + 4, 1, stride, 8, thresh, it, hevThresh);
+}
+
+//-----------------------------------------------------------------------------
+// SSE2: the 16 pixels along an edge are the 16 lanes. Pixels are made signed
+// by flipping the top bit, and saturating byte arithmetic gives the clamps of
+// the scalar code. Vertical edges are transposed into lanes and back.
+//-----------------------------------------------------------------------------
+static inline __m128i AbsDiffSSE2(__m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+}
+
+static inline __m128i FlipSignSSE2(__m128i v) { return _mm_xor_si128(v, _mm_set1_epi8((char)0x80)); }
+
+// Arithmetic shift right by 3 of signed bytes
+static inline __m128i SignedShift3SSE2(__m128i v)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(zero, v), 11);
+    __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(zero, v), 11);
+    return _mm_packs_epi16(lo, hi);
+}
+
+// 4 * |p0 - q0| + |p1 - q1| <= 2 * thresh + 1, evaluated as
+// 2 * |p0 - q0| + |p1 - q1| / 2 <= thresh (the same for integers)
+static inline __m128i NeedsFilterSSE2(__m128i p1, __m128i p0, __m128i q0, __m128i q1, int thresh)
+{
+    __m128i halfOuter = _mm_srli_epi16(_mm_and_si128(AbsDiffSSE2(p1, q1), _mm_set1_epi8((char)0xFE)), 1);
+    __m128i inner = AbsDiffSSE2(p0, q0);
+    __m128i sum = _mm_adds_epu8(_mm_adds_epu8(inner, inner), halfOuter);
+    return _mm_cmpeq_epi8(_mm_subs_epu8(sum, _mm_set1_epi8((char)thresh)), _mm_setzero_si128());
+}
+
+static inline __m128i NotHighEdgeVarianceSSE2(__m128i p1, __m128i p0, __m128i q0, __m128i q1, int hevThresh)
+{
+    __m128i m = _mm_max_epu8(AbsDiffSSE2(p1, p0), AbsDiffSSE2(q1, q0));
+    return _mm_cmpeq_epi8(_mm_subs_epu8(m, _mm_set1_epi8((char)hevThresh)), _mm_setzero_si128());
+}
+
+static inline __m128i ComplexMaskSSE2(__m128i p3, __m128i p2, __m128i p1, __m128i p0, __m128i q0, __m128i q1,
+                                      __m128i q2, __m128i q3, int thresh, int it)
+{
+    __m128i m = _mm_max_epu8(AbsDiffSSE2(p3, p2), AbsDiffSSE2(p2, p1));
+    m = _mm_max_epu8(m, AbsDiffSSE2(p1, p0));
+    m = _mm_max_epu8(m, AbsDiffSSE2(q3, q2));
+    m = _mm_max_epu8(m, AbsDiffSSE2(q2, q1));
+    m = _mm_max_epu8(m, AbsDiffSSE2(q1, q0));
+    __m128i interior = _mm_cmpeq_epi8(_mm_subs_epu8(m, _mm_set1_epi8((char)it)), _mm_setzero_si128());
+    return _mm_and_si128(interior, NeedsFilterSSE2(p1, p0, q0, q1, thresh));
+}
+
+// 3 * (q0 - p0) + (p1 - q1), saturated; inputs are signed. The additions go
+// in an order where saturating early gives the same result as clamping once.
+static inline __m128i BaseDeltaSSE2(__m128i p1, __m128i p0, __m128i q0, __m128i q1)
+{
+    __m128i q0p0 = _mm_subs_epi8(q0, p0);
+    __m128i s = _mm_adds_epi8(_mm_subs_epi8(p1, q1), q0p0);
+    s = _mm_adds_epi8(q0p0, s);
+    return _mm_adds_epi8(q0p0, s);
+}
+
+// DoFilter2 on signed p0 and q0 with the delta a (0 where not filtered)
+static inline void SimpleFilterSSE2(__m128i &p0, __m128i &q0, __m128i a)
+{
+    __m128i a2 = SignedShift3SSE2(_mm_adds_epi8(a, _mm_set1_epi8(3)));
+    __m128i a1 = SignedShift3SSE2(_mm_adds_epi8(a, _mm_set1_epi8(4)));
+    q0 = _mm_subs_epi8(q0, a1);
+    p0 = _mm_adds_epi8(p0, a2);
+}
+
+static inline void DoFilter2SSE2(__m128i p1, __m128i &p0, __m128i &q0, __m128i q1, int thresh)
+{
+    __m128i mask = NeedsFilterSSE2(p1, p0, q0, q1, thresh);
+    p0 = FlipSignSSE2(p0);
+    q0 = FlipSignSSE2(q0);
+    __m128i a = _mm_and_si128(BaseDeltaSSE2(FlipSignSSE2(p1), p0, q0, FlipSignSSE2(q1)), mask);
+    SimpleFilterSSE2(p0, q0, a);
+    p0 = FlipSignSSE2(p0);
+    q0 = FlipSignSSE2(q0);
+}
+
+// Inner edge: DoFilter2 where the edge variance is high, DoFilter4 elsewhere
+static inline void DoFilter4SSE2(__m128i &p1, __m128i &p0, __m128i &q0, __m128i &q1, __m128i mask, int hevThresh)
+{
+    __m128i notHev = NotHighEdgeVarianceSSE2(p1, p0, q0, q1, hevThresh);
+    p1 = FlipSignSSE2(p1);
+    p0 = FlipSignSSE2(p0);
+    q0 = FlipSignSSE2(q0);
+    q1 = FlipSignSSE2(q1);
+
+    // The outer taps only count where the variance is high
+    __m128i t = _mm_andnot_si128(notHev, _mm_subs_epi8(p1, q1));
+    __m128i q0p0 = _mm_subs_epi8(q0, p0);
+    t = _mm_adds_epi8(t, q0p0);
+    t = _mm_adds_epi8(t, q0p0);
+    t = _mm_adds_epi8(t, q0p0);
+    t = _mm_and_si128(t, mask);
+
+    __m128i a2 = SignedShift3SSE2(_mm_adds_epi8(t, _mm_set1_epi8(3)));
+    __m128i a1 = SignedShift3SSE2(_mm_adds_epi8(t, _mm_set1_epi8(4)));
+    p0 = FlipSignSSE2(_mm_adds_epi8(p0, a2));
+    q0 = FlipSignSSE2(_mm_subs_epi8(q0, a1));
+
+    // (a1 + 1) >> 1 on signed bytes, through an unsigned average
+    __m128i a3 = _mm_sub_epi8(_mm_avg_epu8(FlipSignSSE2(a1), _mm_setzero_si128()), _mm_set1_epi8(64));
+    a3 = _mm_and_si128(notHev, a3);
+    p1 = FlipSignSSE2(_mm_adds_epi8(p1, a3));
+    q1 = FlipSignSSE2(_mm_subs_epi8(q1, a3));
+}
+
+// Adds (w * a + 63) >> 7 to p and subtracts it from q; a holds 9 * delta
+// in 16-bit lanes
+static inline void Update2PixelsSSE2(__m128i &p, __m128i &q, __m128i lo, __m128i hi)
+{
+    __m128i delta = _mm_packs_epi16(_mm_srai_epi16(lo, 7), _mm_srai_epi16(hi, 7));
+    p = FlipSignSSE2(_mm_adds_epi8(p, delta));
+    q = FlipSignSSE2(_mm_subs_epi8(q, delta));
+}
+
+// Macroblock edge: DoFilter2 where the edge variance is high, DoFilter6 elsewhere
+static inline void DoFilter6SSE2(__m128i &p2, __m128i &p1, __m128i &p0, __m128i &q0, __m128i &q1, __m128i &q2,
+                                 __m128i mask, int hevThresh)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i notHev = NotHighEdgeVarianceSSE2(p1, p0, q0, q1, hevThresh);
+    p2 = FlipSignSSE2(p2);
+    p1 = FlipSignSSE2(p1);
+    p0 = FlipSignSSE2(p0);
+    q0 = FlipSignSSE2(q0);
+    q1 = FlipSignSSE2(q1);
+    q2 = FlipSignSSE2(q2);
+    __m128i a = BaseDeltaSSE2(p1, p0, q0, q1);
+
+    SimpleFilterSSE2(p0, q0, _mm_and_si128(a, _mm_andnot_si128(notHev, mask)));
+
+    // f * 9 from f << 8 times 9 << 8, keeping the high half
+    __m128i f = _mm_and_si128(a, _mm_and_si128(notHev, mask));
+    const __m128i k9 = _mm_set1_epi16(0x0900);
+    const __m128i k63 = _mm_set1_epi16(63);
+    __m128i f9lo = _mm_mulhi_epi16(_mm_unpacklo_epi8(zero, f), k9);
+    __m128i f9hi = _mm_mulhi_epi16(_mm_unpackhi_epi8(zero, f), k9);
+    __m128i a3lo = _mm_add_epi16(f9lo, k63);
+    __m128i a3hi = _mm_add_epi16(f9hi, k63);
+    __m128i a2lo = _mm_add_epi16(a3lo, f9lo);
+    __m128i a2hi = _mm_add_epi16(a3hi, f9hi);
+    __m128i a1lo = _mm_add_epi16(a2lo, f9lo);
+    __m128i a1hi = _mm_add_epi16(a2hi, f9hi);
+    Update2PixelsSSE2(p2, q2, a3lo, a3hi);
+    Update2PixelsSSE2(p1, q1, a2lo, a2hi);
+    Update2PixelsSSE2(p0, q0, a1lo, a1hi);
+}
+
+// 16 rows of 8 bytes (the first 8 from r0, the rest from r8) into 8 vectors
+// of 16, one per column
+static void Load16x8SSE2(const CKBYTE *r0, const CKBYTE *r8, int stride, __m128i c[8])
+{
+    __m128i a[8];
+    for (int i = 0; i < 4; i++)
+    {
+        a[i] = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(r0 + 2 * i * stride)),
+                                 _mm_loadl_epi64((const __m128i *)(r0 + (2 * i + 1) * stride)));
+        a[i + 4] = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(r8 + 2 * i * stride)),
+                                     _mm_loadl_epi64((const __m128i *)(r8 + (2 * i + 1) * stride)));
+    }
+    __m128i b[8];
+    for (int i = 0; i < 4; i++)
+    {
+        b[2 * i] = _mm_unpacklo_epi16(a[2 * i], a[2 * i + 1]);
+        b[2 * i + 1] = _mm_unpackhi_epi16(a[2 * i], a[2 * i + 1]);
+    }
+    // b[0], b[2]: columns 0-3 of rows 0-3 and 4-7; b[1], b[3]: columns 4-7
+    __m128i lo[4], hi[4];
+    lo[0] = _mm_unpacklo_epi32(b[0], b[2]);
+    lo[1] = _mm_unpackhi_epi32(b[0], b[2]);
+    lo[2] = _mm_unpacklo_epi32(b[1], b[3]);
+    lo[3] = _mm_unpackhi_epi32(b[1], b[3]);
+    hi[0] = _mm_unpacklo_epi32(b[4], b[6]);
+    hi[1] = _mm_unpackhi_epi32(b[4], b[6]);
+    hi[2] = _mm_unpacklo_epi32(b[5], b[7]);
+    hi[3] = _mm_unpackhi_epi32(b[5], b[7]);
+    for (int i = 0; i < 4; i++)
+    {
+        c[2 * i] = _mm_unpacklo_epi64(lo[i], hi[i]);
+        c[2 * i + 1] = _mm_unpackhi_epi64(lo[i], hi[i]);
+    }
+}
+
+// The inverse of Load16x8SSE2
+static void Store16x8SSE2(const __m128i c[8], CKBYTE *r0, CKBYTE *r8, int stride)
+{
+    __m128i e[8];
+    for (int i = 0; i < 4; i++)
+    {
+        e[2 * i] = _mm_unpacklo_epi8(c[2 * i], c[2 * i + 1]);
+        e[2 * i + 1] = _mm_unpackhi_epi8(c[2 * i], c[2 * i + 1]);
+    }
+    // e[0], e[2], e[4], e[6]: column pairs of rows 0-7; odd ones rows 8-15
+    for (int half = 0; half < 2; half++)
+    {
+        CKBYTE *dst = half ? r8 : r0;
+        __m128i f0 = _mm_unpacklo_epi16(e[half], e[half + 2]);
+        __m128i f1 = _mm_unpackhi_epi16(e[half], e[half + 2]);
+        __m128i f2 = _mm_unpacklo_epi16(e[half + 4], e[half + 6]);
+        __m128i f3 = _mm_unpackhi_epi16(e[half + 4], e[half + 6]);
+        __m128i rows[4];
+        rows[0] = _mm_unpacklo_epi32(f0, f2);
+        rows[1] = _mm_unpackhi_epi32(f0, f2);
+        rows[2] = _mm_unpacklo_epi32(f1, f3);
+        rows[3] = _mm_unpackhi_epi32(f1, f3);
+        for (int i = 0; i < 4; i++)
+        {
+            _mm_storel_epi64((__m128i *)(dst + 2 * i * stride), rows[i]);
+            _mm_storel_epi64((__m128i *)(dst + (2 * i + 1) * stride), _mm_unpackhi_epi64(rows[i], rows[i]));
+        }
+    }
+}
+
+static inline __m128i LoadUV(const CKBYTE *u, const CKBYTE *v)
+{
+    return _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)u), _mm_loadl_epi64((const __m128i *)v));
+}
+
+static inline void StoreUV(__m128i x, CKBYTE *u, CKBYTE *v)
+{
+    _mm_storel_epi64((__m128i *)u, x);
+    _mm_storel_epi64((__m128i *)v, _mm_unpackhi_epi64(x, x));
+}
+
+static void SimpleV16SSE2(CKBYTE *p, int stride, int thresh)
+{
+    __m128i p1 = _mm_loadu_si128((const __m128i *)(p - 2 * stride));
+    __m128i p0 = _mm_loadu_si128((const __m128i *)(p - stride));
+    __m128i q0 = _mm_loadu_si128((const __m128i *)p);
+    __m128i q1 = _mm_loadu_si128((const __m128i *)(p + stride));
+    DoFilter2SSE2(p1, p0, q0, q1, thresh);
+    _mm_storeu_si128((__m128i *)(p - stride), p0);
+    _mm_storeu_si128((__m128i *)p, q0);
+}
+
+static void SimpleH16SSE2(CKBYTE *p, int stride, int thresh)
+{
+    __m128i c[8];
+    Load16x8SSE2(p - 4, p - 4 + 8 * stride, stride, c);
+    DoFilter2SSE2(c[2], c[3], c[4], c[5], thresh);
+    Store16x8SSE2(c, p - 4, p - 4 + 8 * stride, stride);
+}
+
+static void SimpleV16iSSE2(CKBYTE *p, int stride, int thresh)
+{
+    for (int k = 1; k < 4; k++)
+        SimpleV16SSE2(p + 4 * k * stride, stride, thresh);
+}
+
+static void SimpleH16iSSE2(CKBYTE *p, int stride, int thresh)
+{
+    for (int k = 1; k < 4; k++)
+        SimpleH16SSE2(p + 4 * k, stride, thresh);
+}
+
+// c[0..7] hold p3..q3; mbEdge picks the 6-tap filter
+static inline void FilterColumnsSSE2(__m128i c[8], CKBOOL mbEdge, int thresh, int it, int hevThresh)
+{
+    __m128i mask = ComplexMaskSSE2(c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7], thresh, it);
+    if (mbEdge)
+        DoFilter6SSE2(c[1], c[2], c[3], c[4], c[5], c[6], mask, hevThresh);
+    else
+        DoFilter4SSE2(c[2], c[3], c[4], c[5], mask, hevThresh);
+}
+
+static inline void FilterRowsSSE2(CKBYTE *p, int stride, CKBOOL mbEdge, int thresh, int it, int hevThresh)
+{
+    __m128i c[8];
+    for (int i = 0; i < 8; i++)
+        c[i] = _mm_loadu_si128((const __m128i *)(p + (i - 4) * stride));
+    FilterColumnsSSE2(c, mbEdge, thresh, it, hevThresh);
+    for (int i = 1; i < 7; i++)
+        _mm_storeu_si128((__m128i *)(p + (i - 4) * stride), c[i]);
+}
+
+static inline void FilterRowsUVSSE2(CKBYTE *u, CKBYTE *v, int stride, CKBOOL mbEdge, int thresh, int it,
+                                    int hevThresh)
+{
+    __m128i c[8];
+    for (int i = 0; i < 8; i++)
+        c[i] = LoadUV(u + (i - 4) * stride, v + (i - 4) * stride);
+    FilterColumnsSSE2(c, mbEdge, thresh, it, hevThresh);
+    for (int i = 1; i < 7; i++)
+        StoreUV(c[i], u + (i - 4) * stride, v + (i - 4) * stride);
+}
+
+static void V16SSE2(CKBYTE *p, int stride, int thresh, int it, int hevThresh)
+{
+    FilterRowsSSE2(p, stride, TRUE, thresh, it, hevThresh);
+}
+
+static void H16SSE2(CKBYTE *p, int stride, int thresh, int it, int hevThresh)
+{
+    __m128i c[8];
+    Load16x8SSE2(p - 4, p - 4 + 8 * stride, stride, c);
+    FilterColumnsSSE2(c, TRUE, thresh, it, hevThresh);
+    Store16x8SSE2(c, p - 4, p - 4 + 8 * stride, stride);
+}
+
+static void V16iSSE2(CKBYTE *p, int stride, int thresh, int it, int hevThresh)
+{
+    for (int k = 1; k < 4; k++)
+        FilterRowsSSE2(p + 4 * k * stride, stride, FALSE, thresh, it, hevThresh);
+}
+
+static void H16iSSE2(CKBYTE *p, int stride, int thresh, int it, int hevThresh)
+{
+    for (int k = 1; k < 4; k++)
+    {
+        __m128i c[8];
+        CKBYTE *edge = p + 4 * k;
+        Load16x8SSE2(edge - 4, edge - 4 + 8 * stride, stride, c);
+        FilterColumnsSSE2(c, FALSE, thresh, it, hevThresh);
+        Store16x8SSE2(c, edge - 4, edge - 4 + 8 * stride, stride);
+    }
+}
+
+static void V8SSE2(CKBYTE *u, CKBYTE *v, int stride, int thresh, int it, int hevThresh)
+{
+    FilterRowsUVSSE2(u, v, stride, TRUE, thresh, it, hevThresh);
+}
+
+static void H8SSE2(CKBYTE *u, CKBYTE *v, int stride, int thresh, int it, int hevThresh)
+{
+    __m128i c[8];
+    Load16x8SSE2(u - 4, v - 4, stride, c);
+    FilterColumnsSSE2(c, TRUE, thresh, it, hevThresh);
+    Store16x8SSE2(c, u - 4, v - 4, stride);
+}
+
+static void V8iSSE2(CKBYTE *u, CKBYTE *v, int stride, int thresh, int it, int hevThresh)
+{
+    FilterRowsUVSSE2(u + 4 * stride, v + 4 * stride, stride, FALSE, thresh, it, hevThresh);
+}
+
+static void H8iSSE2(CKBYTE *u, CKBYTE *v, int stride, int thresh, int it, int hevThresh)
+{
+    __m128i c[8];
+    Load16x8SSE2(u, v, stride, c);
+    FilterColumnsSSE2(c, FALSE, thresh, it, hevThresh);
+    Store16x8SSE2(c, u, v, stride);
+}
+
+//=============================================================================
+// VP8 YUV to BGRA
+//
+// BT.601 studio range with 14-bit fixed point constants, and chroma upsampled
+// with 9:3:3:1 weights (libwebp's "fancy" upsampler). u and v are interpolated
+// together, one in each 16-bit half of a word.
+//=============================================================================
+static inline int MultHi(int v, int coeff) { return (v * coeff) >> 8; }
+
+static inline CKBYTE Clip8(int v) { return (CKBYTE)((v & ~16383) == 0 ? (v >> 6) : (v < 0 ? 0 : 255)); }
+
+static inline void YuvToBgra(int y, int u, int v, CKBYTE *bgra)
+{
+    int luma = MultHi(y, 19077);
+    bgra[0] = Clip8(luma + MultHi(u, 33050) - 17685);
+    bgra[1] = Clip8(luma - MultHi(u, 6419) - MultHi(v, 13320) + 8708);
+    bgra[2] = Clip8(luma + MultHi(v, 26149) - 14234);
+    bgra[3] = 255;
+}
+
+static inline void YuvToBgraPacked(int y, CKDWORD uv, CKBYTE *bgra)
+{
+    YuvToBgra(y, (int)(uv & 0xff), (int)(uv >> 16), bgra);
+}
+
+static void UpsampleScalar(const CKBYTE *topY, const CKBYTE *bottomY, const CKBYTE *topU, const CKBYTE *topV,
+                           const CKBYTE *curU, const CKBYTE *curV, CKBYTE *topDst, CKBYTE *bottomDst, int width)
+{
+    int lastPair = (width - 1) >> 1;
+    CKDWORD tl = topU[0] | ((CKDWORD)topV[0] << 16); // top-left sample
+    CKDWORD l = curU[0] | ((CKDWORD)curV[0] << 16);  // left sample
+    YuvToBgraPacked(topY[0], (3 * tl + l + 0x00020002u) >> 2, topDst);
+    if (bottomY)
+        YuvToBgraPacked(bottomY[0], (3 * l + tl + 0x00020002u) >> 2, bottomDst);
+    for (int x = 1; x <= lastPair; x++)
+    {
+        CKDWORD t = topU[x] | ((CKDWORD)topV[x] << 16);
+        CKDWORD c = curU[x] | ((CKDWORD)curV[x] << 16);
+        CKDWORD avg = tl + t + l + c + 0x00080008u;
+        CKDWORD diag12 = (avg + 2 * (t + l)) >> 3;
+        CKDWORD diag03 = (avg + 2 * (tl + c)) >> 3;
+        YuvToBgraPacked(topY[2 * x - 1], (diag12 + tl) >> 1, topDst + (2 * x - 1) * 4);
+        YuvToBgraPacked(topY[2 * x], (diag03 + t) >> 1, topDst + 2 * x * 4);
+        if (bottomY)
+        {
+            YuvToBgraPacked(bottomY[2 * x - 1], (diag03 + l) >> 1, bottomDst + (2 * x - 1) * 4);
+            YuvToBgraPacked(bottomY[2 * x], (diag12 + c) >> 1, bottomDst + 2 * x * 4);
+        }
+        tl = t;
+        l = c;
+    }
+    if (!(width & 1))
+    {
+        YuvToBgraPacked(topY[width - 1], (3 * tl + l + 0x00020002u) >> 2, topDst + (width - 1) * 4);
+        if (bottomY)
+            YuvToBgraPacked(bottomY[width - 1], (3 * l + tl + 0x00020002u) >> 2, bottomDst + (width - 1) * 4);
+    }
+}
+
+//=============================================================================
+// VP8L Predictors
+//
+// Each pixel is the residual plus a prediction from its left (L), top (T),
+// top-left (TL) and top-right (TR) neighbours, per byte modulo 256.
+//=============================================================================
+static inline CKDWORD AddPixels(CKDWORD a, CKDWORD b)
+{
+    CKDWORD ag = (a & 0xff00ff00u) + (b & 0xff00ff00u);
+    CKDWORD rb = (a & 0x00ff00ffu) + (b & 0x00ff00ffu);
+    return (ag & 0xff00ff00u) | (rb & 0x00ff00ffu);
+}
+
+static inline CKDWORD Average2(CKDWORD a, CKDWORD b) { return (((a ^ b) & 0xfefefefeu) >> 1) + (a & b); }
+
+static inline CKDWORD Clip255(CKDWORD a) { return a < 256 ? a : (~a >> 24); }
+
+static inline CKDWORD ClampedAddSubtractFull(CKDWORD c0, CKDWORD c1, CKDWORD c2)
+{
+    CKDWORD out = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int v = (int)((c0 >> shift) & 0xff) + (int)((c1 >> shift) & 0xff) - (int)((c2 >> shift) & 0xff);
+        out |= Clip255((CKDWORD)v) << shift;
+    }
+    return out;
+}
+
+static inline CKDWORD ClampedAddSubtractHalf(CKDWORD c0, CKDWORD c1, CKDWORD c2)
+{
+    CKDWORD ave = Average2(c0, c1);
+    CKDWORD out = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int a = (int)((ave >> shift) & 0xff);
+        int b = (int)((c2 >> shift) & 0xff);
+        out |= Clip255((CKDWORD)(a + (a - b) / 2)) << shift;
+    }
+    return out;
+}
+
+// Picks the neighbour (top or left) closer to the gradient estimate
+static inline CKDWORD Select(CKDWORD top, CKDWORD left, CKDWORD topLeft)
+{
+    int diff = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int t = (int)((top >> shift) & 0xff);
+        int l = (int)((left >> shift) & 0xff);
+        int tl = (int)((topLeft >> shift) & 0xff);
+        diff += Abs(l - tl) - Abs(t - tl);
+    }
+    return diff <= 0 ? top : left;
+}
+
+struct PredictBlack { static inline CKDWORD Get(CKDWORD, const CKDWORD *) { return 0xff000000u; } };
+struct PredictL { static inline CKDWORD Get(CKDWORD l, const CKDWORD *) { return l; } };
+struct PredictT { static inline CKDWORD Get(CKDWORD, const CKDWORD *t) { return t[0]; } };
+struct PredictTR { static inline CKDWORD Get(CKDWORD, const CKDWORD *t) { return t[1]; } };
+struct PredictTL { static inline CKDWORD Get(CKDWORD, const CKDWORD *t) { return t[-1]; } };
+struct PredictAvgLTTR
+{
+    static inline CKDWORD Get(CKDWORD l, const CKDWORD *t) { return Average2(Average2(l, t[1]), t[0]); }
+};
+struct PredictAvgLTL { static inline CKDWORD Get(CKDWORD l, const CKDWORD *t) { return Average2(l, t[-1]); } };
+struct PredictAvgLT { static inline CKDWORD Get(CKDWORD l, const CKDWORD *t) { return Average2(l, t[0]); } };
+struct PredictAvgTLT { static inline CKDWORD Get(CKDWORD, const CKDWORD *t) { return Average2(t[-1], t[0]); } };
+struct PredictAvgTTR { static inline CKDWORD Get(CKDWORD, const CKDWORD *t) { return Average2(t[0], t[1]); } };
+struct PredictAvgLTLTTR
+{
+    static inline CKDWORD Get(CKDWORD l, const CKDWORD *t) { return Average2(Average2(l, t[-1]), Average2(t[0], t[1])); }
+};
+struct PredictSelect { static inline CKDWORD Get(CKDWORD l, const CKDWORD *t) { return Select(t[0], l, t[-1]); } };
+struct PredictFull
+{
+    static inline CKDWORD Get(CKDWORD l, const CKDWORD *t) { return ClampedAddSubtractFull(l, t[0], t[-1]); }
+};
+struct PredictHalf
+{
+    static inline CKDWORD Get(CKDWORD l, const CKDWORD *t) { return ClampedAddSubtractHalf(l, t[0], t[-1]); }
+};
+
+template <class Predict>
+static void PredictorAddScalar(const CKDWORD *in, const CKDWORD *upper, int count, CKDWORD *out)
+{
+    for (int x = 0; x < count; x++)
+        out[x] = AddPixels(in[x], Predict::Get(out[x - 1], upper + x));
+}
+
+// SSE2: the modes that do not depend on the left pixel are plain additions;
+// mode 1 (left) is a prefix sum over four pixels
+static inline __m128i Average2SSE2(__m128i a, __m128i b)
+{
+    __m128i roundedUp = _mm_avg_epu8(a, b);
+    return _mm_sub_epi8(roundedUp, _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1)));
+}
+
+static void PredictorAdd0SSE2(const CKDWORD *in, const CKDWORD *upper, int count, CKDWORD *out)
+{
+    const __m128i black = _mm_set1_epi32((int)0xff000000u);
+    int x = 0;
+    for (; x + 4 <= count; x += 4)
+    {
+        __m128i src = _mm_loadu_si128((const __m128i *)(in + x));
+        _mm_storeu_si128((__m128i *)(out + x), _mm_add_epi8(src, black));
+    }
+    PredictorAddScalar<PredictBlack>(in + x, upper + x, count - x, out + x);
+}
+
+static void PredictorAdd1SSE2(const CKDWORD *in, const CKDWORD *upper, int count, CKDWORD *out)
+{
+    __m128i left = _mm_cvtsi32_si128((int)out[-1]);
+    int x = 0;
+    for (; x + 4 <= count; x += 4)
+    {
+        __m128i sum = _mm_loadu_si128((const __m128i *)(in + x));
+        sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 4));
+        sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 8));
+        sum = _mm_add_epi8(sum, _mm_shuffle_epi32(left, 0));
+        _mm_storeu_si128((__m128i *)(out + x), sum);
+        left = _mm_shuffle_epi32(sum, 0xff);
+    }
+    PredictorAddScalar<PredictL>(in + x, upper + x, count - x, out + x);
+}
+
+// Modes 2, 3 and 4 add the pixel at upper + offset
+template <int offset, class Predict>
+static void PredictorAddUpperSSE2(const CKDWORD *in, const CKDWORD *upper, int count, CKDWORD *out)
+{
+    int x = 0;
+    for (; x + 4 <= count; x += 4)
+    {
+        __m128i src = _mm_loadu_si128((const __m128i *)(in + x));
+        __m128i pred = _mm_loadu_si128((const __m128i *)(upper + x + offset));
+        _mm_storeu_si128((__m128i *)(out + x), _mm_add_epi8(src, pred));
+    }
+    PredictorAddScalar<Predict>(in + x, upper + x, count - x, out + x);
+}
+
+// Modes 8 and 9 add the average of upper + offset and upper + offset + 1
+template <int offset, class Predict>
+static void PredictorAddAverageSSE2(const CKDWORD *in, const CKDWORD *upper, int count, CKDWORD *out)
+{
+    int x = 0;
+    for (; x + 4 <= count; x += 4)
+    {
+        __m128i src = _mm_loadu_si128((const __m128i *)(in + x));
+        __m128i a = _mm_loadu_si128((const __m128i *)(upper + x + offset));
+        __m128i b = _mm_loadu_si128((const __m128i *)(upper + x + offset + 1));
+        _mm_storeu_si128((__m128i *)(out + x), _mm_add_epi8(src, Average2SSE2(a, b)));
+    }
+    PredictorAddScalar<Predict>(in + x, upper + x, count - x, out + x);
+}
+
+//=============================================================================
+// VP8L Color Transforms
+//=============================================================================
+static inline int ColorTransformDelta(signed char pred, signed char color) { return ((int)pred * color) >> 5; }
+
+static void ColorTransformScalar(CKDWORD element, const CKDWORD *src, int count, CKDWORD *dst)
+{
+    signed char greenToRed = (signed char)(element & 0xff);
+    signed char greenToBlue = (signed char)((element >> 8) & 0xff);
+    signed char redToBlue = (signed char)((element >> 16) & 0xff);
+    for (int i = 0; i < count; i++)
+    {
+        CKDWORD argb = src[i];
+        signed char green = (signed char)(argb >> 8);
+        int red = (int)((argb >> 16) & 0xff);
+        int blue = (int)(argb & 0xff);
+        red = (red + ColorTransformDelta(greenToRed, green)) & 0xff;
+        blue += ColorTransformDelta(greenToBlue, green);
+        blue += ColorTransformDelta(redToBlue, (signed char)red);
+        dst[i] = (argb & 0xff00ff00u) | ((CKDWORD)red << 16) | ((CKDWORD)blue & 0xff);
+    }
+}
+
+// SSE2: a byte b placed in the high half of a 16-bit lane is b * 256 as a
+// signed value; times (m * 8) in mulhi gives (b * m) >> 5 in the low byte
+static void ColorTransformSSE2(CKDWORD element, const CKDWORD *src, int count, CKDWORD *dst)
+{
+    int greenToRed = (signed char)(element & 0xff) * 8;
+    int greenToBlue = (signed char)((element >> 8) & 0xff) * 8;
+    int redToBlue = (signed char)((element >> 16) & 0xff) * 8;
+    const __m128i multGreen = _mm_set_epi16((short)greenToRed, (short)greenToBlue, (short)greenToRed,
+                                            (short)greenToBlue, (short)greenToRed, (short)greenToBlue,
+                                            (short)greenToRed, (short)greenToBlue);
+    const __m128i multRed = _mm_set1_epi32(redToBlue & 0xffff);
+    const __m128i maskAG = _mm_set1_epi32((int)0xff00ff00u);
+    const __m128i maskLow = _mm_set1_epi32(0x00ff00ff);
+    const __m128i maskRed = _mm_set1_epi32(0x0000ff00);
+    const __m128i maskBlue = _mm_set1_epi32(0x000000ff);
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i in = _mm_loadu_si128((const __m128i *)(src + i));
+        // green << 8 in both 16-bit halves of each pixel
+        __m128i green = _mm_and_si128(in, maskAG);
+        green = _mm_shufflehi_epi16(_mm_shufflelo_epi16(green, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 2, 0, 0));
+        __m128i out = _mm_add_epi8(in, _mm_and_si128(_mm_mulhi_epi16(green, multGreen), maskLow));
+        // the new red << 8 in the low half
+        __m128i red = _mm_and_si128(_mm_srli_epi32(out, 8), maskRed);
+        out = _mm_add_epi8(out, _mm_and_si128(_mm_mulhi_epi16(red, multRed), maskBlue));
+        _mm_storeu_si128((__m128i *)(dst + i), out);
+    }
+    ColorTransformScalar(element, src + i, count - i, dst + i);
+}
+
+static void AddGreenScalar(const CKDWORD *src, int count, CKDWORD *dst)
+{
+    for (int i = 0; i < count; i++)
+    {
+        CKDWORD argb = src[i];
+        CKDWORD green = (argb >> 8) & 0xff;
+        CKDWORD redBlue = ((argb & 0x00ff00ffu) + ((green << 16) | green)) & 0x00ff00ffu;
+        dst[i] = (argb & 0xff00ff00u) | redBlue;
+    }
+}
+
+static void AddGreenSSE2(const CKDWORD *src, int count, CKDWORD *dst)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i in = _mm_loadu_si128((const __m128i *)(src + i));
+        // green in the low byte of both 16-bit halves
+        __m128i green = _mm_srli_epi16(in, 8);
+        green = _mm_shufflehi_epi16(_mm_shufflelo_epi16(green, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 2, 0, 0));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_add_epi8(in, green));
+    }
+    AddGreenScalar(src + i, count - i, dst + i);
+}
+
+//=============================================================================
+// Kernel Selection
+//=============================================================================
+static WebpDsp s_ScalarDsp;
+static WebpDsp s_Dsp;
+static ImageOnce s_DspOnce = 0;
+
+static void InitDsp()
+{
+    WebpDsp dsp;
+    dsp.transform = TransformScalar;
+    dsp.simpleV16 = SimpleV16Scalar;
+    dsp.simpleH16 = SimpleH16Scalar;
+    dsp.simpleV16i = SimpleV16iScalar;
+    dsp.simpleH16i = SimpleH16iScalar;
+    dsp.v16 = V16Scalar;
+    dsp.h16 = H16Scalar;
+    dsp.v16i = V16iScalar;
+    dsp.h16i = H16iScalar;
+    dsp.v8 = V8Scalar;
+    dsp.h8 = H8Scalar;
+    dsp.v8i = V8iScalar;
+    dsp.h8i = H8iScalar;
+    dsp.upsample = UpsampleScalar;
+    dsp.predictorAdd[0] = PredictorAddScalar<PredictBlack>;
+    dsp.predictorAdd[1] = PredictorAddScalar<PredictL>;
+    dsp.predictorAdd[2] = PredictorAddScalar<PredictT>;
+    dsp.predictorAdd[3] = PredictorAddScalar<PredictTR>;
+    dsp.predictorAdd[4] = PredictorAddScalar<PredictTL>;
+    dsp.predictorAdd[5] = PredictorAddScalar<PredictAvgLTTR>;
+    dsp.predictorAdd[6] = PredictorAddScalar<PredictAvgLTL>;
+    dsp.predictorAdd[7] = PredictorAddScalar<PredictAvgLT>;
+    dsp.predictorAdd[8] = PredictorAddScalar<PredictAvgTLT>;
+    dsp.predictorAdd[9] = PredictorAddScalar<PredictAvgTTR>;
+    dsp.predictorAdd[10] = PredictorAddScalar<PredictAvgLTLTTR>;
+    dsp.predictorAdd[11] = PredictorAddScalar<PredictSelect>;
+    dsp.predictorAdd[12] = PredictorAddScalar<PredictFull>;
+    dsp.predictorAdd[13] = PredictorAddScalar<PredictHalf>;
+    dsp.predictorAdd[14] = PredictorAddScalar<PredictBlack>;
+    dsp.predictorAdd[15] = PredictorAddScalar<PredictBlack>;
+    dsp.colorTransform = ColorTransformScalar;
+    dsp.addGreen = AddGreenScalar;
+    s_ScalarDsp = dsp;
+
+    if (ImageCpuHas(IMAGE_CPU_SSE2))
+    {
+        dsp.transform = TransformSSE2;
+        dsp.simpleV16 = SimpleV16SSE2;
+        dsp.simpleH16 = SimpleH16SSE2;
+        dsp.simpleV16i = SimpleV16iSSE2;
+        dsp.simpleH16i = SimpleH16iSSE2;
+        dsp.v16 = V16SSE2;
+        dsp.h16 = H16SSE2;
+        dsp.v16i = V16iSSE2;
+        dsp.h16i = H16iSSE2;
+        dsp.v8 = V8SSE2;
+        dsp.h8 = H8SSE2;
+        dsp.v8i = V8iSSE2;
+        dsp.h8i = H8iSSE2;
+        dsp.predictorAdd[0] = PredictorAdd0SSE2;
+        dsp.predictorAdd[1] = PredictorAdd1SSE2;
+        dsp.predictorAdd[2] = PredictorAddUpperSSE2<0, PredictT>;
+        dsp.predictorAdd[3] = PredictorAddUpperSSE2<1, PredictTR>;
+        dsp.predictorAdd[4] = PredictorAddUpperSSE2<-1, PredictTL>;
+        dsp.predictorAdd[8] = PredictorAddAverageSSE2<-1, PredictAvgTLT>;
+        dsp.predictorAdd[9] = PredictorAddAverageSSE2<0, PredictAvgTTR>;
+        dsp.predictorAdd[14] = PredictorAdd0SSE2;
+        dsp.predictorAdd[15] = PredictorAdd0SSE2;
+        dsp.colorTransform = ColorTransformSSE2;
+        dsp.addGreen = AddGreenSSE2;
+    }
+    s_Dsp = dsp;
+}
+
+const WebpDsp &WEBP_GetDsp()
+{
+    ImageCallOnce(s_DspOnce, InitDsp);
+    return s_Dsp;
+}
+
+const WebpDsp &WEBP_GetScalarDsp()
+{
+    ImageCallOnce(s_DspOnce, InitDsp);
+    return s_ScalarDsp;
+}
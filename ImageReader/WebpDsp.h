@@ -0,0 +1,79 @@
+#ifndef WEBPDSP_H
+#define WEBPDSP_H
+
+#include "ImageReader.h"
+
+//=============================================================================
+// WebP signal processing kernels
+//
+// VP8 (lossy) inverse transform, loop filters and chroma upsampling, and the
+// VP8L (lossless) inverse transforms. The integer math follows libwebp, whose
+// output defines the format in practice, and the SSE2 variants produce
+// exactly the scalar results.
+//=============================================================================
+
+// Inverse DCT of one 4x4 block of coefficients (row-major), added to the
+// pixels at dst with saturation
+typedef void (*WebpTransformFunc)(const short *coefs, CKBYTE *dst, int stride);
+
+// Simple loop filter of a 16-pixel luma edge: the horizontal edge above p (V)
+// or the vertical edge left of p (H). The "i" variants filter the three inner
+// edges of the macroblock starting at p. thresh is the edge limit.
+typedef void (*WebpSimpleFilterFunc)(CKBYTE *p, int stride, int thresh);
+
+// Normal loop filter of luma edges, as above
+typedef void (*WebpLumaFilterFunc)(CKBYTE *p, int stride, int thresh, int interiorLimit, int hevThresh);
+
+// Normal loop filter of the same 8-pixel edge of the u and v planes; the "i"
+// variants filter the inner edge
+typedef void (*WebpChromaFilterFunc)(CKBYTE *u, CKBYTE *v, int stride, int thresh, int interiorLimit,
+                                     int hevThresh);
+
+// Converts one or two luma rows of width pixels to BGRA32, interpolating the
+// chroma of each pixel from the two nearest chroma rows ("fancy" upsampling).
+// topU/topV is the chroma row above the pixel pair, curU/curV the one below;
+// bottomY and bottomDst may be NULL.
+typedef void (*WebpUpsampleFunc)(const CKBYTE *topY, const CKBYTE *bottomY, const CKBYTE *topU, const CKBYTE *topV,
+                                 const CKBYTE *curU, const CKBYTE *curV, CKBYTE *topDst, CKBYTE *bottomDst,
+                                 int width);
+
+// VP8L: adds the prediction of one mode to count pixels. upper is the row
+// above (upper[-1] to upper[count] are read) and out[-1] the left pixel;
+// in and out may be the same.
+typedef void (*WebpPredictorAddFunc)(const CKDWORD *in, const CKDWORD *upper, int count, CKDWORD *out);
+
+// VP8L: undoes the color transform of count pixels. element holds the green
+// to red, green to blue and red to blue multipliers in bytes 0, 1 and 2.
+typedef void (*WebpColorTransformFunc)(CKDWORD element, const CKDWORD *src, int count, CKDWORD *dst);
+
+// VP8L: adds green to red and blue (undoes the subtract green transform)
+typedef void (*WebpAddGreenFunc)(const CKDWORD *src, int count, CKDWORD *dst);
+
+struct WebpDsp
+{
+    WebpTransformFunc transform;
+    WebpSimpleFilterFunc simpleV16;
+    WebpSimpleFilterFunc simpleH16;
+    WebpSimpleFilterFunc simpleV16i;
+    WebpSimpleFilterFunc simpleH16i;
+    WebpLumaFilterFunc v16;
+    WebpLumaFilterFunc h16;
+    WebpLumaFilterFunc v16i;
+    WebpLumaFilterFunc h16i;
+    WebpChromaFilterFunc v8;
+    WebpChromaFilterFunc h8;
+    WebpChromaFilterFunc v8i;
+    WebpChromaFilterFunc h8i;
+    WebpUpsampleFunc upsample;
+    WebpPredictorAddFunc predictorAdd[16]; // indexed by mode; 14 and 15 act as 0
+    WebpColorTransformFunc colorTransform;
+    WebpAddGreenFunc addGreen;
+};
+
+// Kernels for the running CPU
+const WebpDsp &WEBP_GetDsp();
+
+// Scalar kernels, used as the reference for the SIMD ones
+const WebpDsp &WEBP_GetScalarDsp();
+
+#endif // WEBPDSP_H
@@ -0,0 +1,927 @@
+#include "WebpCodec.h"
+#include "WebpDsp.h"
+
+//=============================================================================
+// VP8L Constants
+//=============================================================================
+#define VP8L_ROOT_BITS 8
+#define VP8L_LENGTHS_ROOT_BITS 7
+#define VP8L_MAX_CODE_LENGTH 15
+#define VP8L_LITERAL_CODES 256
+#define VP8L_LENGTH_CODES 24
+#define VP8L_DISTANCE_CODES 40
+#define VP8L_CODE_LENGTH_CODES 19
+#define VP8L_MAX_CACHE_BITS 11
+#define VP8L_MAX_ALPHABET (VP8L_LITERAL_CODES + VP8L_LENGTH_CODES + (1 << VP8L_MAX_CACHE_BITS))
+#define VP8L_CODES_PER_GROUP 5 // green (with lengths and cache), red, blue, alpha, distance
+
+#define VP8L_PREDICTOR_TRANSFORM 0
+#define VP8L_CROSS_COLOR_TRANSFORM 1
+#define VP8L_SUBTRACT_GREEN_TRANSFORM 2
+#define VP8L_COLOR_INDEXING_TRANSFORM 3
+#define VP8L_MAX_TRANSFORMS 4
+
+#define VP8L_COLOR_CACHE_MULTIPLIER 0x1e35a7bdu
+
+static const CKWORD AlphabetSize[VP8L_CODES_PER_GROUP] = {VP8L_LITERAL_CODES + VP8L_LENGTH_CODES, 256, 256, 256,
+                                                          VP8L_DISTANCE_CODES};
+
+static const CKBYTE CodeLengthOrder[VP8L_CODE_LENGTH_CODES] = {17, 18, 0, 1,  2,  3,  4,  5,  16, 6,
+                                                               7,  8,  9, 10, 11, 12, 13, 14, 15};
+
+// The first 120 distance codes are (dy, dx) offsets near the current pixel:
+// dy in the high nibble, 8 - dx in the low one
+static const CKBYTE CodeToPlane[120] = {
+    0x18, 0x07, 0x17, 0x19, 0x28, 0x06, 0x27, 0x29, 0x16, 0x1a, 0x26, 0x2a, 0x38, 0x05, 0x37, 0x39, 0x15, 0x1b, 0x36, 0x3a,
+    0x25, 0x2b, 0x48, 0x04, 0x47, 0x49, 0x14, 0x1c, 0x35, 0x3b, 0x46, 0x4a, 0x24, 0x2c, 0x58, 0x45, 0x4b, 0x34, 0x3c, 0x03,
+    0x57, 0x59, 0x13, 0x1d, 0x56, 0x5a, 0x23, 0x2d, 0x44, 0x4c, 0x55, 0x5b, 0x33, 0x3d, 0x68, 0x02, 0x67, 0x69, 0x12, 0x1e,
+    0x66, 0x6a, 0x22, 0x2e, 0x54, 0x5c, 0x43, 0x4d, 0x65, 0x6b, 0x32, 0x3e, 0x78, 0x01, 0x77, 0x79, 0x53, 0x5d, 0x11, 0x1f,
+    0x64, 0x6c, 0x42, 0x4e, 0x76, 0x7a, 0x21, 0x2f, 0x75, 0x7b, 0x31, 0x3f, 0x63, 0x6d, 0x52, 0x5e, 0x00, 0x74, 0x7c, 0x41,
+    0x4f, 0x10, 0x20, 0x62, 0x6e, 0x30, 0x73, 0x7d, 0x51, 0x5f, 0x40, 0x72, 0x7e, 0x61, 0x6f, 0x50, 0x71, 0x7f, 0x60, 0x70};
+
+static inline CKDWORD SubSampleSize(CKDWORD size, CKDWORD bits) { return (size + (1u << bits) - 1) >> bits; }
+
+//=============================================================================
+// Bit Input
+//
+// LSB first, with the refills of ImageInflate: bitbuf holds bitCount bits and
+// reads past the end supply zero bytes counted in overrun. The stream is
+// broken only if some of those zero bits were consumed.
+//=============================================================================
+struct Vp8lBits
+{
+    const CKBYTE *in;
+    const CKBYTE *inEnd;
+    uint64_t bitbuf;
+    CKDWORD bitCount;
+    CKDWORD overrun;
+};
+
+static uint64_t Load64(const CKBYTE *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void Refill(Vp8lBits &s)
+{
+    if (s.inEnd - s.in >= 8)
+    {
+        s.bitbuf |= Load64(s.in) << s.bitCount;
+        s.in += (63 - s.bitCount) >> 3;
+        s.bitCount |= 56;
+        return;
+    }
+    while (s.bitCount <= 56)
+    {
+        CKDWORD byte = 0;
+        if (s.in < s.inEnd)
+            byte = *s.in++;
+        else
+            s.overrun++;
+        s.bitbuf |= (uint64_t)byte << s.bitCount;
+        s.bitCount += 8;
+    }
+}
+
+static inline CKDWORD PeekBits(const Vp8lBits &s, CKDWORD n) { return (CKDWORD)s.bitbuf & ((1u << n) - 1); }
+
+static inline void DropBits(Vp8lBits &s, CKDWORD n)
+{
+    s.bitbuf >>= n;
+    s.bitCount -= n;
+}
+
+// n <= 24
+static inline CKDWORD ReadBits(Vp8lBits &s, CKDWORD n)
+{
+    if (s.bitCount < n)
+        Refill(s);
+    CKDWORD v = PeekBits(s, n);
+    DropBits(s, n);
+    return v;
+}
+
+static inline CKBOOL IsOverrun(const Vp8lBits &s) { return s.overrun * 8 > s.bitCount; }
+
+//=============================================================================
+// Prefix Codes
+//
+// Entry layout as in ImageInflate: [31..16] symbol, [15..8] 0x80 | subtable
+// bits for a subtable pointer (symbol = its offset), [7..0] bits to consume.
+// A code with a single symbol takes no bits.
+//=============================================================================
+#define VP8L_SUBTABLE 0x80
+
+#define ENTRY(value, op, bits) (((CKDWORD)(value) << 16) | ((CKDWORD)(op) << 8) | (CKDWORD)(bits))
+
+static CKDWORD ReverseBits(CKDWORD code, CKDWORD length)
+{
+    CKDWORD reversed = 0;
+    for (CKDWORD i = 0; i < length; i++)
+    {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+    return reversed;
+}
+
+// Builds the decode table of a canonical code, or only sizes it when table
+// is NULL. Codes must be complete unless they have exactly one symbol.
+static CKBOOL BuildCode(const CKWORD *lengths, CKDWORD count, CKDWORD rootBits, CKDWORD *table, CKDWORD &size)
+{
+    CKDWORD counts[VP8L_MAX_CODE_LENGTH + 1];
+    memset(counts, 0, sizeof(counts));
+    for (CKDWORD s = 0; s < count; s++)
+        counts[lengths[s]]++;
+    CKDWORD symbols = count - counts[0];
+    if (symbols == 0)
+        return FALSE;
+
+    CKDWORD rootSize = 1u << rootBits;
+    size = rootSize;
+    if (symbols == 1)
+    {
+        if (table)
+        {
+            CKDWORD symbol = 0;
+            while (lengths[symbol] == 0)
+                symbol++;
+            for (CKDWORD i = 0; i < rootSize; i++)
+                table[i] = ENTRY(symbol, 0, 0);
+        }
+        return TRUE;
+    }
+
+    int left = 1;
+    for (CKDWORD len = 1; len <= VP8L_MAX_CODE_LENGTH; len++)
+    {
+        left = (left << 1) - (int)counts[len];
+        if (left < 0)
+            return FALSE;
+    }
+    if (left != 0)
+        return FALSE;
+    CKDWORD maxLen = VP8L_MAX_CODE_LENGTH;
+    while (counts[maxLen] == 0)
+        maxLen--;
+
+    // Symbols sorted by code length, then by value (canonical order)
+    CKDWORD offsets[VP8L_MAX_CODE_LENGTH + 2];
+    offsets[1] = 0;
+    for (CKDWORD len = 1; len <= VP8L_MAX_CODE_LENGTH; len++)
+        offsets[len + 1] = offsets[len] + counts[len];
+    CKWORD sorted[VP8L_MAX_ALPHABET];
+    for (CKDWORD s = 0; s < count; s++)
+        if (lengths[s])
+            sorted[offsets[lengths[s]]++] = (CKWORD)s;
+
+    CKDWORD remaining[VP8L_MAX_CODE_LENGTH + 1];
+    memcpy(remaining, counts, sizeof(counts));
+
+    CKDWORD rootMask = rootSize - 1;
+    CKDWORD used = rootSize;
+    CKDWORD subPrefix = 0xFFFFFFFF;
+    CKDWORD subOffset = 0;
+    CKDWORD subBits = 0;
+    CKDWORD code = 0;
+    CKDWORD index = 0;
+    for (CKDWORD len = 1; len <= maxLen; len++, code <<= 1)
+    {
+        for (CKDWORD k = 0; k < counts[len]; k++, code++)
+        {
+            CKDWORD symbol = sorted[index++];
+            CKDWORD reversed = ReverseBits(code, len);
+            if (len <= rootBits)
+            {
+                if (table)
+                    for (CKDWORD i = reversed; i < rootSize; i += 1u << len)
+                        table[i] = ENTRY(symbol, 0, len);
+            }
+            else
+            {
+                CKDWORD prefix = reversed & rootMask;
+                if (prefix != subPrefix)
+                {
+                    // Size the subtable for the codes that remain under this prefix
+                    subBits = len - rootBits;
+                    int subLeft = 1 << subBits;
+                    while (subBits + rootBits < maxLen)
+                    {
+                        subLeft -= (int)remaining[subBits + rootBits];
+                        if (subLeft <= 0)
+                            break;
+                        subBits++;
+                        subLeft <<= 1;
+                    }
+                    subPrefix = prefix;
+                    subOffset = used;
+                    used += 1u << subBits;
+                    if (table)
+                        table[prefix] = ENTRY(subOffset, VP8L_SUBTABLE | subBits, rootBits);
+                }
+                if (table)
+                    for (CKDWORD i = reversed >> rootBits; i < (1u << subBits); i += 1u << (len - rootBits))
+                        table[subOffset + i] = ENTRY(symbol, 0, len - rootBits);
+            }
+            remaining[len]--;
+        }
+    }
+    size = used;
+    return TRUE;
+}
+
+// Resolves one symbol; at least 15 bits must be buffered
+static inline CKDWORD DecodeSymbol(Vp8lBits &s, const CKDWORD *table, CKDWORD rootBits)
+{
+    CKDWORD entry = table[PeekBits(s, rootBits)];
+    if (entry & (VP8L_SUBTABLE << 8))
+    {
+        DropBits(s, rootBits);
+        entry = table[(entry >> 16) + PeekBits(s, (entry >> 8) & 0x7F)];
+    }
+    DropBits(s, entry & 0xFF);
+    return entry >> 16;
+}
+
+//=============================================================================
+// Decoder State
+//=============================================================================
+
+// Decode tables of all the codes of one image, appended as they are read
+struct Vp8lTablePool
+{
+    CKDWORD *entries;
+    CKDWORD size;
+    CKDWORD capacity;
+};
+
+struct Vp8lGroup
+{
+    CKDWORD tables[VP8L_CODES_PER_GROUP]; // offsets in the pool
+    CKBOOL trivialLiteral;                // red, blue and alpha take no bits
+    CKDWORD literal;                      // their values, as ARGB with green 0
+};
+
+// The codes of one image level: a single group, or one per block of the
+// entropy image (group indexes remapped to the groups actually used)
+struct Vp8lCodes
+{
+    Vp8lTablePool pool;
+    Vp8lGroup *groups;
+    CKDWORD *entropy;
+    CKDWORD entropyBits;
+    CKDWORD entropyWidth;
+    CKDWORD *cache;
+    CKDWORD cacheBits;
+};
+
+struct Vp8lTransform
+{
+    CKDWORD type;
+    CKDWORD bits;
+    CKDWORD xsize; // width of the image the transform applies to
+    CKDWORD *data; // predictor modes, color elements or the color map
+};
+
+struct Vp8lDecoder
+{
+    Vp8lBits bits;
+    const WebpDsp *dsp;
+    CKWORD codeLengths[VP8L_MAX_ALPHABET];
+    CKBYTE padded[8];
+};
+
+static void InitDecoder(Vp8lDecoder &d, const CKBYTE *data, CKDWORD size)
+{
+    // libwebp reads through a 64-bit window, so a stream shorter than 8
+    // bytes reads as if padded with zeros to 8
+    if (size < 8)
+    {
+        memset(d.padded, 0, sizeof(d.padded));
+        memcpy(d.padded, data, size);
+        data = d.padded;
+        size = 8;
+    }
+    d.bits.in = data;
+    d.bits.inEnd = data + size;
+    d.bits.bitbuf = 0;
+    d.bits.bitCount = 0;
+    d.bits.overrun = 0;
+    d.dsp = &WEBP_GetDsp();
+}
+
+static void InitCodes(Vp8lCodes &codes)
+{
+    memset(&codes, 0, sizeof(codes));
+}
+
+static void FreeCodes(Vp8lCodes &codes)
+{
+    delete[] codes.pool.entries;
+    delete[] codes.groups;
+    delete[] codes.entropy;
+    delete[] codes.cache;
+    InitCodes(codes);
+}
+
+static CKDWORD PoolAppend(Vp8lTablePool &pool, CKDWORD count)
+{
+    if (pool.size + count > pool.capacity)
+    {
+        CKDWORD capacity = pool.capacity ? pool.capacity * 2 : 4096;
+        while (capacity < pool.size + count)
+            capacity *= 2;
+        CKDWORD *entries = new CKDWORD[capacity];
+        if (pool.size)
+            memcpy(entries, pool.entries, pool.size * sizeof(CKDWORD));
+        delete[] pool.entries;
+        pool.entries = entries;
+        pool.capacity = capacity;
+    }
+    CKDWORD offset = pool.size;
+    pool.size += count;
+    return offset;
+}
+
+//=============================================================================
+// Reading Codes
+//=============================================================================
+static CKBOOL ReadCodeLengths(Vp8lDecoder &d, const CKWORD *codeLengthLengths, CKDWORD alphabetSize)
+{
+    static const CKBYTE RepeatExtraBits[3] = {2, 3, 7};
+    static const CKBYTE RepeatOffset[3] = {3, 3, 11};
+
+    Vp8lBits &s = d.bits;
+    CKDWORD table[1 << VP8L_LENGTHS_ROOT_BITS];
+    CKDWORD tableSize;
+    if (!BuildCode(codeLengthLengths, VP8L_CODE_LENGTH_CODES, VP8L_LENGTHS_ROOT_BITS, table, tableSize))
+        return FALSE;
+
+    CKDWORD maxSymbol = alphabetSize;
+    if (ReadBits(s, 1))
+    {
+        CKDWORD lengthBits = 2 + 2 * ReadBits(s, 3);
+        maxSymbol = 2 + ReadBits(s, lengthBits);
+        if (maxSymbol > alphabetSize)
+            return FALSE;
+    }
+
+    CKWORD *lengths = d.codeLengths;
+    CKWORD previous = 8;
+    CKDWORD symbol = 0;
+    while (symbol < alphabetSize && maxSymbol-- > 0)
+    {
+        if (s.bitCount < 16)
+            Refill(s);
+        CKDWORD code = DecodeSymbol(s, table, VP8L_LENGTHS_ROOT_BITS);
+        if (code < 16)
+        {
+            lengths[symbol++] = (CKWORD)code;
+            if (code)
+                previous = (CKWORD)code;
+            continue;
+        }
+        // 16 repeats the previous non-zero length, 17 and 18 repeat zero
+        CKDWORD slot = code - 16;
+        CKDWORD repeat = ReadBits(s, RepeatExtraBits[slot]) + RepeatOffset[slot];
+        if (repeat > alphabetSize - symbol)
+            return FALSE;
+        CKWORD value = (code == 16) ? previous : 0;
+        while (repeat-- > 0)
+            lengths[symbol++] = value;
+    }
+    return TRUE;
+}
+
+// Reads one code. Its table is appended to pool, unless pool is NULL (the
+// code of an unused group, only checked).
+static CKBOOL ReadCode(Vp8lDecoder &d, CKDWORD alphabetSize, Vp8lTablePool *pool, CKDWORD &offset)
+{
+    Vp8lBits &s = d.bits;
+    CKWORD *lengths = d.codeLengths;
+    memset(lengths, 0, alphabetSize * sizeof(CKWORD));
+
+    if (ReadBits(s, 1))
+    {
+        // Simple code: one or two symbols below 256, one bit each. A symbol
+        // past the alphabet is ignored (there is room for it in lengths).
+        CKDWORD symbolCount = ReadBits(s, 1) + 1;
+        lengths[ReadBits(s, ReadBits(s, 1) ? 8 : 1)] = 1;
+        if (symbolCount == 2)
+            lengths[ReadBits(s, 8)] = 1;
+    }
+    else
+    {
+        CKWORD codeLengthLengths[VP8L_CODE_LENGTH_CODES];
+        memset(codeLengthLengths, 0, sizeof(codeLengthLengths));
+        CKDWORD count = ReadBits(s, 4) + 4;
+        for (CKDWORD i = 0; i < count; i++)
+            codeLengthLengths[CodeLengthOrder[i]] = (CKWORD)ReadBits(s, 3);
+        if (!ReadCodeLengths(d, codeLengthLengths, alphabetSize))
+            return FALSE;
+    }
+    if (IsOverrun(s))
+        return FALSE;
+
+    CKDWORD size;
+    if (!BuildCode(lengths, alphabetSize, VP8L_ROOT_BITS, NULL, size))
+        return FALSE;
+    if (pool)
+    {
+        offset = PoolAppend(*pool, size);
+        BuildCode(lengths, alphabetSize, VP8L_ROOT_BITS, pool->entries + offset, size);
+    }
+    return TRUE;
+}
+
+static int DecodeSubImage(Vp8lDecoder &d, CKDWORD xsize, CKDWORD ysize, CKDWORD *&pixels);
+
+static int ReadColorCacheBits(Vp8lDecoder &d, CKDWORD &cacheBits)
+{
+    cacheBits = 0;
+    if (ReadBits(d.bits, 1))
+    {
+        cacheBits = ReadBits(d.bits, 4);
+        if (cacheBits < 1 || cacheBits > VP8L_MAX_CACHE_BITS)
+            return CKBITMAPERROR_FILECORRUPTED;
+    }
+    return 0;
+}
+
+// Reads the color cache size, the entropy image (main image only) and the
+// codes of every group
+static int ReadCodes(Vp8lDecoder &d, CKDWORD xsize, CKDWORD ysize, CKBOOL isMainImage, Vp8lCodes &codes)
+{
+    int result = ReadColorCacheBits(d, codes.cacheBits);
+    if (result != 0)
+        return result;
+
+    CKDWORD groupCount = 1;
+    CKDWORD usedGroupCount = 1;
+    int *mapping = NULL;
+    if (isMainImage && ReadBits(d.bits, 1))
+    {
+        codes.entropyBits = ReadBits(d.bits, 3) + 2;
+        codes.entropyWidth = SubSampleSize(xsize, codes.entropyBits);
+        CKDWORD entropyHeight = SubSampleSize(ysize, codes.entropyBits);
+        result = DecodeSubImage(d, codes.entropyWidth, entropyHeight, codes.entropy);
+        if (result != 0)
+            return result;
+
+        // The group index is in red and green. Only the groups in use get
+        // tables; the format allows 65536 whatever the image size.
+        CKDWORD entropySize = codes.entropyWidth * entropyHeight;
+        groupCount = 0;
+        for (CKDWORD i = 0; i < entropySize; i++)
+        {
+            codes.entropy[i] = (codes.entropy[i] >> 8) & 0xffff;
+            if (codes.entropy[i] >= groupCount)
+                groupCount = codes.entropy[i] + 1;
+        }
+        mapping = new int[groupCount];
+        for (CKDWORD g = 0; g < groupCount; g++)
+            mapping[g] = -1;
+        usedGroupCount = 0;
+        for (CKDWORD i = 0; i < entropySize; i++)
+        {
+            int &mapped = mapping[codes.entropy[i]];
+            if (mapped < 0)
+                mapped = (int)usedGroupCount++;
+            codes.entropy[i] = (CKDWORD)mapped;
+        }
+    }
+    if (IsOverrun(d.bits))
+    {
+        delete[] mapping;
+        return CKBITMAPERROR_FILECORRUPTED;
+    }
+
+    codes.groups = new Vp8lGroup[usedGroupCount];
+    for (CKDWORD g = 0; g < groupCount && result == 0; g++)
+    {
+        Vp8lGroup *group = NULL;
+        if (!mapping)
+            group = &codes.groups[g];
+        else if (mapping[g] >= 0)
+            group = &codes.groups[mapping[g]];
+
+        for (int j = 0; j < VP8L_CODES_PER_GROUP; j++)
+        {
+            CKDWORD alphabetSize = AlphabetSize[j];
+            if (j == 0 && codes.cacheBits > 0)
+                alphabetSize += 1u << codes.cacheBits;
+            CKDWORD offset = 0;
+            if (!ReadCode(d, alphabetSize, group ? &codes.pool : NULL, offset))
+            {
+                result = CKBITMAPERROR_FILECORRUPTED;
+                break;
+            }
+            if (group)
+                group->tables[j] = offset;
+        }
+        if (group && result == 0)
+        {
+            // Single-symbol codes have no subtables, so their first entry is the symbol
+            const CKDWORD *pool = codes.pool.entries;
+            CKDWORD red = pool[group->tables[1]];
+            CKDWORD blue = pool[group->tables[2]];
+            CKDWORD alpha = pool[group->tables[3]];
+            group->trivialLiteral = ((red | blue | alpha) & 0xFFFF) == 0;
+            group->literal = ((alpha >> 16) << 24) | ((red >> 16) << 16) | (blue >> 16);
+        }
+    }
+    delete[] mapping;
+    if (result != 0)
+        return result;
+
+    if (codes.cacheBits > 0)
+    {
+        codes.cache = new CKDWORD[1u << codes.cacheBits];
+        memset(codes.cache, 0, sizeof(CKDWORD) << codes.cacheBits);
+    }
+    return 0;
+}
+
+//=============================================================================
+// Entropy-Coded Pixels
+//=============================================================================
+
+// Length or distance from its prefix symbol and extra bits
+static inline CKDWORD ReadCopyValue(Vp8lBits &s, CKDWORD symbol)
+{
+    if (symbol < 4)
+        return symbol + 1;
+    CKDWORD extraBits = (symbol - 2) >> 1;
+    CKDWORD offset = (2 + (symbol & 1)) << extraBits;
+    return offset + ReadBits(s, extraBits) + 1;
+}
+
+static inline CKDWORD PlaneCodeToDistance(CKDWORD width, CKDWORD planeCode)
+{
+    if (planeCode > 120)
+        return planeCode - 120;
+    int distCode = CodeToPlane[planeCode - 1];
+    int dist = (distCode >> 4) * (int)width + (8 - (distCode & 0xf));
+    return dist >= 1 ? (CKDWORD)dist : 1;
+}
+
+static inline const Vp8lGroup *GroupAt(const Vp8lCodes &codes, CKDWORD x, CKDWORD y)
+{
+    if (!codes.entropy)
+        return codes.groups;
+    CKDWORD bits = codes.entropyBits;
+    return &codes.groups[codes.entropy[(y >> bits) * codes.entropyWidth + (x >> bits)]];
+}
+
+static int DecodePixels(Vp8lDecoder &d, const Vp8lCodes &codes, CKDWORD width, CKDWORD height, CKDWORD *data)
+{
+    Vp8lBits &s = d.bits;
+    const CKDWORD *pool = codes.pool.entries;
+    CKDWORD *cache = codes.cache;
+    CKDWORD cacheShift = 32 - codes.cacheBits;
+    CKDWORD mask = codes.entropy ? (1u << codes.entropyBits) - 1 : 0xFFFFFFFF;
+    CKDWORD total = width * height;
+    CKDWORD pos = 0;
+    CKDWORD x = 0;
+    CKDWORD y = 0;
+    const Vp8lGroup *group = codes.groups;
+    while (pos < total)
+    {
+        if ((x & mask) == 0)
+            group = GroupAt(codes, x, y);
+        if (s.bitCount < 32)
+            Refill(s);
+        CKDWORD code = DecodeSymbol(s, pool + group->tables[0], VP8L_ROOT_BITS);
+
+        CKDWORD count = 1;
+        if (code < VP8L_LITERAL_CODES)
+        {
+            CKDWORD pixel;
+            if (group->trivialLiteral)
+            {
+                pixel = group->literal | (code << 8);
+            }
+            else
+            {
+                CKDWORD red = DecodeSymbol(s, pool + group->tables[1], VP8L_ROOT_BITS);
+                if (s.bitCount < 32)
+                    Refill(s);
+                CKDWORD blue = DecodeSymbol(s, pool + group->tables[2], VP8L_ROOT_BITS);
+                CKDWORD alpha = DecodeSymbol(s, pool + group->tables[3], VP8L_ROOT_BITS);
+                pixel = (alpha << 24) | (red << 16) | (code << 8) | blue;
+            }
+            data[pos] = pixel;
+        }
+        else if (code < VP8L_LITERAL_CODES + VP8L_LENGTH_CODES)
+        {
+            count = ReadCopyValue(s, code - VP8L_LITERAL_CODES);
+            if (s.bitCount < 32)
+                Refill(s);
+            CKDWORD distSymbol = DecodeSymbol(s, pool + group->tables[4], VP8L_ROOT_BITS);
+            CKDWORD dist = PlaneCodeToDistance(width, ReadCopyValue(s, distSymbol));
+            if (IsOverrun(s) || dist > pos || count > total - pos)
+                return CKBITMAPERROR_FILECORRUPTED;
+            // Overlapping copies repeat the pattern, so go pixel by pixel
+            const CKDWORD *src = data + pos - dist;
+            for (CKDWORD i = 0; i < count; i++)
+                data[pos + i] = src[i];
+        }
+        else
+        {
+            data[pos] = cache[code - VP8L_LITERAL_CODES - VP8L_LENGTH_CODES];
+        }
+
+        if (cache)
+        {
+            for (CKDWORD i = 0; i < count; i++)
+            {
+                CKDWORD pixel = data[pos + i];
+                cache[(pixel * VP8L_COLOR_CACHE_MULTIPLIER) >> cacheShift] = pixel;
+            }
+        }
+        pos += count;
+        x += count;
+        if (x >= width)
+        {
+            while (x >= width)
+            {
+                x -= width;
+                y++;
+            }
+            if (IsOverrun(s))
+                return CKBITMAPERROR_FILECORRUPTED;
+        }
+        // A copy can end inside a block of the entropy image
+        if (count > 1 && (x & mask) != 0 && pos < total)
+            group = GroupAt(codes, x, y);
+    }
+    return IsOverrun(s) ? CKBITMAPERROR_FILECORRUPTED : 0;
+}
+
+// Decodes a predictor, color transform, color map or entropy image: a
+// color cache and a single group of codes, no transforms
+static int DecodeSubImage(Vp8lDecoder &d, CKDWORD xsize, CKDWORD ysize, CKDWORD *&pixels)
+{
+    pixels = NULL;
+    Vp8lCodes codes;
+    InitCodes(codes);
+    int result = ReadCodes(d, xsize, ysize, FALSE, codes);
+    if (result == 0)
+    {
+        pixels = new CKDWORD[xsize * ysize];
+        result = DecodePixels(d, codes, xsize, ysize, pixels);
+    }
+    FreeCodes(codes);
+    if (result != 0)
+    {
+        delete[] pixels;
+        pixels = NULL;
+    }
+    return result;
+}
+
+//=============================================================================
+// Inverse Transforms
+//=============================================================================
+static void InversePredictor(const WebpDsp &dsp, const Vp8lTransform &t, CKDWORD *data, CKDWORD height)
+{
+    int width = (int)t.xsize;
+    CKDWORD tileWidth = 1u << t.bits;
+    CKDWORD tilesPerRow = SubSampleSize(t.xsize, t.bits);
+
+    // The first row predicts from black, then from the left
+    data[0] += 0xff000000u;
+    dsp.predictorAdd[1](data + 1, data, width - 1, data + 1);
+
+    for (CKDWORD y = 1; y < height; y++)
+    {
+        CKDWORD *row = data + y * t.xsize;
+        const CKDWORD *upper = row - width;
+        const CKDWORD *modes = t.data + (y >> t.bits) * tilesPerRow;
+
+        // The first column predicts from the top
+        dsp.predictorAdd[2](row, upper, 1, row);
+        int x = 1;
+        while (x < width)
+        {
+            CKDWORD mode = (modes[x >> t.bits] >> 8) & 0xf;
+            int end = (int)(((CKDWORD)x & ~(tileWidth - 1)) + tileWidth);
+            if (end > width)
+                end = width;
+            dsp.predictorAdd[mode](row + x, upper + x, end - x, row + x);
+            x = end;
+        }
+    }
+}
+
+static void InverseCrossColor(const WebpDsp &dsp, const Vp8lTransform &t, CKDWORD *data, CKDWORD height)
+{
+    CKDWORD tileWidth = 1u << t.bits;
+    CKDWORD tilesPerRow = SubSampleSize(t.xsize, t.bits);
+    for (CKDWORD y = 0; y < height; y++)
+    {
+        CKDWORD *row = data + y * t.xsize;
+        const CKDWORD *elements = t.data + (y >> t.bits) * tilesPerRow;
+        for (CKDWORD x = 0; x < t.xsize; x += tileWidth)
+        {
+            CKDWORD count = (t.xsize - x < tileWidth) ? t.xsize - x : tileWidth;
+            dsp.colorTransform(elements[x >> t.bits], row + x, (int)count, row + x);
+        }
+    }
+}
+
+// src holds the packed indexes (several per pixel when the map is small);
+// dst may be src when they are not packed
+static void InverseColorIndexing(const Vp8lTransform &t, const CKDWORD *src, CKDWORD height, CKDWORD *dst)
+{
+    const CKDWORD *map = t.data;
+    if (t.bits == 0)
+    {
+        CKDWORD count = t.xsize * height;
+        for (CKDWORD i = 0; i < count; i++)
+            dst[i] = map[(src[i] >> 8) & 0xff];
+        return;
+    }
+
+    CKDWORD bitsPerIndex = 8 >> t.bits;
+    CKDWORD indexMask = (1u << bitsPerIndex) - 1;
+    CKDWORD perPixel = (1u << t.bits) - 1;
+    CKDWORD packedWidth = SubSampleSize(t.xsize, t.bits);
+    for (CKDWORD y = 0; y < height; y++)
+    {
+        const CKDWORD *in = src + y * packedWidth;
+        CKDWORD *out = dst + y * t.xsize;
+        CKDWORD packed = 0;
+        for (CKDWORD x = 0; x < t.xsize; x++)
+        {
+            if ((x & perPixel) == 0)
+                packed = (in[x >> t.bits] >> 8) & 0xff;
+            out[x] = map[packed & indexMask];
+            packed >>= bitsPerIndex;
+        }
+    }
+}
+
+//=============================================================================
+// Image Decoding
+//=============================================================================
+static int ReadTransform(Vp8lDecoder &d, CKDWORD &xsize, CKDWORD height, Vp8lTransform &t)
+{
+    t.xsize = xsize;
+    t.bits = 0;
+    t.data = NULL;
+    switch (t.type)
+    {
+    case VP8L_PREDICTOR_TRANSFORM:
+    case VP8L_CROSS_COLOR_TRANSFORM:
+        t.bits = ReadBits(d.bits, 3) + 2;
+        return DecodeSubImage(d, SubSampleSize(xsize, t.bits), SubSampleSize(height, t.bits), t.data);
+    case VP8L_COLOR_INDEXING_TRANSFORM:
+    {
+        CKDWORD colorCount = ReadBits(d.bits, 8) + 1;
+        t.bits = (colorCount > 16) ? 0 : (colorCount > 4) ? 1 : (colorCount > 2) ? 2 : 3;
+        xsize = SubSampleSize(xsize, t.bits);
+        CKDWORD *colors;
+        int result = DecodeSubImage(d, colorCount, 1, colors);
+        if (result != 0)
+            return result;
+
+        // The map is delta-coded; indexes past its end give transparent black
+        CKDWORD mapSize = 1u << (8 >> t.bits);
+        t.data = new CKDWORD[mapSize];
+        memset(t.data, 0, mapSize * sizeof(CKDWORD));
+        t.data[0] = colors[0];
+        for (CKDWORD i = 1; i < colorCount; i++)
+        {
+            CKDWORD a = colors[i];
+            CKDWORD b = t.data[i - 1];
+            t.data[i] = (((a & 0xff00ff00u) + (b & 0xff00ff00u)) & 0xff00ff00u) |
+                        (((a & 0x00ff00ffu) + (b & 0x00ff00ffu)) & 0x00ff00ffu);
+        }
+        delete[] colors;
+        return 0;
+    }
+    default: // subtract green has no data
+        return 0;
+    }
+}
+
+// Decodes the main image of a stream: transforms, codes, pixels, then the
+// inverse transforms in reverse order. out receives width * height pixels.
+static int DecodeImage(Vp8lDecoder &d, CKDWORD width, CKDWORD height, CKDWORD *out)
+{
+    Vp8lTransform transforms[VP8L_MAX_TRANSFORMS];
+    int transformCount = 0;
+    CKDWORD seen = 0;
+    CKDWORD xsize = width; // narrower than width when the color indexes are packed
+    int result = 0;
+    while (result == 0 && ReadBits(d.bits, 1))
+    {
+        CKDWORD type = ReadBits(d.bits, 2);
+        if (seen & (1u << type))
+        {
+            result = CKBITMAPERROR_FILECORRUPTED;
+            break;
+        }
+        seen |= 1u << type;
+        Vp8lTransform &t = transforms[transformCount++];
+        t.type = type;
+        result = ReadTransform(d, xsize, height, t);
+    }
+
+    Vp8lCodes codes;
+    InitCodes(codes);
+    CKDWORD *pixels = NULL;
+    if (result == 0)
+        result = ReadCodes(d, xsize, height, TRUE, codes);
+    if (result == 0)
+    {
+        pixels = (xsize == width) ? out : new CKDWORD[xsize * height];
+        result = DecodePixels(d, codes, xsize, height, pixels);
+    }
+    FreeCodes(codes);
+
+    if (result == 0)
+    {
+        const WebpDsp &dsp = *d.dsp;
+        CKDWORD *current = pixels;
+        for (int i = transformCount - 1; i >= 0; i--)
+        {
+            const Vp8lTransform &t = transforms[i];
+            switch (t.type)
+            {
+            case VP8L_PREDICTOR_TRANSFORM:
+                InversePredictor(dsp, t, current, height);
+                break;
+            case VP8L_CROSS_COLOR_TRANSFORM:
+                InverseCrossColor(dsp, t, current, height);
+                break;
+            case VP8L_SUBTRACT_GREEN_TRANSFORM:
+                dsp.addGreen(current, (int)(t.xsize * height), current);
+                break;
+            case VP8L_COLOR_INDEXING_TRANSFORM:
+                InverseColorIndexing(t, current, height, out);
+                current = out;
+                break;
+            }
+        }
+    }
+
+    if (pixels != out)
+        delete[] pixels;
+    for (int i = 0; i < transformCount; i++)
+        delete[] transforms[i].data;
+    return result;
+}
+
+int WEBP_ReadLosslessHeader(const CKBYTE *data, CKDWORD size, CKDWORD &width, CKDWORD &height, CKBOOL &hasAlpha)
+{
+    if (!data || size < WEBP_VP8L_HEADER_SIZE)
+        return CKBITMAPERROR_READERROR;
+    if (data[0] != WEBP_VP8L_SIGNATURE)
+        return CKBITMAPERROR_FILECORRUPTED;
+    CKDWORD bits = data[1] | ((CKDWORD)data[2] << 8) | ((CKDWORD)data[3] << 16) | ((CKDWORD)data[4] << 24);
+    if ((bits >> 29) != 0) // version
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    width = (bits & 0x3FFF) + 1;
+    height = ((bits >> 14) & 0x3FFF) + 1;
+    hasAlpha = (bits >> 28) & 1;
+    return 0;
+}
+
+int WEBP_DecodeLossless(const CKBYTE *data, CKDWORD size, CKDWORD *argb)
+{
+    CKDWORD width, height;
+    CKBOOL hasAlpha;
+    int result = WEBP_ReadLosslessHeader(data, size, width, height, hasAlpha);
+    if (result != 0)
+        return result;
+
+    // The header is the first 40 bits, so the stream goes on byte-aligned
+    Vp8lDecoder *d = new Vp8lDecoder;
+    InitDecoder(*d, data + WEBP_VP8L_HEADER_SIZE, size - WEBP_VP8L_HEADER_SIZE);
+    result = DecodeImage(*d, width, height, argb);
+    delete d;
+    return result;
+}
+
+int WEBP_DecodeLosslessAlpha(const CKBYTE *data, CKDWORD size, CKDWORD width, CKDWORD height, CKBYTE *alpha)
+{
+    if (!data || size == 0)
+        return CKBITMAPERROR_READERROR;
+    CKDWORD count = width * height;
+    CKDWORD *argb = new CKDWORD[count];
+    Vp8lDecoder *d = new Vp8lDecoder;
+    InitDecoder(*d, data, size);
+    int result = DecodeImage(*d, width, height, argb);
+    delete d;
+    if (result == 0)
+    {
+        for (CKDWORD i = 0; i < count; i++)
+            alpha[i] = (CKBYTE)(argb[i] >> 8);
+    }
+    delete[] argb;
+    return result;
+}
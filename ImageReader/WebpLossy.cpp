@@ -0,0 +1,1789 @@
+#include "WebpCodec.h"
+#include "WebpDsp.h"
+#include "ImageThreadPool.h"
+
+//=============================================================================
+// VP8 Constants
+//=============================================================================
+#define VP8_NUM_TYPES 4
+#define VP8_NUM_BANDS 8
+#define VP8_NUM_CTX 3
+#define VP8_NUM_PROBAS 11
+#define VP8_NUM_SEGMENTS 4
+#define VP8_MAX_PARTITIONS 8
+
+// Intra modes. The 16x16 and chroma modes share the first four values; the
+// last three are DC without the missing neighbours (see CheckMode).
+#define VP8_B_DC_PRED 0
+#define VP8_B_TM_PRED 1
+#define VP8_B_VE_PRED 2
+#define VP8_B_HE_PRED 3
+#define VP8_B_RD_PRED 4
+#define VP8_B_VR_PRED 5
+#define VP8_B_LD_PRED 6
+#define VP8_B_VL_PRED 7
+#define VP8_B_HD_PRED 8
+#define VP8_B_HU_PRED 9
+#define VP8_DC_PRED_NOTOP 4
+#define VP8_DC_PRED_NOLEFT 5
+#define VP8_DC_PRED_NOTOPLEFT 6
+
+// Reconstruction work buffer: one macroblock with its top and left samples,
+// Y above, U and V side by side below
+#define VP8_BPS 32
+#define VP8_YUV_SIZE (VP8_BPS * 17 + VP8_BPS * 9)
+#define VP8_Y_OFF (VP8_BPS * 1 + 8)
+#define VP8_U_OFF (VP8_Y_OFF + VP8_BPS * 16 + VP8_BPS)
+#define VP8_V_OFF (VP8_U_OFF + 16)
+
+//=============================================================================
+// Tables (RFC 6386)
+//=============================================================================
+static const CKBYTE DcTable[128] = {
+    4,   5,   6,   7,   8,   9,   10,  10,  11,  12,  13,  14,  15,  16,  17,  17,  18,  19,  20,  20,  21,  21,
+    22,  22,  23,  23,  24,  25,  25,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  37,  38,  39,
+    40,  41,  42,  43,  44,  45,  46,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,  56,  57,  58,  59,  60,
+    61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,  72,  73,  74,  75,  76,  76,  77,  78,  79,  80,  81,
+    82,  83,  84,  85,  86,  87,  88,  89,  91,  93,  95,  96,  98,  100, 101, 102, 104, 106, 108, 110, 112, 114,
+    116, 118, 122, 124, 126, 128, 130, 132, 134, 136, 138, 140, 143, 145, 148, 151, 154, 157};
+
+static const CKWORD AcTable[128] = {
+    4,   5,   6,   7,   8,   9,   10,  11,  12,  13,  14,  15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25,
+    26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,  41,  42,  43,  44,  45,  46,  47,
+    48,  49,  50,  51,  52,  53,  54,  55,  56,  57,  58,  60,  62,  64,  66,  68,  70,  72,  74,  76,  78,  80,
+    82,  84,  86,  88,  90,  92,  94,  96,  98,  100, 102, 104, 106, 108, 110, 112, 114, 116, 119, 122, 125, 128,
+    131, 134, 137, 140, 143, 146, 149, 152, 155, 158, 161, 164, 167, 170, 173, 177, 181, 185, 189, 193, 197, 201,
+    205, 209, 213, 217, 221, 225, 229, 234, 239, 245, 249, 254, 259, 264, 269, 274, 279, 284};
+
+// Default coefficient probabilities, by type, band, context and token tree node
+static const CKBYTE CoeffsProba0[VP8_NUM_TYPES][VP8_NUM_BANDS][VP8_NUM_CTX][VP8_NUM_PROBAS] = {
+    {
+        {
+            {128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128},
+            {128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128},
+            {128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128},
+        },
+        {
+            {253, 136, 254, 255, 228, 219, 128, 128, 128, 128, 128},
+            {189, 129, 242, 255, 227, 213, 255, 219, 128, 128, 128},
+            {106, 126, 227, 252, 214, 209, 255, 255, 128, 128, 128},
+        },
+        {
+            {1, 98, 248, 255, 236, 226, 255, 255, 128, 128, 128},
+            {181, 133, 238, 254, 221, 234, 255, 154, 128, 128, 128},
+            {78, 134, 202, 247, 198, 180, 255, 219, 128, 128, 128},
+        },
+        {
+            {1, 185, 249, 255, 243, 255, 128, 128, 128, 128, 128},
+            {184, 150, 247, 255, 236, 224, 128, 128, 128, 128, 128},
+            {77, 110, 216, 255, 236, 230, 128, 128, 128, 128, 128},
+        },
+        {
+            {1, 101, 251, 255, 241, 255, 128, 128, 128, 128, 128},
+            {170, 139, 241, 252, 236, 209, 255, 255, 128, 128, 128},
+            {37, 116, 196, 243, 228, 255, 255, 255, 128, 128, 128},
+        },
+        {
+            {1, 204, 254, 255, 245, 255, 128, 128, 128, 128, 128},
+            {207, 160, 250, 255, 238, 128, 128, 128, 128, 128, 128},
+            {102, 103, 231, 255, 211, 171, 128, 128, 128, 128, 128},
+        },
+        {
+            {1, 152, 252, 255, 240, 255, 128, 128, 128, 128, 128},
+            {177, 135, 243, 255, 234, 225, 128, 128, 128, 128, 128},
+            {80, 129, 211, 255, 194, 224, 128, 128, 128, 128, 128},
+        },
+        {
+            {1, 1, 255, 128, 128, 128, 128, 128, 128, 128, 128},
+            {246, 1, 255, 128, 128, 128, 128, 128, 128, 128, 128},
+            {255, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128},
+        },
+    },
+    {
+        {
+            {198, 35, 237, 223, 193, 187, 162, 160, 145, 155, 62},
+            {131, 45, 198, 221, 172, 176, 220, 157, 252, 221, 1},
+            {68, 47, 146, 208, 149, 167, 221, 162, 255, 223, 128},
+        },
+        {
+            {1, 149, 241, 255, 221, 224, 255, 255, 128, 128, 128},
+            {184, 141, 234, 253, 222, 220, 255, 199, 128, 128, 128},
+            {81, 99, 181, 242, 176, 190, 249, 202, 255, 255, 128},
+        },
+        {
+            {1, 129, 232, 253, 214, 197, 242, 196, 255, 255, 128},
+            {99, 121, 210, 250, 201, 198, 255, 202, 128, 128, 128},
+            {23, 91, 163, 242, 170, 187, 247, 210, 255, 255, 128},
+        },
+        {
+            {1, 200, 246, 255, 234, 255, 128, 128, 128, 128, 128},
+            {109, 178, 241, 255, 231, 245, 255, 255, 128, 128, 128},
+            {44, 130, 201, 253, 205, 192, 255, 255, 128, 128, 128},
+        },
+        {
+            {1, 132, 239, 251, 219, 209, 255, 165, 128, 128, 128},
+            {94, 136, 225, 251, 218, 190, 255, 255, 128, 128, 128},
+            {22, 100, 174, 245, 186, 161, 255, 199, 128, 128, 128},
+        },
+        {
+            {1, 182, 249, 255, 232, 235, 128, 128, 128, 128, 128},
+            {124, 143, 241, 255, 227, 234, 128, 128, 128, 128, 128},
+            {35, 77, 181, 251, 193, 211, 255, 205, 128, 128, 128},
+        },
+        {
+            {1, 157, 247, 255, 236, 231, 255, 255, 128, 128, 128},
+            {121, 141, 235, 255, 225, 227, 255, 255, 128, 128, 128},
+            {45, 99, 188, 251, 195, 217, 255, 224, 128, 128, 128},
+        },
+        {
+            {1, 1, 251, 255, 213, 255, 128, 128, 128, 128, 128},
+            {203, 1, 248, 255, 255, 128, 128, 128, 128, 128, 128},
+            {137, 1, 177, 255, 224, 255, 128, 128, 128, 128, 128},
+        },
+    },
+    {
+        {
+            {253, 9, 248, 251, 207, 208, 255, 192, 128, 128, 128},
+            {175, 13, 224, 243, 193, 185, 249, 198, 255, 255, 128},
+            {73, 17, 171, 221, 161, 179, 236, 167, 255, 234, 128},
+        },
+        {
+            {1, 95, 247, 253, 212, 183, 255, 255, 128, 128, 128},
+            {239, 90, 244, 250, 211, 209, 255, 255, 128, 128, 128},
+            {155, 77, 195, 248, 188, 195, 255, 255, 128, 128, 128},
+        },
+        {
+            {1, 24, 239, 251, 218, 219, 255, 205, 128, 128, 128},
+            {201, 51, 219, 255, 196, 186, 128, 128, 128, 128, 128},
+            {69, 46, 190, 239, 201, 218, 255, 228, 128, 128, 128},
+        },
+        {
+            {1, 191, 251, 255, 255, 128, 128, 128, 128, 128, 128},
+            {223, 165, 249, 255, 213, 255, 128, 128, 128, 128, 128},
+            {141, 124, 248, 255, 255, 128, 128, 128, 128, 128, 128},
+        },
+        {
+            {1, 16, 248, 255, 255, 128, 128, 128, 128, 128, 128},
+            {190, 36, 230, 255, 236, 255, 128, 128, 128, 128, 128},
+            {149, 1, 255, 128, 128, 128, 128, 128, 128, 128, 128},
+        },
+        {
+            {1, 226, 255, 128, 128, 128, 128, 128, 128, 128, 128},
+            {247, 192, 255, 128, 128, 128, 128, 128, 128, 128, 128},
+            {240, 128, 255, 128, 128, 128, 128, 128, 128, 128, 128},
+        },
+        {
+            {1, 134, 252, 255, 255, 128, 128, 128, 128, 128, 128},
+            {213, 62, 250, 255, 255, 128, 128, 128, 128, 128, 128},
+            {55, 93, 255, 128, 128, 128, 128, 128, 128, 128, 128},
+        },
+        {
+            {128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128},
+            {128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128},
+            {128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128},
+        },
+    },
+    {
+        {
+            {202, 24, 213, 235, 186, 191, 220, 160, 240, 175, 255},
+            {126, 38, 182, 232, 169, 184, 228, 174, 255, 187, 128},
+            {61, 46, 138, 219, 151, 178, 240, 170, 255, 216, 128},
+        },
+        {
+            {1, 112, 230, 250, 199, 191, 247, 159, 255, 255, 128},
+            {166, 109, 228, 252, 211, 215, 255, 174, 128, 128, 128},
+            {39, 77, 162, 232, 172, 180, 245, 178, 255, 255, 128},
+        },
+        {
+            {1, 52, 220, 246, 198, 199, 249, 220, 255, 255, 128},
+            {124, 74, 191, 243, 183, 193, 250, 221, 255, 255, 128},
+            {24, 71, 130, 219, 154, 170, 243, 182, 255, 255, 128},
+        },
+        {
+            {1, 182, 225, 249, 219, 240, 255, 224, 128, 128, 128},
+            {149, 150, 226, 252, 216, 205, 255, 171, 128, 128, 128},
+            {28, 108, 170, 242, 183, 194, 254, 223, 255, 255, 128},
+        },
+        {
+            {1, 81, 230, 252, 204, 203, 255, 192, 128, 128, 128},
+            {123, 102, 209, 247, 188, 196, 255, 233, 128, 128, 128},
+            {20, 95, 153, 243, 164, 173, 255, 203, 128, 128, 128},
+        },
+        {
+            {1, 222, 248, 255, 216, 213, 128, 128, 128, 128, 128},
+            {168, 175, 246, 252, 235, 205, 255, 255, 128, 128, 128},
+            {47, 116, 215, 255, 211, 212, 255, 255, 128, 128, 128},
+        },
+        {
+            {1, 121, 236, 253, 212, 214, 255, 255, 128, 128, 128},
+            {141, 84, 213, 252, 201, 202, 255, 219, 128, 128, 128},
+            {42, 80, 160, 240, 162, 185, 255, 205, 128, 128, 128},
+        },
+        {
+            {1, 1, 255, 128, 128, 128, 128, 128, 128, 128, 128},
+            {244, 1, 255, 128, 128, 128, 128, 128, 128, 128, 128},
+            {238, 1, 255, 128, 128, 128, 128, 128, 128, 128, 128},
+        },
+    },
+};
+
+// Probabilities that the frame header updates a coefficient probability
+static const CKBYTE CoeffsUpdateProba[VP8_NUM_TYPES][VP8_NUM_BANDS][VP8_NUM_CTX][VP8_NUM_PROBAS] = {
+    {
+        {
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {176, 246, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {223, 241, 252, 255, 255, 255, 255, 255, 255, 255, 255},
+            {249, 253, 253, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 244, 252, 255, 255, 255, 255, 255, 255, 255, 255},
+            {234, 254, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {253, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 246, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {239, 253, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {254, 255, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 248, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {251, 255, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 253, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {251, 254, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {254, 255, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 254, 253, 255, 254, 255, 255, 255, 255, 255, 255},
+            {250, 255, 254, 255, 254, 255, 255, 255, 255, 255, 255},
+            {254, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+    },
+    {
+        {
+            {217, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {225, 252, 241, 253, 255, 255, 254, 255, 255, 255, 255},
+            {234, 250, 241, 250, 253, 255, 253, 254, 255, 255, 255},
+        },
+        {
+            {255, 254, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {223, 254, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {238, 253, 254, 254, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 248, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {249, 254, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 253, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {247, 254, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 253, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {252, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 254, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {253, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 254, 253, 255, 255, 255, 255, 255, 255, 255, 255},
+            {250, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {254, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+    },
+    {
+        {
+            {186, 251, 250, 255, 255, 255, 255, 255, 255, 255, 255},
+            {234, 251, 244, 254, 255, 255, 255, 255, 255, 255, 255},
+            {251, 251, 243, 253, 254, 255, 254, 255, 255, 255, 255},
+        },
+        {
+            {255, 253, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {236, 253, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {251, 253, 253, 254, 254, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 254, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {254, 254, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 254, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {254, 254, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {254, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {254, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+    },
+    {
+        {
+            {248, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {250, 254, 252, 254, 255, 255, 255, 255, 255, 255, 255},
+            {248, 254, 249, 253, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 253, 253, 255, 255, 255, 255, 255, 255, 255, 255},
+            {246, 253, 253, 255, 255, 255, 255, 255, 255, 255, 255},
+            {252, 254, 251, 254, 254, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 254, 252, 255, 255, 255, 255, 255, 255, 255, 255},
+            {248, 254, 253, 255, 255, 255, 255, 255, 255, 255, 255},
+            {253, 255, 254, 254, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 251, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {245, 251, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {253, 253, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 251, 253, 255, 255, 255, 255, 255, 255, 255, 255},
+            {252, 253, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 254, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 252, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {249, 255, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 254, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 255, 253, 255, 255, 255, 255, 255, 255, 255, 255},
+            {250, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+        {
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {254, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+            {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255},
+        },
+    },
+};
+
+// 4x4 intra mode probabilities, by top and left mode
+static const CKBYTE BModesProba[10][10][9] = {
+    {
+        {231, 120, 48, 89, 115, 113, 120, 152, 112},
+        {152, 179, 64, 126, 170, 118, 46, 70, 95},
+        {175, 69, 143, 80, 85, 82, 72, 155, 103},
+        {56, 58, 10, 171, 218, 189, 17, 13, 152},
+        {114, 26, 17, 163, 44, 195, 21, 10, 173},
+        {121, 24, 80, 195, 26, 62, 44, 64, 85},
+        {144, 71, 10, 38, 171, 213, 144, 34, 26},
+        {170, 46, 55, 19, 136, 160, 33, 206, 71},
+        {63, 20, 8, 114, 114, 208, 12, 9, 226},
+        {81, 40, 11, 96, 182, 84, 29, 16, 36},
+    },
+    {
+        {134, 183, 89, 137, 98, 101, 106, 165, 148},
+        {72, 187, 100, 130, 157, 111, 32, 75, 80},
+        {66, 102, 167, 99, 74, 62, 40, 234, 128},
+        {41, 53, 9, 178, 241, 141, 26, 8, 107},
+        {74, 43, 26, 146, 73, 166, 49, 23, 157},
+        {65, 38, 105, 160, 51, 52, 31, 115, 128},
+        {104, 79, 12, 27, 217, 255, 87, 17, 7},
+        {87, 68, 71, 44, 114, 51, 15, 186, 23},
+        {47, 41, 14, 110, 182, 183, 21, 17, 194},
+        {66, 45, 25, 102, 197, 189, 23, 18, 22},
+    },
+    {
+        {88, 88, 147, 150, 42, 46, 45, 196, 205},
+        {43, 97, 183, 117, 85, 38, 35, 179, 61},
+        {39, 53, 200, 87, 26, 21, 43, 232, 171},
+        {56, 34, 51, 104, 114, 102, 29, 93, 77},
+        {39, 28, 85, 171, 58, 165, 90, 98, 64},
+        {34, 22, 116, 206, 23, 34, 43, 166, 73},
+        {107, 54, 32, 26, 51, 1, 81, 43, 31},
+        {68, 25, 106, 22, 64, 171, 36, 225, 114},
+        {34, 19, 21, 102, 132, 188, 16, 76, 124},
+        {62, 18, 78, 95, 85, 57, 50, 48, 51},
+    },
+    {
+        {193, 101, 35, 159, 215, 111, 89, 46, 111},
+        {60, 148, 31, 172, 219, 228, 21, 18, 111},
+        {112, 113, 77, 85, 179, 255, 38, 120, 114},
+        {40, 42, 1, 196, 245, 209, 10, 25, 109},
+        {88, 43, 29, 140, 166, 213, 37, 43, 154},
+        {61, 63, 30, 155, 67, 45, 68, 1, 209},
+        {100, 80, 8, 43, 154, 1, 51, 26, 71},
+        {142, 78, 78, 16, 255, 128, 34, 197, 171},
+        {41, 40, 5, 102, 211, 183, 4, 1, 221},
+        {51, 50, 17, 168, 209, 192, 23, 25, 82},
+    },
+    {
+        {138, 31, 36, 171, 27, 166, 38, 44, 229},
+        {67, 87, 58, 169, 82, 115, 26, 59, 179},
+        {63, 59, 90, 180, 59, 166, 93, 73, 154},
+        {40, 40, 21, 116, 143, 209, 34, 39, 175},
+        {47, 15, 16, 183, 34, 223, 49, 45, 183},
+        {46, 17, 33, 183, 6, 98, 15, 32, 183},
+        {57, 46, 22, 24, 128, 1, 54, 17, 37},
+        {65, 32, 73, 115, 28, 128, 23, 128, 205},
+        {40, 3, 9, 115, 51, 192, 18, 6, 223},
+        {87, 37, 9, 115, 59, 77, 64, 21, 47},
+    },
+    {
+        {104, 55, 44, 218, 9, 54, 53, 130, 226},
+        {64, 90, 70, 205, 40, 41, 23, 26, 57},
+        {54, 57, 112, 184, 5, 41, 38, 166, 213},
+        {30, 34, 26, 133, 152, 116, 10, 32, 134},
+        {39, 19, 53, 221, 26, 114, 32, 73, 255},
+        {31, 9, 65, 234, 2, 15, 1, 118, 73},
+        {75, 32, 12, 51, 192, 255, 160, 43, 51},
+        {88, 31, 35, 67, 102, 85, 55, 186, 85},
+        {56, 21, 23, 111, 59, 205, 45, 37, 192},
+        {55, 38, 70, 124, 73, 102, 1, 34, 98},
+    },
+    {
+        {125, 98, 42, 88, 104, 85, 117, 175, 82},
+        {95, 84, 53, 89, 128, 100, 113, 101, 45},
+        {75, 79, 123, 47, 51, 128, 81, 171, 1},
+        {57, 17, 5, 71, 102, 57, 53, 41, 49},
+        {38, 33, 13, 121, 57, 73, 26, 1, 85},
+        {41, 10, 67, 138, 77, 110, 90, 47, 114},
+        {115, 21, 2, 10, 102, 255, 166, 23, 6},
+        {101, 29, 16, 10, 85, 128, 101, 196, 26},
+        {57, 18, 10, 102, 102, 213, 34, 20, 43},
+        {117, 20, 15, 36, 163, 128, 68, 1, 26},
+    },
+    {
+        {102, 61, 71, 37, 34, 53, 31, 243, 192},
+        {69, 60, 71, 38, 73, 119, 28, 222, 37},
+        {68, 45, 128, 34, 1, 47, 11, 245, 171},
+        {62, 17, 19, 70, 146, 85, 55, 62, 70},
+        {37, 43, 37, 154, 100, 163, 85, 160, 1},
+        {63, 9, 92, 136, 28, 64, 32, 201, 85},
+        {75, 15, 9, 9, 64, 255, 184, 119, 16},
+        {86, 6, 28, 5, 64, 255, 25, 248, 1},
+        {56, 8, 17, 132, 137, 255, 55, 116, 128},
+        {58, 15, 20, 82, 135, 57, 26, 121, 40},
+    },
+    {
+        {164, 50, 31, 137, 154, 133, 25, 35, 218},
+        {51, 103, 44, 131, 131, 123, 31, 6, 158},
+        {86, 40, 64, 135, 148, 224, 45, 183, 128},
+        {22, 26, 17, 131, 240, 154, 14, 1, 209},
+        {45, 16, 21, 91, 64, 222, 7, 1, 197},
+        {56, 21, 39, 155, 60, 138, 23, 102, 213},
+        {83, 12, 13, 54, 192, 255, 68, 47, 28},
+        {85, 26, 85, 85, 128, 128, 32, 146, 171},
+        {18, 11, 7, 63, 144, 171, 4, 4, 246},
+        {35, 27, 10, 146, 174, 171, 12, 26, 128},
+    },
+    {
+        {190, 80, 35, 99, 180, 80, 126, 54, 45},
+        {85, 126, 47, 87, 176, 51, 41, 20, 32},
+        {101, 75, 128, 139, 118, 146, 116, 128, 85},
+        {56, 41, 15, 176, 236, 85, 37, 9, 62},
+        {71, 30, 17, 119, 118, 255, 17, 18, 138},
+        {101, 38, 60, 138, 55, 70, 43, 26, 142},
+        {146, 36, 19, 30, 171, 255, 97, 27, 20},
+        {138, 45, 61, 62, 219, 1, 81, 188, 64},
+        {32, 41, 20, 117, 151, 142, 20, 21, 163},
+        {112, 19, 12, 61, 195, 128, 48, 4, 24},
+    },
+};
+
+// 4x4 intra mode tree: positive entries are nodes, others minus the mode
+static const signed char YModesIntra4[18] = {-VP8_B_DC_PRED, 1, -VP8_B_TM_PRED, 2, -VP8_B_VE_PRED, 3,
+                                             4, 6, -VP8_B_HE_PRED, 5, -VP8_B_RD_PRED, -VP8_B_VR_PRED,
+                                             -VP8_B_LD_PRED, 7, -VP8_B_VL_PRED, 8, -VP8_B_HD_PRED, -VP8_B_HU_PRED};
+
+static const CKBYTE Bands[16 + 1] = {0, 1, 2, 3, 6, 4, 5, 6, 6, 6, 6, 6, 6, 6, 6, 7, 0};
+
+static const CKBYTE Zigzag[16] = {0, 1, 4, 8, 5, 2, 3, 6, 9, 12, 13, 10, 7, 11, 14, 15};
+
+static const CKBYTE Cat3[] = {173, 148, 140, 0};
+static const CKBYTE Cat4[] = {176, 155, 140, 135, 0};
+static const CKBYTE Cat5[] = {180, 157, 141, 134, 130, 0};
+static const CKBYTE Cat6[] = {254, 254, 243, 230, 196, 177, 153, 140, 133, 130, 129, 0};
+static const CKBYTE *const Cat3456[4] = {Cat3, Cat4, Cat5, Cat6};
+
+// Left shift that brings a range of 1 to 255 back to 128 or more
+static const CKBYTE RangeNorm[256] = {
+    0, 7, 6, 6, 5, 5, 5, 5, 4, 4, 4, 4, 4, 4, 4, 4, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0};
+
+//=============================================================================
+// Boolean Decoder
+//
+// libwebp's reader, whose end-of-data behaviour decides which truncated
+// files still decode: value holds the unread bits, the top 8 bits past
+// position bits being compared with the split. Past the end, one zero byte
+// is supplied and eof is raised.
+//=============================================================================
+struct Vp8BitReader
+{
+    const CKBYTE *buf;
+    const CKBYTE *bufEnd;
+    uint64_t value;
+    CKDWORD range; // range - 1, in [126, 254]
+    int bits;      // number of valid bits left
+    CKBOOL eof;
+};
+
+static void LoadNewBytes(Vp8BitReader &br)
+{
+    if (br.bufEnd - br.buf >= 8)
+    {
+        // 56 bits at a time, big-endian
+        uint64_t bits = 0;
+        for (int i = 0; i < 7; i++)
+            bits = (bits << 8) | br.buf[i];
+        br.buf += 7;
+        br.value = bits | (br.value << 56);
+        br.bits += 56;
+    }
+    else if (br.buf < br.bufEnd)
+    {
+        br.bits += 8;
+        br.value = (uint64_t)(*br.buf++) | (br.value << 8);
+    }
+    else if (!br.eof)
+    {
+        br.value <<= 8;
+        br.bits += 8;
+        br.eof = TRUE;
+    }
+    else
+    {
+        br.bits = 0; // keeps the shifts defined
+    }
+}
+
+static void InitBitReader(Vp8BitReader &br, const CKBYTE *start, CKDWORD size)
+{
+    br.buf = start;
+    br.bufEnd = start + size;
+    br.value = 0;
+    br.range = 255 - 1;
+    br.bits = -8;
+    br.eof = FALSE;
+    LoadNewBytes(br);
+}
+
+static inline int GetBit(Vp8BitReader &br, int prob)
+{
+    CKDWORD range = br.range;
+    if (br.bits < 0)
+        LoadNewBytes(br);
+    int pos = br.bits;
+    CKDWORD split = (range * (CKDWORD)prob) >> 8;
+    CKDWORD value = (CKDWORD)(br.value >> pos);
+    int bit = value > split;
+    if (bit)
+    {
+        range -= split;
+        br.value -= (uint64_t)(split + 1) << pos;
+    }
+    else
+    {
+        range = split + 1;
+    }
+    int shift = RangeNorm[range];
+    range <<= shift;
+    br.bits -= shift;
+    br.range = range - 1;
+    return bit;
+}
+
+// A sign bit at probability 1/2 applied to v
+static inline int GetSigned(Vp8BitReader &br, int v)
+{
+    if (br.bits < 0)
+        LoadNewBytes(br);
+    int pos = br.bits;
+    CKDWORD split = br.range >> 1;
+    CKDWORD value = (CKDWORD)(br.value >> pos);
+    int mask = (int)(split - value) >> 31; // -1 when the bit is set
+    br.bits -= 1;
+    br.range += (CKDWORD)mask;
+    br.range |= 1;
+    br.value -= (uint64_t)((split + 1) & (CKDWORD)mask) << pos;
+    return (v ^ mask) - mask;
+}
+
+static int GetValue(Vp8BitReader &br, int bits)
+{
+    int v = 0;
+    while (bits-- > 0)
+        v |= GetBit(br, 0x80) << bits;
+    return v;
+}
+
+static int GetSignedValue(Vp8BitReader &br, int bits)
+{
+    int value = GetValue(br, bits);
+    return GetValue(br, 1) ? -value : value;
+}
+
+//=============================================================================
+// Decoder State
+//=============================================================================
+typedef CKBYTE Vp8ProbaArray[VP8_NUM_PROBAS];
+typedef Vp8ProbaArray Vp8BandProbas[VP8_NUM_CTX];
+
+struct Vp8QuantMatrix
+{
+    int y1[2]; // dc, ac
+    int y2[2];
+    int uv[2];
+};
+
+struct Vp8FilterInfo
+{
+    CKBYTE limit; // 0 disables the filter
+    CKBYTE interiorLimit;
+    CKBYTE inner; // filter the inner edges too
+    CKBYTE hevThresh;
+};
+
+// Non-zero flags a macroblock leaves for its right and bottom neighbours:
+// one bit per 4x4 block on the edge (4 luma, 2 u, 2 v) and one for Y2
+struct Vp8NonZero
+{
+    CKBYTE nz;
+    CKBYTE nzDc;
+};
+
+struct Vp8MacroblockData
+{
+    CKBOOL isI4x4;
+    CKBYTE imodes[16]; // 4x4 modes, or the 16x16 mode in imodes[0]
+    CKBYTE uvmode;
+    CKBYTE segment;
+    CKBYTE skip;
+    CKDWORD nonZeroY;  // 2 bits per block (see DoTransform), first block in the top bits
+    CKDWORD nonZeroUV; // 2 bits per chroma block, u in bits 0-7, v in bits 8-15
+};
+
+struct Vp8TopSamples
+{
+    CKBYTE y[16];
+    CKBYTE u[8];
+    CKBYTE v[8];
+};
+
+struct Vp8Decoder
+{
+    const WebpDsp *dsp;
+    Vp8BitReader br; // partition 0: modes
+    Vp8BitReader parts[VP8_MAX_PARTITIONS];
+    int numPartsMinusOne;
+
+    int width;
+    int height;
+    int mbw;
+    int mbh;
+
+    // Segment header
+    CKBOOL useSegment;
+    CKBOOL updateMap;
+    CKBOOL absoluteDelta;
+    int quantizer[VP8_NUM_SEGMENTS];
+    int filterStrength[VP8_NUM_SEGMENTS];
+    CKBYTE segmentProba[3];
+
+    // Filter header
+    CKBOOL simple;
+    int level;
+    int sharpness;
+    CKBOOL useLfDelta;
+    int refLfDelta[4];
+    int modeLfDelta[4];
+    int filterType; // 0 none, 1 simple, 2 normal
+
+    Vp8QuantMatrix dqm[VP8_NUM_SEGMENTS];
+    Vp8BandProbas bands[VP8_NUM_TYPES][VP8_NUM_BANDS];
+    const Vp8BandProbas *bandsPtr[VP8_NUM_TYPES][16 + 1]; // by coefficient index
+    CKBOOL useSkipProba;
+    int skipProba;
+    Vp8FilterInfo fstrengths[VP8_NUM_SEGMENTS][2]; // by segment and i4x4
+
+    // Per row state
+    CKBYTE *intraT;         // 4 modes per macroblock of the row above
+    CKBYTE intraL[4];       // modes of the macroblock on the left
+    Vp8NonZero *nonZero;    // [-1] is the left macroblock
+    Vp8MacroblockData *mbData;
+    Vp8TopSamples *topSamples;
+    short coeffs[384];      // 16 Y, 4 U, 4 V blocks of the current macroblock
+    CKBYTE yuvB[VP8_YUV_SIZE];
+
+    Vp8FilterInfo *filterInfo; // whole frame, filtered after reconstruction
+    CKBYTE *y;
+    CKBYTE *u;
+    CKBYTE *v;
+    int yStride;
+    int uvStride;
+};
+
+//=============================================================================
+// Headers
+//=============================================================================
+int WEBP_ReadLossyHeader(const CKBYTE *data, CKDWORD size, CKDWORD &width, CKDWORD &height)
+{
+    if (!data || size < WEBP_VP8_HEADER_SIZE)
+        return CKBITMAPERROR_READERROR;
+    CKDWORD bits = data[0] | ((CKDWORD)data[1] << 8) | ((CKDWORD)data[2] << 16);
+    if (bits & 1) // inter frame
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    if (((bits >> 1) & 7) > 3 || data[3] != 0x9d || data[4] != 0x01 || data[5] != 0x2a)
+        return CKBITMAPERROR_FILECORRUPTED;
+    if (!((bits >> 4) & 1)) // not meant to be shown
+        return CKBITMAPERROR_UNSUPPORTEDFILE;
+    if ((bits >> 5) >= size)
+        return CKBITMAPERROR_FILECORRUPTED;
+    width = (data[6] | ((CKDWORD)data[7] << 8)) & 0x3fff;
+    height = (data[8] | ((CKDWORD)data[9] << 8)) & 0x3fff;
+    if (width == 0 || height == 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+    return 0;
+}
+
+static CKBOOL ParseSegmentHeader(Vp8Decoder &dec)
+{
+    Vp8BitReader &br = dec.br;
+    dec.useSegment = GetValue(br, 1);
+    dec.updateMap = FALSE;
+    dec.absoluteDelta = TRUE;
+    memset(dec.quantizer, 0, sizeof(dec.quantizer));
+    memset(dec.filterStrength, 0, sizeof(dec.filterStrength));
+    memset(dec.segmentProba, 255, sizeof(dec.segmentProba));
+    if (dec.useSegment)
+    {
+        dec.updateMap = GetValue(br, 1);
+        if (GetValue(br, 1)) // update data
+        {
+            dec.absoluteDelta = GetValue(br, 1);
+            for (int s = 0; s < VP8_NUM_SEGMENTS; s++)
+                dec.quantizer[s] = GetValue(br, 1) ? GetSignedValue(br, 7) : 0;
+            for (int s = 0; s < VP8_NUM_SEGMENTS; s++)
+                dec.filterStrength[s] = GetValue(br, 1) ? GetSignedValue(br, 6) : 0;
+        }
+        if (dec.updateMap)
+            for (int s = 0; s < 3; s++)
+                dec.segmentProba[s] = (CKBYTE)(GetValue(br, 1) ? GetValue(br, 8) : 255);
+    }
+    return !br.eof;
+}
+
+static CKBOOL ParseFilterHeader(Vp8Decoder &dec)
+{
+    Vp8BitReader &br = dec.br;
+    dec.simple = GetValue(br, 1);
+    dec.level = GetValue(br, 6);
+    dec.sharpness = GetValue(br, 3);
+    dec.useLfDelta = GetValue(br, 1);
+    memset(dec.refLfDelta, 0, sizeof(dec.refLfDelta));
+    memset(dec.modeLfDelta, 0, sizeof(dec.modeLfDelta));
+    if (dec.useLfDelta && GetValue(br, 1))
+    {
+        for (int i = 0; i < 4; i++)
+            if (GetValue(br, 1))
+                dec.refLfDelta[i] = GetSignedValue(br, 6);
+        for (int i = 0; i < 4; i++)
+            if (GetValue(br, 1))
+                dec.modeLfDelta[i] = GetSignedValue(br, 6);
+    }
+    dec.filterType = (dec.level == 0) ? 0 : dec.simple ? 1 : 2;
+    return !br.eof;
+}
+
+// Token partitions follow partition 0, the sizes of all but the last first
+static int ParsePartitions(Vp8Decoder &dec, const CKBYTE *buf, CKDWORD size)
+{
+    const CKBYTE *sz = buf;
+    const CKBYTE *bufEnd = buf + size;
+    dec.numPartsMinusOne = (1 << GetValue(dec.br, 2)) - 1;
+    CKDWORD lastPart = (CKDWORD)dec.numPartsMinusOne;
+    if (size < 3 * lastPart)
+        return CKBITMAPERROR_READERROR;
+    const CKBYTE *partStart = buf + lastPart * 3;
+    CKDWORD sizeLeft = size - lastPart * 3;
+    for (CKDWORD p = 0; p < lastPart; p++, sz += 3)
+    {
+        CKDWORD partSize = sz[0] | ((CKDWORD)sz[1] << 8) | ((CKDWORD)sz[2] << 16);
+        if (partSize > sizeLeft)
+            partSize = sizeLeft;
+        InitBitReader(dec.parts[p], partStart, partSize);
+        partStart += partSize;
+        sizeLeft -= partSize;
+    }
+    InitBitReader(dec.parts[lastPart], partStart, sizeLeft);
+    return (partStart < bufEnd) ? 0 : CKBITMAPERROR_READERROR;
+}
+
+static inline int ClipQ(int v, int max) { return v < 0 ? 0 : (v > max ? max : v); }
+
+static void ParseQuant(Vp8Decoder &dec)
+{
+    Vp8BitReader &br = dec.br;
+    int baseQ0 = GetValue(br, 7);
+    int dqy1Dc = GetValue(br, 1) ? GetSignedValue(br, 4) : 0;
+    int dqy2Dc = GetValue(br, 1) ? GetSignedValue(br, 4) : 0;
+    int dqy2Ac = GetValue(br, 1) ? GetSignedValue(br, 4) : 0;
+    int dquvDc = GetValue(br, 1) ? GetSignedValue(br, 4) : 0;
+    int dquvAc = GetValue(br, 1) ? GetSignedValue(br, 4) : 0;
+    for (int s = 0; s < VP8_NUM_SEGMENTS; s++)
+    {
+        int q;
+        if (dec.useSegment)
+        {
+            q = dec.quantizer[s];
+            if (!dec.absoluteDelta)
+                q += baseQ0;
+        }
+        else if (s > 0)
+        {
+            dec.dqm[s] = dec.dqm[0];
+            continue;
+        }
+        else
+        {
+            q = baseQ0;
+        }
+        Vp8QuantMatrix &m = dec.dqm[s];
+        m.y1[0] = DcTable[ClipQ(q + dqy1Dc, 127)];
+        m.y1[1] = AcTable[ClipQ(q, 127)];
+        m.y2[0] = DcTable[ClipQ(q + dqy2Dc, 127)] * 2;
+        // x * 155 / 100 for every x of the table
+        m.y2[1] = (AcTable[ClipQ(q + dqy2Ac, 127)] * 101581) >> 16;
+        if (m.y2[1] < 8)
+            m.y2[1] = 8;
+        m.uv[0] = DcTable[ClipQ(q + dquvDc, 117)];
+        m.uv[1] = AcTable[ClipQ(q + dquvAc, 127)];
+    }
+}
+
+static void ParseProba(Vp8Decoder &dec)
+{
+    Vp8BitReader &br = dec.br;
+    for (int t = 0; t < VP8_NUM_TYPES; t++)
+    {
+        for (int b = 0; b < VP8_NUM_BANDS; b++)
+            for (int c = 0; c < VP8_NUM_CTX; c++)
+                for (int p = 0; p < VP8_NUM_PROBAS; p++)
+                {
+                    int v = GetBit(br, CoeffsUpdateProba[t][b][c][p]) ? GetValue(br, 8) : CoeffsProba0[t][b][c][p];
+                    dec.bands[t][b][c][p] = (CKBYTE)v;
+                }
+        for (int b = 0; b < 16 + 1; b++)
+            dec.bandsPtr[t][b] = &dec.bands[t][Bands[b]];
+    }
+    dec.useSkipProba = GetValue(br, 1);
+    if (dec.useSkipProba)
+        dec.skipProba = GetValue(br, 8);
+}
+
+static int ParseHeaders(Vp8Decoder &dec, const CKBYTE *data, CKDWORD size)
+{
+    CKDWORD width, height;
+    int result = WEBP_ReadLossyHeader(data, size, width, height);
+    if (result != 0)
+        return result;
+    dec.width = (int)width;
+    dec.height = (int)height;
+    dec.mbw = (dec.width + 15) >> 4;
+    dec.mbh = (dec.height + 15) >> 4;
+
+    CKDWORD bits = data[0] | ((CKDWORD)data[1] << 8) | ((CKDWORD)data[2] << 16);
+    CKDWORD partitionLength = bits >> 5;
+    const CKBYTE *buf = data + WEBP_VP8_HEADER_SIZE;
+    CKDWORD bufSize = size - WEBP_VP8_HEADER_SIZE;
+    if (partitionLength > bufSize)
+        return CKBITMAPERROR_READERROR;
+    InitBitReader(dec.br, buf, partitionLength);
+    buf += partitionLength;
+    bufSize -= partitionLength;
+
+    GetValue(dec.br, 1); // color space
+    GetValue(dec.br, 1); // clamping type
+    if (!ParseSegmentHeader(dec) || !ParseFilterHeader(dec))
+        return CKBITMAPERROR_FILECORRUPTED;
+    result = ParsePartitions(dec, buf, bufSize);
+    if (result != 0)
+        return result;
+    ParseQuant(dec);
+    GetValue(dec.br, 1); // update the probabilities for this frame only; there is no next frame
+    ParseProba(dec);
+    return 0;
+}
+
+static void PrecomputeFilterStrengths(Vp8Decoder &dec)
+{
+    if (dec.filterType == 0)
+        return;
+    for (int s = 0; s < VP8_NUM_SEGMENTS; s++)
+    {
+        int baseLevel = dec.level;
+        if (dec.useSegment)
+        {
+            baseLevel = dec.filterStrength[s];
+            if (!dec.absoluteDelta)
+                baseLevel += dec.level;
+        }
+        for (int i4x4 = 0; i4x4 <= 1; i4x4++)
+        {
+            Vp8FilterInfo &info = dec.fstrengths[s][i4x4];
+            int level = baseLevel;
+            if (dec.useLfDelta)
+            {
+                level += dec.refLfDelta[0];
+                if (i4x4)
+                    level += dec.modeLfDelta[0];
+            }
+            level = (level < 0) ? 0 : (level > 63) ? 63 : level;
+            info.limit = 0;
+            info.interiorLimit = 0;
+            info.hevThresh = 0;
+            if (level > 0)
+            {
+                int ilevel = level;
+                if (dec.sharpness > 0)
+                {
+                    ilevel >>= (dec.sharpness > 4) ? 2 : 1;
+                    if (ilevel > 9 - dec.sharpness)
+                        ilevel = 9 - dec.sharpness;
+                }
+                if (ilevel < 1)
+                    ilevel = 1;
+                info.interiorLimit = (CKBYTE)ilevel;
+                info.limit = (CKBYTE)(2 * level + ilevel);
+                info.hevThresh = (CKBYTE)((level >= 40) ? 2 : (level >= 15) ? 1 : 0);
+            }
+            info.inner = (CKBYTE)i4x4;
+        }
+    }
+}
+
+//=============================================================================
+// Macroblock Parsing
+//=============================================================================
+static void ParseIntraMode(Vp8Decoder &dec, int mbx)
+{
+    Vp8BitReader &br = dec.br;
+    Vp8MacroblockData &block = dec.mbData[mbx];
+    CKBYTE *top = dec.intraT + 4 * mbx;
+    CKBYTE *left = dec.intraL;
+
+    if (dec.updateMap)
+        block.segment = (CKBYTE)(!GetBit(br, dec.segmentProba[0]) ? GetBit(br, dec.segmentProba[1])
+                                                                  : GetBit(br, dec.segmentProba[2]) + 2);
+    else
+        block.segment = 0;
+    block.skip = (CKBYTE)(dec.useSkipProba ? GetBit(br, dec.skipProba) : 0);
+
+    block.isI4x4 = !GetBit(br, 145);
+    if (!block.isI4x4)
+    {
+        int ymode = GetBit(br, 156) ? (GetBit(br, 128) ? VP8_B_TM_PRED : VP8_B_HE_PRED)
+                                    : (GetBit(br, 163) ? VP8_B_VE_PRED : VP8_B_DC_PRED);
+        block.imodes[0] = (CKBYTE)ymode;
+        memset(top, ymode, 4);
+        memset(left, ymode, 4);
+    }
+    else
+    {
+        CKBYTE *modes = block.imodes;
+        for (int y = 0; y < 4; y++)
+        {
+            int ymode = left[y];
+            for (int x = 0; x < 4; x++)
+            {
+                const CKBYTE *prob = BModesProba[top[x]][ymode];
+                int i = YModesIntra4[GetBit(br, prob[0])];
+                while (i > 0)
+                    i = YModesIntra4[2 * i + GetBit(br, prob[i])];
+                ymode = -i;
+                top[x] = (CKBYTE)ymode;
+            }
+            memcpy(modes, top, 4);
+            modes += 4;
+            left[y] = (CKBYTE)ymode;
+        }
+    }
+    block.uvmode = (CKBYTE)(!GetBit(br, 142)   ? VP8_B_DC_PRED
+                            : !GetBit(br, 114) ? VP8_B_VE_PRED
+                            : GetBit(br, 183)  ? VP8_B_TM_PRED
+                                               : VP8_B_HE_PRED);
+}
+
+static int GetLargeValue(Vp8BitReader &br, const CKBYTE *p)
+{
+    int v;
+    if (!GetBit(br, p[3]))
+    {
+        v = !GetBit(br, p[4]) ? 2 : 3 + GetBit(br, p[5]);
+    }
+    else if (!GetBit(br, p[6]))
+    {
+        if (!GetBit(br, p[7]))
+        {
+            v = 5 + GetBit(br, 159);
+        }
+        else
+        {
+            v = 7 + 2 * GetBit(br, 165);
+            v += GetBit(br, 145);
+        }
+    }
+    else
+    {
+        int bit1 = GetBit(br, p[8]);
+        int bit0 = GetBit(br, p[9 + bit1]);
+        int cat = 2 * bit1 + bit0;
+        v = 0;
+        for (const CKBYTE *tab = Cat3456[cat]; *tab; tab++)
+            v += v + GetBit(br, *tab);
+        v += 3 + (8 << cat);
+    }
+    return v;
+}
+
+// Reads the tokens of one block from position n; returns the position after
+// the last non-zero coefficient
+static int GetCoeffs(Vp8BitReader &br, const Vp8BandProbas *const *prob, int ctx, const int *dq, int n, short *out)
+{
+    const CKBYTE *p = prob[n][0][ctx];
+    for (; n < 16; n++)
+    {
+        if (!GetBit(br, p[0]))
+            return n; // end of block
+        while (!GetBit(br, p[1])) // zero run
+        {
+            p = prob[++n][0][0];
+            if (n == 16)
+                return 16;
+        }
+        const Vp8BandProbas &next = *prob[n + 1];
+        int v;
+        if (!GetBit(br, p[2]))
+        {
+            v = 1;
+            p = next[1];
+        }
+        else
+        {
+            v = GetLargeValue(br, p);
+            p = next[2];
+        }
+        out[Zigzag[n]] = (short)(GetSigned(br, v) * dq[n > 0]);
+    }
+    return 16;
+}
+
+// 2-bit summary of a block: 3 many coefficients, 2 a few, 1 DC only, 0 none
+static inline CKDWORD NzCodeBits(CKDWORD nzCoeffs, int nz, int dcNz)
+{
+    nzCoeffs <<= 2;
+    nzCoeffs |= (nz > 3) ? 3 : (nz > 1) ? 2 : dcNz;
+    return nzCoeffs;
+}
+
+// Inverse Walsh-Hadamard transform of the Y2 block into the DC of the 16
+// luma blocks
+static void TransformWht(const short *in, short *out)
+{
+    int tmp[16];
+    for (int i = 0; i < 4; i++)
+    {
+        int a0 = in[0 + i] + in[12 + i];
+        int a1 = in[4 + i] + in[8 + i];
+        int a2 = in[4 + i] - in[8 + i];
+        int a3 = in[0 + i] - in[12 + i];
+        tmp[0 + i] = a0 + a1;
+        tmp[8 + i] = a0 - a1;
+        tmp[4 + i] = a3 + a2;
+        tmp[12 + i] = a3 - a2;
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        int dc = tmp[0 + i * 4] + 3;
+        int a0 = dc + tmp[3 + i * 4];
+        int a1 = tmp[1 + i * 4] + tmp[2 + i * 4];
+        int a2 = tmp[1 + i * 4] - tmp[2 + i * 4];
+        int a3 = dc - tmp[3 + i * 4];
+        out[0] = (short)((a0 + a1) >> 3);
+        out[16] = (short)((a3 + a2) >> 3);
+        out[32] = (short)((a0 - a1) >> 3);
+        out[48] = (short)((a3 - a2) >> 3);
+        out += 64;
+    }
+}
+
+// Returns whether the macroblock has no coefficients at all
+static CKBOOL ParseResiduals(Vp8Decoder &dec, int mbx, Vp8BitReader &br)
+{
+    Vp8MacroblockData &block = dec.mbData[mbx];
+    Vp8NonZero &mb = dec.nonZero[mbx];
+    Vp8NonZero &leftMb = dec.nonZero[-1];
+    const Vp8QuantMatrix &q = dec.dqm[block.segment];
+    short *dst = dec.coeffs;
+    memset(dst, 0, 384 * sizeof(short));
+
+    const Vp8BandProbas *const *acProba;
+    int first;
+    if (!block.isI4x4)
+    {
+        short dc[16];
+        memset(dc, 0, sizeof(dc));
+        int ctx = mb.nzDc + leftMb.nzDc;
+        int nz = GetCoeffs(br, dec.bandsPtr[1], ctx, q.y2, 0, dc);
+        mb.nzDc = leftMb.nzDc = (CKBYTE)(nz > 0);
+        if (nz > 1)
+        {
+            TransformWht(dc, dst);
+        }
+        else
+        {
+            int dc0 = (dc[0] + 3) >> 3;
+            for (int i = 0; i < 16 * 16; i += 16)
+                dst[i] = (short)dc0;
+        }
+        first = 1;
+        acProba = dec.bandsPtr[0];
+    }
+    else
+    {
+        first = 0;
+        acProba = dec.bandsPtr[3];
+    }
+
+    CKDWORD tnz = mb.nz & 0x0f;
+    CKDWORD lnz = leftMb.nz & 0x0f;
+    CKDWORD nonZeroY = 0;
+    for (int y = 0; y < 4; y++)
+    {
+        int l = lnz & 1;
+        CKDWORD nzCoeffs = 0;
+        for (int x = 0; x < 4; x++)
+        {
+            int ctx = l + (int)(tnz & 1);
+            int nz = GetCoeffs(br, acProba, ctx, q.y1, first, dst);
+            l = (nz > first);
+            tnz = (tnz >> 1) | ((CKDWORD)l << 7);
+            nzCoeffs = NzCodeBits(nzCoeffs, nz, dst[0] != 0);
+            dst += 16;
+        }
+        tnz >>= 4;
+        lnz = (lnz >> 1) | ((CKDWORD)l << 7);
+        nonZeroY = (nonZeroY << 8) | nzCoeffs;
+    }
+    CKDWORD outTnz = tnz;
+    CKDWORD outLnz = lnz >> 4;
+
+    CKDWORD nonZeroUV = 0;
+    for (int ch = 0; ch < 4; ch += 2)
+    {
+        CKDWORD nzCoeffs = 0;
+        tnz = mb.nz >> (4 + ch);
+        lnz = leftMb.nz >> (4 + ch);
+        for (int y = 0; y < 2; y++)
+        {
+            int l = lnz & 1;
+            for (int x = 0; x < 2; x++)
+            {
+                int ctx = l + (int)(tnz & 1);
+                int nz = GetCoeffs(br, dec.bandsPtr[2], ctx, q.uv, 0, dst);
+                l = (nz > 0);
+                tnz = (tnz >> 1) | ((CKDWORD)l << 3);
+                nzCoeffs = NzCodeBits(nzCoeffs, nz, dst[0] != 0);
+                dst += 16;
+            }
+            tnz >>= 2;
+            lnz = (lnz >> 1) | ((CKDWORD)l << 5);
+        }
+        nonZeroUV |= nzCoeffs << (4 * ch);
+        outTnz |= (tnz << 4) << ch;
+        outLnz |= (lnz & 0xf0) << ch;
+    }
+    mb.nz = (CKBYTE)outTnz;
+    leftMb.nz = (CKBYTE)outLnz;
+
+    block.nonZeroY = nonZeroY;
+    block.nonZeroUV = nonZeroUV;
+    return !(nonZeroY | nonZeroUV);
+}
+
+static CKBOOL DecodeMacroblock(Vp8Decoder &dec, int mbx, int mby, Vp8BitReader &br)
+{
+    Vp8MacroblockData &block = dec.mbData[mbx];
+    CKBOOL skip = dec.useSkipProba ? block.skip : 0;
+    if (!skip)
+    {
+        skip = ParseResiduals(dec, mbx, br);
+    }
+    else
+    {
+        dec.nonZero[-1].nz = dec.nonZero[mbx].nz = 0;
+        if (!block.isI4x4)
+            dec.nonZero[-1].nzDc = dec.nonZero[mbx].nzDc = 0;
+        block.nonZeroY = 0;
+        block.nonZeroUV = 0;
+    }
+    if (dec.filterType > 0)
+    {
+        Vp8FilterInfo &info = dec.filterInfo[mby * dec.mbw + mbx];
+        info = dec.fstrengths[block.segment][block.isI4x4 ? 1 : 0];
+        info.inner |= (CKBYTE)!skip;
+    }
+    return !br.eof;
+}
+
+//=============================================================================
+// Intra Prediction
+//
+// dst is in the work buffer, with the top row at dst - VP8_BPS and the left
+// column at dst - 1.
+//=============================================================================
+#define AVG3(a, b, c) ((CKBYTE)(((a) + 2 * (b) + (c) + 2) >> 2))
+#define AVG2(a, b) ((CKBYTE)(((a) + (b) + 1) >> 1))
+#define DST(x, y) dst[(x) + (y) * VP8_BPS]
+
+static inline CKBYTE ClipPixel(int v) { return (CKBYTE)(v < 0 ? 0 : (v > 255 ? 255 : v)); }
+
+static void TrueMotion(CKBYTE *dst, int size)
+{
+    const CKBYTE *top = dst - VP8_BPS;
+    int topLeft = top[-1];
+    for (int y = 0; y < size; y++, dst += VP8_BPS)
+    {
+        int delta = dst[-1] - topLeft;
+        for (int x = 0; x < size; x++)
+            dst[x] = ClipPixel(top[x] + delta);
+    }
+}
+
+static void FillBlock(CKBYTE *dst, int value, int size)
+{
+    for (int y = 0; y < size; y++, dst += VP8_BPS)
+        memset(dst, value, size);
+}
+
+static void VerticalPred(CKBYTE *dst, int size)
+{
+    for (int y = 0; y < size; y++)
+        memcpy(dst + y * VP8_BPS, dst - VP8_BPS, size);
+}
+
+static void HorizontalPred(CKBYTE *dst, int size)
+{
+    for (int y = 0; y < size; y++, dst += VP8_BPS)
+        memset(dst, dst[-1], size);
+}
+
+// DC of the available neighbours: shift is log2 of their count
+static void DcPred(CKBYTE *dst, int size, CKBOOL useTop, CKBOOL useLeft, int shift)
+{
+    int dc = 1 << (shift - 1);
+    for (int i = 0; i < size; i++)
+    {
+        if (useTop)
+            dc += dst[i - VP8_BPS];
+        if (useLeft)
+            dc += dst[i * VP8_BPS - 1];
+    }
+    FillBlock(dst, dc >> shift, size);
+}
+
+// 16x16 luma (size 16) and 8x8 chroma (size 8) modes
+static void PredictBlock(CKBYTE *dst, int mode, int size, int shift)
+{
+    switch (mode)
+    {
+    case VP8_B_DC_PRED:
+        DcPred(dst, size, TRUE, TRUE, shift + 1);
+        break;
+    case VP8_B_TM_PRED:
+        TrueMotion(dst, size);
+        break;
+    case VP8_B_VE_PRED:
+        VerticalPred(dst, size);
+        break;
+    case VP8_B_HE_PRED:
+        HorizontalPred(dst, size);
+        break;
+    case VP8_DC_PRED_NOTOP:
+        DcPred(dst, size, FALSE, TRUE, shift);
+        break;
+    case VP8_DC_PRED_NOLEFT:
+        DcPred(dst, size, TRUE, FALSE, shift);
+        break;
+    default: // VP8_DC_PRED_NOTOPLEFT
+        FillBlock(dst, 0x80, size);
+        break;
+    }
+}
+
+static void Predict4x4(CKBYTE *dst, int mode)
+{
+    const CKBYTE *top = dst - VP8_BPS;
+    int X = top[-1];
+    int A = top[0], B = top[1], C = top[2], D = top[3];
+    int E = top[4], F = top[5], G = top[6], H = top[7];
+    int I = dst[-1], J = dst[-1 + VP8_BPS], K = dst[-1 + 2 * VP8_BPS], L = dst[-1 + 3 * VP8_BPS];
+    switch (mode)
+    {
+    case VP8_B_DC_PRED:
+    {
+        int dc = 4;
+        for (int i = 0; i < 4; i++)
+            dc += top[i] + dst[i * VP8_BPS - 1];
+        FillBlock(dst, dc >> 3, 4);
+        break;
+    }
+    case VP8_B_TM_PRED:
+        TrueMotion(dst, 4);
+        break;
+    case VP8_B_VE_PRED: // smoothed
+    {
+        CKBYTE vals[4] = {AVG3(X, A, B), AVG3(A, B, C), AVG3(B, C, D), AVG3(C, D, E)};
+        for (int y = 0; y < 4; y++)
+            memcpy(dst + y * VP8_BPS, vals, 4);
+        break;
+    }
+    case VP8_B_HE_PRED: // smoothed
+        memset(dst, AVG3(X, I, J), 4);
+        memset(dst + VP8_BPS, AVG3(I, J, K), 4);
+        memset(dst + 2 * VP8_BPS, AVG3(J, K, L), 4);
+        memset(dst + 3 * VP8_BPS, AVG3(K, L, L), 4);
+        break;
+    case VP8_B_RD_PRED: // down-right
+        DST(0, 3) = AVG3(J, K, L);
+        DST(1, 3) = DST(0, 2) = AVG3(I, J, K);
+        DST(2, 3) = DST(1, 2) = DST(0, 1) = AVG3(X, I, J);
+        DST(3, 3) = DST(2, 2) = DST(1, 1) = DST(0, 0) = AVG3(A, X, I);
+        DST(3, 2) = DST(2, 1) = DST(1, 0) = AVG3(B, A, X);
+        DST(3, 1) = DST(2, 0) = AVG3(C, B, A);
+        DST(3, 0) = AVG3(D, C, B);
+        break;
+    case VP8_B_VR_PRED: // vertical-right
+        DST(0, 0) = DST(1, 2) = AVG2(X, A);
+        DST(1, 0) = DST(2, 2) = AVG2(A, B);
+        DST(2, 0) = DST(3, 2) = AVG2(B, C);
+        DST(3, 0) = AVG2(C, D);
+        DST(0, 3) = AVG3(K, J, I);
+        DST(0, 2) = AVG3(J, I, X);
+        DST(0, 1) = DST(1, 3) = AVG3(I, X, A);
+        DST(1, 1) = DST(2, 3) = AVG3(X, A, B);
+        DST(2, 1) = DST(3, 3) = AVG3(A, B, C);
+        DST(3, 1) = AVG3(B, C, D);
+        break;
+    case VP8_B_LD_PRED: // down-left
+        DST(0, 0) = AVG3(A, B, C);
+        DST(1, 0) = DST(0, 1) = AVG3(B, C, D);
+        DST(2, 0) = DST(1, 1) = DST(0, 2) = AVG3(C, D, E);
+        DST(3, 0) = DST(2, 1) = DST(1, 2) = DST(0, 3) = AVG3(D, E, F);
+        DST(3, 1) = DST(2, 2) = DST(1, 3) = AVG3(E, F, G);
+        DST(3, 2) = DST(2, 3) = AVG3(F, G, H);
+        DST(3, 3) = AVG3(G, H, H);
+        break;
+    case VP8_B_VL_PRED: // vertical-left
+        DST(0, 0) = AVG2(A, B);
+        DST(1, 0) = DST(0, 2) = AVG2(B, C);
+        DST(2, 0) = DST(1, 2) = AVG2(C, D);
+        DST(3, 0) = DST(2, 2) = AVG2(D, E);
+        DST(0, 1) = AVG3(A, B, C);
+        DST(1, 1) = DST(0, 3) = AVG3(B, C, D);
+        DST(2, 1) = DST(1, 3) = AVG3(C, D, E);
+        DST(3, 1) = DST(2, 3) = AVG3(D, E, F);
+        DST(3, 2) = AVG3(E, F, G);
+        DST(3, 3) = AVG3(F, G, H);
+        break;
+    case VP8_B_HD_PRED: // horizontal-down
+        DST(0, 0) = DST(2, 1) = AVG2(I, X);
+        DST(0, 1) = DST(2, 2) = AVG2(J, I);
+        DST(0, 2) = DST(2, 3) = AVG2(K, J);
+        DST(0, 3) = AVG2(L, K);
+        DST(3, 0) = AVG3(A, B, C);
+        DST(2, 0) = AVG3(X, A, B);
+        DST(1, 0) = DST(3, 1) = AVG3(I, X, A);
+        DST(1, 1) = DST(3, 2) = AVG3(J, I, X);
+        DST(1, 2) = DST(3, 3) = AVG3(K, J, I);
+        DST(1, 3) = AVG3(L, K, J);
+        break;
+    default: // VP8_B_HU_PRED, horizontal-up
+        DST(0, 0) = AVG2(I, J);
+        DST(2, 0) = DST(0, 1) = AVG2(J, K);
+        DST(2, 1) = DST(0, 2) = AVG2(K, L);
+        DST(1, 0) = AVG3(I, J, K);
+        DST(3, 0) = DST(1, 1) = AVG3(J, K, L);
+        DST(3, 1) = DST(1, 2) = AVG3(K, L, L);
+        DST(3, 2) = DST(2, 2) = DST(0, 3) = DST(1, 3) = DST(2, 3) = DST(3, 3) = (CKBYTE)L;
+        break;
+    }
+}
+
+#undef AVG3
+#undef AVG2
+#undef DST
+
+// DC prediction needs to know which neighbours exist
+static int CheckMode(int mbx, int mby, int mode)
+{
+    if (mode == VP8_B_DC_PRED)
+    {
+        if (mbx == 0)
+            return (mby == 0) ? VP8_DC_PRED_NOTOPLEFT : VP8_DC_PRED_NOLEFT;
+        return (mby == 0) ? VP8_DC_PRED_NOTOP : VP8_B_DC_PRED;
+    }
+    return mode;
+}
+
+//=============================================================================
+// Reconstruction
+//=============================================================================
+static void TransformDc(const short *in, CKBYTE *dst)
+{
+    int dc = in[0] + 4;
+    for (int y = 0; y < 4; y++, dst += VP8_BPS)
+        for (int x = 0; x < 4; x++)
+            dst[x] = ClipPixel(dst[x] + (dc >> 3));
+}
+
+// bits is the 2-bit block summary in its top bits
+static inline void DoTransform(const WebpDsp &dsp, CKDWORD bits, const short *src, CKBYTE *dst)
+{
+    switch (bits >> 30)
+    {
+    case 3:
+    case 2:
+        dsp.transform(src, dst, VP8_BPS);
+        break;
+    case 1:
+        TransformDc(src, dst);
+        break;
+    default:
+        break;
+    }
+}
+
+static void DoUVTransform(const WebpDsp &dsp, CKDWORD bits, const short *src, CKBYTE *dst)
+{
+    for (int n = 0; n < 4; n++, bits <<= 2)
+        DoTransform(dsp, bits << 24, src + n * 16, dst + (n & 1) * 4 + (n >> 1) * 4 * VP8_BPS);
+}
+
+static void ReconstructMacroblock(Vp8Decoder &dec, int mbx, int mby)
+{
+    const WebpDsp &dsp = *dec.dsp;
+    CKBYTE *yDst = dec.yuvB + VP8_Y_OFF;
+    CKBYTE *uDst = dec.yuvB + VP8_U_OFF;
+    CKBYTE *vDst = dec.yuvB + VP8_V_OFF;
+    const Vp8MacroblockData &block = dec.mbData[mbx];
+    Vp8TopSamples *topYuv = dec.topSamples + mbx;
+
+    if (mbx == 0)
+    {
+        for (int j = 0; j < 16; j++)
+            yDst[j * VP8_BPS - 1] = 129;
+        for (int j = 0; j < 8; j++)
+        {
+            uDst[j * VP8_BPS - 1] = 129;
+            vDst[j * VP8_BPS - 1] = 129;
+        }
+        if (mby > 0)
+        {
+            yDst[-1 - VP8_BPS] = uDst[-1 - VP8_BPS] = vDst[-1 - VP8_BPS] = 129;
+        }
+        else
+        {
+            // Stays valid along the whole first row
+            memset(yDst - VP8_BPS - 1, 127, 16 + 4 + 1);
+            memset(uDst - VP8_BPS - 1, 127, 8 + 1);
+            memset(vDst - VP8_BPS - 1, 127, 8 + 1);
+        }
+    }
+    else
+    {
+        // The right columns of the previous macroblock become the left ones
+        for (int j = -1; j < 16; j++)
+            memcpy(yDst + j * VP8_BPS - 4, yDst + j * VP8_BPS + 12, 4);
+        for (int j = -1; j < 8; j++)
+        {
+            memcpy(uDst + j * VP8_BPS - 4, uDst + j * VP8_BPS + 4, 4);
+            memcpy(vDst + j * VP8_BPS - 4, vDst + j * VP8_BPS + 4, 4);
+        }
+    }
+
+    if (mby > 0)
+    {
+        memcpy(yDst - VP8_BPS, topYuv[0].y, 16);
+        memcpy(uDst - VP8_BPS, topYuv[0].u, 8);
+        memcpy(vDst - VP8_BPS, topYuv[0].v, 8);
+    }
+
+    const short *coeffs = dec.coeffs;
+    CKDWORD bits = block.nonZeroY;
+    if (block.isI4x4)
+    {
+        CKBYTE *topRight = yDst - VP8_BPS + 16;
+        if (mby > 0)
+        {
+            if (mbx >= dec.mbw - 1)
+                memset(topRight, topYuv[0].y[15], 4);
+            else
+                memcpy(topRight, topYuv[1].y, 4);
+        }
+        // The right column of blocks uses the same top-right samples
+        memcpy(topRight + 4 * VP8_BPS, topRight, 4);
+        memcpy(topRight + 8 * VP8_BPS, topRight, 4);
+        memcpy(topRight + 12 * VP8_BPS, topRight, 4);
+
+        for (int n = 0; n < 16; n++, bits <<= 2)
+        {
+            CKBYTE *dst = yDst + (n & 3) * 4 + (n >> 2) * 4 * VP8_BPS;
+            Predict4x4(dst, block.imodes[n]);
+            DoTransform(dsp, bits, coeffs + n * 16, dst);
+        }
+    }
+    else
+    {
+        PredictBlock(yDst, CheckMode(mbx, mby, block.imodes[0]), 16, 4);
+        if (bits != 0)
+            for (int n = 0; n < 16; n++, bits <<= 2)
+                DoTransform(dsp, bits, coeffs + n * 16, yDst + (n & 3) * 4 + (n >> 2) * 4 * VP8_BPS);
+    }
+
+    int uvMode = CheckMode(mbx, mby, block.uvmode);
+    PredictBlock(uDst, uvMode, 8, 3);
+    PredictBlock(vDst, uvMode, 8, 3);
+    DoUVTransform(dsp, block.nonZeroUV >> 0, coeffs + 16 * 16, uDst);
+    DoUVTransform(dsp, block.nonZeroUV >> 8, coeffs + 20 * 16, vDst);
+
+    // Unfiltered bottom samples predict the next row
+    if (mby < dec.mbh - 1)
+    {
+        memcpy(topYuv[0].y, yDst + 15 * VP8_BPS, 16);
+        memcpy(topYuv[0].u, uDst + 7 * VP8_BPS, 8);
+        memcpy(topYuv[0].v, vDst + 7 * VP8_BPS, 8);
+    }
+
+    CKBYTE *y = dec.y + mby * 16 * dec.yStride + mbx * 16;
+    CKBYTE *u = dec.u + mby * 8 * dec.uvStride + mbx * 8;
+    CKBYTE *v = dec.v + mby * 8 * dec.uvStride + mbx * 8;
+    for (int j = 0; j < 16; j++)
+        memcpy(y + j * dec.yStride, yDst + j * VP8_BPS, 16);
+    for (int j = 0; j < 8; j++)
+    {
+        memcpy(u + j * dec.uvStride, uDst + j * VP8_BPS, 8);
+        memcpy(v + j * dec.uvStride, vDst + j * VP8_BPS, 8);
+    }
+}
+
+//=============================================================================
+// Loop Filter
+//=============================================================================
+static void FilterMacroblock(const Vp8Decoder &dec, int mbx, int mby)
+{
+    const WebpDsp &dsp = *dec.dsp;
+    const Vp8FilterInfo &info = dec.filterInfo[mby * dec.mbw + mbx];
+    int limit = info.limit;
+    if (limit == 0)
+        return;
+    int ilevel = info.interiorLimit;
+    int yStride = dec.yStride;
+    CKBYTE *y = dec.y + mby * 16 * yStride + mbx * 16;
+    if (dec.filterType == 1)
+    {
+        if (mbx > 0)
+            dsp.simpleH16(y, yStride, limit + 4);
+        if (info.inner)
+            dsp.simpleH16i(y, yStride, limit);
+        if (mby > 0)
+            dsp.simpleV16(y, yStride, limit + 4);
+        if (info.inner)
+            dsp.simpleV16i(y, yStride, limit);
+        return;
+    }
+
+    int uvStride = dec.uvStride;
+    CKBYTE *u = dec.u + mby * 8 * uvStride + mbx * 8;
+    CKBYTE *v = dec.v + mby * 8 * uvStride + mbx * 8;
+    int hevThresh = info.hevThresh;
+    if (mbx > 0)
+    {
+        dsp.h16(y, yStride, limit + 4, ilevel, hevThresh);
+        dsp.h8(u, v, uvStride, limit + 4, ilevel, hevThresh);
+    }
+    if (info.inner)
+    {
+        dsp.h16i(y, yStride, limit, ilevel, hevThresh);
+        dsp.h8i(u, v, uvStride, limit, ilevel, hevThresh);
+    }
+    if (mby > 0)
+    {
+        dsp.v16(y, yStride, limit + 4, ilevel, hevThresh);
+        dsp.v8(u, v, uvStride, limit + 4, ilevel, hevThresh);
+    }
+    if (info.inner)
+    {
+        dsp.v16i(y, yStride, limit, ilevel, hevThresh);
+        dsp.v8i(u, v, uvStride, limit, ilevel, hevThresh);
+    }
+}
+
+//=============================================================================
+// Output
+//
+// Item 0 is the first row, item k the rows 2k - 1 and 2k between chroma rows
+// k - 1 and k; the last row of an even height has no row below.
+//=============================================================================
+struct Vp8UpsampleJob
+{
+    const Vp8Decoder *dec;
+    CKBYTE *bgra;
+    int stride;
+};
+
+static void UpsampleRows(void *context, CKDWORD begin, CKDWORD end)
+{
+    const Vp8UpsampleJob &job = *(const Vp8UpsampleJob *)context;
+    const Vp8Decoder &dec = *job.dec;
+    WebpUpsampleFunc upsample = dec.dsp->upsample;
+    for (CKDWORD k = begin; k < end; k++)
+    {
+        if (k == 0)
+        {
+            upsample(dec.y, NULL, dec.u, dec.v, dec.u, dec.v, job.bgra, NULL, dec.width);
+            continue;
+        }
+        int row = 2 * (int)k - 1;
+        const CKBYTE *topU = dec.u + (k - 1) * dec.uvStride;
+        const CKBYTE *topV = dec.v + (k - 1) * dec.uvStride;
+        const CKBYTE *topY = dec.y + row * dec.yStride;
+        CKBYTE *topDst = job.bgra + row * job.stride;
+        if (row + 1 < dec.height)
+            upsample(topY, topY + dec.yStride, topU, topV, topU + dec.uvStride, topV + dec.uvStride, topDst,
+                     topDst + job.stride, dec.width);
+        else
+            upsample(topY, NULL, topU, topV, topU, topV, topDst, NULL, dec.width);
+    }
+}
+
+//=============================================================================
+// Decoding
+//=============================================================================
+static int DecodeFrame(Vp8Decoder &dec)
+{
+    for (int mby = 0; mby < dec.mbh; mby++)
+    {
+        Vp8BitReader &tokens = dec.parts[mby & dec.numPartsMinusOne];
+        for (int mbx = 0; mbx < dec.mbw; mbx++)
+            ParseIntraMode(dec, mbx);
+        if (dec.br.eof)
+            return CKBITMAPERROR_FILECORRUPTED;
+
+        for (int mbx = 0; mbx < dec.mbw; mbx++)
+        {
+            if (!DecodeMacroblock(dec, mbx, mby, tokens))
+                return CKBITMAPERROR_FILECORRUPTED;
+            ReconstructMacroblock(dec, mbx, mby);
+        }
+
+        dec.nonZero[-1].nz = 0;
+        dec.nonZero[-1].nzDc = 0;
+        memset(dec.intraL, VP8_B_DC_PRED, sizeof(dec.intraL));
+    }
+
+    if (dec.filterType > 0)
+        for (int mby = 0; mby < dec.mbh; mby++)
+            for (int mbx = 0; mbx < dec.mbw; mbx++)
+                FilterMacroblock(dec, mbx, mby);
+    return 0;
+}
+
+int WEBP_DecodeLossy(const CKBYTE *data, CKDWORD size, CKBYTE *bgra, int stride)
+{
+    Vp8Decoder *dec = new Vp8Decoder;
+    memset(dec, 0, sizeof(Vp8Decoder));
+    dec->dsp = &WEBP_GetDsp();
+    int result = ParseHeaders(*dec, data, size);
+    if (result != 0)
+    {
+        delete dec;
+        return result;
+    }
+    PrecomputeFilterStrengths(*dec);
+
+    int mbw = dec->mbw;
+    int mbh = dec->mbh;
+    dec->yStride = mbw * 16;
+    dec->uvStride = mbw * 8;
+    CKBYTE *planes = new CKBYTE[(size_t)dec->yStride * mbh * 16 + (size_t)dec->uvStride * mbh * 8 * 2];
+    dec->y = planes;
+    dec->u = dec->y + (size_t)dec->yStride * mbh * 16;
+    dec->v = dec->u + (size_t)dec->uvStride * mbh * 8;
+    dec->intraT = new CKBYTE[4 * mbw];
+    memset(dec->intraT, VP8_B_DC_PRED, 4 * mbw);
+    Vp8NonZero *nonZero = new Vp8NonZero[mbw + 1];
+    memset(nonZero, 0, (mbw + 1) * sizeof(Vp8NonZero));
+    dec->nonZero = nonZero + 1;
+    dec->mbData = new Vp8MacroblockData[mbw];
+    dec->topSamples = new Vp8TopSamples[mbw];
+    dec->filterInfo = new Vp8FilterInfo[mbw * mbh];
+
+    result = DecodeFrame(*dec);
+    if (result == 0)
+    {
+        Vp8UpsampleJob job;
+        job.dec = dec;
+        job.bgra = bgra;
+        job.stride = stride;
+        ImageParallelFor((CKDWORD)dec->height / 2 + 1, 16, UpsampleRows, &job);
+    }
+
+    delete[] dec->filterInfo;
+    delete[] dec->topSamples;
+    delete[] dec->mbData;
+    delete[] nonZero;
+    delete[] dec->intraT;
+    delete[] planes;
+    delete dec;
+    return result;
+}
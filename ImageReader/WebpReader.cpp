@@ -0,0 +1,403 @@
+#include "WebpReader.h"
+#include "WebpCodec.h"
+#include "ImageFileMap.h"
+
+//=============================================================================
+// Byte Helpers
+//=============================================================================
+static CKDWORD Read24(const CKBYTE *p) { return p[0] | (p[1] << 8) | ((CKDWORD)p[2] << 16); }
+
+static CKDWORD Read32(const CKBYTE *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((CKDWORD)p[3] << 24); }
+
+static CKBOOL IsTag(const CKBYTE *p, const char *tag) { return memcmp(p, tag, 4) == 0; }
+
+static CKBOOL IsBitstreamTag(const CKBYTE *p) { return IsTag(p, "VP8 ") || IsTag(p, "VP8L"); }
+
+//=============================================================================
+// Chunks
+//=============================================================================
+
+// Finds the image among the chunks in [pos, end): a VP8L chunk, or a VP8
+// chunk with the ALPH chunk before it, if any
+static int ReadFrameChunks(const CKBYTE *data, CKDWORD pos, CKDWORD end, WebpImageInfo &info)
+{
+    while (pos < end)
+    {
+        if (end - pos < WEBP_CHUNK_HEADER_SIZE)
+            return CKBITMAPERROR_READERROR;
+        const CKBYTE *chunk = data + pos;
+        CKDWORD chunkSize = Read32(chunk + 4);
+        if (chunkSize > end - pos - WEBP_CHUNK_HEADER_SIZE)
+            return CKBITMAPERROR_READERROR;
+        const CKBYTE *payload = chunk + WEBP_CHUNK_HEADER_SIZE;
+        if (IsBitstreamTag(chunk))
+        {
+            info.bitstream = payload;
+            info.bitstreamSize = chunkSize;
+            info.lossless = IsTag(chunk, "VP8L");
+            if (info.lossless)
+            {
+                info.alpha = NULL;
+                info.alphaSize = 0;
+            }
+            return 0;
+        }
+        if (IsTag(chunk, "ALPH") && !info.alpha)
+        {
+            info.alpha = payload;
+            info.alphaSize = chunkSize;
+        }
+        // Chunks are padded to an even size
+        pos += WEBP_CHUNK_HEADER_SIZE + chunkSize + (chunkSize & 1);
+    }
+    return CKBITMAPERROR_READERROR;
+}
+
+// Reads the first ANMF chunk and counts the others. Frames after the first
+// are not decoded, so a truncated one only ends the count.
+static int ReadAnimation(const CKBYTE *data, CKDWORD pos, CKDWORD end, WebpImageInfo &info)
+{
+    info.animated = TRUE;
+    info.frameCount = 0;
+    while (end - pos >= WEBP_CHUNK_HEADER_SIZE)
+    {
+        const CKBYTE *chunk = data + pos;
+        CKDWORD chunkSize = Read32(chunk + 4);
+        if (chunkSize > end - pos - WEBP_CHUNK_HEADER_SIZE)
+            break;
+        if (IsTag(chunk, "ANMF"))
+        {
+            if (info.frameCount == 0)
+            {
+                if (chunkSize < WEBP_ANMF_HEADER_SIZE)
+                    return CKBITMAPERROR_FILECORRUPTED;
+                const CKBYTE *frame = chunk + WEBP_CHUNK_HEADER_SIZE;
+                info.frameX = Read24(frame) * 2;
+                info.frameY = Read24(frame + 3) * 2;
+                info.frameWidth = Read24(frame + 6) + 1;
+                info.frameHeight = Read24(frame + 9) + 1;
+                info.blend = !(frame[15] & WEBP_ANMF_NO_BLEND);
+                CKDWORD framePos = pos + WEBP_CHUNK_HEADER_SIZE + WEBP_ANMF_HEADER_SIZE;
+                int result = ReadFrameChunks(data, framePos, pos + WEBP_CHUNK_HEADER_SIZE + chunkSize, info);
+                if (result != 0)
+                    return result;
+            }
+            info.frameCount++;
+        }
+        pos += WEBP_CHUNK_HEADER_SIZE + chunkSize + (chunkSize & 1);
+        if (pos > end)
+            break;
+    }
+    return (info.frameCount > 0) ? 0 : CKBITMAPERROR_READERROR;
+}
+
+int WEBP_ReadInfo(const CKBYTE *data, CKDWORD size, WebpImageInfo &info)
+{
+    memset(&info, 0, sizeof(info));
+    info.frameCount = 1;
+    if (!data || size < 4)
+        return CKBITMAPERROR_READERROR;
+
+    int result = 0;
+    CKBOOL hasCanvas = FALSE;
+    if (IsTag(data, "RIFF"))
+    {
+        if (size < WEBP_RIFF_HEADER_SIZE)
+            return CKBITMAPERROR_READERROR;
+        if (!IsTag(data + 8, "WEBP"))
+            return CKBITMAPERROR_UNSUPPORTEDFILE;
+        CKDWORD riffSize = Read32(data + 4);
+        if (riffSize < 4 + WEBP_CHUNK_HEADER_SIZE)
+            return CKBITMAPERROR_FILECORRUPTED;
+        if (riffSize > size - 8)
+            return CKBITMAPERROR_READERROR;
+        CKDWORD end = 8 + riffSize; // trailing bytes are not part of the file
+        CKDWORD pos = WEBP_RIFF_HEADER_SIZE;
+        if (IsTag(data + pos, "VP8X"))
+        {
+            if (Read32(data + pos + 4) != WEBP_VP8X_CHUNK_SIZE)
+                return CKBITMAPERROR_FILECORRUPTED;
+            if (end - pos < WEBP_CHUNK_HEADER_SIZE + WEBP_VP8X_CHUNK_SIZE)
+                return CKBITMAPERROR_READERROR;
+            const CKBYTE *vp8x = data + pos + WEBP_CHUNK_HEADER_SIZE;
+            info.canvasWidth = Read24(vp8x + 4) + 1;
+            info.canvasHeight = Read24(vp8x + 7) + 1;
+            hasCanvas = TRUE;
+            pos += WEBP_CHUNK_HEADER_SIZE + WEBP_VP8X_CHUNK_SIZE;
+            if (vp8x[0] & WEBP_FLAG_ANIMATION)
+                result = ReadAnimation(data, pos, end, info);
+            else
+                result = ReadFrameChunks(data, pos, end, info);
+        }
+        else
+        {
+            // Simple format: the image is the only chunk
+            if (!IsBitstreamTag(data + pos))
+                return CKBITMAPERROR_FILECORRUPTED;
+            result = ReadFrameChunks(data, pos, end, info);
+        }
+    }
+    else
+    {
+        // A bare bitstream
+        info.bitstream = data;
+        info.bitstreamSize = size;
+        if (data[0] == WEBP_VP8L_SIGNATURE)
+            info.lossless = TRUE;
+        else if (size < WEBP_VP8_HEADER_SIZE || data[3] != 0x9d || data[4] != 0x01 || data[5] != 0x2a)
+            return CKBITMAPERROR_UNSUPPORTEDFILE;
+    }
+    if (result != 0)
+        return result;
+
+    CKDWORD width, height;
+    if (info.lossless)
+    {
+        CKBOOL hasAlpha;
+        result = WEBP_ReadLosslessHeader(info.bitstream, info.bitstreamSize, width, height, hasAlpha);
+    }
+    else
+    {
+        result = WEBP_ReadLossyHeader(info.bitstream, info.bitstreamSize, width, height);
+    }
+    if (result != 0)
+        return result;
+
+    if (info.animated)
+    {
+        if (width != info.frameWidth || height != info.frameHeight || info.frameX + width > info.canvasWidth ||
+            info.frameY + height > info.canvasHeight)
+            return CKBITMAPERROR_FILECORRUPTED;
+    }
+    else
+    {
+        if (hasCanvas && (width != info.canvasWidth || height != info.canvasHeight))
+            return CKBITMAPERROR_FILECORRUPTED;
+        info.canvasWidth = info.frameWidth = width;
+        info.canvasHeight = info.frameHeight = height;
+    }
+    uint64_t canvasSize = (uint64_t)info.canvasWidth * info.canvasHeight * 4;
+    if (!ImageWithinDecodeLimits(info.canvasWidth, info.canvasHeight, canvasSize))
+        return CKBITMAPERROR_FILECORRUPTED;
+    return 0;
+}
+
+//=============================================================================
+// Alpha
+//=============================================================================
+
+// Undoes the prediction of one row; prev is the row above, NULL for the first
+static void UnfilterAlphaRow(int filter, const CKBYTE *prev, const CKBYTE *in, CKBYTE *out, CKDWORD width)
+{
+    // The first row is predicted from the left only, whatever the filter
+    if (!prev || filter == WEBP_ALPHA_FILTER_HORIZONTAL)
+    {
+        CKBYTE pred = prev ? prev[0] : 0;
+        for (CKDWORD i = 0; i < width; i++)
+        {
+            out[i] = (CKBYTE)(pred + in[i]);
+            pred = out[i];
+        }
+    }
+    else if (filter == WEBP_ALPHA_FILTER_VERTICAL)
+    {
+        for (CKDWORD i = 0; i < width; i++)
+            out[i] = (CKBYTE)(prev[i] + in[i]);
+    }
+    else
+    {
+        int left = prev[0];
+        int topLeft = prev[0];
+        for (CKDWORD i = 0; i < width; i++)
+        {
+            int top = prev[i];
+            int gradient = left + top - topLeft;
+            gradient = (gradient < 0) ? 0 : (gradient > 255) ? 255 : gradient;
+            left = (CKBYTE)(in[i] + gradient);
+            topLeft = top;
+            out[i] = (CKBYTE)left;
+        }
+    }
+}
+
+int WEBP_DecodeAlpha(const CKBYTE *data, CKDWORD size, CKDWORD width, CKDWORD height, CKBYTE *alpha)
+{
+    // Header byte: compression, filter, pre-processing (a hint) and reserved bits
+    if (!data || size <= 1)
+        return CKBITMAPERROR_READERROR;
+    int method = data[0] & 0x03;
+    int filter = (data[0] >> 2) & 0x03;
+    int preProcessing = (data[0] >> 4) & 0x03;
+    if (method > WEBP_ALPHA_LOSSLESS || preProcessing > 1 || (data[0] >> 6) != 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    CKDWORD count = width * height;
+    if (method == WEBP_ALPHA_RAW)
+    {
+        if (size - 1 < count)
+            return CKBITMAPERROR_READERROR;
+        memcpy(alpha, data + 1, count);
+    }
+    else
+    {
+        int result = WEBP_DecodeLosslessAlpha(data + 1, size - 1, width, height, alpha);
+        if (result != 0)
+            return result;
+    }
+
+    if (filter != WEBP_ALPHA_FILTER_NONE)
+    {
+        const CKBYTE *prev = NULL;
+        for (CKDWORD y = 0; y < height; y++)
+        {
+            CKBYTE *row = alpha + y * width;
+            UnfilterAlphaRow(filter, prev, row, row, width);
+            prev = row;
+        }
+    }
+    return 0;
+}
+
+//=============================================================================
+// WebpReader Class Implementation
+//=============================================================================
+WebpReader::WebpReader() : ImageReader()
+{
+    m_Properties.Init(WEBPREADER_GUID, "web");
+}
+
+WebpReader::~WebpReader()
+{
+    FreeBitmapData(&m_Properties);
+}
+
+CKPluginInfo *WebpReader::GetReaderInfo()
+{
+    return &g_PluginInfo[READER_INDEX_WEBP];
+}
+
+int WebpReader::GetOptionsCount() { return 0; }
+
+CKSTRING WebpReader::GetOptionDescription(int i) { return ""; }
+
+int WebpReader::ReadFile(CKSTRING filename, CKBitmapProperties **bp)
+{
+    if (!filename || !bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_WEBP, (void *)filename, 0, (CKBitmapProperties *)&m_Properties, 0);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int WebpReader::ReadMemory(void *memory, int size, CKBitmapProperties **bp)
+{
+    if (!bp)
+        return 1;
+    int result = ReadSniffed(READER_INDEX_WEBP, memory, size, (CKBitmapProperties *)&m_Properties, 0);
+    *bp = (CKBitmapProperties *)&m_Properties;
+    return result;
+}
+
+int WebpReader::ReadOwnFormat(void *data, int size, CKBitmapProperties *props)
+{
+    return WEBP_Read(data, size, props);
+}
+
+//=============================================================================
+// WEBP_Read - Core Reading Function
+//=============================================================================
+
+// Decodes the frame into BGRA32 rows of frameWidth pixels
+static int DecodeFrame(const WebpImageInfo &info, CKBYTE *dst)
+{
+    if (info.lossless)
+        return WEBP_DecodeLossless(info.bitstream, info.bitstreamSize, (CKDWORD *)dst);
+
+    int result = WEBP_DecodeLossy(info.bitstream, info.bitstreamSize, dst, (int)(info.frameWidth * 4));
+    if (result != 0 || !info.alpha)
+        return result;
+
+    CKDWORD count = info.frameWidth * info.frameHeight;
+    CKBYTE *alpha = new CKBYTE[count];
+    result = WEBP_DecodeAlpha(info.alpha, info.alphaSize, info.frameWidth, info.frameHeight, alpha);
+    if (result == 0)
+        for (CKDWORD i = 0; i < count; i++)
+            dst[i * 4 + 3] = alpha[i];
+    delete[] alpha;
+    return result;
+}
+
+// Puts the first frame of an animation on the transparent canvas. Blended
+// over transparent pixels, a frame keeps its colors (the integer blends of
+// some decoders round them down by one) and its transparent pixels are cleared.
+static void ComposeFirstFrame(const WebpImageInfo &info, const CKBYTE *frame, CKBYTE *canvas, int canvasStride)
+{
+    memset(canvas, 0, (size_t)canvasStride * info.canvasHeight);
+    for (CKDWORD y = 0; y < info.frameHeight; y++)
+    {
+        const CKDWORD *src = (const CKDWORD *)(frame + (size_t)y * info.frameWidth * 4);
+        CKDWORD *dst = (CKDWORD *)(canvas + (size_t)(info.frameY + y) * canvasStride + info.frameX * 4);
+        if (!info.blend)
+        {
+            memcpy(dst, src, info.frameWidth * 4);
+            continue;
+        }
+        for (CKDWORD x = 0; x < info.frameWidth; x++)
+            dst[x] = (src[x] & 0xFF000000) ? src[x] : 0;
+    }
+}
+
+int WEBP_Read(void *data, int size, CKBitmapProperties *props)
+{
+    if (!data || !props)
+        return CKBITMAPERROR_GENERIC;
+    if (size < 0)
+        return CKBITMAPERROR_FILECORRUPTED;
+
+    // Files are mapped so the chunks are decoded in place
+    ImageFileMap fileMap;
+    if (size == 0)
+    {
+        if (!fileMap.Open((const char *)data))
+            return CKBITMAPERROR_READERROR;
+        data = (void *)fileMap.Data();
+        size = (int)fileMap.Size();
+    }
+
+    WebpImageInfo info;
+    int result = WEBP_ReadInfo((const CKBYTE *)data, (CKDWORD)size, info);
+    if (result != 0)
+        return result;
+
+    int stride = (int)(info.canvasWidth * 4);
+    CKBYTE *dstBlock = new CKBYTE[(size_t)stride * info.canvasHeight];
+    if (!info.animated)
+    {
+        result = DecodeFrame(info, dstBlock);
+    }
+    else
+    {
+        CKBYTE *frame = new CKBYTE[(size_t)info.frameWidth * info.frameHeight * 4];
+        result = DecodeFrame(info, frame);
+        if (result == 0)
+            ComposeFirstFrame(info, frame, dstBlock, stride);
+        delete[] frame;
+    }
+    if (result != 0)
+    {
+        delete[] dstBlock;
+        return result;
+    }
+
+    // Fill properties
+    ImageReader::FillFormatBGRA32(props->m_Format, (int)info.canvasWidth, (int)info.canvasHeight, stride, dstBlock);
+    props->m_Data = dstBlock;
+
+    if (props->m_Size == sizeof(WebpBitmapProperties))
+    {
+        WebpBitmapProperties *webpProps = (WebpBitmapProperties *)props;
+        webpProps->m_FrameCount = info.frameCount;
+        webpProps->m_Lossless = info.lossless ? 1 : 0;
+    }
+    return 0;
+}
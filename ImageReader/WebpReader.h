@@ -0,0 +1,102 @@
+#ifndef WEBPREADER_H
+#define WEBPREADER_H
+
+#include "ImageReader.h"
+
+// WebP Reader GUID
+#define WEBPREADER_GUID CKGUID(0x3B7E05D9, 0x6F21A84C)
+
+/**
+ * WebpReader - WebP reader
+ *
+ *   - Lossless (VP8L) images: table-driven prefix decoding, then the inverse
+ *     predictor, color and subtract green transforms with SSE2
+ *   - Lossy (VP8) key frames, with an ALPH chunk for transparency: SSE2
+ *     inverse DCT and loop filters, and chroma upsampling on the worker pool
+ *     (ImageParallelFor)
+ *   - Simple and extended (VP8X) files, and bare VP8/VP8L bitstreams;
+ *     metadata chunks are skipped
+ *   - Animated files give their first frame, blended onto a transparent
+ *     canvas; WebpBitmapProperties tells the frame count
+ *   - Output matches libwebp exactly; always decoded to BGRA32
+ *   - Read-only: SaveFile and SaveMemory return 0
+ */
+class WebpReader : public ImageReader
+{
+public:
+    WebpReader();
+    virtual ~WebpReader();
+
+    virtual CKPluginInfo *GetReaderInfo();
+    virtual int GetOptionsCount();
+    virtual CKSTRING GetOptionDescription(int i);
+
+    virtual int ReadFile(CKSTRING filename, CKBitmapProperties **bp);
+    virtual int ReadMemory(void *memory, int size, CKBitmapProperties **bp);
+
+protected:
+    virtual int ReadOwnFormat(void *data, int size, CKBitmapProperties *props);
+
+private:
+    WebpBitmapProperties m_Properties;
+};
+
+//=============================================================================
+// WebP file format
+//=============================================================================
+#define WEBP_RIFF_HEADER_SIZE 12
+#define WEBP_CHUNK_HEADER_SIZE 8
+#define WEBP_VP8X_CHUNK_SIZE 10
+#define WEBP_ANMF_HEADER_SIZE 16
+
+// VP8X flags
+#define WEBP_FLAG_ANIMATION 0x02
+#define WEBP_FLAG_ALPHA 0x10
+
+// ANMF flags
+#define WEBP_ANMF_DISPOSE 0x01
+#define WEBP_ANMF_NO_BLEND 0x02
+
+// ALPH header byte
+#define WEBP_ALPHA_RAW 0
+#define WEBP_ALPHA_LOSSLESS 1
+#define WEBP_ALPHA_FILTER_NONE 0
+#define WEBP_ALPHA_FILTER_HORIZONTAL 1
+#define WEBP_ALPHA_FILTER_VERTICAL 2
+#define WEBP_ALPHA_FILTER_GRADIENT 3
+
+// Canvas and the frame to decode (the image of a still file, or the first
+// frame of an animation)
+struct WebpImageInfo
+{
+    CKDWORD canvasWidth;
+    CKDWORD canvasHeight;
+    CKDWORD frameCount;
+    CKBOOL animated;
+
+    const CKBYTE *bitstream; // VP8 or VP8L chunk payload
+    CKDWORD bitstreamSize;
+    CKBOOL lossless;
+    const CKBYTE *alpha; // ALPH chunk payload of a lossy frame, or NULL
+    CKDWORD alphaSize;
+    CKDWORD frameX;
+    CKDWORD frameY;
+    CKDWORD frameWidth;
+    CKDWORD frameHeight;
+    CKBOOL blend; // blend the frame onto the canvas rather than replace it
+};
+
+//=============================================================================
+// Internal helper functions
+//=============================================================================
+
+// Walks the chunks, finds the frame and checks its size against the canvas
+int WEBP_ReadInfo(const CKBYTE *data, CKDWORD size, WebpImageInfo &info);
+
+// Decodes an ALPH chunk payload into width * height alpha values
+int WEBP_DecodeAlpha(const CKBYTE *data, CKDWORD size, CKDWORD width, CKDWORD height, CKBYTE *alpha);
+
+// Core WebP read function (size == 0 means data is a filename)
+int WEBP_Read(void *data, int size, CKBitmapProperties *props);
+
+#endif // WEBPREADER_H
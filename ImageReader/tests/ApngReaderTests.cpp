@@ -0,0 +1,518 @@
+/**
+ * @file ApngReaderTests.cpp
+ * @brief APNG movie tests for CKImageReader
+ *
+ * Tests cover:
+ * - The fcTL/fdAT frame index (regions, delays, default image, static PNGs)
+ * - Disposal and blending on the persistent canvas against a from-scratch model
+ * - Seeking backwards and forwards, and prefetched sequential playback
+ * - tests/images/png/apng/ball.png against the image-rs reference frames
+ * - Malformed animations and the movie reader API
+ */
+
+#include "TestFramework.h"
+#include "ApngReader.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace TestFramework;
+
+//=============================================================================
+// Test Helpers
+//=============================================================================
+
+namespace {
+
+void putBE32(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v >> 24));
+    out.push_back(static_cast<uint8_t>(v >> 16));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+void putBE16(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+// zlib stream of a single stored block (the checksum is not verified)
+std::vector<uint8_t> zlibStored(const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> z;
+    z.push_back(0x78);
+    z.push_back(0x01);
+    z.push_back(1);
+    z.push_back(static_cast<uint8_t>(data.size()));
+    z.push_back(static_cast<uint8_t>(data.size() >> 8));
+    z.push_back(static_cast<uint8_t>(~data.size()));
+    z.push_back(static_cast<uint8_t>(~data.size() >> 8));
+    z.insert(z.end(), data.begin(), data.end());
+    putBE32(z, 0);
+    return z;
+}
+
+void putChunk(std::vector<uint8_t>& png, const char* type, const std::vector<uint8_t>& data) {
+    putBE32(png, static_cast<uint32_t>(data.size()));
+    std::vector<uint8_t> crcData(type, type + 4);
+    crcData.insert(crcData.end(), data.begin(), data.end());
+    png.insert(png.end(), crcData.begin(), crcData.end());
+    putBE32(png, CRC32::compute(crcData.data(), crcData.size()));
+}
+
+// One animation frame with RGBA8 pixels for its region
+struct FrameSpec {
+    uint32_t width, height, x, y;
+    uint16_t delayNum, delayDen;
+    uint8_t dispose, blend;
+    std::vector<uint8_t> rgba;
+
+    FrameSpec(uint32_t w, uint32_t h, uint32_t fx, uint32_t fy, uint8_t d, uint8_t b)
+        : width(w), height(h), x(fx), y(fy), delayNum(1), delayDen(10), dispose(d), blend(b), rgba(w * h * 4, 0) {}
+
+    void fill(uint8_t r, uint8_t g, uint8_t bl, uint8_t a) {
+        for (size_t i = 0; i < rgba.size(); i += 4) {
+            rgba[i] = r;
+            rgba[i + 1] = g;
+            rgba[i + 2] = bl;
+            rgba[i + 3] = a;
+        }
+    }
+};
+
+struct ApngSpec {
+    uint32_t width, height;
+    uint32_t numPlays;
+    bool animated;       // write acTL/fcTL
+    bool defaultIsFrame; // the IDAT image is frame 0
+    size_t fdatSplit;    // split each frame's zlib stream into fdAT chunks of this size (0 = one chunk)
+    std::vector<FrameSpec> frames;
+
+    ApngSpec(uint32_t w, uint32_t h)
+        : width(w), height(h), numPlays(0), animated(true), defaultIsFrame(true), fdatSplit(0) {}
+};
+
+std::vector<uint8_t> frameZlib(const FrameSpec& f) {
+    std::vector<uint8_t> filtered;
+    for (uint32_t y = 0; y < f.height; ++y) {
+        filtered.push_back(0);
+        filtered.insert(filtered.end(), f.rgba.begin() + y * f.width * 4, f.rgba.begin() + (y + 1) * f.width * 4);
+    }
+    return zlibStored(filtered);
+}
+
+std::vector<uint8_t> makeApng(const ApngSpec& spec) {
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<uint8_t> png(signature, signature + 8);
+
+    std::vector<uint8_t> ihdr;
+    putBE32(ihdr, spec.width);
+    putBE32(ihdr, spec.height);
+    ihdr.push_back(8);
+    ihdr.push_back(PNG_COLOR_RGBA);
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    putChunk(png, "IHDR", ihdr);
+
+    if (spec.animated) {
+        std::vector<uint8_t> actl;
+        putBE32(actl, static_cast<uint32_t>(spec.frames.size()));
+        putBE32(actl, spec.numPlays);
+        putChunk(png, "acTL", actl);
+    }
+
+    uint32_t sequence = 0;
+    if (!spec.defaultIsFrame) {
+        // A static image that is not part of the animation
+        FrameSpec still(spec.width, spec.height, 0, 0, 0, 0);
+        still.fill(1, 2, 3, 4);
+        putChunk(png, "IDAT", frameZlib(still));
+    }
+    for (size_t i = 0; i < spec.frames.size(); ++i) {
+        const FrameSpec& f = spec.frames[i];
+        if (spec.animated) {
+            std::vector<uint8_t> fctl;
+            putBE32(fctl, sequence++);
+            putBE32(fctl, f.width);
+            putBE32(fctl, f.height);
+            putBE32(fctl, f.x);
+            putBE32(fctl, f.y);
+            putBE16(fctl, f.delayNum);
+            putBE16(fctl, f.delayDen);
+            fctl.push_back(f.dispose);
+            fctl.push_back(f.blend);
+            putChunk(png, "fcTL", fctl);
+        }
+
+        std::vector<uint8_t> z = frameZlib(f);
+        if (i == 0 && spec.defaultIsFrame) {
+            putChunk(png, "IDAT", z);
+            continue;
+        }
+        size_t split = spec.fdatSplit ? spec.fdatSplit : z.size();
+        for (size_t pos = 0; pos < z.size(); pos += split) {
+            std::vector<uint8_t> fdat;
+            putBE32(fdat, sequence++);
+            fdat.insert(fdat.end(), z.begin() + pos, z.begin() + std::min(z.size(), pos + split));
+            putChunk(png, "fdAT", fdat);
+        }
+    }
+    putChunk(png, "IEND", std::vector<uint8_t>());
+    return png;
+}
+
+// Straightforward model of the APNG rules: replays frames 0..f on a fresh canvas
+std::vector<uint8_t> modelCanvas(const ApngSpec& spec, size_t f) {
+    std::vector<uint8_t> canvas(spec.width * spec.height * 4, 0);
+    std::vector<uint8_t> before;
+    for (size_t i = 0; i <= f; ++i) {
+        const FrameSpec& fr = spec.frames[i];
+        before = canvas;
+        for (uint32_t y = 0; y < fr.height; ++y) {
+            for (uint32_t x = 0; x < fr.width; ++x) {
+                const uint8_t* s = &fr.rgba[(y * fr.width + x) * 4];
+                uint8_t* d = &canvas[((fr.y + y) * spec.width + fr.x + x) * 4];
+                if (fr.blend == APNG_BLEND_OVER && s[3] == 0) continue;
+                d[0] = s[2];
+                d[1] = s[1];
+                d[2] = s[0];
+                d[3] = s[3];
+            }
+        }
+        if (i == f) break;
+
+        uint8_t dispose = (i == 0 && fr.dispose == APNG_DISPOSE_PREVIOUS) ? APNG_DISPOSE_BACKGROUND : fr.dispose;
+        for (uint32_t y = 0; y < fr.height; ++y) {
+            size_t row = ((fr.y + y) * spec.width + fr.x) * 4;
+            if (dispose == APNG_DISPOSE_BACKGROUND)
+                std::fill(canvas.begin() + row, canvas.begin() + row + fr.width * 4, 0);
+            else if (dispose == APNG_DISPOSE_PREVIOUS)
+                std::copy(before.begin() + row, before.begin() + row + fr.width * 4, canvas.begin() + row);
+        }
+    }
+    return canvas;
+}
+
+std::string writeTemp(const std::string& name, const std::vector<uint8_t>& data) {
+    std::string path = joinPath(g_TestOutputDir, name);
+    writeBinaryFile(path, data.data(), data.size());
+    return path;
+}
+
+std::vector<uint8_t> readCanvas(ApngReader& reader, int f, int* error = nullptr) {
+    CKMovieProperties* mp = nullptr;
+    int result = reader.ReadFrame(f, &mp);
+    if (error) *error = result;
+    if (result != CK_OK || !mp) return std::vector<uint8_t>();
+    const VxImageDescEx& fmt = mp->m_Format;
+    const uint8_t* pixels = static_cast<const uint8_t*>(mp->m_Data);
+    return std::vector<uint8_t>(pixels, pixels + fmt.BytesPerLine * fmt.Height);
+}
+
+// Opaque squares moving over a transparent background, with every disposal
+// and blend operation
+ApngSpec makeTestAnimation() {
+    ApngSpec spec(16, 12);
+    FrameSpec bg(16, 12, 0, 0, APNG_DISPOSE_NONE, APNG_BLEND_SOURCE);
+    for (size_t i = 0; i < bg.rgba.size(); i += 4) {
+        bg.rgba[i] = static_cast<uint8_t>(i);
+        bg.rgba[i + 1] = 40;
+        bg.rgba[i + 2] = 90;
+        bg.rgba[i + 3] = (i / 4) % 3 ? 255 : 0;
+    }
+    spec.frames.push_back(bg);
+
+    FrameSpec a(5, 4, 2, 3, APNG_DISPOSE_PREVIOUS, APNG_BLEND_OVER);
+    a.fill(255, 0, 0, 255);
+    a.rgba[3] = 0; // one transparent pixel keeps the background
+    spec.frames.push_back(a);
+
+    FrameSpec b(6, 6, 8, 4, APNG_DISPOSE_BACKGROUND, APNG_BLEND_SOURCE);
+    b.fill(0, 255, 0, 255);
+    spec.frames.push_back(b);
+
+    FrameSpec c(4, 4, 10, 6, APNG_DISPOSE_NONE, APNG_BLEND_OVER);
+    c.fill(0, 0, 255, 255);
+    spec.frames.push_back(c);
+
+    // Full-canvas replacement: later frames can be drawn without replaying the earlier ones
+    FrameSpec d(16, 12, 0, 0, APNG_DISPOSE_NONE, APNG_BLEND_SOURCE);
+    d.fill(10, 20, 30, 255);
+    spec.frames.push_back(d);
+
+    FrameSpec e(3, 3, 0, 0, APNG_DISPOSE_BACKGROUND, APNG_BLEND_OVER);
+    e.fill(200, 100, 50, 255);
+    spec.frames.push_back(e);
+
+    FrameSpec f(2, 2, 1, 1, APNG_DISPOSE_NONE, APNG_BLEND_OVER);
+    f.fill(1, 1, 1, 255);
+    spec.frames.push_back(f);
+    return spec;
+}
+
+} // anonymous namespace
+
+//=============================================================================
+// Index Tests
+//=============================================================================
+
+TEST(ApngReader, Index_FramesAndTiming) {
+    ApngSpec spec = makeTestAnimation();
+    spec.numPlays = 3;
+    spec.fdatSplit = 7;
+    spec.frames[1].delayNum = 3;
+    spec.frames[1].delayDen = 0; // 1/100 s units
+    spec.frames[2].delayNum = 1;
+    spec.frames[2].delayDen = 3;
+    std::vector<uint8_t> png = makeApng(spec);
+
+    ApngAnimation anim;
+    ASSERT_EQ(0, APNG_Index(png.data(), static_cast<CKDWORD>(png.size()), anim));
+    ASSERT_EQ(7u, anim.frameCount);
+    ASSERT_EQ(3u, anim.numPlays);
+    ASSERT_TRUE(anim.frames[0].isIdat);
+    ASSERT_EQ(1u, anim.frames[0].chunkCount);
+    ASSERT_FALSE(anim.frames[1].isIdat);
+    ASSERT_EQ(static_cast<CKDWORD>(frameZlib(spec.frames[1]).size()), anim.frames[1].dataSize);
+    ASSERT_TRUE(anim.frames[1].chunkCount > 1);
+    ASSERT_EQ(5u, anim.frames[1].width);
+    ASSERT_EQ(3u, anim.frames[1].y);
+
+    ASSERT_EQ(100u, anim.frames[0].delay);
+    ASSERT_EQ(30u, anim.frames[1].delay);
+    ASSERT_EQ(333u, anim.frames[2].delay);
+    ASSERT_EQ(130u, anim.frames[2].startTime);
+    ASSERT_EQ(463u + 4 * 100u, anim.length);
+    APNG_FreeIndex(anim);
+}
+
+TEST(ApngReader, Index_DefaultImageOutsideAnimation) {
+    ApngSpec spec = makeTestAnimation();
+    spec.defaultIsFrame = false;
+    std::vector<uint8_t> png = makeApng(spec);
+
+    ApngAnimation anim;
+    ASSERT_EQ(0, APNG_Index(png.data(), static_cast<CKDWORD>(png.size()), anim));
+    ASSERT_EQ(7u, anim.frameCount);
+    ASSERT_FALSE(anim.frames[0].isIdat);
+    APNG_FreeIndex(anim);
+
+    ApngReader reader;
+    ASSERT_EQ(CK_OK, reader.OpenFile(const_cast<char*>(writeTemp("apng_default.png", png).c_str())));
+    for (int f = 0; f < 7; ++f) {
+        ASSERT_TRUE(readCanvas(reader, f) == modelCanvas(spec, f));
+    }
+}
+
+TEST(ApngReader, Index_StaticPngIsOneFrame) {
+    ApngSpec spec = makeTestAnimation();
+    spec.animated = false;
+    spec.frames.erase(spec.frames.begin() + 1, spec.frames.end());
+    std::vector<uint8_t> png = makeApng(spec);
+
+    ApngReader reader;
+    ASSERT_EQ(CK_OK, reader.OpenFile(const_cast<char*>(writeTemp("apng_static.png", png).c_str())));
+    ASSERT_EQ(1, reader.GetMovieFrameCount());
+    ASSERT_EQ(0, reader.GetMovieLength());
+    ASSERT_TRUE(readCanvas(reader, 0) == modelCanvas(spec, 0));
+}
+
+TEST(ApngReader, Index_TruncatedAnimationKeepsCompleteFrames) {
+    ApngSpec spec = makeTestAnimation();
+    std::vector<uint8_t> png = makeApng(spec);
+    // Drop the data of the last frame: the fcTL stays, its fdAT and IEND go
+    std::vector<uint8_t> fdat(png.end() - 12 - 12 - 4 - static_cast<long>(frameZlib(spec.frames[6]).size()),
+                              png.end());
+    png.resize(png.size() - fdat.size());
+
+    ApngAnimation anim;
+    ASSERT_EQ(0, APNG_Index(png.data(), static_cast<CKDWORD>(png.size()), anim));
+    ASSERT_EQ(6u, anim.frameCount);
+    APNG_FreeIndex(anim);
+}
+
+//=============================================================================
+// Compositing Tests
+//=============================================================================
+
+TEST(ApngReader, Compose_SequentialMatchesModel) {
+    ApngSpec spec = makeTestAnimation();
+    ApngReader reader;
+    ASSERT_EQ(CK_OK, reader.OpenFile(const_cast<char*>(writeTemp("apng_compose.png", makeApng(spec)).c_str())));
+    ASSERT_EQ(7, reader.GetMovieFrameCount());
+    ASSERT_EQ(700, reader.GetMovieLength());
+
+    for (int f = 0; f < 7; ++f) {
+        CKMovieProperties* mp = nullptr;
+        ASSERT_EQ(CK_OK, reader.ReadFrame(f, &mp));
+        ASSERT_EQ(16, mp->m_Format.Width);
+        ASSERT_EQ(12, mp->m_Format.Height);
+        ASSERT_EQ(32, mp->m_Format.BitsPerPixel);
+        ASSERT_EQ(100u, reinterpret_cast<ApngMovieProperties*>(mp)->m_FrameDelay);
+        ASSERT_TRUE(readCanvas(reader, f) == modelCanvas(spec, f));
+    }
+}
+
+TEST(ApngReader, Compose_SeekingMatchesModel) {
+    ApngSpec spec = makeTestAnimation();
+    ApngReader reader;
+    ASSERT_EQ(CK_OK, reader.OpenFile(const_cast<char*>(writeTemp("apng_seek.png", makeApng(spec)).c_str())));
+
+    static const int order[] = {3, 1, 6, 5, 2, 2, 0, 4, 6, 3, 0, 1, 2, 3, 4, 5, 6, 0, 6};
+    for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); ++i) {
+        ASSERT_TRUE(readCanvas(reader, order[i]) == modelCanvas(spec, order[i]));
+    }
+}
+
+TEST(ApngReader, Compose_LoopedPlayback) {
+    // The frame after the last one is the first; the prefetched frame must not
+    // be drawn over the old canvas
+    ApngSpec spec = makeTestAnimation();
+    spec.fdatSplit = 16;
+    ApngReader reader;
+    ASSERT_EQ(CK_OK, reader.OpenFile(const_cast<char*>(writeTemp("apng_loop.png", makeApng(spec)).c_str())));
+    for (int loop = 0; loop < 3; ++loop) {
+        for (int f = 0; f < 7; ++f) {
+            ASSERT_TRUE(readCanvas(reader, f) == modelCanvas(spec, f));
+        }
+    }
+}
+
+TEST(ApngReader, Compose_BlendOverSemiTransparent) {
+    ApngSpec spec(2, 1);
+    FrameSpec bg(2, 1, 0, 0, APNG_DISPOSE_NONE, APNG_BLEND_SOURCE);
+    bg.fill(200, 100, 0, 255);
+    bg.rgba[7] = 128; // second pixel half transparent
+    spec.frames.push_back(bg);
+    FrameSpec top(2, 1, 0, 0, APNG_DISPOSE_NONE, APNG_BLEND_OVER);
+    top.fill(0, 0, 255, 128);
+    spec.frames.push_back(top);
+
+    ApngReader reader;
+    ASSERT_EQ(CK_OK, reader.OpenFile(const_cast<char*>(writeTemp("apng_over.png", makeApng(spec)).c_str())));
+    std::vector<uint8_t> canvas = readCanvas(reader, 1);
+    ASSERT_EQ(8u, canvas.size());
+
+    // Over an opaque pixel: a plain mix weighted by the source alpha
+    ASSERT_EQ(128, canvas[0]);
+    ASSERT_EQ(50, canvas[1]);
+    ASSERT_EQ(100, canvas[2]);
+    ASSERT_EQ(255, canvas[3]);
+
+    // Over a half transparent pixel: alpha 128 + 128 * 127 / 255, colors weighted by coverage
+    ASSERT_EQ(192, canvas[7]);
+    ASSERT_EQ(170, canvas[4]);
+    ASSERT_EQ(33, canvas[5]);
+    ASSERT_EQ(66, canvas[6]);
+}
+
+//=============================================================================
+// Corpus Tests
+//=============================================================================
+
+TEST(ApngReader, Corpus_BallMatchesReferenceFrames) {
+    std::string path = joinPath(joinPath(g_TestImagesDir, "png"), "apng/ball.png");
+    std::string refDir = joinPath(joinPath(g_TestReferenceDir, "png"), "apng");
+    if (!fileExists(path)) SKIP_TEST("ball.png not found");
+
+    ApngReader reader;
+    ASSERT_EQ(CK_OK, reader.OpenFile(const_cast<char*>(path.c_str())));
+
+    // References are named ball.png.anim_NN_<crc>.png with NN counted from 1
+    std::vector<std::string> refs = listDirectory(refDir);
+    int compared = 0;
+    for (size_t i = 0; i < refs.size(); ++i) {
+        const std::string prefix = "ball.png.anim_";
+        if (refs[i].compare(0, prefix.size(), prefix) != 0) continue;
+        int frame = atoi(refs[i].c_str() + prefix.size()) - 1;
+        ASSERT_TRUE(frame >= 0 && frame < reader.GetMovieFrameCount());
+
+        CKBitmapProperties refProps;
+        ASSERT_EQ(0, PNG_Read(const_cast<char*>(joinPath(refDir, refs[i]).c_str()), 0, &refProps));
+        const VxImageDescEx& ref = refProps.m_Format;
+        std::vector<uint8_t> canvas = readCanvas(reader, frame);
+        ASSERT_EQ(static_cast<size_t>(ref.BytesPerLine) * ref.Height, canvas.size());
+        ASSERT_TRUE(memcmp(ref.Image, canvas.data(), canvas.size()) == 0);
+        delete[] static_cast<CKBYTE*>(refProps.m_Data);
+        ++compared;
+    }
+    if (compared == 0) SKIP_TEST("ball.png reference frames not found");
+    ASSERT_EQ(reader.GetMovieFrameCount(), compared);
+}
+
+//=============================================================================
+// Negative Tests
+//=============================================================================
+
+TEST(ApngReader, Negative_BadFrameControl) {
+    ApngSpec outside = makeTestAnimation();
+    outside.frames[2].x = 11; // 6 wide at x = 11 ends past the 16 pixel canvas
+    ApngAnimation anim;
+    std::vector<uint8_t> png = makeApng(outside);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, APNG_Index(png.data(), static_cast<CKDWORD>(png.size()), anim));
+
+    ApngSpec badDispose = makeTestAnimation();
+    badDispose.frames[3].dispose = 3;
+    png = makeApng(badDispose);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, APNG_Index(png.data(), static_cast<CKDWORD>(png.size()), anim));
+
+    // Frame 0 is the default image and must cover the canvas
+    ApngSpec smallFirst = makeTestAnimation();
+    smallFirst.frames[0] = smallFirst.frames[1];
+    png = makeApng(smallFirst);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, APNG_Index(png.data(), static_cast<CKDWORD>(png.size()), anim));
+}
+
+TEST(ApngReader, Negative_CorruptFrameData) {
+    ApngSpec spec = makeTestAnimation();
+    std::vector<uint8_t> png = makeApng(spec);
+    // Turn the stored block of frame 2 into an invalid block type
+    std::vector<uint8_t> z = frameZlib(spec.frames[2]);
+    std::vector<uint8_t>::iterator it = std::search(png.begin(), png.end(), z.begin(), z.begin() + 8);
+    ASSERT_TRUE(it != png.end());
+    it[2] = 0x07;
+
+    ApngReader reader;
+    ASSERT_EQ(CK_OK, reader.OpenFile(const_cast<char*>(writeTemp("apng_corrupt.png", png).c_str())));
+    ASSERT_TRUE(readCanvas(reader, 1) == modelCanvas(spec, 1));
+    int error = 0;
+    readCanvas(reader, 2, &error);
+    ASSERT_EQ(CKMOVIEERROR_FILECORRUPTED, error);
+
+    // Frames that do not depend on the broken one still read
+    ASSERT_TRUE(readCanvas(reader, 4) == modelCanvas(spec, 4));
+}
+
+TEST(ApngReader, Negative_OpenFile) {
+    ApngReader reader;
+    ASSERT_EQ(CKMOVIEERROR_READERROR, reader.OpenFile(const_cast<char*>("does_not_exist.png")));
+    std::vector<uint8_t> text(64, 'x');
+    ASSERT_EQ(CKMOVIEERROR_UNSUPPORTEDFILE, reader.OpenFile(const_cast<char*>(writeTemp("apng_text.png", text).c_str())));
+    ASSERT_EQ(0, reader.GetMovieFrameCount());
+
+    CKMovieProperties* mp = nullptr;
+    ASSERT_EQ(CKMOVIEERROR_GENERIC, reader.ReadFrame(0, &mp));
+}
+
+//=============================================================================
+// API Tests
+//=============================================================================
+
+TEST(ApngReader, GetReaderInfo) {
+    ApngReader reader;
+    CKPluginInfo* info = reader.GetReaderInfo();
+    ASSERT_TRUE(info != nullptr);
+    ASSERT_GUID_EQ(APNGREADER_GUID, info->m_GUID);
+    ASSERT_EQ(static_cast<int>(CKPLUGIN_MOVIE_READER), static_cast<int>(info->m_Type));
+}
+
+TEST(ApngReader, ReopenWhilePrefetching) {
+    ApngSpec spec = makeTestAnimation();
+    std::string path = writeTemp("apng_reopen.png", makeApng(spec));
+    ApngReader reader;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(CK_OK, reader.OpenFile(const_cast<char*>(path.c_str())));
+        ASSERT_TRUE(readCanvas(reader, i) == modelCanvas(spec, i));
+    }
+    CKMovieProperties* mp = nullptr;
+    ASSERT_EQ(CKMOVIEERROR_GENERIC, reader.ReadFrame(7, &mp));
+}
@@ -1397,6 +1397,48 @@ TEST(BmpReader, Negative_VeryLargeDimensions) {
     ASSERT_NE(0, result.errorCode);
 }
 
+//=============================================================================
+// Decode Limit Tests
+//=============================================================================
+
+TEST(BmpReader, Limits_PixelDataBeyondFile) {
+    // A large image declared over a few bytes of pixels is rejected before allocating
+    std::vector<uint8_t> data = generateBmpRGB24(16, 16);
+    uint32_t side = 20000;
+    memcpy(&data[18], &side, 4);
+    memcpy(&data[22], &side, 4);
+    BmpTestResult result = readBmpMemory(data.data(), static_cast<int>(data.size()));
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, result.errorCode);
+
+    // The padding of the last row may be missing, but not its pixels
+    data = generateBmpRGB24(5, 4);
+    data.resize(data.size() - 1);
+    result = readBmpMemory(data.data(), static_cast<int>(data.size()));
+    ASSERT_EQ(0, result.errorCode);
+    data.resize(data.size() - 1);
+    result = readBmpMemory(data.data(), static_cast<int>(data.size()));
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, result.errorCode);
+}
+
+TEST(BmpReader, Limits_DecodeBudget) {
+    struct RestoreLimits {
+        ~RestoreLimits() { ImageSetDecodeLimits(0, 0); }
+    } restore;
+    std::vector<uint8_t> data = generateBmpRGB24(64, 64);
+
+    ImageSetDecodeLimits(64 * 64 - 1, 0);
+    ASSERT_EQ(64u * 64 - 1, ImageGetMaxPixels());
+    ASSERT_EQ(IMAGE_DEFAULT_MAX_BYTES, ImageGetMaxBytes());
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readBmpMemory(data.data(), static_cast<int>(data.size())).errorCode);
+
+    ImageSetDecodeLimits(0, 64 * 64 * 4 - 1);
+    ASSERT_EQ(IMAGE_DEFAULT_MAX_PIXELS, ImageGetMaxPixels());
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readBmpMemory(data.data(), static_cast<int>(data.size())).errorCode);
+
+    ImageSetDecodeLimits(64 * 64, 64 * 64 * 4);
+    ASSERT_EQ(0, readBmpMemory(data.data(), static_cast<int>(data.size())).errorCode);
+}
+
 //=============================================================================
 // Memory vs File Consistency Tests
 //=============================================================================
@@ -1706,4 +1748,111 @@ TEST(BmpReader, BadBmpFixtures_MustNotCrash) {
         }
         ASSERT_TRUE(false);
     }
-}
\ No newline at end of file
+}
+//=============================================================================
+// Index-Preserving Read Tests (IMAGE_READ_KEEP_INDICES)
+//=============================================================================
+
+namespace {
+
+// Reads path with and without IMAGE_READ_KEEP_INDICES and checks that looking the
+// indices up in ColorMap reproduces the BGRA32 decode exactly
+void checkIndicesMatchBGRA(const std::string& path, int expectedEntries) {
+    BmpReader bgraReader;
+    CKBitmapProperties* bgra = nullptr;
+    ASSERT_EQ(0, bgraReader.ReadFile(const_cast<char*>(path.c_str()), &bgra));
+
+    BmpReader indexReader;
+    indexReader.SetReadFlags(IMAGE_READ_KEEP_INDICES);
+    CKBitmapProperties* indexed = nullptr;
+    ASSERT_EQ(0, indexReader.ReadFile(const_cast<char*>(path.c_str()), &indexed));
+
+    const VxImageDescEx& fmt = indexed->m_Format;
+    ASSERT_EQ(8, fmt.BitsPerPixel);
+    ASSERT_EQ(4, fmt.BytesPerColorEntry);
+    ASSERT_EQ(expectedEntries, fmt.ColorMapEntries);
+    ASSERT_TRUE(fmt.ColorMap != nullptr);
+    ASSERT_EQ(bgra->m_Format.Width, fmt.Width);
+    ASSERT_EQ(bgra->m_Format.Height, fmt.Height);
+    ASSERT_EQ((fmt.Width + 3) & ~3, fmt.BytesPerLine);
+
+    bool match = true;
+    for (int y = 0; y < fmt.Height && match; ++y) {
+        const uint8_t* idxRow = fmt.Image + y * fmt.BytesPerLine;
+        const uint8_t* bgraRow = bgra->m_Format.Image + y * bgra->m_Format.BytesPerLine;
+        for (int x = 0; x < fmt.Width; ++x) {
+            if (idxRow[x] >= fmt.ColorMapEntries ||
+                memcmp(fmt.ColorMap + idxRow[x] * 4, bgraRow + x * 4, 4) != 0) {
+                match = false;
+                break;
+            }
+        }
+    }
+    ASSERT_TRUE(match);
+}
+
+} // anonymous namespace
+
+TEST(BmpReader, KeepIndices_Core_1_Bit) {
+    std::string path = getBmpTestImagePath("Core_1_Bit.bmp");
+    if (!fileExists(path)) SKIP_TEST("Test image not found");
+    checkIndicesMatchBGRA(path, 2);
+}
+
+TEST(BmpReader, KeepIndices_Info_4_Bit) {
+    std::string path = getBmpTestImagePath("Info_4_Bit.bmp");
+    if (!fileExists(path)) SKIP_TEST("Test image not found");
+    checkIndicesMatchBGRA(path, 6);
+}
+
+TEST(BmpReader, KeepIndices_Info_8_Bit_TopDown) {
+    std::string path = getBmpTestImagePath("Info_8_Bit_Top_Down.bmp");
+    if (!fileExists(path)) SKIP_TEST("Test image not found");
+    checkIndicesMatchBGRA(path, 6);
+}
+
+TEST(BmpReader, KeepIndices_Pal8_RLE) {
+    std::string path = getBmpTestImagePath("pal8rle.bmp");
+    if (!fileExists(path)) SKIP_TEST("Test image not found");
+    checkIndicesMatchBGRA(path, 252);
+}
+
+TEST(BmpReader, KeepIndices_Pal4_RLE) {
+    std::string path = getBmpTestImagePath("pal4rle.bmp");
+    if (!fileExists(path)) SKIP_TEST("Test image not found");
+    checkIndicesMatchBGRA(path, 12);
+}
+
+TEST(BmpReader, KeepIndices_IgnoredForTrueColor) {
+    std::string path = getBmpTestImagePath("rgb24.bmp");
+    if (!fileExists(path)) SKIP_TEST("Test image not found");
+
+    BmpReader reader;
+    reader.SetReadFlags(IMAGE_READ_KEEP_INDICES);
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(0, reader.ReadFile(const_cast<char*>(path.c_str()), &props));
+    ASSERT_EQ(32, props->m_Format.BitsPerPixel);
+    ASSERT_TRUE(props->m_Format.ColorMap == nullptr);
+}
+
+TEST(BmpReader, KeepIndices_RLESkippedPixelsAreIndexZero) {
+    // 4x2 RLE8: end-of-bitmap right after one pixel leaves the rest unset
+    const uint8_t bmp[] = {
+        'B', 'M', 70, 0, 0, 0, 0, 0, 0, 0, 62, 0, 0, 0,
+        40, 0, 0, 0, 4, 0, 0, 0, 2, 0, 0, 0, 1, 0, 8, 0, 1, 0, 0, 0,
+        8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0,
+        10, 20, 30, 0, 40, 50, 60, 0,
+        1, 1, 0, 1, 0, 0, 0, 0};
+    BmpReader reader;
+    reader.SetReadFlags(IMAGE_READ_KEEP_INDICES);
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(0, reader.ReadMemory(const_cast<uint8_t*>(bmp), static_cast<int>(sizeof(bmp)), &props));
+    const VxImageDescEx& fmt = props->m_Format;
+    ASSERT_EQ(2, fmt.ColorMapEntries);
+    ASSERT_EQ(40, fmt.ColorMap[4]);
+    ASSERT_EQ(255, fmt.ColorMap[7]);
+    // Bottom-up: the first encoded row is the last image row
+    ASSERT_EQ(1, fmt.Image[fmt.BytesPerLine]);
+    ASSERT_EQ(0, fmt.Image[fmt.BytesPerLine + 1]);
+    ASSERT_EQ(0, fmt.Image[0]);
+}
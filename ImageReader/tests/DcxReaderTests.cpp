@@ -0,0 +1,263 @@
+/**
+ * @file DcxReaderTests.cpp
+ * @brief DCX (multi-page PCX) tests for CKImageReader
+ *
+ * Tests cover:
+ * - Page index construction from the offset table
+ * - Decoding individual pages and page ranges (parallel)
+ * - Reader interface (first page via ReadMemory/ReadFile)
+ * - Malformed archives (bad magic, empty table, offsets out of range)
+ */
+
+#include "TestFramework.h"
+#include "DcxReader.h"
+#include "PcxReader.h"
+#include <cstring>
+
+using namespace TestFramework;
+
+//=============================================================================
+// Test Helpers
+//=============================================================================
+
+namespace {
+
+// Builds a 24-bit PCX page whose pixels all derive from seed
+std::vector<uint8_t> makePcxPage(int width, int height, int seed) {
+    std::vector<uint8_t> pixels(width * height * 4);
+    for (int i = 0; i < width * height; ++i) {
+        pixels[i * 4 + 0] = static_cast<uint8_t>(seed * 31 + i);
+        pixels[i * 4 + 1] = static_cast<uint8_t>(seed * 7);
+        pixels[i * 4 + 2] = static_cast<uint8_t>(i / width);
+        pixels[i * 4 + 3] = 255;
+    }
+
+    PcxBitmapProperties props;
+    ImageReader::FillFormatBGRA32(props.m_Format, width, height, width * 4, pixels.data());
+    void* memory = nullptr;
+    int size = PCX_Save(&memory, &props, 24, 1);
+    std::vector<uint8_t> page;
+    if (size > 0 && memory) {
+        page.assign(static_cast<uint8_t*>(memory), static_cast<uint8_t*>(memory) + size);
+        delete[] static_cast<CKBYTE*>(memory);
+    }
+    return page;
+}
+
+void putLE32(std::vector<uint8_t>& out, size_t pos, uint32_t v) {
+    out[pos + 0] = static_cast<uint8_t>(v);
+    out[pos + 1] = static_cast<uint8_t>(v >> 8);
+    out[pos + 2] = static_cast<uint8_t>(v >> 16);
+    out[pos + 3] = static_cast<uint8_t>(v >> 24);
+}
+
+// Packs pages behind a full 1024-entry offset table
+std::vector<uint8_t> makeDcx(const std::vector<std::vector<uint8_t> >& pages) {
+    std::vector<uint8_t> dcx(4 + 1024 * 4, 0);
+    putLE32(dcx, 0, DCX_MAGIC);
+    for (size_t i = 0; i < pages.size(); ++i) {
+        putLE32(dcx, 4 + i * 4, static_cast<uint32_t>(dcx.size()));
+        dcx.insert(dcx.end(), pages[i].begin(), pages[i].end());
+    }
+    return dcx;
+}
+
+uint32_t pageCrc(const CKBitmapProperties& props) {
+    return CRC32::compute(props.m_Format.Image, props.m_Format.BytesPerLine * props.m_Format.Height);
+}
+
+uint32_t pcxCrc(const std::vector<uint8_t>& page) {
+    CKBitmapProperties props;
+    memset(&props, 0, sizeof(props));
+    if (PCX_Read(const_cast<uint8_t*>(page.data()), static_cast<int>(page.size()), &props) != 0) return 0;
+    uint32_t crc = pageCrc(props);
+    ImageReader::FreeBitmapData(&props);
+    return crc;
+}
+
+} // anonymous namespace
+
+//=============================================================================
+// Page Index Tests
+//=============================================================================
+
+TEST(DcxReader, Index_CountsPages) {
+    std::vector<std::vector<uint8_t> > pages;
+    pages.push_back(makePcxPage(10, 4, 1));
+    pages.push_back(makePcxPage(7, 9, 2));
+    pages.push_back(makePcxPage(3, 3, 3));
+    std::vector<uint8_t> dcx = makeDcx(pages);
+
+    DcxArchive archive;
+    ASSERT_EQ(0, DCX_Index(dcx.data(), static_cast<int>(dcx.size()), archive));
+    ASSERT_EQ(3u, archive.pageCount);
+    ASSERT_EQ(static_cast<CKDWORD>(pages[0].size()), archive.pages[0].size);
+    ASSERT_EQ(static_cast<CKDWORD>(pages[2].size()), archive.pages[2].size);
+}
+
+TEST(DcxReader, Index_BadMagic) {
+    std::vector<std::vector<uint8_t> > pages(1, makePcxPage(4, 4, 1));
+    std::vector<uint8_t> dcx = makeDcx(pages);
+    dcx[0] ^= 0xFF;
+
+    DcxArchive archive;
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, DCX_Index(dcx.data(), static_cast<int>(dcx.size()), archive));
+}
+
+TEST(DcxReader, Index_NoPages) {
+    std::vector<uint8_t> dcx = makeDcx(std::vector<std::vector<uint8_t> >());
+
+    DcxArchive archive;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, DCX_Index(dcx.data(), static_cast<int>(dcx.size()), archive));
+}
+
+TEST(DcxReader, Index_OffsetOutOfRange) {
+    std::vector<std::vector<uint8_t> > pages(2, makePcxPage(4, 4, 1));
+    std::vector<uint8_t> dcx = makeDcx(pages);
+    putLE32(dcx, 8, static_cast<uint32_t>(dcx.size() + 100));
+
+    DcxArchive archive;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, DCX_Index(dcx.data(), static_cast<int>(dcx.size()), archive));
+}
+
+TEST(DcxReader, Index_OffsetInsideTable) {
+    std::vector<std::vector<uint8_t> > pages(1, makePcxPage(4, 4, 1));
+    std::vector<uint8_t> dcx = makeDcx(pages);
+    putLE32(dcx, 4, 2);
+
+    DcxArchive archive;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, DCX_Index(dcx.data(), static_cast<int>(dcx.size()), archive));
+}
+
+TEST(DcxReader, Index_Truncated) {
+    std::vector<uint8_t> dcx(6, 0);
+    putLE32(dcx, 0, DCX_MAGIC);
+
+    DcxArchive archive;
+    ASSERT_NE(0, DCX_Index(dcx.data(), static_cast<int>(dcx.size()), archive));
+}
+
+//=============================================================================
+// Page Decoding Tests
+//=============================================================================
+
+TEST(DcxReader, ReadPage_MatchesStandalonePcx) {
+    std::vector<std::vector<uint8_t> > pages;
+    for (int i = 0; i < 4; ++i) {
+        pages.push_back(makePcxPage(12 + i, 5 + i, i));
+    }
+    std::vector<uint8_t> dcx = makeDcx(pages);
+
+    DcxArchive archive;
+    ASSERT_EQ(0, DCX_Index(dcx.data(), static_cast<int>(dcx.size()), archive));
+    for (CKDWORD i = 0; i < archive.pageCount; ++i) {
+        CKBitmapProperties props;
+        memset(&props, 0, sizeof(props));
+        ASSERT_EQ(0, DCX_ReadPage(archive, i, &props));
+        ASSERT_EQ(12 + static_cast<int>(i), props.m_Format.Width);
+        ASSERT_EQ(5 + static_cast<int>(i), props.m_Format.Height);
+        ASSERT_EQ(pcxCrc(pages[i]), pageCrc(props));
+        ImageReader::FreeBitmapData(&props);
+    }
+}
+
+TEST(DcxReader, ReadPage_OutOfRange) {
+    std::vector<std::vector<uint8_t> > pages(1, makePcxPage(4, 4, 1));
+    std::vector<uint8_t> dcx = makeDcx(pages);
+
+    DcxArchive archive;
+    ASSERT_EQ(0, DCX_Index(dcx.data(), static_cast<int>(dcx.size()), archive));
+    CKBitmapProperties props;
+    memset(&props, 0, sizeof(props));
+    ASSERT_EQ(CKBITMAPERROR_READERROR, DCX_ReadPage(archive, 1, &props));
+}
+
+TEST(DcxReader, ReadPages_Parallel) {
+    std::vector<std::vector<uint8_t> > pages;
+    for (int i = 0; i < 24; ++i) {
+        pages.push_back(makePcxPage(40, 30, i));
+    }
+    std::vector<uint8_t> dcx = makeDcx(pages);
+
+    DcxArchive archive;
+    ASSERT_EQ(0, DCX_Index(dcx.data(), static_cast<int>(dcx.size()), archive));
+
+    std::vector<CKBitmapProperties> results(20);
+    memset(results.data(), 0, results.size() * sizeof(CKBitmapProperties));
+    ASSERT_EQ(0, DCX_ReadPages(archive, 3, 20, results.data()));
+
+    bool match = true;
+    for (int i = 0; i < 20; ++i) {
+        if (pageCrc(results[i]) != pcxCrc(pages[3 + i])) {
+            match = false;
+        }
+        ImageReader::FreeBitmapData(&results[i]);
+    }
+    ASSERT_TRUE(match);
+}
+
+TEST(DcxReader, ReadPages_ReportsCorruptPage) {
+    std::vector<std::vector<uint8_t> > pages(3, makePcxPage(8, 8, 1));
+    pages[1][0] = 0x00; // not a PCX manufacturer byte
+    std::vector<uint8_t> dcx = makeDcx(pages);
+
+    DcxArchive archive;
+    ASSERT_EQ(0, DCX_Index(dcx.data(), static_cast<int>(dcx.size()), archive));
+
+    CKBitmapProperties results[3];
+    memset(results, 0, sizeof(results));
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, DCX_ReadPages(archive, 0, 3, results));
+    for (int i = 0; i < 3; ++i) {
+        ImageReader::FreeBitmapData(&results[i]);
+    }
+}
+
+//=============================================================================
+// Reader Interface Tests
+//=============================================================================
+
+TEST(DcxReader, ReadMemory_FirstPage) {
+    std::vector<std::vector<uint8_t> > pages;
+    pages.push_back(makePcxPage(9, 6, 5));
+    pages.push_back(makePcxPage(4, 4, 6));
+    std::vector<uint8_t> dcx = makeDcx(pages);
+
+    DcxReader reader;
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(0, reader.ReadMemory(dcx.data(), static_cast<int>(dcx.size()), &props));
+    ASSERT_TRUE(props != nullptr);
+    ASSERT_EQ(9, props->m_Format.Width);
+    ASSERT_EQ(6, props->m_Format.Height);
+    ASSERT_EQ(pcxCrc(pages[0]), pageCrc(*props));
+}
+
+TEST(DcxReader, ReadFile_FirstPage) {
+    std::vector<std::vector<uint8_t> > pages;
+    pages.push_back(makePcxPage(11, 3, 8));
+    std::vector<uint8_t> dcx = makeDcx(pages);
+
+    std::string tempPath = joinPath(g_TestOutputDir, "dcx_read_test.dcx");
+    FILE* f = fopen(tempPath.c_str(), "wb");
+    ASSERT_TRUE(f != nullptr);
+    fwrite(dcx.data(), 1, dcx.size(), f);
+    fclose(f);
+
+    DcxReader reader;
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(0, reader.ReadFile(const_cast<char*>(tempPath.c_str()), &props));
+    ASSERT_TRUE(props != nullptr);
+    ASSERT_EQ(11, props->m_Format.Width);
+    ASSERT_EQ(pcxCrc(pages[0]), pageCrc(*props));
+    remove(tempPath.c_str());
+}
+
+TEST(DcxReader, ReadFile_Missing) {
+    DcxReader reader;
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(CKBITMAPERROR_READERROR, reader.ReadFile(const_cast<char*>("does_not_exist.dcx"), &props));
+}
+
+TEST(DcxReader, GetOptionsCount) {
+    DcxReader reader;
+    ASSERT_EQ(0, reader.GetOptionsCount());
+}
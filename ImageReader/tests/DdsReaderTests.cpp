@@ -0,0 +1,674 @@
+/**
+ * @file DdsReaderTests.cpp
+ * @brief DDS format and BC1-BC7 block decoding tests for CKImageReader
+ *
+ * Tests cover:
+ * - Hand-built BC1 to BC7 blocks and CRCs of random blocks of every format
+ *   (cross-checked against an independent decoder when they were recorded)
+ * - Decoding the top level to BGRA32, RGBA float for BC6H, and passing the
+ *   blocks of the whole mip chain through with IMAGE_READ_KEEP_BLOCKS
+ * - Cube maps, arrays and volumes (first face, element and slice)
+ * - Uncompressed pixel formats, the corpus in tests/images/dds
+ * - Malformed files (bad headers, truncated levels, huge dimensions)
+ */
+
+#include "TestFramework.h"
+#include "DdsReader.h"
+#include "PngReader.h"
+#include "ImageBcn.h"
+#include <cstring>
+
+using namespace TestFramework;
+
+//=============================================================================
+// Test Helpers
+//=============================================================================
+
+namespace {
+
+uint32_t g_Seed = 7331;
+
+uint32_t nextRandom() {
+    g_Seed = g_Seed * 1103515245u + 12345u;
+    return g_Seed >> 8;
+}
+
+void putLE32(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v >> 16));
+    out.push_back(static_cast<uint8_t>(v >> 24));
+}
+
+uint32_t fourCC(const char* s) {
+    return static_cast<uint32_t>(s[0]) | (static_cast<uint32_t>(s[1]) << 8) |
+           (static_cast<uint32_t>(s[2]) << 16) | (static_cast<uint32_t>(s[3]) << 24);
+}
+
+// Random blocks; BC6H and BC7 blocks cycle through every mode
+std::vector<uint8_t> randomBlocks(CKDWORD format, size_t count) {
+    static const uint8_t bc6Codes[14] = {0, 1, 2, 6, 10, 14, 18, 22, 26, 30, 3, 7, 11, 15};
+    size_t blockBytes = ImageBlockBytes(format);
+    std::vector<uint8_t> out(count * blockBytes);
+    for (size_t i = 0; i < out.size(); ++i)
+        out[i] = static_cast<uint8_t>(nextRandom());
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t& first = out[i * blockBytes];
+        if (format == IMAGE_BLOCK_BC7) {
+            int mode = static_cast<int>(i % 8);
+            first = static_cast<uint8_t>((first & ~((2 << mode) - 1)) | (1 << mode));
+        } else if (format == IMAGE_BLOCK_BC6H || format == IMAGE_BLOCK_BC6H_SF16) {
+            uint8_t code = bc6Codes[i % 14];
+            int bits = (code < 2) ? 2 : 5;
+            first = static_cast<uint8_t>((first & ~((1 << bits) - 1)) | code);
+        }
+    }
+    return out;
+}
+
+// Writes fields LSB first, as BC6H and BC7 blocks are laid out
+struct BitWriter {
+    uint8_t bytes[16];
+    int pos;
+
+    BitWriter() : pos(0) { memset(bytes, 0, sizeof(bytes)); }
+
+    void put(uint32_t value, int count) {
+        for (int i = 0; i < count; ++i, ++pos)
+            if (value & (1u << i)) bytes[pos / 8] |= static_cast<uint8_t>(1 << (pos % 8));
+    }
+};
+
+struct DdsDesc {
+    uint32_t width;
+    uint32_t height;
+    uint32_t mips;
+    uint32_t depth;
+    uint32_t pfFlags;
+    uint32_t fourCC;
+    uint32_t bitCount;
+    uint32_t masks[4]; // R, G, B, A
+    uint32_t caps2;
+    bool dx10;
+    uint32_t dxgi;
+    uint32_t dimension;
+    uint32_t misc;
+    uint32_t arraySize;
+
+    DdsDesc(uint32_t w, uint32_t h)
+        : width(w), height(h), mips(1), depth(0), pfFlags(DDPF_FOURCC), fourCC(0), bitCount(0), caps2(0),
+          dx10(false), dxgi(0), dimension(3), misc(0), arraySize(1) {
+        memset(masks, 0, sizeof(masks));
+    }
+};
+
+DdsDesc blockDesc(uint32_t w, uint32_t h, const char* code) {
+    DdsDesc desc(w, h);
+    desc.fourCC = fourCC(code);
+    return desc;
+}
+
+DdsDesc dx10Desc(uint32_t w, uint32_t h, uint32_t dxgi) {
+    DdsDesc desc(w, h);
+    desc.fourCC = fourCC("DX10");
+    desc.dx10 = true;
+    desc.dxgi = dxgi;
+    return desc;
+}
+
+DdsDesc maskDesc(uint32_t w, uint32_t h, uint32_t flags, uint32_t bitCount, uint32_t r, uint32_t g, uint32_t b,
+                 uint32_t a) {
+    DdsDesc desc(w, h);
+    desc.pfFlags = flags;
+    desc.bitCount = bitCount;
+    desc.masks[0] = r;
+    desc.masks[1] = g;
+    desc.masks[2] = b;
+    desc.masks[3] = a;
+    return desc;
+}
+
+std::vector<uint8_t> makeDds(const DdsDesc& desc, const std::vector<uint8_t>& payload) {
+    std::vector<uint8_t> out(DDS_MAGIC, DDS_MAGIC + 4);
+    putLE32(out, 124);
+    putLE32(out, 0x1007 | (desc.mips > 1 ? 0x20000 : 0));
+    putLE32(out, desc.height);
+    putLE32(out, desc.width);
+    putLE32(out, 0);
+    putLE32(out, desc.depth);
+    putLE32(out, desc.mips);
+    for (int i = 0; i < 11; ++i) putLE32(out, 0);
+    putLE32(out, 32);
+    putLE32(out, desc.pfFlags);
+    putLE32(out, desc.fourCC);
+    putLE32(out, desc.bitCount);
+    for (int i = 0; i < 4; ++i) putLE32(out, desc.masks[i]);
+    putLE32(out, 0x1000);
+    putLE32(out, desc.caps2);
+    for (int i = 0; i < 3; ++i) putLE32(out, 0);
+    if (desc.dx10) {
+        putLE32(out, desc.dxgi);
+        putLE32(out, desc.dimension);
+        putLE32(out, desc.misc);
+        putLE32(out, desc.arraySize);
+        putLE32(out, 0);
+    }
+    out.insert(out.end(), payload.begin(), payload.end());
+    return out;
+}
+
+struct DdsTestResult {
+    int errorCode;
+    int width;
+    int height;
+    int bytesPerLine;
+    int bitsPerPixel;
+    std::vector<uint8_t> pixels; // tightly packed rows, or the blocks as returned
+    DdsBitmapProperties props;
+};
+
+DdsTestResult readDds(const std::vector<uint8_t>& data, CKDWORD flags = 0) {
+    DdsTestResult result;
+    DdsReader reader;
+    reader.SetReadFlags(flags);
+    CKBitmapProperties* props = nullptr;
+    result.errorCode = reader.ReadMemory(const_cast<uint8_t*>(data.data()), static_cast<int>(data.size()), &props);
+    result.width = 0;
+    result.height = 0;
+    result.bytesPerLine = 0;
+    result.bitsPerPixel = 0;
+    if (result.errorCode == 0 && props && props->m_Format.Image) {
+        const VxImageDescEx& fmt = props->m_Format;
+        result.props = *reinterpret_cast<DdsBitmapProperties*>(props);
+        result.width = fmt.Width;
+        result.height = fmt.Height;
+        result.bytesPerLine = fmt.BytesPerLine;
+        result.bitsPerPixel = fmt.BitsPerPixel;
+        if (flags & IMAGE_READ_KEEP_BLOCKS && result.props.m_BlockFormat != IMAGE_BLOCK_NONE) {
+            result.pixels.assign(fmt.Image, fmt.Image + result.props.m_DataSize);
+        } else {
+            for (int y = 0; y < fmt.Height; ++y) {
+                const uint8_t* row = fmt.Image + y * fmt.BytesPerLine;
+                result.pixels.insert(result.pixels.end(), row, row + fmt.Width * fmt.BitsPerPixel / 8);
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<uint8_t> decodeLevel(CKDWORD format, const uint8_t* blocks, int width, int height,
+                                 bool toFloat = false) {
+    int pixelBytes = toFloat ? 16 : 4;
+    std::vector<uint8_t> out(width * height * pixelBytes);
+    ImageDecodeBlockLevel(format, blocks, width, height, out.data(), width * pixelBytes, toFloat);
+    return out;
+}
+
+uint32_t bgra(int r, int g, int b, int a) {
+    return static_cast<uint32_t>(b) | (static_cast<uint32_t>(g) << 8) | (static_cast<uint32_t>(r) << 16) |
+           (static_cast<uint32_t>(a) << 24);
+}
+
+std::string ddsImagesDir() { return joinPath(g_TestImagesDir, "dds"); }
+
+} // namespace
+
+//=============================================================================
+// Block Decoding
+//=============================================================================
+
+TEST(DdsReader, Bcn_KnownBlocks) {
+    CKDWORD pixels[16];
+
+    // BC1, four colors: red and blue endpoints and the two thirds between
+    const uint8_t bc1[8] = {0x00, 0xF8, 0x1F, 0x00, 0xE4, 0xE4, 0xE4, 0xE4};
+    ImageDecodeBlock(IMAGE_BLOCK_BC1, bc1, pixels);
+    ASSERT_EQ(bgra(255, 0, 0, 255), pixels[0]);
+    ASSERT_EQ(bgra(0, 0, 255, 255), pixels[1]);
+    ASSERT_EQ(bgra(170, 0, 85, 255), pixels[2]);
+    ASSERT_EQ(bgra(85, 0, 170, 255), pixels[3]);
+    ASSERT_EQ(pixels[3], pixels[15]);
+
+    // BC1, three colors: endpoints swapped, index 3 is transparent black
+    const uint8_t bc1Punch[8] = {0x1F, 0x00, 0x00, 0xF8, 0xE4, 0xE4, 0xE4, 0xE4};
+    ImageDecodeBlock(IMAGE_BLOCK_BC1, bc1Punch, pixels);
+    ASSERT_EQ(bgra(127, 0, 127, 255), pixels[2]);
+    ASSERT_EQ(0u, pixels[3]);
+
+    // BC2 and BC3 always use four colors; BC2 alpha is 4 bits per pixel
+    uint8_t bc2[16] = {0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE};
+    memcpy(bc2 + 8, bc1Punch, 8);
+    ImageDecodeBlock(IMAGE_BLOCK_BC2, bc2, pixels);
+    for (int i = 0; i < 16; ++i) ASSERT_EQ(static_cast<CKDWORD>(i * 17), pixels[i] >> 24);
+    ASSERT_EQ(bgra(170, 0, 85, 0x33), pixels[3]);
+
+    // BC4: 3-bit indices 0 to 7 over the first row and a half
+    uint8_t bc4[8] = {200, 100};
+    uint32_t indices = 0;
+    for (int i = 0; i < 8; ++i) indices |= static_cast<uint32_t>(i) << (i * 3);
+    bc4[2] = static_cast<uint8_t>(indices);
+    bc4[3] = static_cast<uint8_t>(indices >> 8);
+    bc4[4] = static_cast<uint8_t>(indices >> 16);
+    ImageDecodeBlock(IMAGE_BLOCK_BC4, bc4, pixels);
+    const int palette[8] = {200, 100, 185, 171, 157, 142, 128, 114};
+    for (int i = 0; i < 8; ++i) ASSERT_EQ(bgra(palette[i], palette[i], palette[i], 255), pixels[i]);
+    ASSERT_EQ(bgra(200, 200, 200, 255), pixels[8]);
+
+    // BC4 with the first endpoint not greater: four values, then 0 and 255
+    bc4[0] = 100;
+    bc4[1] = 200;
+    ImageDecodeBlock(IMAGE_BLOCK_BC4, bc4, pixels);
+    ASSERT_EQ(bgra(120, 120, 120, 255), pixels[2]);
+    ASSERT_EQ(bgra(0, 0, 0, 255), pixels[6]);
+    ASSERT_EQ(bgra(255, 255, 255, 255), pixels[7]);
+
+    // BC7 mode 6: 7-bit endpoints and a P-bit, all indices 0
+    BitWriter bc7;
+    bc7.put(1 << 6, 7);
+    const uint32_t e0[4] = {100, 50, 25, 127};
+    for (int c = 0; c < 4; ++c) {
+        bc7.put(e0[c], 7);
+        bc7.put(0, 7);
+    }
+    bc7.put(1, 1); // P-bit of endpoint 0
+    ImageDecodeBlock(IMAGE_BLOCK_BC7, bc7.bytes, pixels);
+    for (int i = 0; i < 16; ++i) ASSERT_EQ(bgra(201, 101, 51, 255), pixels[i]);
+
+    // BC7 reserved mode (no bit set in the first byte) is transparent black
+    const uint8_t bc7Reserved[16] = {0};
+    ImageDecodeBlock(IMAGE_BLOCK_BC7, bc7Reserved, pixels);
+    ASSERT_EQ(0u, pixels[5]);
+
+    // BC6H mode 11 (10-bit endpoints, no deltas), all indices 0
+    BitWriter bc6;
+    bc6.put(3, 5);
+    bc6.put(1023, 10);
+    bc6.put(256, 10);
+    bc6.put(0, 10);
+    CKWORD halves[64];
+    ImageDecodeBlockHalf(IMAGE_BLOCK_BC6H, bc6.bytes, halves);
+    ASSERT_EQ(0x7BFF, halves[0]); // the largest half
+    ASSERT_EQ(0x1F0F, halves[1]);
+    ASSERT_EQ(0, halves[2]);
+    ASSERT_EQ(0x3C00, halves[3]);
+    ImageDecodeBlock(IMAGE_BLOCK_BC6H, bc6.bytes, pixels);
+    ASSERT_EQ(bgra(255, 2, 0, 255), pixels[0]);
+}
+
+TEST(DdsReader, Bcn_RandomBlockCrcs) {
+    // CRCs of 64x64 BGRA32 levels of random blocks
+    struct Expected {
+        CKDWORD format;
+        uint32_t crc;
+    };
+    const Expected expected[] = {
+        {IMAGE_BLOCK_BC1, 0x811c4e4a},       {IMAGE_BLOCK_BC2, 0x777dfcff},       {IMAGE_BLOCK_BC3, 0x6debbaf4},
+        {IMAGE_BLOCK_BC4, 0x13a13c15},       {IMAGE_BLOCK_BC5, 0x7e4655b9},       {IMAGE_BLOCK_BC6H, 0xfaf7e026},
+        {IMAGE_BLOCK_BC7, 0x617688d7},       {IMAGE_BLOCK_BC4_SNORM, 0xfe39cfb7}, {IMAGE_BLOCK_BC5_SNORM, 0x04ffee76},
+        {IMAGE_BLOCK_BC6H_SF16, 0x22d5dfd7},
+    };
+    g_Seed = 7331;
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i) {
+        std::vector<uint8_t> blocks = randomBlocks(expected[i].format, 256);
+        std::vector<uint8_t> pixels = decodeLevel(expected[i].format, blocks.data(), 64, 64);
+        ASSERT_CRC(expected[i].crc, pixels.data(), pixels.size());
+    }
+
+    // BC6H as float
+    std::vector<uint8_t> blocks = randomBlocks(IMAGE_BLOCK_BC6H, 256);
+    std::vector<uint8_t> floats = decodeLevel(IMAGE_BLOCK_BC6H, blocks.data(), 64, 64, true);
+    ASSERT_CRC(0x3aea70a9u, floats.data(), floats.size());
+}
+
+TEST(DdsReader, Bcn_LevelMatchesBlocks) {
+    // Partial blocks on the right and bottom are clipped; the level is
+    // decoded in parallel block rows
+    const int width = 123, height = 517;
+    const int blocksWide = (width + 3) / 4;
+    const CKDWORD formats[] = {IMAGE_BLOCK_BC1, IMAGE_BLOCK_BC3, IMAGE_BLOCK_BC5, IMAGE_BLOCK_BC6H, IMAGE_BLOCK_BC7};
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f) {
+        CKDWORD blockBytes = ImageBlockBytes(formats[f]);
+        std::vector<uint8_t> blocks = randomBlocks(formats[f], blocksWide * ((height + 3) / 4));
+        std::vector<uint8_t> level = decodeLevel(formats[f], blocks.data(), width, height);
+        for (int y = 0; y < height; y += 3) {
+            for (int x = 0; x < width; x += 5) {
+                CKDWORD pixels[16];
+                ImageDecodeBlock(formats[f], &blocks[((y / 4) * blocksWide + x / 4) * blockBytes], pixels);
+                uint32_t actual;
+                memcpy(&actual, &level[(y * width + x) * 4], 4);
+                ASSERT_EQ(pixels[(y % 4) * 4 + x % 4], actual);
+            }
+        }
+    }
+}
+
+TEST(DdsReader, Bcn_Sizes) {
+    ASSERT_EQ(8u, ImageBlockBytes(IMAGE_BLOCK_BC1));
+    ASSERT_EQ(8u, ImageBlockBytes(IMAGE_BLOCK_BC4_SNORM));
+    ASSERT_EQ(16u, ImageBlockBytes(IMAGE_BLOCK_BC7));
+    ASSERT_EQ(0u, ImageBlockBytes(IMAGE_BLOCK_NONE));
+    ASSERT_EQ(0u, ImageBlockBytes(IMAGE_BLOCK_FORMAT_COUNT));
+    ASSERT_EQ(static_cast<uint64_t>(8), ImageBlockLevelSize(IMAGE_BLOCK_BC1, 1, 1));
+    ASSERT_EQ(static_cast<uint64_t>(2 * 3 * 16), ImageBlockLevelSize(IMAGE_BLOCK_BC3, 5, 9));
+    // 16x8, 8x4, 4x2, 2x1, 1x1
+    ASSERT_EQ(static_cast<uint64_t>((8 + 2 + 1 + 1 + 1) * 8), ImageBlockChainSize(IMAGE_BLOCK_BC1, 16, 8, 5));
+}
+
+//=============================================================================
+// Block Formats
+//=============================================================================
+
+TEST(DdsReader, DecodesTopLevel) {
+    // 20x12 DXT5 with three levels: only the first is decoded
+    std::vector<uint8_t> level0 = randomBlocks(IMAGE_BLOCK_BC3, 5 * 3);
+    std::vector<uint8_t> payload = level0;
+    std::vector<uint8_t> rest = randomBlocks(IMAGE_BLOCK_BC3, 3 * 2 + 2 * 1);
+    payload.insert(payload.end(), rest.begin(), rest.end());
+    DdsDesc desc = blockDesc(20, 12, "DXT5");
+    desc.mips = 3;
+
+    DdsTestResult r = readDds(makeDds(desc, payload));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(20, r.width);
+    ASSERT_EQ(12, r.height);
+    ASSERT_EQ(32, r.bitsPerPixel);
+    ASSERT_TRUE(r.pixels == decodeLevel(IMAGE_BLOCK_BC3, level0.data(), 20, 12));
+    ASSERT_EQ(static_cast<CKDWORD>(IMAGE_BLOCK_BC3), r.props.m_BlockFormat);
+    ASSERT_EQ(3u, r.props.m_MipCount);
+    ASSERT_EQ(20u * 12 * 4, r.props.m_DataSize);
+    ASSERT_EQ(1u, r.props.m_Faces);
+    ASSERT_EQ(1u, r.props.m_Layers);
+    ASSERT_EQ(1u, r.props.m_Depth);
+    ASSERT_EQ(0u, r.props.m_Srgb);
+}
+
+TEST(DdsReader, KeepBlocks_PassesChainThrough) {
+    const char* codes[] = {"DXT1", "DXT3", "DXT5", "ATI1", "BC4S", "ATI2", "BC5S"};
+    const CKDWORD formats[] = {IMAGE_BLOCK_BC1, IMAGE_BLOCK_BC2,       IMAGE_BLOCK_BC3,      IMAGE_BLOCK_BC4,
+                               IMAGE_BLOCK_BC4_SNORM, IMAGE_BLOCK_BC5, IMAGE_BLOCK_BC5_SNORM};
+    for (int i = 0; i < 7; ++i) {
+        // 33x9: 9x3, 5x2, 3x1, 2x1, 1x1, 1x1 blocks
+        size_t chainBytes = ImageBlockChainSize(formats[i], 33, 9, 6);
+        std::vector<uint8_t> chain(chainBytes);
+        for (size_t j = 0; j < chain.size(); ++j) chain[j] = static_cast<uint8_t>(nextRandom());
+        DdsDesc desc = blockDesc(33, 9, codes[i]);
+        desc.mips = 6;
+
+        DdsTestResult r = readDds(makeDds(desc, chain), IMAGE_READ_KEEP_BLOCKS);
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_TRUE(r.pixels == chain);
+        ASSERT_EQ(formats[i], r.props.m_BlockFormat);
+        ASSERT_EQ(6u, r.props.m_MipCount);
+        ASSERT_EQ(static_cast<CKDWORD>(chainBytes), r.props.m_DataSize);
+        ASSERT_EQ(33, r.width);
+        ASSERT_EQ(9, r.height);
+        ASSERT_EQ(static_cast<int>(9 * ImageBlockBytes(formats[i])), r.bytesPerLine);
+        ASSERT_EQ(static_cast<int>(ImageBlockBytes(formats[i]) / 2), r.bitsPerPixel);
+    }
+}
+
+TEST(DdsReader, KeepBlocks_FirstFaceLayerAndSlice) {
+    // Cube map: six faces of two levels each; the first face comes first
+    size_t faceBytes = ImageBlockChainSize(IMAGE_BLOCK_BC1, 8, 8, 2);
+    std::vector<uint8_t> faces = randomBlocks(IMAGE_BLOCK_BC1, 6 * (4 + 1));
+    DdsDesc cube = blockDesc(8, 8, "DXT1");
+    cube.mips = 2;
+    cube.caps2 = DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_ALLFACES;
+    DdsTestResult r = readDds(makeDds(cube, faces), IMAGE_READ_KEEP_BLOCKS);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(6u, r.props.m_Faces);
+    ASSERT_TRUE(r.pixels == std::vector<uint8_t>(faces.begin(), faces.begin() + faceBytes));
+
+    // DX10 array of three BC7 textures
+    std::vector<uint8_t> layers = randomBlocks(IMAGE_BLOCK_BC7, 3 * 4);
+    DdsDesc array = dx10Desc(8, 8, 99);
+    array.arraySize = 3;
+    r = readDds(makeDds(array, layers), IMAGE_READ_KEEP_BLOCKS);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(3u, r.props.m_Layers);
+    ASSERT_EQ(1u, r.props.m_Srgb);
+    ASSERT_TRUE(r.pixels == std::vector<uint8_t>(layers.begin(), layers.begin() + 4 * 16));
+
+    // An array size of 0 (as some writers leave it) is one texture
+    array.arraySize = 0;
+    r = readDds(makeDds(array, layers), IMAGE_READ_KEEP_BLOCKS);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(1u, r.props.m_Layers);
+
+    // Volume 8x8x4 with two levels: slices 0 of level 0 and of level 1
+    std::vector<uint8_t> volume = randomBlocks(IMAGE_BLOCK_BC1, 4 * 4 + 2 * 1);
+    DdsDesc desc = blockDesc(8, 8, "DXT1");
+    desc.mips = 2;
+    desc.depth = 4;
+    desc.caps2 = DDSCAPS2_VOLUME;
+    r = readDds(makeDds(desc, volume), IMAGE_READ_KEEP_BLOCKS);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(4u, r.props.m_Depth);
+    std::vector<uint8_t> expected(volume.begin(), volume.begin() + 4 * 8);
+    expected.insert(expected.end(), volume.begin() + 16 * 8, volume.begin() + 17 * 8);
+    ASSERT_TRUE(r.pixels == expected);
+
+    // Decoding reads the same first slice
+    r = readDds(makeDds(desc, volume));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == decodeLevel(IMAGE_BLOCK_BC1, volume.data(), 8, 8));
+}
+
+TEST(DdsReader, Dx10_Bc6hAndBc7) {
+    std::vector<uint8_t> blocks = randomBlocks(IMAGE_BLOCK_BC6H, 4 * 2);
+    DdsTestResult r = readDds(makeDds(dx10Desc(13, 5, 95), blocks), IMAGE_READ_FLOAT);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(128, r.bitsPerPixel);
+    ASSERT_TRUE(r.pixels == decodeLevel(IMAGE_BLOCK_BC6H, blocks.data(), 13, 5, true));
+    ASSERT_EQ(13u * 5 * 16, r.props.m_DataSize);
+
+    // Without the flag, BC6H is clamped to BGRA32
+    r = readDds(makeDds(dx10Desc(13, 5, 96), blocks));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(32, r.bitsPerPixel);
+    ASSERT_EQ(static_cast<CKDWORD>(IMAGE_BLOCK_BC6H_SF16), r.props.m_BlockFormat);
+    ASSERT_TRUE(r.pixels == decodeLevel(IMAGE_BLOCK_BC6H_SF16, blocks.data(), 13, 5));
+
+    // IMAGE_READ_FLOAT does not apply to BC7
+    blocks = randomBlocks(IMAGE_BLOCK_BC7, 4 * 2);
+    r = readDds(makeDds(dx10Desc(13, 5, 98), blocks), IMAGE_READ_FLOAT);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(32, r.bitsPerPixel);
+    ASSERT_EQ(0u, r.props.m_Srgb);
+    ASSERT_TRUE(r.pixels == decodeLevel(IMAGE_BLOCK_BC7, blocks.data(), 13, 5));
+}
+
+//=============================================================================
+// Uncompressed Formats
+//=============================================================================
+
+TEST(DdsReader, Uncompressed_Formats) {
+    // 3x2 pixels of each layout; expected BGRA32 per pixel
+    struct Case {
+        DdsDesc desc;
+        std::vector<uint8_t> payload;
+        std::vector<uint32_t> expected;
+    };
+    std::vector<Case> cases;
+
+    std::vector<uint8_t> bgraBytes;
+    std::vector<uint32_t> bgraPixels;
+    for (int i = 0; i < 6; ++i) {
+        uint32_t v = nextRandom() | (nextRandom() << 24);
+        putLE32(bgraBytes, v);
+        bgraPixels.push_back(v);
+    }
+    cases.push_back({maskDesc(3, 2, DDPF_RGB | DDPF_ALPHAPIXELS, 32, 0xFF0000, 0xFF00, 0xFF, 0xFF000000), bgraBytes,
+                     bgraPixels});
+
+    std::vector<uint32_t> bgrxPixels = bgraPixels;
+    for (size_t i = 0; i < bgrxPixels.size(); ++i) bgrxPixels[i] |= 0xFF000000;
+    cases.push_back({maskDesc(3, 2, DDPF_RGB, 32, 0xFF0000, 0xFF00, 0xFF, 0xFF000000), bgraBytes, bgrxPixels});
+
+    std::vector<uint32_t> rgbaPixels;
+    for (size_t i = 0; i < bgraPixels.size(); ++i) {
+        uint32_t v = bgraPixels[i];
+        rgbaPixels.push_back((v & 0xFF00FF00) | ((v >> 16) & 0xFF) | ((v & 0xFF) << 16));
+    }
+    cases.push_back({dx10Desc(3, 2, 28), bgraBytes, rgbaPixels});
+    cases.push_back({dx10Desc(3, 2, 87), bgraBytes, bgraPixels});
+    cases.push_back({dx10Desc(3, 2, 88), bgraBytes, bgrxPixels});
+
+    // 24-bit BGR (masks as in D3DFMT_R8G8B8) and RGB
+    std::vector<uint8_t> rgb(bgraBytes.begin(), bgraBytes.begin() + 18);
+    std::vector<uint32_t> bgrPixels, rgbPixels;
+    for (int i = 0; i < 6; ++i) {
+        bgrPixels.push_back(bgra(rgb[i * 3 + 2], rgb[i * 3 + 1], rgb[i * 3], 255));
+        rgbPixels.push_back(bgra(rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2], 255));
+    }
+    cases.push_back({maskDesc(3, 2, DDPF_RGB, 24, 0xFF0000, 0xFF00, 0xFF, 0), rgb, bgrPixels});
+    cases.push_back({maskDesc(3, 2, DDPF_RGB, 24, 0xFF, 0xFF00, 0xFF0000, 0), rgb, rgbPixels});
+
+    // 8-bit luminance, alpha and R8
+    std::vector<uint8_t> bytes8(bgraBytes.begin(), bgraBytes.begin() + 6);
+    std::vector<uint32_t> grayPixels, alphaPixels;
+    for (int i = 0; i < 6; ++i) {
+        grayPixels.push_back(bgra(bytes8[i], bytes8[i], bytes8[i], 255));
+        alphaPixels.push_back(bgra(0, 0, 0, bytes8[i]));
+    }
+    cases.push_back({maskDesc(3, 2, DDPF_LUMINANCE, 8, 0xFF, 0, 0, 0), bytes8, grayPixels});
+    cases.push_back({maskDesc(3, 2, DDPF_ALPHA, 8, 0, 0, 0, 0xFF), bytes8, alphaPixels});
+    cases.push_back({dx10Desc(3, 2, 61), bytes8, grayPixels});
+    cases.push_back({dx10Desc(3, 2, 65), bytes8, alphaPixels});
+
+    // 16-bit R5G6B5 and A1R5G5B5 scale each channel to 0..255
+    std::vector<uint8_t> bytes16;
+    putLE32(bytes16, 0x07E0F800); // red, green
+    putLE32(bytes16, 0xFFFF001F); // blue, white
+    putLE32(bytes16, 0x00004208); // 8, 16, 8 (565) or 16, 16, 8 (1555), black
+    cases.push_back({maskDesc(3, 2, DDPF_RGB, 16, 0xF800, 0x07E0, 0x001F, 0), bytes16,
+                     {bgra(255, 0, 0, 255), bgra(0, 255, 0, 255), bgra(0, 0, 255, 255), bgra(255, 255, 255, 255),
+                      bgra(66, 65, 66, 255), bgra(0, 0, 0, 255)}});
+    cases.push_back({maskDesc(3, 2, DDPF_RGB | DDPF_ALPHAPIXELS, 16, 0x7C00, 0x03E0, 0x001F, 0x8000), bytes16,
+                     {bgra(247, 0, 0, 255), bgra(8, 255, 0, 0), bgra(0, 0, 255, 0), bgra(255, 255, 255, 255),
+                      bgra(132, 132, 66, 0), bgra(0, 0, 0, 0)}});
+
+    for (size_t i = 0; i < cases.size(); ++i) {
+        DdsTestResult r = readDds(makeDds(cases[i].desc, cases[i].payload), IMAGE_READ_KEEP_BLOCKS);
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_EQ(32, r.bitsPerPixel);
+        ASSERT_EQ(static_cast<CKDWORD>(IMAGE_BLOCK_NONE), r.props.m_BlockFormat);
+        ASSERT_TRUE(memcmp(r.pixels.data(), cases[i].expected.data(), 24) == 0);
+    }
+}
+
+TEST(DdsReader, Uncompressed_ManyRows) {
+    std::vector<uint8_t> rgb;
+    for (int i = 0; i < 301 * 555 * 3; ++i) rgb.push_back(static_cast<uint8_t>(nextRandom()));
+    DdsTestResult r = readDds(makeDds(maskDesc(301, 555, DDPF_RGB, 24, 0xFF, 0xFF00, 0xFF0000, 0), rgb));
+    ASSERT_EQ(0, r.errorCode);
+    for (int i = 0; i < 301 * 555; i += 97) {
+        ASSERT_EQ(rgb[i * 3 + 2], r.pixels[i * 4]);
+        ASSERT_EQ(rgb[i * 3 + 1], r.pixels[i * 4 + 1]);
+        ASSERT_EQ(rgb[i * 3], r.pixels[i * 4 + 2]);
+        ASSERT_EQ(255, r.pixels[i * 4 + 3]);
+    }
+}
+
+TEST(DdsReader, ReaderInfo) {
+    DdsReader reader;
+    CKPluginInfo* info = reader.GetReaderInfo();
+    ASSERT_TRUE(info != nullptr);
+    ASSERT_GUID_EQ(DDSREADER_GUID, info->m_GUID);
+    ASSERT_EQ(0, reader.SaveFile(const_cast<char*>("unused.dds"), nullptr));
+}
+
+//=============================================================================
+// Corpus Tests
+//=============================================================================
+
+TEST(DdsReader, Corpus_ReferenceCrcs) {
+    std::vector<std::string> files = collectFilesWithExtensions(ddsImagesDir(), {".dds"});
+    int checked = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        uint32_t crc = 0;
+        if (!getReferenceCrc("dds/" + files[i], crc)) continue;
+        DdsTestResult r = readDds(readBinaryFile(joinPath(ddsImagesDir(), files[i])));
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_CRC(crc, r.pixels.data(), r.pixels.size());
+        ++checked;
+    }
+    if (checked == 0) SKIP_TEST("DDS corpus or reference CRCs not found");
+}
+
+TEST(DdsReader, Corpus_UncompressedMatchesPng) {
+    std::string pngPath = joinPath(joinPath(joinPath(g_TestImagesDir, "png"), "transparency"), "tp0n2c08.png");
+    std::string ddsPath = joinPath(ddsImagesDir(), "tp0n2c08_rgba.dds");
+    if (!fileExists(pngPath) || !fileExists(ddsPath)) SKIP_TEST("DDS corpus or PNG original not found");
+
+    DdsTestResult image = readDds(readBinaryFile(ddsPath));
+    ASSERT_EQ(0, image.errorCode);
+    CKBitmapProperties refProps;
+    ASSERT_EQ(0, PNG_Read(const_cast<char*>(pngPath.c_str()), 0, &refProps));
+    const VxImageDescEx& ref = refProps.m_Format;
+    ASSERT_EQ(ref.Width, image.width);
+    ASSERT_EQ(ref.Height, image.height);
+    for (int y = 0; y < ref.Height; ++y)
+        ASSERT_TRUE(memcmp(ref.Image + y * ref.BytesPerLine, &image.pixels[y * image.width * 4], image.width * 4) ==
+                    0);
+    delete[] static_cast<CKBYTE*>(refProps.m_Data);
+}
+
+//=============================================================================
+// Negative Tests
+//=============================================================================
+
+TEST(DdsReader, Truncations_FailFast) {
+    // Decoding needs the first level only; keeping the blocks needs them all
+    DdsDesc desc = blockDesc(16, 16, "DXT1");
+    desc.mips = 5;
+    std::vector<uint8_t> data = makeDds(desc, randomBlocks(IMAGE_BLOCK_BC1, 16 + 4 + 1 + 1 + 1));
+    ASSERT_EQ(0, readDds(data, IMAGE_READ_KEEP_BLOCKS).errorCode);
+    size_t level0End = DDS_HEADER_SIZE + 16 * 8;
+    for (size_t n = 1; n < data.size(); ++n) {
+        std::vector<uint8_t> prefix(data.begin(), data.begin() + n);
+        ASSERT_EQ(n < level0End ? CKBITMAPERROR_READERROR : 0, readDds(prefix).errorCode);
+        ASSERT_EQ(CKBITMAPERROR_READERROR, readDds(prefix, IMAGE_READ_KEEP_BLOCKS).errorCode);
+    }
+
+    // The DX10 header is part of the header
+    std::vector<uint8_t> dx10 = makeDds(dx10Desc(4, 4, 98), randomBlocks(IMAGE_BLOCK_BC7, 1));
+    ASSERT_EQ(0, readDds(dx10).errorCode);
+    dx10.resize(DDS_HEADER_SIZE + 10);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readDds(dx10).errorCode);
+}
+
+TEST(DdsReader, Negative_BadHeader) {
+    std::vector<uint8_t> payload = randomBlocks(IMAGE_BLOCK_BC1, 1);
+    std::vector<uint8_t> data = makeDds(blockDesc(4, 4, "DXT1"), payload);
+    ASSERT_EQ(0, readDds(data).errorCode);
+
+    std::vector<uint8_t> bad = data;
+    bad[0] = 'd';
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readDds(bad).errorCode);
+    bad = data;
+    bad[4] = 100; // header size
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readDds(bad).errorCode);
+
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readDds(makeDds(blockDesc(4, 4, "ETC1"), payload)).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readDds(makeDds(dx10Desc(4, 4, 2), payload)).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE,
+              readDds(makeDds(maskDesc(1, 1, DDPF_RGB, 12, 0xF00, 0xF0, 0xF, 0), payload)).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readDds(makeDds(maskDesc(1, 1, 0, 32, 0, 0, 0, 0), payload)).errorCode);
+
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readDds(makeDds(blockDesc(0, 4, "DXT1"), payload)).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readDds(makeDds(blockDesc(4, 0, "DXT1"), payload)).errorCode);
+    DdsDesc mips = blockDesc(4, 4, "DXT1");
+    mips.mips = 4; // 4x4 has three levels
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readDds(makeDds(mips, payload)).errorCode);
+}
+
+TEST(DdsReader, Negative_HugeDimensionsFailFast) {
+    // Beyond the pixel limit, then within it but far beyond the file
+    std::vector<uint8_t> payload = randomBlocks(IMAGE_BLOCK_BC7, 4);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readDds(makeDds(dx10Desc(0x10000, 0x10000, 98), payload)).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readDds(makeDds(dx10Desc(16384, 16384, 98), payload)).errorCode);
+    DdsDesc desc = dx10Desc(16384, 16384, 98);
+    desc.mips = 15;
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readDds(makeDds(desc, payload), IMAGE_READ_KEEP_BLOCKS).errorCode);
+}
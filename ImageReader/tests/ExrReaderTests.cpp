@@ -0,0 +1,1002 @@
+/**
+ * @file ExrReaderTests.cpp
+ * @brief OpenEXR format tests for CKImageReader
+ *
+ * Tests cover:
+ * - Uncompressed, RLE, ZIPS, ZIP and PIZ chunks, scanlines and tiles, against
+ *   encoders written from the OpenEXR reference implementation
+ * - Half, float and uint channels; RGB(A), luminance and layer channels
+ * - Data windows placed in the display window, float output
+ * - The half float conversion and the PIZ wavelet and Huffman stages
+ * - The corpus in tests/images/exr against CRCs, the uncropped original and
+ *   the Radiance version of the same image
+ * - Malformed files (bad header, chunks outside the file, corrupt chunk data)
+ */
+
+#include "TestFramework.h"
+#include "ExrReader.h"
+#include "ExrCodec.h"
+#include "HdrReader.h"
+#include "ImageSimd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <queue>
+
+using namespace TestFramework;
+
+//=============================================================================
+// Test Helpers
+//=============================================================================
+
+namespace {
+
+void putLE16(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+void putLE32(std::vector<uint8_t>& out, uint32_t v) {
+    putLE16(out, v & 0xFFFF);
+    putLE16(out, v >> 16);
+}
+
+float halfToFloat(uint16_t h) {
+    int exponent = (h >> 10) & 0x1F;
+    int mantissa = h & 0x3FF;
+    double v;
+    if (exponent == 0)
+        v = std::ldexp(static_cast<double>(mantissa), -24);
+    else if (exponent == 31)
+        v = mantissa ? NAN : INFINITY;
+    else
+        v = std::ldexp(static_cast<double>(mantissa | 0x400), exponent - 25);
+    return static_cast<float>((h & 0x8000) ? -v : v);
+}
+
+uint8_t toByte(float f) {
+    // NaN fails the first comparison, as in the reader
+    f = (f > 0.0f) ? f : 0.0f;
+    f = (f < 1.0f) ? f : 1.0f;
+    return static_cast<uint8_t>(static_cast<int>(f * 255.0f + 0.5f));
+}
+
+uint32_t floatBits(float f) {
+    uint32_t v;
+    memcpy(&v, &f, 4);
+    return v;
+}
+
+//-----------------------------------------------------------------------------
+// Compressors (ImfRle, ImfZip, ImfPizCompressor, ImfWav, ImfHuf)
+//-----------------------------------------------------------------------------
+
+// Even bytes then odd bytes, delta-coded
+std::vector<uint8_t> splitAndPredict(const std::vector<uint8_t>& raw) {
+    std::vector<uint8_t> t(raw.size());
+    size_t half = (raw.size() + 1) / 2;
+    for (size_t i = 0; i < raw.size(); ++i) t[(i & 1) ? half + i / 2 : i / 2] = raw[i];
+    for (size_t i = t.size(); i-- > 1;) t[i] = static_cast<uint8_t>(t[i] - t[i - 1] + 128);
+    return t;
+}
+
+std::vector<uint8_t> rleCompress(const std::vector<uint8_t>& raw) {
+    std::vector<uint8_t> t = splitAndPredict(raw);
+    std::vector<uint8_t> out;
+    size_t i = 0;
+    while (i < t.size()) {
+        size_t run = 1;
+        while (i + run < t.size() && run < 128 && t[i + run] == t[i]) ++run;
+        if (run >= 3) {
+            out.push_back(static_cast<uint8_t>(run - 1));
+            out.push_back(t[i]);
+            i += run;
+            continue;
+        }
+        size_t start = i;
+        while (i < t.size() && i - start < 127 &&
+               !(i + 2 < t.size() && t[i] == t[i + 1] && t[i] == t[i + 2]))
+            ++i;
+        out.push_back(static_cast<uint8_t>(-static_cast<int>(i - start)));
+        out.insert(out.end(), t.begin() + start, t.begin() + i);
+    }
+    return out;
+}
+
+std::vector<uint8_t> zlibStore(const std::vector<uint8_t>& raw) {
+    std::vector<uint8_t> z;
+    z.push_back(0x78);
+    z.push_back(0x01);
+    for (size_t pos = 0; pos == 0 || pos < raw.size(); pos += 65535) {
+        size_t n = std::min<size_t>(65535, raw.size() - pos);
+        z.push_back(pos + n == raw.size() ? 1 : 0);
+        putLE16(z, static_cast<uint32_t>(n));
+        putLE16(z, static_cast<uint32_t>(~n & 0xFFFF));
+        z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + n);
+    }
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < raw.size(); ++i) {
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    z.push_back(static_cast<uint8_t>(b >> 8));
+    z.push_back(static_cast<uint8_t>(b));
+    z.push_back(static_cast<uint8_t>(a >> 8));
+    z.push_back(static_cast<uint8_t>(a));
+    return z;
+}
+
+struct BitWriter {
+    std::vector<uint8_t> bytes;
+    uint64_t bits = 0;
+    int count = 0;
+    uint64_t total = 0;
+
+    void put(uint64_t value, int n) {
+        for (int i = n - 1; i >= 0; --i) {
+            bits = (bits << 1) | ((value >> i) & 1);
+            if (++count == 8) {
+                bytes.push_back(static_cast<uint8_t>(bits));
+                bits = 0;
+                count = 0;
+            }
+        }
+        total += n;
+    }
+    void flush() {
+        if (count) bytes.push_back(static_cast<uint8_t>(bits << (8 - count)));
+        bits = 0;
+        count = 0;
+    }
+};
+
+// Huffman lengths, canonical codes as OpenEXR assigns them, runs of a
+// repeated word coded as (word, run symbol, 8-bit count)
+std::vector<uint8_t> hufCompress(const std::vector<uint16_t>& data) {
+    std::vector<uint64_t> freq(EXR_HUF_ENCSIZE, 0);
+    for (size_t i = 0; i < data.size(); ++i) freq[data[i]]++;
+    uint32_t im = 0;
+    while (freq[im] == 0) ++im;
+    uint32_t iM = 65535;
+    while (freq[iM] == 0) --iM;
+    ++iM;
+    freq[iM] = 1; // run symbol
+
+    // Code lengths from a plain Huffman tree
+    std::vector<int> length(EXR_HUF_ENCSIZE, 0);
+    typedef std::pair<uint64_t, std::vector<uint32_t> > Node;
+    struct Greater {
+        bool operator()(const Node& a, const Node& b) const { return a.first > b.first; }
+    };
+    std::priority_queue<Node, std::vector<Node>, Greater> heap;
+    for (uint32_t s = im; s <= iM; ++s)
+        if (freq[s]) heap.push(Node(freq[s], std::vector<uint32_t>(1, s)));
+    while (heap.size() > 1) {
+        Node a = heap.top();
+        heap.pop();
+        Node b = heap.top();
+        heap.pop();
+        for (size_t k = 0; k < a.second.size(); ++k) length[a.second[k]]++;
+        for (size_t k = 0; k < b.second.size(); ++k) length[b.second[k]]++;
+        a.second.insert(a.second.end(), b.second.begin(), b.second.end());
+        heap.push(Node(a.first + b.first, a.second));
+    }
+
+    // Canonical codes (hufCanonicalCodeTable)
+    std::vector<uint64_t> n(59, 0), code(EXR_HUF_ENCSIZE, 0);
+    for (uint32_t s = 0; s < EXR_HUF_ENCSIZE; ++s) n[length[s]]++;
+    uint64_t c = 0;
+    for (int l = 58; l > 0; --l) {
+        uint64_t next = (c + n[l]) >> 1;
+        n[l] = c;
+        c = next;
+    }
+    for (uint32_t s = 0; s < EXR_HUF_ENCSIZE; ++s)
+        if (length[s] > 0) code[s] = n[length[s]]++;
+
+    // Length table with zero runs (hufPackEncTable)
+    BitWriter table;
+    for (uint32_t s = im; s <= iM; ++s) {
+        if (length[s] == 0) {
+            uint32_t run = 1;
+            while (s + run <= iM && length[s + run] == 0 && run < 261) ++run;
+            if (run >= 6) {
+                table.put(63, 6);
+                table.put(run - 6, 8);
+                s += run - 1;
+                continue;
+            }
+            if (run >= 2) {
+                table.put(59 + run - 2, 6);
+                s += run - 1;
+                continue;
+            }
+        }
+        table.put(static_cast<uint64_t>(length[s]), 6);
+    }
+    table.flush();
+
+    BitWriter bits;
+    for (size_t i = 0; i < data.size();) {
+        uint16_t s = data[i];
+        size_t run = 0;
+        while (i + 1 + run < data.size() && data[i + 1 + run] == s && run < 255) ++run;
+        bits.put(code[s], length[s]);
+        if (run >= 3) {
+            bits.put(code[iM], length[iM]);
+            bits.put(run, 8);
+            i += run + 1;
+        } else {
+            ++i;
+        }
+    }
+    uint64_t bitCount = bits.total;
+    bits.flush();
+
+    std::vector<uint8_t> out;
+    putLE32(out, im);
+    putLE32(out, iM);
+    putLE32(out, static_cast<uint32_t>(table.bytes.size()));
+    putLE32(out, static_cast<uint32_t>(bitCount));
+    putLE32(out, 0);
+    out.insert(out.end(), table.bytes.begin(), table.bytes.end());
+    out.insert(out.end(), bits.bytes.begin(), bits.bytes.end());
+    return out;
+}
+
+void wenc14(uint16_t a, uint16_t b, uint16_t& l, uint16_t& h) {
+    int as = static_cast<int16_t>(a);
+    int bs = static_cast<int16_t>(b);
+    l = static_cast<uint16_t>((as + bs) >> 1);
+    h = static_cast<uint16_t>(as - bs);
+}
+
+void wenc16(uint16_t a, uint16_t b, uint16_t& l, uint16_t& h) {
+    int ao = (a + 0x8000) & 0xFFFF;
+    int m = (ao + b) >> 1;
+    int d = ao - b;
+    if (d < 0) m = (m + 0x8000) & 0xFFFF;
+    l = static_cast<uint16_t>(m);
+    h = static_cast<uint16_t>(d & 0xFFFF);
+}
+
+void wav2Encode(uint16_t* in, int nx, int ox, int ny, int oy, uint16_t mx) {
+    void (*wenc)(uint16_t, uint16_t, uint16_t&, uint16_t&) = (mx < (1 << 14)) ? wenc14 : wenc16;
+    int n = std::min(nx, ny);
+    int p = 1, p2 = 2;
+    while (p2 <= n) {
+        uint16_t* py = in;
+        uint16_t* ey = in + oy * (ny - p2);
+        int oy1 = oy * p, oy2 = oy * p2, ox1 = ox * p, ox2 = ox * p2;
+        uint16_t i00, i01, i10, i11;
+        for (; py <= ey; py += oy2) {
+            uint16_t* px = py;
+            uint16_t* ex = py + ox * (nx - p2);
+            for (; px <= ex; px += ox2) {
+                uint16_t* p01 = px + ox1;
+                uint16_t* p10 = px + oy1;
+                uint16_t* p11 = p10 + ox1;
+                wenc(*px, *p01, i00, i01);
+                wenc(*p10, *p11, i10, i11);
+                wenc(i00, i10, *px, *p10);
+                wenc(i01, i11, *p01, *p11);
+            }
+            if (nx & p) {
+                uint16_t* p10 = px + oy1;
+                wenc(*px, *p10, i00, *p10);
+                *px = i00;
+            }
+        }
+        if (ny & p) {
+            uint16_t* px = py;
+            uint16_t* ex = py + ox * (nx - p2);
+            for (; px <= ex; px += ox2) {
+                uint16_t* p01 = px + ox1;
+                wenc(*px, *p01, i00, *p01);
+                *px = i00;
+            }
+        }
+        p = p2;
+        p2 <<= 1;
+    }
+}
+
+std::vector<uint8_t> pizCompress(const std::vector<uint8_t>& raw, int width, int lines,
+                                 const std::vector<int>& channelWords) {
+    // Rows of channels to one array per channel
+    std::vector<uint16_t> words(raw.size() / 2);
+    std::vector<size_t> start(channelWords.size());
+    size_t total = 0;
+    for (size_t c = 0; c < channelWords.size(); ++c) {
+        start[c] = total;
+        total += static_cast<size_t>(width) * lines * channelWords[c];
+    }
+    size_t in = 0;
+    for (int y = 0; y < lines; ++y)
+        for (size_t c = 0; c < channelWords.size(); ++c)
+            for (int k = 0; k < width * channelWords[c]; ++k, in += 2)
+                words[start[c] + static_cast<size_t>(y) * width * channelWords[c] + k] =
+                    static_cast<uint16_t>(raw[in] | (raw[in + 1] << 8));
+
+    std::vector<uint8_t> bitmap(EXR_PIZ_BITMAP_SIZE, 0);
+    for (size_t i = 0; i < words.size(); ++i) bitmap[words[i] >> 3] |= static_cast<uint8_t>(1 << (words[i] & 7));
+    bitmap[0] &= ~1;
+    uint32_t minNonZero = EXR_PIZ_BITMAP_SIZE - 1, maxNonZero = 0;
+    for (uint32_t i = 0; i < EXR_PIZ_BITMAP_SIZE; ++i)
+        if (bitmap[i]) {
+            minNonZero = std::min(minNonZero, i);
+            maxNonZero = std::max(maxNonZero, i);
+        }
+    std::vector<uint16_t> lut(65536, 0);
+    uint32_t k = 0;
+    for (uint32_t i = 0; i < 65536; ++i)
+        if (i == 0 || (bitmap[i >> 3] & (1 << (i & 7)))) lut[i] = static_cast<uint16_t>(k++);
+    uint16_t maxValue = static_cast<uint16_t>(k - 1);
+    for (size_t i = 0; i < words.size(); ++i) words[i] = lut[words[i]];
+
+    for (size_t c = 0; c < channelWords.size(); ++c)
+        for (int j = 0; j < channelWords[c]; ++j)
+            wav2Encode(&words[start[c]] + j, width, channelWords[c], lines, width * channelWords[c], maxValue);
+
+    std::vector<uint8_t> out;
+    putLE16(out, minNonZero);
+    putLE16(out, maxNonZero);
+    if (minNonZero <= maxNonZero) out.insert(out.end(), bitmap.begin() + minNonZero, bitmap.begin() + maxNonZero + 1);
+    std::vector<uint8_t> huf = hufCompress(words);
+    putLE32(out, static_cast<uint32_t>(huf.size()));
+    out.insert(out.end(), huf.begin(), huf.end());
+    return out;
+}
+
+//-----------------------------------------------------------------------------
+// File builder
+//-----------------------------------------------------------------------------
+
+struct ExrChannelSpec {
+    std::string name;
+    uint32_t pixelType;
+    std::vector<uint32_t> values; // raw bits (half, float) or value (uint), per pixel
+};
+
+struct ExrSpec {
+    int minX = 0, minY = 0;
+    uint32_t width, height;
+    int displayMinX = 0, displayMinY = 0;
+    uint32_t displayWidth = 0, displayHeight = 0; // 0: same as the data window
+    std::vector<ExrChannelSpec> channels;         // sorted by name
+    uint32_t compression = EXR_COMPRESSION_NONE;
+    bool tiled = false;
+    uint32_t tileWidth = 0, tileHeight = 0;
+    uint8_t levelMode = 0;
+    bool misalign = false; // one padding byte before each chunk
+
+    ExrSpec(uint32_t w, uint32_t h) : width(w), height(h) {}
+
+    void addChannel(const std::string& name, uint32_t pixelType, uint32_t seed) {
+        ExrChannelSpec c;
+        c.name = name;
+        c.pixelType = pixelType;
+        uint32_t state = seed * 2654435761u + 7;
+        for (uint32_t i = 0; i < width * height; ++i) {
+            state = state * 1103515245u + 12345u;
+            uint32_t r = state >> 8;
+            if (pixelType == EXR_PIXEL_HALF)
+                c.values.push_back((i % 7 == 0) ? (r & 0x3FF) : (0x3000 + r % 0x1000)); // denormals, 0.125..1
+            else if (pixelType == EXR_PIXEL_FLOAT)
+                c.values.push_back(floatBits(static_cast<float>(r % 1400) / 1000.0f - 0.2f));
+            else
+                c.values.push_back(r % 3);
+        }
+        // Some flat areas, so the encoders produce runs
+        for (uint32_t i = 0; i < width * height; ++i)
+            if ((i / 5) % 3 == 0) c.values[i] = c.values[i - i % 5];
+        channels.push_back(c);
+    }
+
+    float value(size_t c, uint32_t i) const {
+        uint32_t v = channels[c].values[i];
+        if (channels[c].pixelType == EXR_PIXEL_HALF) return halfToFloat(static_cast<uint16_t>(v));
+        if (channels[c].pixelType == EXR_PIXEL_UINT) return static_cast<float>(v);
+        float f;
+        memcpy(&f, &v, 4);
+        return f;
+    }
+
+    uint32_t linesPerChunk() const {
+        static const uint32_t lines[] = {1, 1, 1, 16, 32};
+        return tiled ? tileHeight : lines[compression];
+    }
+
+    // One chunk in file layout: each row, each channel's samples in turn
+    std::vector<uint8_t> rawChunk(uint32_t x0, uint32_t y0, uint32_t w, uint32_t h) const {
+        std::vector<uint8_t> raw;
+        for (uint32_t y = y0; y < y0 + h; ++y)
+            for (size_t c = 0; c < channels.size(); ++c)
+                for (uint32_t x = x0; x < x0 + w; ++x) {
+                    uint32_t v = channels[c].values[y * width + x];
+                    if (channels[c].pixelType == EXR_PIXEL_HALF)
+                        putLE16(raw, v);
+                    else
+                        putLE32(raw, v);
+                }
+        return raw;
+    }
+
+    std::vector<uint8_t> compress(const std::vector<uint8_t>& raw, uint32_t w, uint32_t h) const {
+        std::vector<uint8_t> packed;
+        switch (compression) {
+        case EXR_COMPRESSION_RLE:
+            packed = rleCompress(raw);
+            break;
+        case EXR_COMPRESSION_ZIPS:
+        case EXR_COMPRESSION_ZIP:
+            packed = zlibStore(splitAndPredict(raw));
+            break;
+        case EXR_COMPRESSION_PIZ: {
+            std::vector<int> words;
+            for (size_t c = 0; c < channels.size(); ++c)
+                words.push_back(channels[c].pixelType == EXR_PIXEL_HALF ? 1 : 2);
+            packed = pizCompress(raw, static_cast<int>(w), static_cast<int>(h), words);
+            break;
+        }
+        default:
+            return raw;
+        }
+        // Writers store chunks that would not shrink as they are
+        return (packed.size() < raw.size()) ? packed : raw;
+    }
+
+    static void attribute(std::vector<uint8_t>& out, const char* name, const char* type,
+                          const std::vector<uint8_t>& value) {
+        out.insert(out.end(), name, name + strlen(name) + 1);
+        out.insert(out.end(), type, type + strlen(type) + 1);
+        putLE32(out, static_cast<uint32_t>(value.size()));
+        out.insert(out.end(), value.begin(), value.end());
+    }
+
+    static std::vector<uint8_t> box(int minX, int minY, uint32_t w, uint32_t h) {
+        std::vector<uint8_t> v;
+        putLE32(v, static_cast<uint32_t>(minX));
+        putLE32(v, static_cast<uint32_t>(minY));
+        putLE32(v, static_cast<uint32_t>(minX + static_cast<int>(w) - 1));
+        putLE32(v, static_cast<uint32_t>(minY + static_cast<int>(h) - 1));
+        return v;
+    }
+
+    std::vector<uint8_t> header() const {
+        std::vector<uint8_t> out;
+        putLE32(out, EXR_MAGIC);
+        putLE32(out, EXR_VERSION | (tiled ? EXR_FLAG_TILED : 0));
+        std::vector<uint8_t> chlist;
+        for (size_t c = 0; c < channels.size(); ++c) {
+            chlist.insert(chlist.end(), channels[c].name.begin(), channels[c].name.end());
+            chlist.push_back(0);
+            putLE32(chlist, channels[c].pixelType);
+            putLE32(chlist, 0);
+            putLE32(chlist, 1);
+            putLE32(chlist, 1);
+        }
+        chlist.push_back(0);
+        attribute(out, "channels", "chlist", chlist);
+        attribute(out, "compression", "compression", std::vector<uint8_t>(1, static_cast<uint8_t>(compression)));
+        attribute(out, "dataWindow", "box2i", box(minX, minY, width, height));
+        attribute(out, "displayWindow", "box2i",
+                  box(displayMinX, displayMinY, displayWidth ? displayWidth : width,
+                      displayHeight ? displayHeight : height));
+        attribute(out, "lineOrder", "lineOrder", std::vector<uint8_t>(1, 0));
+        std::vector<uint8_t> one;
+        putLE32(one, floatBits(1.0f));
+        attribute(out, "pixelAspectRatio", "float", one);
+        attribute(out, "screenWindowCenter", "v2f", std::vector<uint8_t>(8, 0));
+        attribute(out, "screenWindowWidth", "float", one);
+        if (tiled) {
+            std::vector<uint8_t> tiles;
+            putLE32(tiles, tileWidth);
+            putLE32(tiles, tileHeight);
+            tiles.push_back(levelMode);
+            attribute(out, "tiles", "tiledesc", tiles);
+        }
+        out.push_back(0);
+        return out;
+    }
+
+    std::vector<uint8_t> build() const {
+        uint32_t cw = tiled ? tileWidth : width;
+        uint32_t ch = linesPerChunk();
+        uint32_t across = (width + cw - 1) / cw;
+        uint32_t down = (height + ch - 1) / ch;
+        // Later levels of mipmapped files are not read; their offsets stay 0
+        uint32_t extra = levelMode ? 3 : 0;
+
+        std::vector<uint8_t> out = header();
+        size_t table = out.size();
+        out.resize(table + (across * down + extra) * 8, 0);
+        for (uint32_t ty = 0; ty < down; ++ty)
+            for (uint32_t tx = 0; tx < across; ++tx) {
+                uint32_t x0 = tx * cw, y0 = ty * ch;
+                uint32_t w = std::min(cw, width - x0), h = std::min(ch, height - y0);
+                std::vector<uint8_t> data = compress(rawChunk(x0, y0, w, h), w, h);
+                if (misalign) out.push_back(0xCC);
+                uint64_t offset = out.size();
+                for (int b = 0; b < 8; ++b) out[table + (ty * across + tx) * 8 + b] = static_cast<uint8_t>(offset >> (8 * b));
+                if (tiled) {
+                    putLE32(out, tx);
+                    putLE32(out, ty);
+                    putLE32(out, 0);
+                    putLE32(out, 0);
+                } else {
+                    putLE32(out, static_cast<uint32_t>(minY + static_cast<int>(y0)));
+                }
+                putLE32(out, static_cast<uint32_t>(data.size()));
+                out.insert(out.end(), data.begin(), data.end());
+            }
+        return out;
+    }
+
+    // Expected RGBA floats (missing color 0, missing alpha 1; Y when no color)
+    std::vector<float> expectRgba() const {
+        bool hasColor = false;
+        for (size_t c = 0; c < channels.size(); ++c)
+            hasColor |= channels[c].name == "R" || channels[c].name == "G" || channels[c].name == "B";
+        std::vector<float> out;
+        for (uint32_t i = 0; i < width * height; ++i) {
+            float px[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+            for (size_t c = 0; c < channels.size(); ++c) {
+                const std::string& n = channels[c].name;
+                if (n == "R") px[0] = value(c, i);
+                if (n == "G") px[1] = value(c, i);
+                if (n == "B") px[2] = value(c, i);
+                if (n == "A") px[3] = value(c, i);
+                if (n == "Y" && !hasColor) px[0] = px[1] = px[2] = value(c, i);
+            }
+            out.insert(out.end(), px, px + 4);
+        }
+        return out;
+    }
+
+    std::vector<uint8_t> expectBgra() const {
+        std::vector<float> rgba = expectRgba();
+        std::vector<uint8_t> out;
+        for (size_t i = 0; i < rgba.size(); i += 4) {
+            out.push_back(toByte(rgba[i + 2]));
+            out.push_back(toByte(rgba[i + 1]));
+            out.push_back(toByte(rgba[i]));
+            out.push_back(toByte(rgba[i + 3]));
+        }
+        return out;
+    }
+};
+
+ExrSpec makeRgbaHalf(uint32_t w, uint32_t h, uint32_t seed) {
+    ExrSpec spec(w, h);
+    spec.addChannel("A", EXR_PIXEL_HALF, seed);
+    spec.addChannel("B", EXR_PIXEL_HALF, seed + 1);
+    spec.addChannel("G", EXR_PIXEL_HALF, seed + 2);
+    spec.addChannel("R", EXR_PIXEL_HALF, seed + 3);
+    return spec;
+}
+
+struct ExrTestResult {
+    int errorCode;
+    int width;
+    int height;
+    int bitsPerPixel;
+    std::vector<uint8_t> pixels; // tightly packed rows
+    CKDWORD displayWidth;
+    CKDWORD displayHeight;
+    int dataX;
+    int dataY;
+};
+
+ExrTestResult readExr(const std::vector<uint8_t>& data, CKDWORD flags = 0) {
+    ExrTestResult result;
+    ExrReader reader;
+    reader.SetReadFlags(flags);
+    CKBitmapProperties* props = nullptr;
+    result.errorCode = reader.ReadMemory(const_cast<uint8_t*>(data.data()), static_cast<int>(data.size()), &props);
+    result.width = 0;
+    result.height = 0;
+    result.bitsPerPixel = 0;
+    result.displayWidth = 0;
+    result.displayHeight = 0;
+    result.dataX = 0;
+    result.dataY = 0;
+    if (result.errorCode == 0 && props && props->m_Format.Image) {
+        const VxImageDescEx& fmt = props->m_Format;
+        result.width = fmt.Width;
+        result.height = fmt.Height;
+        result.bitsPerPixel = fmt.BitsPerPixel;
+        for (int y = 0; y < fmt.Height; ++y) {
+            const uint8_t* row = fmt.Image + y * fmt.BytesPerLine;
+            result.pixels.insert(result.pixels.end(), row, row + fmt.Width * fmt.BitsPerPixel / 8);
+        }
+        ExrBitmapProperties* ep = reinterpret_cast<ExrBitmapProperties*>(props);
+        result.displayWidth = ep->m_DisplayWidth;
+        result.displayHeight = ep->m_DisplayHeight;
+        result.dataX = ep->m_DataX;
+        result.dataY = ep->m_DataY;
+    }
+    return result;
+}
+
+ExrTestResult readExrFile(const std::string& path, CKDWORD flags = 0) {
+    return readExr(readBinaryFile(path), flags);
+}
+
+// Float output compared bit for bit (NaN included)
+bool sameFloats(const ExrTestResult& r, const std::vector<float>& expected) {
+    return r.pixels.size() == expected.size() * 4 && memcmp(r.pixels.data(), expected.data(), r.pixels.size()) == 0;
+}
+
+std::string exrImagesDir() { return joinPath(g_TestImagesDir, "exr"); }
+
+} // namespace
+
+//=============================================================================
+// Codec Stages
+//=============================================================================
+
+TEST(ExrReader, Half_AllValuesMatchReference) {
+    std::vector<CKWORD> halves(65536 + 3);
+    for (uint32_t i = 0; i < halves.size(); ++i) halves[i] = static_cast<CKWORD>(i);
+    std::vector<float> f(halves.size() + 1, -7.0f);
+    ImageHalfToFloat(halves.data(), f.data(), static_cast<int>(halves.size()));
+    for (uint32_t i = 0; i < halves.size(); ++i) {
+        float expected = halfToFloat(halves[i]);
+        if (std::isnan(expected))
+            ASSERT_TRUE(std::isnan(f[i]));
+        else
+            ASSERT_EQ(floatBits(expected), floatBits(f[i]));
+    }
+    ASSERT_TRUE(f[halves.size()] == -7.0f);
+}
+
+TEST(ExrReader, Wavelet_RoundTrip14And16Bit) {
+    static const int sizes[][2] = {{1, 1}, {1, 9}, {7, 1}, {8, 8}, {13, 6}, {33, 17}};
+    for (int s = 0; s < 6; ++s) {
+        int nx = sizes[s][0], ny = sizes[s][1];
+        for (int wide = 0; wide < 2; ++wide) {
+            uint16_t maxValue = wide ? 60000 : 9000;
+            std::vector<uint16_t> data(nx * ny * 2);
+            for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<uint16_t>((i * 7919 + s) % (maxValue + 1));
+            std::vector<uint16_t> coded = data;
+            // Two interleaved arrays (ox 2), as for float channels
+            wav2Encode(coded.data(), nx, 2, ny, nx * 2, maxValue);
+            wav2Encode(coded.data() + 1, nx, 2, ny, nx * 2, maxValue);
+            std::vector<CKWORD> decoded(coded.begin(), coded.end());
+            EXR_Wav2Decode(decoded.data(), nx, 2, ny, nx * 2, maxValue);
+            EXR_Wav2Decode(decoded.data() + 1, nx, 2, ny, nx * 2, maxValue);
+            ASSERT_TRUE(std::equal(data.begin(), data.end(), decoded.begin()));
+        }
+    }
+}
+
+TEST(ExrReader, Huffman_RoundTrip) {
+    std::vector<uint16_t> data;
+    for (int i = 0; i < 5000; ++i) data.push_back(static_cast<uint16_t>((i % 17 == 0) ? 65535 : (i / 40) % 9));
+    data.insert(data.end(), 600, 3); // runs longer than 255
+    std::vector<uint8_t> coded = hufCompress(data);
+    std::vector<CKWORD> decoded(data.size());
+    ASSERT_TRUE(EXR_HufDecode(coded.data(), static_cast<CKDWORD>(coded.size()), decoded.data(),
+                              static_cast<CKDWORD>(decoded.size())));
+    ASSERT_TRUE(std::equal(data.begin(), data.end(), decoded.begin()));
+
+    // Wrong word count, cut stream
+    ASSERT_FALSE(EXR_HufDecode(coded.data(), static_cast<CKDWORD>(coded.size()), decoded.data(),
+                               static_cast<CKDWORD>(decoded.size() - 1)));
+    ASSERT_FALSE(EXR_HufDecode(coded.data(), 30, decoded.data(), static_cast<CKDWORD>(decoded.size())));
+}
+
+//=============================================================================
+// Chunk Layouts
+//=============================================================================
+
+TEST(ExrReader, Compressions_AllMatch) {
+    for (uint32_t comp = EXR_COMPRESSION_NONE; comp <= EXR_COMPRESSION_PIZ; ++comp) {
+        ExrSpec spec = makeRgbaHalf(37, 45, comp + 1);
+        spec.compression = comp;
+        ExrTestResult r = readExr(spec.build());
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_EQ(37, r.width);
+        ASSERT_EQ(45, r.height);
+        ASSERT_EQ(32, r.bitsPerPixel);
+        ASSERT_TRUE(r.pixels == spec.expectBgra());
+        ASSERT_TRUE(sameFloats(readExr(spec.build(), IMAGE_READ_FLOAT), spec.expectRgba()));
+    }
+}
+
+TEST(ExrReader, PixelTypes_MixedChannels) {
+    for (uint32_t comp = EXR_COMPRESSION_NONE; comp <= EXR_COMPRESSION_PIZ; ++comp) {
+        ExrSpec spec(21, 34);
+        spec.addChannel("A", EXR_PIXEL_UINT, 1);
+        spec.addChannel("B", EXR_PIXEL_FLOAT, 2);
+        spec.addChannel("G", EXR_PIXEL_HALF, 3);
+        spec.addChannel("R", EXR_PIXEL_FLOAT, 4);
+        spec.compression = comp;
+        ExrTestResult r = readExr(spec.build(), IMAGE_READ_FLOAT);
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_EQ(128, r.bitsPerPixel);
+        ASSERT_TRUE(sameFloats(r, spec.expectRgba()));
+    }
+}
+
+TEST(ExrReader, Tiles_PartialEdgeTilesAndMipmaps) {
+    for (uint32_t comp = EXR_COMPRESSION_NONE; comp <= EXR_COMPRESSION_PIZ; ++comp) {
+        ExrSpec spec = makeRgbaHalf(50, 23, 10 + comp);
+        spec.compression = comp;
+        spec.tiled = true;
+        spec.tileWidth = 16;
+        spec.tileHeight = 8;
+        ASSERT_TRUE(readExr(spec.build()).pixels == spec.expectBgra());
+        spec.levelMode = 1; // mipmaps: only the first level is read
+        ASSERT_TRUE(readExr(spec.build()).pixels == spec.expectBgra());
+    }
+}
+
+TEST(ExrReader, Piz_WideValueRangeAndFlatData) {
+    // More than 16384 distinct words selects the 16-bit wavelet
+    ExrSpec spec(160, 40);
+    spec.addChannel("B", EXR_PIXEL_FLOAT, 5);
+    spec.addChannel("G", EXR_PIXEL_FLOAT, 6);
+    spec.addChannel("R", EXR_PIXEL_FLOAT, 7);
+    for (size_t c = 0; c < 3; ++c)
+        for (uint32_t i = 0; i < spec.width * spec.height; ++i)
+            spec.channels[c].values[i] = floatBits(static_cast<float>(i * 3 + c) * 0.37f);
+    spec.compression = EXR_COMPRESSION_PIZ;
+    ASSERT_TRUE(sameFloats(readExr(spec.build(), IMAGE_READ_FLOAT), spec.expectRgba()));
+
+    // All zero: empty bitmap
+    ExrSpec zero = makeRgbaHalf(9, 5, 8);
+    for (size_t c = 0; c < zero.channels.size(); ++c)
+        std::fill(zero.channels[c].values.begin(), zero.channels[c].values.end(), 0u);
+    zero.compression = EXR_COMPRESSION_PIZ;
+    ASSERT_TRUE(sameFloats(readExr(zero.build(), IMAGE_READ_FLOAT), zero.expectRgba()));
+}
+
+TEST(ExrReader, Unaligned_ChunkData) {
+    ExrSpec spec(11, 4);
+    spec.addChannel("B", EXR_PIXEL_HALF, 1);
+    spec.addChannel("G", EXR_PIXEL_FLOAT, 2);
+    spec.addChannel("R", EXR_PIXEL_UINT, 3);
+    spec.misalign = true;
+    ASSERT_TRUE(sameFloats(readExr(spec.build(), IMAGE_READ_FLOAT), spec.expectRgba()));
+}
+
+TEST(ExrReader, ManyChunks_ParallelDecode) {
+    ExrSpec spec = makeRgbaHalf(64, 900, 9);
+    spec.compression = EXR_COMPRESSION_ZIPS;
+    ASSERT_TRUE(readExr(spec.build()).pixels == spec.expectBgra());
+}
+
+//=============================================================================
+// Channels and Windows
+//=============================================================================
+
+TEST(ExrReader, Channels_LuminanceLayersAndMissingAlpha) {
+    // Luminance only: gray
+    ExrSpec gray(6, 5);
+    gray.addChannel("Y", EXR_PIXEL_HALF, 1);
+    ASSERT_TRUE(readExr(gray.build()).pixels == gray.expectBgra());
+
+    // RGB plus layer channels: layers skipped, alpha opaque
+    ExrSpec layered(6, 5);
+    layered.addChannel("B", EXR_PIXEL_HALF, 2);
+    layered.addChannel("G", EXR_PIXEL_HALF, 3);
+    layered.addChannel("R", EXR_PIXEL_HALF, 4);
+    layered.addChannel("Y", EXR_PIXEL_HALF, 5);
+    layered.addChannel("diffuse.R", EXR_PIXEL_FLOAT, 6);
+    layered.compression = EXR_COMPRESSION_ZIP;
+    ExrTestResult r = readExr(layered.build());
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == layered.expectBgra());
+    for (size_t k = 3; k < r.pixels.size(); k += 4) ASSERT_EQ(255, r.pixels[k]);
+}
+
+TEST(ExrReader, DataWindow_PlacedInDisplayWindow) {
+    ExrSpec spec = makeRgbaHalf(10, 7, 11);
+    spec.minX = -3;
+    spec.minY = 40;
+    spec.displayMinX = -5;
+    spec.displayMinY = 2;
+    spec.displayWidth = 100;
+    spec.displayHeight = 80;
+    spec.compression = EXR_COMPRESSION_RLE;
+    ExrTestResult r = readExr(spec.build());
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(10, r.width);
+    ASSERT_EQ(7, r.height);
+    ASSERT_EQ(100u, r.displayWidth);
+    ASSERT_EQ(80u, r.displayHeight);
+    ASSERT_EQ(2, r.dataX);
+    ASSERT_EQ(38, r.dataY);
+    ASSERT_TRUE(r.pixels == spec.expectBgra());
+}
+
+//=============================================================================
+// Reader Tests
+//=============================================================================
+
+TEST(ExrReader, ReaderInfo) {
+    ExrReader reader;
+    CKPluginInfo* info = reader.GetReaderInfo();
+    ASSERT_TRUE(info != nullptr);
+    ASSERT_GUID_EQ(EXRREADER_GUID, info->m_GUID);
+    ASSERT_EQ(0, reader.SaveFile(const_cast<char*>("unused.exr"), nullptr));
+}
+
+//=============================================================================
+// Corpus Tests
+//=============================================================================
+
+TEST(ExrReader, Corpus_ReferenceCrcs) {
+    std::vector<std::string> files = collectFilesWithExtensions(exrImagesDir(), {".exr"});
+    int checked = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        uint32_t crc = 0;
+        if (!getReferenceCrc("exr/" + files[i], crc)) continue;
+        ExrTestResult r = readExrFile(joinPath(exrImagesDir(), files[i]));
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_CRC(crc, r.pixels.data(), r.pixels.size());
+        ++checked;
+    }
+    if (checked == 0) SKIP_TEST("EXR corpus or reference CRCs not found");
+}
+
+TEST(ExrReader, Corpus_CroppedMatchesOriginal) {
+    std::string croppedPath = joinPath(exrImagesDir(), "cropping - data window differs display window.exr");
+    std::string originalPath = joinPath(exrImagesDir(), "cropping - uncropped original.exr");
+    if (!fileExists(croppedPath) || !fileExists(originalPath)) SKIP_TEST("EXR cropping images not found");
+
+    ExrTestResult cropped = readExrFile(croppedPath, IMAGE_READ_FLOAT);
+    ExrTestResult original = readExrFile(originalPath, IMAGE_READ_FLOAT);
+    ASSERT_EQ(0, cropped.errorCode);
+    ASSERT_EQ(0, original.errorCode);
+    ASSERT_EQ(1920, original.width);
+    ASSERT_EQ(315, cropped.width);
+    ASSERT_EQ(100, cropped.height);
+    ASSERT_EQ(1920u, cropped.displayWidth);
+    ASSERT_EQ(1920u, cropped.displayHeight);
+    ASSERT_EQ(1012, cropped.dataX);
+    ASSERT_EQ(1097, cropped.dataY);
+    for (int y = 0; y < cropped.height; ++y) {
+        const uint8_t* a = &cropped.pixels[static_cast<size_t>(y) * cropped.width * 16];
+        const uint8_t* b = &original.pixels[(static_cast<size_t>(y + 1097) * original.width + 1012) * 16];
+        ASSERT_TRUE(memcmp(a, b, cropped.width * 16) == 0);
+    }
+}
+
+TEST(ExrReader, Corpus_GradientMatchesRadianceVersion) {
+    // The same gradient as PIZ-compressed halves and as RGBE: the RGBE
+    // mantissas keep 8 bits below the pixel's largest component, so values
+    // agree to within a 128th of it (plus the half rounding)
+    std::string exrPath = joinPath(exrImagesDir(), "overexposed gradient - data window equals display window.exr");
+    std::string hdrPath = joinPath(exrImagesDir(), "overexposed gradient.hdr");
+    if (!fileExists(exrPath) || !fileExists(hdrPath)) SKIP_TEST("EXR gradient images not found");
+
+    ExrTestResult exr = readExrFile(exrPath, IMAGE_READ_FLOAT);
+    ASSERT_EQ(0, exr.errorCode);
+    HdrReader hdrReader;
+    hdrReader.SetReadFlags(IMAGE_READ_FLOAT);
+    std::vector<uint8_t> hdrData = readBinaryFile(hdrPath);
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(0, hdrReader.ReadMemory(hdrData.data(), static_cast<int>(hdrData.size()), &props));
+    ASSERT_EQ(props->m_Format.Width, exr.width);
+    ASSERT_EQ(props->m_Format.Height, exr.height);
+    const float* a = reinterpret_cast<const float*>(exr.pixels.data());
+    const float* b = reinterpret_cast<const float*>(props->m_Format.Image);
+    for (int i = 0; i < exr.width * exr.height * 4; i += 4) {
+        float largest = std::max(b[i], std::max(b[i + 1], b[i + 2]));
+        for (int c = 0; c < 3; ++c)
+            ASSERT_TRUE(std::fabs(a[i + c] - b[i + c]) <= largest / 128.0f + std::fabs(a[i + c]) / 1024.0f);
+    }
+}
+
+TEST(ExrReader, Truncations_MustNotCrash) {
+    // Every prefix of small files in each compression: errors are fine, crashes are not
+    for (uint32_t comp = EXR_COMPRESSION_NONE; comp <= EXR_COMPRESSION_PIZ; ++comp) {
+        ExrSpec spec = makeRgbaHalf(9, 6, 20 + comp);
+        spec.compression = comp;
+        std::vector<uint8_t> data = spec.build();
+        for (size_t n = 0; n <= data.size(); ++n) {
+            std::vector<uint8_t> prefix(data.begin(), data.begin() + n);
+            ASSERT_TRUE(readExr(prefix).errorCode != 0 || n == data.size());
+        }
+    }
+}
+
+TEST(ExrReader, CorruptChunkData_MustNotCrash) {
+    // Every byte of the chunk data flipped in turn
+    for (uint32_t comp = EXR_COMPRESSION_RLE; comp <= EXR_COMPRESSION_PIZ; ++comp) {
+        ExrSpec spec = makeRgbaHalf(12, 33, 30 + comp);
+        spec.compression = comp;
+        std::vector<uint8_t> data = spec.build();
+        size_t start = spec.header().size();
+        for (size_t k = start; k < data.size(); ++k) {
+            std::vector<uint8_t> bad = data;
+            bad[k] ^= 0x5A;
+            readExr(bad);
+        }
+    }
+}
+
+//=============================================================================
+// Negative Tests
+//=============================================================================
+
+TEST(ExrReader, Negative_BadHeader) {
+    ExrSpec spec = makeRgbaHalf(4, 4, 40);
+    std::vector<uint8_t> good = spec.build();
+    ASSERT_EQ(0, readExr(good).errorCode);
+
+    std::vector<uint8_t> bad = good;
+    bad[0] = 0x77;
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readExr(bad).errorCode);
+    bad = good;
+    bad[4] = 3; // version
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readExr(bad).errorCode);
+    bad = good;
+    bad[5] |= EXR_FLAG_MULTIPART >> 8;
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readExr(bad).errorCode);
+    bad = good;
+    bad[5] |= EXR_FLAG_DEEP >> 8;
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readExr(bad).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readExr(std::vector<uint8_t>(good.begin(), good.begin() + 40)).errorCode);
+
+    spec.compression = 6; // B44
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readExr(spec.header()).errorCode);
+
+    // Channels: nothing to show, subsampled
+    ExrSpec alphaOnly(4, 4);
+    alphaOnly.addChannel("A", EXR_PIXEL_HALF, 1);
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readExr(alphaOnly.build()).errorCode);
+    std::vector<uint8_t> subsampled = good;
+    size_t pos = std::search(subsampled.begin(), subsampled.end(), "chlist", "chlist" + 6) - subsampled.begin();
+    subsampled[pos + 7 + 4 + 2 + 12] = 2; // xSampling of the first channel
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readExr(subsampled).errorCode);
+
+    // Missing data window
+    bad = good;
+    pos = std::search(bad.begin(), bad.end(), "dataWindow", "dataWindow" + 10) - bad.begin();
+    bad[pos] = 'x';
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readExr(bad).errorCode);
+}
+
+TEST(ExrReader, Negative_ChunksOutsideFile) {
+    ExrSpec spec = makeRgbaHalf(8, 6, 41);
+    spec.compression = EXR_COMPRESSION_ZIPS;
+    std::vector<uint8_t> good = spec.build();
+    size_t table = spec.header().size();
+
+    std::vector<uint8_t> bad = good;
+    bad[table + 8 * 3 + 2] = 0x7F; // offset past the end
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readExr(bad).errorCode);
+    bad = good;
+    bad[table] = 0; // offset into the header
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readExr(bad).errorCode);
+
+    // Chunk y out of sequence, data size past the end
+    uint64_t offset = 0;
+    for (int b = 0; b < 8; ++b) offset |= static_cast<uint64_t>(good[table + 8 + b]) << (8 * b);
+    bad = good;
+    bad[offset] ^= 1;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readExr(bad).errorCode);
+    bad = good;
+    bad[offset + 6] = 0x10;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readExr(bad).errorCode);
+
+    // Offset table cut short
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED,
+              readExr(std::vector<uint8_t>(good.begin(), good.begin() + table + 20)).errorCode);
+}
+
+TEST(ExrReader, Negative_HugeDimensionsFailFast) {
+    ExrSpec spec = makeRgbaHalf(2, 2, 42);
+    spec.width = 100000;
+    spec.height = 100000;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readExr(spec.header()).errorCode);
+    spec.width = 100000;
+    spec.height = 2000;
+    std::vector<uint8_t> data = spec.header();
+    data.resize(data.size() + 256, 0);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readExr(data).errorCode); // offset table cannot fit
+}
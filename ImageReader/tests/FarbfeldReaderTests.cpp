@@ -0,0 +1,272 @@
+/**
+ * @file FarbfeldReaderTests.cpp
+ * @brief Farbfeld format tests for CKImageReader
+ *
+ * Tests cover:
+ * - The SIMD 16-bit RGBA kernels against scalar loops
+ * - BGRA32 and BGRA64 output, the alpha property and parallel row conversion
+ * - The corpus in tests/images/farbfeld against CRCs and the PNG originals
+ * - Malformed files (bad magic, truncated payloads, huge dimensions)
+ */
+
+#include "TestFramework.h"
+#include "FarbfeldReader.h"
+#include "PngReader.h"
+#include "ImageSimd.h"
+#include <cstring>
+
+using namespace TestFramework;
+
+//=============================================================================
+// Test Helpers
+//=============================================================================
+
+namespace {
+
+uint32_t g_Seed = 4242;
+
+uint32_t nextRandom() {
+    g_Seed = g_Seed * 1103515245u + 12345u;
+    return g_Seed >> 8;
+}
+
+void putBE32(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v >> 24));
+    out.push_back(static_cast<uint8_t>(v >> 16));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+// RGBA samples, four per pixel, in top-down order
+std::vector<uint16_t> randomSamples(uint32_t pixels, bool opaque) {
+    std::vector<uint16_t> samples(pixels * 4);
+    for (size_t i = 0; i < samples.size(); ++i)
+        samples[i] = (opaque && i % 4 == 3) ? 0xFFFF : static_cast<uint16_t>(nextRandom());
+    return samples;
+}
+
+std::vector<uint8_t> makeFarbfeld(uint32_t width, uint32_t height, const std::vector<uint16_t>& samples) {
+    std::vector<uint8_t> out(FARBFELD_MAGIC, FARBFELD_MAGIC + 8);
+    putBE32(out, width);
+    putBE32(out, height);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        out.push_back(static_cast<uint8_t>(samples[i] >> 8));
+        out.push_back(static_cast<uint8_t>(samples[i]));
+    }
+    return out;
+}
+
+std::vector<uint8_t> expectBgra32(const std::vector<uint16_t>& samples) {
+    std::vector<uint8_t> out;
+    for (size_t i = 0; i < samples.size(); i += 4) {
+        out.push_back(static_cast<uint8_t>(samples[i + 2] >> 8));
+        out.push_back(static_cast<uint8_t>(samples[i + 1] >> 8));
+        out.push_back(static_cast<uint8_t>(samples[i] >> 8));
+        out.push_back(static_cast<uint8_t>(samples[i + 3] >> 8));
+    }
+    return out;
+}
+
+struct FarbfeldTestResult {
+    int errorCode;
+    int width;
+    int height;
+    int bitsPerPixel;
+    std::vector<uint8_t> pixels; // tightly packed rows
+    CKDWORD hasAlpha;
+};
+
+FarbfeldTestResult readFarbfeld(const std::vector<uint8_t>& data, CKDWORD flags = 0) {
+    FarbfeldTestResult result;
+    FarbfeldReader reader;
+    reader.SetReadFlags(flags);
+    CKBitmapProperties* props = nullptr;
+    result.errorCode = reader.ReadMemory(const_cast<uint8_t*>(data.data()), static_cast<int>(data.size()), &props);
+    result.width = 0;
+    result.height = 0;
+    result.bitsPerPixel = 0;
+    result.hasAlpha = 0;
+    if (result.errorCode == 0 && props && props->m_Format.Image) {
+        const VxImageDescEx& fmt = props->m_Format;
+        result.width = fmt.Width;
+        result.height = fmt.Height;
+        result.bitsPerPixel = fmt.BitsPerPixel;
+        for (int y = 0; y < fmt.Height; ++y) {
+            const uint8_t* row = fmt.Image + y * fmt.BytesPerLine;
+            result.pixels.insert(result.pixels.end(), row, row + fmt.Width * fmt.BitsPerPixel / 8);
+        }
+        result.hasAlpha = reinterpret_cast<FarbfeldBitmapProperties*>(props)->m_HasAlpha;
+    }
+    return result;
+}
+
+std::string farbfeldImagesDir() { return joinPath(joinPath(g_TestImagesDir, "farbfeld"), "transparency"); }
+
+} // namespace
+
+//=============================================================================
+// SIMD Kernels
+//=============================================================================
+
+TEST(FarbfeldReader, Kernels_MatchScalar) {
+    for (int count = 0; count < 40; ++count) {
+        std::vector<uint16_t> samples = randomSamples(count, false);
+        std::vector<uint8_t> src = makeFarbfeld(count, 1, samples);
+        src.erase(src.begin(), src.begin() + FARBFELD_HEADER_SIZE);
+
+        std::vector<CKBYTE> dst(count * 4 + 1, 0xEE);
+        ImageRGBA16ToBGRA32(src.data(), dst.data(), count);
+        std::vector<uint8_t> expected = expectBgra32(samples);
+        // expected is empty for count 0, and its data() may be null
+        if (count > 0)
+            ASSERT_TRUE(memcmp(dst.data(), expected.data(), expected.size()) == 0);
+        ASSERT_EQ(0xEE, dst[count * 4]);
+
+        std::vector<CKWORD> wide(count * 4 + 1, 0xEEEE);
+        ImageRGBA16ToBGRA64(src.data(), wide.data(), count);
+        for (int i = 0; i < count; ++i) {
+            ASSERT_EQ(samples[i * 4 + 2], wide[i * 4]);
+            ASSERT_EQ(samples[i * 4 + 1], wide[i * 4 + 1]);
+            ASSERT_EQ(samples[i * 4], wide[i * 4 + 2]);
+            ASSERT_EQ(samples[i * 4 + 3], wide[i * 4 + 3]);
+        }
+        ASSERT_EQ(0xEEEE, wide[count * 4]);
+    }
+}
+
+//=============================================================================
+// Decoding
+//=============================================================================
+
+TEST(FarbfeldReader, Bgra32_KeepsHighBytes) {
+    std::vector<uint16_t> samples = randomSamples(13 * 7, false);
+    FarbfeldTestResult r = readFarbfeld(makeFarbfeld(13, 7, samples));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(13, r.width);
+    ASSERT_EQ(7, r.height);
+    ASSERT_EQ(32, r.bitsPerPixel);
+    ASSERT_TRUE(r.pixels == expectBgra32(samples));
+}
+
+TEST(FarbfeldReader, Keep16Bit_Bgra64) {
+    std::vector<uint16_t> samples = randomSamples(9 * 5, false);
+    FarbfeldTestResult r = readFarbfeld(makeFarbfeld(9, 5, samples), IMAGE_READ_KEEP_16BIT);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(64, r.bitsPerPixel);
+    const uint16_t* p = reinterpret_cast<const uint16_t*>(r.pixels.data());
+    for (size_t i = 0; i < samples.size(); i += 4) {
+        ASSERT_EQ(samples[i + 2], p[i]);
+        ASSERT_EQ(samples[i + 1], p[i + 1]);
+        ASSERT_EQ(samples[i], p[i + 2]);
+        ASSERT_EQ(samples[i + 3], p[i + 3]);
+    }
+}
+
+TEST(FarbfeldReader, HasAlpha) {
+    std::vector<uint16_t> samples = randomSamples(31 * 40, true);
+    ASSERT_EQ(0u, readFarbfeld(makeFarbfeld(31, 40, samples)).hasAlpha);
+    ASSERT_EQ(0u, readFarbfeld(makeFarbfeld(31, 40, samples), IMAGE_READ_KEEP_16BIT).hasAlpha);
+
+    // One pixel on the last row, just below opaque: visible only in BGRA64
+    samples[(31 * 39 + 30) * 4 + 3] = 0xFFFE;
+    ASSERT_EQ(0u, readFarbfeld(makeFarbfeld(31, 40, samples)).hasAlpha);
+    ASSERT_EQ(1u, readFarbfeld(makeFarbfeld(31, 40, samples), IMAGE_READ_KEEP_16BIT).hasAlpha);
+    samples[3] = 0x1234;
+    ASSERT_EQ(1u, readFarbfeld(makeFarbfeld(31, 40, samples)).hasAlpha);
+}
+
+TEST(FarbfeldReader, ManyRows_ParallelConvert) {
+    std::vector<uint16_t> samples = randomSamples(301 * 555, false);
+    FarbfeldTestResult r = readFarbfeld(makeFarbfeld(301, 555, samples));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == expectBgra32(samples));
+}
+
+TEST(FarbfeldReader, ReaderInfo) {
+    FarbfeldReader reader;
+    CKPluginInfo* info = reader.GetReaderInfo();
+    ASSERT_TRUE(info != nullptr);
+    ASSERT_GUID_EQ(FARBFELDREADER_GUID, info->m_GUID);
+    ASSERT_EQ(0, reader.SaveFile(const_cast<char*>("unused.ff"), nullptr));
+}
+
+//=============================================================================
+// Corpus Tests
+//=============================================================================
+
+TEST(FarbfeldReader, Corpus_ReferenceCrcs) {
+    std::vector<std::string> files = collectFilesWithExtensions(farbfeldImagesDir(), {".ff"});
+    int checked = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        uint32_t crc = 0;
+        if (!getReferenceCrc("farbfeld/transparency/" + files[i], crc)) continue;
+        FarbfeldTestResult r = readFarbfeld(readBinaryFile(joinPath(farbfeldImagesDir(), files[i])));
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_CRC(crc, r.pixels.data(), r.pixels.size());
+        ++checked;
+    }
+    if (checked == 0) SKIP_TEST("Farbfeld corpus or reference CRCs not found");
+}
+
+TEST(FarbfeldReader, Corpus_MatchesPngOriginals) {
+    // Most samples are PngSuite images converted to farbfeld: the high bytes
+    // are the PNG samples
+    std::string pngDir = joinPath(joinPath(g_TestImagesDir, "png"), "transparency");
+    std::vector<std::string> files = collectFilesWithExtensions(farbfeldImagesDir(), {".ff"});
+    int compared = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        std::string pngPath = joinPath(pngDir, files[i].substr(0, files[i].size() - 3) + ".png");
+        if (!fileExists(pngPath)) continue;
+        FarbfeldTestResult image = readFarbfeld(readBinaryFile(joinPath(farbfeldImagesDir(), files[i])));
+        ASSERT_EQ(0, image.errorCode);
+        CKBitmapProperties refProps;
+        ASSERT_EQ(0, PNG_Read(const_cast<char*>(pngPath.c_str()), 0, &refProps));
+        const VxImageDescEx& ref = refProps.m_Format;
+        ASSERT_EQ(ref.Width, image.width);
+        ASSERT_EQ(ref.Height, image.height);
+        for (int y = 0; y < ref.Height; ++y)
+            ASSERT_TRUE(memcmp(ref.Image + y * ref.BytesPerLine, &image.pixels[y * image.width * 4],
+                               image.width * 4) == 0);
+        delete[] static_cast<CKBYTE*>(refProps.m_Data);
+        ++compared;
+    }
+    if (compared == 0) SKIP_TEST("Farbfeld corpus or PNG originals not found");
+}
+
+TEST(FarbfeldReader, Truncations_FailFast) {
+    std::vector<uint8_t> data = makeFarbfeld(5, 3, randomSamples(15, false));
+    ASSERT_EQ(0, readFarbfeld(data).errorCode);
+    for (size_t n = 1; n < data.size(); ++n) {
+        std::vector<uint8_t> prefix(data.begin(), data.begin() + n);
+        ASSERT_EQ(CKBITMAPERROR_READERROR, readFarbfeld(prefix).errorCode);
+    }
+    // Trailing bytes are ignored
+    data.resize(data.size() + 5, 0xAB);
+    ASSERT_EQ(0, readFarbfeld(data).errorCode);
+}
+
+//=============================================================================
+// Negative Tests
+//=============================================================================
+
+TEST(FarbfeldReader, Negative_BadHeader) {
+    std::vector<uint8_t> data = makeFarbfeld(2, 2, randomSamples(4, false));
+    std::vector<uint8_t> bad = data;
+    bad[0] = 'F';
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readFarbfeld(bad).errorCode);
+
+    bad = data;
+    bad[11] = 0; // width 0
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readFarbfeld(bad).errorCode);
+    bad = data;
+    bad[15] = 0; // height 0
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readFarbfeld(bad).errorCode);
+}
+
+TEST(FarbfeldReader, Negative_HugeDimensionsFailFast) {
+    // Beyond the pixel limit, then within it but far beyond the file
+    std::vector<uint8_t> data = makeFarbfeld(0x10000, 0x10000, std::vector<uint16_t>(64));
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readFarbfeld(data).errorCode);
+    data = makeFarbfeld(10000, 10000, std::vector<uint16_t>(64));
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readFarbfeld(data).errorCode);
+}
@@ -0,0 +1,469 @@
+/**
+ * @file GifMovieReaderTests.cpp
+ * @brief Animated GIF movie tests for CKImageReader
+ *
+ * Tests cover:
+ * - The frame index (regions, delays, disposal, loop count, truncated files)
+ * - Disposal and transparency on the persistent canvas against a from-scratch model
+ * - Seeking backwards and forwards, and prefetched sequential playback
+ * - The animations in tests/images/gif/anim, sequential against random access
+ * - Malformed animations and the movie reader API
+ */
+
+#include "TestFramework.h"
+#include "GifMovieReader.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace TestFramework;
+
+//=============================================================================
+// Test Helpers
+//=============================================================================
+
+namespace {
+
+void putLE16(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+// 8-bit LZW data made of literal codes only, with a clear code before the
+// code width would grow; every decoder must accept it
+std::vector<uint8_t> lzwLiterals(const std::vector<uint8_t>& indices) {
+    std::vector<uint8_t> out;
+    uint32_t bits = 0;
+    int count = 0;
+    for (size_t i = 0; i <= indices.size(); ++i) {
+        int code = (i == indices.size()) ? 257 : indices[i];
+        int codes = (i % 254 == 0) ? 2 : 1;
+        for (int k = 0; k < codes; ++k) {
+            bits |= static_cast<uint32_t>((codes == 2 && k == 0) ? 256 : code) << count;
+            count += 9;
+            while (count >= 8) {
+                out.push_back(static_cast<uint8_t>(bits));
+                bits >>= 8;
+                count -= 8;
+            }
+        }
+    }
+    if (count > 0) out.push_back(static_cast<uint8_t>(bits));
+    return out;
+}
+
+struct FrameSpec {
+    uint32_t x, y, width, height;
+    uint32_t delay; // in 1/100 s
+    uint8_t disposal;
+    int transparent;
+    std::vector<uint8_t> indices;
+
+    FrameSpec(uint32_t fx, uint32_t fy, uint32_t w, uint32_t h, uint8_t d)
+        : x(fx), y(fy), width(w), height(h), delay(10), disposal(d), transparent(-1), indices(w * h, 0) {}
+
+    void fill(uint8_t index) { std::fill(indices.begin(), indices.end(), index); }
+};
+
+struct GifSpec {
+    uint32_t width, height;
+    int loops; // NETSCAPE repeat count, -1 for none
+    std::vector<FrameSpec> frames;
+
+    GifSpec(uint32_t w, uint32_t h) : width(w), height(h), loops(-1) {}
+};
+
+// Global palette of 256 entries: index i is (i * 3, i * 5, 255 - i)
+void paletteRGB(int i, uint8_t* rgb) {
+    rgb[0] = static_cast<uint8_t>(i * 3);
+    rgb[1] = static_cast<uint8_t>(i * 5);
+    rgb[2] = static_cast<uint8_t>(255 - i);
+}
+
+std::vector<uint8_t> makeGif(const GifSpec& spec) {
+    std::vector<uint8_t> gif;
+    const char* signature = "GIF89a";
+    gif.insert(gif.end(), signature, signature + 6);
+    putLE16(gif, spec.width);
+    putLE16(gif, spec.height);
+    gif.push_back(GIF_FLAG_COLOR_TABLE | 7);
+    gif.push_back(0);
+    gif.push_back(0);
+    for (int i = 0; i < 256; ++i) {
+        uint8_t rgb[3];
+        paletteRGB(i, rgb);
+        gif.insert(gif.end(), rgb, rgb + 3);
+    }
+
+    if (spec.loops >= 0) {
+        gif.push_back(GIF_BLOCK_EXTENSION);
+        gif.push_back(GIF_EXT_APPLICATION);
+        gif.push_back(11);
+        const char* id = "NETSCAPE2.0";
+        gif.insert(gif.end(), id, id + 11);
+        gif.push_back(3);
+        gif.push_back(1);
+        putLE16(gif, static_cast<uint32_t>(spec.loops));
+        gif.push_back(0);
+    }
+
+    for (size_t i = 0; i < spec.frames.size(); ++i) {
+        const FrameSpec& f = spec.frames[i];
+        gif.push_back(GIF_BLOCK_EXTENSION);
+        gif.push_back(GIF_EXT_GRAPHIC_CONTROL);
+        gif.push_back(GIF_GCE_SIZE);
+        gif.push_back(static_cast<uint8_t>((f.disposal << 2) | (f.transparent >= 0 ? 1 : 0)));
+        putLE16(gif, f.delay);
+        gif.push_back(static_cast<uint8_t>(f.transparent >= 0 ? f.transparent : 0));
+        gif.push_back(0);
+
+        gif.push_back(GIF_BLOCK_IMAGE);
+        putLE16(gif, f.x);
+        putLE16(gif, f.y);
+        putLE16(gif, f.width);
+        putLE16(gif, f.height);
+        gif.push_back(0);
+        gif.push_back(8);
+        std::vector<uint8_t> data = lzwLiterals(f.indices);
+        for (size_t pos = 0; pos < data.size(); pos += 255) {
+            size_t n = std::min<size_t>(255, data.size() - pos);
+            gif.push_back(static_cast<uint8_t>(n));
+            gif.insert(gif.end(), data.begin() + pos, data.begin() + pos + n);
+        }
+        gif.push_back(0);
+    }
+    gif.push_back(GIF_BLOCK_TRAILER);
+    return gif;
+}
+
+// Straightforward model of the GIF rules: replays frames 0..f on a fresh canvas
+std::vector<uint8_t> modelCanvas(const GifSpec& spec, size_t f) {
+    std::vector<uint8_t> canvas(spec.width * spec.height * 4, 0);
+    std::vector<uint8_t> before;
+    for (size_t i = 0; i <= f; ++i) {
+        const FrameSpec& fr = spec.frames[i];
+        before = canvas;
+        for (uint32_t y = 0; y < fr.height && fr.y + y < spec.height; ++y) {
+            for (uint32_t x = 0; x < fr.width && fr.x + x < spec.width; ++x) {
+                int index = fr.indices[y * fr.width + x];
+                if (index == fr.transparent) continue;
+                uint8_t rgb[3];
+                paletteRGB(index, rgb);
+                uint8_t* d = &canvas[((fr.y + y) * spec.width + fr.x + x) * 4];
+                d[0] = rgb[2];
+                d[1] = rgb[1];
+                d[2] = rgb[0];
+                d[3] = 255;
+            }
+        }
+        if (i == f) break;
+
+        uint8_t dispose = fr.disposal;
+        if (i == 0 && dispose == GIF_DISPOSE_PREVIOUS) dispose = GIF_DISPOSE_BACKGROUND;
+        for (uint32_t y = 0; y < fr.height && fr.y + y < spec.height; ++y) {
+            if (fr.x >= spec.width) break;
+            size_t row = ((fr.y + y) * spec.width + fr.x) * 4;
+            size_t bytes = std::min(fr.width, spec.width - fr.x) * 4;
+            if (dispose == GIF_DISPOSE_BACKGROUND)
+                std::fill(canvas.begin() + row, canvas.begin() + row + bytes, 0);
+            else if (dispose == GIF_DISPOSE_PREVIOUS)
+                std::copy(before.begin() + row, before.begin() + row + bytes, canvas.begin() + row);
+        }
+    }
+    return canvas;
+}
+
+std::string writeTemp(const std::string& name, const std::vector<uint8_t>& data) {
+    std::string path = joinPath(g_TestOutputDir, name);
+    writeBinaryFile(path, data.data(), data.size());
+    return path;
+}
+
+std::vector<uint8_t> readCanvas(GifMovieReader& reader, int f, int* error = nullptr) {
+    CKMovieProperties* mp = nullptr;
+    int result = reader.ReadFrame(f, &mp);
+    if (error) *error = result;
+    if (result != CK_OK || !mp) return std::vector<uint8_t>();
+    const VxImageDescEx& fmt = mp->m_Format;
+    const uint8_t* pixels = static_cast<const uint8_t*>(mp->m_Data);
+    return std::vector<uint8_t>(pixels, pixels + fmt.BytesPerLine * fmt.Height);
+}
+
+// Patterned squares over a partly transparent background, with every
+// disposal method and a frame reaching past the screen
+GifSpec makeTestAnimation() {
+    GifSpec spec(16, 12);
+    FrameSpec bg(0, 0, 16, 12, GIF_DISPOSE_NONE);
+    for (size_t i = 0; i < bg.indices.size(); ++i) bg.indices[i] = static_cast<uint8_t>(i % 7);
+    bg.transparent = 0;
+    spec.frames.push_back(bg);
+
+    FrameSpec a(2, 3, 5, 4, GIF_DISPOSE_PREVIOUS);
+    a.fill(200);
+    a.indices[0] = 1; // one transparent pixel keeps the background
+    a.transparent = 1;
+    spec.frames.push_back(a);
+
+    FrameSpec b(8, 4, 6, 6, GIF_DISPOSE_BACKGROUND);
+    b.fill(100);
+    spec.frames.push_back(b);
+
+    FrameSpec c(10, 6, 4, 4, 0); // unspecified disposal: left in place
+    for (size_t i = 0; i < c.indices.size(); ++i) c.indices[i] = static_cast<uint8_t>(50 + i % 2);
+    c.transparent = 51;
+    spec.frames.push_back(c);
+
+    // Opaque full-screen replacement: later frames can be drawn without
+    // replaying the earlier ones
+    FrameSpec d(0, 0, 16, 12, GIF_DISPOSE_NONE);
+    for (size_t i = 0; i < d.indices.size(); ++i) d.indices[i] = static_cast<uint8_t>(30 + i % 11);
+    spec.frames.push_back(d);
+
+    FrameSpec e(0, 0, 3, 3, GIF_DISPOSE_BACKGROUND);
+    e.fill(250);
+    spec.frames.push_back(e);
+
+    FrameSpec f(14, 10, 4, 4, GIF_DISPOSE_PREVIOUS); // clipped to 2 x 2
+    f.fill(7);
+    spec.frames.push_back(f);
+
+    FrameSpec g(1, 1, 2, 2, 5); // undefined disposal: left in place
+    g.fill(9);
+    spec.frames.push_back(g);
+    return spec;
+}
+
+} // anonymous namespace
+
+//=============================================================================
+// Index Tests
+//=============================================================================
+
+TEST(GifMovieReader, Index_FramesAndTiming) {
+    GifSpec spec = makeTestAnimation();
+    spec.loops = 4;
+    spec.frames[1].delay = 3;
+    spec.frames[2].delay = 0;
+    std::vector<uint8_t> gif = makeGif(spec);
+
+    GifAnimation anim;
+    ASSERT_EQ(0, GIF_Index(gif.data(), static_cast<CKDWORD>(gif.size()), anim));
+    ASSERT_EQ(8u, anim.frameCount);
+    ASSERT_EQ(5u, anim.numPlays);
+    ASSERT_EQ(16u, anim.width);
+    ASSERT_EQ(12u, anim.height);
+    ASSERT_EQ(192u, anim.maxFramePixels);
+
+    ASSERT_EQ(100u, anim.frames[0].delay);
+    ASSERT_EQ(30u, anim.frames[1].delay);
+    ASSERT_EQ(0u, anim.frames[2].delay);
+    ASSERT_EQ(130u, anim.frames[3].startTime);
+    ASSERT_EQ(130u + 5 * 100u, anim.length);
+
+    ASSERT_EQ(static_cast<CKDWORD>(GIF_DISPOSE_PREVIOUS), anim.frames[1].disposal);
+    ASSERT_EQ(static_cast<CKDWORD>(GIF_DISPOSE_NONE), anim.frames[3].disposal);
+    ASSERT_EQ(static_cast<CKDWORD>(GIF_DISPOSE_NONE), anim.frames[7].disposal);
+    ASSERT_EQ(1, anim.frames[1].transparent);
+    ASSERT_EQ(-1, anim.frames[2].transparent);
+    ASSERT_EQ(2u, anim.frames[6].drawWidth);
+    ASSERT_EQ(2u, anim.frames[6].drawHeight);
+
+    std::vector<uint8_t> indices(anim.maxFramePixels);
+    CKDWORD decoded = 0;
+    ASSERT_EQ(0, GIF_DecodeFrame(anim, 3, indices.data(), decoded));
+    ASSERT_EQ(16u, decoded);
+    ASSERT_TRUE(std::equal(spec.frames[3].indices.begin(), spec.frames[3].indices.end(), indices.begin()));
+    GIF_FreeIndex(anim);
+}
+
+TEST(GifMovieReader, Index_TruncatedAnimationKeepsFrames) {
+    GifSpec spec = makeTestAnimation();
+    std::vector<uint8_t> gif = makeGif(spec);
+
+    // Cut inside the data of the last frame: it stays, partly drawn
+    gif.resize(gif.size() - 4);
+    GifAnimation anim;
+    ASSERT_EQ(0, GIF_Index(gif.data(), static_cast<CKDWORD>(gif.size()), anim));
+    ASSERT_EQ(8u, anim.frameCount);
+    GIF_FreeIndex(anim);
+
+    // Cut inside the descriptor of the last frame: it goes
+    gif.resize(gif.size() - 8);
+    ASSERT_EQ(0, GIF_Index(gif.data(), static_cast<CKDWORD>(gif.size()), anim));
+    ASSERT_EQ(7u, anim.frameCount);
+    GIF_FreeIndex(anim);
+
+    GifMovieReader reader;
+    ASSERT_EQ(CK_OK, reader.OpenFile(const_cast<char*>(writeTemp("gif_truncated.gif", gif).c_str())));
+    ASSERT_EQ(7, reader.GetMovieFrameCount());
+    ASSERT_TRUE(readCanvas(reader, 6) == modelCanvas(spec, 6));
+}
+
+//=============================================================================
+// Compositing Tests
+//=============================================================================
+
+TEST(GifMovieReader, Compose_SequentialMatchesModel) {
+    GifSpec spec = makeTestAnimation();
+    spec.loops = 0;
+    GifMovieReader reader;
+    ASSERT_EQ(CK_OK, reader.OpenFile(const_cast<char*>(writeTemp("gif_compose.gif", makeGif(spec)).c_str())));
+    ASSERT_EQ(8, reader.GetMovieFrameCount());
+    ASSERT_EQ(800, reader.GetMovieLength());
+
+    for (int f = 0; f < 8; ++f) {
+        CKMovieProperties* mp = nullptr;
+        ASSERT_EQ(CK_OK, reader.ReadFrame(f, &mp));
+        ASSERT_EQ(16, mp->m_Format.Width);
+        ASSERT_EQ(12, mp->m_Format.Height);
+        ASSERT_EQ(32, mp->m_Format.BitsPerPixel);
+        ASSERT_EQ(100u, reinterpret_cast<GifMovieProperties*>(mp)->m_FrameDelay);
+        ASSERT_EQ(0u, reinterpret_cast<GifMovieProperties*>(mp)->m_NumPlays);
+        ASSERT_TRUE(readCanvas(reader, f) == modelCanvas(spec, f));
+    }
+}
+
+TEST(GifMovieReader, Compose_SeekingMatchesModel) {
+    GifSpec spec = makeTestAnimation();
+    GifMovieReader reader;
+    ASSERT_EQ(CK_OK, reader.OpenFile(const_cast<char*>(writeTemp("gif_seek.gif", makeGif(spec)).c_str())));
+
+    static const int order[] = {3, 1, 7, 5, 2, 2, 0, 4, 6, 3, 0, 1, 2, 3, 4, 5, 6, 7, 0, 7, 6};
+    for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); ++i) {
+        ASSERT_TRUE(readCanvas(reader, order[i]) == modelCanvas(spec, order[i]));
+    }
+}
+
+TEST(GifMovieReader, Compose_LoopedPlayback) {
+    // The frame after the last one is the first; the prefetched frame must not
+    // be drawn over the old canvas
+    GifSpec spec = makeTestAnimation();
+    GifMovieReader reader;
+    ASSERT_EQ(CK_OK, reader.OpenFile(const_cast<char*>(writeTemp("gif_loop.gif", makeGif(spec)).c_str())));
+    for (int loop = 0; loop < 3; ++loop) {
+        for (int f = 0; f < 8; ++f) {
+            ASSERT_TRUE(readCanvas(reader, f) == modelCanvas(spec, f));
+        }
+    }
+}
+
+TEST(GifMovieReader, Compose_FirstFrameDisposedToPrevious) {
+    // Restoring the first frame restores the empty canvas
+    GifSpec spec(6, 6);
+    FrameSpec first(1, 1, 4, 4, GIF_DISPOSE_PREVIOUS);
+    first.fill(20);
+    spec.frames.push_back(first);
+    FrameSpec second(0, 0, 2, 2, GIF_DISPOSE_NONE);
+    second.fill(40);
+    spec.frames.push_back(second);
+
+    GifMovieReader reader;
+    ASSERT_EQ(CK_OK, reader.OpenFile(const_cast<char*>(writeTemp("gif_first_prev.gif", makeGif(spec)).c_str())));
+    std::vector<uint8_t> canvas = readCanvas(reader, 1);
+    ASSERT_TRUE(canvas == modelCanvas(spec, 1));
+    ASSERT_EQ(0, canvas[(3 * 6 + 3) * 4 + 3]);
+}
+
+//=============================================================================
+// Corpus Tests
+//=============================================================================
+
+TEST(GifMovieReader, Corpus_SeekingMatchesSequential) {
+    std::string animDir = joinPath(joinPath(g_TestImagesDir, "gif"), "anim");
+    std::vector<std::string> files = listDirectory(animDir);
+    int checked = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (toLower(getExtension(files[i])) != ".gif") continue;
+        std::string path = joinPath(animDir, files[i]);
+
+        GifMovieReader reader;
+        ASSERT_EQ(CK_OK, reader.OpenFile(const_cast<char*>(path.c_str())));
+        int count = reader.GetMovieFrameCount();
+        ASSERT_TRUE(count > 0);
+        std::vector<std::vector<uint8_t> > frames;
+        for (int f = 0; f < count; ++f) {
+            frames.push_back(readCanvas(reader, f));
+            ASSERT_FALSE(frames.back().empty());
+        }
+
+        // The first frame is what the bitmap reader returns
+        CKBitmapProperties props;
+        props.m_Size = sizeof(CKBitmapProperties);
+        ASSERT_EQ(0, GIF_Read(const_cast<char*>(path.c_str()), 0, &props));
+        ASSERT_TRUE(memcmp(props.m_Format.Image, frames[0].data(), frames[0].size()) == 0);
+        delete[] static_cast<CKBYTE*>(props.m_Data);
+
+        GifMovieReader fresh;
+        ASSERT_EQ(CK_OK, fresh.OpenFile(const_cast<char*>(path.c_str())));
+        for (int f = count - 1; f >= 0; --f) {
+            ASSERT_TRUE(readCanvas(fresh, f) == frames[f]);
+        }
+        ++checked;
+    }
+    if (checked == 0) SKIP_TEST("GIF animations not found");
+}
+
+//=============================================================================
+// Negative Tests
+//=============================================================================
+
+TEST(GifMovieReader, Negative_CorruptFrameData) {
+    GifSpec spec = makeTestAnimation();
+    std::vector<uint8_t> gif = makeGif(spec);
+    // Make the first code of frame 2 invalid (511 after the clear code)
+    GifAnimation anim;
+    ASSERT_EQ(0, GIF_Index(gif.data(), static_cast<CKDWORD>(gif.size()), anim));
+    size_t data = anim.frames[2].dataOffset + 1;
+    GIF_FreeIndex(anim);
+    gif[data + 1] |= 0xFE;
+    gif[data + 2] |= 0x03;
+
+    GifMovieReader reader;
+    ASSERT_EQ(CK_OK, reader.OpenFile(const_cast<char*>(writeTemp("gif_corrupt.gif", gif).c_str())));
+    ASSERT_TRUE(readCanvas(reader, 1) == modelCanvas(spec, 1));
+    int error = 0;
+    readCanvas(reader, 2, &error);
+    ASSERT_EQ(CKMOVIEERROR_FILECORRUPTED, error);
+
+    // Frames that do not depend on the broken one still read
+    ASSERT_TRUE(readCanvas(reader, 4) == modelCanvas(spec, 4));
+    ASSERT_TRUE(readCanvas(reader, 5) == modelCanvas(spec, 5));
+}
+
+TEST(GifMovieReader, Negative_OpenFile) {
+    GifMovieReader reader;
+    ASSERT_EQ(CKMOVIEERROR_READERROR, reader.OpenFile(const_cast<char*>("does_not_exist.gif")));
+    std::vector<uint8_t> text(64, 'x');
+    ASSERT_EQ(CKMOVIEERROR_UNSUPPORTEDFILE, reader.OpenFile(const_cast<char*>(writeTemp("gif_text.gif", text).c_str())));
+    ASSERT_EQ(0, reader.GetMovieFrameCount());
+
+    // A header without frames
+    std::vector<uint8_t> empty = makeGif(GifSpec(4, 4));
+    ASSERT_EQ(CKMOVIEERROR_FILECORRUPTED, reader.OpenFile(const_cast<char*>(writeTemp("gif_empty.gif", empty).c_str())));
+
+    CKMovieProperties* mp = nullptr;
+    ASSERT_EQ(CKMOVIEERROR_GENERIC, reader.ReadFrame(0, &mp));
+}
+
+//=============================================================================
+// API Tests
+//=============================================================================
+
+TEST(GifMovieReader, GetReaderInfo) {
+    GifMovieReader reader;
+    CKPluginInfo* info = reader.GetReaderInfo();
+    ASSERT_TRUE(info != nullptr);
+    ASSERT_GUID_EQ(GIFMOVIEREADER_GUID, info->m_GUID);
+    ASSERT_EQ(static_cast<int>(CKPLUGIN_MOVIE_READER), static_cast<int>(info->m_Type));
+}
+
+TEST(GifMovieReader, ReopenWhilePrefetching) {
+    GifSpec spec = makeTestAnimation();
+    std::string path = writeTemp("gif_reopen.gif", makeGif(spec));
+    GifMovieReader reader;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(CK_OK, reader.OpenFile(const_cast<char*>(path.c_str())));
+        ASSERT_TRUE(readCanvas(reader, i) == modelCanvas(spec, i));
+    }
+    CKMovieProperties* mp = nullptr;
+    ASSERT_EQ(CKMOVIEERROR_GENERIC, reader.ReadFrame(8, &mp));
+}
@@ -0,0 +1,644 @@
+/**
+ * @file GifReaderTests.cpp
+ * @brief GIF format tests for CKImageReader
+ *
+ * Tests cover:
+ * - LZW round trips at every minimum code size, with and without clear codes
+ *   once the table is full, and the code-not-yet-in-table case
+ * - Global and local color tables, transparency and interlacing
+ * - Index output (IMAGE_READ_KEEP_INDICES) and frames clipped to the screen
+ * - The corpus in tests/images/gif against CRCs and the image-rs reference images
+ * - Malformed files (bad signature, bad descriptor, truncated data)
+ */
+
+#include "TestFramework.h"
+#include "GifReader.h"
+#include "PngReader.h"
+#include "ImageLzw.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+using namespace TestFramework;
+
+//=============================================================================
+// Test Helpers
+//=============================================================================
+
+namespace {
+
+void putLE16(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+// Plain GIF LZW encoder: a map from (prefix code, byte) to code. With
+// clearWhenFull a clear code is sent once all 4096 codes are taken, otherwise
+// the table stays frozen (a "deferred clear").
+std::vector<uint8_t> lzwEncode(const std::vector<uint8_t>& data, int minCodeSize, bool clearWhenFull = true) {
+    std::vector<uint8_t> out;
+    uint32_t bits = 0;
+    int count = 0;
+    const int clearCode = 1 << minCodeSize;
+    int width = minCodeSize + 1;
+    int next = clearCode + 2;
+    std::map<std::pair<int, int>, int> table;
+
+    struct Emit {
+        std::vector<uint8_t>& out;
+        uint32_t& bits;
+        int& count;
+        void operator()(int code, int width) {
+            bits |= static_cast<uint32_t>(code) << count;
+            count += width;
+            while (count >= 8) {
+                out.push_back(static_cast<uint8_t>(bits));
+                bits >>= 8;
+                count -= 8;
+            }
+        }
+    } emit = {out, bits, count};
+
+    emit(clearCode, width);
+    int prefix = -1;
+    for (size_t i = 0; i < data.size(); ++i) {
+        int c = data[i];
+        if (prefix < 0) {
+            prefix = c;
+            continue;
+        }
+        std::map<std::pair<int, int>, int>::const_iterator it = table.find(std::make_pair(prefix, c));
+        if (it != table.end()) {
+            prefix = it->second;
+            continue;
+        }
+        emit(prefix, width);
+        if (next < 4096) {
+            table[std::make_pair(prefix, c)] = next++;
+            // The decoder adds this entry one code later
+            if (next - 1 == (1 << width) && width < 12) ++width;
+        } else if (clearWhenFull) {
+            emit(clearCode, width);
+            table.clear();
+            width = minCodeSize + 1;
+            next = clearCode + 2;
+        }
+        prefix = c;
+    }
+    if (prefix >= 0) emit(prefix, width);
+    emit(clearCode + 1, width);
+    if (count > 0) out.push_back(static_cast<uint8_t>(bits));
+    return out;
+}
+
+std::vector<uint8_t> lzwDecode(const std::vector<uint8_t>& code, int minCodeSize, size_t capacity) {
+    std::vector<uint8_t> out(capacity);
+    CKDWORD n = ImageLzwDecode(code.data(), static_cast<CKDWORD>(code.size()), minCodeSize, out.data(),
+                               static_cast<CKDWORD>(capacity));
+    out.resize(n);
+    return out;
+}
+
+std::vector<uint8_t> makeIndices(size_t count, int colors, uint32_t seed, int runs = 1) {
+    std::vector<uint8_t> v(count);
+    uint32_t state = seed;
+    for (size_t i = 0; i < count;) {
+        state = state * 1103515245u + 12345u;
+        uint8_t value = static_cast<uint8_t>((state >> 16) % colors);
+        size_t run = 1 + (state >> 8) % runs;
+        for (size_t k = 0; k < run && i < count; ++k) v[i++] = value;
+    }
+    return v;
+}
+
+struct FrameSpec {
+    uint32_t x, y, width, height;
+    std::vector<uint8_t> indices; // row-major image order
+    std::vector<uint8_t> localPalette; // RGB triples, empty = use the global table
+    int transparent;
+    bool interlaced;
+    int minCodeSize;
+
+    FrameSpec(uint32_t fx, uint32_t fy, uint32_t w, uint32_t h)
+        : x(fx), y(fy), width(w), height(h), indices(w * h, 0), transparent(-1), interlaced(false), minCodeSize(8) {}
+};
+
+struct GifSpec {
+    uint32_t width, height;
+    std::vector<uint8_t> palette; // RGB triples of the global table
+    int loops;                    // NETSCAPE repeat count, -1 for none
+    std::vector<FrameSpec> frames;
+
+    GifSpec(uint32_t w, uint32_t h) : width(w), height(h), loops(-1) {}
+};
+
+// Color table field: entries = 2 << bits, padded with zeros
+void putColorTable(std::vector<uint8_t>& out, std::vector<uint8_t> rgb, uint8_t& bits) {
+    bits = 0;
+    while ((2u << bits) * 3 < rgb.size()) ++bits;
+    rgb.resize((2u << bits) * 3, 0);
+    out.insert(out.end(), rgb.begin(), rgb.end());
+}
+
+void putSubBlocks(std::vector<uint8_t>& out, const std::vector<uint8_t>& data) {
+    for (size_t pos = 0; pos < data.size(); pos += 255) {
+        size_t n = std::min<size_t>(255, data.size() - pos);
+        out.push_back(static_cast<uint8_t>(n));
+        out.insert(out.end(), data.begin() + pos, data.begin() + pos + n);
+    }
+    out.push_back(0);
+}
+
+std::vector<uint8_t> interlaceRows(const FrameSpec& f) {
+    std::vector<uint8_t> stream;
+    static const uint32_t start[4] = {0, 4, 2, 1};
+    static const uint32_t step[4] = {8, 8, 4, 2};
+    for (int pass = 0; pass < 4; ++pass) {
+        for (uint32_t y = start[pass]; y < f.height; y += step[pass]) {
+            stream.insert(stream.end(), f.indices.begin() + y * f.width, f.indices.begin() + (y + 1) * f.width);
+        }
+    }
+    return stream;
+}
+
+std::vector<uint8_t> makeGif(const GifSpec& spec) {
+    std::vector<uint8_t> gif;
+    const char* signature = "GIF89a";
+    gif.insert(gif.end(), signature, signature + 6);
+    putLE16(gif, spec.width);
+    putLE16(gif, spec.height);
+    size_t flagsPos = gif.size();
+    gif.push_back(0);
+    gif.push_back(0);
+    gif.push_back(0);
+    if (!spec.palette.empty()) {
+        std::vector<uint8_t> table;
+        uint8_t bits = 0;
+        putColorTable(table, spec.palette, bits);
+        gif[flagsPos] = static_cast<uint8_t>(GIF_FLAG_COLOR_TABLE | bits);
+        gif.insert(gif.end(), table.begin(), table.end());
+    }
+
+    if (spec.loops >= 0) {
+        gif.push_back(GIF_BLOCK_EXTENSION);
+        gif.push_back(GIF_EXT_APPLICATION);
+        gif.push_back(11);
+        const char* id = "NETSCAPE2.0";
+        gif.insert(gif.end(), id, id + 11);
+        gif.push_back(3);
+        gif.push_back(1);
+        putLE16(gif, static_cast<uint32_t>(spec.loops));
+        gif.push_back(0);
+    }
+
+    for (size_t i = 0; i < spec.frames.size(); ++i) {
+        const FrameSpec& f = spec.frames[i];
+        gif.push_back(GIF_BLOCK_EXTENSION);
+        gif.push_back(GIF_EXT_GRAPHIC_CONTROL);
+        gif.push_back(GIF_GCE_SIZE);
+        gif.push_back(static_cast<uint8_t>((GIF_DISPOSE_NONE << 2) | (f.transparent >= 0 ? 1 : 0)));
+        putLE16(gif, 10);
+        gif.push_back(static_cast<uint8_t>(f.transparent >= 0 ? f.transparent : 0));
+        gif.push_back(0);
+
+        gif.push_back(GIF_BLOCK_IMAGE);
+        putLE16(gif, f.x);
+        putLE16(gif, f.y);
+        putLE16(gif, f.width);
+        putLE16(gif, f.height);
+        uint8_t flags = f.interlaced ? GIF_FLAG_INTERLACED : 0;
+        std::vector<uint8_t> table;
+        if (!f.localPalette.empty()) {
+            uint8_t bits = 0;
+            putColorTable(table, f.localPalette, bits);
+            flags |= GIF_FLAG_COLOR_TABLE | bits;
+        }
+        gif.push_back(flags);
+        gif.insert(gif.end(), table.begin(), table.end());
+        gif.push_back(static_cast<uint8_t>(f.minCodeSize));
+        putSubBlocks(gif, lzwEncode(f.interlaced ? interlaceRows(f) : f.indices, f.minCodeSize));
+    }
+    gif.push_back(GIF_BLOCK_TRAILER);
+    return gif;
+}
+
+// Grayscale-ish test palette: entry i is (i, 255 - i, i * 7)
+std::vector<uint8_t> makePalette(int count) {
+    std::vector<uint8_t> rgb;
+    for (int i = 0; i < count; ++i) {
+        rgb.push_back(static_cast<uint8_t>(i));
+        rgb.push_back(static_cast<uint8_t>(255 - i));
+        rgb.push_back(static_cast<uint8_t>(i * 7));
+    }
+    return rgb;
+}
+
+struct GifTestResult {
+    int errorCode;
+    int width;
+    int height;
+    int bitsPerPixel;
+    std::vector<uint8_t> pixels; // tightly packed rows
+    std::vector<uint8_t> colorMap;
+    CKDWORD frameCount;
+    CKDWORD numPlays;
+};
+
+GifTestResult readGif(const std::vector<uint8_t>& data, CKDWORD flags = 0) {
+    GifTestResult result;
+    GifReader reader;
+    reader.SetReadFlags(flags);
+    CKBitmapProperties* props = nullptr;
+    result.errorCode = reader.ReadMemory(const_cast<uint8_t*>(data.data()), static_cast<int>(data.size()), &props);
+    result.width = 0;
+    result.height = 0;
+    result.bitsPerPixel = 0;
+    result.frameCount = 0;
+    result.numPlays = 0;
+    if (result.errorCode == 0 && props && props->m_Format.Image) {
+        const VxImageDescEx& fmt = props->m_Format;
+        result.width = fmt.Width;
+        result.height = fmt.Height;
+        result.bitsPerPixel = fmt.BitsPerPixel;
+        size_t rowBytes = static_cast<size_t>(fmt.Width) * fmt.BitsPerPixel / 8;
+        result.pixels.resize(rowBytes * fmt.Height);
+        for (int y = 0; y < fmt.Height; ++y) {
+            memcpy(&result.pixels[y * rowBytes], fmt.Image + y * fmt.BytesPerLine, rowBytes);
+        }
+        if (fmt.ColorMap) {
+            result.colorMap.assign(fmt.ColorMap, fmt.ColorMap + fmt.ColorMapEntries * 4);
+        }
+        result.frameCount = reinterpret_cast<GifBitmapProperties*>(props)->m_FrameCount;
+        result.numPlays = reinterpret_cast<GifBitmapProperties*>(props)->m_NumPlays;
+    }
+    return result;
+}
+
+GifTestResult readGifFile(const std::string& path, CKDWORD flags = 0) {
+    return readGif(readBinaryFile(path), flags);
+}
+
+// Expected BGRA32 screen with frame drawn over a transparent canvas
+std::vector<uint8_t> expectScreen(const GifSpec& spec, const FrameSpec& f) {
+    const std::vector<uint8_t>& rgb = f.localPalette.empty() ? spec.palette : f.localPalette;
+    std::vector<uint8_t> out(spec.width * spec.height * 4, 0);
+    for (uint32_t y = 0; y < f.height && f.y + y < spec.height; ++y) {
+        for (uint32_t x = 0; x < f.width && f.x + x < spec.width; ++x) {
+            int index = f.indices[y * f.width + x];
+            if (index == f.transparent) continue;
+            uint8_t* d = &out[((f.y + y) * spec.width + f.x + x) * 4];
+            if (static_cast<size_t>(index) * 3 + 2 < rgb.size()) {
+                d[0] = rgb[index * 3 + 2];
+                d[1] = rgb[index * 3 + 1];
+                d[2] = rgb[index * 3];
+            } else {
+                d[0] = d[1] = d[2] = 0;
+            }
+            d[3] = 255;
+        }
+    }
+    return out;
+}
+
+} // anonymous namespace
+
+//=============================================================================
+// LZW Tests
+//=============================================================================
+
+TEST(GifReader, Lzw_RoundTripAllCodeSizes) {
+    for (int m = 1; m <= 8; ++m) {
+        for (int runs = 1; runs <= 40; runs += 13) {
+            std::vector<uint8_t> data = makeIndices(20000, 1 << m, 17u * m + runs, runs);
+            std::vector<uint8_t> code = lzwEncode(data, m);
+            ASSERT_TRUE(lzwDecode(code, m, data.size()) == data);
+        }
+    }
+}
+
+TEST(GifReader, Lzw_FullTable) {
+    // Random bytes fill the 4096 codes many times over: once with a clear
+    // code each time and once with the table left frozen
+    std::vector<uint8_t> data = makeIndices(200000, 256, 99);
+    ASSERT_TRUE(lzwDecode(lzwEncode(data, 8, true), 8, data.size()) == data);
+    ASSERT_TRUE(lzwDecode(lzwEncode(data, 8, false), 8, data.size()) == data);
+
+    // Long runs make long strings, copied 8 bytes at a time
+    std::vector<uint8_t> runs = makeIndices(300000, 4, 5, 3000);
+    ASSERT_TRUE(lzwDecode(lzwEncode(runs, 2, false), 2, runs.size()) == runs);
+}
+
+TEST(GifReader, Lzw_CodeNotYetInTable) {
+    // "aaaa..." is coded almost entirely with codes that are defined by
+    // their own use (the KwKwK case)
+    for (size_t n = 1; n < 300; n += 7) {
+        std::vector<uint8_t> data(n, 3);
+        ASSERT_TRUE(lzwDecode(lzwEncode(data, 2), 2, n) == data);
+    }
+    std::vector<uint8_t> abab;
+    for (int i = 0; i < 1000; ++i) abab.push_back(static_cast<uint8_t>(i & 1));
+    ASSERT_TRUE(lzwDecode(lzwEncode(abab, 1), 1, abab.size()) == abab);
+}
+
+TEST(GifReader, Lzw_Limits) {
+    std::vector<uint8_t> data = makeIndices(5000, 16, 7, 9);
+    std::vector<uint8_t> code = lzwEncode(data, 4);
+
+    // Output is cut at the capacity, also in the middle of a string
+    for (size_t cap = 1; cap < 200; cap += 3) {
+        std::vector<uint8_t> part = lzwDecode(code, 4, cap);
+        ASSERT_EQ(cap, part.size());
+        ASSERT_TRUE(std::equal(part.begin(), part.end(), data.begin()));
+    }
+
+    // Truncated input yields a prefix of the data
+    std::vector<uint8_t> cut(code.begin(), code.begin() + code.size() / 2);
+    std::vector<uint8_t> part = lzwDecode(cut, 4, data.size());
+    ASSERT_TRUE(part.size() > 0 && part.size() < data.size());
+    ASSERT_TRUE(std::equal(part.begin(), part.end(), data.begin()));
+
+    // A code past the next table entry stops decoding: clear (16) in 5 bits,
+    // then 24 while the next entry is 18
+    std::vector<uint8_t> bad;
+    bad.push_back(0x10);
+    bad.push_back(0xFF);
+    bad.push_back(0xFF);
+    ASSERT_EQ(0u, lzwDecode(bad, 4, 100).size());
+
+    ASSERT_EQ(0u, ImageLzwDecode(code.data(), static_cast<CKDWORD>(code.size()), 9, &part[0], 1));
+    ASSERT_EQ(0u, ImageLzwDecode(code.data(), static_cast<CKDWORD>(code.size()), 0, &part[0], 1));
+}
+
+//=============================================================================
+// Image Tests
+//=============================================================================
+
+TEST(GifReader, Basic_GlobalPalette) {
+    GifSpec spec(13, 7);
+    spec.palette = makePalette(200);
+    FrameSpec f(0, 0, 13, 7);
+    f.indices = makeIndices(13 * 7, 200, 3, 4);
+    spec.frames.push_back(f);
+
+    GifTestResult r = readGif(makeGif(spec));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(13, r.width);
+    ASSERT_EQ(7, r.height);
+    ASSERT_EQ(32, r.bitsPerPixel);
+    ASSERT_TRUE(r.pixels == expectScreen(spec, f));
+    ASSERT_EQ(1u, r.frameCount);
+    ASSERT_EQ(1u, r.numPlays);
+}
+
+TEST(GifReader, Basic_LocalPaletteAndTransparency) {
+    GifSpec spec(20, 10);
+    spec.palette = makePalette(4);
+    FrameSpec f(3, 2, 9, 6);
+    f.localPalette = makePalette(30);
+    std::reverse(f.localPalette.begin(), f.localPalette.end());
+    f.indices = makeIndices(9 * 6, 40, 11, 2); // indices past the table are black
+    f.transparent = 5;
+    f.minCodeSize = 6;
+    spec.frames.push_back(f);
+
+    GifTestResult r = readGif(makeGif(spec));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == expectScreen(spec, f));
+}
+
+TEST(GifReader, Interlaced_MatchesProgressive) {
+    for (uint32_t h = 1; h <= 19; ++h) {
+        GifSpec spec(5, h);
+        spec.palette = makePalette(64);
+        FrameSpec f(0, 0, 5, h);
+        f.indices = makeIndices(5 * h, 64, h);
+        spec.frames.push_back(f);
+        std::vector<uint8_t> progressive = readGif(makeGif(spec)).pixels;
+        spec.frames[0].interlaced = true;
+        GifTestResult r = readGif(makeGif(spec));
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_TRUE(r.pixels == progressive);
+        ASSERT_TRUE(r.pixels == expectScreen(spec, f));
+    }
+}
+
+TEST(GifReader, KeepIndices) {
+    GifSpec spec(6, 5);
+    spec.palette = makePalette(16);
+    FrameSpec f(0, 0, 6, 5);
+    f.indices = makeIndices(30, 16, 8);
+    f.transparent = 2;
+    f.interlaced = true;
+    f.minCodeSize = 4;
+    spec.frames.push_back(f);
+
+    GifTestResult r = readGif(makeGif(spec), IMAGE_READ_KEEP_INDICES);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(8, r.bitsPerPixel);
+    ASSERT_TRUE(r.pixels == f.indices);
+    ASSERT_EQ(16u * 4, r.colorMap.size());
+    ASSERT_EQ(7 * 3, r.colorMap[3 * 4 + 0]); // B of entry 3
+    ASSERT_EQ(255 - 3, r.colorMap[3 * 4 + 1]);
+    ASSERT_EQ(3, r.colorMap[3 * 4 + 2]);
+    ASSERT_EQ(255, r.colorMap[3 * 4 + 3]);
+    ASSERT_EQ(0, r.colorMap[2 * 4 + 3]); // transparent entry
+
+    // A frame smaller than the screen is composited instead
+    spec.frames[0].width = 5;
+    spec.frames[0].indices.resize(25);
+    r = readGif(makeGif(spec), IMAGE_READ_KEEP_INDICES);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(32, r.bitsPerPixel);
+}
+
+TEST(GifReader, FrameClippedToScreen) {
+    GifSpec spec(10, 8);
+    spec.palette = makePalette(32);
+    FrameSpec f(4, 3, 12, 9);
+    f.indices = makeIndices(12 * 9, 32, 21, 3);
+    spec.frames.push_back(f);
+
+    GifTestResult r = readGif(makeGif(spec));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(10, r.width);
+    ASSERT_EQ(8, r.height);
+    ASSERT_TRUE(r.pixels == expectScreen(spec, f));
+
+    // Entirely outside: an empty screen
+    spec.frames[0].x = 10;
+    r = readGif(makeGif(spec));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == std::vector<uint8_t>(10 * 8 * 4, 0));
+
+    // No screen size: the extent of the frame
+    spec.width = spec.height = 0;
+    spec.frames[0].x = 1;
+    r = readGif(makeGif(spec));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(13, r.width);
+    ASSERT_EQ(12, r.height);
+}
+
+TEST(GifReader, ReportsFramesAndLoops) {
+    GifSpec spec(4, 4);
+    spec.palette = makePalette(4);
+    spec.loops = 0;
+    for (int i = 0; i < 3; ++i) {
+        FrameSpec f(0, 0, 4, 4);
+        f.indices = makeIndices(16, 4, i);
+        spec.frames.push_back(f);
+    }
+    GifTestResult r = readGif(makeGif(spec));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(3u, r.frameCount);
+    ASSERT_EQ(0u, r.numPlays);
+    ASSERT_TRUE(r.pixels == expectScreen(spec, spec.frames[0]));
+
+    spec.loops = 2;
+    ASSERT_EQ(3u, readGif(makeGif(spec)).numPlays);
+}
+
+TEST(GifReader, TruncatedFrameKeepsDecodedRows) {
+    const uint32_t w = 40, h = 30;
+    GifSpec spec(w, h);
+    spec.palette = makePalette(256);
+    FrameSpec f(0, 0, w, h);
+    f.indices = makeIndices(w * h, 256, 4);
+    spec.frames.push_back(f);
+    std::vector<uint8_t> gif = makeGif(spec);
+    gif.resize(gif.size() - 400);
+
+    GifTestResult r = readGif(gif);
+    ASSERT_EQ(0, r.errorCode);
+    std::vector<uint8_t> full = expectScreen(spec, f);
+    // The first rows are intact, the last row is undrawn
+    ASSERT_TRUE(std::equal(full.begin(), full.begin() + w * 4 * 4, r.pixels.begin()));
+    ASSERT_TRUE(std::vector<uint8_t>(r.pixels.end() - w * 4, r.pixels.end()) == std::vector<uint8_t>(w * 4, 0));
+}
+
+//=============================================================================
+// Corpus Tests
+//=============================================================================
+
+TEST(GifReader, Corpus_ReferenceCrcs) {
+    static const char* files[] = {"simple/alpha_gif_a.gif", "simple/issue_1455_oversized.gif", "simple/sample_1.gif",
+                                  "anim/any-disposal.gif", "anim/interlaced.gif", "anim/large-gif-anim-combine.gif",
+                                  "anim/oob.gif"};
+    std::string gifDir = joinPath(g_TestImagesDir, "gif");
+    int checked = 0;
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i) {
+        std::string path = joinPath(gifDir, files[i]);
+        uint32_t crc = 0;
+        if (!fileExists(path) || !getReferenceCrc(std::string("gif/") + files[i], crc)) continue;
+        GifTestResult r = readGifFile(path);
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_CRC(crc, r.pixels.data(), r.pixels.size());
+        ++checked;
+    }
+    if (checked == 0) SKIP_TEST("GIF corpus or reference CRCs not found");
+}
+
+TEST(GifReader, Corpus_MatchesReferenceImages) {
+    // The references hold the first frame on a transparent screen as RGBA PNGs
+    static const char* subdirs[] = {"simple", "anim"};
+    int compared = 0;
+    for (size_t d = 0; d < sizeof(subdirs) / sizeof(subdirs[0]); ++d) {
+        std::string imageDir = joinPath(joinPath(g_TestImagesDir, "gif"), subdirs[d]);
+        std::string refDir = joinPath(joinPath(g_TestReferenceDir, "gif"), subdirs[d]);
+        std::vector<std::string> refs = listDirectory(refDir);
+        for (size_t i = 0; i < refs.size(); ++i) {
+            ReferenceInfo info = parseReferenceFilename(refs[i]);
+            std::string imagePath = joinPath(imageDir, info.inputName);
+            if (!info.valid || !fileExists(imagePath)) continue;
+
+            GifTestResult image = readGifFile(imagePath);
+            ASSERT_EQ(0, image.errorCode);
+            CKBitmapProperties refProps;
+            ASSERT_EQ(0, PNG_Read(const_cast<char*>(joinPath(refDir, refs[i]).c_str()), 0, &refProps));
+            const VxImageDescEx& ref = refProps.m_Format;
+            ASSERT_EQ(ref.Width, image.width);
+            ASSERT_EQ(ref.Height, image.height);
+            ASSERT_TRUE(memcmp(ref.Image, image.pixels.data(), image.pixels.size()) == 0);
+            delete[] static_cast<CKBYTE*>(refProps.m_Data);
+            ++compared;
+        }
+    }
+    if (compared == 0) SKIP_TEST("GIF reference images not found");
+}
+
+TEST(GifReader, RegressionCorpus_MustNotCrash) {
+    // Every prefix length of a small animation: errors are fine, crashes are not
+    std::string path = joinPath(joinPath(g_TestImagesDir, "gif"), "anim/mixed-disposal.gif");
+    if (!fileExists(path)) SKIP_TEST("mixed-disposal.gif not found");
+    std::vector<uint8_t> data = readBinaryFile(path);
+    for (size_t n = 0; n <= data.size(); ++n) {
+        std::vector<uint8_t> prefix(data.begin(), data.begin() + n);
+        readGif(prefix);
+        readGif(prefix, IMAGE_READ_KEEP_INDICES);
+    }
+}
+
+//=============================================================================
+// Negative Tests
+//=============================================================================
+
+TEST(GifReader, Negative_BadSignature) {
+    GifSpec spec(2, 2);
+    spec.palette = makePalette(2);
+    spec.frames.push_back(FrameSpec(0, 0, 2, 2));
+    std::vector<uint8_t> gif = makeGif(spec);
+    gif[4] = '8'; // "GIF88a"
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readGif(gif).errorCode);
+    gif.resize(10);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readGif(gif).errorCode);
+}
+
+TEST(GifReader, Negative_BadDescriptor) {
+    GifSpec spec(8, 8);
+    spec.palette = makePalette(2);
+    spec.frames.push_back(FrameSpec(0, 0, 8, 8));
+    std::vector<uint8_t> gif = makeGif(spec);
+    const size_t descriptor = GIF_HEADER_SIZE + 6 + 8; // after the global table and the GCE
+    ASSERT_EQ(GIF_BLOCK_IMAGE, gif[descriptor]);
+
+    std::vector<uint8_t> zeroWidth = gif;
+    zeroWidth[descriptor + 5] = 0;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readGif(zeroWidth).errorCode);
+
+    std::vector<uint8_t> badCodeSize = gif;
+    badCodeSize[descriptor + GIF_DESCRIPTOR_SIZE] = 9;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readGif(badCodeSize).errorCode);
+
+    // No image at all
+    std::vector<uint8_t> empty(gif.begin(), gif.begin() + GIF_HEADER_SIZE + 6);
+    empty.push_back(GIF_BLOCK_TRAILER);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readGif(empty).errorCode);
+
+    // Image data that starts with an invalid code
+    std::vector<uint8_t> badData = gif;
+    badData[descriptor + GIF_DESCRIPTOR_SIZE + 2] = 0xFF;
+    badData[descriptor + GIF_DESCRIPTOR_SIZE + 3] = 0xFF;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readGif(badData).errorCode);
+}
+
+//=============================================================================
+// API Tests
+//=============================================================================
+
+TEST(GifReader, GetReaderInfo) {
+    GifReader reader;
+    CKPluginInfo* info = reader.GetReaderInfo();
+    ASSERT_TRUE(info != nullptr);
+    ASSERT_GUID_EQ(GIFREADER_GUID, info->m_GUID);
+    ASSERT_EQ(static_cast<int>(CKPLUGIN_BITMAP_READER), static_cast<int>(info->m_Type));
+}
+
+TEST(GifReader, ReadOnly) {
+    GifReader reader;
+    GifBitmapProperties props;
+    std::vector<uint8_t> pixels(4 * 4, 0);
+    ImageReader::FillFormatBGRA32(props.m_Format, 2, 2, 8, pixels.data());
+    void* memory = nullptr;
+    ASSERT_EQ(0, reader.SaveMemory(&memory, &props));
+    ASSERT_EQ(0, reader.SaveFile(const_cast<char*>("test.gif"), &props));
+}
@@ -0,0 +1,543 @@
+/**
+ * @file HdrReaderTests.cpp
+ * @brief Radiance HDR format tests for CKImageReader
+ *
+ * Tests cover:
+ * - Flat, old-style RLE and new-style RLE scanlines decoding to the same pixels
+ * - The four row/column orders, exposure scaling and header variables
+ * - Float output (IMAGE_READ_FLOAT)
+ * - The SIMD RGBE kernels against a scalar reference
+ * - The corpus in tests/images/hdr against CRCs and the image-rs reference images
+ * - Malformed files (bad header, corrupt runs, truncated data)
+ */
+
+#include "TestFramework.h"
+#include "HdrReader.h"
+#include "TiffReader.h"
+#include "ImageInflate.h"
+#include "ImageSimd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace TestFramework;
+
+//=============================================================================
+// Test Helpers
+//=============================================================================
+
+namespace {
+
+// RGBE pixels of a test image, in top-down, left-to-right order
+struct RgbeImage {
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint8_t> pixels;
+
+    RgbeImage(uint32_t w, uint32_t h, uint32_t seed) : width(w), height(h), pixels(w * h * 4) {
+        // Short runs and noise, so both run and literal codes are produced
+        uint32_t state = seed * 2654435761u + 1;
+        for (uint32_t i = 0; i < w * h; ++i) {
+            if (i % 5 != 0) {
+                state = state * 1103515245u + 12345u;
+                for (int c = 0; c < 4; ++c) pixels[i * 4 + c] = static_cast<uint8_t>(state >> (8 + 5 * c));
+                pixels[i * 4 + 3] = static_cast<uint8_t>(120 + (state >> 28));
+            } else if (i > 0) {
+                memcpy(&pixels[i * 4], &pixels[(i - 1) * 4], 4);
+            }
+        }
+    }
+    const uint8_t* at(uint32_t x, uint32_t y) const { return &pixels[(y * width + x) * 4]; }
+};
+
+float rgbeChannel(uint8_t m, uint8_t e) {
+    return (e == 0) ? 0.0f : static_cast<float>(std::ldexp(static_cast<double>(m), e - 136));
+}
+
+uint8_t toByte(float f) {
+    f = std::min(std::max(f, 0.0f), 1.0f);
+    return static_cast<uint8_t>(static_cast<int>(f * 255.0f + 0.5f));
+}
+
+// One scanline in new-style RLE (widths 8 to 0x7FFF only): runs of three or
+// more as (128 + n, value)
+void encodeRle(const uint8_t* px, uint32_t width, std::vector<uint8_t>& out) {
+    out.push_back(2);
+    out.push_back(2);
+    out.push_back(static_cast<uint8_t>(width >> 8));
+    out.push_back(static_cast<uint8_t>(width));
+    for (int c = 0; c < 4; ++c) {
+        uint32_t x = 0;
+        while (x < width) {
+            uint32_t run = 1;
+            while (x + run < width && run < 127 && px[(x + run) * 4 + c] == px[x * 4 + c]) ++run;
+            if (run >= 3) {
+                out.push_back(static_cast<uint8_t>(128 + run));
+                out.push_back(px[x * 4 + c]);
+                x += run;
+                continue;
+            }
+            uint32_t start = x;
+            while (x < width && x - start < 128) {
+                if (x + 2 < width && px[x * 4 + c] == px[(x + 1) * 4 + c] && px[x * 4 + c] == px[(x + 2) * 4 + c])
+                    break;
+                ++x;
+            }
+            out.push_back(static_cast<uint8_t>(x - start));
+            for (uint32_t k = start; k < x; ++k) out.push_back(px[k * 4 + c]);
+        }
+    }
+}
+
+// One scanline in old-style RLE: repeats as (1, 1, 1, n), with a second
+// marker for the high byte of longer repeats
+void encodeOldRle(const uint8_t* px, uint32_t width, std::vector<uint8_t>& out) {
+    uint32_t x = 0;
+    while (x < width) {
+        out.insert(out.end(), px + x * 4, px + x * 4 + 4);
+        uint32_t run = 0;
+        while (x + 1 + run < width && memcmp(px + (x + 1 + run) * 4, px + x * 4, 4) == 0) ++run;
+        if (run >= 2) {
+            uint8_t marker[4] = {1, 1, 1, static_cast<uint8_t>(run)};
+            out.insert(out.end(), marker, marker + 4);
+            if (run > 255) {
+                marker[3] = static_cast<uint8_t>(run >> 8);
+                out.insert(out.end(), marker, marker + 4);
+            }
+            x += run;
+        }
+        ++x;
+    }
+}
+
+enum Encoding { FLAT, OLD_RLE, NEW_RLE };
+
+// Resolution orders as written in the file and how the file scanlines map
+// to the image (flipY: bottom row first; flipX: right to left)
+struct Order {
+    const char* format;
+    bool flipY;
+    bool flipX;
+};
+
+const Order kTopDown = {"-Y %u +X %u", false, false};
+
+std::vector<uint8_t> makeHdr(const RgbeImage& img, Encoding encoding, const Order& order = kTopDown,
+                             const std::string& variables = "FORMAT=32-bit_rle_rgbe\n") {
+    std::string header = "#?RADIANCE\n" + variables + "\n";
+    char resolution[64];
+    snprintf(resolution, sizeof(resolution), order.format, img.height, img.width);
+    header += resolution;
+    header += "\n";
+    std::vector<uint8_t> out(header.begin(), header.end());
+
+    std::vector<uint8_t> line(img.width * 4);
+    for (uint32_t y = 0; y < img.height; ++y) {
+        uint32_t srcY = order.flipY ? img.height - 1 - y : y;
+        for (uint32_t x = 0; x < img.width; ++x)
+            memcpy(&line[x * 4], img.at(order.flipX ? img.width - 1 - x : x, srcY), 4);
+        if (encoding == NEW_RLE && img.width >= HDR_RLE_MIN_WIDTH && img.width <= HDR_RLE_MAX_WIDTH)
+            encodeRle(line.data(), img.width, out);
+        else if (encoding == OLD_RLE)
+            encodeOldRle(line.data(), img.width, out);
+        else
+            out.insert(out.end(), line.begin(), line.end());
+    }
+    return out;
+}
+
+std::vector<uint8_t> expectBgra(const RgbeImage& img, float exposure = 1.0f) {
+    std::vector<uint8_t> out;
+    for (uint32_t i = 0; i < img.width * img.height; ++i) {
+        const uint8_t* p = &img.pixels[i * 4];
+        out.push_back(toByte(rgbeChannel(p[2], p[3]) * exposure));
+        out.push_back(toByte(rgbeChannel(p[1], p[3]) * exposure));
+        out.push_back(toByte(rgbeChannel(p[0], p[3]) * exposure));
+        out.push_back(255);
+    }
+    return out;
+}
+
+struct HdrTestResult {
+    int errorCode;
+    int width;
+    int height;
+    int bitsPerPixel;
+    std::vector<uint8_t> pixels; // tightly packed rows
+    float exposure;
+    float gamma;
+};
+
+HdrTestResult readHdr(const std::vector<uint8_t>& data, CKDWORD flags = 0, float exposure = 1.0f) {
+    HdrTestResult result;
+    HdrReader reader;
+    reader.SetReadFlags(flags);
+    reader.SetExposure(exposure);
+    CKBitmapProperties* props = nullptr;
+    result.errorCode = reader.ReadMemory(const_cast<uint8_t*>(data.data()), static_cast<int>(data.size()), &props);
+    result.width = 0;
+    result.height = 0;
+    result.bitsPerPixel = 0;
+    result.exposure = 0.0f;
+    result.gamma = 0.0f;
+    if (result.errorCode == 0 && props && props->m_Format.Image) {
+        const VxImageDescEx& fmt = props->m_Format;
+        result.width = fmt.Width;
+        result.height = fmt.Height;
+        result.bitsPerPixel = fmt.BitsPerPixel;
+        for (int y = 0; y < fmt.Height; ++y) {
+            const uint8_t* row = fmt.Image + y * fmt.BytesPerLine;
+            result.pixels.insert(result.pixels.end(), row, row + fmt.Width * fmt.BitsPerPixel / 8);
+        }
+        HdrBitmapProperties* hp = reinterpret_cast<HdrBitmapProperties*>(props);
+        result.exposure = hp->m_Exposure;
+        result.gamma = hp->m_Gamma;
+    }
+    return result;
+}
+
+HdrTestResult readHdrFile(const std::string& path, CKDWORD flags = 0) {
+    return readHdr(readBinaryFile(path), flags);
+}
+
+// The RGB float samples of a reference image (little-endian, Deflate strips
+// with the floating point predictor, as written by image-rs)
+bool readReferenceFloats(const std::vector<uint8_t>& tiff, uint32_t& width, uint32_t& height,
+                         std::vector<float>& samples) {
+    TiffImageInfo info;
+    if (TIFF_ReadInfo(tiff.data(), static_cast<CKDWORD>(tiff.size()), info) != 0) return false;
+    if (info.bigEndian || info.bitsPerSample != 32 || info.samplesPerPixel != 3 || info.tiled ||
+        info.compression != TIFF_COMPRESSION_DEFLATE || info.predictor != TIFF_PREDICTOR_FLOAT)
+        return false;
+    width = info.width;
+    height = info.height;
+    samples.assign(width * height * 3, 0.0f);
+    uint32_t rowBytes = width * 12;
+    std::vector<uint8_t> strip(rowBytes * info.chunkHeight);
+    for (uint32_t s = 0; s < info.chunksDown; ++s) {
+        uint32_t rows = std::min(info.chunkHeight, height - s * info.chunkHeight);
+        CKDWORD offset = TIFF_ArrayValue(info, info.offsets, s);
+        CKDWORD count = TIFF_ArrayValue(info, info.byteCounts, s);
+        CKDWORD written = 0;
+        if (!ImageZlibInflate(&tiff[offset], count, strip.data(), rows * rowBytes, &written) ||
+            written != rows * rowBytes)
+            return false;
+        for (uint32_t r = 0; r < rows; ++r) {
+            uint8_t* row = &strip[r * rowBytes];
+            // Bytes are differenced one pixel apart and stored as planes,
+            // most significant first
+            for (uint32_t k = 3; k < rowBytes; ++k) row[k] = static_cast<uint8_t>(row[k] + row[k - 3]);
+            uint32_t n = width * 3;
+            for (uint32_t i = 0; i < n; ++i) {
+                uint32_t bits = (static_cast<uint32_t>(row[i]) << 24) | (static_cast<uint32_t>(row[n + i]) << 16) |
+                                (static_cast<uint32_t>(row[2 * n + i]) << 8) | row[3 * n + i];
+                memcpy(&samples[((s * info.chunkHeight + r) * width) * 3 + i], &bits, 4);
+            }
+        }
+    }
+    return true;
+}
+
+std::string hdrImagesDir() { return joinPath(joinPath(g_TestImagesDir, "hdr"), "images"); }
+
+} // namespace
+
+//=============================================================================
+// Scanline Encodings
+//=============================================================================
+
+TEST(HdrReader, Flat_TopDown) {
+    RgbeImage img(5, 3, 1); // narrower than 8: never run-length encoded
+    HdrTestResult r = readHdr(makeHdr(img, FLAT));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(5, r.width);
+    ASSERT_EQ(3, r.height);
+    ASSERT_EQ(32, r.bitsPerPixel);
+    ASSERT_TRUE(r.pixels == expectBgra(img));
+}
+
+TEST(HdrReader, KnownValues) {
+    // (128, 64, 32) with exponent 129 is (1.0, 0.5, 0.25)
+    RgbeImage img(2, 1, 0);
+    static const uint8_t px[8] = {128, 64, 32, 129, 200, 0, 255, 0};
+    memcpy(img.pixels.data(), px, 8);
+    HdrTestResult r = readHdr(makeHdr(img, FLAT), IMAGE_READ_FLOAT);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(128, r.bitsPerPixel);
+    const float* f = reinterpret_cast<const float*>(r.pixels.data());
+    static const float expected[8] = {1.0f, 0.5f, 0.25f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+    ASSERT_TRUE(memcmp(f, expected, sizeof(expected)) == 0);
+
+    r = readHdr(makeHdr(img, FLAT));
+    static const uint8_t bgra[8] = {64, 128, 255, 255, 0, 0, 0, 255};
+    ASSERT_TRUE(memcmp(r.pixels.data(), bgra, 8) == 0);
+}
+
+TEST(HdrReader, Encodings_AllMatch) {
+    // Widths around the new-style RLE range and past one 127-byte run
+    static const uint32_t widths[] = {7, 8, 9, 31, 130, 300};
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); ++w) {
+        RgbeImage img(widths[w], 37, static_cast<uint32_t>(w + 2));
+        std::vector<uint8_t> expected = expectBgra(img);
+        ASSERT_TRUE(readHdr(makeHdr(img, FLAT)).pixels == expected);
+        ASSERT_TRUE(readHdr(makeHdr(img, OLD_RLE)).pixels == expected);
+        ASSERT_TRUE(readHdr(makeHdr(img, NEW_RLE)).pixels == expected);
+    }
+}
+
+TEST(HdrReader, OldRle_LongRepeats) {
+    // 300 equal pixels need a second marker: 300 = 44 + (1 << 8)
+    RgbeImage img(302, 2, 3);
+    for (uint32_t i = 1; i < 301; ++i) memcpy(&img.pixels[i * 4], &img.pixels[0], 4);
+    std::vector<uint8_t> data = makeHdr(img, OLD_RLE);
+    HdrTestResult r = readHdr(data);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == expectBgra(img));
+}
+
+TEST(HdrReader, Orientation_AllFourOrders) {
+    RgbeImage img(11, 6, 4);
+    std::vector<uint8_t> expected = expectBgra(img);
+    static const Order orders[] = {
+        {"-Y %u +X %u", false, false},
+        {"+Y %u +X %u", true, false},
+        {"-Y %u -X %u", false, true},
+        {"+Y %u -X %u", true, true},
+    };
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(readHdr(makeHdr(img, NEW_RLE, orders[i])).pixels == expected);
+        ASSERT_TRUE(readHdr(makeHdr(img, FLAT, orders[i])).pixels == expected);
+    }
+}
+
+TEST(HdrReader, ManyScanlines_ParallelDecode) {
+    RgbeImage img(64, 700, 5);
+    HdrTestResult r = readHdr(makeHdr(img, NEW_RLE, {"+Y %u +X %u", true, false}));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == expectBgra(img));
+}
+
+//=============================================================================
+// Output Options
+//=============================================================================
+
+TEST(HdrReader, Float_Output) {
+    RgbeImage img(13, 4, 6);
+    HdrTestResult r = readHdr(makeHdr(img, NEW_RLE), IMAGE_READ_FLOAT, 4.0f);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(128, r.bitsPerPixel);
+    ASSERT_EQ(static_cast<size_t>(13 * 4 * 16), r.pixels.size());
+    const float* f = reinterpret_cast<const float*>(r.pixels.data());
+    for (uint32_t i = 0; i < 13 * 4; ++i) {
+        const uint8_t* p = &img.pixels[i * 4];
+        // The exposure setting does not apply to float output
+        for (int c = 0; c < 3; ++c) ASSERT_TRUE(f[i * 4 + c] == rgbeChannel(p[c], p[3]));
+        ASSERT_TRUE(f[i * 4 + 3] == 1.0f);
+    }
+}
+
+TEST(HdrReader, Exposure_ScalesBgra32) {
+    RgbeImage img(9, 3, 7);
+    ASSERT_TRUE(readHdr(makeHdr(img, FLAT), 0, 0.25f).pixels == expectBgra(img, 0.25f));
+    ASSERT_TRUE(readHdr(makeHdr(img, FLAT), 0, 8.0f).pixels == expectBgra(img, 8.0f));
+}
+
+TEST(HdrReader, HeaderVariables) {
+    RgbeImage img(3, 2, 8);
+    std::string vars = "# comment\nSOFTWARE=test\nEXPOSURE=2.0\nGAMMA=2.2\nEXPOSURE=0.25\nFORMAT=32-bit_rle_rgbe\n";
+    HdrTestResult r = readHdr(makeHdr(img, FLAT, kTopDown, vars));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.exposure == 0.5f);
+    ASSERT_TRUE(std::fabs(r.gamma - 2.2f) < 1e-6f);
+
+    // No variables at all
+    r = readHdr(makeHdr(img, FLAT, kTopDown, ""));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.exposure == 1.0f);
+    ASSERT_TRUE(r.gamma == 1.0f);
+}
+
+TEST(HdrReader, Simd_RgbeMatchesScalar) {
+    for (int count = 0; count < 40; ++count) {
+        std::vector<CKBYTE> src(count * 4);
+        for (int i = 0; i < count * 4; ++i) src[i] = static_cast<CKBYTE>(i * 73 + count * 31);
+        // Edge exponents: black, denormal results and the largest
+        if (count > 3) {
+            src[3] = 0;
+            src[7] = 1;
+            src[11] = 255;
+        }
+        std::vector<float> f(count * 4 + 1, -7.0f);
+        std::vector<CKBYTE> b(count * 4 + 1, 0xEE);
+        ImageRGBEToFloat(src.data(), f.data(), count);
+        ImageRGBEToBGRA32(src.data(), b.data(), count, 3.0f);
+        for (int i = 0; i < count; ++i) {
+            const CKBYTE* p = &src[i * 4];
+            for (int c = 0; c < 3; ++c) {
+                float expected = rgbeChannel(p[c], p[3]);
+                ASSERT_TRUE(f[i * 4 + c] == expected);
+                ASSERT_EQ(toByte(expected * 3.0f), b[i * 4 + 2 - c]);
+            }
+            ASSERT_TRUE(f[i * 4 + 3] == 1.0f);
+            ASSERT_EQ(255, b[i * 4 + 3]);
+        }
+        ASSERT_TRUE(f[count * 4] == -7.0f);
+        ASSERT_EQ(0xEE, b[count * 4]);
+    }
+}
+
+//=============================================================================
+// Reader Tests
+//=============================================================================
+
+TEST(HdrReader, ReaderInfo) {
+    HdrReader reader;
+    CKPluginInfo* info = reader.GetReaderInfo();
+    ASSERT_TRUE(info != nullptr);
+    ASSERT_GUID_EQ(HDRREADER_GUID, info->m_GUID);
+    ASSERT_EQ(0, reader.SaveFile(const_cast<char*>("unused.hdr"), nullptr));
+}
+
+//=============================================================================
+// Corpus Tests
+//=============================================================================
+
+TEST(HdrReader, Corpus_ReferenceCrcs) {
+    std::vector<std::string> files = collectFilesWithExtensions(hdrImagesDir(), {".hdr"});
+    int checked = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        uint32_t crc = 0;
+        if (!getReferenceCrc("hdr/" + files[i], crc)) continue;
+        HdrTestResult r = readHdrFile(joinPath(hdrImagesDir(), files[i]));
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_CRC(crc, r.pixels.data(), r.pixels.size());
+        ++checked;
+    }
+    if (checked == 0) SKIP_TEST("HDR corpus or reference CRCs not found");
+}
+
+TEST(HdrReader, Corpus_MatchesReferenceImages) {
+    // The references are float TIFFs: the float output must match exactly,
+    // and the TIFF reader clamps them to the same BGRA32 as the HDR reader
+    std::string refDir = joinPath(joinPath(g_TestReferenceDir, "hdr"), "images");
+    std::vector<std::string> refs = listDirectory(refDir);
+    int compared = 0;
+    for (size_t i = 0; i < refs.size(); ++i) {
+        ReferenceInfo info = parseReferenceFilename(refs[i]);
+        std::string imagePath = joinPath(hdrImagesDir(), info.inputName);
+        if (!info.valid || !fileExists(imagePath)) continue;
+
+        std::vector<uint8_t> tiff = readBinaryFile(joinPath(refDir, refs[i]));
+        uint32_t width = 0, height = 0;
+        std::vector<float> samples;
+        ASSERT_TRUE(readReferenceFloats(tiff, width, height, samples));
+        HdrTestResult image = readHdrFile(imagePath, IMAGE_READ_FLOAT);
+        ASSERT_EQ(0, image.errorCode);
+        ASSERT_EQ(static_cast<int>(width), image.width);
+        ASSERT_EQ(static_cast<int>(height), image.height);
+        const float* f = reinterpret_cast<const float*>(image.pixels.data());
+        for (uint32_t k = 0; k < width * height; ++k)
+            for (int c = 0; c < 3; ++c) ASSERT_TRUE(f[k * 4 + c] == samples[k * 3 + c]);
+
+        image = readHdrFile(imagePath);
+        ASSERT_EQ(0, image.errorCode);
+        CKBitmapProperties refProps;
+        ASSERT_EQ(0, TIFF_Read(tiff.data(), static_cast<int>(tiff.size()), &refProps));
+        const VxImageDescEx& ref = refProps.m_Format;
+        ASSERT_TRUE(memcmp(ref.Image, image.pixels.data(), image.pixels.size()) == 0);
+        delete[] static_cast<CKBYTE*>(refProps.m_Data);
+        ++compared;
+    }
+    if (compared == 0) SKIP_TEST("HDR reference images not found");
+}
+
+TEST(HdrReader, Truncations_MustNotCrash) {
+    // Every prefix of small files in each encoding: errors are fine, crashes are not
+    RgbeImage img(10, 4, 9);
+    for (int e = 0; e < 3; ++e) {
+        std::vector<uint8_t> data = makeHdr(img, static_cast<Encoding>(e));
+        for (size_t n = 0; n <= data.size(); ++n) {
+            std::vector<uint8_t> prefix(data.begin(), data.begin() + n);
+            readHdr(prefix);
+            readHdr(prefix, IMAGE_READ_FLOAT);
+        }
+    }
+}
+
+TEST(HdrReader, Truncated_MissingPixelsAreBlack) {
+    RgbeImage img(12, 40, 10);
+    std::vector<uint8_t> data = makeHdr(img, FLAT);
+    data.resize(data.size() - 12 * 4 * 2 - 20); // last two and a half scanlines
+    HdrTestResult r = readHdr(data);
+    ASSERT_EQ(0, r.errorCode);
+    std::vector<uint8_t> expected = expectBgra(img);
+    size_t kept = (12 * 37 + 7) * 4;
+    ASSERT_TRUE(memcmp(r.pixels.data(), expected.data(), kept) == 0);
+    for (size_t k = kept; k < r.pixels.size(); ++k) ASSERT_EQ(k % 4 == 3 ? 255 : 0, r.pixels[k]);
+}
+
+//=============================================================================
+// Negative Tests
+//=============================================================================
+
+TEST(HdrReader, Negative_BadHeader) {
+    RgbeImage img(4, 4, 11);
+    ASSERT_EQ(0, readHdr(makeHdr(img, FLAT)).errorCode);
+
+    std::vector<uint8_t> bad = makeHdr(img, FLAT);
+    bad[1] = '!';
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readHdr(bad).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE,
+              readHdr(makeHdr(img, FLAT, kTopDown, "FORMAT=32-bit_rle_xyze\n")).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readHdr(makeHdr(img, FLAT, {"+X %u -Y %u", false, false})).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readHdr(makeHdr(img, FLAT, {"-Y %u *X %u", false, false})).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readHdr(makeHdr(img, FLAT, {"-Y %u +X", false, false})).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readHdr(makeHdr(RgbeImage(0, 4, 1), FLAT)).errorCode);
+
+    // Header without its end
+    std::string header = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n";
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readHdr(std::vector<uint8_t>(header.begin(), header.end())).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readHdr(std::vector<uint8_t>(1, '#')).errorCode);
+}
+
+TEST(HdrReader, Negative_CorruptRuns) {
+    RgbeImage img(16, 2, 12);
+    std::vector<uint8_t> good = makeHdr(img, NEW_RLE);
+    size_t start = good.size();
+    while (!(good[start - 4] == 2 && good[start - 3] == 2 && good[start - 1] == 16 && good[start - 2] == 0)) --start;
+    // start is just past the header of the last scanline
+
+    std::vector<uint8_t> bad = good;
+    bad[start - 1] = 15; // width mismatch
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readHdr(bad).errorCode);
+    bad = good;
+    bad[start] = 0; // zero-length literal
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readHdr(bad).errorCode);
+    bad = good;
+    bad[start] = 128 + 17; // run past the scanline
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readHdr(bad).errorCode);
+
+    // Old-style repeat with nothing to repeat
+    RgbeImage flat(4, 1, 13);
+    static const uint8_t marker[4] = {1, 1, 1, 2};
+    memcpy(flat.pixels.data(), marker, 4);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readHdr(makeHdr(flat, FLAT)).errorCode);
+    // ... and one running past the scanline
+    memcpy(flat.pixels.data() + 8, marker, 4);
+    flat.pixels[0] = 9;
+    flat.pixels[11] = 3;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readHdr(makeHdr(flat, FLAT)).errorCode);
+}
+
+TEST(HdrReader, Negative_HugeDimensionsFailFast) {
+    std::string text = "#?RADIANCE\n\n-Y 100000 +X 100000\n";
+    std::vector<uint8_t> data(text.begin(), text.end());
+    data.resize(data.size() + 64, 0x40);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readHdr(data).errorCode);
+
+    // Far more scanlines than the data could hold
+    text = "#?RADIANCE\n\n-Y 1000000 +X 16\n";
+    data.assign(text.begin(), text.end());
+    data.resize(data.size() + 64, 0x40);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readHdr(data).errorCode);
+}
@@ -0,0 +1,592 @@
+/**
+ * @file IcoReaderTests.cpp
+ * @brief ICO/CUR format tests for CKImageReader
+ *
+ * Tests cover:
+ * - Directory validation and entry selection by size and bit depth
+ * - DIB entries (AND mask as alpha, 32-bit alpha) and PNG entries
+ * - Cursors (hotspots, CurReader)
+ * - The corpus in tests/images/ico against CRCs, and the fuzzer cases in
+ *   tests/regression/ico
+ * - Malformed files (bad header, truncated table, entries out of range)
+ */
+
+#include "TestFramework.h"
+#include "IcoReader.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace TestFramework;
+
+//=============================================================================
+// Test Helpers
+//=============================================================================
+
+namespace {
+
+void putLE16(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+void putLE32(std::vector<uint8_t>& out, uint32_t v) {
+    putLE16(out, v & 0xFFFF);
+    putLE16(out, v >> 16);
+}
+
+void putBE32(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v >> 24));
+    out.push_back(static_cast<uint8_t>(v >> 16));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+// BGRA pixel of an entry, top-down order
+uint8_t pixelByte(uint32_t x, uint32_t y, int channel, int seed) {
+    return static_cast<uint8_t>(x * 17 + y * 5 + channel * 60 + seed * 29);
+}
+
+// Icon DIB: 24 or 32 bits per pixel, bottom-up, followed by the AND mask
+// (bit set where masked(x, y)). alpha fills the fourth byte of 32-bit pixels.
+std::vector<uint8_t> makeDib(uint32_t width, uint32_t height, int bitCount, int seed, int alpha,
+                             bool (*masked)(uint32_t, uint32_t)) {
+    std::vector<uint8_t> dib;
+    putLE32(dib, 40);
+    putLE32(dib, width);
+    putLE32(dib, height * 2);
+    putLE16(dib, 1);
+    putLE16(dib, bitCount);
+    for (int i = 0; i < 6; ++i) putLE32(dib, 0);
+
+    int bpp = bitCount / 8;
+    size_t stride = (width * bpp + 3) & ~3u;
+    for (uint32_t row = 0; row < height; ++row) {
+        uint32_t y = height - 1 - row;
+        std::vector<uint8_t> line(stride, 0);
+        for (uint32_t x = 0; x < width; ++x) {
+            for (int c = 0; c < 3; ++c) line[x * bpp + c] = pixelByte(x, y, c, seed);
+            if (bpp == 4) line[x * 4 + 3] = static_cast<uint8_t>(alpha);
+        }
+        dib.insert(dib.end(), line.begin(), line.end());
+    }
+
+    size_t maskStride = ((width + 31) / 32) * 4;
+    for (uint32_t row = 0; row < height; ++row) {
+        uint32_t y = height - 1 - row;
+        std::vector<uint8_t> line(maskStride, 0);
+        for (uint32_t x = 0; x < width; ++x)
+            if (masked && masked(x, y)) line[x / 8] |= static_cast<uint8_t>(0x80 >> (x & 7));
+        dib.insert(dib.end(), line.begin(), line.end());
+    }
+    return dib;
+}
+
+bool checkerMask(uint32_t x, uint32_t y) { return ((x + y) & 1) != 0; }
+
+// RGBA8 PNG with stored deflate blocks
+std::vector<uint8_t> makePng(uint32_t width, uint32_t height, int seed) {
+    std::vector<uint8_t> raw;
+    for (uint32_t y = 0; y < height; ++y) {
+        raw.push_back(0);
+        for (uint32_t x = 0; x < width; ++x) {
+            raw.push_back(pixelByte(x, y, 2, seed));
+            raw.push_back(pixelByte(x, y, 1, seed));
+            raw.push_back(pixelByte(x, y, 0, seed));
+            raw.push_back(static_cast<uint8_t>(x * 8));
+        }
+    }
+    std::vector<uint8_t> z;
+    z.push_back(0x78);
+    z.push_back(0x01);
+    for (size_t pos = 0; pos == 0 || pos < raw.size(); pos += 65535) {
+        size_t n = std::min<size_t>(65535, raw.size() - pos);
+        z.push_back(pos + n == raw.size() ? 1 : 0);
+        putLE16(z, static_cast<uint32_t>(n));
+        putLE16(z, static_cast<uint32_t>(~n & 0xFFFF));
+        z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + n);
+    }
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < raw.size(); ++i) {
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    putBE32(z, (b << 16) | a);
+
+    std::vector<uint8_t> png;
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+    png.insert(png.end(), signature, signature + 8);
+    struct Chunk {
+        static void put(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+            putBE32(out, static_cast<uint32_t>(data.size()));
+            std::vector<uint8_t> body(type, type + 4);
+            body.insert(body.end(), data.begin(), data.end());
+            out.insert(out.end(), body.begin(), body.end());
+            putBE32(out, CRC32::compute(body.data(), body.size()));
+        }
+    };
+    std::vector<uint8_t> ihdr;
+    putBE32(ihdr, width);
+    putBE32(ihdr, height);
+    ihdr.push_back(8);
+    ihdr.push_back(6);
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    Chunk::put(png, "IHDR", ihdr);
+    Chunk::put(png, "IDAT", z);
+    Chunk::put(png, "IEND", std::vector<uint8_t>());
+    return png;
+}
+
+struct EntrySpec {
+    uint32_t width;
+    uint32_t height;
+    uint32_t planes;   // hotspot x in cursors
+    uint32_t bitCount; // hotspot y in cursors
+    std::vector<uint8_t> image;
+
+    EntrySpec(uint32_t w, uint32_t h, uint32_t p, uint32_t bc, const std::vector<uint8_t>& img)
+        : width(w), height(h), planes(p), bitCount(bc), image(img) {}
+};
+
+std::vector<uint8_t> makeIco(const std::vector<EntrySpec>& entries, uint32_t type = ICO_TYPE_ICON) {
+    std::vector<uint8_t> ico;
+    putLE16(ico, 0);
+    putLE16(ico, type);
+    putLE16(ico, static_cast<uint32_t>(entries.size()));
+    uint32_t offset = static_cast<uint32_t>(ICO_HEADER_SIZE + entries.size() * ICO_ENTRY_SIZE);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const EntrySpec& e = entries[i];
+        ico.push_back(static_cast<uint8_t>(e.width & 0xFF));
+        ico.push_back(static_cast<uint8_t>(e.height & 0xFF));
+        ico.push_back(0);
+        ico.push_back(0);
+        putLE16(ico, e.planes);
+        putLE16(ico, e.bitCount);
+        putLE32(ico, static_cast<uint32_t>(e.image.size()));
+        putLE32(ico, offset);
+        offset += static_cast<uint32_t>(e.image.size());
+    }
+    for (size_t i = 0; i < entries.size(); ++i) ico.insert(ico.end(), entries[i].image.begin(), entries[i].image.end());
+    return ico;
+}
+
+struct IcoTestResult {
+    int errorCode;
+    int width;
+    int height;
+    std::vector<uint8_t> pixels; // tightly packed BGRA rows
+    CKDWORD entryCount;
+    CKDWORD entryIndex;
+};
+
+template <typename Reader>
+IcoTestResult readWith(const std::vector<uint8_t>& data, CKDWORD size = 0, CKDWORD bitDepth = 0) {
+    IcoTestResult result;
+    Reader reader;
+    reader.SetPreferredEntry(size, bitDepth);
+    CKBitmapProperties* props = nullptr;
+    result.errorCode = reader.ReadMemory(const_cast<uint8_t*>(data.data()), static_cast<int>(data.size()), &props);
+    result.width = 0;
+    result.height = 0;
+    result.entryCount = 0;
+    result.entryIndex = 0;
+    if (result.errorCode == 0 && props && props->m_Format.Image) {
+        const VxImageDescEx& fmt = props->m_Format;
+        result.width = fmt.Width;
+        result.height = fmt.Height;
+        for (int y = 0; y < fmt.Height; ++y) {
+            const uint8_t* row = fmt.Image + y * fmt.BytesPerLine;
+            result.pixels.insert(result.pixels.end(), row, row + fmt.Width * 4);
+        }
+        result.entryCount = reinterpret_cast<IcoBitmapProperties*>(props)->m_EntryCount;
+        result.entryIndex = reinterpret_cast<IcoBitmapProperties*>(props)->m_EntryIndex;
+    }
+    return result;
+}
+
+IcoTestResult readIco(const std::vector<uint8_t>& data, CKDWORD size = 0, CKDWORD bitDepth = 0) {
+    return readWith<IcoReader>(data, size, bitDepth);
+}
+
+IcoTestResult readIcoFile(const std::string& path, CKDWORD size = 0, CKDWORD bitDepth = 0) {
+    return readIco(readBinaryFile(path), size, bitDepth);
+}
+
+std::string icoImagesDir() {
+    return joinPath(joinPath(g_TestImagesDir, "ico"), "images");
+}
+
+// Entry sizes 16, 32 and 48 at 24 and 32 bits per pixel, seeded by position
+std::vector<uint8_t> makeSelectionIco() {
+    std::vector<EntrySpec> entries;
+    static const uint32_t sizes[] = {16, 32, 48};
+    for (int i = 0; i < 3; ++i) {
+        entries.push_back(EntrySpec(sizes[i], sizes[i], 1, 24, makeDib(sizes[i], sizes[i], 24, i * 2, 0, nullptr)));
+        entries.push_back(EntrySpec(sizes[i], sizes[i], 1, 32, makeDib(sizes[i], sizes[i], 32, i * 2 + 1, 255, nullptr)));
+    }
+    return makeIco(entries);
+}
+
+} // anonymous namespace
+
+//=============================================================================
+// Directory Tests
+//=============================================================================
+
+TEST(IcoReader, Index_ReadsEntries) {
+    std::vector<uint8_t> ico = makeSelectionIco();
+    IcoDirectory dir;
+    ASSERT_EQ(0, ICO_Index(ico.data(), static_cast<int>(ico.size()), dir));
+    ASSERT_EQ(6u, dir.entryCount);
+    ASSERT_EQ(static_cast<CKDWORD>(ICO_TYPE_ICON), dir.type);
+
+    IcoEntry entry;
+    ASSERT_EQ(0, ICO_Entry(dir, 3, entry));
+    ASSERT_EQ(32u, entry.width);
+    ASSERT_EQ(32u, entry.height);
+    ASSERT_EQ(32u, entry.bitDepth);
+    ASSERT_FALSE(entry.png);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, ICO_Entry(dir, 6, entry));
+}
+
+TEST(IcoReader, Index_TableMustFit) {
+    std::vector<uint8_t> ico = makeSelectionIco();
+    IcoDirectory dir;
+    // A count far beyond the file is rejected from the header alone
+    ico[4] = 0xFF;
+    ico[5] = 0xFF;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, ICO_Index(ico.data(), static_cast<int>(ico.size()), dir));
+    ico[4] = 0;
+    ico[5] = 0;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, ICO_Index(ico.data(), static_cast<int>(ico.size()), dir));
+}
+
+TEST(IcoReader, Index_EntryOutOfRange) {
+    std::vector<uint8_t> ico = makeSelectionIco();
+    IcoDirectory dir;
+    ASSERT_EQ(0, ICO_Index(ico.data(), static_cast<int>(ico.size()), dir));
+
+    // Size running past the end, offset inside the table
+    std::vector<uint8_t> bad = ico;
+    bad[ICO_HEADER_SIZE + 8 + 3] = 0x7F;
+    ASSERT_EQ(0, ICO_Index(bad.data(), static_cast<int>(bad.size()), dir));
+    IcoEntry entry;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, ICO_Entry(dir, 0, entry));
+    bad = ico;
+    bad[ICO_HEADER_SIZE + ICO_ENTRY_SIZE + 12] = 2;
+    bad[ICO_HEADER_SIZE + ICO_ENTRY_SIZE + 13] = 0;
+    ASSERT_EQ(0, ICO_Index(bad.data(), static_cast<int>(bad.size()), dir));
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, ICO_Entry(dir, 1, entry));
+
+    // Broken entries are skipped when choosing one
+    ASSERT_EQ(0u, ICO_BestEntry(dir, 16, 32));
+}
+
+TEST(IcoReader, BestEntry_SizeAndDepth) {
+    std::vector<uint8_t> ico = makeSelectionIco();
+    IcoDirectory dir;
+    ASSERT_EQ(0, ICO_Index(ico.data(), static_cast<int>(ico.size()), dir));
+
+    ASSERT_EQ(5u, ICO_BestEntry(dir, 0, 0));   // largest, deepest
+    ASSERT_EQ(3u, ICO_BestEntry(dir, 32, 0));  // exact size
+    ASSERT_EQ(2u, ICO_BestEntry(dir, 32, 24)); // exact size and depth
+    ASSERT_EQ(2u, ICO_BestEntry(dir, 32, 30)); // deepest not above 30
+    ASSERT_EQ(0u, ICO_BestEntry(dir, 16, 8));  // nothing that shallow: shallowest
+    ASSERT_EQ(3u, ICO_BestEntry(dir, 24, 32)); // tie between 16 and 32: larger
+    ASSERT_EQ(5u, ICO_BestEntry(dir, 256, 0)); // above every entry: largest
+    ASSERT_EQ(1u, ICO_BestEntry(dir, 1, 0));   // below every entry: smallest
+}
+
+TEST(IcoReader, BestEntry_FirstOfEqualEntries) {
+    std::vector<EntrySpec> entries;
+    entries.push_back(EntrySpec(8, 8, 1, 32, makeDib(8, 8, 32, 1, 255, nullptr)));
+    entries.push_back(EntrySpec(8, 8, 1, 32, makeDib(8, 8, 32, 2, 255, nullptr)));
+    IcoTestResult r = readIco(makeIco(entries));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(2u, r.entryCount);
+    ASSERT_EQ(0u, r.entryIndex);
+    ASSERT_EQ(pixelByte(0, 0, 0, 1), r.pixels[0]);
+}
+
+TEST(IcoReader, ReadsOnlyTheChosenEntry) {
+    // Entries that would fail to decode do not matter unless they are chosen
+    std::vector<EntrySpec> entries;
+    std::vector<uint8_t> broken = makeDib(32, 32, 32, 0, 255, nullptr);
+    broken[12] = 0; // planes
+    entries.push_back(EntrySpec(32, 32, 1, 32, broken));
+    entries.push_back(EntrySpec(16, 16, 1, 32, makeDib(16, 16, 32, 3, 255, nullptr)));
+    std::vector<uint8_t> ico = makeIco(entries);
+
+    IcoTestResult r = readIco(ico, 16);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(1u, r.entryIndex);
+    ASSERT_EQ(16, r.width);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readIco(ico, 32).errorCode);
+}
+
+//=============================================================================
+// Decoding Tests
+//=============================================================================
+
+TEST(IcoReader, Dib24_MaskBecomesAlpha) {
+    std::vector<EntrySpec> entries;
+    entries.push_back(EntrySpec(13, 7, 1, 24, makeDib(13, 7, 24, 4, 0, checkerMask)));
+    IcoTestResult r = readIco(makeIco(entries));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(13, r.width);
+    ASSERT_EQ(7, r.height);
+    for (uint32_t y = 0; y < 7; ++y) {
+        for (uint32_t x = 0; x < 13; ++x) {
+            const uint8_t* p = &r.pixels[(y * 13 + x) * 4];
+            ASSERT_EQ(pixelByte(x, y, 0, 4), p[0]);
+            ASSERT_EQ(pixelByte(x, y, 2, 4), p[2]);
+            ASSERT_EQ(checkerMask(x, y) ? 0 : 255, static_cast<int>(p[3]));
+        }
+    }
+}
+
+TEST(IcoReader, Dib32_KeepsAlpha) {
+    std::vector<EntrySpec> entries;
+    entries.push_back(EntrySpec(9, 9, 1, 32, makeDib(9, 9, 32, 5, 0x80, checkerMask)));
+    IcoTestResult r = readIco(makeIco(entries));
+    ASSERT_EQ(0, r.errorCode);
+    for (size_t i = 0; i < r.pixels.size(); i += 4) ASSERT_EQ(0x80, static_cast<int>(r.pixels[i + 3]));
+    ASSERT_EQ(pixelByte(3, 2, 1, 5), r.pixels[(2 * 9 + 3) * 4 + 1]);
+}
+
+TEST(IcoReader, Dib32_ZeroAlphaUsesMask) {
+    std::vector<EntrySpec> entries;
+    entries.push_back(EntrySpec(9, 9, 1, 32, makeDib(9, 9, 32, 5, 0, checkerMask)));
+    IcoTestResult r = readIco(makeIco(entries));
+    ASSERT_EQ(0, r.errorCode);
+    for (uint32_t y = 0; y < 9; ++y)
+        for (uint32_t x = 0; x < 9; ++x)
+            ASSERT_EQ(checkerMask(x, y) ? 0 : 255, static_cast<int>(r.pixels[(y * 9 + x) * 4 + 3]));
+}
+
+TEST(IcoReader, Dib_MissingMaskIsOpaque) {
+    std::vector<uint8_t> dib = makeDib(8, 8, 24, 6, 0, checkerMask);
+    dib.resize(dib.size() - 8 * 4);
+    std::vector<EntrySpec> entries;
+    entries.push_back(EntrySpec(8, 8, 1, 24, dib));
+    IcoTestResult r = readIco(makeIco(entries));
+    ASSERT_EQ(0, r.errorCode);
+    for (size_t i = 0; i < r.pixels.size(); i += 4) ASSERT_EQ(255, static_cast<int>(r.pixels[i + 3]));
+}
+
+TEST(IcoReader, Dib_TruncatedColorBitmap) {
+    std::vector<uint8_t> dib = makeDib(8, 8, 24, 6, 0, nullptr);
+    dib.resize(40 + 8 * 24 - 1);
+    std::vector<EntrySpec> entries;
+    entries.push_back(EntrySpec(8, 8, 1, 24, dib));
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readIco(makeIco(entries)).errorCode);
+}
+
+TEST(IcoReader, Png_Entry) {
+    std::vector<EntrySpec> entries;
+    entries.push_back(EntrySpec(16, 16, 1, 32, makeDib(16, 16, 32, 1, 255, nullptr)));
+    entries.push_back(EntrySpec(20, 12, 1, 32, makePng(20, 12, 7)));
+    IcoTestResult r = readIco(makeIco(entries));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(1u, r.entryIndex);
+    ASSERT_EQ(20, r.width);
+    ASSERT_EQ(12, r.height);
+    for (uint32_t y = 0; y < 12; ++y) {
+        for (uint32_t x = 0; x < 20; ++x) {
+            const uint8_t* p = &r.pixels[(y * 20 + x) * 4];
+            ASSERT_EQ(pixelByte(x, y, 0, 7), p[0]);
+            ASSERT_EQ(pixelByte(x, y, 2, 7), p[2]);
+            ASSERT_EQ(static_cast<int>(x * 8), static_cast<int>(p[3]));
+        }
+    }
+}
+
+TEST(IcoReader, Png_Entry256AndLarger) {
+    // 0 in the directory stands for 256 or more
+    std::vector<EntrySpec> entries;
+    entries.push_back(EntrySpec(0, 0, 1, 32, makePng(300, 256, 1)));
+    IcoTestResult r = readIco(makeIco(entries));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(300, r.width);
+    ASSERT_EQ(256, r.height);
+}
+
+TEST(IcoReader, Png_SizeMustMatchDirectory) {
+    std::vector<EntrySpec> entries;
+    entries.push_back(EntrySpec(16, 16, 1, 32, makePng(16, 17, 1)));
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readIco(makeIco(entries)).errorCode);
+    entries[0] = EntrySpec(0, 16, 1, 32, makePng(255, 16, 1));
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readIco(makeIco(entries)).errorCode);
+}
+
+TEST(IcoReader, Png_HugeDimensionsFailFast) {
+    // Far more pixels than deflate can expand the entry to
+    std::vector<uint8_t> png = makePng(4, 4, 1);
+    png[18] = 0x04; // 1024 x 1024
+    png[19] = 0x00;
+    png[22] = 0x04;
+    png[23] = 0x00;
+    std::vector<EntrySpec> entries;
+    entries.push_back(EntrySpec(0, 0, 1, 32, png));
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readIco(makeIco(entries)).errorCode);
+}
+
+//=============================================================================
+// Cursor Tests
+//=============================================================================
+
+TEST(IcoReader, Cursor_Hotspot) {
+    std::vector<EntrySpec> entries;
+    entries.push_back(EntrySpec(16, 16, 3, 11, makeDib(16, 16, 32, 2, 255, nullptr)));
+    std::vector<uint8_t> cur = makeIco(entries, ICO_TYPE_CURSOR);
+
+    IcoDirectory dir;
+    ASSERT_EQ(0, ICO_Index(cur.data(), static_cast<int>(cur.size()), dir));
+    IcoEntry entry;
+    ASSERT_EQ(0, ICO_Entry(dir, 0, entry));
+    ASSERT_EQ(3u, entry.hotspotX);
+    ASSERT_EQ(11u, entry.hotspotY);
+    ASSERT_EQ(32u, entry.bitDepth);
+
+    IcoTestResult r = readWith<CurReader>(cur);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(16, r.width);
+    ASSERT_EQ(pixelByte(0, 0, 0, 2), r.pixels[0]);
+}
+
+//=============================================================================
+// Corpus Tests
+//=============================================================================
+
+TEST(IcoReader, Corpus_ReferenceCrcs) {
+    std::vector<std::string> files = collectFilesWithExtensions(icoImagesDir(), {".ico"});
+    int checked = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        uint32_t crc = 0;
+        if (!getReferenceCrc("ico/" + files[i], crc)) continue;
+        IcoTestResult r = readIcoFile(joinPath(icoImagesDir(), files[i]));
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_CRC(crc, r.pixels.data(), r.pixels.size());
+        ++checked;
+    }
+    if (checked == 0) SKIP_TEST("ICO corpus or reference CRCs not found");
+}
+
+TEST(IcoReader, Corpus_EntrySelection) {
+    std::string path = joinPath(icoImagesDir(), "multiple_entries_with_different_bit_depth.ico");
+    if (!fileExists(path)) SKIP_TEST("multiple_entries_with_different_bit_depth.ico not found");
+    std::vector<uint8_t> data = readBinaryFile(path);
+    IcoDirectory dir;
+    ASSERT_EQ(0, ICO_Index(data.data(), static_cast<int>(data.size()), dir));
+
+    // Every valid entry decodes at its directory size, and asking for exactly
+    // its size and depth picks an entry with both
+    for (CKDWORD i = 0; i < dir.entryCount; ++i) {
+        IcoEntry entry;
+        ASSERT_EQ(0, ICO_Entry(dir, i, entry));
+        IcoTestResult r = readIco(data, entry.width, entry.bitDepth);
+        ASSERT_EQ(0, r.errorCode);
+        IcoEntry chosen;
+        ASSERT_EQ(0, ICO_Entry(dir, r.entryIndex, chosen));
+        ASSERT_EQ(entry.width, chosen.width);
+        ASSERT_EQ(entry.bitDepth, chosen.bitDepth);
+        ASSERT_EQ(static_cast<int>(entry.width), r.width);
+        ASSERT_EQ(static_cast<int>(entry.height), r.height);
+    }
+}
+
+TEST(IcoReader, Corpus_BadImageLength) {
+    std::string path = joinPath(icoImagesDir(), "Bad_smile-incorrect-image-length.bad_ico");
+    if (!fileExists(path)) SKIP_TEST("Bad_smile-incorrect-image-length.bad_ico not found");
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readIcoFile(path).errorCode);
+}
+
+TEST(IcoReader, RegressionCorpus_FailFast) {
+    // Fuzzer cases: oversized directories and images must be rejected before
+    // anything is allocated for them
+    std::string regDir = joinPath(joinPath(g_TestReferenceDir, ".."), "regression/ico");
+    if (!directoryExists(regDir)) SKIP_TEST("ICO regression directory not found");
+    std::vector<std::string> files = collectFilesWithExtensions(regDir, {".ico"});
+    if (files.empty()) SKIP_TEST("No ICO regression files found");
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        IcoTestResult r = readIcoFile(joinPath(regDir, files[i]));
+        ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, r.errorCode);
+    }
+}
+
+TEST(IcoReader, Truncations_MustNotCrash) {
+    std::string path = joinPath(icoImagesDir(), "smile.ico");
+    if (!fileExists(path)) SKIP_TEST("smile.ico not found");
+    std::vector<uint8_t> data = readBinaryFile(path);
+    for (size_t n = 0; n <= data.size(); ++n) {
+        std::vector<uint8_t> prefix(data.begin(), data.begin() + n);
+        readIco(prefix);
+        readIco(prefix, 16, 4);
+    }
+}
+
+//=============================================================================
+// Negative Tests
+//=============================================================================
+
+TEST(IcoReader, Negative_BadHeader) {
+    std::vector<uint8_t> ico = makeSelectionIco();
+    ico[2] = 3; // neither icon nor cursor
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readIco(ico).errorCode);
+    ico[2] = 1;
+    ico[0] = 1; // reserved
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readIco(ico).errorCode);
+    ico.resize(5);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readIco(ico).errorCode);
+}
+
+TEST(IcoReader, Negative_CompressedDib) {
+    std::vector<uint8_t> dib = makeDib(8, 8, 24, 1, 0, nullptr);
+    dib[16] = 1; // BI_RLE8
+    std::vector<EntrySpec> entries;
+    entries.push_back(EntrySpec(8, 8, 1, 24, dib));
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readIco(makeIco(entries)).errorCode);
+}
+
+//=============================================================================
+// Reader Interface Tests
+//=============================================================================
+
+TEST(IcoReader, GetReaderInfo) {
+    IcoReader ico;
+    CKPluginInfo* info = ico.GetReaderInfo();
+    ASSERT_TRUE(info != nullptr);
+    ASSERT_GUID_EQ(ICOREADER_GUID, info->m_GUID);
+    ASSERT_EQ(static_cast<int>(CKPLUGIN_BITMAP_READER), static_cast<int>(info->m_Type));
+
+    CurReader cur;
+    info = cur.GetReaderInfo();
+    ASSERT_TRUE(info != nullptr);
+    ASSERT_GUID_EQ(CURREADER_GUID, info->m_GUID);
+}
+
+TEST(IcoReader, ReadOnly) {
+    IcoReader reader;
+    IcoBitmapProperties props;
+    ASSERT_EQ(0, reader.SaveFile(const_cast<char*>("out.ico"), &props));
+    void* memory = nullptr;
+    ASSERT_EQ(0, reader.SaveMemory(&memory, &props));
+    ASSERT_TRUE(memory == nullptr);
+}
+
+TEST(IcoReader, PreferredEntry) {
+    IcoReader reader;
+    ASSERT_EQ(0u, reader.GetPreferredSize());
+    ASSERT_EQ(0u, reader.GetPreferredBitDepth());
+    reader.SetPreferredEntry(32, 8);
+    ASSERT_EQ(32u, reader.GetPreferredSize());
+    ASSERT_EQ(8u, reader.GetPreferredBitDepth());
+
+    IcoTestResult r = readIco(makeSelectionIco(), 48, 24);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(6u, r.entryCount);
+    ASSERT_EQ(4u, r.entryIndex);
+    ASSERT_EQ(48, r.width);
+}
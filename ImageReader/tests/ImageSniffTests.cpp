@@ -0,0 +1,294 @@
+/**
+ * @file ImageSniffTests.cpp
+ * @brief Format sniffing and dispatch tests for CKImageReader
+ *
+ * Tests cover:
+ * - ImageSniffFormat on the corpus of every format, short data and unknown data
+ * - Misnamed files and memory blocks read through another format's reader
+ * - Extended properties of the calling reader left untouched by another format
+ * - Files without a known signature still reported by the reader's own checks
+ * - Data matching another signature by chance still read by the reader's own format
+ */
+
+#include "TestFramework.h"
+#include "ImageSniff.h"
+#include "BmpReader.h"
+#include "TgaReader.h"
+#include "PngReader.h"
+#include "JpegReader.h"
+#include "IcoReader.h"
+#include "PnmReader.h"
+#include <cstring>
+
+using namespace TestFramework;
+
+//=============================================================================
+// Test Helpers
+//=============================================================================
+
+namespace {
+
+struct SniffResult {
+    int errorCode;
+    int width;
+    int height;
+    std::vector<uint8_t> pixels; // tightly packed BGRA32 rows
+};
+
+SniffResult collect(int errorCode, CKBitmapProperties* props) {
+    SniffResult result;
+    result.errorCode = errorCode;
+    result.width = 0;
+    result.height = 0;
+    if (errorCode == 0 && props && props->m_Format.Image) {
+        const VxImageDescEx& fmt = props->m_Format;
+        result.width = fmt.Width;
+        result.height = fmt.Height;
+        for (int y = 0; y < fmt.Height; ++y) {
+            const uint8_t* row = fmt.Image + y * fmt.BytesPerLine;
+            result.pixels.insert(result.pixels.end(), row, row + fmt.Width * 4);
+        }
+    }
+    if (errorCode == 0)
+        ImageReader::FreeBitmapData(props);
+    return result;
+}
+
+SniffResult readMemory(CKBitmapReader& reader, const std::vector<uint8_t>& data) {
+    CKBitmapProperties* props = nullptr;
+    int error = reader.ReadMemory(const_cast<uint8_t*>(data.data()), static_cast<int>(data.size()), &props);
+    return collect(error, props);
+}
+
+SniffResult readFile(CKBitmapReader& reader, const std::string& path) {
+    CKBitmapProperties* props = nullptr;
+    int error = reader.ReadFile(const_cast<char*>(path.c_str()), &props);
+    return collect(error, props);
+}
+
+int sniffFile(const std::string& path) {
+    std::vector<uint8_t> data = readBinaryFile(path);
+    return ImageSniffFormat(data.data(), static_cast<CKDWORD>(data.size()));
+}
+
+// Copies a test image to the output directory under another name
+std::string copyAs(const std::string& source, const std::string& name) {
+    std::vector<uint8_t> data = readBinaryFile(source);
+    std::string path = joinPath(g_TestOutputDir, name);
+    writeBinaryFile(path, data.data(), data.size());
+    return path;
+}
+
+std::string imagePath(const char* dir, const char* subdir, const char* file) {
+    std::string path = joinPath(g_TestImagesDir, dir);
+    if (subdir) path = joinPath(path, subdir);
+    return joinPath(path, file);
+}
+
+} // namespace
+
+//=============================================================================
+// Sniffing
+//=============================================================================
+
+TEST(ImageSniff, Corpus_EveryFormat) {
+    struct Corpus {
+        const char* dir;
+        const char* subdir;
+        const char* ext;
+        int expected;
+    };
+    const Corpus corpora[] = {
+        {"bmp", "images", ".bmp", READER_INDEX_BMP},
+        {"tga", "testsuite", ".tga", READER_INDEX_TGA},
+        {"pcx", nullptr, ".pcx", READER_INDEX_PCX},
+        {"qoi", nullptr, ".qoi", READER_INDEX_QOI},
+        {"png", "16bpc", ".png", READER_INDEX_PNG},
+        {"jpg", "progressive", ".jpg", READER_INDEX_JPEG},
+        {"gif", "simple", ".gif", READER_INDEX_GIF},
+        {"ico", "images", ".ico", READER_INDEX_ICO},
+        {"tiff", "testsuite", ".tiff", READER_INDEX_TIFF},
+        {"hdr", "images", ".hdr", READER_INDEX_HDR},
+        {"exr", nullptr, ".exr", READER_INDEX_EXR},
+        {"webp", "extended_images", ".webp", READER_INDEX_WEBP},
+        {"pbm", "images", ".pbm", READER_INDEX_PNM},
+        {"farbfeld", "transparency", ".ff", READER_INDEX_FARBFELD},
+        {"dds", nullptr, ".dds", READER_INDEX_DDS},
+    };
+    int checked = 0;
+    for (size_t c = 0; c < sizeof(corpora) / sizeof(corpora[0]); ++c) {
+        std::string dir = joinPath(g_TestImagesDir, corpora[c].dir);
+        if (corpora[c].subdir) dir = joinPath(dir, corpora[c].subdir);
+        std::vector<std::string> files = collectFilesWithExtensions(dir, {corpora[c].ext});
+        for (size_t i = 0; i < files.size(); ++i) {
+            int sniffed = sniffFile(joinPath(dir, files[i]));
+            if (sniffed != corpora[c].expected) failTest("Sniffed " + std::to_string(sniffed) + " for " + files[i]);
+            ASSERT_EQ(corpora[c].expected, sniffed);
+            ++checked;
+        }
+    }
+    if (checked == 0) SKIP_TEST("Test images not found");
+}
+
+TEST(ImageSniff, SignaturesAndLimits) {
+    const uint8_t dcx[] = {0xB1, 0x68, 0xDE, 0x3A, 0x10, 0x10, 0, 0};
+    ASSERT_EQ(READER_INDEX_DCX, ImageSniffFormat(dcx, sizeof(dcx)));
+    const uint8_t ktx2[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+    ASSERT_EQ(READER_INDEX_KTX, ImageSniffFormat(ktx2, sizeof(ktx2)));
+    // Icons need a first entry inside the file, after the directory
+    uint8_t cur[22 + 26] = {0, 0, 2, 0, 1, 0};
+    cur[6 + 8] = 26;
+    cur[6 + 12] = 22;
+    ASSERT_EQ(READER_INDEX_ICO, ImageSniffFormat(cur, sizeof(cur)));
+    ASSERT_EQ(IMAGE_SNIFF_UNKNOWN, ImageSniffFormat(cur, sizeof(cur) - 1));
+    cur[6 + 12] = 21;
+    ASSERT_EQ(IMAGE_SNIFF_UNKNOWN, ImageSniffFormat(cur, sizeof(cur)));
+    const uint8_t pam[] = {'P', '7', '\n'};
+    ASSERT_EQ(READER_INDEX_PNM, ImageSniffFormat(pam, sizeof(pam)));
+
+    // Signatures cut short, and data matching none
+    const uint8_t png[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+    ASSERT_EQ(READER_INDEX_PNG, ImageSniffFormat(png, 8));
+    ASSERT_EQ(IMAGE_SNIFF_UNKNOWN, ImageSniffFormat(png, 7));
+    ASSERT_EQ(IMAGE_SNIFF_UNKNOWN, ImageSniffFormat(ktx2, 11));
+    ASSERT_EQ(IMAGE_SNIFF_UNKNOWN, ImageSniffFormat(nullptr, 100));
+    ASSERT_EQ(IMAGE_SNIFF_UNKNOWN, ImageSniffFormat(png, 0));
+    uint8_t bmp[18] = {'B', 'M'};
+    bmp[14] = 20; // neither a core nor an info header
+    ASSERT_EQ(IMAGE_SNIFF_UNKNOWN, ImageSniffFormat(bmp, sizeof(bmp)));
+    bmp[14] = 40;
+    ASSERT_EQ(READER_INDEX_BMP, ImageSniffFormat(bmp, sizeof(bmp)));
+    const uint8_t p8[] = {'P', '8', '\n'};
+    ASSERT_EQ(IMAGE_SNIFF_UNKNOWN, ImageSniffFormat(p8, sizeof(p8)));
+
+    std::string hook = imagePath("hook", nullptr, "extension.MoCkHoOk");
+    if (fileExists(hook)) ASSERT_EQ(IMAGE_SNIFF_UNKNOWN, sniffFile(hook));
+
+    // TGA: a plausible header only; a zero width or an unknown type is not
+    uint8_t tga[18] = {0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4, 0, 4, 0, 32, 8};
+    ASSERT_EQ(READER_INDEX_TGA, ImageSniffFormat(tga, sizeof(tga)));
+    tga[12] = 0;
+    ASSERT_EQ(IMAGE_SNIFF_UNKNOWN, ImageSniffFormat(tga, sizeof(tga)));
+    tga[12] = 4;
+    tga[2] = 4;
+    ASSERT_EQ(IMAGE_SNIFF_UNKNOWN, ImageSniffFormat(tga, sizeof(tga)));
+}
+
+//=============================================================================
+// Dispatch
+//=============================================================================
+
+TEST(ImageSniff, MisnamedFileReadOnce) {
+    // A TGA saved as .bmp reads as the TGA reader reads it
+    std::string tgaPath = imagePath("tga", "testsuite", "ctc24.tga");
+    if (!fileExists(tgaPath)) SKIP_TEST("TGA test image not found");
+    TgaReader tgaReader;
+    SniffResult expected = readFile(tgaReader, tgaPath);
+    ASSERT_EQ(0, expected.errorCode);
+
+    BmpReader bmpReader;
+    SniffResult actual = readFile(bmpReader, copyAs(tgaPath, "misnamed_tga.bmp"));
+    ASSERT_EQ(0, actual.errorCode);
+    ASSERT_EQ(expected.width, actual.width);
+    ASSERT_EQ(expected.height, actual.height);
+    ASSERT_TRUE(expected.pixels == actual.pixels);
+
+    // And a PNG saved as .jpg, read from memory
+    std::string pngPath = imagePath("png", "16bpc", "basn6a16.png");
+    if (!fileExists(pngPath)) return;
+    PngReader pngReader;
+    expected = readFile(pngReader, pngPath);
+    JpegReader jpegReader;
+    actual = readMemory(jpegReader, readBinaryFile(pngPath));
+    ASSERT_EQ(0, actual.errorCode);
+    ASSERT_TRUE(expected.pixels == actual.pixels);
+}
+
+TEST(ImageSniff, ExtendedPropertiesUntouched) {
+    std::string pngPath = imagePath("png", "16bpc", "basn6a16.png");
+    if (!fileExists(pngPath)) SKIP_TEST("PNG test image not found");
+
+    // PNG properties share the size of TGA properties but not their meaning
+    TgaReader reader;
+    CKBitmapProperties* props = nullptr;
+    std::vector<uint8_t> data = readBinaryFile(pngPath);
+    ASSERT_EQ(0, reader.ReadMemory(data.data(), static_cast<int>(data.size()), &props));
+    TgaBitmapProperties* tgaProps = reinterpret_cast<TgaBitmapProperties*>(props);
+    ASSERT_EQ(static_cast<int>(sizeof(TgaBitmapProperties)), tgaProps->m_Size);
+    ASSERT_EQ(24u, tgaProps->m_BitDepth);
+    ASSERT_EQ(0u, tgaProps->m_UseRLE);
+    ASSERT_EQ(32, props->m_Format.Width);
+    ImageReader::FreeBitmapData(props);
+
+    // Readers sharing a format keep their own properties and options
+    std::vector<uint8_t> ppm = {'P', '6', ' ', '1', ' ', '1', ' ', '2', '5', '5', '\n', 10, 20, 30};
+    PbmReader pbm;
+    ASSERT_EQ(0, pbm.ReadMemory(ppm.data(), static_cast<int>(ppm.size()), &props));
+    ASSERT_EQ(6u, reinterpret_cast<PnmBitmapProperties*>(props)->m_PnmFormat);
+    ASSERT_EQ(255u, reinterpret_cast<PnmBitmapProperties*>(props)->m_MaxValue);
+    ImageReader::FreeBitmapData(props);
+}
+
+TEST(ImageSniff, FailedSniffFallsBackToOwnReader) {
+    // A 2x2 TGA without a color map but with a nonzero color map length:
+    // bytes 0-5 read as an icon directory of 256 entries, but the first entry
+    // does not point past the directory
+    std::vector<uint8_t> small = {0, 0, 2, 0, 0, 1, 0, 0, 0, 0, 0, 0, 2, 0, 2, 0, 24, 0x20};
+    for (int i = 0; i < 2 * 2 * 3; ++i) small.push_back(static_cast<uint8_t>(i * 20));
+    ASSERT_EQ(READER_INDEX_TGA, ImageSniffFormat(small.data(), static_cast<CKDWORD>(small.size())));
+
+    // An 800x700 16-bit TGA whose header and first pixels also make a valid
+    // first entry: size 0x001002BC (height, depth) at offset 4102 (the first
+    // pixel). The entry's image is not an icon, so the icon reader fails and
+    // the TGA reader reads it.
+    std::vector<uint8_t> tga = {0, 0, 2, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0x20, 0x03, 0xBC, 0x02, 16, 0};
+    tga.resize(18 + 800 * 700 * 2, 0);
+    tga[18] = 0x06;
+    tga[19] = 0x10;
+    ASSERT_EQ(READER_INDEX_ICO, ImageSniffFormat(tga.data(), static_cast<CKDWORD>(tga.size())));
+
+    std::vector<uint8_t> clean = tga;
+    clean[5] = 0;
+    ASSERT_EQ(READER_INDEX_TGA, ImageSniffFormat(clean.data(), static_cast<CKDWORD>(clean.size())));
+    TgaReader reader;
+    SniffResult expected = readMemory(reader, clean);
+    ASSERT_EQ(0, expected.errorCode);
+
+    SniffResult actual = readMemory(reader, tga);
+    ASSERT_EQ(0, actual.errorCode);
+    ASSERT_EQ(800, actual.width);
+    ASSERT_EQ(700, actual.height);
+    ASSERT_TRUE(expected.pixels == actual.pixels);
+
+    std::string path = joinPath(g_TestOutputDir, "ico_like.tga");
+    writeBinaryFile(path, tga.data(), tga.size());
+    actual = readFile(reader, path);
+    ASSERT_EQ(0, actual.errorCode);
+    ASSERT_TRUE(expected.pixels == actual.pixels);
+
+    // Readers of neither format still report the failed read
+    BmpReader bmpReader;
+    ASSERT_NE(0, readMemory(bmpReader, tga).errorCode);
+}
+
+TEST(ImageSniff, UnknownDataUsesOwnReader) {
+    PngReader reader;
+    std::vector<uint8_t> text(64, 'x');
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readMemory(reader, text).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readFile(reader, joinPath(g_TestOutputDir, "does_not_exist.png")).errorCode);
+
+    std::string empty = joinPath(g_TestOutputDir, "empty.png");
+    writeBinaryFile(empty, "", 0);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readFile(reader, empty).errorCode);
+
+    // Invalid arguments keep the reader's own errors
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(CKBITMAPERROR_GENERIC, reader.ReadMemory(nullptr, 10, &props));
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, reader.ReadMemory(text.data(), -1, &props));
+
+    // A cursor signature read by the icon reader goes through its own options
+    std::string icoPath = imagePath("ico", "images", "bmp-24bpp-mask.ico");
+    if (!fileExists(icoPath)) return;
+    CurReader cur;
+    ASSERT_EQ(0, readFile(cur, icoPath).errorCode);
+}
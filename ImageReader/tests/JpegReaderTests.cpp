@@ -0,0 +1,585 @@
+/**
+ * @file JpegReaderTests.cpp
+ * @brief JPEG format tests for CKImageReader
+ *
+ * Tests cover:
+ * - Baseline decoding of generated DC-only images, at full size and scaled
+ *   by 1/2, 1/4 and 1/8 (IMAGE_READ_SCALE_*)
+ * - Restart intervals, decoded in parallel, and damaged restart markers
+ * - The SSE2/AVX2 IDCT, upsampling and color kernels against the scalar ones
+ * - The corpus in tests/images/jpg against CRCs and the reference images
+ * - Malformed files (bad SOI, unsupported coding, truncated data, fuzzer cases)
+ */
+
+#include "TestFramework.h"
+#include "JpegReader.h"
+#include "JpegDsp.h"
+#include "PngReader.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using namespace TestFramework;
+
+//=============================================================================
+// Test Helpers
+//=============================================================================
+
+namespace {
+
+void putBE16(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+void putMarker(std::vector<uint8_t>& out, uint8_t marker, const std::vector<uint8_t>& segment) {
+    out.push_back(0xFF);
+    out.push_back(marker);
+    putBE16(out, static_cast<uint32_t>(segment.size() + 2));
+    out.insert(out.end(), segment.begin(), segment.end());
+}
+
+// MSB-first entropy coded data with 0xFF byte stuffing
+struct BitWriter {
+    std::vector<uint8_t> bytes;
+    uint32_t acc;
+    int count;
+
+    BitWriter() : acc(0), count(0) {}
+
+    void put(uint32_t bits, int n) {
+        for (int i = n - 1; i >= 0; --i) {
+            acc = (acc << 1) | ((bits >> i) & 1);
+            if (++count == 8) {
+                bytes.push_back(static_cast<uint8_t>(acc));
+                if (acc == 0xFF) bytes.push_back(0);
+                acc = 0;
+                count = 0;
+            }
+        }
+    }
+
+    // Pads the last byte with 1 bits
+    void flush() {
+        while (count != 0) put(1, 1);
+    }
+};
+
+// Baseline grayscale JPEG whose blocks hold only a DC coefficient.
+// dc lists one value per block in raster order; with a quantizer of 8 every
+// pixel of a block decodes to 128 + dc. A nonzero restartInterval inserts an
+// RSTn marker every restartInterval blocks.
+std::vector<uint8_t> makeDcJpeg(uint32_t width, uint32_t height, const std::vector<int>& dc,
+                                uint32_t restartInterval = 0) {
+    std::vector<uint8_t> out;
+    out.push_back(0xFF);
+    out.push_back(JPEG_MARKER_SOI);
+
+    std::vector<uint8_t> dqt(1, 0);
+    dqt.insert(dqt.end(), 64, 8);
+    putMarker(out, JPEG_MARKER_DQT, dqt);
+
+    std::vector<uint8_t> sof;
+    sof.push_back(8);
+    putBE16(sof, height);
+    putBE16(sof, width);
+    sof.push_back(1);
+    sof.push_back(1);
+    sof.push_back(0x11);
+    sof.push_back(0);
+    putMarker(out, JPEG_MARKER_SOF0, sof);
+
+    // DC table: categories 0-11 as 4-bit codes equal to the category.
+    // AC table: a single 1-bit code for EOB.
+    std::vector<uint8_t> dht(1, 0x00);
+    for (int len = 1; len <= 16; ++len) dht.push_back(len == 4 ? 12 : 0);
+    for (int s = 0; s < 12; ++s) dht.push_back(static_cast<uint8_t>(s));
+    dht.push_back(0x10);
+    for (int len = 1; len <= 16; ++len) dht.push_back(len == 1 ? 1 : 0);
+    dht.push_back(0x00);
+    putMarker(out, JPEG_MARKER_DHT, dht);
+
+    if (restartInterval) {
+        std::vector<uint8_t> dri;
+        putBE16(dri, restartInterval);
+        putMarker(out, JPEG_MARKER_DRI, dri);
+    }
+
+    std::vector<uint8_t> sos;
+    sos.push_back(1);
+    sos.push_back(1);
+    sos.push_back(0x00);
+    sos.push_back(0);
+    sos.push_back(63);
+    sos.push_back(0);
+    putMarker(out, JPEG_MARKER_SOS, sos);
+
+    BitWriter bits;
+    int prev = 0;
+    for (size_t i = 0; i < dc.size(); ++i) {
+        if (restartInterval && i > 0 && i % restartInterval == 0) {
+            bits.flush();
+            bits.bytes.push_back(0xFF);
+            bits.bytes.push_back(static_cast<uint8_t>(JPEG_MARKER_RST0 + (i / restartInterval - 1) % 8));
+            prev = 0;
+        }
+        int diff = dc[i] - prev;
+        prev = dc[i];
+        int magnitude = diff < 0 ? -diff : diff;
+        int category = 0;
+        while ((1 << category) <= magnitude) ++category;
+        bits.put(category, 4);
+        if (category > 0) bits.put(diff >= 0 ? diff : diff + (1 << category) - 1, category);
+        bits.put(0, 1); // EOB
+    }
+    bits.flush();
+    out.insert(out.end(), bits.bytes.begin(), bits.bytes.end());
+    out.push_back(0xFF);
+    out.push_back(JPEG_MARKER_EOI);
+    return out;
+}
+
+struct JpegTestResult {
+    int errorCode;
+    int width;
+    int height;
+    std::vector<uint8_t> pixels; // tightly packed BGRA32 rows
+};
+
+JpegTestResult readJpeg(const std::vector<uint8_t>& data, CKDWORD flags = 0) {
+    JpegTestResult result;
+    JpegReader reader;
+    reader.SetReadFlags(flags);
+    CKBitmapProperties* props = nullptr;
+    result.errorCode = reader.ReadMemory(const_cast<uint8_t*>(data.data()), static_cast<int>(data.size()), &props);
+    result.width = 0;
+    result.height = 0;
+    if (result.errorCode == 0 && props && props->m_Format.Image) {
+        const VxImageDescEx& fmt = props->m_Format;
+        result.width = fmt.Width;
+        result.height = fmt.Height;
+        size_t rowBytes = static_cast<size_t>(fmt.Width) * 4;
+        result.pixels.resize(rowBytes * fmt.Height);
+        for (int y = 0; y < fmt.Height; ++y) {
+            memcpy(&result.pixels[y * rowBytes], fmt.Image + y * fmt.BytesPerLine, rowBytes);
+        }
+    }
+    return result;
+}
+
+JpegTestResult readJpegFile(const std::string& path, CKDWORD flags = 0) {
+    return readJpeg(readBinaryFile(path), flags);
+}
+
+// Pixel (x, y) of a DC-only image with 8x8 blocks scaled down by denom
+bool checkDcImage(const JpegTestResult& r, uint32_t width, const std::vector<int>& dc, int denom) {
+    int blockSize = 8 / denom;
+    int blocksPerLine = static_cast<int>((width + 7) / 8);
+    for (int y = 0; y < r.height; ++y) {
+        for (int x = 0; x < r.width; ++x) {
+            int v = 128 + dc[(y / blockSize) * blocksPerLine + x / blockSize];
+            const uint8_t* p = &r.pixels[(static_cast<size_t>(y) * r.width + x) * 4];
+            if (p[0] != v || p[1] != v || p[2] != v || p[3] != 255) return false;
+        }
+    }
+    return true;
+}
+
+uint32_t g_Seed = 1;
+
+int nextRandom() {
+    g_Seed = g_Seed * 1103515245u + 12345u;
+    return static_cast<int>((g_Seed >> 16) & 0x7FFF);
+}
+
+} // anonymous namespace
+
+//=============================================================================
+// Decoding Tests
+//=============================================================================
+
+TEST(JpegReader, Baseline_DcOnlyGray) {
+    const uint32_t w = 20, h = 12;
+    std::vector<int> dc;
+    for (int i = 0; i < 6; ++i) dc.push_back(i * 37 - 100);
+    JpegTestResult r = readJpeg(makeDcJpeg(w, h, dc));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(20, r.width);
+    ASSERT_EQ(12, r.height);
+    ASSERT_TRUE(checkDcImage(r, w, dc, 1));
+}
+
+TEST(JpegReader, Baseline_StuffedBytes) {
+    // The second block is coded as 00000 0111 1111111 0, which puts an
+    // all-ones byte at bit offset 8 that must be stuffed as 0xFF 0x00
+    const uint32_t w = 64, h = 8;
+    static const int values[] = {0, 127, -128, 127, 0, 127, -128, 127};
+    std::vector<int> dc(values, values + 8);
+    std::vector<uint8_t> jpeg = makeDcJpeg(w, h, dc);
+    bool stuffed = false;
+    for (size_t i = 0; i + 1 < jpeg.size(); ++i) stuffed |= jpeg[i] == 0xFF && jpeg[i + 1] == 0;
+    ASSERT_TRUE(stuffed);
+    JpegTestResult r = readJpeg(jpeg);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(checkDcImage(r, w, dc, 1));
+}
+
+TEST(JpegReader, Restart_Intervals) {
+    // Large enough for the restart segments to be decoded on the worker pool,
+    // with intervals that end inside and at the end of block rows
+    const uint32_t w = 320, h = 260;
+    const size_t blocks = 40 * 33;
+    std::vector<int> dc;
+    for (size_t i = 0; i < blocks; ++i) dc.push_back(static_cast<int>((i * 13) % 200) - 100);
+    static const uint32_t intervals[] = {1, 3, 40, 1000};
+    for (int i = 0; i < 4; ++i) {
+        JpegTestResult r = readJpeg(makeDcJpeg(w, h, dc, intervals[i]));
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_EQ(320, r.width);
+        ASSERT_EQ(260, r.height);
+        ASSERT_TRUE(checkDcImage(r, w, dc, 1));
+
+        JpegTestResult scaled = readJpeg(makeDcJpeg(w, h, dc, intervals[i]), IMAGE_READ_SCALE_1_4);
+        ASSERT_EQ(0, scaled.errorCode);
+        ASSERT_TRUE(checkDcImage(scaled, w, dc, 4));
+    }
+}
+
+TEST(JpegReader, Restart_MissingMarker) {
+    // A lost RSTn sends the scan to the serial decoder, which resynchronizes
+    // at the next marker; the segments before the damage are unaffected
+    const uint32_t w = 320, h = 256;
+    std::vector<int> dc(40 * 32, 20);
+    std::vector<uint8_t> jpeg = makeDcJpeg(w, h, dc, 40);
+    size_t sos = 0;
+    for (size_t k = 2; k + 1 < jpeg.size(); ++k) {
+        if (jpeg[k] == 0xFF && jpeg[k + 1] == JPEG_MARKER_SOS) sos = k;
+    }
+    for (size_t k = sos + 2; k + 1 < jpeg.size(); ++k) {
+        if (jpeg[k] == 0xFF && jpeg[k + 1] == JPEG_MARKER_RST0 + 4) {
+            jpeg.erase(jpeg.begin() + k, jpeg.begin() + k + 2);
+            break;
+        }
+    }
+    JpegTestResult r = readJpeg(jpeg);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(320, r.width);
+    ASSERT_EQ(256, r.height);
+    // One segment per block row; RST4 followed the fifth
+    for (size_t i = 0; i < static_cast<size_t>(w) * 40 * 4; i += 4) ASSERT_EQ(128 + 20, r.pixels[i]);
+}
+
+TEST(JpegReader, Scaled_Sizes) {
+    JpegImageInfo info;
+    info.width = 17;
+    info.height = 9;
+    info.components = 3;
+    info.progressive = FALSE;
+    static const CKDWORD flags[] = {0, IMAGE_READ_SCALE_1_2, IMAGE_READ_SCALE_1_4, IMAGE_READ_SCALE_1_8};
+    static const CKDWORD widths[] = {17, 9, 5, 3}, heights[] = {9, 5, 3, 2};
+    for (int i = 0; i < 4; ++i) {
+        CKDWORD w = 0, h = 0;
+        JPEG_ScaledSize(info, flags[i], w, h);
+        ASSERT_EQ(widths[i], w);
+        ASSERT_EQ(heights[i], h);
+    }
+}
+
+TEST(JpegReader, Scaled_DcOnlyGray) {
+    const uint32_t w = 21, h = 19;
+    std::vector<int> dc;
+    for (int i = 0; i < 9; ++i) dc.push_back(90 - i * 23);
+    std::vector<uint8_t> jpeg = makeDcJpeg(w, h, dc);
+
+    JpegImageInfo info;
+    ASSERT_EQ(0, JPEG_ReadInfo(jpeg.data(), static_cast<CKDWORD>(jpeg.size()), info));
+    static const CKDWORD flags[] = {IMAGE_READ_SCALE_1_2, IMAGE_READ_SCALE_1_4, IMAGE_READ_SCALE_1_8};
+    static const int denoms[] = {2, 4, 8};
+    for (int i = 0; i < 3; ++i) {
+        CKDWORD sw = 0, sh = 0;
+        JPEG_ScaledSize(info, flags[i], sw, sh);
+        JpegTestResult r = readJpeg(jpeg, flags[i]);
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_EQ(static_cast<int>(sw), r.width);
+        ASSERT_EQ(static_cast<int>(sh), r.height);
+        ASSERT_TRUE(checkDcImage(r, w, dc, denoms[i]));
+    }
+}
+
+TEST(JpegReader, ReadInfo) {
+    std::vector<uint8_t> jpeg = makeDcJpeg(300, 200, std::vector<int>(38 * 25, 0));
+    JpegImageInfo info;
+    ASSERT_EQ(0, JPEG_ReadInfo(jpeg.data(), static_cast<CKDWORD>(jpeg.size()), info));
+    ASSERT_EQ(300u, info.width);
+    ASSERT_EQ(200u, info.height);
+    ASSERT_EQ(1u, info.components);
+    ASSERT_FALSE(info.progressive);
+}
+
+//=============================================================================
+// Kernel Tests
+//=============================================================================
+
+TEST(JpegReader, Kernels_IdctMatchesScalar) {
+    const JpegDsp& scalar = JPEG_GetScalarDsp();
+    const JpegDsp& dsp = JPEG_GetDsp();
+    const int count = 5;
+    static const int sizes[] = {8, 4, 2, 1};
+    g_Seed = 7;
+    for (int iter = 0; iter < 200; ++iter) {
+        std::vector<short> coefs(64 * count, 0);
+        CKWORD quant[64];
+        for (int k = 0; k < 64; ++k) quant[k] = static_cast<CKWORD>(1 + nextRandom() % (iter < 100 ? 16 : 255));
+        for (size_t k = 0; k < coefs.size(); ++k) {
+            // Sparse blocks exercise the DC-only shortcuts; the last iterations use extreme values
+            int r = nextRandom();
+            if (iter % 3 == 0 && k % 64 != 0) continue;
+            coefs[k] = static_cast<short>(iter >= 180 ? (r & 1 ? 32767 : -32768) : r % 512 - 256);
+        }
+        for (int s = 0; s < 4; ++s) {
+            int size = sizes[s];
+            int stride = count * size + 3;
+            std::vector<uint8_t> expected(stride * size, 0), actual(stride * size, 0);
+            scalar.idct[JPEG_IDCT_INDEX(size)](coefs.data(), count, quant, expected.data(), stride);
+            dsp.idct[JPEG_IDCT_INDEX(size)](coefs.data(), count, quant, actual.data(), stride);
+            ASSERT_TRUE(expected == actual);
+        }
+    }
+}
+
+TEST(JpegReader, Kernels_UpsampleAndColorMatchScalar) {
+    const JpegDsp& scalar = JPEG_GetScalarDsp();
+    const JpegDsp& dsp = JPEG_GetDsp();
+    g_Seed = 11;
+    for (int width = 2; width <= 70; ++width) {
+        std::vector<uint8_t> a(width), b(width), c(width * 2);
+        for (int i = 0; i < width; ++i) {
+            a[i] = static_cast<uint8_t>(nextRandom());
+            b[i] = static_cast<uint8_t>(nextRandom());
+        }
+        for (int i = 0; i < width * 2; ++i) c[i] = static_cast<uint8_t>(nextRandom());
+
+        std::vector<uint8_t> expected(width * 2), actual(width * 2);
+        scalar.upsampleH2V1(a.data(), width, expected.data());
+        dsp.upsampleH2V1(a.data(), width, actual.data());
+        ASSERT_TRUE(expected == actual);
+        scalar.upsampleH2V2(a.data(), b.data(), width, expected.data());
+        dsp.upsampleH2V2(a.data(), b.data(), width, actual.data());
+        ASSERT_TRUE(expected == actual);
+
+        std::vector<uint8_t> expectedBGRA(width * 8), actualBGRA(width * 8);
+        scalar.yccToBGRA(c.data(), a.data(), b.data(), expectedBGRA.data(), width);
+        dsp.yccToBGRA(c.data(), a.data(), b.data(), actualBGRA.data(), width);
+        ASSERT_TRUE(expectedBGRA == actualBGRA);
+    }
+}
+
+//=============================================================================
+// Corpus Tests
+//=============================================================================
+
+TEST(JpegReader, Corpus_ReferenceCrcs) {
+    static const char* files[] = {"exif-xmp-metadata.jpg", "iptc.jpg", "portrait_2.jpg", "progressive/3.jpg",
+                                  "progressive/cat.jpg", "progressive/test.jpg"};
+    std::string jpgDir = joinPath(g_TestImagesDir, "jpg");
+    int checked = 0;
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i) {
+        std::string path = joinPath(jpgDir, files[i]);
+        uint32_t crc = 0;
+        if (!fileExists(path) || !getReferenceCrc(std::string("jpg/") + files[i], crc)) continue;
+        JpegTestResult r = readJpegFile(path);
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_CRC(crc, r.pixels.data(), r.pixels.size());
+        ++checked;
+    }
+    if (checked == 0) SKIP_TEST("JPEG corpus or reference CRCs not found");
+}
+
+TEST(JpegReader, Corpus_MatchesReferenceImages) {
+    // The references come from a decoder with a different IDCT and upsampling,
+    // so the pixels only have to agree within a small tolerance
+    std::string imageDir = joinPath(joinPath(g_TestImagesDir, "jpg"), "progressive");
+    std::string refDir = joinPath(joinPath(g_TestReferenceDir, "jpg"), "progressive");
+    std::vector<std::string> refs = listDirectory(refDir);
+    int compared = 0;
+    for (size_t i = 0; i < refs.size(); ++i) {
+        ReferenceInfo info = parseReferenceFilename(refs[i]);
+        std::string imagePath = joinPath(imageDir, info.inputName);
+        if (!info.valid || !fileExists(imagePath)) continue;
+
+        JpegTestResult image = readJpegFile(imagePath);
+        ASSERT_EQ(0, image.errorCode);
+
+        PngReader pngReader;
+        CKBitmapProperties* props = nullptr;
+        std::string refPath = joinPath(refDir, refs[i]);
+        ASSERT_EQ(0, pngReader.ReadFile(const_cast<char*>(refPath.c_str()), &props));
+        const VxImageDescEx& fmt = props->m_Format;
+        ASSERT_EQ(fmt.Width, image.width);
+        ASSERT_EQ(fmt.Height, image.height);
+
+        long long total = 0;
+        int maxDiff = 0;
+        for (int y = 0; y < fmt.Height; ++y) {
+            const uint8_t* ref = fmt.Image + y * fmt.BytesPerLine;
+            const uint8_t* px = &image.pixels[static_cast<size_t>(y) * image.width * 4];
+            for (int x = 0; x < fmt.Width * 4; ++x) {
+                int d = std::abs(static_cast<int>(ref[x]) - static_cast<int>(px[x]));
+                total += d;
+                maxDiff = std::max(maxDiff, d);
+            }
+        }
+        ASSERT_TRUE(maxDiff <= 4);
+        ASSERT_TRUE(total <= static_cast<long long>(fmt.Width) * fmt.Height * 4 / 10);
+        ++compared;
+    }
+    if (compared == 0) SKIP_TEST("JPEG reference images not found");
+}
+
+TEST(JpegReader, Corpus_ReportsSourceFormat) {
+    std::string path = joinPath(joinPath(g_TestImagesDir, "jpg"), "progressive/cat.jpg");
+    if (!fileExists(path)) SKIP_TEST("cat.jpg not found");
+
+    JpegReader reader;
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(0, reader.ReadFile(const_cast<char*>(path.c_str()), &props));
+    ASSERT_EQ(static_cast<int>(sizeof(JpegBitmapProperties)), props->m_Size);
+    ASSERT_EQ(3u, reinterpret_cast<JpegBitmapProperties*>(props)->m_Components);
+    ASSERT_EQ(1u, reinterpret_cast<JpegBitmapProperties*>(props)->m_Progressive);
+    ASSERT_EQ(32, props->m_Format.BitsPerPixel);
+}
+
+TEST(JpegReader, Corpus_ScaledMatchesFullSize) {
+    // A 1/8 decode keeps only the DC terms, so each pixel should be close to
+    // the mean of the matching 8x8 area of the full decode
+    std::string path = joinPath(joinPath(g_TestImagesDir, "jpg"), "progressive/cat.jpg");
+    if (!fileExists(path)) SKIP_TEST("cat.jpg not found");
+
+    JpegTestResult full = readJpegFile(path);
+    JpegTestResult eighth = readJpegFile(path, IMAGE_READ_SCALE_1_8);
+    ASSERT_EQ(0, full.errorCode);
+    ASSERT_EQ(0, eighth.errorCode);
+    ASSERT_EQ((full.width + 7) / 8, eighth.width);
+    ASSERT_EQ((full.height + 7) / 8, eighth.height);
+    long long total = 0;
+    int samples = 0;
+    for (int y = 0; y < full.height / 8; ++y) {
+        for (int x = 0; x < full.width / 8; ++x) {
+            for (int c = 0; c < 3; ++c) {
+                int sum = 0;
+                for (int j = 0; j < 8; ++j)
+                    for (int i = 0; i < 8; ++i)
+                        sum += full.pixels[((static_cast<size_t>(y) * 8 + j) * full.width + x * 8 + i) * 4 + c];
+                total += std::abs(sum / 64 - eighth.pixels[(static_cast<size_t>(y) * eighth.width + x) * 4 + c]);
+                ++samples;
+            }
+        }
+    }
+    ASSERT_TRUE(samples > 0);
+    ASSERT_TRUE(total <= static_cast<long long>(samples) * 2);
+}
+
+TEST(JpegReader, RegressionCorpus_MustNotCrash) {
+    // Fuzzer cases: decoding may fail, but must fail cleanly
+    std::string regDir = joinPath(joinPath(g_TestReferenceDir, ".."), "regression/jpg");
+    if (!directoryExists(regDir)) SKIP_TEST("JPEG regression directory not found");
+    std::vector<std::string> files = collectFilesWithExtensions(regDir, {".jpg", ".jpeg"});
+    if (files.empty()) SKIP_TEST("No JPEG regression files found");
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        JpegTestResult r = readJpegFile(joinPath(regDir, files[i]));
+        if (r.errorCode == 0) {
+            ASSERT_TRUE(r.width > 0 && r.height > 0);
+            ASSERT_EQ(static_cast<size_t>(r.width) * r.height * 4, r.pixels.size());
+        }
+    }
+}
+
+//=============================================================================
+// Negative Tests
+//=============================================================================
+
+TEST(JpegReader, Negative_BadSoi) {
+    std::vector<uint8_t> jpeg = makeDcJpeg(8, 8, std::vector<int>(1, 0));
+    jpeg[1] = 0xD9;
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readJpeg(jpeg).errorCode);
+    jpeg.resize(1);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readJpeg(jpeg).errorCode);
+}
+
+TEST(JpegReader, Negative_UnsupportedCoding) {
+    // Lossless (SOF3) and arithmetic coded (SOF9) frames
+    static const uint8_t markers[] = {0xC3, 0xC9};
+    for (int i = 0; i < 2; ++i) {
+        std::vector<uint8_t> jpeg = makeDcJpeg(8, 8, std::vector<int>(1, 0));
+        for (size_t k = 2; k + 1 < jpeg.size(); ++k) {
+            if (jpeg[k] == 0xFF && jpeg[k + 1] == JPEG_MARKER_SOF0) {
+                jpeg[k + 1] = markers[i];
+                break;
+            }
+        }
+        ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readJpeg(jpeg).errorCode);
+    }
+
+    // 12-bit samples
+    std::vector<uint8_t> jpeg = makeDcJpeg(8, 8, std::vector<int>(1, 0));
+    for (size_t k = 2; k + 4 < jpeg.size(); ++k) {
+        if (jpeg[k] == 0xFF && jpeg[k + 1] == JPEG_MARKER_SOF0) {
+            jpeg[k + 4] = 12;
+            break;
+        }
+    }
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readJpeg(jpeg).errorCode);
+}
+
+TEST(JpegReader, Negative_BadFrame) {
+    std::vector<uint8_t> zeroWidth = makeDcJpeg(0, 8, std::vector<int>(1, 0));
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readJpeg(zeroWidth).errorCode);
+    std::vector<uint8_t> tooLarge = makeDcJpeg(65535, 65535, std::vector<int>(1, 0));
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readJpeg(tooLarge).errorCode);
+}
+
+TEST(JpegReader, Negative_Truncated) {
+    const uint32_t w = 64, h = 64;
+    std::vector<int> dc(64, 50);
+    std::vector<uint8_t> jpeg = makeDcJpeg(w, h, dc);
+    size_t sos = 0;
+    for (size_t k = 2; k + 1 < jpeg.size(); ++k) {
+        if (jpeg[k] == 0xFF && jpeg[k + 1] == JPEG_MARKER_SOS) sos = k;
+    }
+    ASSERT_TRUE(sos != 0);
+
+    // Cut before the scan: nothing to decode
+    std::vector<uint8_t> header(jpeg.begin(), jpeg.begin() + sos);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readJpeg(header).errorCode);
+
+    // Cut inside the entropy coded data: like libjpeg, the missing blocks
+    // decode as if their coefficients were zero
+    jpeg.resize(jpeg.size() - 12);
+    JpegTestResult r = readJpeg(jpeg);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(64, r.width);
+    ASSERT_EQ(64, r.height);
+    ASSERT_EQ(128 + 50, r.pixels[0]);
+}
+
+//=============================================================================
+// API Tests
+//=============================================================================
+
+TEST(JpegReader, GetReaderInfo) {
+    JpegReader reader;
+    CKPluginInfo* info = reader.GetReaderInfo();
+    ASSERT_TRUE(info != nullptr);
+    ASSERT_GUID_EQ(JPEGREADER_GUID, info->m_GUID);
+}
+
+TEST(JpegReader, ReadOnly) {
+    JpegReader reader;
+    JpegBitmapProperties props;
+    std::vector<uint8_t> pixels(4 * 4, 0);
+    ImageReader::FillFormatBGRA32(props.m_Format, 2, 2, 8, pixels.data());
+    void* memory = nullptr;
+    ASSERT_EQ(0, reader.SaveMemory(&memory, &props));
+    ASSERT_EQ(0, reader.SaveFile(const_cast<char*>("test.jpg"), &props));
+}
@@ -0,0 +1,436 @@
+/**
+ * @file KtxReaderTests.cpp
+ * @brief KTX 1 and KTX 2 format tests for CKImageReader
+ *
+ * Tests cover:
+ * - BC1 to BC7 textures of both versions, decoded or passed through with
+ *   IMAGE_READ_KEEP_BLOCKS (levels are gathered from wherever they are stored)
+ * - Big-endian KTX 1, key/value data, cube maps and opaque BC1
+ * - Uncompressed formats with KTX 1 row padding
+ * - Malformed files (supercompression, truncated levels, bad headers)
+ */
+
+#include "TestFramework.h"
+#include "KtxReader.h"
+#include "ImageBcn.h"
+#include <cstring>
+
+using namespace TestFramework;
+
+//=============================================================================
+// Test Helpers
+//=============================================================================
+
+namespace {
+
+uint32_t g_Seed = 4242;
+
+uint32_t nextRandom() {
+    g_Seed = g_Seed * 1103515245u + 12345u;
+    return g_Seed >> 8;
+}
+
+const uint8_t kKtx1Identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+const uint8_t kKtx2Identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+std::vector<uint8_t> randomBytes(size_t count) {
+    std::vector<uint8_t> out(count);
+    for (size_t i = 0; i < count; ++i) out[i] = static_cast<uint8_t>(nextRandom());
+    return out;
+}
+
+void put32(std::vector<uint8_t>& out, uint32_t v, bool bigEndian = false) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<uint8_t>(v >> (bigEndian ? 24 - i * 8 : i * 8)));
+}
+
+void put64(std::vector<uint8_t>& out, uint64_t v) {
+    put32(out, static_cast<uint32_t>(v));
+    put32(out, static_cast<uint32_t>(v >> 32));
+}
+
+struct Ktx1Desc {
+    uint32_t glType;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t width;
+    uint32_t height;
+    uint32_t layers;
+    uint32_t faces;
+    uint32_t keyValueBytes;
+    bool bigEndian;
+
+    Ktx1Desc(uint32_t internalFormat, uint32_t w, uint32_t h)
+        : glType(0), glFormat(0), glInternalFormat(internalFormat), width(w), height(h), layers(0), faces(1),
+          keyValueBytes(0), bigEndian(false) {}
+};
+
+// levels[i] holds the image data of level i (all faces of a cube map)
+std::vector<uint8_t> makeKtx1(const Ktx1Desc& desc, const std::vector<std::vector<uint8_t> >& levels,
+                              uint32_t imageSizeOverride = 0) {
+    std::vector<uint8_t> out(kKtx1Identifier, kKtx1Identifier + 12);
+    bool be = desc.bigEndian;
+    put32(out, 0x04030201, be);
+    put32(out, desc.glType, be);
+    put32(out, desc.glType ? 1 : 0, be);
+    put32(out, desc.glFormat, be);
+    put32(out, desc.glInternalFormat, be);
+    put32(out, desc.glFormat ? desc.glFormat : 0x1908, be);
+    put32(out, desc.width, be);
+    put32(out, desc.height, be);
+    put32(out, 0, be);
+    put32(out, desc.layers, be);
+    put32(out, desc.faces, be);
+    put32(out, static_cast<uint32_t>(levels.size()), be);
+    put32(out, desc.keyValueBytes, be);
+    std::vector<uint8_t> keyValues = randomBytes(desc.keyValueBytes);
+    out.insert(out.end(), keyValues.begin(), keyValues.end());
+    for (size_t i = 0; i < levels.size(); ++i) {
+        uint32_t imageSize = static_cast<uint32_t>(levels[i].size());
+        if (desc.faces == 6 && desc.layers == 0) imageSize /= 6;
+        put32(out, imageSizeOverride ? imageSizeOverride : imageSize, be);
+        out.insert(out.end(), levels[i].begin(), levels[i].end());
+        while (out.size() % 4) out.push_back(0);
+    }
+    return out;
+}
+
+// Levels are stored smallest first, as KTX 2 writers do
+std::vector<uint8_t> makeKtx2(uint32_t vkFormat, uint32_t width, uint32_t height,
+                              const std::vector<std::vector<uint8_t> >& levels, uint32_t supercompression = 0) {
+    std::vector<uint8_t> out(kKtx2Identifier, kKtx2Identifier + 12);
+    put32(out, vkFormat);
+    put32(out, 1);
+    put32(out, width);
+    put32(out, height);
+    put32(out, 0);
+    put32(out, 0);
+    put32(out, 1);
+    put32(out, static_cast<uint32_t>(levels.size()));
+    put32(out, supercompression);
+    for (int i = 0; i < 4; ++i) put32(out, 0);
+    put64(out, 0);
+    put64(out, 0);
+
+    uint64_t offset = out.size() + levels.size() * 24;
+    std::vector<uint64_t> offsets(levels.size());
+    for (size_t i = levels.size(); i-- > 0;) {
+        offset = (offset + 15) & ~static_cast<uint64_t>(15);
+        offsets[i] = offset;
+        offset += levels[i].size();
+    }
+    for (size_t i = 0; i < levels.size(); ++i) {
+        put64(out, offsets[i]);
+        put64(out, levels[i].size());
+        put64(out, levels[i].size());
+    }
+    for (size_t i = levels.size(); i-- > 0;) {
+        out.resize(static_cast<size_t>(offsets[i]), 0);
+        out.insert(out.end(), levels[i].begin(), levels[i].end());
+    }
+    return out;
+}
+
+// Random blocks for each level of a width x height chain
+std::vector<std::vector<uint8_t> > blockChain(CKDWORD format, uint32_t width, uint32_t height, uint32_t mips) {
+    std::vector<std::vector<uint8_t> > levels;
+    for (uint32_t i = 0; i < mips; ++i) {
+        levels.push_back(randomBytes(static_cast<size_t>(ImageBlockLevelSize(format, width, height))));
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return levels;
+}
+
+std::vector<uint8_t> concat(const std::vector<std::vector<uint8_t> >& levels) {
+    std::vector<uint8_t> out;
+    for (size_t i = 0; i < levels.size(); ++i) out.insert(out.end(), levels[i].begin(), levels[i].end());
+    return out;
+}
+
+struct KtxTestResult {
+    int errorCode;
+    int width;
+    int height;
+    int bitsPerPixel;
+    std::vector<uint8_t> pixels; // tightly packed rows, or the blocks as returned
+    KtxBitmapProperties props;
+};
+
+KtxTestResult readKtx(const std::vector<uint8_t>& data, CKDWORD flags = 0) {
+    KtxTestResult result;
+    KtxReader reader;
+    reader.SetReadFlags(flags);
+    CKBitmapProperties* props = nullptr;
+    result.errorCode = reader.ReadMemory(const_cast<uint8_t*>(data.data()), static_cast<int>(data.size()), &props);
+    result.width = 0;
+    result.height = 0;
+    result.bitsPerPixel = 0;
+    if (result.errorCode == 0 && props && props->m_Format.Image) {
+        const VxImageDescEx& fmt = props->m_Format;
+        result.props = *reinterpret_cast<KtxBitmapProperties*>(props);
+        result.width = fmt.Width;
+        result.height = fmt.Height;
+        result.bitsPerPixel = fmt.BitsPerPixel;
+        if (flags & IMAGE_READ_KEEP_BLOCKS && result.props.m_BlockFormat != IMAGE_BLOCK_NONE) {
+            result.pixels.assign(fmt.Image, fmt.Image + result.props.m_DataSize);
+        } else {
+            for (int y = 0; y < fmt.Height; ++y) {
+                const uint8_t* row = fmt.Image + y * fmt.BytesPerLine;
+                result.pixels.insert(result.pixels.end(), row, row + fmt.Width * fmt.BitsPerPixel / 8);
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<uint8_t> decodeLevel(CKDWORD format, const uint8_t* blocks, int width, int height,
+                                 bool toFloat = false) {
+    int pixelBytes = toFloat ? 16 : 4;
+    std::vector<uint8_t> out(width * height * pixelBytes);
+    ImageDecodeBlockLevel(format, blocks, width, height, out.data(), width * pixelBytes, toFloat);
+    return out;
+}
+
+} // namespace
+
+//=============================================================================
+// KTX 1
+//=============================================================================
+
+TEST(KtxReader, Ktx1_DecodesTopLevel) {
+    const uint32_t internalFormats[] = {0x83F1, 0x83F2, 0x83F3, 0x8DBB, 0x8DBC, 0x8DBD, 0x8DBE, 0x8E8C, 0x8E8F};
+    const CKDWORD formats[] = {IMAGE_BLOCK_BC1,       IMAGE_BLOCK_BC2, IMAGE_BLOCK_BC3,       IMAGE_BLOCK_BC4,
+                               IMAGE_BLOCK_BC4_SNORM, IMAGE_BLOCK_BC5, IMAGE_BLOCK_BC5_SNORM, IMAGE_BLOCK_BC7,
+                               IMAGE_BLOCK_BC6H};
+    for (int i = 0; i < 9; ++i) {
+        std::vector<std::vector<uint8_t> > levels = blockChain(formats[i], 18, 7, 3);
+        for (int bigEndian = 0; bigEndian < 2; ++bigEndian) {
+            Ktx1Desc desc(internalFormats[i], 18, 7);
+            desc.bigEndian = bigEndian != 0;
+            KtxTestResult r = readKtx(makeKtx1(desc, levels));
+            ASSERT_EQ(0, r.errorCode);
+            ASSERT_EQ(18, r.width);
+            ASSERT_EQ(7, r.height);
+            ASSERT_EQ(32, r.bitsPerPixel);
+            ASSERT_TRUE(r.pixels == decodeLevel(formats[i], levels[0].data(), 18, 7));
+            ASSERT_EQ(formats[i], r.props.m_BlockFormat);
+            ASSERT_EQ(3u, r.props.m_MipCount);
+            ASSERT_EQ(1u, r.props.m_KtxVersion);
+        }
+    }
+
+    // BC6H as float
+    std::vector<std::vector<uint8_t> > levels = blockChain(IMAGE_BLOCK_BC6H, 18, 7, 1);
+    KtxTestResult r = readKtx(makeKtx1(Ktx1Desc(0x8E8E, 18, 7), levels), IMAGE_READ_FLOAT);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(128, r.bitsPerPixel);
+    ASSERT_TRUE(r.pixels == decodeLevel(IMAGE_BLOCK_BC6H_SF16, levels[0].data(), 18, 7, true));
+}
+
+TEST(KtxReader, Ktx1_OpaqueBc1) {
+    // Indices 3 with c0 <= c1: transparent black with alpha, black without
+    std::vector<uint8_t> block = {0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    std::vector<std::vector<uint8_t> > levels(1, block);
+    KtxTestResult r = readKtx(makeKtx1(Ktx1Desc(0x83F1, 4, 4), levels));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(0, r.pixels[3]);
+    r = readKtx(makeKtx1(Ktx1Desc(0x83F0, 4, 4), levels));
+    ASSERT_EQ(0, r.errorCode);
+    for (int i = 0; i < 16; ++i) ASSERT_EQ(0xFF, r.pixels[i * 4 + 3]);
+    ASSERT_EQ(0, r.pixels[0]);
+    r = readKtx(makeKtx1(Ktx1Desc(0x8C4C, 4, 4), levels));
+    ASSERT_EQ(0xFF, r.pixels[3]);
+    ASSERT_EQ(1u, r.props.m_Srgb);
+}
+
+TEST(KtxReader, Ktx1_KeepBlocks) {
+    // Key/value data before the levels, 4-byte level padding
+    std::vector<std::vector<uint8_t> > levels = blockChain(IMAGE_BLOCK_BC7, 40, 24, 6);
+    Ktx1Desc desc(0x8E8D, 40, 24);
+    desc.keyValueBytes = 28;
+    KtxTestResult r = readKtx(makeKtx1(desc, levels), IMAGE_READ_KEEP_BLOCKS);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == concat(levels));
+    ASSERT_EQ(static_cast<CKDWORD>(IMAGE_BLOCK_BC7), r.props.m_BlockFormat);
+    ASSERT_EQ(6u, r.props.m_MipCount);
+    ASSERT_EQ(static_cast<CKDWORD>(concat(levels).size()), r.props.m_DataSize);
+    ASSERT_EQ(1u, r.props.m_Srgb);
+    ASSERT_EQ(8, r.bitsPerPixel);
+
+    // Cube map: the first face of each level
+    std::vector<std::vector<uint8_t> > faces = blockChain(IMAGE_BLOCK_BC1, 8, 8, 4);
+    std::vector<std::vector<uint8_t> > cubeLevels;
+    for (size_t i = 0; i < faces.size(); ++i) {
+        std::vector<uint8_t> level = faces[i];
+        for (int f = 1; f < 6; ++f) {
+            std::vector<uint8_t> other = randomBytes(faces[i].size());
+            level.insert(level.end(), other.begin(), other.end());
+        }
+        cubeLevels.push_back(level);
+    }
+    Ktx1Desc cube(0x83F1, 8, 8);
+    cube.faces = 6;
+    r = readKtx(makeKtx1(cube, cubeLevels), IMAGE_READ_KEEP_BLOCKS);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(6u, r.props.m_Faces);
+    ASSERT_TRUE(r.pixels == concat(faces));
+}
+
+TEST(KtxReader, Ktx1_UncompressedRowPadding) {
+    // 5x3 RGB rows are padded to 16 bytes
+    std::vector<uint8_t> level;
+    for (int y = 0; y < 3; ++y) {
+        std::vector<uint8_t> row = randomBytes(15);
+        level.insert(level.end(), row.begin(), row.end());
+        level.push_back(0xEE);
+    }
+    Ktx1Desc desc(0x8051, 5, 3);
+    desc.glType = KTX_GL_UNSIGNED_BYTE;
+    desc.glFormat = KTX_GL_RGB;
+    KtxTestResult r = readKtx(makeKtx1(desc, std::vector<std::vector<uint8_t> >(1, level)));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(static_cast<CKDWORD>(IMAGE_BLOCK_NONE), r.props.m_BlockFormat);
+    for (int y = 0; y < 3; ++y) {
+        for (int x = 0; x < 5; ++x) {
+            const uint8_t* src = &level[y * 16 + x * 3];
+            const uint8_t* dst = &r.pixels[(y * 5 + x) * 4];
+            ASSERT_EQ(src[2], dst[0]);
+            ASSERT_EQ(src[1], dst[1]);
+            ASSERT_EQ(src[0], dst[2]);
+            ASSERT_EQ(255, dst[3]);
+        }
+    }
+
+    // BGRA rows need no padding; KEEP_BLOCKS does not apply
+    std::vector<uint8_t> bgra = randomBytes(5 * 3 * 4);
+    desc.glFormat = KTX_GL_BGRA;
+    r = readKtx(makeKtx1(desc, std::vector<std::vector<uint8_t> >(1, bgra)), IMAGE_READ_KEEP_BLOCKS);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == bgra);
+
+    // Luminance-alpha
+    std::vector<uint8_t> la = randomBytes(12);
+    desc.width = 2;
+    desc.glFormat = KTX_GL_LUMINANCE_ALPHA;
+    r = readKtx(makeKtx1(desc, std::vector<std::vector<uint8_t> >(1, la)));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(la[4], r.pixels[8]);
+    ASSERT_EQ(la[4], r.pixels[9]);
+    ASSERT_EQ(la[4], r.pixels[10]);
+    ASSERT_EQ(la[5], r.pixels[11]);
+}
+
+//=============================================================================
+// KTX 2
+//=============================================================================
+
+TEST(KtxReader, Ktx2_KeepBlocks) {
+    std::vector<std::vector<uint8_t> > levels = blockChain(IMAGE_BLOCK_BC7, 37, 21, 6);
+    std::vector<uint8_t> data = makeKtx2(146, 37, 21, levels);
+    KtxTestResult r = readKtx(data, IMAGE_READ_KEEP_BLOCKS);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == concat(levels));
+    ASSERT_EQ(6u, r.props.m_MipCount);
+    ASSERT_EQ(1u, r.props.m_Srgb);
+    ASSERT_EQ(2u, r.props.m_KtxVersion);
+
+    r = readKtx(data);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == decodeLevel(IMAGE_BLOCK_BC7, levels[0].data(), 37, 21));
+
+    levels = blockChain(IMAGE_BLOCK_BC1, 12, 12, 1);
+    r = readKtx(makeKtx2(131, 12, 12, levels));
+    ASSERT_EQ(0, r.errorCode);
+    std::vector<uint8_t> expected = decodeLevel(IMAGE_BLOCK_BC1, levels[0].data(), 12, 12);
+    for (size_t i = 3; i < expected.size(); i += 4) expected[i] = 0xFF;
+    ASSERT_TRUE(r.pixels == expected);
+}
+
+TEST(KtxReader, Ktx2_Uncompressed) {
+    std::vector<uint8_t> rgba = randomBytes(7 * 5 * 4);
+    KtxTestResult r = readKtx(makeKtx2(43, 7, 5, std::vector<std::vector<uint8_t> >(1, rgba)));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(1u, r.props.m_Srgb);
+    for (int i = 0; i < 35; ++i) {
+        ASSERT_EQ(rgba[i * 4 + 2], r.pixels[i * 4]);
+        ASSERT_EQ(rgba[i * 4 + 1], r.pixels[i * 4 + 1]);
+        ASSERT_EQ(rgba[i * 4], r.pixels[i * 4 + 2]);
+        ASSERT_EQ(rgba[i * 4 + 3], r.pixels[i * 4 + 3]);
+    }
+
+    // R8 rows are packed
+    std::vector<uint8_t> red = randomBytes(7 * 5);
+    r = readKtx(makeKtx2(9, 7, 5, std::vector<std::vector<uint8_t> >(1, red)));
+    ASSERT_EQ(0, r.errorCode);
+    for (int i = 0; i < 35; ++i) ASSERT_EQ(red[i], r.pixels[i * 4 + 1]);
+}
+
+TEST(KtxReader, ReaderInfo) {
+    KtxReader reader;
+    CKPluginInfo* info = reader.GetReaderInfo();
+    ASSERT_TRUE(info != nullptr);
+    ASSERT_GUID_EQ(KTXREADER_GUID, info->m_GUID);
+    ASSERT_TRUE(strcmp(info->m_Extension, "Ktx") == 0);
+    ASSERT_EQ(0, reader.SaveFile(const_cast<char*>("unused.ktx"), nullptr));
+}
+
+//=============================================================================
+// Negative Tests
+//=============================================================================
+
+TEST(KtxReader, Truncations_FailFast) {
+    // Decoding needs the first level only; keeping the blocks needs them all
+    std::vector<std::vector<uint8_t> > levels = blockChain(IMAGE_BLOCK_BC3, 8, 8, 4);
+    std::vector<uint8_t> data = makeKtx1(Ktx1Desc(0x83F3, 8, 8), levels);
+    ASSERT_EQ(0, readKtx(data, IMAGE_READ_KEEP_BLOCKS).errorCode);
+    size_t level0End = KTX1_HEADER_SIZE + 4 + levels[0].size();
+    for (size_t n = 1; n < data.size(); ++n) {
+        std::vector<uint8_t> prefix(data.begin(), data.begin() + n);
+        ASSERT_EQ(n < level0End ? CKBITMAPERROR_READERROR : 0, readKtx(prefix).errorCode);
+        ASSERT_EQ(CKBITMAPERROR_READERROR, readKtx(prefix, IMAGE_READ_KEEP_BLOCKS).errorCode);
+    }
+
+    // KTX 2 stores the top level last
+    data = makeKtx2(137, 8, 8, levels);
+    ASSERT_EQ(0, readKtx(data, IMAGE_READ_KEEP_BLOCKS).errorCode);
+    for (size_t n = 1; n < data.size(); ++n) {
+        std::vector<uint8_t> prefix(data.begin(), data.begin() + n);
+        ASSERT_EQ(CKBITMAPERROR_READERROR, readKtx(prefix).errorCode);
+    }
+
+    // A level size that puts the next level beyond the file
+    data = makeKtx1(Ktx1Desc(0x83F3, 8, 8), blockChain(IMAGE_BLOCK_BC3, 8, 8, 2), 0x7FFFFFF0);
+    ASSERT_EQ(0, readKtx(data).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readKtx(data, IMAGE_READ_KEEP_BLOCKS).errorCode);
+}
+
+TEST(KtxReader, Negative_BadHeader) {
+    std::vector<std::vector<uint8_t> > levels = blockChain(IMAGE_BLOCK_BC1, 4, 4, 1);
+    std::vector<uint8_t> data = makeKtx1(Ktx1Desc(0x83F1, 4, 4), levels);
+    ASSERT_EQ(0, readKtx(data).errorCode);
+
+    std::vector<uint8_t> bad = data;
+    bad[5] = '3';
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readKtx(bad).errorCode);
+    bad = data;
+    bad[12] = 0x02; // endianness
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readKtx(bad).errorCode);
+
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readKtx(makeKtx1(Ktx1Desc(0x9274, 4, 4), levels)).errorCode);
+    Ktx1Desc floats(0x8814, 4, 4);
+    floats.glType = 0x1406;
+    floats.glFormat = KTX_GL_RGBA;
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readKtx(makeKtx1(floats, levels)).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readKtx(makeKtx1(Ktx1Desc(0x83F1, 0, 4), levels)).errorCode);
+    Ktx1Desc faces(0x83F1, 4, 4);
+    faces.faces = 3;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readKtx(makeKtx1(faces, levels)).errorCode);
+    std::vector<std::vector<uint8_t> > tooMany = blockChain(IMAGE_BLOCK_BC1, 4, 4, 4);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readKtx(makeKtx1(Ktx1Desc(0x83F1, 4, 4), tooMany)).errorCode);
+
+    // Basis/zstd supercompression and formats without a decoder
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readKtx(makeKtx2(131, 4, 4, levels, 2)).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readKtx(makeKtx2(0, 4, 4, levels)).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readKtx(makeKtx2(147, 4, 4, levels)).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readKtx(makeKtx2(131, 0x10000, 0x10000, levels)).errorCode);
+}
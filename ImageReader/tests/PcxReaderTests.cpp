@@ -8,13 +8,13 @@
  * - 1-bit and 4-bit images (EGA/CGA)
  * - RLE compression edge cases
  * - Memory reading
+ * - Saving (8-bit paletted and 24-bit planar) with round-trip checks
  * - Generated test fixtures for complete coverage
- *
- * Note: PCX save is not implemented (read-only format in this library)
  */
 
 #include "TestFramework.h"
 #include "PcxReader.h"
+#include <cstdlib>
 #include <cstring>
 
 using namespace TestFramework;
@@ -434,6 +434,31 @@ TEST(PcxReader, Generated_24bit_OddWidth) {
     ASSERT_EQ(25, result.height);
 }
 
+TEST(PcxReader, Generated_24bit_PixelsMatchPlanes) {
+    // 45 columns exercise both the vector interleave and its scalar tail
+    const int width = 45;
+    const int height = 7;
+    std::vector<uint8_t> pcxData = generatePcx24bit(width, height);
+
+    PcxReader reader;
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(0, reader.ReadMemory(pcxData.data(), static_cast<int>(pcxData.size()), &props));
+    ASSERT_TRUE(props != nullptr);
+    bool match = true;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* px = props->m_Format.Image + y * props->m_Format.BytesPerLine;
+        for (int x = 0; x < width; ++x) {
+            uint8_t r = static_cast<uint8_t>((x * 255) / (width - 1));
+            uint8_t g = static_cast<uint8_t>((y * 255) / (height - 1));
+            if (px[x * 4 + 0] != 128 || px[x * 4 + 1] != g || px[x * 4 + 2] != r || px[x * 4 + 3] != 255) {
+                match = false;
+            }
+        }
+    }
+    ASSERT_TRUE(match);
+    ImageReader::FreeBitmapData(props);
+}
+
 //=============================================================================
 // Generated Fixture Tests - 4-bit (16-color)
 //=============================================================================
@@ -456,6 +481,29 @@ TEST(PcxReader, Generated_4bit_Medium) {
     ASSERT_EQ(60, result.height);
 }
 
+TEST(PcxReader, Generated_4bit_PixelsMatchPalette) {
+    // 21 columns: two full plane bytes plus a partial one
+    std::vector<uint8_t> pcxData = generatePcx4bit(21, 19);
+    const uint8_t* colorMap = pcxData.data() + 16;
+
+    PcxReader reader;
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(0, reader.ReadMemory(pcxData.data(), static_cast<int>(pcxData.size()), &props));
+    ASSERT_TRUE(props != nullptr);
+    bool match = true;
+    for (int y = 0; y < 19; ++y) {
+        const uint8_t* px = props->m_Format.Image + y * props->m_Format.BytesPerLine;
+        for (int x = 0; x < 21; ++x) {
+            const uint8_t* rgb = colorMap + ((x + y) % 16) * 3;
+            if (px[x * 4 + 0] != rgb[2] || px[x * 4 + 1] != rgb[1] || px[x * 4 + 2] != rgb[0] || px[x * 4 + 3] != 255) {
+                match = false;
+            }
+        }
+    }
+    ASSERT_TRUE(match);
+    ImageReader::FreeBitmapData(props);
+}
+
 //=============================================================================
 // Generated Fixture Tests - 1-bit Monochrome
 //=============================================================================
@@ -575,6 +623,29 @@ TEST(PcxReader, Truncated_Data) {
     ASSERT_TRUE(result.errorCode == 0 || result.errorCode != 0);
 }
 
+TEST(PcxReader, Limits_DataBeyondFile) {
+    // Every RLE scanline takes a byte at least: 30000 lines cannot fit in this file
+    std::vector<uint8_t> pcxData = generatePcx8bit(16, 16);
+    pcxData[10] = 0x2F;
+    pcxData[11] = 0x75; // yMax = 29999
+    PcxTestResult result = readPcxMemory(pcxData.data(), static_cast<int>(pcxData.size()));
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, result.errorCode);
+}
+
+TEST(PcxReader, Limits_DecodeBudget) {
+    struct RestoreLimits {
+        ~RestoreLimits() { ImageSetDecodeLimits(0, 0); }
+    } restore;
+    std::vector<uint8_t> pcxData = generatePcx8bit(32, 32);
+
+    ImageSetDecodeLimits(32 * 32 - 1, 0);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPcxMemory(pcxData.data(), static_cast<int>(pcxData.size())).errorCode);
+    ImageSetDecodeLimits(0, 32 * 32 * 4 - 1);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPcxMemory(pcxData.data(), static_cast<int>(pcxData.size())).errorCode);
+    ImageSetDecodeLimits(32 * 32, 32 * 32 * 4);
+    ASSERT_EQ(0, readPcxMemory(pcxData.data(), static_cast<int>(pcxData.size())).errorCode);
+}
+
 TEST(PcxReader, Empty_File) {
     uint8_t emptyData[1] = {0};
     PcxTestResult result = readPcxMemory(emptyData, 0);
@@ -607,9 +678,8 @@ TEST(PcxReader, GetReaderInfo) {
 
 TEST(PcxReader, GetOptionsCount) {
     PcxReader reader;
-    int count = reader.GetOptionsCount();
-    // PCX is read-only, so options count may be 0 or minimal
-    ASSERT_TRUE(count >= 0);
+    // Bit depth and RLE save options
+    ASSERT_EQ(2, reader.GetOptionsCount());
 }
 
 TEST(PcxReader, GetFlags) {
@@ -618,12 +688,12 @@ TEST(PcxReader, GetFlags) {
     ASSERT_EQ(15, flags);
 }
 
-TEST(PcxReader, SaveFile_NotImplemented) {
+TEST(PcxReader, SaveFile_NoImage) {
     PcxReader reader;
     CKBitmapProperties props;
     memset(&props, 0, sizeof(props));
 
-    // Save should return 0 (not implemented)
+    // Nothing to save without pixel data
     int result = reader.SaveFile(const_cast<char*>("test.pcx"), &props);
     ASSERT_EQ(0, result);
 }
@@ -773,6 +843,70 @@ TEST(PcxReader, RLE_LiteralBytes) {
     ASSERT_EQ(4, result.height);
 }
 
+TEST(PcxReader, RLE_LongLiteralStretchesBetweenRuns) {
+    // Literal stretches of varying length (crossing 16-byte boundaries) separated by
+    // runs and escaped >= 0xC0 bytes; decoded pixels must match the raw indices
+    const int width = 97;
+    const int height = 5;
+    std::vector<uint8_t> data;
+
+    PCXHeader header;
+    memset(&header, 0, sizeof(header));
+    header.manufacturer = 0x0A;
+    header.version = 5;
+    header.encoding = 1;
+    header.bitsPerPixel = 8;
+    header.xMax = width - 1;
+    header.yMax = height - 1;
+    header.nPlanes = 1;
+    header.bytesPerLine = width + 1;
+    header.paletteInfo = 1;
+
+    const uint8_t* hdr = reinterpret_cast<const uint8_t*>(&header);
+    data.insert(data.end(), hdr, hdr + 128);
+
+    std::vector<uint8_t> raw(header.bytesPerLine * height);
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = &raw[y * header.bytesPerLine];
+        int x = 0;
+        int stretch = 1 + y * 7;
+        while (x < header.bytesPerLine) {
+            for (int i = 0; i < stretch && x < header.bytesPerLine; ++i, ++x) {
+                row[x] = static_cast<uint8_t>((x * 5 + y) % 0xC0 | 1);
+            }
+            for (int i = 0; i < 3 && x < header.bytesPerLine; ++i, ++x) {
+                row[x] = static_cast<uint8_t>(0xC0 + y);
+            }
+            stretch += 11;
+        }
+        pcxRleEncode(row, header.bytesPerLine, data);
+    }
+
+    data.push_back(0x0C);
+    for (int i = 0; i < 256; ++i) {
+        data.push_back(static_cast<uint8_t>(i));
+        data.push_back(static_cast<uint8_t>(i));
+        data.push_back(static_cast<uint8_t>(i));
+    }
+
+    PcxReader reader;
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(0, reader.ReadMemory(data.data(), static_cast<int>(data.size()), &props));
+    ASSERT_TRUE(props != nullptr);
+    bool match = true;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* px = props->m_Format.Image + y * props->m_Format.BytesPerLine;
+        for (int x = 0; x < width; ++x) {
+            uint8_t v = raw[y * header.bytesPerLine + x];
+            if (px[x * 4 + 0] != v || px[x * 4 + 1] != v || px[x * 4 + 2] != v || px[x * 4 + 3] != 255) {
+                match = false;
+            }
+        }
+    }
+    ASSERT_TRUE(match);
+    ImageReader::FreeBitmapData(props);
+}
+
 //=============================================================================
 // Additional Generated Size Tests
 //=============================================================================
@@ -991,6 +1125,338 @@ TEST(PcxReader, Negative_MissingPaletteMarker) {
     ASSERT_TRUE(result.errorCode == 0 || result.errorCode != 0);
 }
 
+//=============================================================================
+// VGA Palette Tests
+//=============================================================================
+
+namespace {
+
+// Rewrites the trailing VGA palette so entry i = (R=i, G=255-i, B=7)
+void writeDistinctPalette(std::vector<uint8_t>& pcx) {
+    size_t pal = pcx.size() - 768;
+    for (int i = 0; i < 256; ++i) {
+        pcx[pal + i * 3 + 0] = static_cast<uint8_t>(i);
+        pcx[pal + i * 3 + 1] = static_cast<uint8_t>(255 - i);
+        pcx[pal + i * 3 + 2] = 7;
+    }
+}
+
+bool checkPalettePixel(const CKBitmapProperties* props, int x, int y) {
+    // generatePcx8bit stores index (x + y) % 256
+    const uint8_t* px = props->m_Format.Image + y * props->m_Format.BytesPerLine + x * 4;
+    uint8_t idx = static_cast<uint8_t>((x + y) % 256);
+    return px[0] == 7 && px[1] == 255 - idx && px[2] == idx && px[3] == 255;
+}
+
+} // anonymous namespace
+
+TEST(PcxReader, Palette_MapsIndicesToBGRA) {
+    std::vector<uint8_t> pcx = generatePcx8bit(33, 9);
+    writeDistinctPalette(pcx);
+
+    PcxReader reader;
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(0, reader.ReadMemory(pcx.data(), static_cast<int>(pcx.size()), &props));
+    ASSERT_TRUE(props != nullptr);
+    ASSERT_TRUE(checkPalettePixel(props, 0, 0));
+    ASSERT_TRUE(checkPalettePixel(props, 5, 3));
+    ASSERT_TRUE(checkPalettePixel(props, 32, 8));
+    ImageReader::FreeBitmapData(props);
+}
+
+TEST(PcxReader, Palette_TrailingDataAfterPalette) {
+    std::vector<uint8_t> pcx = generatePcx8bit(20, 6);
+    writeDistinctPalette(pcx);
+    // Junk after the palette moves it out of the last 769 bytes
+    for (int i = 0; i < 40; ++i) {
+        pcx.push_back(static_cast<uint8_t>(i * 3));
+    }
+
+    PcxReader reader;
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(0, reader.ReadMemory(pcx.data(), static_cast<int>(pcx.size()), &props));
+    ASSERT_TRUE(props != nullptr);
+    ASSERT_TRUE(checkPalettePixel(props, 0, 0));
+    ASSERT_TRUE(checkPalettePixel(props, 19, 5));
+    ImageReader::FreeBitmapData(props);
+}
+
+//=============================================================================
+// Large Image Tests (parallel row decoding)
+//=============================================================================
+
+TEST(PcxReader, Large_8bit_AllPixelsMatch) {
+    std::vector<uint8_t> pcx = generatePcx8bit(600, 300);
+    writeDistinctPalette(pcx);
+
+    PcxReader reader;
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(0, reader.ReadMemory(pcx.data(), static_cast<int>(pcx.size()), &props));
+    ASSERT_TRUE(props != nullptr);
+    bool match = true;
+    for (int y = 0; y < 300 && match; ++y) {
+        for (int x = 0; x < 600; ++x) {
+            if (!checkPalettePixel(props, x, y)) {
+                match = false;
+                break;
+            }
+        }
+    }
+    ASSERT_TRUE(match);
+    ImageReader::FreeBitmapData(props);
+}
+
+TEST(PcxReader, Large_4bit_AllPixelsMatch) {
+    std::vector<uint8_t> pcx = generatePcx4bit(517, 260);
+    const uint8_t* colorMap = pcx.data() + 16;
+
+    PcxReader reader;
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(0, reader.ReadMemory(pcx.data(), static_cast<int>(pcx.size()), &props));
+    ASSERT_TRUE(props != nullptr);
+    bool match = true;
+    for (int y = 0; y < 260; ++y) {
+        const uint8_t* px = props->m_Format.Image + y * props->m_Format.BytesPerLine;
+        for (int x = 0; x < 517; ++x) {
+            const uint8_t* rgb = colorMap + ((x + y) % 16) * 3;
+            if (px[x * 4 + 0] != rgb[2] || px[x * 4 + 1] != rgb[1] || px[x * 4 + 2] != rgb[0]) {
+                match = false;
+            }
+        }
+    }
+    ASSERT_TRUE(match);
+    ImageReader::FreeBitmapData(props);
+}
+
+//=============================================================================
+// Index-Preserving Read Tests (IMAGE_READ_KEEP_INDICES)
+//=============================================================================
+
+namespace {
+
+// generatePcx8bit stores index (x + y) % 256; writeDistinctPalette sets the palette
+bool checkIndexImage(const CKBitmapProperties* props, int width, int height) {
+    const VxImageDescEx& fmt = props->m_Format;
+    if (fmt.BitsPerPixel != 8 || fmt.BytesPerColorEntry != 4 || fmt.ColorMapEntries != 256 ||
+        fmt.Width != width || fmt.Height != height || fmt.BytesPerLine != ((width + 3) & ~3)) {
+        return false;
+    }
+    for (int i = 0; i < 256; ++i) {
+        const uint8_t* entry = fmt.ColorMap + i * 4;
+        if (entry[0] != 7 || entry[1] != 255 - i || entry[2] != i || entry[3] != 255) return false;
+    }
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row = fmt.Image + y * fmt.BytesPerLine;
+        for (int x = 0; x < width; ++x) {
+            if (row[x] != static_cast<uint8_t>((x + y) % 256)) return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+TEST(PcxReader, KeepIndices_8bit) {
+    std::vector<uint8_t> pcx = generatePcx8bit(33, 9);
+    writeDistinctPalette(pcx);
+
+    PcxReader reader;
+    reader.SetReadFlags(IMAGE_READ_KEEP_INDICES);
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(0, reader.ReadMemory(pcx.data(), static_cast<int>(pcx.size()), &props));
+    ASSERT_TRUE(checkIndexImage(props, 33, 9));
+    // Row padding is zeroed
+    ASSERT_EQ(0, props->m_Format.Image[33]);
+    ASSERT_EQ(0, props->m_Format.Image[35]);
+    ImageReader::FreeBitmapData(props);
+}
+
+TEST(PcxReader, KeepIndices_ScanlineWiderThanStride) {
+    // 8 encoded bytes per line but only 3 visible columns
+    std::vector<uint8_t> pcx = generatePcx8bit(8, 4);
+    writeDistinctPalette(pcx);
+    pcx[8] = 2; // xMax
+
+    CKBitmapProperties props;
+    memset(&props, 0, sizeof(props));
+    ASSERT_EQ(0, PCX_Read(pcx.data(), static_cast<int>(pcx.size()), &props, IMAGE_READ_KEEP_INDICES));
+    ASSERT_TRUE(checkIndexImage(&props, 3, 4));
+    ASSERT_EQ(0, props.m_Format.Image[3]);
+    ImageReader::FreeBitmapData(&props);
+}
+
+TEST(PcxReader, KeepIndices_Large) {
+    std::vector<uint8_t> pcx = generatePcx8bit(600, 300);
+    writeDistinctPalette(pcx);
+
+    CKBitmapProperties props;
+    memset(&props, 0, sizeof(props));
+    ASSERT_EQ(0, PCX_Read(pcx.data(), static_cast<int>(pcx.size()), &props, IMAGE_READ_KEEP_INDICES));
+    ASSERT_TRUE(checkIndexImage(&props, 600, 300));
+    ImageReader::FreeBitmapData(&props);
+}
+
+TEST(PcxReader, KeepIndices_IgnoredFor24bit) {
+    std::vector<uint8_t> pcx = generatePcx24bit(10, 10);
+
+    CKBitmapProperties props;
+    memset(&props, 0, sizeof(props));
+    ASSERT_EQ(0, PCX_Read(pcx.data(), static_cast<int>(pcx.size()), &props, IMAGE_READ_KEEP_INDICES));
+    ASSERT_EQ(32, props.m_Format.BitsPerPixel);
+    ASSERT_TRUE(props.m_Format.ColorMap == nullptr);
+    ImageReader::FreeBitmapData(&props);
+}
+
+//=============================================================================
+// Save Tests
+//=============================================================================
+
+namespace {
+
+// Saves BGRA32 pixels to memory with the given options and reads the result back
+bool savePcxAndReload(const std::vector<uint8_t>& pixels, int width, int height, int bitDepth, int useRLE,
+                      std::vector<uint8_t>& encoded, std::vector<uint8_t>& decoded) {
+    PcxBitmapProperties props;
+    ImageReader::FillFormatBGRA32(props.m_Format, width, height, width * 4, const_cast<uint8_t*>(pixels.data()));
+    props.m_BitDepth = bitDepth;
+    props.m_UseRLE = useRLE;
+
+    PcxReader writer;
+    void* memory = nullptr;
+    int size = writer.SaveMemory(&memory, &props);
+    if (size <= 0 || !memory) return false;
+    encoded.assign(static_cast<uint8_t*>(memory), static_cast<uint8_t*>(memory) + size);
+    writer.ReleaseMemory(memory);
+
+    PcxReader reader;
+    CKBitmapProperties* out = nullptr;
+    if (reader.ReadMemory(encoded.data(), size, &out) != 0 || !out) return false;
+    if (out->m_Format.Width != width || out->m_Format.Height != height) return false;
+    decoded.resize(width * height * 4);
+    for (int y = 0; y < height; ++y) {
+        memcpy(&decoded[y * width * 4], out->m_Format.Image + y * out->m_Format.BytesPerLine, width * 4);
+    }
+    return true;
+}
+
+std::vector<uint8_t> makeSavePattern(int width, int height, int colorCount) {
+    std::vector<uint8_t> pixels(width * height * 4);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            // Horizontal runs of 5 pixels plus noise-like literals, alpha always opaque
+            int c = ((x / 5) * 7 + y * 13 + (x % 3 == 0 ? x : 0)) % colorCount;
+            uint8_t* p = &pixels[(y * width + x) * 4];
+            p[0] = static_cast<uint8_t>(c * 37);
+            p[1] = static_cast<uint8_t>(c * 11 + 0xC0);
+            p[2] = static_cast<uint8_t>(c);
+            p[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+} // anonymous namespace
+
+TEST(PcxReader, Save_24bit_RoundTrip) {
+    std::vector<uint8_t> pixels = makeSavePattern(61, 17, 1000);
+    std::vector<uint8_t> encoded, decoded;
+    ASSERT_TRUE(savePcxAndReload(pixels, 61, 17, 24, 1, encoded, decoded));
+    ASSERT_EQ(0x0A, encoded[0]);
+    ASSERT_EQ(1, encoded[2]);  // RLE
+    ASSERT_EQ(3, encoded[65]); // planes
+    ASSERT_TRUE(decoded == pixels);
+}
+
+TEST(PcxReader, Save_24bit_Uncompressed_RoundTrip) {
+    std::vector<uint8_t> pixels = makeSavePattern(30, 9, 1000);
+    std::vector<uint8_t> encoded, decoded;
+    ASSERT_TRUE(savePcxAndReload(pixels, 30, 9, 24, 0, encoded, decoded));
+    ASSERT_EQ(0, encoded[2]);
+    ASSERT_EQ(static_cast<size_t>(128 + 30 * 3 * 9), encoded.size());
+    ASSERT_TRUE(decoded == pixels);
+}
+
+TEST(PcxReader, Save_8bit_ExactPaletteRoundTrip) {
+    // 200 distinct colors fit the palette, so the round trip is lossless
+    std::vector<uint8_t> pixels = makeSavePattern(75, 23, 200);
+    std::vector<uint8_t> encoded, decoded;
+    ASSERT_TRUE(savePcxAndReload(pixels, 75, 23, 8, 1, encoded, decoded));
+    ASSERT_EQ(1, encoded[65]);
+    ASSERT_EQ(0x0C, encoded[encoded.size() - 769]);
+    ASSERT_TRUE(decoded == pixels);
+}
+
+TEST(PcxReader, Save_8bit_TooManyColorsUsesColorCube) {
+    std::vector<uint8_t> pixels = makeSavePattern(64, 32, 1000);
+    std::vector<uint8_t> encoded, decoded;
+    ASSERT_TRUE(savePcxAndReload(pixels, 64, 32, 8, 1, encoded, decoded));
+    // Cube levels are at most 255/10 + 1 away from the source on each channel
+    bool close = true;
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        if (std::abs(static_cast<int>(pixels[i]) - static_cast<int>(decoded[i])) > 26) {
+            close = false;
+        }
+    }
+    ASSERT_TRUE(close);
+}
+
+TEST(PcxReader, Save_RLE_CompressesRuns) {
+    std::vector<uint8_t> pixels(200 * 50 * 4, 0);
+    for (size_t i = 3; i < pixels.size(); i += 4) pixels[i] = 255;
+    std::vector<uint8_t> encoded, decoded;
+    ASSERT_TRUE(savePcxAndReload(pixels, 200, 50, 24, 1, encoded, decoded));
+    // 200 bytes per plane -> 4 runs (63+63+63+11) of 2 bytes, 3 planes, 50 rows
+    ASSERT_EQ(static_cast<size_t>(128 + 4 * 2 * 3 * 50), encoded.size());
+    ASSERT_TRUE(decoded == pixels);
+}
+
+TEST(PcxReader, Save_Large_RoundTrip) {
+    // Large enough to encode rows on the worker pool
+    std::vector<uint8_t> pixels = makeSavePattern(400, 300, 1000);
+    std::vector<uint8_t> encoded, decoded;
+    ASSERT_TRUE(savePcxAndReload(pixels, 400, 300, 24, 1, encoded, decoded));
+    ASSERT_TRUE(decoded == pixels);
+}
+
+TEST(PcxReader, Save_DimensionLimit) {
+    // Images at the read limit round-trip; one pixel more is not written
+    for (int wide = 0; wide < 2; ++wide) {
+        int width = wide ? PCX_MAX_DIMENSION : 2;
+        int height = wide ? 2 : PCX_MAX_DIMENSION;
+        std::vector<uint8_t> pixels = makeSavePattern(width, height, 1000);
+        std::vector<uint8_t> encoded, decoded;
+        ASSERT_TRUE(savePcxAndReload(pixels, width, height, 24, 1, encoded, decoded));
+        ASSERT_TRUE(decoded == pixels);
+
+        int overWidth = wide ? width + 1 : width;
+        int overHeight = wide ? height : height + 1;
+        pixels = makeSavePattern(overWidth, overHeight, 1000);
+        PcxBitmapProperties props;
+        ImageReader::FillFormatBGRA32(props.m_Format, overWidth, overHeight, overWidth * 4, pixels.data());
+        PcxReader writer;
+        void* memory = nullptr;
+        ASSERT_EQ(0, writer.SaveMemory(&memory, &props));
+        ASSERT_TRUE(memory == nullptr);
+    }
+}
+
+TEST(PcxReader, SaveFile_RoundTrip) {
+    std::vector<uint8_t> pixels = makeSavePattern(33, 20, 100);
+    PcxBitmapProperties props;
+    ImageReader::FillFormatBGRA32(props.m_Format, 33, 20, 33 * 4, pixels.data());
+    props.m_BitDepth = 8;
+
+    std::string tempPath = joinPath(g_TestOutputDir, "pcx_save_test.pcx");
+    PcxReader writer;
+    ASSERT_TRUE(writer.SaveFile(const_cast<char*>(tempPath.c_str()), &props) > 0);
+
+    PcxTestResult fileResult = readPcxFile(tempPath);
+    ASSERT_EQ(0, fileResult.errorCode);
+    ASSERT_EQ(33, fileResult.width);
+    ASSERT_EQ(20, fileResult.height);
+    remove(tempPath.c_str());
+}
+
 //=============================================================================
 // Memory vs File Consistency Tests
 //=============================================================================
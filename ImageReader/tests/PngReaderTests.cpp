@@ -0,0 +1,732 @@
+/**
+ * @file PngReaderTests.cpp
+ * @brief PNG format tests for CKImageReader
+ *
+ * Tests cover:
+ * - Inflate of stored, fixed Huffman and dynamic Huffman blocks, and of streams
+ *   ending inside the fast decode loop
+ * - All five row filters at 1, 3, 4 and 8 bytes per pixel (scalar and SIMD paths)
+ * - Adam7 interlacing, sub-byte samples, palettes and tRNS transparency
+ * - 16-bit output (IMAGE_READ_KEEP_16BIT) and index output (IMAGE_READ_KEEP_INDICES)
+ * - The corpus in tests/images/png against CRCs and the image-rs reference images
+ * - Malformed files (bad signature, bad header, bad filter, truncated data)
+ */
+
+#include "TestFramework.h"
+#include "PngReader.h"
+#include "ImageInflate.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using namespace TestFramework;
+
+//=============================================================================
+// Test Helpers
+//=============================================================================
+
+namespace {
+
+void putBE32(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v >> 24));
+    out.push_back(static_cast<uint8_t>(v >> 16));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+uint32_t adler32(const std::vector<uint8_t>& data) {
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < data.size(); ++i) {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+// zlib stream made of stored blocks of at most blockSize bytes
+std::vector<uint8_t> zlibStored(const std::vector<uint8_t>& data, size_t blockSize = 65535) {
+    std::vector<uint8_t> z;
+    z.push_back(0x78);
+    z.push_back(0x01);
+    size_t pos = 0;
+    do {
+        size_t len = std::min(blockSize, data.size() - pos);
+        bool final = (pos + len == data.size());
+        z.push_back(final ? 1 : 0);
+        z.push_back(static_cast<uint8_t>(len));
+        z.push_back(static_cast<uint8_t>(len >> 8));
+        z.push_back(static_cast<uint8_t>(~len));
+        z.push_back(static_cast<uint8_t>(~len >> 8));
+        z.insert(z.end(), data.begin() + pos, data.begin() + pos + len);
+        pos += len;
+    } while (pos < data.size());
+    putBE32(z, adler32(data));
+    return z;
+}
+
+// Deflate bit stream: fields are packed from the low bit, Huffman codes from their top bit
+struct DeflateBits {
+    std::vector<uint8_t> bytes;
+    size_t bitCount = 0;
+
+    void put(uint32_t value, int n) {
+        for (int i = 0; i < n; ++i, ++bitCount) {
+            if (bitCount % 8 == 0) bytes.push_back(0);
+            bytes.back() |= static_cast<uint8_t>(((value >> i) & 1) << (bitCount % 8));
+        }
+    }
+    void putCode(uint32_t code, int n) {
+        for (int i = n - 1; i >= 0; --i) put(code >> i, 1);
+    }
+};
+
+void putChunk(std::vector<uint8_t>& png, const char* type, const std::vector<uint8_t>& data) {
+    putBE32(png, static_cast<uint32_t>(data.size()));
+    std::vector<uint8_t> crcData(type, type + 4);
+    crcData.insert(crcData.end(), data.begin(), data.end());
+    png.insert(png.end(), crcData.begin(), crcData.end());
+    putBE32(png, CRC32::compute(crcData.data(), crcData.size()));
+}
+
+struct PngSpec {
+    uint32_t width;
+    uint32_t height;
+    uint8_t bitDepth;
+    uint8_t colorType;
+    uint8_t interlace;
+    std::vector<uint8_t> plte;
+    std::vector<uint8_t> trns;
+    size_t idatSplit; // split the zlib stream into IDAT chunks of this size (0 = one chunk)
+
+    PngSpec(uint32_t w, uint32_t h, uint8_t depth, uint8_t type)
+        : width(w), height(h), bitDepth(depth), colorType(type), interlace(0), idatSplit(0) {}
+};
+
+// Assembles a PNG file around already filtered image data
+std::vector<uint8_t> makePng(const PngSpec& spec, const std::vector<uint8_t>& filtered) {
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<uint8_t> png(signature, signature + 8);
+
+    std::vector<uint8_t> ihdr;
+    putBE32(ihdr, spec.width);
+    putBE32(ihdr, spec.height);
+    ihdr.push_back(spec.bitDepth);
+    ihdr.push_back(spec.colorType);
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    ihdr.push_back(spec.interlace);
+    putChunk(png, "IHDR", ihdr);
+    if (!spec.plte.empty()) putChunk(png, "PLTE", spec.plte);
+    if (!spec.trns.empty()) putChunk(png, "tRNS", spec.trns);
+
+    std::vector<uint8_t> z = zlibStored(filtered, 1000);
+    size_t split = spec.idatSplit ? spec.idatSplit : z.size();
+    for (size_t pos = 0; pos < z.size(); pos += split) {
+        size_t len = std::min(split, z.size() - pos);
+        putChunk(png, "IDAT", std::vector<uint8_t>(z.begin() + pos, z.begin() + pos + len));
+    }
+    putChunk(png, "IEND", std::vector<uint8_t>());
+    return png;
+}
+
+int paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return (pb <= pc) ? b : c;
+}
+
+// Filters packed rows (rowBytes each) with the filter chosen per row by filterOf(y)
+std::vector<uint8_t> filterRows(const std::vector<uint8_t>& rows, size_t rowBytes, size_t bpp, int (*filterOf)(size_t)) {
+    std::vector<uint8_t> out;
+    size_t height = rowBytes ? rows.size() / rowBytes : 0;
+    std::vector<uint8_t> zero(rowBytes, 0);
+    for (size_t y = 0; y < height; ++y) {
+        const uint8_t* cur = &rows[y * rowBytes];
+        const uint8_t* prev = y ? &rows[(y - 1) * rowBytes] : zero.data();
+        int filter = filterOf(y);
+        out.push_back(static_cast<uint8_t>(filter));
+        for (size_t i = 0; i < rowBytes; ++i) {
+            int a = i >= bpp ? cur[i - bpp] : 0;
+            int b = prev[i];
+            int c = i >= bpp ? prev[i - bpp] : 0;
+            int pred = 0;
+            switch (filter) {
+            case 1: pred = a; break;
+            case 2: pred = b; break;
+            case 3: pred = (a + b) >> 1; break;
+            case 4: pred = paeth(a, b, c); break;
+            }
+            out.push_back(static_cast<uint8_t>(cur[i] - pred));
+        }
+    }
+    return out;
+}
+
+int filterCycle(size_t y) { return static_cast<int>(y % 5); }
+int filterNone(size_t) { return 0; }
+
+// Deterministic pseudo-random bytes mixed with smooth gradients
+std::vector<uint8_t> makeSamples(size_t count, uint32_t seed) {
+    std::vector<uint8_t> data(count);
+    for (size_t i = 0; i < count; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        data[i] = (i % 3 == 0) ? static_cast<uint8_t>(seed >> 16) : static_cast<uint8_t>(i * 7 + (i >> 5));
+    }
+    return data;
+}
+
+struct PngTestResult {
+    int errorCode;
+    int width;
+    int height;
+    int bitsPerPixel;
+    std::vector<uint8_t> pixels; // tightly packed rows
+    std::vector<uint8_t> colorMap;
+};
+
+PngTestResult readPng(const std::vector<uint8_t>& data, CKDWORD flags = 0) {
+    PngTestResult result;
+    PngReader reader;
+    reader.SetReadFlags(flags);
+    CKBitmapProperties* props = nullptr;
+    result.errorCode = reader.ReadMemory(const_cast<uint8_t*>(data.data()), static_cast<int>(data.size()), &props);
+    result.width = 0;
+    result.height = 0;
+    result.bitsPerPixel = 0;
+    if (result.errorCode == 0 && props && props->m_Format.Image) {
+        const VxImageDescEx& fmt = props->m_Format;
+        result.width = fmt.Width;
+        result.height = fmt.Height;
+        result.bitsPerPixel = fmt.BitsPerPixel;
+        size_t rowBytes = static_cast<size_t>(fmt.Width) * fmt.BitsPerPixel / 8;
+        result.pixels.resize(rowBytes * fmt.Height);
+        for (int y = 0; y < fmt.Height; ++y) {
+            memcpy(&result.pixels[y * rowBytes], fmt.Image + y * fmt.BytesPerLine, rowBytes);
+        }
+        if (fmt.ColorMap) {
+            result.colorMap.assign(fmt.ColorMap, fmt.ColorMap + fmt.ColorMapEntries * 4);
+        }
+    }
+    return result;
+}
+
+PngTestResult readPngFile(const std::string& path, CKDWORD flags = 0) {
+    return readPng(readBinaryFile(path), flags);
+}
+
+// Expected BGRA32 pixels of 8-bit RGB/RGBA samples
+std::vector<uint8_t> expectBGRA(const std::vector<uint8_t>& samples, size_t channels) {
+    std::vector<uint8_t> out;
+    for (size_t i = 0; i + channels <= samples.size(); i += channels) {
+        out.push_back(samples[i + 2]);
+        out.push_back(samples[i + 1]);
+        out.push_back(samples[i]);
+        out.push_back(channels == 4 ? samples[i + 3] : 255);
+    }
+    return out;
+}
+
+// Splits an image into Adam7 passes and filters each pass
+std::vector<uint8_t> interlace(const std::vector<uint8_t>& samples, uint32_t width, uint32_t height, size_t bpp) {
+    static const uint32_t x0[7] = {0, 4, 0, 2, 0, 1, 0}, y0[7] = {0, 0, 4, 0, 2, 0, 1};
+    static const uint32_t dx[7] = {8, 8, 4, 4, 2, 2, 1}, dy[7] = {8, 8, 8, 4, 4, 2, 2};
+    std::vector<uint8_t> out;
+    for (int p = 0; p < 7; ++p) {
+        std::vector<uint8_t> pass;
+        uint32_t passWidth = 0, passHeight = 0;
+        for (uint32_t y = y0[p]; y < height; y += dy[p], ++passHeight) {
+            passWidth = 0;
+            for (uint32_t x = x0[p]; x < width; x += dx[p], ++passWidth) {
+                pass.insert(pass.end(), samples.begin() + (y * width + x) * bpp,
+                            samples.begin() + (y * width + x + 1) * bpp);
+            }
+        }
+        if (passWidth == 0 || passHeight == 0) continue;
+        std::vector<uint8_t> filtered = filterRows(pass, passWidth * bpp, bpp, filterCycle);
+        out.insert(out.end(), filtered.begin(), filtered.end());
+    }
+    return out;
+}
+
+} // anonymous namespace
+
+//=============================================================================
+// Inflate Tests
+//=============================================================================
+
+TEST(PngReader, Inflate_StoredBlocks) {
+    std::vector<uint8_t> data = makeSamples(5000, 1);
+    std::vector<uint8_t> z = zlibStored(data, 777);
+    std::vector<uint8_t> out(data.size());
+    CKDWORD written = 0;
+    ASSERT_TRUE(ImageZlibInflate(z.data(), static_cast<CKDWORD>(z.size()), out.data(), static_cast<CKDWORD>(out.size()), &written));
+    ASSERT_EQ(static_cast<CKDWORD>(data.size()), written);
+    ASSERT_TRUE(out == data);
+}
+
+TEST(PngReader, Inflate_FixedHuffman) {
+    // zlib level 9, Z_FIXED, raw deflate of "Deflate, deflate, deflate! " x 4 followed by bytes 0..39
+    static const uint8_t stream[] = {
+        0x73, 0x49, 0x4d, 0xcb, 0x49, 0x2c, 0x49, 0xd5, 0x51, 0x48, 0x41, 0x63, 0x28, 0x2a, 0xb8, 0x50,
+        0x5b, 0x8a, 0x81, 0x91, 0x89, 0x99, 0x85, 0x95, 0x8d, 0x9d, 0x83, 0x93, 0x8b, 0x9b, 0x87, 0x97,
+        0x8f, 0x5f, 0x40, 0x50, 0x48, 0x58, 0x44, 0x54, 0x4c, 0x5c, 0x42, 0x52, 0x4a, 0x5a, 0x46, 0x56,
+        0x4e, 0x5e, 0x41, 0x51, 0x49, 0x59, 0x45, 0x55, 0x4d, 0x1d, 0x00};
+    std::string text;
+    for (int i = 0; i < 4; ++i) text += "Deflate, deflate, deflate! ";
+    std::vector<uint8_t> expected(text.begin(), text.end());
+    for (int i = 0; i < 40; ++i) expected.push_back(static_cast<uint8_t>(i));
+
+    std::vector<uint8_t> out(expected.size());
+    CKDWORD written = 0;
+    ASSERT_TRUE(ImageInflate(stream, sizeof(stream), out.data(), static_cast<CKDWORD>(out.size()), &written));
+    ASSERT_EQ(static_cast<CKDWORD>(expected.size()), written);
+    ASSERT_TRUE(out == expected);
+}
+
+TEST(PngReader, Inflate_DynamicHuffman) {
+    // zlib level 9, raw deflate of 120 bytes drawn from "aaaabbc" by an LCG
+    static const uint8_t stream[] = {
+        0x4d, 0x8c, 0x81, 0x0d, 0x00, 0x20, 0x0c, 0xc2, 0x6e, 0x85, 0xfe, 0xff, 0x83, 0x82, 0x33, 0xba,
+        0x6c, 0x01, 0x42, 0x56, 0xb0, 0x25, 0x59, 0x95, 0x98, 0x37, 0xdb, 0xe3, 0x6c, 0x3a, 0x4f, 0x77,
+        0x3c, 0xa6, 0x92, 0x38, 0x2f, 0x05, 0xe5, 0x40, 0x97, 0x56, 0xee, 0x8e, 0x7c, 0xe4, 0xe2, 0xbc, 0x00};
+    std::vector<uint8_t> expected;
+    uint32_t seed = 12345;
+    for (int i = 0; i < 120; ++i) {
+        seed = (seed * 1103515245u + 12345u) & 0x7FFFFFFF;
+        expected.push_back(static_cast<uint8_t>("aaaabbc"[(seed >> 16) % 7]));
+    }
+
+    std::vector<uint8_t> out(expected.size());
+    CKDWORD written = 0;
+    ASSERT_TRUE(ImageInflate(stream, sizeof(stream), out.data(), static_cast<CKDWORD>(out.size()), &written));
+    ASSERT_EQ(static_cast<CKDWORD>(expected.size()), written);
+    ASSERT_TRUE(out == expected);
+
+    // Every truncation must fail rather than read past the input
+    for (size_t len = 0; len < sizeof(stream) - 1; ++len) {
+        ASSERT_FALSE(ImageInflate(stream, static_cast<CKDWORD>(len), out.data(), static_cast<CKDWORD>(out.size()), &written));
+    }
+}
+
+TEST(PngReader, Inflate_FastLoopStopsAtInputEnd) {
+    // Fixed Huffman pairs of a literal and a match, up to the last input byte.
+    // Matches with many extra bits leave the bit buffer low, so the fast loop
+    // starts its last rounds with few bytes left and refills after the
+    // literal. Every pair count ends the stream at a different bit position.
+    for (int pairs = 1; pairs <= 48; ++pairs) {
+        DeflateBits bits;
+        bits.put(1, 1); // final block
+        bits.put(1, 2); // fixed Huffman
+        std::vector<uint8_t> expected;
+        for (int i = 0; i < pairs; ++i) {
+            uint8_t literal = static_cast<uint8_t>('a' + i % 26);
+            bits.putCode(0x30 + literal, 8);
+            expected.push_back(literal);
+
+            // Length 227 + 0..30 (symbol 284), then distance 1, or 513 + 0..255
+            // (code 18) once there is enough output
+            uint32_t lengthExtra = (i * 7) % 31;
+            bits.putCode(0xC4, 8);
+            bits.put(lengthExtra, 5);
+            uint32_t distance = 1;
+            if (expected.size() >= 768) {
+                uint32_t distanceExtra = (i * 37) & 255;
+                bits.putCode(18, 5);
+                bits.put(distanceExtra, 8);
+                distance = 513 + distanceExtra;
+            } else {
+                bits.putCode(0, 5);
+            }
+            for (uint32_t n = 0; n < 227 + lengthExtra; ++n)
+                expected.push_back(expected[expected.size() - distance]);
+        }
+        bits.putCode(0, 7); // end of block
+
+        // The stream ends its heap block, at every alignment so that an
+        // address checker sees 8-byte loads past the end. The output is large
+        // enough for the fast loop to run out of input first.
+        for (size_t shift = 0; shift < 8; ++shift) {
+            std::vector<uint8_t> block(shift + bits.bytes.size());
+            std::copy(bits.bytes.begin(), bits.bytes.end(), block.begin() + shift);
+            std::vector<uint8_t> out(expected.size() + 512);
+            CKDWORD written = 0;
+            ASSERT_TRUE(ImageInflate(block.data() + shift, static_cast<CKDWORD>(bits.bytes.size()), out.data(),
+                                     static_cast<CKDWORD>(out.size()), &written));
+            ASSERT_EQ(static_cast<CKDWORD>(expected.size()), written);
+            ASSERT_TRUE(std::equal(expected.begin(), expected.end(), out.begin()));
+        }
+    }
+}
+
+TEST(PngReader, Inflate_Rejects) {
+    std::vector<uint8_t> data = makeSamples(100, 2);
+    std::vector<uint8_t> z = zlibStored(data);
+    std::vector<uint8_t> out(data.size());
+    CKDWORD written = 0;
+
+    // Output too small
+    ASSERT_FALSE(ImageZlibInflate(z.data(), static_cast<CKDWORD>(z.size()), out.data(), 99, &written));
+    // Bad zlib header check bits, preset dictionary
+    std::vector<uint8_t> bad = z;
+    bad[1] ^= 1;
+    ASSERT_FALSE(ImageZlibInflate(bad.data(), static_cast<CKDWORD>(bad.size()), out.data(), 100, &written));
+    bad = z;
+    bad[0] = 0x78;
+    bad[1] = 0xBB; // FDICT set, (0x78BB % 31) == 0
+    ASSERT_FALSE(ImageZlibInflate(bad.data(), static_cast<CKDWORD>(bad.size()), out.data(), 100, &written));
+    // Stored block LEN/NLEN mismatch
+    bad = z;
+    bad[5] ^= 0xFF;
+    ASSERT_FALSE(ImageZlibInflate(bad.data(), static_cast<CKDWORD>(bad.size()), out.data(), 100, &written));
+    // Reserved block type 3
+    const uint8_t reserved[] = {0x07, 0x00};
+    ASSERT_FALSE(ImageInflate(reserved, sizeof(reserved), out.data(), 100, &written));
+}
+
+//=============================================================================
+// Filter Tests
+//=============================================================================
+
+TEST(PngReader, Filters_RGBA8) {
+    const uint32_t w = 37, h = 20;
+    std::vector<uint8_t> samples = makeSamples(w * h * 4, 3);
+    PngSpec spec(w, h, 8, PNG_COLOR_RGBA);
+    PngTestResult r = readPng(makePng(spec, filterRows(samples, w * 4, 4, filterCycle)));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == expectBGRA(samples, 4));
+}
+
+TEST(PngReader, Filters_RGB8) {
+    const uint32_t w = 41, h = 15;
+    std::vector<uint8_t> samples = makeSamples(w * h * 3, 4);
+    PngSpec spec(w, h, 8, PNG_COLOR_RGB);
+    PngTestResult r = readPng(makePng(spec, filterRows(samples, w * 3, 3, filterCycle)));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == expectBGRA(samples, 3));
+}
+
+TEST(PngReader, Filters_Gray8) {
+    const uint32_t w = 19, h = 10;
+    std::vector<uint8_t> samples = makeSamples(w * h, 5);
+    PngSpec spec(w, h, 8, PNG_COLOR_GRAY);
+    PngTestResult r = readPng(makePng(spec, filterRows(samples, w, 1, filterCycle)));
+    ASSERT_EQ(0, r.errorCode);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        ASSERT_EQ(samples[i], r.pixels[i * 4]);
+        ASSERT_EQ(samples[i], r.pixels[i * 4 + 2]);
+        ASSERT_EQ(255, r.pixels[i * 4 + 3]);
+    }
+}
+
+TEST(PngReader, Filters_RGBA16) {
+    const uint32_t w = 13, h = 10;
+    std::vector<uint8_t> samples = makeSamples(w * h * 8, 6);
+    PngSpec spec(w, h, 16, PNG_COLOR_RGBA);
+    PngTestResult r = readPng(makePng(spec, filterRows(samples, w * 8, 8, filterCycle)));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(32, r.bitsPerPixel);
+    for (size_t i = 0; i < w * h; ++i) {
+        const uint8_t* s = &samples[i * 8];
+        ASSERT_EQ(s[4], r.pixels[i * 4]);     // B high byte
+        ASSERT_EQ(s[2], r.pixels[i * 4 + 1]); // G
+        ASSERT_EQ(s[0], r.pixels[i * 4 + 2]); // R
+        ASSERT_EQ(s[6], r.pixels[i * 4 + 3]); // A
+    }
+}
+
+TEST(PngReader, Filters_InvalidType) {
+    PngSpec spec(2, 2, 8, PNG_COLOR_RGB);
+    std::vector<uint8_t> filtered = filterRows(makeSamples(12, 7), 6, 3, filterNone);
+    filtered[7] = 5;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPng(makePng(spec, filtered)).errorCode);
+}
+
+//=============================================================================
+// Sample Format Tests
+//=============================================================================
+
+TEST(PngReader, Gray_SubByteDepthsScaleTo8Bit) {
+    // 1-bit: 0 -> 0, 1 -> 255; 2-bit: 85 per step; 4-bit: 17 per step
+    const uint8_t depths[3] = {1, 2, 4};
+    for (int d = 0; d < 3; ++d) {
+        uint8_t depth = depths[d];
+        uint32_t maxValue = (1u << depth) - 1;
+        const uint32_t w = 11; // not a whole number of bytes
+        std::vector<uint8_t> row((w * depth + 7) / 8, 0);
+        for (uint32_t x = 0; x < w; ++x) {
+            uint32_t v = x & maxValue;
+            row[x * depth / 8] |= static_cast<uint8_t>(v << (8 - depth - (x * depth) % 8));
+        }
+        PngSpec spec(w, 1, depth, PNG_COLOR_GRAY);
+        PngTestResult r = readPng(makePng(spec, filterRows(row, row.size(), 1, filterNone)));
+        ASSERT_EQ(0, r.errorCode);
+        for (uint32_t x = 0; x < w; ++x) {
+            ASSERT_EQ(static_cast<int>((x & maxValue) * 255 / maxValue), static_cast<int>(r.pixels[x * 4 + 1]));
+        }
+    }
+}
+
+TEST(PngReader, Palette_WithTransparency) {
+    PngSpec spec(4, 1, 2, PNG_COLOR_PALETTE);
+    uint8_t plte[] = {255, 0, 0, 0, 255, 0, 0, 0, 255};
+    spec.plte.assign(plte, plte + 9);
+    spec.trns.push_back(128); // only entry 0 has alpha
+    std::vector<uint8_t> row(1, 0x1B); // indices 0, 1, 2, 3 (3 is out of range)
+    PngTestResult r = readPng(makePng(spec, filterRows(row, 1, 1, filterNone)));
+    ASSERT_EQ(0, r.errorCode);
+    const uint8_t expected[16] = {0, 0, 255, 128, 0, 255, 0, 255, 255, 0, 0, 255, 0, 0, 0, 255};
+    ASSERT_TRUE(memcmp(expected, r.pixels.data(), 16) == 0);
+}
+
+TEST(PngReader, Palette_KeepIndices) {
+    PngSpec spec(5, 2, 8, PNG_COLOR_PALETTE);
+    uint8_t plte[] = {10, 20, 30, 40, 50, 60, 70, 80, 90};
+    spec.plte.assign(plte, plte + 9);
+    std::vector<uint8_t> indices = {0, 1, 2, 1, 0, 2, 2, 1, 0, 0};
+    PngTestResult r = readPng(makePng(spec, filterRows(indices, 5, 1, filterCycle)), IMAGE_READ_KEEP_INDICES);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(8, r.bitsPerPixel);
+    ASSERT_TRUE(r.pixels == indices);
+    ASSERT_EQ(static_cast<size_t>(3 * 4), r.colorMap.size());
+    ASSERT_EQ(60, r.colorMap[4]);
+    ASSERT_EQ(50, r.colorMap[5]);
+    ASSERT_EQ(40, r.colorMap[6]);
+    ASSERT_EQ(255, r.colorMap[7]);
+}
+
+TEST(PngReader, Palette_MissingPLTE) {
+    PngSpec spec(2, 1, 8, PNG_COLOR_PALETTE);
+    std::vector<uint8_t> row(2, 0);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPng(makePng(spec, filterRows(row, 2, 1, filterNone))).errorCode);
+}
+
+TEST(PngReader, ColorKey_RGB8) {
+    PngSpec spec(3, 1, 8, PNG_COLOR_RGB);
+    uint8_t trns[] = {0, 1, 0, 2, 0, 3};
+    spec.trns.assign(trns, trns + 6);
+    std::vector<uint8_t> row = {1, 2, 3, 4, 5, 6, 1, 2, 3};
+    PngTestResult r = readPng(makePng(spec, filterRows(row, 9, 3, filterNone)));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(0, r.pixels[3]);
+    ASSERT_EQ(255, r.pixels[7]);
+    ASSERT_EQ(0, r.pixels[11]);
+    ASSERT_EQ(3, r.pixels[8]);
+}
+
+TEST(PngReader, Keep16Bit_RGBA16) {
+    const uint32_t w = 7, h = 3;
+    std::vector<uint8_t> samples = makeSamples(w * h * 8, 8);
+    PngSpec spec(w, h, 16, PNG_COLOR_RGBA);
+    std::vector<uint8_t> png = makePng(spec, filterRows(samples, w * 8, 8, filterCycle));
+
+    PngTestResult r = readPng(png, IMAGE_READ_KEEP_16BIT);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(64, r.bitsPerPixel);
+    for (size_t i = 0; i < w * h; ++i) {
+        const uint8_t* s = &samples[i * 8];
+        const uint8_t* p = &r.pixels[i * 8];
+        // Little-endian B, G, R, A words from big-endian R, G, B, A samples
+        ASSERT_EQ(s[5], p[0]); ASSERT_EQ(s[4], p[1]);
+        ASSERT_EQ(s[3], p[2]); ASSERT_EQ(s[2], p[3]);
+        ASSERT_EQ(s[1], p[4]); ASSERT_EQ(s[0], p[5]);
+        ASSERT_EQ(s[7], p[6]); ASSERT_EQ(s[6], p[7]);
+    }
+
+    // 8-bit images are unaffected by the flag
+    PngSpec spec8(2, 1, 8, PNG_COLOR_RGB);
+    std::vector<uint8_t> row = makeSamples(6, 9);
+    ASSERT_EQ(32, readPng(makePng(spec8, filterRows(row, 6, 3, filterNone)), IMAGE_READ_KEEP_16BIT).bitsPerPixel);
+}
+
+//=============================================================================
+// Interlacing and Chunking Tests
+//=============================================================================
+
+TEST(PngReader, Interlaced_MatchesProgressive) {
+    // Small sizes leave some Adam7 passes empty
+    const uint32_t sizes[][2] = {{1, 1}, {3, 2}, {5, 9}, {8, 8}, {17, 13}};
+    for (int s = 0; s < 5; ++s) {
+        uint32_t w = sizes[s][0], h = sizes[s][1];
+        std::vector<uint8_t> samples = makeSamples(w * h * 3, 10 + s);
+        PngSpec progressive(w, h, 8, PNG_COLOR_RGB);
+        PngSpec interlaced = progressive;
+        interlaced.interlace = 1;
+
+        PngTestResult a = readPng(makePng(progressive, filterRows(samples, w * 3, 3, filterCycle)));
+        PngTestResult b = readPng(makePng(interlaced, interlace(samples, w, h, 3)));
+        ASSERT_EQ(0, a.errorCode);
+        ASSERT_EQ(0, b.errorCode);
+        ASSERT_TRUE(a.pixels == b.pixels);
+        ASSERT_TRUE(a.pixels == expectBGRA(samples, 3));
+    }
+}
+
+TEST(PngReader, MultipleIDATChunks) {
+    const uint32_t w = 30, h = 30;
+    std::vector<uint8_t> samples = makeSamples(w * h * 4, 11);
+    PngSpec spec(w, h, 8, PNG_COLOR_RGBA);
+    spec.idatSplit = 333;
+    PngTestResult r = readPng(makePng(spec, filterRows(samples, w * 4, 4, filterCycle)));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == expectBGRA(samples, 4));
+}
+
+//=============================================================================
+// Corpus Tests
+//=============================================================================
+
+TEST(PngReader, Corpus_ReferenceCrcs) {
+    static const char* files[] = {
+        "16bpc/basi0g16.png", "16bpc/basn2c16.png", "16bpc/basn6a16.png", "apng/ball.png",
+        "bugfixes/debug_triangle_corners_widescreen.png", "bugfixes/issue#2026.png", "bugfixes/issue#403.png",
+        "interlaced/basi2c08.png", "iptc.png", "transparency/acid2.png", "transparency/tbbn0g04.png",
+        "transparency/tbbn3p08.png", "transparency/tbrn2c08.png", "transparency/tm3n3p02.png",
+        "transparency/tp0n0g08.png", "transparency/tp0n2c08.png", "transparency/tp0n3p08.png",
+        "transparency/tp1n3p08_xmp.png"};
+    std::string pngDir = joinPath(g_TestImagesDir, "png");
+    int checked = 0;
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i) {
+        std::string path = joinPath(pngDir, files[i]);
+        uint32_t crc = 0;
+        if (!fileExists(path) || !getReferenceCrc(std::string("png/") + files[i], crc)) continue;
+        PngTestResult r = readPngFile(path);
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_CRC(crc, r.pixels.data(), r.pixels.size());
+        ++checked;
+    }
+    if (checked == 0) SKIP_TEST("PNG corpus or reference CRCs not found");
+}
+
+TEST(PngReader, Corpus_MatchesReferenceImages) {
+    // Every reference is itself a PNG holding the expected pixels in a plainer
+    // layout (e.g. RGBA8 for a palette image), so both must decode identically
+    static const char* subdirs[] = {"16bpc", "bugfixes", "interlaced", "transparency"};
+    int compared = 0;
+    for (size_t d = 0; d < sizeof(subdirs) / sizeof(subdirs[0]); ++d) {
+        std::string imageDir = joinPath(joinPath(g_TestImagesDir, "png"), subdirs[d]);
+        std::string refDir = joinPath(joinPath(g_TestReferenceDir, "png"), subdirs[d]);
+        std::vector<std::string> refs = listDirectory(refDir);
+        for (size_t i = 0; i < refs.size(); ++i) {
+            ReferenceInfo info = parseReferenceFilename(refs[i]);
+            std::string imagePath = joinPath(imageDir, info.inputName);
+            if (!info.valid || !fileExists(imagePath)) continue;
+
+            PngTestResult image = readPngFile(imagePath);
+            PngTestResult ref = readPngFile(joinPath(refDir, refs[i]));
+            ASSERT_EQ(0, image.errorCode);
+            ASSERT_EQ(0, ref.errorCode);
+            ASSERT_EQ(ref.width, image.width);
+            ASSERT_EQ(ref.height, image.height);
+            ASSERT_TRUE(ref.pixels == image.pixels);
+            ++compared;
+        }
+    }
+    if (compared == 0) SKIP_TEST("PNG reference images not found");
+}
+
+TEST(PngReader, Corpus_Keep16BitMatchesHighBytes) {
+    std::string path = joinPath(joinPath(g_TestImagesDir, "png"), "16bpc/basn6a16.png");
+    if (!fileExists(path)) SKIP_TEST("basn6a16.png not found");
+
+    PngTestResult narrow = readPngFile(path);
+    PngTestResult wide = readPngFile(path, IMAGE_READ_KEEP_16BIT);
+    ASSERT_EQ(0, narrow.errorCode);
+    ASSERT_EQ(0, wide.errorCode);
+    ASSERT_EQ(64, wide.bitsPerPixel);
+    ASSERT_EQ(narrow.pixels.size() * 2, wide.pixels.size());
+    for (size_t i = 0; i < narrow.pixels.size(); ++i) {
+        ASSERT_EQ(narrow.pixels[i], wide.pixels[i * 2 + 1]);
+    }
+}
+
+TEST(PngReader, Corpus_ReportsSourceFormat) {
+    std::string path = joinPath(joinPath(g_TestImagesDir, "png"), "transparency/tbbn0g04.png");
+    if (!fileExists(path)) SKIP_TEST("tbbn0g04.png not found");
+
+    PngReader reader;
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(0, reader.ReadFile(const_cast<char*>(path.c_str()), &props));
+    ASSERT_EQ(static_cast<int>(sizeof(PngBitmapProperties)), props->m_Size);
+    ASSERT_EQ(4u, reinterpret_cast<PngBitmapProperties*>(props)->m_BitDepth);
+    ASSERT_EQ(static_cast<CKDWORD>(PNG_COLOR_GRAY), reinterpret_cast<PngBitmapProperties*>(props)->m_ColorType);
+}
+
+//=============================================================================
+// Negative Tests
+//=============================================================================
+
+TEST(PngReader, Negative_BadSignature) {
+    PngSpec spec(1, 1, 8, PNG_COLOR_GRAY);
+    std::vector<uint8_t> png = makePng(spec, std::vector<uint8_t>(2, 0));
+    png[1] = 'X';
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readPng(png).errorCode);
+    png.resize(5);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readPng(png).errorCode);
+}
+
+TEST(PngReader, Negative_BadHeader) {
+    std::vector<uint8_t> row(4, 0);
+    PngSpec zeroWidth(0, 1, 8, PNG_COLOR_GRAY);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPng(makePng(zeroWidth, row)).errorCode);
+    PngSpec badDepth(1, 1, 4, PNG_COLOR_RGB);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPng(makePng(badDepth, row)).errorCode);
+    PngSpec badType(1, 1, 8, 5);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPng(makePng(badType, row)).errorCode);
+    PngSpec badInterlace(1, 1, 8, PNG_COLOR_GRAY);
+    badInterlace.interlace = 2;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPng(makePng(badInterlace, row)).errorCode);
+    PngSpec tooLarge(65536, 65536, 8, PNG_COLOR_GRAY);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPng(makePng(tooLarge, row)).errorCode);
+}
+
+TEST(PngReader, Negative_TruncatedImageData) {
+    const uint32_t w = 16, h = 16;
+    PngSpec spec(w, h, 8, PNG_COLOR_RGBA);
+    std::vector<uint8_t> filtered = filterRows(makeSamples(w * h * 4, 12), w * 4, 4, filterCycle);
+    filtered.resize(filtered.size() - 100);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPng(makePng(spec, filtered)).errorCode);
+
+    // File cut in the middle of IDAT
+    std::vector<uint8_t> png = makePng(spec, filterRows(makeSamples(w * h * 4, 12), w * 4, 4, filterCycle));
+    png.resize(png.size() / 2);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPng(png).errorCode);
+}
+
+TEST(PngReader, Negative_DecodeLimits) {
+    struct RestoreLimits {
+        ~RestoreLimits() { ImageSetDecodeLimits(0, 0); }
+    } restore;
+    const uint32_t w = 7, h = 3;
+    PngSpec spec(w, h, 16, PNG_COLOR_RGBA);
+    std::vector<uint8_t> png = makePng(spec, filterRows(makeSamples(w * h * 8, 13), w * 8, 8, filterCycle));
+
+    ImageSetDecodeLimits(w * h - 1, 0);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPng(png).errorCode);
+
+    // The block size follows the output format
+    ImageSetDecodeLimits(w * h, w * h * 4);
+    ASSERT_EQ(0, readPng(png).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPng(png, IMAGE_READ_KEEP_16BIT).errorCode);
+}
+
+//=============================================================================
+// API Tests
+//=============================================================================
+
+TEST(PngReader, GetReaderInfo) {
+    PngReader reader;
+    CKPluginInfo* info = reader.GetReaderInfo();
+    ASSERT_TRUE(info != nullptr);
+    ASSERT_GUID_EQ(PNGREADER_GUID, info->m_GUID);
+}
+
+TEST(PngReader, ReadOnly) {
+    PngReader reader;
+    PngBitmapProperties props;
+    std::vector<uint8_t> pixels(4 * 4, 0);
+    ImageReader::FillFormatBGRA32(props.m_Format, 2, 2, 8, pixels.data());
+    void* memory = nullptr;
+    ASSERT_EQ(0, reader.SaveMemory(&memory, &props));
+    ASSERT_EQ(0, reader.SaveFile(const_cast<char*>("test.png"), &props));
+}
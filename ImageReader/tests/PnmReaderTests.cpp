@@ -0,0 +1,524 @@
+/**
+ * @file PnmReaderTests.cpp
+ * @brief Netpbm format tests for CKImageReader
+ *
+ * Tests cover:
+ * - The SSE2 gray, bit expansion and byte swap kernels against scalar loops
+ * - Plain and raw bitmaps, graymaps and pixmaps, and PAM with 1 to 4
+ *   channels, at several maxvals, to BGRA32 and BGRA64
+ * - Plain rasters with comments, odd separators and long numbers, and ones
+ *   large enough to be tokenized in parallel chunks
+ * - The corpus in tests/images/pbm against CRCs and the reference images
+ * - Malformed files (bad headers, truncated rasters, huge dimensions)
+ */
+
+#include "TestFramework.h"
+#include "PnmReader.h"
+#include "PngReader.h"
+#include "ImageSimd.h"
+#include <cstdio>
+#include <cstring>
+
+using namespace TestFramework;
+
+//=============================================================================
+// Test Helpers
+//=============================================================================
+
+namespace {
+
+uint32_t g_Seed = 12345;
+
+uint32_t nextRandom() {
+    g_Seed = g_Seed * 1103515245u + 12345u;
+    return g_Seed >> 8;
+}
+
+// Samples of a test image, depth per pixel, in top-down order
+struct PnmImage {
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+    uint32_t maxValue;
+    std::vector<uint16_t> samples;
+
+    PnmImage(uint32_t w, uint32_t h, uint32_t d, uint32_t maxval)
+        : width(w), height(h), depth(d), maxValue(maxval), samples(w * h * d) {
+        for (size_t i = 0; i < samples.size(); ++i) samples[i] = static_cast<uint16_t>(nextRandom() % (maxval + 1));
+    }
+};
+
+std::string header(int format, const PnmImage& img) {
+    char text[256];
+    if (format == PNM_ARBITRARY_MAP) {
+        static const char* tuples[] = {"GRAYSCALE", "GRAYSCALE_ALPHA", "RGB", "RGB_ALPHA"};
+        snprintf(text, sizeof(text), "P7\nWIDTH %u\nHEIGHT %u\nDEPTH %u\nMAXVAL %u\nTUPLTYPE %s\nENDHDR\n", img.width,
+                 img.height, img.depth, img.maxValue, tuples[img.depth - 1]);
+    } else if (format == PNM_PLAIN_BITMAP || format == PNM_RAW_BITMAP) {
+        snprintf(text, sizeof(text), "P%d\n%u %u\n", format, img.width, img.height);
+    } else {
+        snprintf(text, sizeof(text), "P%d\n%u %u\n%u\n", format, img.width, img.height, img.maxValue);
+    }
+    return text;
+}
+
+// Raw raster: packed bits for P4, big-endian samples above 255
+std::vector<uint8_t> makeRaw(int format, const PnmImage& img) {
+    std::string text = header(format, img);
+    std::vector<uint8_t> out(text.begin(), text.end());
+    if (format == PNM_RAW_BITMAP) {
+        for (uint32_t y = 0; y < img.height; ++y) {
+            for (uint32_t x = 0; x < img.width; x += 8) {
+                uint8_t byte = 0;
+                for (uint32_t b = 0; b < 8 && x + b < img.width; ++b)
+                    if (img.samples[y * img.width + x + b]) byte |= static_cast<uint8_t>(0x80 >> b);
+                out.push_back(byte);
+            }
+        }
+        return out;
+    }
+    for (size_t i = 0; i < img.samples.size(); ++i) {
+        if (img.maxValue > 255) out.push_back(static_cast<uint8_t>(img.samples[i] >> 8));
+        out.push_back(static_cast<uint8_t>(img.samples[i]));
+    }
+    return out;
+}
+
+// Plain raster with varied separators; bits of P1 are packed together
+std::vector<uint8_t> makePlain(int format, const PnmImage& img) {
+    static const char* separators[] = {" ", "\n", "  ", "\t", "\r\n", " \n "};
+    std::string text = header(format, img);
+    for (size_t i = 0; i < img.samples.size(); ++i) {
+        char number[16];
+        snprintf(number, sizeof(number), "%u", img.samples[i]);
+        text += number;
+        if (format != PNM_PLAIN_BITMAP || i % 9 == 8) text += separators[nextRandom() % 6];
+    }
+    return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+uint8_t scale8(uint32_t v, uint32_t maxval) {
+    if (maxval == 65535) return static_cast<uint8_t>(v >> 8);
+    if (v > maxval) v = maxval;
+    return static_cast<uint8_t>((v * 255 + maxval / 2) / maxval);
+}
+
+uint16_t scale16(uint32_t v, uint32_t maxval) {
+    if (v > maxval) v = maxval;
+    return static_cast<uint16_t>((v * 65535u + maxval / 2) / maxval);
+}
+
+// Expected BGRA32 pixels (bitmaps: 1 is black)
+std::vector<uint8_t> expectBgra(const PnmImage& img, bool bitmap) {
+    std::vector<uint8_t> out;
+    for (uint32_t p = 0; p < img.width * img.height; ++p) {
+        const uint16_t* s = &img.samples[p * img.depth];
+        uint8_t c[4];
+        for (uint32_t k = 0; k < img.depth; ++k) c[k] = bitmap ? (s[k] ? 0 : 255) : scale8(s[k], img.maxValue);
+        bool color = img.depth >= 3;
+        out.push_back(color ? c[2] : c[0]);
+        out.push_back(color ? c[1] : c[0]);
+        out.push_back(c[0]);
+        out.push_back((img.depth == 2 || img.depth == 4) ? c[img.depth - 1] : 255);
+    }
+    return out;
+}
+
+std::vector<uint16_t> expectBgra64(const PnmImage& img) {
+    std::vector<uint16_t> out;
+    for (uint32_t p = 0; p < img.width * img.height; ++p) {
+        const uint16_t* s = &img.samples[p * img.depth];
+        uint16_t c[4];
+        for (uint32_t k = 0; k < img.depth; ++k) c[k] = scale16(s[k], img.maxValue);
+        bool color = img.depth >= 3;
+        out.push_back(color ? c[2] : c[0]);
+        out.push_back(color ? c[1] : c[0]);
+        out.push_back(c[0]);
+        out.push_back((img.depth == 2 || img.depth == 4) ? c[img.depth - 1] : 65535);
+    }
+    return out;
+}
+
+struct PnmTestResult {
+    int errorCode;
+    int width;
+    int height;
+    int bitsPerPixel;
+    std::vector<uint8_t> pixels; // tightly packed rows
+    CKDWORD pnmFormat;
+    CKDWORD maxValue;
+};
+
+PnmTestResult readPnm(const std::vector<uint8_t>& data, CKDWORD flags = 0) {
+    PnmTestResult result;
+    PnmReader reader;
+    reader.SetReadFlags(flags);
+    CKBitmapProperties* props = nullptr;
+    result.errorCode = reader.ReadMemory(const_cast<uint8_t*>(data.data()), static_cast<int>(data.size()), &props);
+    result.width = 0;
+    result.height = 0;
+    result.bitsPerPixel = 0;
+    result.pnmFormat = 0;
+    result.maxValue = 0;
+    if (result.errorCode == 0 && props && props->m_Format.Image) {
+        const VxImageDescEx& fmt = props->m_Format;
+        result.width = fmt.Width;
+        result.height = fmt.Height;
+        result.bitsPerPixel = fmt.BitsPerPixel;
+        for (int y = 0; y < fmt.Height; ++y) {
+            const uint8_t* row = fmt.Image + y * fmt.BytesPerLine;
+            result.pixels.insert(result.pixels.end(), row, row + fmt.Width * fmt.BitsPerPixel / 8);
+        }
+        PnmBitmapProperties* pp = reinterpret_cast<PnmBitmapProperties*>(props);
+        result.pnmFormat = pp->m_PnmFormat;
+        result.maxValue = pp->m_MaxValue;
+    }
+    return result;
+}
+
+std::vector<uint8_t> toBytes(const std::string& text) { return std::vector<uint8_t>(text.begin(), text.end()); }
+
+std::string pbmImagesDir() { return joinPath(joinPath(g_TestImagesDir, "pbm"), "images"); }
+
+} // namespace
+
+//=============================================================================
+// SIMD Kernels
+//=============================================================================
+
+TEST(PnmReader, Kernels_MatchScalar) {
+    for (int count = 0; count < 70; ++count) {
+        std::vector<CKBYTE> src(count * 2 + 1);
+        for (size_t i = 0; i < src.size(); ++i) src[i] = static_cast<CKBYTE>(nextRandom());
+        std::vector<CKBYTE> dst(count * 4 + 1, 0xEE);
+
+        ImageGrayToBGRA32(src.data(), dst.data(), count);
+        for (int i = 0; i < count; ++i) {
+            for (int c = 0; c < 3; ++c) ASSERT_EQ(src[i], dst[i * 4 + c]);
+            ASSERT_EQ(255, dst[i * 4 + 3]);
+        }
+        ASSERT_EQ(0xEE, dst[count * 4]);
+
+        ImageGrayAlphaToBGRA32(src.data(), dst.data(), count);
+        for (int i = 0; i < count; ++i) {
+            for (int c = 0; c < 3; ++c) ASSERT_EQ(src[i * 2], dst[i * 4 + c]);
+            ASSERT_EQ(src[i * 2 + 1], dst[i * 4 + 3]);
+        }
+        ASSERT_EQ(0xEE, dst[count * 4]);
+
+        ImageBitsToBGRA32(src.data(), dst.data(), count, 0x11223344, 0xAABBCCDD);
+        for (int i = 0; i < count; ++i) {
+            CKDWORD pixel;
+            memcpy(&pixel, &dst[i * 4], 4);
+            ASSERT_EQ((src[i / 8] & (0x80 >> (i % 8))) ? 0xAABBCCDDu : 0x11223344u, pixel);
+        }
+        ASSERT_EQ(0xEE, dst[count * 4]);
+
+        std::vector<CKWORD> words(count + 1, 0xEEEE);
+        ImageSwap16(src.data(), words.data(), count);
+        for (int i = 0; i < count; ++i) ASSERT_EQ((src[i * 2] << 8) | src[i * 2 + 1], words[i]);
+        ASSERT_EQ(0xEEEE, words[count]);
+
+        // In place
+        std::vector<CKBYTE> copy(src);
+        ImageSwap16(copy.data(), reinterpret_cast<CKWORD*>(copy.data()), count);
+        for (int i = 0; i < count; ++i) {
+            ASSERT_EQ(src[i * 2 + 1], copy[i * 2]);
+            ASSERT_EQ(src[i * 2], copy[i * 2 + 1]);
+        }
+    }
+}
+
+//=============================================================================
+// Formats
+//=============================================================================
+
+TEST(PnmReader, Raw_AllFormats) {
+    struct Case {
+        int format;
+        uint32_t depth;
+    };
+    static const Case cases[] = {{PNM_RAW_GRAYMAP, 1}, {PNM_RAW_PIXMAP, 3},    {PNM_ARBITRARY_MAP, 1},
+                                 {PNM_ARBITRARY_MAP, 2}, {PNM_ARBITRARY_MAP, 3}, {PNM_ARBITRARY_MAP, 4}};
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        PnmImage img(37, 29, cases[i].depth, 255);
+        PnmTestResult r = readPnm(makeRaw(cases[i].format, img));
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_EQ(37, r.width);
+        ASSERT_EQ(29, r.height);
+        ASSERT_EQ(32, r.bitsPerPixel);
+        ASSERT_TRUE(r.pixels == expectBgra(img, false));
+        ASSERT_EQ(static_cast<CKDWORD>(cases[i].format), r.pnmFormat);
+        ASSERT_EQ(255u, r.maxValue);
+    }
+
+    PnmImage bits(45, 7, 1, 1);
+    PnmTestResult r = readPnm(makeRaw(PNM_RAW_BITMAP, bits));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == expectBgra(bits, true));
+    ASSERT_EQ(1u, r.maxValue);
+}
+
+TEST(PnmReader, Plain_MatchesRaw) {
+    PnmImage bits(45, 7, 1, 1);
+    PnmTestResult plain = readPnm(makePlain(PNM_PLAIN_BITMAP, bits));
+    ASSERT_EQ(0, plain.errorCode);
+    ASSERT_TRUE(plain.pixels == readPnm(makeRaw(PNM_RAW_BITMAP, bits)).pixels);
+    ASSERT_EQ(static_cast<CKDWORD>(PNM_PLAIN_BITMAP), plain.pnmFormat);
+
+    PnmImage gray(33, 9, 1, 255);
+    plain = readPnm(makePlain(PNM_PLAIN_GRAYMAP, gray));
+    ASSERT_EQ(0, plain.errorCode);
+    ASSERT_TRUE(plain.pixels == readPnm(makeRaw(PNM_RAW_GRAYMAP, gray)).pixels);
+
+    PnmImage rgb(19, 21, 3, 1000);
+    plain = readPnm(makePlain(PNM_PLAIN_PIXMAP, rgb));
+    ASSERT_EQ(0, plain.errorCode);
+    ASSERT_TRUE(plain.pixels == readPnm(makeRaw(PNM_RAW_PIXMAP, rgb)).pixels);
+    ASSERT_TRUE(plain.pixels == expectBgra(rgb, false));
+}
+
+TEST(PnmReader, Plain_CommentsAndOddNumbers) {
+    // Comments in the header and the raster, leading zeros, numbers of more
+    // than 8 and 16 digits, values above the maxval and trailing tokens
+    PnmTestResult r = readPnm(toBytes("P2 # comment\n#another\n3\t2 #\n100\n"
+                                      "0 # skipped 77\n 50 0000000000000000100\n"
+                                      "200 99999999999999999999 0100 7 8 9"));
+    ASSERT_EQ(0, r.errorCode);
+    static const uint8_t expected[] = {0, 128, 255, 255, 255, 255};
+    for (int i = 0; i < 6; ++i) ASSERT_EQ(expected[i], r.pixels[i * 4]);
+
+    // The same without comments, through the SIMD tokenizer
+    r = readPnm(toBytes("P2\n3 2\n100\n0 50 0000000000000000100 200 99999999999999999999 0100 7 8 9"));
+    ASSERT_EQ(0, r.errorCode);
+    for (int i = 0; i < 6; ++i) ASSERT_EQ(expected[i], r.pixels[i * 4]);
+
+    // Bitmaps need no separators, and any digit but 0 is black
+    r = readPnm(toBytes("P1 4 2 0110\n1\n0 1 0\n"));
+    ASSERT_EQ(0, r.errorCode);
+    static const uint8_t bits[] = {255, 0, 0, 255, 0, 255, 0, 255};
+    for (int i = 0; i < 8; ++i) ASSERT_EQ(bits[i], r.pixels[i * 4]);
+    r = readPnm(toBytes("P1 2 1 #c\n 0#c\n5"));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(255, r.pixels[0]);
+    ASSERT_EQ(0, r.pixels[4]);
+}
+
+TEST(PnmReader, Plain_ManyChunks_ParallelParse) {
+    // Large enough for the raster to be split into chunks, whose nominal
+    // bounds fall inside numbers
+    for (int format = PNM_PLAIN_BITMAP; format <= PNM_PLAIN_PIXMAP; ++format) {
+        uint32_t depth = (format == PNM_PLAIN_PIXMAP) ? 3 : 1;
+        uint32_t maxval = (format == PNM_PLAIN_BITMAP) ? 1 : (format == PNM_PLAIN_GRAYMAP ? 65535 : 255);
+        PnmImage img(1501, 997, depth, maxval);
+        std::vector<uint8_t> data = makePlain(format, img);
+        ASSERT_TRUE(data.size() > PNM_PLAIN_CHUNK_SIZE);
+        PnmTestResult r = readPnm(data);
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_TRUE(r.pixels == expectBgra(img, format == PNM_PLAIN_BITMAP));
+
+        // One sample short
+        data.resize(data.size() - 8);
+        while (data.back() >= '0' && data.back() <= '9') data.pop_back();
+        ASSERT_EQ(CKBITMAPERROR_READERROR, readPnm(data).errorCode);
+    }
+}
+
+TEST(PnmReader, MaxValues_ScaleToBytes) {
+    static const uint32_t maxvals[] = {1, 3, 7, 100, 255, 256, 1000, 4095, 65534, 65535};
+    for (size_t m = 0; m < sizeof(maxvals) / sizeof(maxvals[0]); ++m) {
+        PnmImage img(23, 5, 3, maxvals[m]);
+        img.samples[0] = static_cast<uint16_t>(maxvals[m] < 255 ? 255 : maxvals[m]); // above the maxval: clamped
+        std::vector<uint8_t> expected = expectBgra(img, false);
+        PnmTestResult r = readPnm(makeRaw(PNM_RAW_PIXMAP, img));
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_TRUE(r.pixels == expected);
+        ASSERT_EQ(maxvals[m], r.maxValue);
+        r = readPnm(makePlain(PNM_PLAIN_PIXMAP, img));
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_TRUE(r.pixels == expected);
+    }
+}
+
+TEST(PnmReader, Keep16Bit_Bgra64) {
+    static const uint32_t maxvals[] = {256, 1000, 65535};
+    for (size_t m = 0; m < 3; ++m) {
+        for (uint32_t depth = 1; depth <= 4; ++depth) {
+            PnmImage img(17, 6, depth, maxvals[m]);
+            std::vector<uint16_t> expected = expectBgra64(img);
+            PnmTestResult r = readPnm(makeRaw(PNM_ARBITRARY_MAP, img), IMAGE_READ_KEEP_16BIT);
+            ASSERT_EQ(0, r.errorCode);
+            ASSERT_EQ(64, r.bitsPerPixel);
+            ASSERT_TRUE(memcmp(r.pixels.data(), expected.data(), expected.size() * 2) == 0);
+            if (depth == 1) {
+                r = readPnm(makePlain(PNM_PLAIN_GRAYMAP, img), IMAGE_READ_KEEP_16BIT);
+                ASSERT_EQ(0, r.errorCode);
+                ASSERT_TRUE(memcmp(r.pixels.data(), expected.data(), expected.size() * 2) == 0);
+            }
+        }
+    }
+
+    // Eight-bit files stay BGRA32
+    PnmImage img(4, 4, 1, 255);
+    PnmTestResult r = readPnm(makeRaw(PNM_RAW_GRAYMAP, img), IMAGE_READ_KEEP_16BIT);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(32, r.bitsPerPixel);
+}
+
+TEST(PnmReader, ManyRows_ParallelConvert) {
+    PnmImage img(300, 777, 3, 255);
+    PnmTestResult r = readPnm(makeRaw(PNM_RAW_PIXMAP, img));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == expectBgra(img, false));
+}
+
+TEST(PnmReader, ReadInfo) {
+    std::vector<uint8_t> data = toBytes("P7\n# comment\n WIDTH 5\nHEIGHT 3\nDEPTH 2\nMAXVAL 4000\nTUPLTYPE "
+                                        "GRAYSCALE_ALPHA\nTUPLTYPE extra\nENDHDR\n");
+    PnmImageInfo info;
+    ASSERT_EQ(0, PNM_ReadInfo(data.data(), static_cast<CKDWORD>(data.size()), info));
+    ASSERT_EQ(static_cast<CKDWORD>(PNM_ARBITRARY_MAP), info.format);
+    ASSERT_EQ(5u, info.width);
+    ASSERT_EQ(3u, info.height);
+    ASSERT_EQ(2u, info.depth);
+    ASSERT_EQ(4000u, info.maxValue);
+    ASSERT_FALSE(info.plain);
+    ASSERT_EQ(static_cast<CKDWORD>(data.size()), info.dataOffset);
+
+    data = toBytes("P4#c\n8#c\n 2\r\x01\x02");
+    ASSERT_EQ(0, PNM_ReadInfo(data.data(), static_cast<CKDWORD>(data.size()), info));
+    ASSERT_TRUE(info.bitmap);
+    ASSERT_EQ(1u, info.maxValue);
+    ASSERT_EQ(static_cast<CKDWORD>(data.size() - 2), info.dataOffset);
+}
+
+TEST(PnmReader, ReaderInfo) {
+    PnmReader pnm;
+    PbmReader pbm;
+    PgmReader pgm;
+    PpmReader ppm;
+    PamReader pam;
+    PnmReader* readers[] = {&pnm, &pbm, &pgm, &ppm, &pam};
+    const CKGUID guids[] = {PNMREADER_GUID, PBMREADER_GUID, PGMREADER_GUID, PPMREADER_GUID, PAMREADER_GUID};
+    for (int i = 0; i < 5; ++i) {
+        CKPluginInfo* info = readers[i]->GetReaderInfo();
+        ASSERT_TRUE(info != nullptr);
+        ASSERT_GUID_EQ(guids[i], info->m_GUID);
+        ASSERT_EQ(0, readers[i]->SaveFile(const_cast<char*>("unused.pnm"), nullptr));
+    }
+
+    // Any extension reads any Netpbm format
+    PnmImage img(3, 3, 3, 255);
+    std::vector<uint8_t> data = makeRaw(PNM_RAW_PIXMAP, img);
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(0, pbm.ReadMemory(data.data(), static_cast<int>(data.size()), &props));
+    ASSERT_EQ(3, props->m_Format.Width);
+}
+
+//=============================================================================
+// Corpus Tests
+//=============================================================================
+
+TEST(PnmReader, Corpus_ReferenceCrcs) {
+    std::vector<std::string> files =
+        collectFilesWithExtensions(pbmImagesDir(), {".pbm", ".pgm", ".ppm", ".pnm", ".pam"});
+    int checked = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        uint32_t crc = 0;
+        if (!getReferenceCrc("pbm/" + files[i], crc)) continue;
+        PnmTestResult r = readPnm(readBinaryFile(joinPath(pbmImagesDir(), files[i])));
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_CRC(crc, r.pixels.data(), r.pixels.size());
+        ++checked;
+    }
+    if (checked == 0) SKIP_TEST("Netpbm corpus or reference CRCs not found");
+}
+
+TEST(PnmReader, Corpus_MatchesReferenceImages) {
+    std::string refDir = joinPath(joinPath(g_TestReferenceDir, "pbm"), "images");
+    std::vector<std::string> refs = listDirectory(refDir);
+    int compared = 0;
+    for (size_t i = 0; i < refs.size(); ++i) {
+        ReferenceInfo info = parseReferenceFilename(refs[i]);
+        std::string imagePath = joinPath(pbmImagesDir(), info.inputName);
+        if (!info.valid || !fileExists(imagePath)) continue;
+
+        PnmTestResult image = readPnm(readBinaryFile(imagePath));
+        ASSERT_EQ(0, image.errorCode);
+        CKBitmapProperties refProps;
+        ASSERT_EQ(0, PNG_Read(const_cast<char*>(joinPath(refDir, refs[i]).c_str()), 0, &refProps));
+        const VxImageDescEx& ref = refProps.m_Format;
+        ASSERT_EQ(ref.Width, image.width);
+        ASSERT_EQ(ref.Height, image.height);
+        for (int y = 0; y < ref.Height; ++y)
+            ASSERT_TRUE(memcmp(ref.Image + y * ref.BytesPerLine, &image.pixels[y * image.width * 4],
+                               image.width * 4) == 0);
+        delete[] static_cast<CKBYTE*>(refProps.m_Data);
+        ++compared;
+    }
+    if (compared == 0) SKIP_TEST("Netpbm reference images not found");
+}
+
+TEST(PnmReader, Truncations_MustNotCrash) {
+    // Every prefix of each format: a raster cut short is a read error
+    PnmImage gray(7, 5, 1, 300);
+    PnmImage rgb(7, 5, 3, 255);
+    PnmImage bits(11, 5, 1, 1);
+    PnmImage rgba(7, 5, 4, 65535);
+    std::vector<std::vector<uint8_t> > files;
+    files.push_back(makePlain(PNM_PLAIN_BITMAP, bits));
+    files.push_back(makePlain(PNM_PLAIN_GRAYMAP, gray));
+    files.push_back(makePlain(PNM_PLAIN_PIXMAP, rgb));
+    files.push_back(makeRaw(PNM_RAW_BITMAP, bits));
+    files.push_back(makeRaw(PNM_RAW_GRAYMAP, gray));
+    files.push_back(makeRaw(PNM_RAW_PIXMAP, rgb));
+    files.push_back(makeRaw(PNM_ARBITRARY_MAP, rgba));
+    for (size_t f = 0; f < files.size(); ++f) {
+        ASSERT_EQ(0, readPnm(files[f]).errorCode);
+        bool plain = f < 3;
+        for (size_t n = 0; n < files[f].size(); ++n) {
+            std::vector<uint8_t> prefix(files[f].begin(), files[f].begin() + n);
+            int error = readPnm(prefix, IMAGE_READ_KEEP_16BIT).errorCode;
+            // A plain raster cut inside its last number still has every sample
+            if (!(plain && n + 7 >= files[f].size())) ASSERT_TRUE(error != 0);
+        }
+    }
+}
+
+//=============================================================================
+// Negative Tests
+//=============================================================================
+
+TEST(PnmReader, Negative_BadHeader) {
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readPnm(toBytes("P8\n1 1\n255\nx")).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readPnm(toBytes("Q5\n1 1\n255\nx")).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readPnm(toBytes("P51 1\n255\nx")).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readPnm(toBytes("P7 332\n#XVVERSION\n")).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPnm(toBytes("P5\n1 x\n255\nx")).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPnm(toBytes("P5\n0 1\n255\nx")).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPnm(toBytes("P5\n1 1\n0\nx")).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPnm(toBytes("P5\n1 1\n65536\nxx")).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPnm(toBytes("P5\n1 1\n255x")).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readPnm(toBytes("P5\n1 1\n255")).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readPnm(toBytes("P5\n1 1 # no maxval")).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readPnm(toBytes("P")).errorCode);
+
+    // PAM: missing fields, unsupported depth and no ENDHDR
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED,
+              readPnm(toBytes("P7\nWIDTH 1\nHEIGHT 1\nMAXVAL 255\nENDHDR\nx")).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED,
+              readPnm(toBytes("P7\nWIDTH 1\nHEIGHT one\nDEPTH 1\nMAXVAL 255\nENDHDR\nx")).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE,
+              readPnm(toBytes("P7\nWIDTH 1\nHEIGHT 1\nDEPTH 5\nMAXVAL 255\nENDHDR\nxxxxx")).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readPnm(toBytes("P7\nWIDTH 1\nHEIGHT 1\nDEPTH 1\nMAXVAL 255\n")).errorCode);
+}
+
+TEST(PnmReader, Negative_HugeDimensionsFailFast) {
+    // Beyond the pixel limit
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPnm(toBytes("P5\n100000 100000\n255\nxxxx")).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readPnm(toBytes("P5\n99999999999999 1\n255\nxxxx")).errorCode);
+    // Far more samples than the file holds: nothing is allocated
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readPnm(toBytes("P6\n10000 10000\n255\nxxxx")).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readPnm(toBytes("P3\n10000 10000\n255\n1 2 3 4")).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readPnm(toBytes("P1\n10000 10000\n0101")).errorCode);
+}
@@ -0,0 +1,361 @@
+/**
+ * @file QoiReaderTests.cpp
+ * @brief QOI format tests for CKImageReader
+ *
+ * Tests cover:
+ * - Decoding of every chunk type (RGB, RGBA, INDEX, DIFF, LUMA, RUN)
+ * - The corpus image in tests/images/qoi
+ * - Saving (RGB, RGBA and auto channel selection) with round-trip checks
+ * - Malformed files (bad magic, bad header fields, truncated chunks)
+ */
+
+#include "TestFramework.h"
+#include "QoiReader.h"
+#include <cstring>
+
+using namespace TestFramework;
+
+//=============================================================================
+// Test Helpers
+//=============================================================================
+
+namespace {
+
+void putBE32(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v >> 24));
+    out.push_back(static_cast<uint8_t>(v >> 16));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+// Wraps a chunk stream in a header and the end marker
+std::vector<uint8_t> makeQoi(uint32_t width, uint32_t height, uint8_t channels, const std::vector<uint8_t>& chunks) {
+    std::vector<uint8_t> qoi;
+    putBE32(qoi, QOI_MAGIC);
+    putBE32(qoi, width);
+    putBE32(qoi, height);
+    qoi.push_back(channels);
+    qoi.push_back(0);
+    qoi.insert(qoi.end(), chunks.begin(), chunks.end());
+    for (int i = 0; i < 7; ++i) qoi.push_back(0);
+    qoi.push_back(1);
+    return qoi;
+}
+
+struct QoiTestResult {
+    int errorCode;
+    int width;
+    int height;
+    std::vector<uint8_t> pixels; // tightly packed BGRA32
+};
+
+QoiTestResult readQoiMemory(const std::vector<uint8_t>& data) {
+    QoiTestResult result;
+    QoiReader reader;
+    CKBitmapProperties* props = nullptr;
+    result.errorCode = reader.ReadMemory(const_cast<uint8_t*>(data.data()), static_cast<int>(data.size()), &props);
+    result.width = 0;
+    result.height = 0;
+    if (result.errorCode == 0 && props && props->m_Format.Image) {
+        result.width = props->m_Format.Width;
+        result.height = props->m_Format.Height;
+        result.pixels.resize(result.width * result.height * 4);
+        for (int y = 0; y < result.height; ++y) {
+            memcpy(&result.pixels[y * result.width * 4], props->m_Format.Image + y * props->m_Format.BytesPerLine,
+                   result.width * 4);
+        }
+    }
+    return result;
+}
+
+// Returns the BGRA bytes of pixel i
+uint32_t pixelAt(const QoiTestResult& r, int i) {
+    const uint8_t* p = &r.pixels[i * 4];
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Saves BGRA32 pixels with the given channel option and returns the encoded file
+std::vector<uint8_t> saveQoi(const std::vector<uint8_t>& pixels, int width, int height, int channels) {
+    QoiBitmapProperties props;
+    ImageReader::FillFormatBGRA32(props.m_Format, width, height, width * 4, const_cast<uint8_t*>(pixels.data()));
+    props.m_Channels = channels;
+
+    QoiReader writer;
+    void* memory = nullptr;
+    int size = writer.SaveMemory(&memory, &props);
+    std::vector<uint8_t> encoded;
+    if (size > 0 && memory) {
+        encoded.assign(static_cast<uint8_t*>(memory), static_cast<uint8_t*>(memory) + size);
+        writer.ReleaseMemory(memory);
+    }
+    return encoded;
+}
+
+// Gradients, flat areas, repeated colors and (optionally) varying alpha, so
+// that the encoder emits every chunk type
+std::vector<uint8_t> makeSavePattern(int width, int height, bool alpha) {
+    std::vector<uint8_t> pixels(width * height * 4);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t* p = &pixels[(y * width + x) * 4];
+            if (x < width / 4) {
+                p[0] = 10; p[1] = 20; p[2] = 30;                 // flat run
+            } else if (x < width / 2) {
+                p[0] = static_cast<uint8_t>(x); p[1] = static_cast<uint8_t>(y);
+                p[2] = static_cast<uint8_t>(x + y);              // small deltas
+            } else if ((x + y) % 3 == 0) {
+                p[0] = static_cast<uint8_t>((x * 5) & 0xF0); p[1] = 200; p[2] = 7; // recurring colors
+            } else {
+                p[0] = static_cast<uint8_t>(x * 97 + y * 31);
+                p[1] = static_cast<uint8_t>(x * 13 ^ y * 71);
+                p[2] = static_cast<uint8_t>(x * y);              // large jumps
+            }
+            p[3] = alpha ? static_cast<uint8_t>(((x / 8) * 40 + y) & 0xFF) : 255;
+        }
+    }
+    return pixels;
+}
+
+} // anonymous namespace
+
+//=============================================================================
+// Chunk Decoding Tests
+//=============================================================================
+
+TEST(QoiReader, Chunk_RGB_KeepsAlpha) {
+    std::vector<uint8_t> chunks;
+    chunks.push_back(QOI_OP_RGBA); chunks.push_back(1); chunks.push_back(2); chunks.push_back(3); chunks.push_back(128);
+    chunks.push_back(QOI_OP_RGB); chunks.push_back(10); chunks.push_back(20); chunks.push_back(30);
+    QoiTestResult r = readQoiMemory(makeQoi(2, 1, 4, chunks));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(0x80010203u, pixelAt(r, 0));
+    ASSERT_EQ(0x800A141Eu, pixelAt(r, 1));
+}
+
+TEST(QoiReader, Chunk_Index) {
+    std::vector<uint8_t> chunks;
+    chunks.push_back(QOI_OP_RGB); chunks.push_back(50); chunks.push_back(60); chunks.push_back(70);
+    chunks.push_back(QOI_OP_RGB); chunks.push_back(1); chunks.push_back(1); chunks.push_back(1);
+    int hash = (50 * 3 + 60 * 5 + 70 * 7 + 255 * 11) % 64;
+    chunks.push_back(static_cast<uint8_t>(QOI_OP_INDEX | hash));
+    QoiTestResult r = readQoiMemory(makeQoi(3, 1, 3, chunks));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(0xFF323C46u, pixelAt(r, 2));
+}
+
+TEST(QoiReader, Chunk_Diff_WrapsAround) {
+    std::vector<uint8_t> chunks;
+    chunks.push_back(QOI_OP_RGB); chunks.push_back(0); chunks.push_back(255); chunks.push_back(100);
+    // dr = -2, dg = +1, db = 0
+    chunks.push_back(static_cast<uint8_t>(QOI_OP_DIFF | (0 << 4) | (3 << 2) | 2));
+    QoiTestResult r = readQoiMemory(makeQoi(2, 1, 3, chunks));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(0xFFFE0064u, pixelAt(r, 1));
+}
+
+TEST(QoiReader, Chunk_Luma) {
+    std::vector<uint8_t> chunks;
+    chunks.push_back(QOI_OP_RGB); chunks.push_back(100); chunks.push_back(100); chunks.push_back(100);
+    // dg = -20, dr - dg = +7, db - dg = -8
+    chunks.push_back(static_cast<uint8_t>(QOI_OP_LUMA | (-20 + 32)));
+    chunks.push_back(static_cast<uint8_t>(((7 + 8) << 4) | (-8 + 8)));
+    QoiTestResult r = readQoiMemory(makeQoi(2, 1, 3, chunks));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(0xFF575048u, pixelAt(r, 1));
+}
+
+TEST(QoiReader, Chunk_Run_StartsFromOpaqueBlack) {
+    std::vector<uint8_t> chunks;
+    chunks.push_back(static_cast<uint8_t>(QOI_OP_RUN | 61)); // 62 pixels
+    chunks.push_back(static_cast<uint8_t>(QOI_OP_RUN | 7));  // 8 pixels
+    QoiTestResult r = readQoiMemory(makeQoi(10, 7, 4, chunks));
+    ASSERT_EQ(0, r.errorCode);
+    for (int i = 0; i < 70; ++i) {
+        ASSERT_EQ(0xFF000000u, pixelAt(r, i));
+    }
+}
+
+TEST(QoiReader, Chunk_Run_ClampedToImage) {
+    std::vector<uint8_t> chunks;
+    chunks.push_back(QOI_OP_RGB); chunks.push_back(9); chunks.push_back(8); chunks.push_back(7);
+    chunks.push_back(static_cast<uint8_t>(QOI_OP_RUN | 61));
+    QoiTestResult r = readQoiMemory(makeQoi(2, 2, 3, chunks));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(0xFF090807u, pixelAt(r, 3));
+}
+
+//=============================================================================
+// Corpus Tests
+//=============================================================================
+
+TEST(QoiReader, Corpus_BasicTest) {
+    std::string path = joinPath(joinPath(g_TestImagesDir, "qoi"), "basic-test.qoi");
+    if (!fileExists(path)) SKIP_TEST("basic-test.qoi not found");
+
+    QoiReader reader;
+    CKBitmapProperties* props = nullptr;
+    ASSERT_EQ(0, reader.ReadFile(const_cast<char*>(path.c_str()), &props));
+    ASSERT_TRUE(props != nullptr);
+    ASSERT_EQ(5, props->m_Format.Width);
+    ASSERT_EQ(5, props->m_Format.Height);
+    ASSERT_EQ(32, props->m_Format.BitsPerPixel);
+    ASSERT_EQ(4u, reinterpret_cast<QoiBitmapProperties*>(props)->m_Channels);
+    ASSERT_CRC(0x72416d1fu, props->m_Format.Image, 5 * 5 * 4);
+}
+
+//=============================================================================
+// Save Tests
+//=============================================================================
+
+TEST(QoiReader, Save_RGBA_RoundTrip) {
+    std::vector<uint8_t> pixels = makeSavePattern(97, 41, true);
+    std::vector<uint8_t> encoded = saveQoi(pixels, 97, 41, 4);
+    ASSERT_TRUE(!encoded.empty());
+    ASSERT_EQ(4, encoded[12]);
+    QoiTestResult r = readQoiMemory(encoded);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == pixels);
+}
+
+TEST(QoiReader, Save_RGB_ForcesOpaque) {
+    std::vector<uint8_t> pixels = makeSavePattern(64, 16, true);
+    std::vector<uint8_t> encoded = saveQoi(pixels, 64, 16, 3);
+    ASSERT_EQ(3, encoded[12]);
+    QoiTestResult r = readQoiMemory(encoded);
+    ASSERT_EQ(0, r.errorCode);
+    for (size_t i = 3; i < pixels.size(); i += 4) pixels[i] = 255;
+    ASSERT_TRUE(r.pixels == pixels);
+}
+
+TEST(QoiReader, Save_Auto_PicksChannelsFromAlpha) {
+    std::vector<uint8_t> opaque = makeSavePattern(20, 20, false);
+    std::vector<uint8_t> translucent = makeSavePattern(20, 20, true);
+    ASSERT_EQ(3, saveQoi(opaque, 20, 20, QOI_CHANNELS_AUTO)[12]);
+    ASSERT_EQ(4, saveQoi(translucent, 20, 20, QOI_CHANNELS_AUTO)[12]);
+}
+
+TEST(QoiReader, Save_LongRunsAndPadding) {
+    // 1000 identical pixels -> 1 RGB chunk + runs of 62, then the end marker
+    std::vector<uint8_t> pixels(1000 * 4);
+    for (int i = 0; i < 1000; ++i) {
+        pixels[i * 4 + 0] = 100; pixels[i * 4 + 1] = 150; pixels[i * 4 + 2] = 200; pixels[i * 4 + 3] = 255;
+    }
+    std::vector<uint8_t> encoded = saveQoi(pixels, 1000, 1, 3);
+    size_t runChunks = (999 + 61) / 62;
+    ASSERT_EQ(static_cast<size_t>(14 + 4 + runChunks + 8), encoded.size());
+    ASSERT_EQ(1, encoded[encoded.size() - 1]);
+    ASSERT_EQ(0, encoded[encoded.size() - 2]);
+    QoiTestResult r = readQoiMemory(encoded);
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == pixels);
+}
+
+TEST(QoiReader, Save_SmallerThanTga) {
+    std::vector<uint8_t> pixels = makeSavePattern(256, 128, false);
+    std::vector<uint8_t> encoded = saveQoi(pixels, 256, 128, 3);
+    ASSERT_TRUE(encoded.size() < static_cast<size_t>(256 * 128 * 3));
+}
+
+TEST(QoiReader, SaveFile_RoundTrip) {
+    std::vector<uint8_t> pixels = makeSavePattern(33, 20, true);
+    QoiBitmapProperties props;
+    ImageReader::FillFormatBGRA32(props.m_Format, 33, 20, 33 * 4, pixels.data());
+
+    std::string tempPath = joinPath(g_TestOutputDir, "qoi_save_test.qoi");
+    QoiReader writer;
+    ASSERT_TRUE(writer.SaveFile(const_cast<char*>(tempPath.c_str()), &props) > 0);
+
+    QoiReader reader;
+    CKBitmapProperties* out = nullptr;
+    ASSERT_EQ(0, reader.ReadFile(const_cast<char*>(tempPath.c_str()), &out));
+    ASSERT_EQ(33, out->m_Format.Width);
+    ASSERT_TRUE(memcmp(out->m_Format.Image, pixels.data(), pixels.size()) == 0);
+    remove(tempPath.c_str());
+}
+
+TEST(QoiReader, SaveFile_NoImage) {
+    QoiReader reader;
+    CKBitmapProperties props;
+    memset(&props, 0, sizeof(props));
+    ASSERT_EQ(0, reader.SaveFile(const_cast<char*>("test.qoi"), &props));
+}
+
+//=============================================================================
+// Negative Tests
+//=============================================================================
+
+TEST(QoiReader, Negative_BadMagic) {
+    std::vector<uint8_t> qoi = makeQoi(1, 1, 4, std::vector<uint8_t>(1, QOI_OP_RUN));
+    qoi[0] = 'x';
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readQoiMemory(qoi).errorCode);
+}
+
+TEST(QoiReader, Negative_BadHeaderFields) {
+    std::vector<uint8_t> chunks(1, QOI_OP_RUN);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readQoiMemory(makeQoi(0, 1, 4, chunks)).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readQoiMemory(makeQoi(1, 0, 4, chunks)).errorCode);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readQoiMemory(makeQoi(1, 1, 5, chunks)).errorCode);
+    std::vector<uint8_t> qoi = makeQoi(1, 1, 4, chunks);
+    qoi[13] = 2; // color space
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readQoiMemory(qoi).errorCode);
+}
+
+TEST(QoiReader, Negative_TooManyPixels) {
+    std::vector<uint8_t> chunks(1, QOI_OP_RUN);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readQoiMemory(makeQoi(65536, 65536, 4, chunks)).errorCode);
+}
+
+TEST(QoiReader, Negative_DecodeLimits) {
+    struct RestoreLimits {
+        ~RestoreLimits() { ImageSetDecodeLimits(0, 0); }
+    } restore;
+    std::vector<uint8_t> qoi = makeQoi(10, 10, 4, std::vector<uint8_t>(2, static_cast<uint8_t>(QOI_OP_RUN | 49)));
+
+    ImageSetDecodeLimits(10 * 10 - 1, 0);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readQoiMemory(qoi).errorCode);
+    ImageSetDecodeLimits(0, 10 * 10 * 4 - 1);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readQoiMemory(qoi).errorCode);
+    ImageSetDecodeLimits(10 * 10, 10 * 10 * 4);
+    ASSERT_EQ(0, readQoiMemory(qoi).errorCode);
+}
+
+TEST(QoiReader, Negative_TruncatedChunks) {
+    // 100 pixels but only one run of 62
+    std::vector<uint8_t> chunks(1, static_cast<uint8_t>(QOI_OP_RUN | 61));
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readQoiMemory(makeQoi(10, 10, 4, chunks)).errorCode);
+}
+
+TEST(QoiReader, Negative_TruncatedHeader) {
+    std::vector<uint8_t> qoi = makeQoi(1, 1, 4, std::vector<uint8_t>(1, QOI_OP_RUN));
+    qoi.resize(10);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readQoiMemory(qoi).errorCode);
+}
+
+TEST(QoiReader, Negative_MissingPadding) {
+    std::vector<uint8_t> qoi = makeQoi(1, 1, 4, std::vector<uint8_t>(1, QOI_OP_RUN));
+    qoi.resize(14 + 5);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readQoiMemory(qoi).errorCode);
+}
+
+//=============================================================================
+// API Tests
+//=============================================================================
+
+TEST(QoiReader, GetReaderInfo) {
+    QoiReader reader;
+    CKPluginInfo* info = reader.GetReaderInfo();
+    ASSERT_TRUE(info != nullptr);
+    ASSERT_GUID_EQ(QOIREADER_GUID, info->m_GUID);
+}
+
+TEST(QoiReader, IsAlphaSaved) {
+    QoiReader reader;
+    QoiBitmapProperties props;
+    props.m_Channels = 3;
+    ASSERT_FALSE(reader.IsAlphaSaved(&props));
+    props.m_Channels = 4;
+    ASSERT_TRUE(reader.IsAlphaSaved(&props));
+    props.m_Channels = QOI_CHANNELS_AUTO;
+    ASSERT_TRUE(reader.IsAlphaSaved(&props));
+}
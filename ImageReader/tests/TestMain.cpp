@@ -51,6 +51,17 @@ void VxDeleteAligned(void* ptr) {
 #include "BmpReader.h"
 #include "TgaReader.h"
 #include "PcxReader.h"
+#include "PngReader.h"
+#include "JpegReader.h"
+#include "GifReader.h"
+#include "IcoReader.h"
+#include "TiffReader.h"
+#include "HdrReader.h"
+#include "ExrReader.h"
+#include "WebpReader.h"
+#include "PnmReader.h"
+#include "FarbfeldReader.h"
+#include "DdsReader.h"
 
 //=============================================================================
 // Global Test Paths
@@ -322,6 +333,208 @@ void generateReferenceFile(const std::string& outputPath) {
         }
     }
 
+    // PNG test images (top level and one level of subdirectories)
+    fprintf(f, "\n[png]\n");
+    std::string pngDir = TestFramework::joinPath(g_TestImagesDir, "png");
+    if (TestFramework::directoryExists(pngDir)) {
+        static const char* pngSubdirs[] = {"", "16bpc", "apng", "bugfixes", "interlaced", "transparency"};
+        for (size_t d = 0; d < sizeof(pngSubdirs) / sizeof(pngSubdirs[0]); ++d) {
+            std::string sub = pngSubdirs[d];
+            std::string dir = sub.empty() ? pngDir : TestFramework::joinPath(pngDir, sub);
+            std::vector<std::string> pngFiles = TestFramework::listDirectory(dir);
+            for (size_t i = 0; i < pngFiles.size(); ++i) {
+                const std::string& file = pngFiles[i];
+                if (TestFramework::toLower(TestFramework::getExtension(file)) != ".png") continue;
+                std::string key = sub.empty() ? file : sub + "/" + file;
+                ReaderTestResult result = testReadFile<PngReader>(TestFramework::joinPath(dir, file));
+                if (result.errorCode == 0) {
+                    fprintf(f, "%s=%08x\n", key.c_str(), result.crc);
+                    g_GeneratedCrcs["png/" + key] = result.crc;
+                }
+            }
+        }
+    }
+
+    // JPEG test images (top level and one level of subdirectories)
+    fprintf(f, "\n[jpg]\n");
+    std::string jpgDir = TestFramework::joinPath(g_TestImagesDir, "jpg");
+    if (TestFramework::directoryExists(jpgDir)) {
+        static const char* jpgSubdirs[] = {"", "progressive"};
+        for (size_t d = 0; d < sizeof(jpgSubdirs) / sizeof(jpgSubdirs[0]); ++d) {
+            std::string sub = jpgSubdirs[d];
+            std::string dir = sub.empty() ? jpgDir : TestFramework::joinPath(jpgDir, sub);
+            std::vector<std::string> jpgFiles = TestFramework::listDirectory(dir);
+            for (size_t i = 0; i < jpgFiles.size(); ++i) {
+                const std::string& file = jpgFiles[i];
+                if (TestFramework::toLower(TestFramework::getExtension(file)) != ".jpg") continue;
+                std::string key = sub.empty() ? file : sub + "/" + file;
+                ReaderTestResult result = testReadFile<JpegReader>(TestFramework::joinPath(dir, file));
+                if (result.errorCode == 0) {
+                    fprintf(f, "%s=%08x\n", key.c_str(), result.crc);
+                    g_GeneratedCrcs["jpg/" + key] = result.crc;
+                }
+            }
+        }
+    }
+
+    // GIF test images (first frame; one level of subdirectories)
+    fprintf(f, "\n[gif]\n");
+    std::string gifDir = TestFramework::joinPath(g_TestImagesDir, "gif");
+    if (TestFramework::directoryExists(gifDir)) {
+        static const char* gifSubdirs[] = {"simple", "anim"};
+        for (size_t d = 0; d < sizeof(gifSubdirs) / sizeof(gifSubdirs[0]); ++d) {
+            std::string sub = gifSubdirs[d];
+            std::string dir = TestFramework::joinPath(gifDir, sub);
+            std::vector<std::string> gifFiles = TestFramework::listDirectory(dir);
+            for (size_t i = 0; i < gifFiles.size(); ++i) {
+                const std::string& file = gifFiles[i];
+                if (TestFramework::toLower(TestFramework::getExtension(file)) != ".gif") continue;
+                std::string key = sub + "/" + file;
+                ReaderTestResult result = testReadFile<GifReader>(TestFramework::joinPath(dir, file));
+                if (result.errorCode == 0) {
+                    fprintf(f, "%s=%08x\n", key.c_str(), result.crc);
+                    g_GeneratedCrcs["gif/" + key] = result.crc;
+                }
+            }
+        }
+    }
+
+    // ICO test images (largest, deepest entry)
+    fprintf(f, "\n[ico]\n");
+    std::string icoDir = TestFramework::joinPath(TestFramework::joinPath(g_TestImagesDir, "ico"), "images");
+    if (TestFramework::directoryExists(icoDir)) {
+        std::vector<std::string> icoFiles = TestFramework::listDirectory(icoDir);
+        for (size_t i = 0; i < icoFiles.size(); ++i) {
+            const std::string& file = icoFiles[i];
+            if (TestFramework::toLower(TestFramework::getExtension(file)) != ".ico") continue;
+            ReaderTestResult result = testReadFile<IcoReader>(TestFramework::joinPath(icoDir, file));
+            if (result.errorCode == 0) {
+                fprintf(f, "%s=%08x\n", file.c_str(), result.crc);
+                g_GeneratedCrcs["ico/" + file] = result.crc;
+            }
+        }
+    }
+
+    // TIFF test images
+    fprintf(f, "\n[tiff]\n");
+    std::string tiffDir = TestFramework::joinPath(TestFramework::joinPath(g_TestImagesDir, "tiff"), "testsuite");
+    if (TestFramework::directoryExists(tiffDir)) {
+        std::vector<std::string> tiffFiles = TestFramework::listDirectory(tiffDir);
+        for (size_t i = 0; i < tiffFiles.size(); ++i) {
+            const std::string& file = tiffFiles[i];
+            std::string ext = TestFramework::toLower(TestFramework::getExtension(file));
+            if (ext != ".tif" && ext != ".tiff") continue;
+            ReaderTestResult result = testReadFile<TiffReader>(TestFramework::joinPath(tiffDir, file));
+            if (result.errorCode == 0) {
+                fprintf(f, "%s=%08x\n", file.c_str(), result.crc);
+                g_GeneratedCrcs["tiff/" + file] = result.crc;
+            }
+        }
+    }
+
+    // Radiance HDR test images
+    fprintf(f, "\n[hdr]\n");
+    std::string hdrDir = TestFramework::joinPath(TestFramework::joinPath(g_TestImagesDir, "hdr"), "images");
+    if (TestFramework::directoryExists(hdrDir)) {
+        std::vector<std::string> hdrFiles = TestFramework::listDirectory(hdrDir);
+        for (size_t i = 0; i < hdrFiles.size(); ++i) {
+            const std::string& file = hdrFiles[i];
+            if (TestFramework::toLower(TestFramework::getExtension(file)) != ".hdr") continue;
+            ReaderTestResult result = testReadFile<HdrReader>(TestFramework::joinPath(hdrDir, file));
+            if (result.errorCode == 0) {
+                fprintf(f, "%s=%08x\n", file.c_str(), result.crc);
+                g_GeneratedCrcs["hdr/" + file] = result.crc;
+            }
+        }
+    }
+
+    fprintf(f, "\n[exr]\n");
+    std::string exrDir = TestFramework::joinPath(g_TestImagesDir, "exr");
+    if (TestFramework::directoryExists(exrDir)) {
+        std::vector<std::string> exrFiles = TestFramework::listDirectory(exrDir);
+        for (size_t i = 0; i < exrFiles.size(); ++i) {
+            const std::string& file = exrFiles[i];
+            if (TestFramework::toLower(TestFramework::getExtension(file)) != ".exr") continue;
+            ReaderTestResult result = testReadFile<ExrReader>(TestFramework::joinPath(exrDir, file));
+            if (result.errorCode == 0) {
+                fprintf(f, "%s=%08x\n", file.c_str(), result.crc);
+                g_GeneratedCrcs["exr/" + file] = result.crc;
+            }
+        }
+    }
+
+    // WebP test images (first frame of animations; one level of subdirectories)
+    fprintf(f, "\n[webp]\n");
+    std::string webpDir = TestFramework::joinPath(g_TestImagesDir, "webp");
+    if (TestFramework::directoryExists(webpDir)) {
+        static const char* webpSubdirs[] = {"extended_images", "lossless_images", "lossy_images"};
+        for (size_t d = 0; d < sizeof(webpSubdirs) / sizeof(webpSubdirs[0]); ++d) {
+            std::string sub = webpSubdirs[d];
+            std::string dir = TestFramework::joinPath(webpDir, sub);
+            std::vector<std::string> webpFiles = TestFramework::listDirectory(dir);
+            for (size_t i = 0; i < webpFiles.size(); ++i) {
+                const std::string& file = webpFiles[i];
+                if (TestFramework::toLower(TestFramework::getExtension(file)) != ".webp") continue;
+                std::string key = sub + "/" + file;
+                ReaderTestResult result = testReadFile<WebpReader>(TestFramework::joinPath(dir, file));
+                if (result.errorCode == 0) {
+                    fprintf(f, "%s=%08x\n", key.c_str(), result.crc);
+                    g_GeneratedCrcs["webp/" + key] = result.crc;
+                }
+            }
+        }
+    }
+
+    // Netpbm test images
+    fprintf(f, "\n[pbm]\n");
+    std::string pbmDir = TestFramework::joinPath(TestFramework::joinPath(g_TestImagesDir, "pbm"), "images");
+    if (TestFramework::directoryExists(pbmDir)) {
+        std::vector<std::string> pbmFiles = TestFramework::listDirectory(pbmDir);
+        for (size_t i = 0; i < pbmFiles.size(); ++i) {
+            const std::string& file = pbmFiles[i];
+            std::string ext = TestFramework::toLower(TestFramework::getExtension(file));
+            if (ext != ".pbm" && ext != ".pgm" && ext != ".ppm" && ext != ".pnm" && ext != ".pam") continue;
+            ReaderTestResult result = testReadFile<PnmReader>(TestFramework::joinPath(pbmDir, file));
+            if (result.errorCode == 0) {
+                fprintf(f, "%s=%08x\n", file.c_str(), result.crc);
+                g_GeneratedCrcs["pbm/" + file] = result.crc;
+            }
+        }
+    }
+
+    // Farbfeld test images
+    fprintf(f, "\n[farbfeld]\n");
+    std::string farbfeldDir = TestFramework::joinPath(TestFramework::joinPath(g_TestImagesDir, "farbfeld"), "transparency");
+    if (TestFramework::directoryExists(farbfeldDir)) {
+        std::vector<std::string> farbfeldFiles = TestFramework::listDirectory(farbfeldDir);
+        for (size_t i = 0; i < farbfeldFiles.size(); ++i) {
+            const std::string& file = farbfeldFiles[i];
+            if (TestFramework::toLower(TestFramework::getExtension(file)) != ".ff") continue;
+            std::string key = "transparency/" + file;
+            ReaderTestResult result = testReadFile<FarbfeldReader>(TestFramework::joinPath(farbfeldDir, file));
+            if (result.errorCode == 0) {
+                fprintf(f, "%s=%08x\n", key.c_str(), result.crc);
+                g_GeneratedCrcs["farbfeld/" + key] = result.crc;
+            }
+        }
+    }
+
+    // DDS test images
+    fprintf(f, "\n[dds]\n");
+    std::string ddsDir = TestFramework::joinPath(g_TestImagesDir, "dds");
+    if (TestFramework::directoryExists(ddsDir)) {
+        std::vector<std::string> ddsFiles = TestFramework::listDirectory(ddsDir);
+        for (size_t i = 0; i < ddsFiles.size(); ++i) {
+            const std::string& file = ddsFiles[i];
+            if (TestFramework::toLower(TestFramework::getExtension(file)) != ".dds") continue;
+            ReaderTestResult result = testReadFile<DdsReader>(TestFramework::joinPath(ddsDir, file));
+            if (result.errorCode == 0) {
+                fprintf(f, "%s=%08x\n", file.c_str(), result.crc);
+                g_GeneratedCrcs["dds/" + file] = result.crc;
+            }
+        }
+    }
+
     fclose(f);
     printf("Generated reference file: %s (%zu entries)\n", outputPath.c_str(), g_GeneratedCrcs.size());
 }
@@ -9,6 +9,7 @@
  * - Origin variations: top-left, top-right, bottom-left, bottom-right
  * - Colormap offset handling
  * - Save/load round-trips with optional RLE
+ * - Auto bit depth selection from source alpha
  */
 
 #include "TestFramework.h"
@@ -549,6 +550,90 @@ TEST(TgaReader, SaveLoad_32bit_RLE) {
     ImageReader::FreeBitmapData(props3);
 }
 
+//=============================================================================
+// Auto Bit Depth Tests
+//=============================================================================
+
+namespace {
+
+// Saves a generated BGRA image (in auto mode by default) and returns the written pixel depth
+int saveAutoAndGetDepth(std::vector<uint8_t>& pixels, int width, int height,
+                        CKDWORD bitDepth = TGA_BITDEPTH_AUTO) {
+    TgaBitmapProperties props;
+    ImageReader::FillFormatBGRA32(props.m_Format, width, height, width * 4, pixels.data());
+    props.m_BitDepth = bitDepth;
+    props.m_UseRLE = 0;
+
+    TgaReader reader;
+    void* memory = nullptr;
+    int size = reader.SaveMemory(&memory, &props);
+    if (size <= 0 || !memory) return -1;
+
+    int depth = static_cast<uint8_t*>(memory)[16];
+    reader.ReleaseMemory(memory);
+    return depth;
+}
+
+} // anonymous namespace
+
+TEST(TgaReader, SaveAuto_OpaqueWrites24bit) {
+    const int width = 37, height = 13;
+    std::vector<uint8_t> pixels(width * height * 4);
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        pixels[i] = ((i & 3) == 3) ? 0xFF : static_cast<uint8_t>(i * 7);
+    }
+    ASSERT_EQ(24, saveAutoAndGetDepth(pixels, width, height));
+}
+
+TEST(TgaReader, SaveAuto_TranslucentWrites32bit) {
+    const int width = 37, height = 13;
+    std::vector<uint8_t> pixels(width * height * 4, 0xFF);
+    // A single translucent pixel in the scalar tail must still be detected
+    pixels[(width * height - 1) * 4 + 3] = 0x80;
+    ASSERT_EQ(32, saveAutoAndGetDepth(pixels, width, height));
+
+    pixels[(width * height - 1) * 4 + 3] = 0xFF;
+    pixels[5 * 4 + 3] = 0x00;
+    ASSERT_EQ(32, saveAutoAndGetDepth(pixels, width, height));
+}
+
+TEST(TgaReader, SaveAuto_ZeroBitDepthWrites24bit) {
+    // Zero-filled properties keep saving 24-bit, whatever the source alpha
+    const int width = 8, height = 4;
+    std::vector<uint8_t> pixels(width * height * 4, 0x40);
+    ASSERT_EQ(24, saveAutoAndGetDepth(pixels, width, height, 0));
+    ASSERT_EQ(32, saveAutoAndGetDepth(pixels, width, height));
+}
+
+TEST(TgaReader, SaveAuto_RoundTripPreservesPixels) {
+    std::string inputPath = getTgaTestImagePath("testsuite", "utc32.tga");
+    if (!fileExists(inputPath)) SKIP_TEST("Test image not found");
+
+    TgaReader reader1;
+    CKBitmapProperties* props1 = nullptr;
+    int err = reader1.ReadFile(const_cast<char*>(inputPath.c_str()), &props1);
+    ASSERT_EQ(0, err);
+    ASSERT_TRUE(props1 != nullptr);
+
+    size_t imageSize = static_cast<size_t>(props1->m_Format.BytesPerLine) * props1->m_Format.Height;
+    uint32_t originalCrc = CRC32::compute(props1->m_Format.Image, imageSize);
+
+    TgaBitmapProperties* tgaProps = static_cast<TgaBitmapProperties*>(props1);
+    tgaProps->m_BitDepth = TGA_BITDEPTH_AUTO;
+    tgaProps->m_UseRLE = 1;
+
+    TgaReader reader2;
+    void* memory = nullptr;
+    int size = reader2.SaveMemory(&memory, props1);
+    ASSERT_TRUE(size > 0);
+    ImageReader::FreeBitmapData(props1);
+
+    TgaTestResult result = readTgaMemory(memory, size);
+    reader2.ReleaseMemory(memory);
+    ASSERT_EQ(0, result.errorCode);
+    ASSERT_EQ(originalCrc, result.crc);
+}
+
 //=============================================================================
 // API Tests
 //=============================================================================
@@ -600,6 +685,20 @@ TEST(TgaReader, IsAlphaSaved_32bit) {
     ASSERT_TRUE(reader.IsAlphaSaved(&props));
 }
 
+TEST(TgaReader, IsAlphaSaved_Auto) {
+    // Alpha is saved only if the image to save uses it
+    TgaReader reader;
+    TgaBitmapProperties props;
+    props.m_BitDepth = TGA_BITDEPTH_AUTO;
+    ASSERT_FALSE(reader.IsAlphaSaved(&props));
+
+    std::vector<uint8_t> pixels(4 * 3 * 4, 0xFF);
+    ImageReader::FillFormatBGRA32(props.m_Format, 4, 3, 16, pixels.data());
+    ASSERT_FALSE(reader.IsAlphaSaved(&props));
+    pixels[7 * 4 + 3] = 0x80;
+    ASSERT_TRUE(reader.IsAlphaSaved(&props));
+}
+
 //=============================================================================
 // Additional Generated TGA Tests
 //=============================================================================
@@ -1001,6 +1100,33 @@ TEST(TgaReader, Empty_File) {
     ASSERT_NE(0, result.errorCode);
 }
 
+TEST(TgaReader, Limits_PixelDataBeyondFile) {
+    // Uncompressed pixels must all be present
+    std::vector<uint8_t> data = generateTgaUncompressed24(16, 16);
+    data.pop_back();
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readTgaMemory(data.data(), static_cast<int>(data.size())).errorCode);
+
+    // RLE packets cover 128 pixels at most: 4000 x 4000 cannot fit in a few bytes
+    data = generateTgaRLE24(16, 16);
+    data[12] = data[14] = 0xA0;
+    data[13] = data[15] = 0x0F;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readTgaMemory(data.data(), static_cast<int>(data.size())).errorCode);
+}
+
+TEST(TgaReader, Limits_DecodeBudget) {
+    struct RestoreLimits {
+        ~RestoreLimits() { ImageSetDecodeLimits(0, 0); }
+    } restore;
+    std::vector<uint8_t> data = generateTgaRLE24(32, 32);
+
+    ImageSetDecodeLimits(32 * 32 - 1, 0);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readTgaMemory(data.data(), static_cast<int>(data.size())).errorCode);
+    ImageSetDecodeLimits(0, 32 * 32 * 4 - 1);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readTgaMemory(data.data(), static_cast<int>(data.size())).errorCode);
+    ImageSetDecodeLimits(32 * 32, 32 * 32 * 4);
+    ASSERT_EQ(0, readTgaMemory(data.data(), static_cast<int>(data.size())).errorCode);
+}
+
 TEST(TgaReader, Invalid_ImageType) {
     std::vector<uint8_t> data = generateTgaUncompressed24(16, 16);
     // Corrupt image type byte (offset 2)
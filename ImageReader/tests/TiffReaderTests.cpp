@@ -0,0 +1,941 @@
+/**
+ * @file TiffReaderTests.cpp
+ * @brief TIFF format tests for CKImageReader
+ *
+ * Tests cover:
+ * - LZW round trips in the TIFF flavor (MSB first, early change) and PackBits
+ * - Uncompressed, PackBits, LZW and Deflate strips and tiles, chunky and
+ *   planar, little- and big-endian, with the horizontal and float predictors
+ * - Gray, palette, RGB and CMYK images; 1 to 16-bit and float samples;
+ *   associated and unassociated alpha; BGRA64 and index output
+ * - The SIMD narrowing kernels against a scalar reference
+ * - The corpus in tests/images/tiff against CRCs and the image-rs reference images
+ * - Malformed files (bad header, chunks outside the file, truncated data)
+ */
+
+#include "TestFramework.h"
+#include "TiffReader.h"
+#include "PngReader.h"
+#include "ImageLzw.h"
+#include "ImageSimd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+
+using namespace TestFramework;
+
+//=============================================================================
+// Test Helpers
+//=============================================================================
+
+namespace {
+
+// TIFF LZW encoder: codes MSB first, widened one code early, cleared two
+// codes before the table is full (as libtiff does)
+std::vector<uint8_t> lzwEncodeTiff(const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> out;
+    uint64_t bits = 0;
+    int count = 0;
+    int width = 9;
+    int next = 258;
+    std::map<std::pair<int, int>, int> table;
+
+    struct Emit {
+        std::vector<uint8_t>& out;
+        uint64_t& bits;
+        int& count;
+        void operator()(int code, int width) {
+            bits = (bits << width) | static_cast<uint64_t>(code);
+            count += width;
+            while (count >= 8) {
+                out.push_back(static_cast<uint8_t>(bits >> (count - 8)));
+                count -= 8;
+            }
+        }
+    } emit = {out, bits, count};
+
+    emit(256, width);
+    int prefix = -1;
+    for (size_t i = 0; i < data.size(); ++i) {
+        int c = data[i];
+        if (prefix < 0) {
+            prefix = c;
+            continue;
+        }
+        std::map<std::pair<int, int>, int>::const_iterator it = table.find(std::make_pair(prefix, c));
+        if (it != table.end()) {
+            prefix = it->second;
+            continue;
+        }
+        emit(prefix, width);
+        if (next == 4094) {
+            emit(256, width);
+            table.clear();
+            width = 9;
+            next = 258;
+        } else {
+            table[std::make_pair(prefix, c)] = next++;
+            if (next == (1 << width) && width < 12) ++width;
+        }
+        prefix = c;
+    }
+    if (prefix >= 0) emit(prefix, width);
+    emit(257, width);
+    if (count > 0) out.push_back(static_cast<uint8_t>(bits << (8 - count)));
+    return out;
+}
+
+std::vector<uint8_t> packBits(const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> out;
+    size_t i = 0;
+    while (i < data.size()) {
+        size_t run = 1;
+        while (i + run < data.size() && run < 128 && data[i + run] == data[i]) ++run;
+        if (run >= 3) {
+            out.push_back(static_cast<uint8_t>(257 - run));
+            out.push_back(data[i]);
+            i += run;
+            continue;
+        }
+        size_t start = i;
+        size_t n = 0;
+        while (i < data.size() && n < 128) {
+            if (i + 2 < data.size() && data[i] == data[i + 1] && data[i] == data[i + 2]) break;
+            ++i;
+            ++n;
+        }
+        out.push_back(static_cast<uint8_t>(n - 1));
+        out.insert(out.end(), data.begin() + start, data.begin() + i);
+    }
+    return out;
+}
+
+void putBE32(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v >> 24));
+    out.push_back(static_cast<uint8_t>(v >> 16));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+// zlib stream of stored deflate blocks
+std::vector<uint8_t> zlibStore(const std::vector<uint8_t>& raw) {
+    std::vector<uint8_t> z;
+    z.push_back(0x78);
+    z.push_back(0x01);
+    for (size_t pos = 0; pos == 0 || pos < raw.size(); pos += 65535) {
+        size_t n = std::min<size_t>(65535, raw.size() - pos);
+        z.push_back(pos + n == raw.size() ? 1 : 0);
+        z.push_back(static_cast<uint8_t>(n));
+        z.push_back(static_cast<uint8_t>(n >> 8));
+        z.push_back(static_cast<uint8_t>(~n));
+        z.push_back(static_cast<uint8_t>(~n >> 8));
+        z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + n);
+    }
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < raw.size(); ++i) {
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    putBE32(z, (b << 16) | a);
+    return z;
+}
+
+struct TagSpec {
+    uint16_t tag;
+    uint16_t type;
+    std::vector<uint32_t> values;
+
+    TagSpec(uint16_t t, uint16_t ty, const std::vector<uint32_t>& v) : tag(t), type(ty), values(v) {}
+};
+
+// Builds a TIFF file: header, chunk data, IFD, then out-of-line tag arrays.
+// The offsets and byte counts tags are generated from chunks.
+struct TiffBuilder {
+    bool bigEndian;
+    std::vector<TagSpec> tags;
+    std::vector<std::vector<uint8_t> > chunks;
+    bool tiled;
+
+    TiffBuilder() : bigEndian(false), tiled(false) {}
+
+    void set(uint16_t tag, uint32_t value, uint16_t type = TIFF_TYPE_SHORT) {
+        setArray(tag, std::vector<uint32_t>(1, value), type);
+    }
+
+    void setArray(uint16_t tag, const std::vector<uint32_t>& values, uint16_t type = TIFF_TYPE_SHORT) {
+        for (size_t i = 0; i < tags.size(); ++i) {
+            if (tags[i].tag == tag) {
+                tags[i] = TagSpec(tag, type, values);
+                return;
+            }
+        }
+        tags.push_back(TagSpec(tag, type, values));
+    }
+
+    void remove(uint16_t tag) {
+        for (size_t i = 0; i < tags.size(); ++i)
+            if (tags[i].tag == tag) tags.erase(tags.begin() + i--);
+    }
+
+    void put(std::vector<uint8_t>& out, uint32_t v, int size) const {
+        for (int i = 0; i < size; ++i) {
+            int shift = bigEndian ? (size - 1 - i) * 8 : i * 8;
+            out.push_back(static_cast<uint8_t>(v >> shift));
+        }
+    }
+
+    void write(std::vector<uint8_t>& out, size_t pos, uint32_t v, int size) const {
+        std::vector<uint8_t> tmp;
+        put(tmp, v, size);
+        std::copy(tmp.begin(), tmp.end(), out.begin() + pos);
+    }
+
+    std::vector<uint8_t> build() const {
+        std::vector<uint8_t> out;
+        out.push_back(bigEndian ? 'M' : 'I');
+        out.push_back(bigEndian ? 'M' : 'I');
+        put(out, TIFF_MAGIC, 2);
+        put(out, 0, 4);
+
+        std::vector<uint32_t> offsets, counts;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            offsets.push_back(static_cast<uint32_t>(out.size()));
+            counts.push_back(static_cast<uint32_t>(chunks[i].size()));
+            out.insert(out.end(), chunks[i].begin(), chunks[i].end());
+        }
+        if (out.size() & 1) out.push_back(0);
+
+        std::vector<TagSpec> all = tags;
+        if (!chunks.empty()) {
+            all.push_back(TagSpec(tiled ? TIFF_TAG_TILE_OFFSETS : TIFF_TAG_STRIP_OFFSETS, TIFF_TYPE_LONG, offsets));
+            all.push_back(TagSpec(tiled ? TIFF_TAG_TILE_BYTE_COUNTS : TIFF_TAG_STRIP_BYTE_COUNTS, TIFF_TYPE_LONG, counts));
+        }
+        struct ByTag {
+            bool operator()(const TagSpec& a, const TagSpec& b) const { return a.tag < b.tag; }
+        };
+        std::sort(all.begin(), all.end(), ByTag());
+
+        uint32_t ifd = static_cast<uint32_t>(out.size());
+        write(out, 4, ifd, 4);
+        put(out, static_cast<uint32_t>(all.size()), 2);
+        size_t extraPos = out.size() + all.size() * TIFF_ENTRY_SIZE + 4;
+        std::vector<uint8_t> extra;
+        for (size_t i = 0; i < all.size(); ++i) {
+            const TagSpec& t = all[i];
+            int size = (t.type == TIFF_TYPE_BYTE) ? 1 : (t.type == TIFF_TYPE_SHORT) ? 2 : 4;
+            std::vector<uint8_t> values;
+            for (size_t k = 0; k < t.values.size(); ++k) put(values, t.values[k], size);
+            put(out, t.tag, 2);
+            put(out, t.type, 2);
+            put(out, static_cast<uint32_t>(t.values.size()), 4);
+            if (values.size() <= 4) {
+                values.resize(4, 0);
+                out.insert(out.end(), values.begin(), values.end());
+            } else {
+                put(out, static_cast<uint32_t>(extraPos + extra.size()), 4);
+                extra.insert(extra.end(), values.begin(), values.end());
+                if (extra.size() & 1) extra.push_back(0);
+            }
+        }
+        put(out, 0, 4);
+        out.insert(out.end(), extra.begin(), extra.end());
+        return out;
+    }
+};
+
+// Image described by its samples (8 or 16 bits, or floats stored as raw bits),
+// row-major and chunky, which the builder splits into chunks
+struct ImageSpec {
+    uint32_t width;
+    uint32_t height;
+    uint32_t samplesPerPixel;
+    uint32_t bitsPerSample;
+    uint32_t photometric;
+    std::vector<uint32_t> samples;
+
+    ImageSpec(uint32_t w, uint32_t h, uint32_t spp, uint32_t bps, uint32_t photo)
+        : width(w), height(h), samplesPerPixel(spp), bitsPerSample(bps), photometric(photo),
+          samples(w * h * spp, 0) {}
+
+    uint32_t& at(uint32_t x, uint32_t y, uint32_t s) { return samples[(y * width + x) * samplesPerPixel + s]; }
+    uint32_t at(uint32_t x, uint32_t y, uint32_t s) const { return samples[(y * width + x) * samplesPerPixel + s]; }
+};
+
+ImageSpec makeRgb(uint32_t w, uint32_t h, uint32_t spp, uint32_t bps, int seed) {
+    ImageSpec img(w, h, spp, bps, TIFF_PHOTOMETRIC_RGB);
+    uint32_t maxValue = (bps == 16) ? 0xFFFF : 0xFF;
+    for (uint32_t y = 0; y < h; ++y)
+        for (uint32_t x = 0; x < w; ++x)
+            for (uint32_t s = 0; s < spp; ++s)
+                img.at(x, y, s) = ((x * 37 + y * 11 + s * 71 + seed * 13) * (bps == 16 ? 257 : 1) + x * y) & maxValue;
+    return img;
+}
+
+struct Layout {
+    uint32_t compression;
+    uint32_t predictor;
+    bool planar;
+    bool bigEndian;
+    uint32_t rowsPerStrip; // 0 = one strip
+    uint32_t tileWidth;    // 0 = strips
+    uint32_t tileHeight;
+
+    Layout() : compression(TIFF_COMPRESSION_NONE), predictor(TIFF_PREDICTOR_NONE), planar(false), bigEndian(false),
+               rowsPerStrip(0), tileWidth(0), tileHeight(0) {}
+};
+
+// Encodes one chunk row of samples (already predicted) in file byte order
+void putSamples(std::vector<uint8_t>& out, const std::vector<uint32_t>& row, uint32_t bps, bool bigEndian) {
+    if (bps < 8) {
+        size_t start = out.size();
+        size_t bytes = (row.size() * bps + 7) / 8;
+        out.resize(start + bytes, 0);
+        for (size_t i = 0; i < row.size(); ++i) {
+            size_t bit = i * bps;
+            out[start + bit / 8] |= static_cast<uint8_t>(row[i] << (8 - bps - bit % 8));
+        }
+        return;
+    }
+    int size = static_cast<int>(bps / 8);
+    for (size_t i = 0; i < row.size(); ++i)
+        for (int b = 0; b < size; ++b) {
+            int shift = bigEndian ? (size - 1 - b) * 8 : b * 8;
+            out.push_back(static_cast<uint8_t>(row[i] >> shift));
+        }
+}
+
+std::vector<uint8_t> compress(const std::vector<uint8_t>& raw, uint32_t compression) {
+    switch (compression) {
+    case TIFF_COMPRESSION_PACKBITS:
+        return packBits(raw);
+    case TIFF_COMPRESSION_LZW:
+        return lzwEncodeTiff(raw);
+    case TIFF_COMPRESSION_DEFLATE:
+    case TIFF_COMPRESSION_ADOBE_DEFLATE:
+        return zlibStore(raw);
+    default:
+        return raw;
+    }
+}
+
+// Splits, predicts and compresses the image. Tiles are padded with zeros.
+TiffBuilder makeTiff(const ImageSpec& img, const Layout& layout, uint32_t sampleFormat = TIFF_SAMPLE_FORMAT_UINT) {
+    TiffBuilder b;
+    b.bigEndian = layout.bigEndian;
+    b.set(TIFF_TAG_IMAGE_WIDTH, img.width, TIFF_TYPE_LONG);
+    b.set(TIFF_TAG_IMAGE_LENGTH, img.height, TIFF_TYPE_LONG);
+    b.setArray(TIFF_TAG_BITS_PER_SAMPLE, std::vector<uint32_t>(img.samplesPerPixel, img.bitsPerSample));
+    b.set(TIFF_TAG_COMPRESSION, layout.compression);
+    b.set(TIFF_TAG_PHOTOMETRIC, img.photometric);
+    b.set(TIFF_TAG_SAMPLES_PER_PIXEL, img.samplesPerPixel);
+    b.set(TIFF_TAG_PLANAR_CONFIG, layout.planar ? 2 : 1);
+    if (layout.predictor != TIFF_PREDICTOR_NONE) b.set(TIFF_TAG_PREDICTOR, layout.predictor);
+    if (sampleFormat != TIFF_SAMPLE_FORMAT_UINT)
+        b.setArray(TIFF_TAG_SAMPLE_FORMAT, std::vector<uint32_t>(img.samplesPerPixel, sampleFormat));
+
+    uint32_t cw = img.width, ch = layout.rowsPerStrip ? std::min(layout.rowsPerStrip, img.height) : img.height;
+    if (layout.tileWidth) {
+        b.tiled = true;
+        cw = layout.tileWidth;
+        ch = layout.tileHeight;
+        b.set(TIFF_TAG_TILE_WIDTH, cw);
+        b.set(TIFF_TAG_TILE_LENGTH, ch);
+    } else {
+        b.set(TIFF_TAG_ROWS_PER_STRIP, ch, TIFF_TYPE_LONG);
+    }
+
+    uint32_t planes = layout.planar ? img.samplesPerPixel : 1;
+    uint32_t chunkSamples = layout.planar ? 1 : img.samplesPerPixel;
+    uint32_t across = (img.width + cw - 1) / cw, down = (img.height + ch - 1) / ch;
+    for (uint32_t p = 0; p < planes; ++p)
+        for (uint32_t cy = 0; cy < down; ++cy)
+            for (uint32_t cx = 0; cx < across; ++cx) {
+                uint32_t rows = layout.tileWidth ? ch : std::min(ch, img.height - cy * ch);
+                std::vector<uint8_t> raw;
+                for (uint32_t y = 0; y < rows; ++y) {
+                    std::vector<uint32_t> row;
+                    for (uint32_t x = 0; x < cw; ++x)
+                        for (uint32_t s = 0; s < chunkSamples; ++s) {
+                            uint32_t ix = cx * cw + x, iy = cy * ch + y;
+                            bool inside = ix < img.width && iy < img.height;
+                            row.push_back(inside ? img.at(ix, iy, layout.planar ? p : s) : 0);
+                        }
+                    if (layout.predictor == TIFF_PREDICTOR_HORIZONTAL) {
+                        uint32_t mask = (img.bitsPerSample == 16) ? 0xFFFF : 0xFF;
+                        for (size_t i = row.size() - 1; i >= chunkSamples; --i)
+                            row[i] = (row[i] - row[i - chunkSamples]) & mask;
+                    }
+                    if (layout.predictor == TIFF_PREDICTOR_FLOAT) {
+                        // Byte planes, most significant first, then byte differences
+                        size_t n = row.size();
+                        std::vector<uint8_t> planesRow(n * 4);
+                        for (size_t i = 0; i < n; ++i)
+                            for (int k = 0; k < 4; ++k) planesRow[k * n + i] = static_cast<uint8_t>(row[i] >> (24 - 8 * k));
+                        for (size_t i = planesRow.size() - 1; i >= chunkSamples; --i)
+                            planesRow[i] = static_cast<uint8_t>(planesRow[i] - planesRow[i - chunkSamples]);
+                        raw.insert(raw.end(), planesRow.begin(), planesRow.end());
+                    } else {
+                        putSamples(raw, row, img.bitsPerSample, layout.bigEndian);
+                    }
+                }
+                b.chunks.push_back(compress(raw, layout.compression));
+            }
+    return b;
+}
+
+struct TiffTestResult {
+    int errorCode;
+    int width;
+    int height;
+    int bitsPerPixel;
+    std::vector<uint8_t> pixels; // tightly packed rows
+    std::vector<uint8_t> palette;
+    CKDWORD bitsPerSample;
+    CKDWORD samplesPerPixel;
+};
+
+TiffTestResult readTiff(const std::vector<uint8_t>& data, CKDWORD flags = 0) {
+    TiffTestResult result;
+    TiffReader reader;
+    reader.SetReadFlags(flags);
+    CKBitmapProperties* props = nullptr;
+    result.errorCode = reader.ReadMemory(const_cast<uint8_t*>(data.data()), static_cast<int>(data.size()), &props);
+    result.width = 0;
+    result.height = 0;
+    result.bitsPerPixel = 0;
+    result.bitsPerSample = 0;
+    result.samplesPerPixel = 0;
+    if (result.errorCode == 0 && props && props->m_Format.Image) {
+        const VxImageDescEx& fmt = props->m_Format;
+        result.width = fmt.Width;
+        result.height = fmt.Height;
+        result.bitsPerPixel = fmt.BitsPerPixel;
+        for (int y = 0; y < fmt.Height; ++y) {
+            const uint8_t* row = fmt.Image + y * fmt.BytesPerLine;
+            result.pixels.insert(result.pixels.end(), row, row + fmt.Width * fmt.BitsPerPixel / 8);
+        }
+        if (fmt.ColorMap) result.palette.assign(fmt.ColorMap, fmt.ColorMap + fmt.ColorMapEntries * 4);
+        TiffBitmapProperties* tp = reinterpret_cast<TiffBitmapProperties*>(props);
+        result.bitsPerSample = tp->m_BitsPerSample;
+        result.samplesPerPixel = tp->m_SamplesPerPixel;
+    }
+    return result;
+}
+
+TiffTestResult readTiffFile(const std::string& path, CKDWORD flags = 0) {
+    return readTiff(readBinaryFile(path), flags);
+}
+
+// Expected BGRA32 of an 8-bit RGB(A) image with unassociated or no alpha
+std::vector<uint8_t> expectRgb8(const ImageSpec& img) {
+    std::vector<uint8_t> out;
+    for (uint32_t y = 0; y < img.height; ++y)
+        for (uint32_t x = 0; x < img.width; ++x) {
+            out.push_back(static_cast<uint8_t>(img.at(x, y, 2)));
+            out.push_back(static_cast<uint8_t>(img.at(x, y, 1)));
+            out.push_back(static_cast<uint8_t>(img.at(x, y, 0)));
+            out.push_back(img.samplesPerPixel > 3 ? static_cast<uint8_t>(img.at(x, y, 3)) : 255);
+        }
+    return out;
+}
+
+void addUnassociatedAlpha(TiffBuilder& b) { b.set(TIFF_TAG_EXTRA_SAMPLES, TIFF_EXTRA_UNASSOCIATED_ALPHA); }
+
+std::string tiffImagesDir() { return joinPath(joinPath(g_TestImagesDir, "tiff"), "testsuite"); }
+
+uint32_t floatBits(float f) {
+    uint32_t v;
+    memcpy(&v, &f, 4);
+    return v;
+}
+
+} // namespace
+
+//=============================================================================
+// LZW and PackBits
+//=============================================================================
+
+TEST(TiffReader, Lzw_TiffFlavorRoundTrip) {
+    // Sizes around the width changes and past a full table (clear codes)
+    static const size_t sizes[] = {1, 2, 300, 800, 3000, 70000};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        std::vector<uint8_t> data(sizes[i]);
+        uint32_t state = static_cast<uint32_t>(i + 1);
+        for (size_t k = 0; k < data.size(); ++k) {
+            state = state * 1103515245u + 12345u;
+            data[k] = static_cast<uint8_t>((state >> 16) % ((k / 1000) % 2 ? 4 : 256));
+        }
+        std::vector<uint8_t> code = lzwEncodeTiff(data);
+        std::vector<uint8_t> out(data.size());
+        CKDWORD n = ImageLzwDecodeTiff(code.data(), static_cast<CKDWORD>(code.size()), out.data(),
+                                       static_cast<CKDWORD>(out.size()));
+        ASSERT_EQ(static_cast<CKDWORD>(data.size()), n);
+        ASSERT_TRUE(out == data);
+    }
+}
+
+TEST(TiffReader, Lzw_RunsUseCodeNotYetInTable) {
+    // A long run makes the encoder emit each code right after defining it
+    std::vector<uint8_t> data(5000, 0x5A);
+    std::vector<uint8_t> code = lzwEncodeTiff(data);
+    std::vector<uint8_t> out(data.size());
+    ASSERT_EQ(static_cast<CKDWORD>(data.size()),
+              ImageLzwDecodeTiff(code.data(), static_cast<CKDWORD>(code.size()), out.data(),
+                                 static_cast<CKDWORD>(out.size())));
+    ASSERT_TRUE(out == data);
+}
+
+TEST(TiffReader, PackBits_SpecificationExample) {
+    // The example from the TIFF 6.0 specification
+    static const uint8_t packed[] = {0xFE, 0xAA, 0x02, 0x80, 0x00, 0x2A, 0xFD, 0xAA, 0x03,
+                                     0x80, 0x00, 0x2A, 0x22, 0xF7, 0xAA};
+    static const uint8_t expected[] = {0xAA, 0xAA, 0xAA, 0x80, 0x00, 0x2A, 0xAA, 0xAA, 0xAA, 0xAA, 0x80, 0x00,
+                                       0x2A, 0x22, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA};
+    uint8_t out[sizeof(expected) + 4];
+    ASSERT_EQ(static_cast<CKDWORD>(sizeof(expected)), TIFF_UnpackBits(packed, sizeof(packed), out, sizeof(out)));
+    ASSERT_TRUE(memcmp(out, expected, sizeof(expected)) == 0);
+
+    // Output is cut at the buffer end, input at the data end
+    ASSERT_EQ(5u, TIFF_UnpackBits(packed, sizeof(packed), out, 5));
+    ASSERT_EQ(3u, TIFF_UnpackBits(packed, 3, out, sizeof(out)));
+}
+
+//=============================================================================
+// Layout Tests
+//=============================================================================
+
+TEST(TiffReader, Strips_UncompressedRgb) {
+    ImageSpec img = makeRgb(37, 21, 3, 8, 1);
+    Layout layout;
+    layout.rowsPerStrip = 4;
+    TiffTestResult r = readTiff(makeTiff(img, layout).build());
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(37, r.width);
+    ASSERT_EQ(21, r.height);
+    ASSERT_EQ(32, r.bitsPerPixel);
+    ASSERT_TRUE(r.pixels == expectRgb8(img));
+    ASSERT_EQ(8u, r.bitsPerSample);
+    ASSERT_EQ(3u, r.samplesPerPixel);
+}
+
+TEST(TiffReader, Compressions_AllMatch) {
+    // Every compression, with and without the predictor, gives the same pixels
+    ImageSpec img = makeRgb(50, 33, 4, 8, 2);
+    std::vector<uint8_t> expected = expectRgb8(img);
+    static const uint32_t compressions[] = {TIFF_COMPRESSION_NONE, TIFF_COMPRESSION_PACKBITS, TIFF_COMPRESSION_LZW,
+                                            TIFF_COMPRESSION_DEFLATE, TIFF_COMPRESSION_ADOBE_DEFLATE};
+    for (size_t c = 0; c < sizeof(compressions) / sizeof(compressions[0]); ++c) {
+        for (int predict = 0; predict < 2; ++predict) {
+            Layout layout;
+            layout.compression = compressions[c];
+            layout.predictor = predict ? TIFF_PREDICTOR_HORIZONTAL : TIFF_PREDICTOR_NONE;
+            layout.rowsPerStrip = 7;
+            TiffBuilder b = makeTiff(img, layout);
+            addUnassociatedAlpha(b);
+            TiffTestResult r = readTiff(b.build());
+            ASSERT_EQ(0, r.errorCode);
+            ASSERT_TRUE(r.pixels == expected);
+        }
+    }
+}
+
+TEST(TiffReader, Tiles_PartialEdgeTiles) {
+    ImageSpec img = makeRgb(45, 39, 3, 8, 3);
+    Layout layout;
+    layout.tileWidth = 16;
+    layout.tileHeight = 16;
+    layout.compression = TIFF_COMPRESSION_LZW;
+    layout.predictor = TIFF_PREDICTOR_HORIZONTAL;
+    TiffTestResult r = readTiff(makeTiff(img, layout).build());
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_TRUE(r.pixels == expectRgb8(img));
+}
+
+TEST(TiffReader, Planar_StripsAndTiles) {
+    ImageSpec img = makeRgb(30, 25, 4, 8, 4);
+    std::vector<uint8_t> expected = expectRgb8(img);
+    for (int tiled = 0; tiled < 2; ++tiled) {
+        Layout layout;
+        layout.planar = true;
+        layout.compression = TIFF_COMPRESSION_DEFLATE;
+        layout.predictor = TIFF_PREDICTOR_HORIZONTAL;
+        layout.rowsPerStrip = 6;
+        layout.tileWidth = tiled ? 16 : 0;
+        layout.tileHeight = tiled ? 16 : 0;
+        TiffBuilder b = makeTiff(img, layout);
+        addUnassociatedAlpha(b);
+        TiffTestResult r = readTiff(b.build());
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_TRUE(r.pixels == expected);
+    }
+}
+
+TEST(TiffReader, ManyStrips_MatchSingleStrip) {
+    // One row per strip spreads the work over the whole pool
+    ImageSpec img = makeRgb(64, 300, 3, 8, 5);
+    Layout single;
+    single.compression = TIFF_COMPRESSION_LZW;
+    Layout many = single;
+    many.rowsPerStrip = 1;
+    TiffTestResult a = readTiff(makeTiff(img, single).build());
+    TiffTestResult b = readTiff(makeTiff(img, many).build());
+    ASSERT_EQ(0, a.errorCode);
+    ASSERT_EQ(0, b.errorCode);
+    ASSERT_TRUE(a.pixels == b.pixels);
+    ASSERT_TRUE(a.pixels == expectRgb8(img));
+}
+
+TEST(TiffReader, ShortStrip_PaddedWithZeros) {
+    ImageSpec img = makeRgb(8, 4, 3, 8, 6);
+    TiffBuilder b = makeTiff(img, Layout());
+    b.chunks[0].resize(8 * 3 * 2);
+    TiffTestResult r = readTiff(b.build());
+    ASSERT_EQ(0, r.errorCode);
+    std::vector<uint8_t> expected = expectRgb8(img);
+    ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + 8 * 4 * 2, r.pixels.begin()));
+    for (size_t i = 8 * 4 * 2; i < r.pixels.size(); ++i) ASSERT_EQ((i % 4 == 3) ? 255 : 0, r.pixels[i]);
+}
+
+//=============================================================================
+// Sample Format Tests
+//=============================================================================
+
+TEST(TiffReader, BigEndian16Bit_NarrowedAndKept) {
+    ImageSpec img = makeRgb(41, 9, 3, 16, 7);
+    for (int predict = 0; predict < 2; ++predict) {
+        Layout layout;
+        layout.bigEndian = true;
+        layout.compression = predict ? TIFF_COMPRESSION_LZW : TIFF_COMPRESSION_NONE;
+        layout.predictor = predict ? TIFF_PREDICTOR_HORIZONTAL : TIFF_PREDICTOR_NONE;
+        layout.rowsPerStrip = 4;
+        std::vector<uint8_t> tiff = makeTiff(img, layout).build();
+
+        TiffTestResult r = readTiff(tiff);
+        ASSERT_EQ(0, r.errorCode);
+        TiffTestResult wide = readTiff(tiff, IMAGE_READ_KEEP_16BIT);
+        ASSERT_EQ(0, wide.errorCode);
+        ASSERT_EQ(64, wide.bitsPerPixel);
+        for (uint32_t i = 0; i < img.width * img.height; ++i) {
+            for (int c = 0; c < 3; ++c) {
+                uint32_t v = img.samples[i * 3 + 2 - c];
+                ASSERT_EQ(static_cast<int>(v >> 8), r.pixels[i * 4 + c]);
+                ASSERT_EQ(static_cast<int>(v), wide.pixels[i * 8 + c * 2] | (wide.pixels[i * 8 + c * 2 + 1] << 8));
+            }
+            ASSERT_EQ(255, r.pixels[i * 4 + 3]);
+            ASSERT_EQ(0xFFFF, wide.pixels[i * 8 + 6] | (wide.pixels[i * 8 + 7] << 8));
+        }
+        ASSERT_EQ(16u, r.bitsPerSample);
+    }
+}
+
+TEST(TiffReader, Gray_PackedDepthsAndMinIsWhite) {
+    static const uint32_t depths[] = {1, 2, 4, 8};
+    for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); ++d) {
+        uint32_t bps = depths[d];
+        uint32_t maxValue = (1u << bps) - 1;
+        for (int white = 0; white < 2; ++white) {
+            ImageSpec img(13, 5, 1, bps, white ? TIFF_PHOTOMETRIC_MIN_IS_WHITE : TIFF_PHOTOMETRIC_MIN_IS_BLACK);
+            for (uint32_t i = 0; i < img.samples.size(); ++i) img.samples[i] = (i * 7) & maxValue;
+            Layout layout;
+            layout.compression = TIFF_COMPRESSION_PACKBITS;
+            layout.rowsPerStrip = 2;
+            TiffTestResult r = readTiff(makeTiff(img, layout).build());
+            ASSERT_EQ(0, r.errorCode);
+            for (uint32_t i = 0; i < img.samples.size(); ++i) {
+                uint32_t gray = img.samples[i] * 255 / maxValue;
+                if (white) gray = 255 - gray;
+                ASSERT_EQ(static_cast<int>(gray), r.pixels[i * 4]);
+                ASSERT_EQ(static_cast<int>(gray), r.pixels[i * 4 + 2]);
+                ASSERT_EQ(255, r.pixels[i * 4 + 3]);
+            }
+        }
+    }
+}
+
+TEST(TiffReader, Palette_ColorsAndIndices) {
+    ImageSpec img(19, 6, 1, 4, TIFF_PHOTOMETRIC_PALETTE);
+    for (uint32_t i = 0; i < img.samples.size(); ++i) img.samples[i] = (i * 5) & 15;
+    TiffBuilder b = makeTiff(img, Layout());
+    std::vector<uint32_t> colorMap(48);
+    for (uint32_t i = 0; i < 16; ++i) {
+        colorMap[i] = (i * 16) * 257;
+        colorMap[16 + i] = (255 - i) * 257;
+        colorMap[32 + i] = (i * 3) * 257 + 0x7F; // only the high byte counts
+    }
+    b.setArray(TIFF_TAG_COLOR_MAP, colorMap);
+    std::vector<uint8_t> tiff = b.build();
+
+    TiffTestResult r = readTiff(tiff);
+    ASSERT_EQ(0, r.errorCode);
+    for (uint32_t i = 0; i < img.samples.size(); ++i) {
+        uint32_t v = img.samples[i];
+        ASSERT_EQ(static_cast<int>(v * 3), r.pixels[i * 4]);
+        ASSERT_EQ(static_cast<int>(255 - v), r.pixels[i * 4 + 1]);
+        ASSERT_EQ(static_cast<int>(v * 16), r.pixels[i * 4 + 2]);
+    }
+
+    TiffTestResult idx = readTiff(tiff, IMAGE_READ_KEEP_INDICES);
+    ASSERT_EQ(0, idx.errorCode);
+    ASSERT_EQ(8, idx.bitsPerPixel);
+    ASSERT_EQ(16u * 4, static_cast<CKDWORD>(idx.palette.size()));
+    for (uint32_t i = 0; i < img.samples.size(); ++i) ASSERT_EQ(static_cast<int>(img.samples[i]), idx.pixels[i]);
+    ASSERT_EQ(5 * 16, idx.palette[5 * 4 + 2]);
+
+    // A color map of the wrong size is corrupt
+    b.setArray(TIFF_TAG_COLOR_MAP, std::vector<uint32_t>(45, 0));
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readTiff(b.build()).errorCode);
+}
+
+TEST(TiffReader, Alpha_AssociatedIsUnpremultiplied) {
+    ImageSpec img(4, 1, 4, 8, TIFF_PHOTOMETRIC_RGB);
+    static const uint32_t px[4][4] = {{100, 50, 0, 200}, {0, 0, 0, 0}, {128, 64, 32, 128}, {10, 20, 30, 255}};
+    for (uint32_t x = 0; x < 4; ++x)
+        for (uint32_t s = 0; s < 4; ++s) img.at(x, 0, s) = px[x][s];
+    TiffBuilder b = makeTiff(img, Layout());
+    b.set(TIFF_TAG_EXTRA_SAMPLES, TIFF_EXTRA_ASSOCIATED_ALPHA);
+    TiffTestResult r = readTiff(b.build());
+    ASSERT_EQ(0, r.errorCode);
+    static const uint8_t expected[16] = {0, 64, 128, 200, 0, 0, 0, 0, 64, 128, 255, 128, 30, 20, 10, 255};
+    ASSERT_TRUE(memcmp(r.pixels.data(), expected, 16) == 0);
+
+    // Without ExtraSamples the fourth sample is not alpha
+    b.remove(TIFF_TAG_EXTRA_SAMPLES);
+    r = readTiff(b.build());
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(255, r.pixels[7]);
+    ASSERT_EQ(50, r.pixels[1]);
+}
+
+TEST(TiffReader, Cmyk_ConvertedToRgb) {
+    ImageSpec img(3, 1, 4, 8, TIFF_PHOTOMETRIC_SEPARATED);
+    static const uint32_t px[3][4] = {{0, 0, 0, 0}, {255, 0, 0, 0}, {0, 128, 0, 51}};
+    for (uint32_t x = 0; x < 3; ++x)
+        for (uint32_t s = 0; s < 4; ++s) img.at(x, 0, s) = px[x][s];
+    Layout layout;
+    layout.compression = TIFF_COMPRESSION_LZW;
+    layout.predictor = TIFF_PREDICTOR_HORIZONTAL;
+    TiffTestResult r = readTiff(makeTiff(img, layout).build());
+    ASSERT_EQ(0, r.errorCode);
+    static const uint8_t expected[12] = {255, 255, 255, 255, 255, 255, 0, 255, 204, 101, 204, 255};
+    ASSERT_TRUE(memcmp(r.pixels.data(), expected, 12) == 0);
+}
+
+TEST(TiffReader, Float_PredictorAndClamping) {
+    ImageSpec img(20, 3, 3, 32, TIFF_PHOTOMETRIC_RGB);
+    static const float special[] = {-1.0f, 2.0f, NAN, 0.5f, 1.0f, 0.0f};
+    for (uint32_t i = 0; i < img.samples.size(); ++i) {
+        float f = (i < 6) ? special[i] : static_cast<float>(i % 97) / 96.0f;
+        img.samples[i] = floatBits(f);
+    }
+    for (int be = 0; be < 2; ++be) {
+        for (int predict = 0; predict < 2; ++predict) {
+            Layout layout;
+            layout.bigEndian = be != 0;
+            layout.compression = TIFF_COMPRESSION_DEFLATE;
+            layout.predictor = predict ? TIFF_PREDICTOR_FLOAT : TIFF_PREDICTOR_NONE;
+            TiffTestResult r = readTiff(makeTiff(img, layout, TIFF_SAMPLE_FORMAT_FLOAT).build());
+            ASSERT_EQ(0, r.errorCode);
+            ASSERT_EQ(32u, r.bitsPerSample);
+            // Pixel 0: R -1 -> 0, G 2 -> 255, B NaN -> 0; pixel 1: 0.5, 1, 0
+            static const uint8_t first[8] = {0, 255, 0, 255, 0, 255, 128, 255};
+            ASSERT_TRUE(memcmp(r.pixels.data(), first, 8) == 0);
+            for (uint32_t i = 2; i < img.width * img.height; ++i)
+                for (int c = 0; c < 3; ++c) {
+                    float f;
+                    memcpy(&f, &img.samples[i * 3 + 2 - c], 4);
+                    ASSERT_EQ(static_cast<int>(f * 255.0f + 0.5f), r.pixels[i * 4 + c]);
+                }
+        }
+    }
+}
+
+TEST(TiffReader, Simd_NarrowingMatchesScalar) {
+    for (int count = 0; count < 80; ++count) {
+        std::vector<CKWORD> words(count);
+        std::vector<float> floats(count);
+        for (int i = 0; i < count; ++i) {
+            words[i] = static_cast<CKWORD>(i * 2749 + 13);
+            floats[i] = (i % 7 == 0) ? -0.25f : (i % 11 == 0) ? 1.5f : static_cast<float>(i) / 79.0f;
+        }
+        std::vector<CKBYTE> a(count + 1, 0xEE), b(count + 1, 0xEE);
+        ImageNarrow16To8(words.data(), a.data(), count);
+        ImageFloatTo8(floats.data(), b.data(), count);
+        for (int i = 0; i < count; ++i) {
+            ASSERT_EQ(words[i] >> 8, a[i]);
+            float f = std::min(std::max(floats[i], 0.0f), 1.0f);
+            ASSERT_EQ(static_cast<int>(f * 255.0f + 0.5f), b[i]);
+        }
+        ASSERT_EQ(0xEE, a[count]);
+        ASSERT_EQ(0xEE, b[count]);
+    }
+}
+
+//=============================================================================
+// Reader Tests
+//=============================================================================
+
+TEST(TiffReader, ReaderInfo) {
+    TiffReader reader;
+    CKPluginInfo* info = reader.GetReaderInfo();
+    ASSERT_TRUE(info != nullptr);
+    ASSERT_GUID_EQ(TIFFREADER_GUID, info->m_GUID);
+    ASSERT_EQ(0, reader.SaveFile(const_cast<char*>("unused.tif"), nullptr));
+}
+
+//=============================================================================
+// Corpus Tests
+//=============================================================================
+
+TEST(TiffReader, Corpus_ReferenceCrcs) {
+    std::vector<std::string> files = collectFilesWithExtensions(tiffImagesDir(), {".tiff", ".tif"});
+    int checked = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        uint32_t crc = 0;
+        if (!getReferenceCrc("tiff/" + files[i], crc)) continue;
+        TiffTestResult r = readTiffFile(joinPath(tiffImagesDir(), files[i]));
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_CRC(crc, r.pixels.data(), r.pixels.size());
+        ++checked;
+    }
+    if (checked == 0) SKIP_TEST("TIFF corpus or reference CRCs not found");
+}
+
+TEST(TiffReader, Corpus_MatchesReferenceImages) {
+    // 16-bit references are compared on their high bytes; float images were
+    // rounded to 16 bits for the references, so they may be off by one. The
+    // references keep associated alpha premultiplied, the reader does not.
+    std::string refDir = joinPath(joinPath(g_TestReferenceDir, "tiff"), "testsuite");
+    std::vector<std::string> refs = listDirectory(refDir);
+    int compared = 0;
+    for (size_t i = 0; i < refs.size(); ++i) {
+        ReferenceInfo info = parseReferenceFilename(refs[i]);
+        std::string imagePath = joinPath(tiffImagesDir(), info.inputName);
+        if (!info.valid || !fileExists(imagePath)) continue;
+
+        std::vector<uint8_t> data = readBinaryFile(imagePath);
+        TiffTestResult image = readTiff(data);
+        if (image.errorCode == CKBITMAPERROR_UNSUPPORTEDFILE) continue; // fax4.tiff
+        ASSERT_EQ(0, image.errorCode);
+        TiffImageInfo tiffInfo;
+        ASSERT_EQ(0, TIFF_ReadInfo(data.data(), static_cast<CKDWORD>(data.size()), tiffInfo));
+        bool premultiply = tiffInfo.alphaType == TIFF_EXTRA_ASSOCIATED_ALPHA;
+        for (size_t k = 0; premultiply && k < image.pixels.size(); ++k)
+            if (k % 4 != 3) image.pixels[k] = static_cast<uint8_t>((image.pixels[k] * image.pixels[k | 3] + 127) / 255);
+        CKBitmapProperties refProps;
+        ASSERT_EQ(0, PNG_Read(const_cast<char*>(joinPath(refDir, refs[i]).c_str()), 0, &refProps));
+        const VxImageDescEx& ref = refProps.m_Format;
+        ASSERT_EQ(ref.Width, image.width);
+        ASSERT_EQ(ref.Height, image.height);
+        int tolerance = (image.bitsPerSample == 32 || premultiply) ? 1 : 0;
+        for (size_t k = 0; k < image.pixels.size(); ++k)
+            ASSERT_TRUE(std::abs(static_cast<int>(ref.Image[k]) - static_cast<int>(image.pixels[k])) <= tolerance);
+        delete[] static_cast<CKBYTE*>(refProps.m_Data);
+        ++compared;
+    }
+    if (compared == 0) SKIP_TEST("TIFF reference images not found");
+}
+
+TEST(TiffReader, Corpus_UnsupportedCompression) {
+    std::string path = joinPath(tiffImagesDir(), "fax4.tiff");
+    if (!fileExists(path)) SKIP_TEST("fax4.tiff not found");
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readTiffFile(path).errorCode);
+}
+
+TEST(TiffReader, RegressionCorpus_MustNotCrash) {
+    std::string regDir = joinPath(joinPath(g_TestReferenceDir, ".."), "regression/tiff");
+    if (!directoryExists(regDir)) SKIP_TEST("TIFF regression directory not found");
+    std::vector<std::string> files = collectFilesWithExtensions(regDir, {".tif", ".tiff"});
+    if (files.empty()) SKIP_TEST("No TIFF regression files found");
+    for (size_t i = 0; i < files.size(); ++i) ASSERT_TRUE(readTiffFile(joinPath(regDir, files[i])).errorCode != 0);
+}
+
+TEST(TiffReader, Truncations_MustNotCrash) {
+    // Every prefix of a small LZW image: errors are fine, crashes are not
+    ImageSpec img = makeRgb(9, 7, 3, 16, 8);
+    Layout layout;
+    layout.compression = TIFF_COMPRESSION_LZW;
+    layout.predictor = TIFF_PREDICTOR_HORIZONTAL;
+    layout.rowsPerStrip = 3;
+    std::vector<uint8_t> data = makeTiff(img, layout).build();
+    for (size_t n = 0; n <= data.size(); ++n) {
+        std::vector<uint8_t> prefix(data.begin(), data.begin() + n);
+        readTiff(prefix);
+        readTiff(prefix, IMAGE_READ_KEEP_16BIT);
+    }
+}
+
+//=============================================================================
+// Negative Tests
+//=============================================================================
+
+TEST(TiffReader, Negative_BadHeader) {
+    std::vector<uint8_t> tiff = makeTiff(makeRgb(2, 2, 3, 8, 9), Layout()).build();
+    ASSERT_EQ(0, readTiff(tiff).errorCode);
+
+    std::vector<uint8_t> bad = tiff;
+    bad[0] = 'X';
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readTiff(bad).errorCode);
+    bad = tiff;
+    bad[2] = 43; // BigTIFF
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readTiff(bad).errorCode);
+    bad = tiff;
+    bad[4] = 0xF0; // IFD past the end
+    bad[5] = 0xFF;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readTiff(bad).errorCode);
+    bad.resize(6);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readTiff(bad).errorCode);
+}
+
+TEST(TiffReader, Negative_UnsupportedFeatures) {
+    ImageSpec img = makeRgb(4, 4, 3, 8, 10);
+    TiffBuilder b = makeTiff(img, Layout());
+    b.set(TIFF_TAG_COMPRESSION, 7); // JPEG
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readTiff(b.build()).errorCode);
+    b = makeTiff(img, Layout());
+    b.set(TIFF_TAG_PHOTOMETRIC, 6); // YCbCr
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readTiff(b.build()).errorCode);
+    b = makeTiff(img, Layout());
+    b.setArray(TIFF_TAG_SAMPLE_FORMAT, std::vector<uint32_t>(3, 2)); // signed
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readTiff(b.build()).errorCode);
+    b = makeTiff(img, Layout());
+    b.setArray(TIFF_TAG_BITS_PER_SAMPLE, std::vector<uint32_t>(3, 12));
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readTiff(b.build()).errorCode);
+    b = makeTiff(img, Layout());
+    b.set(TIFF_TAG_FILL_ORDER, 2);
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readTiff(b.build()).errorCode);
+}
+
+TEST(TiffReader, Negative_ChunksOutsideFile) {
+    ImageSpec img = makeRgb(6, 6, 3, 8, 11);
+    Layout layout;
+    layout.rowsPerStrip = 2;
+    TiffBuilder b = makeTiff(img, layout);
+
+    // Too few strips for the image
+    TiffBuilder few = b;
+    few.chunks.pop_back();
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readTiff(few.build()).errorCode);
+
+    // A byte count running past the end of the file
+    std::vector<uint8_t> tiff = b.build();
+    TiffImageInfo info;
+    ASSERT_EQ(0, TIFF_ReadInfo(tiff.data(), static_cast<CKDWORD>(tiff.size()), info));
+    size_t countPos = info.byteCounts.data - tiff.data();
+    tiff[countPos + 5] = 0xFF;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readTiff(tiff).errorCode);
+
+    // Missing offsets
+    TiffBuilder none = b;
+    none.chunks.clear();
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readTiff(none.build()).errorCode);
+}
+
+TEST(TiffReader, Negative_HugeDimensionsFailFast) {
+    TiffBuilder b = makeTiff(makeRgb(2, 2, 3, 8, 12), Layout());
+    b.set(TIFF_TAG_IMAGE_WIDTH, 100000, TIFF_TYPE_LONG);
+    b.set(TIFF_TAG_IMAGE_LENGTH, 100000, TIFF_TYPE_LONG);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readTiff(b.build()).errorCode);
+    b.set(TIFF_TAG_IMAGE_WIDTH, 0, TIFF_TYPE_LONG);
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readTiff(b.build()).errorCode);
+}
@@ -0,0 +1,649 @@
+/**
+ * @file WebpReaderTests.cpp
+ * @brief WebP format tests for CKImageReader
+ *
+ * Tests cover:
+ * - The SSE2 kernels (inverse DCT, loop filters, lossless transforms) against
+ *   the scalar ones
+ * - Alpha planes with each prediction filter, over lossy images
+ * - Simple, extended (VP8X) and bare bitstream files holding the same image;
+ *   the first frame of animations placed on the canvas
+ * - The corpus in tests/images/webp against CRCs and the reference images
+ * - Malformed files (bad container, frame outside the canvas, truncated and
+ *   corrupt bitstreams)
+ */
+
+#include "TestFramework.h"
+#include "WebpReader.h"
+#include "WebpCodec.h"
+#include "WebpDsp.h"
+#include "PngReader.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using namespace TestFramework;
+
+//=============================================================================
+// Test Helpers
+//=============================================================================
+
+namespace {
+
+void putLE24(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v >> 16));
+}
+
+void putLE32(std::vector<uint8_t>& out, uint32_t v) {
+    putLE24(out, v & 0xFFFFFF);
+    out.push_back(static_cast<uint8_t>(v >> 24));
+}
+
+// A chunk with its header and padding byte
+std::vector<uint8_t> chunk(const char* tag, const std::vector<uint8_t>& payload) {
+    std::vector<uint8_t> out(tag, tag + 4);
+    putLE32(out, static_cast<uint32_t>(payload.size()));
+    out.insert(out.end(), payload.begin(), payload.end());
+    if (payload.size() & 1) out.push_back(0);
+    return out;
+}
+
+std::vector<uint8_t> riff(const std::vector<uint8_t>& chunks) {
+    std::vector<uint8_t> out(4, 0);
+    memcpy(out.data(), "RIFF", 4);
+    putLE32(out, static_cast<uint32_t>(chunks.size() + 4));
+    out.insert(out.end(), "WEBP", "WEBP" + 4);
+    out.insert(out.end(), chunks.begin(), chunks.end());
+    return out;
+}
+
+std::vector<uint8_t> vp8x(uint8_t flags, uint32_t width, uint32_t height) {
+    std::vector<uint8_t> payload(4, 0);
+    payload[0] = flags;
+    putLE24(payload, width - 1);
+    putLE24(payload, height - 1);
+    return chunk("VP8X", payload);
+}
+
+// ANMF chunk around the frame chunks
+std::vector<uint8_t> anmf(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint8_t flags,
+                          const std::vector<uint8_t>& frameChunks) {
+    std::vector<uint8_t> payload;
+    putLE24(payload, x / 2);
+    putLE24(payload, y / 2);
+    putLE24(payload, width - 1);
+    putLE24(payload, height - 1);
+    putLE24(payload, 100); // duration
+    payload.push_back(flags);
+    payload.insert(payload.end(), frameChunks.begin(), frameChunks.end());
+    return chunk("ANMF", payload);
+}
+
+// Payload of the first chunk with the given tag in a RIFF file
+std::vector<uint8_t> findChunk(const std::vector<uint8_t>& file, const char* tag) {
+    size_t pos = WEBP_RIFF_HEADER_SIZE;
+    while (pos + 8 <= file.size()) {
+        uint32_t size = file[pos + 4] | (file[pos + 5] << 8) | (file[pos + 6] << 16) | (file[pos + 7] << 24);
+        if (memcmp(&file[pos], tag, 4) == 0)
+            return std::vector<uint8_t>(file.begin() + pos + 8, file.begin() + pos + 8 + size);
+        pos += 8 + size + (size & 1);
+    }
+    return std::vector<uint8_t>();
+}
+
+struct WebpTestResult {
+    int errorCode;
+    int width;
+    int height;
+    std::vector<uint8_t> pixels;
+    CKDWORD frameCount;
+    CKDWORD lossless;
+};
+
+WebpTestResult readWebp(const std::vector<uint8_t>& data) {
+    WebpTestResult result;
+    WebpReader reader;
+    CKBitmapProperties* props = nullptr;
+    result.errorCode = reader.ReadMemory(const_cast<uint8_t*>(data.data()), static_cast<int>(data.size()), &props);
+    result.width = 0;
+    result.height = 0;
+    result.frameCount = 0;
+    result.lossless = 0;
+    if (result.errorCode == 0 && props && props->m_Format.Image) {
+        const VxImageDescEx& fmt = props->m_Format;
+        result.width = fmt.Width;
+        result.height = fmt.Height;
+        for (int y = 0; y < fmt.Height; ++y) {
+            const uint8_t* row = fmt.Image + y * fmt.BytesPerLine;
+            result.pixels.insert(result.pixels.end(), row, row + fmt.Width * 4);
+        }
+        WebpBitmapProperties* wp = reinterpret_cast<WebpBitmapProperties*>(props);
+        result.frameCount = wp->m_FrameCount;
+        result.lossless = wp->m_Lossless;
+    }
+    return result;
+}
+
+WebpTestResult readWebpFile(const std::string& path) { return readWebp(readBinaryFile(path)); }
+
+std::string webpImagesDir() { return joinPath(g_TestImagesDir, "webp"); }
+
+const char* const g_CorpusDirs[] = {"extended_images", "lossless_images", "lossy_images"};
+
+// Loads a corpus file, or returns an empty vector
+std::vector<uint8_t> corpusFile(const char* name) {
+    std::string path = joinPath(webpImagesDir(), name);
+    return fileExists(path) ? readBinaryFile(path) : std::vector<uint8_t>();
+}
+
+// Forward alpha prediction filters, as in the encoder
+std::vector<uint8_t> filterAlpha(const std::vector<uint8_t>& alpha, int width, int height, int filter) {
+    std::vector<uint8_t> out(alpha.size());
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            int i = y * width + x;
+            int pred;
+            if (filter == WEBP_ALPHA_FILTER_NONE)
+                pred = 0;
+            else if (y == 0)
+                pred = x ? alpha[i - 1] : 0;
+            else if (x == 0 || filter == WEBP_ALPHA_FILTER_VERTICAL)
+                pred = alpha[i - width];
+            else if (filter == WEBP_ALPHA_FILTER_HORIZONTAL)
+                pred = alpha[i - 1];
+            else
+                pred = std::min(255, std::max(0, alpha[i - 1] + alpha[i - width] - alpha[i - width - 1]));
+            out[i] = static_cast<uint8_t>(alpha[i] - pred);
+        }
+    }
+    return out;
+}
+
+uint32_t g_Seed = 1;
+
+int nextRandom() {
+    g_Seed = g_Seed * 1103515245u + 12345u;
+    return static_cast<int>((g_Seed >> 16) & 0x7FFF);
+}
+
+// Pixels around a flat level with small steps, so the loop filters act on
+// most edges
+std::vector<uint8_t> smoothNoise(size_t size, int spread) {
+    std::vector<uint8_t> out(size);
+    int level = 40 + nextRandom() % 176;
+    for (size_t i = 0; i < size; ++i) out[i] = static_cast<uint8_t>(level + nextRandom() % (2 * spread + 1) - spread);
+    return out;
+}
+
+} // namespace
+
+//=============================================================================
+// Kernel Tests
+//=============================================================================
+
+TEST(WebpReader, Kernels_TransformMatchesScalar) {
+    const WebpDsp& scalar = WEBP_GetScalarDsp();
+    const WebpDsp& dsp = WEBP_GetDsp();
+    g_Seed = 3;
+    for (int iter = 0; iter < 500; ++iter) {
+        short coefs[16];
+        int range = (iter < 250) ? 256 : 2048;
+        for (int k = 0; k < 16; ++k) coefs[k] = static_cast<short>(nextRandom() % (2 * range) - range);
+        if (iter % 4 == 0) memset(coefs + 1, 0, sizeof(coefs) - sizeof(coefs[0])); // DC only
+        const int stride = 11;
+        std::vector<uint8_t> expected(stride * 4);
+        for (size_t k = 0; k < expected.size(); ++k) expected[k] = static_cast<uint8_t>(nextRandom());
+        std::vector<uint8_t> actual = expected;
+        scalar.transform(coefs, expected.data() + 3, stride);
+        dsp.transform(coefs, actual.data() + 3, stride);
+        ASSERT_TRUE(expected == actual);
+    }
+}
+
+TEST(WebpReader, Kernels_LoopFiltersMatchScalar) {
+    const WebpDsp& scalar = WEBP_GetScalarDsp();
+    const WebpDsp& dsp = WEBP_GetDsp();
+    const int stride = 40;
+    const int origin = 8 * stride + 8;
+    g_Seed = 5;
+    for (int iter = 0; iter < 300; ++iter) {
+        int thresh = nextRandom() % 130;
+        int interior = 1 + nextRandom() % 63;
+        int hev = nextRandom() % 3;
+        std::vector<uint8_t> plane = smoothNoise(stride * stride, 1 + iter % 12);
+        std::vector<uint8_t> u = smoothNoise(stride * stride, 1 + iter % 9);
+        std::vector<uint8_t> v = smoothNoise(stride * stride, 1 + iter % 7);
+
+        WebpSimpleFilterFunc simpleKernels[4][2] = {{scalar.simpleV16, dsp.simpleV16},
+                                                    {scalar.simpleH16, dsp.simpleH16},
+                                                    {scalar.simpleV16i, dsp.simpleV16i},
+                                                    {scalar.simpleH16i, dsp.simpleH16i}};
+        for (int k = 0; k < 4; ++k) {
+            std::vector<uint8_t> expected = plane, actual = plane;
+            simpleKernels[k][0](expected.data() + origin, stride, thresh);
+            simpleKernels[k][1](actual.data() + origin, stride, thresh);
+            ASSERT_TRUE(expected == actual);
+        }
+
+        WebpLumaFilterFunc lumaKernels[4][2] = {
+            {scalar.v16, dsp.v16}, {scalar.h16, dsp.h16}, {scalar.v16i, dsp.v16i}, {scalar.h16i, dsp.h16i}};
+        for (int k = 0; k < 4; ++k) {
+            std::vector<uint8_t> expected = plane, actual = plane;
+            lumaKernels[k][0](expected.data() + origin, stride, thresh, interior, hev);
+            lumaKernels[k][1](actual.data() + origin, stride, thresh, interior, hev);
+            ASSERT_TRUE(expected == actual);
+        }
+
+        WebpChromaFilterFunc chromaKernels[4][2] = {
+            {scalar.v8, dsp.v8}, {scalar.h8, dsp.h8}, {scalar.v8i, dsp.v8i}, {scalar.h8i, dsp.h8i}};
+        for (int k = 0; k < 4; ++k) {
+            std::vector<uint8_t> expectedU = u, expectedV = v, actualU = u, actualV = v;
+            chromaKernels[k][0](expectedU.data() + origin, expectedV.data() + origin, stride, thresh, interior, hev);
+            chromaKernels[k][1](actualU.data() + origin, actualV.data() + origin, stride, thresh, interior, hev);
+            ASSERT_TRUE(expectedU == actualU);
+            ASSERT_TRUE(expectedV == actualV);
+        }
+    }
+}
+
+TEST(WebpReader, Kernels_LosslessTransformsMatchScalar) {
+    const WebpDsp& scalar = WEBP_GetScalarDsp();
+    const WebpDsp& dsp = WEBP_GetDsp();
+    g_Seed = 9;
+    for (int count = 1; count <= 37; ++count) {
+        // upper[-1] to upper[count] and out[-1] are read
+        std::vector<CKDWORD> upper(count + 2), in(count), left(count + 1);
+        for (int i = 0; i < count + 2; ++i) upper[i] = (nextRandom() << 17) ^ nextRandom();
+        for (int i = 0; i < count; ++i) in[i] = (nextRandom() << 17) ^ nextRandom();
+        left[0] = (nextRandom() << 17) ^ nextRandom();
+
+        for (int mode = 0; mode < 16; ++mode) {
+            std::vector<CKDWORD> expected = left, actual = left;
+            scalar.predictorAdd[mode](in.data(), upper.data() + 1, count, expected.data() + 1);
+            dsp.predictorAdd[mode](in.data(), upper.data() + 1, count, actual.data() + 1);
+            ASSERT_TRUE(expected == actual);
+
+            // In place
+            std::vector<CKDWORD> inPlace = left;
+            std::copy(in.begin(), in.end(), inPlace.begin() + 1);
+            dsp.predictorAdd[mode](inPlace.data() + 1, upper.data() + 1, count, inPlace.data() + 1);
+            ASSERT_TRUE(expected == inPlace);
+        }
+
+        CKDWORD element = (nextRandom() << 17) ^ nextRandom();
+        std::vector<CKDWORD> expected(count), actual(count);
+        scalar.colorTransform(element, in.data(), count, expected.data());
+        dsp.colorTransform(element, in.data(), count, actual.data());
+        ASSERT_TRUE(expected == actual);
+        scalar.addGreen(in.data(), count, expected.data());
+        dsp.addGreen(in.data(), count, actual.data());
+        ASSERT_TRUE(expected == actual);
+    }
+}
+
+//=============================================================================
+// Alpha Tests
+//=============================================================================
+
+TEST(WebpReader, Alpha_RawWithEachFilter) {
+    const int width = 13, height = 7;
+    std::vector<uint8_t> alpha(width * height);
+    for (int i = 0; i < width * height; ++i) alpha[i] = static_cast<uint8_t>((i % width) * 19 + (i / width) * 37 + i % 3);
+    for (int filter = WEBP_ALPHA_FILTER_NONE; filter <= WEBP_ALPHA_FILTER_GRADIENT; ++filter) {
+        std::vector<uint8_t> data(1, static_cast<uint8_t>(WEBP_ALPHA_RAW | (filter << 2)));
+        std::vector<uint8_t> filtered = filterAlpha(alpha, width, height, filter);
+        data.insert(data.end(), filtered.begin(), filtered.end());
+        std::vector<uint8_t> decoded(width * height);
+        ASSERT_EQ(0, WEBP_DecodeAlpha(data.data(), static_cast<CKDWORD>(data.size()), width, height, decoded.data()));
+        ASSERT_TRUE(decoded == alpha);
+        ASSERT_EQ(CKBITMAPERROR_READERROR,
+                  WEBP_DecodeAlpha(data.data(), static_cast<CKDWORD>(data.size() - 1), width, height, decoded.data()));
+    }
+
+    // Unknown method, reserved bits
+    std::vector<uint8_t> bad(1 + width * height, 0);
+    std::vector<uint8_t> decoded(width * height);
+    bad[0] = 2;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, WEBP_DecodeAlpha(bad.data(), static_cast<CKDWORD>(bad.size()), width,
+                                                           height, decoded.data()));
+    bad[0] = 0x40;
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, WEBP_DecodeAlpha(bad.data(), static_cast<CKDWORD>(bad.size()), width,
+                                                           height, decoded.data()));
+}
+
+TEST(WebpReader, Alpha_LossyImageWithRawAlpha) {
+    // The lossy corpus image with an ALPH chunk added: colors unchanged, alpha
+    // from the chunk
+    std::vector<uint8_t> rgbFile = corpusFile("lossy_images/simple-rgb.webp");
+    if (rgbFile.empty()) SKIP_TEST("simple-rgb.webp not found");
+    WebpTestResult plain = readWebp(rgbFile);
+    ASSERT_EQ(0, plain.errorCode);
+
+    const int width = plain.width, height = plain.height;
+    std::vector<uint8_t> alpha(width * height);
+    for (int i = 0; i < width * height; ++i) alpha[i] = static_cast<uint8_t>(i * 7 / width);
+    std::vector<uint8_t> alph(1, static_cast<uint8_t>(WEBP_ALPHA_RAW | (WEBP_ALPHA_FILTER_GRADIENT << 2)));
+    std::vector<uint8_t> filtered = filterAlpha(alpha, width, height, WEBP_ALPHA_FILTER_GRADIENT);
+    alph.insert(alph.end(), filtered.begin(), filtered.end());
+
+    std::vector<uint8_t> chunks = vp8x(WEBP_FLAG_ALPHA, width, height);
+    std::vector<uint8_t> alphChunk = chunk("ALPH", alph);
+    std::vector<uint8_t> vp8Chunk = chunk("VP8 ", findChunk(rgbFile, "VP8 "));
+    chunks.insert(chunks.end(), alphChunk.begin(), alphChunk.end());
+    chunks.insert(chunks.end(), vp8Chunk.begin(), vp8Chunk.end());
+    WebpTestResult r = readWebp(riff(chunks));
+    ASSERT_EQ(0, r.errorCode);
+    ASSERT_EQ(width, r.width);
+    for (int i = 0; i < width * height; ++i) {
+        ASSERT_TRUE(memcmp(&r.pixels[i * 4], &plain.pixels[i * 4], 3) == 0);
+        ASSERT_EQ(alpha[i], r.pixels[i * 4 + 3]);
+    }
+}
+
+//=============================================================================
+// Container Tests
+//=============================================================================
+
+TEST(WebpReader, Container_SimpleExtendedAndBareMatch) {
+    static const char* files[] = {"lossless_images/2-color.webp", "lossy_images/simple-gray.webp"};
+    for (int f = 0; f < 2; ++f) {
+        std::vector<uint8_t> file = corpusFile(files[f]);
+        if (file.empty()) SKIP_TEST("WebP corpus not found");
+        WebpTestResult simple = readWebp(file);
+        ASSERT_EQ(0, simple.errorCode);
+
+        const char* tag = f == 0 ? "VP8L" : "VP8 ";
+        std::vector<uint8_t> bitstream = findChunk(file, tag);
+        WebpTestResult bare = readWebp(bitstream);
+        ASSERT_EQ(0, bare.errorCode);
+        ASSERT_TRUE(bare.pixels == simple.pixels);
+
+        // Metadata chunks around the image are skipped; trailing bytes after
+        // the RIFF payload are ignored
+        std::vector<uint8_t> chunks = vp8x(0, simple.width, simple.height);
+        std::vector<uint8_t> iccp = chunk("ICCP", std::vector<uint8_t>(5, 0xEE));
+        std::vector<uint8_t> image = chunk(tag, bitstream);
+        std::vector<uint8_t> exif = chunk("EXIF", std::vector<uint8_t>(8, 0xDD));
+        chunks.insert(chunks.end(), iccp.begin(), iccp.end());
+        chunks.insert(chunks.end(), image.begin(), image.end());
+        chunks.insert(chunks.end(), exif.begin(), exif.end());
+        std::vector<uint8_t> extended = riff(chunks);
+        extended.insert(extended.end(), 3, 0xAB);
+        WebpTestResult r = readWebp(extended);
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_TRUE(r.pixels == simple.pixels);
+        ASSERT_EQ(1u, r.frameCount);
+        ASSERT_EQ(f == 0 ? 1u : 0u, r.lossless);
+    }
+}
+
+TEST(WebpReader, Animation_FirstFramePlacedOnCanvas) {
+    std::vector<uint8_t> file = corpusFile("lossless_images/2-color.webp");
+    if (file.empty()) SKIP_TEST("2-color.webp not found");
+    WebpTestResult still = readWebp(file);
+    ASSERT_EQ(0, still.errorCode);
+    std::vector<uint8_t> frame = chunk("VP8L", findChunk(file, "VP8L"));
+
+    const int canvasWidth = still.width + 9, canvasHeight = still.height + 5;
+    const int frameX = 6, frameY = 2;
+    for (int blend = 0; blend < 2; ++blend) {
+        std::vector<uint8_t> chunks = vp8x(WEBP_FLAG_ANIMATION, canvasWidth, canvasHeight);
+        std::vector<uint8_t> anim = chunk("ANIM", std::vector<uint8_t>(6, 0));
+        std::vector<uint8_t> first =
+            anmf(frameX, frameY, still.width, still.height, blend ? 0 : WEBP_ANMF_NO_BLEND, frame);
+        std::vector<uint8_t> second = anmf(0, 0, still.width, still.height, 0, frame);
+        chunks.insert(chunks.end(), anim.begin(), anim.end());
+        chunks.insert(chunks.end(), first.begin(), first.end());
+        chunks.insert(chunks.end(), second.begin(), second.end());
+        chunks.insert(chunks.end(), second.begin(), second.end());
+        std::vector<uint8_t> data = riff(chunks);
+
+        WebpTestResult r = readWebp(data);
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_EQ(canvasWidth, r.width);
+        ASSERT_EQ(canvasHeight, r.height);
+        ASSERT_EQ(3u, r.frameCount);
+        for (int y = 0; y < canvasHeight; ++y) {
+            for (int x = 0; x < canvasWidth; ++x) {
+                const uint8_t* p = &r.pixels[(y * canvasWidth + x) * 4];
+                int fx = x - frameX, fy = y - frameY;
+                if (fx < 0 || fy < 0 || fx >= still.width || fy >= still.height) {
+                    ASSERT_EQ(0u, static_cast<uint32_t>(p[0] | p[1] | p[2] | p[3]));
+                } else {
+                    // The opaque frame looks the same blended or not
+                    ASSERT_TRUE(memcmp(p, &still.pixels[(fy * still.width + fx) * 4], 4) == 0);
+                }
+            }
+        }
+
+        // A truncated later frame only ends the count
+        std::vector<uint8_t> cut(data.begin(), data.end() - 10);
+        cut[4] = static_cast<uint8_t>(cut.size() - 8);
+        cut[5] = static_cast<uint8_t>((cut.size() - 8) >> 8);
+        cut[6] = static_cast<uint8_t>((cut.size() - 8) >> 16);
+        cut[7] = 0;
+        WebpTestResult truncated = readWebp(cut);
+        ASSERT_EQ(0, truncated.errorCode);
+        ASSERT_EQ(2u, truncated.frameCount);
+        ASSERT_TRUE(truncated.pixels == r.pixels);
+    }
+}
+
+TEST(WebpReader, ReadInfo) {
+    std::vector<uint8_t> file = corpusFile("lossy_images/simple-rgb.webp");
+    if (file.empty()) SKIP_TEST("simple-rgb.webp not found");
+    WebpImageInfo info;
+    ASSERT_EQ(0, WEBP_ReadInfo(file.data(), static_cast<CKDWORD>(file.size()), info));
+    ASSERT_EQ(100u, info.canvasWidth);
+    ASSERT_EQ(100u, info.canvasHeight);
+    ASSERT_EQ(1u, info.frameCount);
+    ASSERT_FALSE(info.animated);
+    ASSERT_FALSE(info.lossless);
+    ASSERT_TRUE(info.alpha == nullptr);
+    ASSERT_TRUE(info.bitstream == file.data() + WEBP_RIFF_HEADER_SIZE + WEBP_CHUNK_HEADER_SIZE);
+}
+
+//=============================================================================
+// Reader Tests
+//=============================================================================
+
+TEST(WebpReader, ReaderInfo) {
+    WebpReader reader;
+    CKPluginInfo* info = reader.GetReaderInfo();
+    ASSERT_TRUE(info != nullptr);
+    ASSERT_GUID_EQ(WEBPREADER_GUID, info->m_GUID);
+    // The extension is stored in three characters
+    ASSERT_TRUE(strcmp(info->m_Extension, "Web") == 0);
+    ASSERT_EQ(0, reader.SaveFile(const_cast<char*>("unused.webp"), nullptr));
+}
+
+//=============================================================================
+// Corpus Tests
+//=============================================================================
+
+TEST(WebpReader, Corpus_ReferenceCrcs) {
+    int checked = 0;
+    for (int d = 0; d < 3; ++d) {
+        std::string dir = joinPath(webpImagesDir(), g_CorpusDirs[d]);
+        std::vector<std::string> files = collectFilesWithExtensions(dir, {".webp"});
+        for (size_t i = 0; i < files.size(); ++i) {
+            std::string key = std::string(g_CorpusDirs[d]) + "/" + files[i];
+            uint32_t crc = 0;
+            if (!getReferenceCrc("webp/" + key, crc)) continue;
+            WebpTestResult r = readWebpFile(joinPath(dir, files[i]));
+            ASSERT_EQ(0, r.errorCode);
+            ASSERT_CRC(crc, r.pixels.data(), r.pixels.size());
+            ++checked;
+        }
+    }
+    if (checked == 0) SKIP_TEST("WebP corpus or reference CRCs not found");
+}
+
+TEST(WebpReader, Corpus_MatchesReferenceImages) {
+    // Exact match: lossy images too, since the decoder follows libwebp's
+    // integer math. Animations show their first frame; the references blend
+    // it onto the canvas with a rounding that can take one off the colors.
+    int compared = 0;
+    for (int d = 0; d < 3; ++d) {
+        std::string imageDir = joinPath(webpImagesDir(), g_CorpusDirs[d]);
+        std::string refDir = joinPath(joinPath(g_TestReferenceDir, "webp"), g_CorpusDirs[d]);
+        std::vector<std::string> refs = listDirectory(refDir);
+        for (size_t i = 0; i < refs.size(); ++i) {
+            ReferenceInfo info = parseReferenceFilename(refs[i]);
+            std::string imagePath = joinPath(imageDir, info.inputName);
+            if (!info.valid || !fileExists(imagePath)) continue;
+
+            WebpTestResult image = readWebpFile(imagePath);
+            ASSERT_EQ(0, image.errorCode);
+            CKBitmapProperties refProps;
+            ASSERT_EQ(0, PNG_Read(const_cast<char*>(joinPath(refDir, refs[i]).c_str()), 0, &refProps));
+            const VxImageDescEx& ref = refProps.m_Format;
+            ASSERT_EQ(ref.Width, image.width);
+            ASSERT_EQ(ref.Height, image.height);
+            int tolerance = image.frameCount > 1 ? 1 : 0;
+            for (int y = 0; y < ref.Height; ++y) {
+                const uint8_t* row = ref.Image + y * ref.BytesPerLine;
+                for (int k = 0; k < image.width * 4; ++k)
+                    ASSERT_TRUE(std::abs(static_cast<int>(row[k]) - image.pixels[y * image.width * 4 + k]) <= tolerance);
+            }
+            delete[] static_cast<CKBYTE*>(refProps.m_Data);
+            ++compared;
+        }
+    }
+    if (compared == 0) SKIP_TEST("WebP reference images not found");
+}
+
+TEST(WebpReader, Corpus_Properties) {
+    struct Expected {
+        const char* name;
+        CKDWORD frameCount;
+        CKDWORD lossless;
+    };
+    static const Expected expected[] = {{"extended_images/anim.webp", 6, 0},
+                                        {"extended_images/lossy_alpha.webp", 1, 0},
+                                        {"lossless_images/simple_xmp.webp", 1, 1},
+                                        {"lossy_images/simple-gray.webp", 1, 0}};
+    int checked = 0;
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i) {
+        std::string path = joinPath(webpImagesDir(), expected[i].name);
+        if (!fileExists(path)) continue;
+        WebpTestResult r = readWebpFile(path);
+        ASSERT_EQ(0, r.errorCode);
+        ASSERT_EQ(expected[i].frameCount, r.frameCount);
+        ASSERT_EQ(expected[i].lossless, r.lossless);
+        ++checked;
+    }
+    if (checked == 0) SKIP_TEST("WebP corpus not found");
+}
+
+TEST(WebpReader, RegressionCorpus_MustNotCrash) {
+    // panic.webp is valid, if unusual: libwebp decodes it too
+    std::string regDir = joinPath(joinPath(g_TestReferenceDir, ".."), "regression/webp");
+    if (!directoryExists(regDir)) SKIP_TEST("WebP regression directory not found");
+    std::vector<std::string> files = collectFilesWithExtensions(regDir, {".webp"});
+    if (files.empty()) SKIP_TEST("No WebP regression files found");
+    for (size_t i = 0; i < files.size(); ++i) {
+        WebpTestResult r = readWebpFile(joinPath(regDir, files[i]));
+        ASSERT_TRUE(r.errorCode != 0 || r.pixels.size() == static_cast<size_t>(r.width) * r.height * 4);
+    }
+}
+
+TEST(WebpReader, Truncations_MustNotCrash) {
+    // Every prefix of a lossless and a lossy file: errors are fine, crashes are not
+    static const char* files[] = {"lossless_images/2-color.webp", "extended_images/lossy_alpha.webp"};
+    int checked = 0;
+    for (int f = 0; f < 2; ++f) {
+        std::vector<uint8_t> data = corpusFile(files[f]);
+        if (data.empty()) continue;
+        for (size_t n = 0; n < data.size(); ++n) {
+            std::vector<uint8_t> prefix(data.begin(), data.begin() + n);
+            ASSERT_TRUE(readWebp(prefix).errorCode != 0);
+        }
+        ++checked;
+    }
+    if (checked == 0) SKIP_TEST("WebP corpus not found");
+}
+
+TEST(WebpReader, CorruptBitstream_MustNotCrash) {
+    // Bytes of the bitstreams flipped in turn
+    static const char* files[] = {"lossless_images/2-color.webp", "extended_images/lossy_alpha.webp"};
+    int checked = 0;
+    for (int f = 0; f < 2; ++f) {
+        std::vector<uint8_t> data = corpusFile(files[f]);
+        if (data.empty()) continue;
+        for (size_t k = WEBP_RIFF_HEADER_SIZE; k < data.size(); ++k) {
+            std::vector<uint8_t> bad = data;
+            bad[k] ^= static_cast<uint8_t>(0x11 << (k % 4));
+            readWebp(bad);
+        }
+        ++checked;
+    }
+    if (checked == 0) SKIP_TEST("WebP corpus not found");
+}
+
+//=============================================================================
+// Negative Tests
+//=============================================================================
+
+TEST(WebpReader, Negative_BadContainer) {
+    std::vector<uint8_t> good = corpusFile("lossless_images/2-color.webp");
+    if (good.empty()) SKIP_TEST("2-color.webp not found");
+    ASSERT_EQ(0, readWebp(good).errorCode);
+
+    std::vector<uint8_t> bad = good;
+    memcpy(&bad[8], "AVI ", 4);
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readWebp(bad).errorCode);
+    bad = good;
+    bad[0] = 'X'; // neither RIFF nor a bitstream
+    ASSERT_EQ(CKBITMAPERROR_UNSUPPORTEDFILE, readWebp(bad).errorCode);
+    bad = good;
+    memcpy(&bad[12], "ICCP", 4); // simple files start with the image
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readWebp(bad).errorCode);
+    bad = good;
+    bad[6] = 1; // RIFF size past the end
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readWebp(bad).errorCode);
+    bad = good;
+    bad[16] = static_cast<uint8_t>(bad[16] + 1); // chunk past the RIFF payload
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readWebp(bad).errorCode);
+    bad = good;
+    bad[20] = 0x2E; // VP8L signature
+    ASSERT_TRUE(readWebp(bad).errorCode != 0);
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readWebp(std::vector<uint8_t>(good.begin(), good.begin() + 3)).errorCode);
+}
+
+TEST(WebpReader, Negative_FrameOutsideCanvas) {
+    std::vector<uint8_t> file = corpusFile("lossless_images/2-color.webp");
+    if (file.empty()) SKIP_TEST("2-color.webp not found");
+    std::vector<uint8_t> frame = chunk("VP8L", findChunk(file, "VP8L"));
+    const int size = 300;
+
+    // Still image not matching the VP8X canvas
+    std::vector<uint8_t> chunks = vp8x(0, size + 1, size);
+    chunks.insert(chunks.end(), frame.begin(), frame.end());
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readWebp(riff(chunks)).errorCode);
+
+    // Animation frame past the canvas edge, frame size not matching its bitstream
+    chunks = vp8x(WEBP_FLAG_ANIMATION, size + 1, size);
+    std::vector<uint8_t> shifted = anmf(2, 0, size, size, 0, frame);
+    chunks.insert(chunks.end(), shifted.begin(), shifted.end());
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readWebp(riff(chunks)).errorCode);
+    chunks = vp8x(WEBP_FLAG_ANIMATION, size + 1, size);
+    std::vector<uint8_t> wrongSize = anmf(0, 0, size + 1, size, 0, frame);
+    chunks.insert(chunks.end(), wrongSize.begin(), wrongSize.end());
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readWebp(riff(chunks)).errorCode);
+
+    // No frame at all
+    ASSERT_EQ(CKBITMAPERROR_READERROR, readWebp(riff(vp8x(WEBP_FLAG_ANIMATION, size, size))).errorCode);
+}
+
+TEST(WebpReader, Negative_HugeDimensionsFailFast) {
+    // A huge animation canvas is rejected before anything is decoded
+    std::vector<uint8_t> file = corpusFile("lossless_images/2-color.webp");
+    if (file.empty()) SKIP_TEST("2-color.webp not found");
+    std::vector<uint8_t> chunks = vp8x(WEBP_FLAG_ANIMATION, 1 << 24, 1 << 24);
+    std::vector<uint8_t> frame = anmf(0, 0, 300, 300, 0, chunk("VP8L", findChunk(file, "VP8L")));
+    chunks.insert(chunks.end(), frame.begin(), frame.end());
+    ASSERT_EQ(CKBITMAPERROR_FILECORRUPTED, readWebp(riff(chunks)).errorCode);
+}